@@ -1,5 +1,6 @@
 #include <filesystem>
 #include <future>
+#include <linux/ioprio.h>
 #include <ostream>
 #include <system_error>
 #include <vector>
@@ -21,14 +22,40 @@ SISL_OPTION_GROUP(ublkpp_disk,
                   (loop, "", "loop", "Attach a single device 1-to-1", ::cxxopts::value< std::string >(), "<path>"),
                   (raid0, "", "raid0", "Devices for RAID0 device", ::cxxopts::value< std::vector< std::string > >(),
                    "<path>[,<path>,...]"),
+                  (raid0_weights, "", "raid0_weights",
+                   "Stripes per cycle for each --raid0 device, or auto to weigh them by capacity",
+                   ::cxxopts::value< std::vector< std::string > >(), "auto|<n>[,<n>,...]"),
+                  (raid0_expand, "", "raid0_expand", "Add these devices to the --raid0 device once it is running",
+                   ::cxxopts::value< std::vector< std::string > >(), "<path>[,<path>,...]"),
                   (raid1, "", "raid1", "Devices for RAID1 device", ::cxxopts::value< std::vector< std::string > >(),
                    "<path>[,<path>,...]"),
+                  (raid1_meta, "", "raid1_meta", "Keep the RAID1 bitmap on this device instead of the legs",
+                   ::cxxopts::value< std::string >(), "<path>"),
                   (raid10, "", "raid10", "Devices for RAID10 device", ::cxxopts::value< std::vector< std::string > >(),
                    "<path>[,<path>,...]"),
+                  (raid10_layout, "", "raid10_layout",
+                   "Build --raid10 as a native RAID10 with this layout instead of RAID0 over RAID1 pairs",
+                   ::cxxopts::value< std::string >(), "near|far"),
+                  (raid5, "", "raid5", "Devices for RAID5 device", ::cxxopts::value< std::vector< std::string > >(),
+                   "<path>,<path>,<path>[,<path>,...]"),
+                  (raid6, "", "raid6", "Devices for RAID6 device", ::cxxopts::value< std::vector< std::string > >(),
+                   "<path>,<path>,<path>,<path>[,<path>,...]"),
                   (stripe_size, "", "stripe_size", "RAID-0 Stripe Size",
                    ::cxxopts::value< uint32_t >()->default_value("131072"), ""),
                   (device_id, "", "device_id", "Recover existing device",
-                   cxxopts::value< int32_t >()->default_value("-1"), "<ublkid>"))
+                   cxxopts::value< int32_t >()->default_value("-1"), "<ublkid>"),
+                  (qos_read_iops, "", "qos_read_iops", "Limit reads per second (0 for no limit)",
+                   ::cxxopts::value< uint64_t >()->default_value("0"), "<iops>"),
+                  (qos_write_iops, "", "qos_write_iops", "Limit writes per second (0 for no limit)",
+                   ::cxxopts::value< uint64_t >()->default_value("0"), "<iops>"),
+                  (qos_read_bps, "", "qos_read_bps", "Limit bytes read per second (0 for no limit)",
+                   ::cxxopts::value< uint64_t >()->default_value("0"), "<bytes>"),
+                  (qos_write_bps, "", "qos_write_bps", "Limit bytes written per second (0 for no limit)",
+                   ::cxxopts::value< uint64_t >()->default_value("0"), "<bytes>"),
+                  (qos_burst_ms, "", "qos_burst_ms", "Let this many milliseconds of each QoS limit through at once",
+                   ::cxxopts::value< uint32_t >()->default_value("0"), "<msecs>"),
+                  (ioprio, "", "ioprio", "I/O priority of the volume's backend I/O",
+                   ::cxxopts::value< std::string >(), "rt|be|idle[:<level>]"))
 
 #define ENABLED_OPTIONS logging, ublkpp_tgt, raid1, ublkpp_disk
 
@@ -51,6 +78,24 @@ static Result _run_target(boost::uuids::uuid const& vol_id, std::shared_ptr< ubl
     auto res = ublkpp::ublkpp_tgt::run(vol_id, std::move(dev), SISL_OPTIONS["device_id"].as< int32_t >());
     if (!res) { return std::unexpected(res.error()); }
     k_target = std::move(res.value());
+
+    auto const limit = [](char const* name) {
+        auto const rate = SISL_OPTIONS[name].as< uint64_t >();
+        return ublkpp::qos_limit{.rate = rate, .burst = rate * SISL_OPTIONS["qos_burst_ms"].as< uint32_t >() / 1000};
+    };
+    if (auto const qos = ublkpp::qos_limits{.read_iops = limit("qos_read_iops"),
+                                            .write_iops = limit("qos_write_iops"),
+                                            .read_bytes = limit("qos_read_bps"),
+                                            .write_bytes = limit("qos_write_bps")};
+        ublkpp::qos_limits{} != qos)
+        k_target->set_qos(qos);
+    if (0 < SISL_OPTIONS["ioprio"].count()) {
+        auto const prio = SISL_OPTIONS["ioprio"].as< std::string >();
+        auto const cls = prio.substr(0, prio.find(':'));
+        auto const level = (std::string::npos == prio.find(':')) ? 0 : std::stoi(prio.substr(prio.find(':') + 1));
+        auto const cls_id = ("rt" == cls) ? IOPRIO_CLASS_RT : ("idle" == cls) ? IOPRIO_CLASS_IDLE : IOPRIO_CLASS_BE;
+        k_target->set_io_priority(static_cast< uint16_t >(IOPRIO_PRIO_VALUE(cls_id, level)));
+    }
     return k_target->device_path();
 }
 
@@ -85,11 +130,34 @@ Result create_raid0(boost::uuids::uuid const& id, std::vector< std::string > con
             devices.push_back(get_driver(disk, raid_uuid));
         }
 
-        if (0 < devices.size())
-            dev = ublkpp::make_raid0_disk(id, SISL_OPTIONS["stripe_size"].as< uint32_t >(), std::move(devices));
-    } catch (std::runtime_error const& e) {}
+        auto const stripe_size = SISL_OPTIONS["stripe_size"].as< uint32_t >();
+        auto weights = std::vector< uint32_t >();
+        if (0 < SISL_OPTIONS["raid0_weights"].count()) {
+            auto const given = SISL_OPTIONS["raid0_weights"].as< std::vector< std::string > >();
+            if (1 == given.size() && "auto" == given.front())
+                weights = ublkpp::raid0::weights_by_capacity(devices, stripe_size);
+            else
+                for (auto const& w : given)
+                    weights.push_back(static_cast< uint32_t >(std::stoul(w)));
+        }
+        if (0 < devices.size()) dev = ublkpp::make_raid0_disk(id, stripe_size, std::move(devices), weights);
+    } catch (std::exception const& e) { LOGERROR("Could not assemble RAID0: {}", e.what()) }
     if (!dev) return std::unexpected(std::make_error_condition(std::errc::operation_not_permitted));
-    return _run_target(id, std::move(dev));
+    auto raid = dev;
+    auto res = _run_target(id, std::move(dev));
+    if (res && 0 < SISL_OPTIONS["raid0_expand"].count()) {
+        auto added = std::vector< std::shared_ptr< ublkpp::ublk_disk > >();
+        try {
+            for (auto const& disk : SISL_OPTIONS["raid0_expand"].as< std::vector< std::string > >())
+                added.push_back(get_driver(disk, boost::uuids::to_string(id)));
+        } catch (std::runtime_error const& e) {
+            LOGERROR("Could not open devices to add: {}", e.what())
+            added.clear();
+        }
+        if (added.empty() || !ublkpp::raid0::expand(*raid, std::move(added)))
+            LOGERROR("Could not expand {}; it keeps its current devices", res.value().native())
+    }
+    return res;
 }
 
 Result create_raid1(boost::uuids::uuid const& id, std::vector< std::string > const& layout) {
@@ -101,7 +169,11 @@ Result create_raid1(boost::uuids::uuid const& id, std::vector< std::string > con
         auto dev_a = get_driver(*layout.begin(), raid_uuid);
         auto dev_b = get_driver(*(layout.begin() + 1), raid_uuid);
 
-        dev = ublkpp::make_raid1_disk(id, std::move(dev_a), std::move(dev_b), raid_uuid);
+        auto meta = std::shared_ptr< ublkpp::ublk_disk >();
+        if (SISL_OPTIONS.count("raid1_meta"))
+            meta = ublkpp::make_fs_disk(SISL_OPTIONS["raid1_meta"].as< std::string >(), raid_uuid);
+
+        dev = ublkpp::make_raid1_disk(id, std::move(dev_a), std::move(dev_b), raid_uuid, std::move(meta));
     } catch (std::runtime_error const& e) {}
     if (!dev) return std::unexpected(std::make_error_condition(std::errc::operation_not_permitted));
     return _run_target(id, std::move(dev));
@@ -115,6 +187,23 @@ Result create_raid10(boost::uuids::uuid const& id, std::vector< std::string > co
 
     auto dev = std::shared_ptr< ublkpp::ublk_disk >();
     auto raid10_uuid_str = boost::uuids::to_string(id);
+    if (0 < SISL_OPTIONS["raid10_layout"].count()) {
+        auto const lay = SISL_OPTIONS["raid10_layout"].as< std::string >();
+        if (lay != "near" && lay != "far") {
+            LOGERROR("Unknown RAID10 layout [{}], expected near or far", lay)
+            return std::unexpected(std::make_error_condition(std::errc::invalid_argument));
+        }
+        try {
+            auto devices = std::vector< std::shared_ptr< ublkpp::ublk_disk > >();
+            for (auto const& disk : layout) {
+                devices.push_back(get_driver(disk, raid10_uuid_str));
+            }
+            dev = ublkpp::make_raid10_disk(id, SISL_OPTIONS["stripe_size"].as< uint32_t >(), std::move(devices),
+                                           lay == "far" ? ublkpp::raid10::layout::FAR : ublkpp::raid10::layout::NEAR);
+        } catch (std::exception const& e) { LOGERROR("Could not assemble RAID10: {}", e.what()) }
+        if (!dev) return std::unexpected(std::make_error_condition(std::errc::operation_not_permitted));
+        return _run_target(id, std::move(dev));
+    }
     try {
         auto devices = std::vector< std::shared_ptr< ublkpp::ublk_disk > >();
         auto name_gen = boost::uuids::name_generator(id);
@@ -139,6 +228,22 @@ Result create_raid10(boost::uuids::uuid const& id, std::vector< std::string > co
     return _run_target(id, std::move(dev));
 }
 
+Result create_parity(boost::uuids::uuid const& id, std::vector< std::string > const& layout, uint32_t parity) {
+    auto dev = std::shared_ptr< ublkpp::ublk_disk >();
+    auto raid_uuid = boost::uuids::to_string(id);
+    try {
+        auto devices = std::vector< std::shared_ptr< ublkpp::ublk_disk > >();
+        for (auto const& disk : layout) {
+            devices.push_back(get_driver(disk, raid_uuid));
+        }
+        auto const chunk = SISL_OPTIONS["stripe_size"].as< uint32_t >();
+        dev = (2 == parity) ? ublkpp::make_raid6_disk(id, chunk, std::move(devices))
+                            : ublkpp::make_raid5_disk(id, chunk, std::move(devices));
+    } catch (std::exception const& e) { LOGERROR("Could not assemble RAID{}: {}", (2 == parity) ? 6 : 5, e.what()) }
+    if (!dev) return std::unexpected(std::make_error_condition(std::errc::operation_not_permitted));
+    return _run_target(id, std::move(dev));
+}
+
 int main(int argc, char* argv[]) {
     SISL_OPTIONS_LOAD(argc, argv, ENABLED_OPTIONS);
     sisl::logging::SetLogger(std::string(argv[0]),
@@ -162,6 +267,10 @@ int main(int argc, char* argv[]) {
         res = create_raid1(vol_id, SISL_OPTIONS["raid1"].as< std::vector< std::string > >());
     } else if (0 < SISL_OPTIONS["raid10"].count()) {
         res = create_raid10(vol_id, SISL_OPTIONS["raid10"].as< std::vector< std::string > >());
+    } else if (0 < SISL_OPTIONS["raid5"].count()) {
+        res = create_parity(vol_id, SISL_OPTIONS["raid5"].as< std::vector< std::string > >(), 1);
+    } else if (0 < SISL_OPTIONS["raid6"].count()) {
+        res = create_parity(vol_id, SISL_OPTIONS["raid6"].as< std::vector< std::string > >(), 2);
     } else
         std::cout << SISL_PARSER.help({}) << std::endl;
 
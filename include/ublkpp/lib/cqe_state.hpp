@@ -1,7 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <coroutine>
 #include <cstdint>
+#include <ctime>
 #include <utility>
 #include <vector>
 
@@ -21,8 +23,12 @@ namespace ublkpp {
 //
 //   disk_task<int> MyDisk::async_iov(ublksrv_queue const* q, ublk_io_data const* d, ...) {
 //       auto* sqe = next_sqe(q);
+//       while (!sqe && co_await sq_space(q, d))
+//           sqe = next_sqe(q);
+//       if (!sqe) co_return -EBUSY;
 //       auto [state, user_data] = build_cqe_state_data(d);
 //       io_uring_prep_*(sqe, ...);
+//       sqe->ioprio = io_priority(d);
 //       io_uring_sqe_set_data64(sqe, user_data);
 //       co_return co_await *state;
 //   }
@@ -45,6 +51,18 @@ namespace ublkpp {
 // (encode_managed_user_data(nullptr)) and run_queue_loop checks state == nullptr to tell them
 // apart from real I/O CQEs.
 //
+// The ublk ring is sized for a typical number of SQEs per I/O (--ring_sqes_per_io), not for the
+// most a stack may issue: next_sqe(q) comes back empty while the queue's SQEs in flight fill it,
+// and sq_space waits for the CQEs that free room. Every SQE taken with next_sqe(q) must carry a
+// managed user_data, as its CQE is what returns the room.
+//
+// Under work stealing (--steal_io) an I/O may be served by the thread of another queue of the
+// target than the one its tag arrived on; `q` is then that queue, and every SQE of the I/O goes to
+// its ring. A driver keeps using the `q` it is handed and never caches one per ublk_io_data.
+//
+// A driver whose reads and writes may complete by polling (an O_DIRECT block device under
+// --iopoll) takes their SQE from next_polled_sqe(q) instead, falling back to next_sqe(q).
+//
 // Reference implementation: src/driver/fs_disk.cpp.
 // =============================================================================
 
@@ -55,11 +73,25 @@ struct cqe_state;
 // Lifetime: placement-new'd in init_queue for each tag slot; explicitly ~async_io() in
 // deinit_queue. _pool is cleared at the start of each new I/O in __handle_io_async (the
 // tgt C callback).
+//
+// Ownership: one thread at a time, the one serving the I/O. That is the thread of _home unless a
+// sibling queue stole the I/O (--steal_io); the hand-over both ways goes through a lock of the
+// target, so what one thread wrote here the next one sees.
 struct async_io {
     // Pre-reserved in init_queue to prepare_result::max_sqes_per_io. push_back never
     // reallocates when size < capacity, so cqe_state* pointers in SQE user_data stay stable.
     std::vector< cqe_state > _pool{};
-    int _tag{-1}; // set in tgt __handle_io_async; read by run_queue_loop on error
+    // set in tgt handle_io_async; read by run_queue_loop on error. -1 for I/O a driver issues on its
+    // own that no request waits on (e.g. a RAID1 write-behind copy): nothing is completed for it.
+    int _tag{-1};
+    // ioprio(2) value every backend SQE of this I/O carries; set in tgt __handle_io_async
+    uint16_t _ioprio{0};
+    // The next request merged into this one's backend I/O (--plug_merge), or nullptr; run_queue_loop
+    // fails the whole chain when the coroutine throws. Set in tgt __handle_io_async.
+    async_io const* _merge_next{nullptr};
+    // The queue the tag belongs to, which alone may complete it (ublksrv_complete_io); set in
+    // init_queue
+    ublksrv_queue const* _home{nullptr};
 
     // Allocates a fresh cqe_state in the _pool and returns a stable pointer to it.
     cqe_state* next_state();
@@ -73,6 +105,9 @@ struct async_io {
 // _owner is nullable: per-IO cqe_states (build_cqe_state_data path) point at the slot's
 // async_io so an exception on resume can be reported via ublksrv_complete_io. Stand-alone
 // cqe_states set _owner = nullptr; callers handle their own errors.
+//
+// A cqe_state is only touched by the thread serving its I/O: the SQE carrying it goes to the ring
+// of the queue that thread runs, so its CQE is reaped, and its waiter resumed, on the same thread.
 struct cqe_state {
     async_io* _owner{nullptr};
     int _result{0};
@@ -98,14 +133,145 @@ inline std::pair< cqe_state*, uint64_t > build_cqe_state_data(ublk_io_data const
     return {state, sisl::async::encode_managed_user_data(state)};
 }
 
-// Acquires an SQE from the queue's io_uring, submitting any pending SQEs first if the ring
-// is full. Returns nullptr only if the kernel cannot allocate one even after submission;
-// callers should treat that as a transient back-pressure signal.
-inline io_uring_sqe* next_sqe(ublksrv_queue const* q) {
-    auto* r = q->ring_ptr;
+// The I/O priority a driver gives each SQE it prepares for `data` (sqe->ioprio, after the
+// io_uring_prep_*() call, which clears it): the priority of the target the I/O arrived on.
+inline uint16_t io_priority(ublk_io_data const* data) noexcept {
+    return reinterpret_cast< async_io const* >(data->private_data)->_ioprio;
+}
+
+// Acquires an SQE from `r`, submitting any pending SQEs first if the ring is full. Returns
+// nullptr only if the kernel cannot allocate one even after submission.
+inline io_uring_sqe* next_sqe(io_uring* r) {
     if (0 == io_uring_sq_space_left(r)) [[unlikely]]
         if (io_uring_submit(r) < 0) return nullptr;
     return io_uring_get_sqe(r);
 }
 
+// An I/O waiting for room in its queue's ring (see sq_space). run_queue_loop calls on_space() once
+// the CQEs of a pass have freed some, oldest waiter first; a waiter that still finds none queues
+// again.
+struct sq_waiter {
+    sq_waiter* next{nullptr};
+    uint64_t since_ns{0};                     // CLOCK_MONOTONIC when it began waiting
+    void (*on_space)(sq_waiter*){nullptr};    // Resumes the waiting I/O
+    async_io const* owner{nullptr};           // Failed by run_queue_loop if on_space() throws; may be null
+};
+
+// What a queue has besides its ublk ring (q->ring_ptr): a polled ring, and how many SQEs its
+// target I/O may have in flight on each. The target hangs one of these off q->private_data; a
+// queue without it (e.g. one a test drives disks on directly) has only the ublk ring, unbounded.
+struct queue_rings {
+    // Set up with IORING_SETUP_IOPOLL (--iopoll) for drivers that answered prepare_result::polled:
+    // its completions are reaped by polling the device, not by interrupts, and only O_DIRECT reads
+    // and writes to a block device that polls may go there. nullptr when the queue has none.
+    io_uring* polled{nullptr};
+    uint32_t polled_inflight{0}; // SQEs taken from `polled` whose CQEs run_queue_loop has not reaped
+
+    // SQEs taken from the ublk ring with next_sqe(q) whose CQEs have not been reaped, and how many
+    // of them the ring is sized for (0: unbounded). Past that, I/O waits in sq_space.
+    uint32_t inflight{0};
+    uint32_t inflight_max{0};
+    // I/O waiting for room, oldest first. New I/O queues behind it unless it is being woken.
+    sq_waiter* waiters{nullptr};
+    sq_waiter* waiters_tail{nullptr};
+    bool waking{false};
+
+    // I/O drivers keep running past the request that started it (detached_io), counted across the
+    // target's queues: they serve their rings, and a shutdown drain keeps the device, until it is 0
+    std::atomic< uint32_t >* detached{nullptr};
+};
+
+inline queue_rings* rings_of(ublksrv_queue const* q) noexcept {
+    return q ? static_cast< queue_rings* >(q->private_data) : nullptr;
+}
+
+// Whether the queue holds new SQEs back: its SQEs in flight are at what its ring is sized for, or
+// other I/O is already waiting for room
+inline bool sq_held(queue_rings const* rings) noexcept {
+    return rings && ((0 < rings->inflight_max && rings->inflight_max <= rings->inflight) ||
+                     (rings->waiters && !rings->waking));
+}
+
+// Whether next_sqe(q) would come back empty: the queue holds SQEs back, or the kernel takes no more
+inline bool sq_full(ublksrv_queue const* q) noexcept {
+    if (sq_held(rings_of(q))) return true;
+    return 0 == io_uring_sq_space_left(q->ring_ptr) && 0 > io_uring_submit(q->ring_ptr);
+}
+
+// Acquires an SQE from the queue's io_uring, or nullptr when it has no room (sq_full()): a
+// coroutine then waits for room with sq_space and tries again, anything else fails the I/O with
+// -EBUSY.
+inline io_uring_sqe* next_sqe(ublksrv_queue const* q) {
+    auto* rings = rings_of(q);
+    if (sq_held(rings)) [[unlikely]]
+        return nullptr;
+    auto* sqe = next_sqe(q->ring_ptr);
+    if (sqe && rings) ++rings->inflight;
+    return sqe;
+}
+
+// Acquires an SQE from the queue's polled ring, or nullptr when it has none or it is full; the
+// caller then falls back to next_sqe(q). CQEs from either ring are routed the same way.
+inline io_uring_sqe* next_polled_sqe(ublksrv_queue const* q) {
+    auto* rings = rings_of(q);
+    if (!rings || !rings->polled || rings->polled->sq.ring_entries <= rings->polled_inflight) return nullptr;
+    auto* sqe = next_sqe(rings->polled);
+    if (sqe) ++rings->polled_inflight;
+    return sqe;
+}
+
+// co_await sq_space(q, data) after next_sqe(q) came back empty: suspends the I/O until the queue's
+// ring has room again and yields true, so the caller retries; false at once when the ring is not
+// full (the SQE was refused for another reason) or no run_queue_loop serves the queue, and the
+// caller fails as before. Lives in the awaiting frame, so waiting allocates nothing.
+class sq_space : sq_waiter {
+    ublksrv_queue const* _q;
+    std::coroutine_handle<> _h{};
+    bool _parked{false};
+
+public:
+    explicit sq_space(ublksrv_queue const* q, ublk_io_data const* data = nullptr) noexcept : _q(q) {
+        owner = data ? reinterpret_cast< async_io const* >(data->private_data) : nullptr;
+        on_space = [](sq_waiter* w) { static_cast< sq_space* >(w)->_h.resume(); };
+    }
+    bool await_ready() const noexcept { return !rings_of(_q) || !sq_full(_q); }
+    void await_suspend(std::coroutine_handle<> h) noexcept {
+        _h = h;
+        _parked = true;
+        park(_q, this);
+    }
+    bool await_resume() const noexcept { return _parked; }
+
+    // Queues `w` behind the I/O already waiting for room on `q`
+    static void park(ublksrv_queue const* q, sq_waiter* w) noexcept {
+        auto* rings = rings_of(q);
+        auto ts = timespec{};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        w->since_ns = static_cast< uint64_t >(ts.tv_sec) * 1000000000UL + static_cast< uint64_t >(ts.tv_nsec);
+        w->next = nullptr;
+        if (rings->waiters_tail)
+            rings->waiters_tail->next = w;
+        else
+            rings->waiters = w;
+        rings->waiters_tail = w;
+    }
+};
+
+// Held by I/O a driver leaves running on `q` once its request has completed (e.g. RAID1
+// write-behind copies) for as long as it runs: its CQEs still come in on that queue's ring.
+class detached_io {
+    std::atomic< uint32_t >* _count{nullptr};
+
+public:
+    explicit detached_io(ublksrv_queue const* q) noexcept {
+        if (auto* rings = rings_of(q); rings) _count = rings->detached;
+        if (_count) _count->fetch_add(1, std::memory_order_seq_cst);
+    }
+    ~detached_io() {
+        if (_count) _count->fetch_sub(1, std::memory_order_seq_cst);
+    }
+    detached_io(detached_io const&) = delete;
+    detached_io& operator=(detached_io const&) = delete;
+};
+
 } // namespace ublkpp
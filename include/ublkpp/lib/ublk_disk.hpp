@@ -107,18 +107,27 @@ public:
     // fixed-file table and the maximum number of SQEs this disk may submit for a single user I/O.
     // The target uses max_sqes_per_io to pre-reserve async_io::_pool at queue-init time so that
     // push_back during I/O never reallocates and cqe_state* pointers in SQE user_data stay stable.
+    // polled asks for a second, IORING_SETUP_IOPOLL ring per queue (queue_rings::polled) that some
+    // of those SQEs may go to; the target sets one up under --iopoll, sized like the first.
     struct prepare_result {
         std::vector< int > fds{};
         size_t max_sqes_per_io{1};
+        bool polled{false};
     };
 
     // Called once per queue at startup. Returns file descriptors to register in the queue's
     // io_uring fixed-file table (kernel assigns indices starting at iouring_device_start) and the
     // SQE ceiling for pre-reserving the per-tag cqe_state pool. Composite drivers propagate to
-    // children, concatenating fds and combining max_sqes_per_io.
+    // children, concatenating fds, combining max_sqes_per_io and asking for a polled ring if any does.
     // Default: no FDs, 1 SQE (subclasses that submit 0 or >1 SQEs per I/O must override).
     virtual prepare_result prepare(ublksrv_queue const* /*q*/, int const /*iouring_device_start*/) { return {}; }
 
+    // True when async_iov() reads and writes every iovec it is given, not only iovecs[0]. A target
+    // merging contiguous requests (--plug_merge) then hands such a disk several of them as one
+    // call: `data` is the first, and the length is that of the iovecs, not of data->iod.
+    // Composite drivers answer for their children. Default: false.
+    virtual bool scatter_gather() const noexcept { return false; }
+
     // Called by run_queue_loop when a probe timeout CQE fires. Probes ALL mirrors on every tick,
     // not only unavail ones; so silent healthy-to-failed transitions are detected within
     // k_io_idle_secs, not only after the next user I/O hits the failed device. No-op when
@@ -14,15 +14,69 @@ namespace ublkpp {
 class ublk_disk;
 using disk_handle = std::shared_ptr< ublk_disk >;
 
-// Construct a RAID0 stripe set. `disks` becomes the array (ownership consumed).
-// Throws std::runtime_error on bad geometry / superblock probe failure.
+// Construct a RAID0 stripe set of up to 256 legs. `disks` becomes the array (ownership consumed).
+// Re-assemble with the same disk order, followed by any legs added with raid0::expand(); a reshape
+// that was still running resumes in the background. Non-empty `weights` (one per disk, for at most
+// 64 disks, 1-255, summing to at most 256) give each leg that many stripes of every cycle, so
+// faster or larger legs take a bigger share (see raid0::weights_by_capacity()); they are recorded
+// when the array is created and the on-disk ones win afterwards. Weighted arrays cannot be expanded.
+// Throws std::invalid_argument on bad weights, std::runtime_error on bad geometry / superblock
+// probe failure.
 disk_handle make_raid0_disk(boost::uuids::uuid const& uuid, uint32_t stripe_size_bytes,
+                            std::vector< disk_handle >&& disks, std::vector< uint32_t > const& weights = {});
+
+namespace raid10 {
+// NEAR: legs are mirrored in pairs and striped like RAID0 over the pairs (even leg count).
+// FAR: each stripe is also kept in the far half of the next leg, so sequential reads stripe
+// across every leg; half of each leg holds the second copies.
+ENUM(layout, uint8_t, NEAR = 0, FAR = 1);
+} // namespace raid10
+
+// Construct a native RAID10 array over `disks` (2 to 64 legs; ownership consumed). One combined
+// superblock set describes the whole array and I/O is dispatched straight to the legs. Re-assemble
+// with the same disk order; the on-disk stripe size and layout win over the arguments. A missing
+// leg (see make_missing_disk()) or a leg that misses a write is recorded as failed and excluded;
+// see raid10::replace_device() to bring the array back to full redundancy. The superblocks also
+// record the regions with writes in flight; after a crash, assembly copies the first copy of each
+// stripe there over the second in the background.
+// Throws std::invalid_argument on bad geometry, std::runtime_error on superblock probe failure or
+// if the failed legs hold both copies of some stripe.
+disk_handle make_raid10_disk(boost::uuids::uuid const& uuid, uint32_t stripe_size_bytes,
+                             std::vector< disk_handle >&& disks, raid10::layout lay = raid10::layout::NEAR);
+
+// Construct a RAID5 (one rotating parity block per row, 3 to 64 legs) or RAID6 (P+Q parity, 4 to
+// 64 legs) array over `disks` (ownership consumed). Parity is computed with ISA-L. Re-assemble
+// with the same disk order; the on-disk chunk size wins over the argument. Missing or failing legs
+// are recorded as failed and their blocks reconstructed on read, up to the parity count; see
+// raid5::replace_device() to bring the array back to full redundancy. Parity of the rows a crash
+// may have left half written is recomputed in the background on the next assembly. Discard is not
+// supported.
+// Throws std::invalid_argument on bad geometry, std::runtime_error on superblock probe failure or
+// if more legs are unavailable than parity covers.
+disk_handle make_raid5_disk(boost::uuids::uuid const& uuid, uint32_t chunk_size_bytes,
+                            std::vector< disk_handle >&& disks);
+disk_handle make_raid6_disk(boost::uuids::uuid const& uuid, uint32_t chunk_size_bytes,
                             std::vector< disk_handle >&& disks);
 
 // Construct a 2-way RAID1 mirror from `dev_a` + `dev_b`. `parent_id` is woven into the metrics
-// labels; pass empty if metrics correlation is not needed.
+// labels; pass empty if metrics correlation is not needed. A `meta` device, if given when the array
+// is created, holds the dirty bitmap instead of the legs, which then reserve only a 4 KiB
+// superblock; the same `meta` must be passed on every later assembly.
 // Throws std::runtime_error on bad geometry / superblock probe failure.
 disk_handle make_raid1_disk(boost::uuids::uuid const& uuid, disk_handle dev_a, disk_handle dev_b,
+                            std::string const& parent_id = "", disk_handle meta = nullptr);
+
+// Construct an N-way RAID1 mirror (N >= 2) from `legs`. Legs past the second are assembled as a
+// chain of 2-way mirrors (legs[0] mirrors a mirror of legs[1..]) whose UUIDs derive from `uuid`;
+// re-assemble with the same leg order. Reads spread evenly across all clean leaves by chunk
+// address, so a single sequential reader touches one leaf at a time; spreading needs concurrent
+// reads. The array survives N-1 leg failures. The raid1:: API below recurses into the chain.
+// Each level of the chain is a full 2-way mirror: it reserves a superblock and bitmap region
+// (about 126 MiB, as make_raid1_disk() does) on what lies beneath it and runs a resync thread of
+// its own. The capacity is thus the smallest leg's less N-1 reservations, and N-1 resync threads
+// run.
+// Throws std::invalid_argument for fewer than 2 legs, otherwise as the 2-leg overload.
+disk_handle make_raid1_disk(boost::uuids::uuid const& uuid, std::vector< disk_handle >&& legs,
                             std::string const& parent_id = "");
 
 // Construct a placeholder disk representing a missing mirror leg. All I/O fails; is_missing()
@@ -34,34 +88,121 @@ namespace raid0 {
 // Returns the stripe leg at `stripe_offset`, or nullptr if out of range / not a Raid0 disk.
 disk_handle get_device(ublk_disk const& disk, uint32_t stripe_offset) noexcept;
 
+// Add `legs` to a live array. A background thread restripes the data across all legs in address
+// order; stripes it has passed are served by every leg at once and I/O into the few being moved
+// waits for them. Progress is kept in the superblocks, so an interrupted reshape resumes on the
+// next assembly. The array keeps its size while running: the added capacity appears on the first
+// assembly after the reshape completes. Returns false (and leaves the array untouched) if a
+// reshape is running, the array would exceed 256 legs, or a leg is smaller than the current legs
+// or otherwise incompatible.
+bool expand(ublk_disk& disk, std::vector< disk_handle >&& legs);
+
+// Array bytes left to restripe; 0 when no reshape is running or `disk` is not RAID0.
+uint64_t reshape_remaining(ublk_disk const& disk) noexcept;
+
+// Weights for make_raid0_disk() in proportion to the capacity of each of `disks`, so every leg
+// fills up at about the same point; empty (plain round-robin) for fewer than 2 or more than 64 disks.
+std::vector< uint32_t > weights_by_capacity(std::vector< disk_handle > const& disks, uint32_t stripe_size_bytes);
+
 } // namespace raid0
 
+namespace raid10 {
+
+// Returns the ids of the legs recorded as failed, in slot order. A leg fails once a write to it
+// fails again when reissued, and stays excluded until replaced. Empty if `disk` is not RAID10.
+std::vector< std::string > failed_devices(ublk_disk const& disk);
+
+// Put `new_device` in the slot of the failed leg `old_device_id` and copy every row back onto it
+// from the mirror copies in the background while the array stays online. Progress is kept in the
+// superblocks, so an interrupted rebuild resumes on the next assembly. Returns false (and leaves
+// the array untouched) if that leg is not failed, a rebuild is already running, or `new_device` is
+// too small or otherwise incompatible.
+bool replace_device(ublk_disk& disk, std::string const& old_device_id, disk_handle new_device);
+
+// Bytes left to rebuild on the leg being rebuilt; 0 when no rebuild is running or `disk` is not RAID10.
+uint64_t rebuild_remaining(ublk_disk const& disk) noexcept;
+
+} // namespace raid10
+
+// Management of RAID5 and RAID6 arrays; every call is a no-op (empty / false / 0) for other disks.
+namespace raid5 {
+
+// Returns the ids of the legs recorded as failed, in slot order.
+std::vector< std::string > failed_devices(ublk_disk const& disk);
+
+// Put `new_device` in the slot of the failed leg `old_device_id` and rebuild it in the background
+// while the array stays online. Returns false (and leaves the array untouched) if that leg is not
+// failed, a rebuild is already running, or `new_device` is too small.
+bool replace_device(ublk_disk& disk, std::string const& old_device_id, disk_handle new_device);
+
+// Bytes left to rebuild on the leg being rebuilt; 0 when no rebuild is running.
+uint64_t rebuild_remaining(ublk_disk const& disk) noexcept;
+
+} // namespace raid5
+
 namespace raid1 {
 
-ENUM(replica_state, uint8_t, CLEAN = 0, SYNCING = 1, ERROR = 2, UNAVAIL = 3);
+// SLOW (since 0.39.0): in sync and reachable, but demoted from reads by fail-slow detection (see the
+// slow_threshold option). It holds every byte a CLEAN leg does, so a consumer that only asks
+// whether a leg has the data treats it as CLEAN; one with an exhaustive switch must handle it. A
+// leg stays SLOW, or out of it, for at least 10 seconds at a time.
+ENUM(replica_state, uint8_t, CLEAN = 0, SYNCING = 1, ERROR = 2, UNAVAIL = 3, SLOW = 4);
+
+// One leaf of a mirror: its device id and state. A leaf inside a nested mirror of an N-way chain
+// reports the worse of its own state and that of the slot holding the nested mirror.
+struct leg_state {
+    std::string id;
+    replica_state state{replica_state::ERROR};
+};
 
 // Default-constructed value is a reserved sentinel: the implementation never produces both
 // legs in ERROR simultaneously (the active leg is always CLEAN or UNAVAIL), so wrong-type
-// queries are distinguishable from any valid Raid1 state.
+// queries are distinguishable from any valid Raid1 state. device_a/device_b are the two slots of
+// this mirror; `legs` lists every leaf in leg order, flattening N-way chains (two entries for a
+// plain 2-way mirror, empty for the sentinel).
 struct array_state {
     replica_state device_a{replica_state::ERROR};
     replica_state device_b{replica_state::ERROR};
     uint64_t bytes_to_sync{0};
+    std::vector< leg_state > legs{};
 };
 
-// Replace one leg of the mirror identified by `old_device_id` with `new_device`. On success
-// returns the displaced leg. On rejection (no matching id, geometry mismatch, would-degrade-
-// active-leg, etc.) returns `new_device` unchanged so the caller can identify rejection by
-// pointer-equality. Aborts if `disk` is not a Raid1 mirror (programmer error).
+// Replace one leg of the mirror identified by `old_device_id` with `new_device`, searching nested
+// mirrors of an N-way chain when the id is not a direct leg. On success returns the displaced
+// leg. On rejection (no matching id, geometry mismatch, would-degrade-active-leg, etc.) returns
+// `new_device` unchanged so the caller can identify rejection by pointer-equality. Aborts if
+// `disk` is not a Raid1 mirror (programmer error).
 disk_handle swap_device(ublk_disk& disk, std::string const& old_device_id, disk_handle new_device);
 
-// Returns the per-leg replica state + bytes-to-sync. If `disk` is not a Raid1 mirror, returns
-// the default-constructed value (see array_state).
+// Returns the per-slot and per-leaf replica state + bytes-to-sync. If `disk` is not a Raid1
+// mirror, returns the default-constructed value (see array_state).
 array_state replica_states(ublk_disk const& disk) noexcept;
 
 // Returns both legs of the mirror, or {nullptr, nullptr} if `disk` is not a Raid1 mirror.
 std::pair< disk_handle, disk_handle > replicas(ublk_disk const& disk) noexcept;
 
+// Mark the leg `device_id` write-mostly: it still receives every write but only serves reads when
+// the other leg cannot. With the `write_behind` option set, a write-mostly second leg (dev_b) may
+// also lag behind: writes are acked once the first leg completes, with up to `write_behind` MiB of
+// copies to the second leg in flight; it serves no reads and never takes over until they land.
+// Runtime-only; a swapped-in leg starts cleared. Returns false if no such leg exists (or `disk` is not Raid1).
+bool set_write_mostly(ublk_disk& disk, std::string const& device_id, bool write_mostly);
+
+// Detach the leg `device_id` from a clean mirror as a frozen point-in-time copy and return it;
+// nullptr if there is no such leg or the array is not clean. Its slot is left missing, the array
+// runs degraded and the dirty bitmap tracks every write made meanwhile. Blocks until writes in
+// flight at the split have landed, so the copy holds every write acked before it returns (it is
+// crash-consistent at that point). Quiesce the filesystem first for an application-consistent
+// copy, and treat the detached leg as read-only (its data starts at reserved_size()):
+// rejoin_mirror() trusts that it still holds the split-time contents.
+disk_handle split_mirror(ublk_disk& disk, std::string const& device_id);
+
+// Reattach a leg detached by split_mirror() into the missing slot. A leg still one age behind
+// the array resyncs only the regions written during the split; anything older (e.g. the array
+// restarted uncleanly while split) falls back to a full resync, as with swap_device(). Returns
+// false if the array has no missing slot or the leg is refused.
+bool rejoin_mirror(ublk_disk& disk, disk_handle leg);
+
 } // namespace raid1
 
 } // namespace ublkpp
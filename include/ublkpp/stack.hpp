@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+
+#include "ublkpp/drivers.hpp"
+#include "ublkpp/raid.hpp"
+
+namespace ublkpp {
+
+// Disk stacks whose topology is fixed at compile time, e.g.
+//
+//     auto disk = make_stack(stack::raid10< stack::fs >{.uuid = id, .stripe_size = 128 * Ki,
+//                                                       .legs = {{"/dev/nvme0n1"}, {"/dev/nvme1n1"}}});
+//
+// Each spec builds the same disk, with the same on-disk format, as the matching make_*_disk()
+// factory, and make_stack() returns an ordinary disk_handle: a stack can be run as a target or
+// used as a leg of any other disk. What the static type buys is the layer over the leaves: a RAID0
+// or RAID10 whose legs are all `stack::fs` issues each leg I/O inline, where the dynamic path
+// makes a virtual async_iov() call and a coroutine frame per leg. RAID1 layers still reach their
+// legs through ublk_disk, as raid1::swap_device() may put any disk in a slot.
+namespace stack {
+
+// A file or block device, as make_fs_disk()
+struct fs {
+    std::filesystem::path path;
+};
+
+// As make_raid0_disk(). Legs added to a RAID0 over `fs` with raid0::expand() must be FSDisks too.
+template < typename Leg >
+struct raid0 {
+    boost::uuids::uuid uuid;
+    uint32_t stripe_size;
+    std::vector< Leg > legs;
+    std::vector< uint32_t > weights{};
+};
+
+// As the 2-way make_raid1_disk()
+template < typename Leg >
+struct raid1 {
+    boost::uuids::uuid uuid;
+    Leg a;
+    Leg b;
+};
+
+// As make_raid10_disk()
+template < typename Leg >
+struct raid10 {
+    boost::uuids::uuid uuid;
+    uint32_t stripe_size;
+    std::vector< Leg > legs;
+    ::ublkpp::raid10::layout layout{::ublkpp::raid10::layout::NEAR};
+};
+
+namespace detail {
+// The fused layers: as make_raid0_disk() / make_raid10_disk(), for legs built by make_fs_disk().
+// Throw std::invalid_argument if any leg is not.
+disk_handle make_raid0_over_fs(boost::uuids::uuid const& uuid, uint32_t stripe_size_bytes,
+                               std::vector< disk_handle >&& disks, std::vector< uint32_t > const& weights);
+disk_handle make_raid10_over_fs(boost::uuids::uuid const& uuid, uint32_t stripe_size_bytes,
+                                std::vector< disk_handle >&& disks, ::ublkpp::raid10::layout lay);
+
+template < typename Leg >
+std::vector< disk_handle > make_legs(std::vector< Leg > const& legs, std::string const& parent_id);
+} // namespace detail
+
+// Builds the disk `spec` describes, leaves first. `parent_id` is passed to every layer that takes
+// one. Throws as the make_*_disk() factories do.
+inline disk_handle make_stack(fs const& spec, std::string const& parent_id = "") {
+    return make_fs_disk(spec.path, parent_id);
+}
+
+template < typename Leg >
+disk_handle make_stack(raid1< Leg > const& spec, std::string const& parent_id = "") {
+    return make_raid1_disk(spec.uuid, make_stack(spec.a, parent_id), make_stack(spec.b, parent_id), parent_id);
+}
+
+template < typename Leg >
+disk_handle make_stack(raid0< Leg > const& spec, std::string const& parent_id = "") {
+    auto legs = detail::make_legs(spec.legs, parent_id);
+    if constexpr (std::is_same_v< Leg, fs >)
+        return detail::make_raid0_over_fs(spec.uuid, spec.stripe_size, std::move(legs), spec.weights);
+    else
+        return make_raid0_disk(spec.uuid, spec.stripe_size, std::move(legs), spec.weights);
+}
+
+template < typename Leg >
+disk_handle make_stack(raid10< Leg > const& spec, std::string const& parent_id = "") {
+    auto legs = detail::make_legs(spec.legs, parent_id);
+    if constexpr (std::is_same_v< Leg, fs >)
+        return detail::make_raid10_over_fs(spec.uuid, spec.stripe_size, std::move(legs), spec.layout);
+    else
+        return make_raid10_disk(spec.uuid, spec.stripe_size, std::move(legs), spec.layout);
+}
+
+template < typename Leg >
+std::vector< disk_handle > detail::make_legs(std::vector< Leg > const& legs, std::string const& parent_id) {
+    auto disks = std::vector< disk_handle >();
+    disks.reserve(legs.size());
+    for (auto const& leg : legs)
+        disks.push_back(make_stack(leg, parent_id));
+    return disks;
+}
+
+} // namespace stack
+} // namespace ublkpp
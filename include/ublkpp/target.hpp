@@ -1,9 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <expected>
 #include <memory>
 #include <filesystem>
+#include <optional>
 #include <system_error>
+#include <vector>
 
 #include <boost/uuid/uuid.hpp>
 
@@ -17,6 +20,48 @@ class ublk_disk;
 using disk_handle = std::shared_ptr< ublk_disk >;
 struct ublkpp_tgt_impl;
 
+// A byte range of the volume reported by changed-block tracking.
+struct changed_extent {
+    uint64_t offset;
+    uint64_t length;
+    bool operator==(changed_extent const&) const = default;
+};
+
+// io_uring setup of a target's queue rings
+enum class ring_mode : uint8_t {
+    COOP_TASKRUN,  // Task work runs at the queue thread's next kernel transition, without an IPI
+    DEFER_TASKRUN, // Task work runs only when the queue waits for completions, batched
+    SQPOLL,        // A kernel thread per queue polls its SQ: submission without io_uring_enter()
+};
+
+struct ring_setup {
+    ring_mode mode{ring_mode::COOP_TASKRUN};
+    // io_uring_register_ring_fd(): io_uring_enter() skips the fd lookup
+    bool register_fd{false};
+
+    // The setup --ring_mode and --ring_fd describe; nullopt for an unknown mode
+    static std::optional< ring_setup > from_options();
+};
+
+// A token bucket: `rate` units per second, and up to `burst` more let through at once after the
+// target has run below the rate. A rate of 0 leaves the bucket unlimited.
+struct qos_limit {
+    uint64_t rate{0};
+    uint64_t burst{0};
+
+    bool operator==(qos_limit const&) const = default;
+};
+
+// Per-target QoS. DISCARD and WRITE_ZEROES take write IOPS only; FLUSH is never limited.
+struct qos_limits {
+    qos_limit read_iops{};
+    qos_limit write_iops{};
+    qos_limit read_bytes{};
+    qos_limit write_bytes{};
+
+    bool operator==(qos_limits const&) const = default;
+};
+
 struct ublkpp_tgt {
     using run_result_t = std::expected< std::unique_ptr< ublkpp_tgt >, std::error_condition >;
 
@@ -28,9 +73,12 @@ struct ublkpp_tgt {
     // Brings up the ublk target. `vol_id` identifies the volume (woven into superblock + metric
     // labels). `device_id`: -1 lets the kernel assign /dev/ublkbN; >=0 attempts to recover a
     // kernel-preserved device under UBLK_F_USER_RECOVERY (no_such_device if not found).
+    // `ring` selects how its queue rings are set up, ring_setup::from_options() when not given.
     // Returns the live tgt or an error_condition (system_category from the ublksrv handshake,
-    // operation_not_permitted on permission/setup failure, invalid_argument on bad geometry).
-    static run_result_t run(boost::uuids::uuid const& vol_id, disk_handle device, int device_id = -1);
+    // operation_not_permitted on permission/setup failure, invalid_argument on bad geometry or an
+    // unknown --ring_mode).
+    static run_result_t run(boost::uuids::uuid const& vol_id, disk_handle device, int device_id = -1,
+                            std::optional< ring_setup > ring = std::nullopt);
 
     // Signals the target to begin a graceful drain. After this call, new I/O is dropped (left
     // uncompleted / OWNED_BY_SRV) so the kernel requeues it to the next daemon under
@@ -82,6 +130,36 @@ struct ublkpp_tgt {
     // Asserts (RELEASE_ASSERT) if called on a make_for_test() target (dev_data is null).
     int device_id() const;
 
+    // Changed-block tracking (CBT) for incremental backups, independent of the backing disk type.
+    // Off until the first cbt_new_epoch(); from then on every WRITE / WRITE_ZEROES / DISCARD the
+    // target completes is recorded at 32 KiB granularity, failed ones included. Tracking lives in
+    // memory only: a restarted target reports epoch 0 and the next backup must be a full one.
+    //
+    // Closes the current epoch and opens the next, returning the extents changed during the one
+    // just closed (sorted, coalesced; empty on the call that enables tracking). A write racing the
+    // rotation is reported in exactly one of the two epochs.
+    std::vector< changed_extent > cbt_new_epoch();
+    // Extents changed so far in the current epoch, which stays open. Empty while tracking is off.
+    std::vector< changed_extent > cbt_changed() const;
+    // Current epoch number, starting at 1; 0 while tracking is off.
+    uint64_t cbt_epoch() const;
+
+    // QoS limits, unlimited until first set. I/O over a limit is parked on its queue thread until
+    // the bucket lets it through, and the time it waited is exported as throttled time in the
+    // target's I/O metrics. May be changed at any time: parked I/O is re-admitted under the new
+    // limits, and lifting them releases it at once.
+    void set_qos(qos_limits const& limits);
+    qos_limits qos() const;
+
+    // I/O priority as ioprio_set(2) takes it (IOPRIO_PRIO_VALUE(class, level)); 0, the default,
+    // leaves the backing devices to use the daemon's. ublk does not pass the priority of each
+    // request, so it is the target's: every SQE submitted to a backing device for this target
+    // carries it. An IOPRIO_CLASS_IDLE target's queue threads also run SCHED_IDLE, so queues of
+    // other targets sharing their CPUs are served first; under --shared_reactors, whose threads
+    // serve many targets, only the SQEs take it. May be changed at any time.
+    void set_io_priority(uint16_t ioprio);
+    uint16_t io_priority() const;
+
 private:
     explicit ublkpp_tgt(std::shared_ptr< ublkpp_tgt_impl > p);
     std::shared_ptr< ublkpp_tgt_impl > _p;
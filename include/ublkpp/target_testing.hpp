@@ -8,6 +8,8 @@
 
 namespace ublkpp {
 
+class ChangeTracker;
+
 // Test peer: declared as friend in ublkpp_tgt, providing access to internal state for tests.
 // All methods are implemented in ublkpp_tgt.cpp. Do not use outside of test binaries.
 struct ublkpp_tgt_test_peer {
@@ -23,6 +25,9 @@ struct ublkpp_tgt_test_peer {
 
     // Returns the I/O metrics for direct counter manipulation in tests.
     static UblkIOMetrics& metrics(ublkpp_tgt& tgt);
+
+    // Returns the changed-block tracker queue threads mark, or nullptr before cbt_new_epoch().
+    static ChangeTracker* change_tracker(ublkpp_tgt& tgt);
 };
 
 } // namespace ublkpp
@@ -11,6 +11,7 @@ extern "C" {
 }
 
 #include <fstream>
+#include <tuple>
 
 #include <sisl/logging/logging.h>
 #include <sisl/options/options.h>
@@ -36,7 +37,7 @@ namespace ublkpp {
 // environments (MockUblksrv) may run on older kernels.  Fall back to synchronous preadv2/pwritev2
 // on affected kernels so CQE delivery implies the data is already visible to page-cache readers.
 // When the minimum supported test kernel is raised above 5.4, this guard and the sync_iov
-// fallback in async_iov can be removed.
+// fallback in __submit_other can be removed.
 static bool buffered_uring_broken() {
     // clang-format off
     struct utsname uts{};
@@ -48,31 +49,6 @@ static bool buffered_uring_broken() {
 }
 static bool const k_buffered_uring_broken = buffered_uring_broken();
 
-// File-local concrete ublk_disk; constructed only via the make_fs_disk factory below. The public
-// header exposes only the factory; consumers (raid composers, target wiring) operate against the
-// ublk_disk virtual interface.
-class FSDisk : public ublk_disk {
-    std::filesystem::path _path;
-    int _fd{-1};
-    bool _block_device{false};
-    std::unique_ptr< UblkFSDiskMetrics > _metrics;
-
-public:
-    explicit FSDisk(std::filesystem::path const& path, std::string const& parent_id = "");
-    ~FSDisk() override;
-
-    std::string id() const noexcept override { return _path.native(); }
-
-    prepare_result prepare(ublksrv_queue const*, int const) override;
-    disk_task< int > async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
-                               uint64_t addr) override;
-    io_result sync_iov(uint8_t op, iovec* iovecs, uint32_t nr_vecs, off_t offset) noexcept override;
-
-private:
-    std::pair< io_result, cqe_state* > handle_discard(ublksrv_queue const* q, ublk_io_data const* data, uint32_t len,
-                                                      uint64_t addr);
-};
-
 FSDisk::FSDisk(std::filesystem::path const& path, std::string const& parent_id) : ublk_disk(), _path(path) {
     // Create metrics with parent_id for correlation
     if (!parent_id.empty()) { _metrics = std::make_unique< UblkFSDiskMetrics >(parent_id, _path.string()); }
@@ -157,6 +133,9 @@ FSDisk::FSDisk(std::filesystem::path const& path, std::string const& parent_id)
     // discard_granularity is zero-initialized and only set from st.st_blksize when the device
     // supports discard (can_discard()). If it stayed zero, discard was not configured — strip flag.
     if (our_params.discard.discard_granularity == 0) { our_params.types &= ~UBLK_PARAM_TYPE_DISCARD; }
+    _sync_fallback = !_direct_io && k_buffered_uring_broken;
+    _iopoll = _direct_io && _block_device && block_polls(st);
+    if (_iopoll) DLOGD("{} polls: reads and writes may complete on a polled ring", str_path)
     fd_scope.release(); // constructor succeeded: _fd ownership transferred to this
 }
 
@@ -179,66 +158,47 @@ FSDisk::~FSDisk() {
 //}
 
 FSDisk::prepare_result FSDisk::prepare(ublksrv_queue const*, int const) {
-    return {.max_sqes_per_io = 1}; // READ/WRITE submit 1 SQE; FLUSH and block-DISCARD submit 0
+    // READ/WRITE submit 1 SQE; FLUSH and block-DISCARD submit 0
+    return {.max_sqes_per_io = 1, .polled = _iopoll};
 }
 
 disk_task< int > FSDisk::async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
                                    uint64_t addr) {
-    auto const op = ublksrv_get_op(data->iod);
+    auto [res, state] = submit(q, data, iovecs, nr_vecs, addr);
+    // The ring is full: wait for room and queue it again
+    while (-EBUSY == res && co_await sq_space(q, data))
+        std::tie(res, state) = submit(q, data, iovecs, nr_vecs, addr);
+    if (!state) co_return res;
+    auto const cqe_result = co_await *state;
+    finish(data);
+    co_return cqe_result;
+}
 
-    if (op == UBLK_IO_OP_FLUSH) co_return 0;
+std::pair< int, cqe_state* > FSDisk::__submit_other(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs,
+                                                    uint32_t nr_vecs, uint64_t addr) {
+    auto const op = ublksrv_get_op(data->iod);
+    if (op == UBLK_IO_OP_FLUSH) return {0, nullptr};
 
-    io_result res;
-    cqe_state* state{nullptr};
-    bool track_metrics{false};
     if (op == UBLK_IO_OP_DISCARD || op == UBLK_IO_OP_WRITE_ZEROES) {
         uint32_t const len = (nr_vecs > 0) ? static_cast< uint32_t >(iovecs[0].iov_len) : 0;
-        auto [discard_res, discard_state] = handle_discard(q, data, len, addr);
-        res = discard_res;
-        state = discard_state;
-    } else {
-        DLOGT("{} {} : [tag:{:#0x}] ublk io [addr:{:#0x}|len:{:#0x}]", op == UBLK_IO_OP_READ ? "READ" : "WRITE",
-              _path.native(), data->tag, addr, iovec_len(iovecs, iovecs + nr_vecs))
-        // LCOV_EXCL_START — kernel <= 5.4 sync fallback, not exercised in production
-        if (!_direct_io && k_buffered_uring_broken) {
-            auto r = sync_iov(op, iovecs, nr_vecs, static_cast< off_t >(addr));
-            if (!r) co_return -static_cast< int >(r.error().value());
-            co_return 0; // inline completion
-        }
-        // LCOV_EXCL_STOP
-
-        auto sqe = next_sqe(q);
-        if (!sqe) [[unlikely]]
-            co_return -EBUSY;
-        DEBUG_ASSERT_GE(capacity(), iovecs->iov_len + addr, "Access beyond device bounds!");
-
-        if (UBLK_IO_OP_READ == op) {
-            io_uring_prep_readv(sqe, _fd, iovecs, nr_vecs, addr);
-        } else {
-            io_uring_prep_writev(sqe, _fd, iovecs, nr_vecs, addr);
-        }
-
-        if (UBLK_IO_OP_READ != op && (data->iod->op_flags & UBLK_IO_F_FUA)) sqe->rw_flags |= RWF_DSYNC;
-        auto [s, sqe_data] = build_cqe_state_data(data);
-        state = s;
-        sqe->user_data = sqe_data;
-        if (_metrics) { // GCOVR_EXCL_BR_LINE -- UblkFSDiskMetrics requires prometheus registry; not constructible in
-                        // unit tests
-            // LCOV_EXCL_START
-            _metrics->record_io_start(data);
-            track_metrics = true;
-        } // LCOV_EXCL_STOP
-        res = 1;
+        auto [res, state] = handle_discard(q, data, len, addr);
+        if (!res) return {-static_cast< int >(res.error().value()), nullptr};
+        return {(0 == res.value()) ? 0 : 1, state};
     }
 
-    if (!res) co_return -static_cast< int >(res.error().value());
-    if (res.value() == 0) co_return 0;
-
-    auto const cqe_result = co_await *state;
-    if (track_metrics) { _metrics->record_io_complete(data); } // GCOVR_EXCL_BR_LINE
-    co_return cqe_result;
+    // LCOV_EXCL_START — kernel <= 5.4 sync fallback, not exercised in production
+    if (auto r = sync_iov(op, iovecs, nr_vecs, static_cast< off_t >(addr)); !r)
+        return {-static_cast< int >(r.error().value()), nullptr};
+    return {0, nullptr}; // inline completion
+    // LCOV_EXCL_STOP
 }
 
+// UblkFSDiskMetrics requires a prometheus registry; not constructible in unit tests
+// LCOV_EXCL_START
+void FSDisk::__record_start(ublk_io_data const* data) noexcept { _metrics->record_io_start(data); }
+void FSDisk::__record_complete(ublk_io_data const* data) noexcept { _metrics->record_io_complete(data); }
+// LCOV_EXCL_STOP
+
 std::pair< io_result, cqe_state* > FSDisk::handle_discard(ublksrv_queue const* q, ublk_io_data const* data,
                                                           uint32_t len, uint64_t addr) {
     DLOGD("DISCARD {}: [tag:{:#0x}] ublk io [addr:{:#0x}|len:{:#0x}]", _path.native(), data->tag, addr, len)
@@ -247,6 +207,7 @@ std::pair< io_result, cqe_state* > FSDisk::handle_discard(ublksrv_queue const* q
         if (!sqe) [[unlikely]]
             return {std::unexpected(std::make_error_condition(std::errc::device_or_resource_busy)), nullptr};
         io_uring_prep_fallocate(sqe, _fd, discard_to_fallocate(data->iod), addr, len);
+        sqe->ioprio = io_priority(data);
 
         auto [state, sqe_data] = build_cqe_state_data(data);
         sqe->user_data = sqe_data;
@@ -6,20 +6,29 @@ extern "C" {
 
 #include <filesystem>
 #include <fstream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <utility>
 
 #include <sisl/logging/logging.h>
 #include <ublksrv.h>
 
+#include <ublkpp/lib/cqe_state.hpp>
+#include <ublkpp/lib/ublk_disk.hpp>
+
+#include "lib/common.hpp"
 #include "lib/logging.hpp"
 
 namespace ublkpp {
 
 // In order to correctly handle partitions we follow the device link into the each subsystem rather than
-// probe the sysfs/block filesystem which lacks discard info for partitions.
-inline bool block_has_unmap(struct stat const& st) {
+// probe the sysfs/block filesystem which lacks discard info for partitions. Reads the number in the
+// device's queue/<attr>, or 0 when there is none.
+inline uint64_t block_queue_attr(struct stat const& st, std::string_view attr) {
     static auto const sys_path = std::filesystem::path{"/"} / "sys" / "dev" / "block";
-    static auto const discard_path = std::filesystem::path{"queue"} / "discard_max_hw_bytes";
+    auto const attr_path = std::filesystem::path{"queue"} / attr;
 
     auto const subsysytem_link = sys_path / fmt::format("{}:{}", major(st.st_rdev), minor(st.st_rdev));
     auto ec = std::error_code();
@@ -27,28 +36,33 @@ inline bool block_has_unmap(struct stat const& st) {
     if (ec) {
         DLOGW("Device [{}] is not present in sysfs [maj:min = {}:{}]: {}", subsysytem_link.native(), major(st.st_rdev),
               minor(st.st_rdev), ec.message())
-        return false;
+        return 0;
     }
 
-    auto str_path = (sys_path / resolved_path / discard_path).native();
+    auto str_path = (sys_path / resolved_path / attr_path).native();
     DLOGD("Probing {}", str_path)
-    std::ifstream discard_max(str_path, std::ios::in);
-    if (!discard_max.is_open()) {
-        str_path = (sys_path / resolved_path / ".." / discard_path).native();
+    std::ifstream attr_file(str_path, std::ios::in);
+    if (!attr_file.is_open()) {
+        str_path = (sys_path / resolved_path / ".." / attr_path).native();
         DLOGD("Testing for partition {}", str_path)
-        discard_max = std::ifstream(str_path, std::ios::in);
+        attr_file = std::ifstream(str_path, std::ios::in);
     }
-    if (!discard_max.is_open()) return false;
+    if (!attr_file.is_open()) return 0;
 
-    uint64_t max_discard{0};
+    uint64_t value{0};
     std::string line;
-    if (std::getline(discard_max, line)) {
+    if (std::getline(attr_file, line)) {
         std::istringstream iss(line);
-        iss >> max_discard;
+        iss >> value;
     }
-    return 0 < max_discard;
+    return value;
 }
 
+inline bool block_has_unmap(struct stat const& st) { return 0 < block_queue_attr(st, "discard_max_hw_bytes"); }
+
+// Whether the device completes polled (IOPOLL / RWF_HIPRI) I/O by polling; NVMe needs poll queues
+inline bool block_polls(struct stat const& st) { return 0 < block_queue_attr(st, "io_poll"); }
+
 inline auto discard_to_fallocate(ublksrv_io_desc const* iod) {
     int const mode = FALLOC_FL_KEEP_SIZE;
     if (UBLK_IO_OP_DISCARD == ublksrv_get_op(iod) || (0 == (UBLK_IO_F_NOUNMAP & ublksrv_get_flags(iod)))) {
@@ -57,4 +71,82 @@ inline auto discard_to_fallocate(ublksrv_io_desc const* iod) {
     return mode | FALLOC_FL_ZERO_RANGE;
 }
 
+struct UblkFSDiskMetrics;
+
+// Concrete ublk_disk over a file or block device; constructed via the make_fs_disk factory.
+// Declared here rather than in fs_disk.cpp so that composites whose legs are known to be FSDisks
+// (see stack::make_stack()) can issue leg I/O through submit() / finish() directly: no virtual
+// call and no coroutine frame per leg.
+class FSDisk final : public ublk_disk {
+    std::filesystem::path _path;
+    int _fd{-1};
+    bool _block_device{false};
+    bool _sync_fallback{false}; // Buffered I/O on a kernel whose io_uring cannot be trusted with it
+    bool _iopoll{false};        // O_DIRECT on a block device that polls: reads and writes may be polled
+    std::unique_ptr< UblkFSDiskMetrics > _metrics;
+
+public:
+    explicit FSDisk(std::filesystem::path const& path, std::string const& parent_id = "");
+    ~FSDisk() override;
+
+    std::string id() const noexcept override { return _path.native(); }
+
+    prepare_result prepare(ublksrv_queue const*, int const) override;
+    bool scatter_gather() const noexcept override { return true; }
+    disk_task< int > async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
+                               uint64_t addr) override;
+    io_result sync_iov(uint8_t op, iovec* iovecs, uint32_t nr_vecs, off_t offset) noexcept override;
+
+    // async_iov() without the wait: queues the SQE and returns {1, state} with the cqe_state its
+    // result arrives on, {0, nullptr} if the I/O completed inline, or {-errno, nullptr}. A caller
+    // that got a state co_awaits it and then calls finish(); one that got -EBUSY may wait for room
+    // in the ring (sq_space) and call it again.
+    std::pair< int, cqe_state* > submit(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs,
+                                        uint32_t nr_vecs, uint64_t addr);
+    void finish(ublk_io_data const* data) noexcept {
+        if (_metrics) [[unlikely]]
+            __record_complete(data);
+    }
+
+private:
+    std::pair< io_result, cqe_state* > handle_discard(ublksrv_queue const* q, ublk_io_data const* data, uint32_t len,
+                                                      uint64_t addr);
+    std::pair< int, cqe_state* > __submit_other(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs,
+                                                uint32_t nr_vecs, uint64_t addr);
+    void __record_start(ublk_io_data const* data) noexcept;
+    void __record_complete(ublk_io_data const* data) noexcept;
+};
+
+// Reads and writes are queued here; flush, discard and the kernel <= 5.4 fallback go out of line
+inline std::pair< int, cqe_state* > FSDisk::submit(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs,
+                                                   uint32_t nr_vecs, uint64_t addr) {
+    auto const op = ublksrv_get_op(data->iod);
+    if ((UBLK_IO_OP_READ != op && UBLK_IO_OP_WRITE != op) || _sync_fallback) [[unlikely]]
+        return __submit_other(q, data, iovecs, nr_vecs, addr);
+
+    DLOGT("{} {} : [tag:{:#0x}] ublk io [addr:{:#0x}|len:{:#0x}]", op == UBLK_IO_OP_READ ? "READ" : "WRITE",
+          _path.native(), data->tag, addr, iovec_len(iovecs, iovecs + nr_vecs))
+    // FUA writes stay on the interrupt-driven ring: RWF_DSYNC may need a cache flush after the write
+    auto const fua = UBLK_IO_OP_READ != op && (data->iod->op_flags & UBLK_IO_F_FUA);
+    auto sqe = (_iopoll && !fua) ? next_polled_sqe(q) : nullptr;
+    if (!sqe) sqe = next_sqe(q);
+    if (!sqe) [[unlikely]]
+        return {-EBUSY, nullptr};
+    DEBUG_ASSERT_GE(capacity(), iovec_len(iovecs, iovecs + nr_vecs) + addr, "Access beyond device bounds!");
+
+    if (UBLK_IO_OP_READ == op) {
+        io_uring_prep_readv(sqe, _fd, iovecs, nr_vecs, addr);
+    } else {
+        io_uring_prep_writev(sqe, _fd, iovecs, nr_vecs, addr);
+    }
+
+    if (fua) sqe->rw_flags |= RWF_DSYNC;
+    sqe->ioprio = io_priority(data);
+    auto [state, sqe_data] = build_cqe_state_data(data);
+    sqe->user_data = sqe_data;
+    if (_metrics) [[unlikely]]
+        __record_start(data);
+    return {1, state};
+}
+
 } // namespace ublkpp
@@ -3,6 +3,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <linux/ioprio.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -36,6 +37,14 @@ TEST(BlockHasUnmap, NonExistentDevice) {
     EXPECT_FALSE(result);
 }
 
+TEST(BlockPolls, NonExistentDevice) {
+    // clang-format off
+    struct stat fake_stat{};
+    // clang-format on
+    EXPECT_FALSE(ublkpp::block_polls(fake_stat));
+    EXPECT_EQ(0U, ublkpp::block_queue_attr(fake_stat, "io_poll"));
+}
+
 // ============================================================================
 // Test discard_to_fallocate function
 // ============================================================================
@@ -133,4 +142,14 @@ TEST(FsDiskImpl, CqeStateTargetBitEncoding) {
     EXPECT_EQ(state, decoded);
 }
 
+TEST(FsDiskImpl, IoPriorityFollowsTheIo) {
+    // FSDisk stamps every SQE with io_priority(); __handle_io_async sets it from the target
+    ublkpp::async_io io{};
+    ublk_io_data fake{};
+    fake.private_data = &io;
+    EXPECT_EQ(0U, ublkpp::io_priority(&fake));
+    io._ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0);
+    EXPECT_EQ(IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0), ublkpp::io_priority(&fake));
+}
+
 } // anonymous namespace
@@ -25,6 +25,12 @@ UblkIOMetrics::UblkIOMetrics(std::string const& uuid) : sisl::MetricsGroup{"ublk
                        HistogramBucketsType(ExponentialOfTwoBuckets));
     REGISTER_HISTOGRAM(ublk_write_latency_us, "Write IO latency in microseconds",
                        HistogramBucketsType(ExponentialOfTwoBuckets));
+    REGISTER_COUNTER(read_throttled_total, "Reads held back by QoS limits", "ublk_read_throttled_total");
+    REGISTER_COUNTER(write_throttled_total, "Writes held back by QoS limits", "ublk_write_throttled_total");
+    REGISTER_COUNTER(read_throttled_us_total, "Time reads waited on QoS limits in microseconds",
+                     "ublk_read_throttled_us_total");
+    REGISTER_COUNTER(write_throttled_us_total, "Time writes waited on QoS limits in microseconds",
+                     "ublk_write_throttled_us_total");
     register_me_to_farm();
 }
 
@@ -122,4 +128,18 @@ void UblkIOMetrics::record_io_error(uint8_t op) {
     }
 }
 
+void UblkIOMetrics::record_io_throttled(uint8_t op, uint64_t microseconds) {
+    if (op == 0) { // UBLK_IO_OP_READ
+        _throttled_reads.fetch_add(1, std::memory_order_relaxed);
+        _read_throttled_us.fetch_add(microseconds, std::memory_order_relaxed);
+        COUNTER_INCREMENT(*this, read_throttled_total, 1);
+        COUNTER_INCREMENT(*this, read_throttled_us_total, microseconds);
+    } else if (op != 2) { // all but UBLK_IO_OP_FLUSH, which is never throttled
+        _throttled_writes.fetch_add(1, std::memory_order_relaxed);
+        _write_throttled_us.fetch_add(microseconds, std::memory_order_relaxed);
+        COUNTER_INCREMENT(*this, write_throttled_total, 1);
+        COUNTER_INCREMENT(*this, write_throttled_us_total, microseconds);
+    }
+}
+
 } // namespace ublkpp
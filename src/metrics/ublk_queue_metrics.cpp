@@ -0,0 +1,75 @@
+#include "ublk_queue_metrics.hpp"
+
+#include <fmt/format.h>
+
+namespace ublkpp {
+
+UblkQueueMetrics::UblkQueueMetrics(std::string const& uuid, int q_id) :
+        sisl::MetricsGroup{"ublk_queue_metrics", fmt::format("{}_q{}", uuid, q_id)} {
+    auto const queue = std::to_string(q_id);
+    REGISTER_COUNTER(busy_poll_hits_total, "Completions caught spinning on the CQ ring", "ublk_busy_poll_hits_total",
+                     {"queue", queue});
+    REGISTER_COUNTER(busy_poll_misses_total, "Spins that ran out their window and slept",
+                     "ublk_busy_poll_misses_total", {"queue", queue});
+    REGISTER_COUNTER(busy_poll_spin_ns_total, "Time spent spinning on the CQ ring", "ublk_busy_poll_spin_ns_total",
+                     {"queue", queue});
+    REGISTER_COUNTER(busy_poll_wasted_ns_total, "Time spent spinning in spins that then slept",
+                     "ublk_busy_poll_wasted_ns_total", {"queue", queue});
+    REGISTER_GAUGE(busy_poll_window_ns, "Current spin window", "ublk_busy_poll_window_ns", {"queue", queue});
+    REGISTER_COUNTER(plug_ios_total, "Requests held back for merging", "ublk_plug_ios_total", {"queue", queue});
+    REGISTER_COUNTER(plug_dispatches_total, "I/Os issued for the requests held back", "ublk_plug_dispatches_total",
+                     {"queue", queue});
+    REGISTER_COUNTER(sq_full_waits_total, "I/Os that waited for room in the queue ring", "ublk_sq_full_waits_total",
+                     {"queue", queue});
+    REGISTER_COUNTER(sq_full_wait_ns_total, "Time I/O spent waiting for room in the queue ring",
+                     "ublk_sq_full_wait_ns_total", {"queue", queue});
+    REGISTER_COUNTER(steal_lent_ios_total, "Requests of this queue served by a sibling queue",
+                     "ublk_steal_lent_ios_total", {"queue", queue});
+    REGISTER_COUNTER(steal_stolen_ios_total, "Requests of sibling queues served by this one",
+                     "ublk_steal_stolen_ios_total", {"queue", queue});
+    register_me_to_farm();
+}
+
+UblkQueueMetrics::~UblkQueueMetrics() { deregister_me_from_farm(); }
+
+void UblkQueueMetrics::record_spin_hit(uint64_t spun_ns) {
+    _spin_hits.fetch_add(1, std::memory_order_relaxed);
+    COUNTER_INCREMENT(*this, busy_poll_hits_total, 1);
+    COUNTER_INCREMENT(*this, busy_poll_spin_ns_total, spun_ns);
+}
+
+void UblkQueueMetrics::record_spin_miss(uint64_t spun_ns) {
+    _spin_misses.fetch_add(1, std::memory_order_relaxed);
+    _spin_wasted_ns.fetch_add(spun_ns, std::memory_order_relaxed);
+    COUNTER_INCREMENT(*this, busy_poll_misses_total, 1);
+    COUNTER_INCREMENT(*this, busy_poll_spin_ns_total, spun_ns);
+    COUNTER_INCREMENT(*this, busy_poll_wasted_ns_total, spun_ns);
+}
+
+void UblkQueueMetrics::record_poll_window(uint64_t window_ns) { GAUGE_UPDATE(*this, busy_poll_window_ns, window_ns); }
+
+void UblkQueueMetrics::record_unplug(uint64_t ios, uint64_t dispatches) {
+    _plugged_ios.fetch_add(ios, std::memory_order_relaxed);
+    _plug_dispatches.fetch_add(dispatches, std::memory_order_relaxed);
+    COUNTER_INCREMENT(*this, plug_ios_total, ios);
+    COUNTER_INCREMENT(*this, plug_dispatches_total, dispatches);
+}
+
+void UblkQueueMetrics::record_sq_wait(uint64_t waited_ns) {
+    _sq_waits.fetch_add(1, std::memory_order_relaxed);
+    _sq_wait_ns.fetch_add(waited_ns, std::memory_order_relaxed);
+    COUNTER_INCREMENT(*this, sq_full_waits_total, 1);
+    COUNTER_INCREMENT(*this, sq_full_wait_ns_total, waited_ns);
+}
+
+void UblkQueueMetrics::record_lent(uint64_t ios) {
+    _lent_ios.fetch_add(ios, std::memory_order_relaxed);
+    COUNTER_INCREMENT(*this, steal_lent_ios_total, ios);
+}
+
+void UblkQueueMetrics::record_stolen(uint64_t ios) {
+    _stolen_ios.fetch_add(ios, std::memory_order_relaxed);
+    COUNTER_INCREMENT(*this, steal_stolen_ios_total, ios);
+}
+
+} // namespace ublkpp
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <sisl/metrics/metrics.hpp>
+
+namespace ublkpp {
+
+// Per-queue metrics of the queue loop's busy-poll: how often spinning on the CQ ring caught a
+// completion before the queue would have slept, and the CPU time spent spinning for nothing. And
+// of its plugging: how many requests went to the disk as how many I/Os. How long I/O waited for
+// room in the queue ring. And, under work stealing, how many of its requests sibling queues
+// served and how many of theirs it served.
+//
+// Constructor parameters:
+//   uuid: The volume/target UUID for this ublkpp target instance.
+//   q_id: The ublk queue this instance reports for.
+struct UblkQueueMetrics : public sisl::MetricsGroup {
+    UblkQueueMetrics(std::string const& uuid, int q_id);
+    ~UblkQueueMetrics();
+
+    std::atomic< uint64_t > _spin_hits{0};
+    std::atomic< uint64_t > _spin_misses{0};
+    std::atomic< uint64_t > _spin_wasted_ns{0};
+    std::atomic< uint64_t > _plugged_ios{0};
+    std::atomic< uint64_t > _plug_dispatches{0};
+    std::atomic< uint64_t > _sq_waits{0};
+    std::atomic< uint64_t > _sq_wait_ns{0};
+    std::atomic< uint64_t > _lent_ios{0};
+    std::atomic< uint64_t > _stolen_ios{0};
+
+    // A spin of `spun_ns` that found a completion
+    void record_spin_hit(uint64_t spun_ns);
+    // A spin of `spun_ns` that ran out its window; the queue went to sleep after it
+    void record_spin_miss(uint64_t spun_ns);
+    void record_poll_window(uint64_t window_ns);
+    // A CQE batch's `ios` requests, issued as `dispatches` I/Os
+    void record_unplug(uint64_t ios, uint64_t dispatches);
+    // An I/O that waited `waited_ns` for room in the queue ring
+    void record_sq_wait(uint64_t waited_ns);
+    // `ios` requests of this queue served by a sibling, and `ios` of a sibling's served here
+    void record_lent(uint64_t ios);
+    void record_stolen(uint64_t ios);
+};
+
+} // namespace ublkpp
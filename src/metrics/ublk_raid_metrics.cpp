@@ -13,6 +13,10 @@ UblkRaidMetrics::UblkRaidMetrics(std::string const& parent_id, std::string const
                      "ublk_raid_degraded_count_device_a", {"parent_id", parent_id});
     REGISTER_COUNTER(raid_degraded_count_device_b, "RAID device B degradation events",
                      "ublk_raid_degraded_count_device_b", {"parent_id", parent_id});
+    REGISTER_GAUGE(raid_slow_device_a, "1 if RAID device A is demoted by fail-slow detection",
+                   "ublk_raid_slow_device_a", {"parent_id", parent_id});
+    REGISTER_GAUGE(raid_slow_device_b, "1 if RAID device B is demoted by fail-slow detection",
+                   "ublk_raid_slow_device_b", {"parent_id", parent_id});
     REGISTER_COUNTER(device_swaps_total, "Total number of device swaps", "ublk_device_swaps_total",
                      {"parent_id", parent_id});
     // RAID1 resync metrics
@@ -45,6 +49,14 @@ void UblkRaidMetrics::record_device_degraded(std::string const& device_name) {
     }
 }
 
+void UblkRaidMetrics::record_device_slow(std::string const& device_name, bool is_slow) {
+    if (device_name == "device_a") {
+        GAUGE_UPDATE(*this, raid_slow_device_a, is_slow ? 1 : 0);
+    } else if (device_name == "device_b") {
+        GAUGE_UPDATE(*this, raid_slow_device_b, is_slow ? 1 : 0);
+    }
+}
+
 void UblkRaidMetrics::record_resync_start() { COUNTER_INCREMENT(*this, resync_started_total, 1); }
 
 void UblkRaidMetrics::record_resync_progress(uint64_t bytes) {
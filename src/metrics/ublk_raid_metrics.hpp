@@ -20,6 +20,7 @@ struct UblkRaidMetrics : public sisl::MetricsGroup {
 
     void record_device_degraded(std::string const& device_name);
     void record_device_swap();
+    void record_device_slow(std::string const& device_name, bool is_slow);
 
     // RAID1 resync metrics
     void record_resync_start();
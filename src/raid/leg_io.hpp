@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <coroutine>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+#include <ublkpp/lib/cqe_state.hpp>
+#include <ublkpp/lib/ublk_disk.hpp>
+
+#include "driver/fs_disk_impl.hpp"
+
+namespace ublkpp {
+
+// One child I/O a composite sends to a leg whose type is `Leg`. Over a plain ublk_disk it is the
+// leg's async_iov() task. When the composite's legs are known at compile time to be a leaf type
+// (see stack::make_stack()), the I/O is queued inline by that type's submit() and awaited on its
+// cqe_state: no virtual call and no coroutine frame per leg.
+//
+// start() runs until the SQE is queued; co_await wait() yields the leg's result. Every started
+// leg_io must be awaited before it is destroyed or reset, as its cqe_state may still be resumed.
+template < typename Leg >
+class leg_io {
+    std::optional< hot_task< int > > _task;
+
+public:
+    void start(ublk_disk& leg, ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
+               uint64_t addr) {
+        _task.emplace(leg.async_iov(q, data, iovecs, nr_vecs, addr).start());
+    }
+    bool started() const noexcept { return _task.has_value(); }
+    hot_task< int >& wait() noexcept { return *_task; }
+    void reset() noexcept { _task.reset(); }
+};
+
+// When the ring has no room, the leg waits for it from start() on (sq_space) and the I/O is queued
+// once run_queue_loop finds some; the composite keeps the iovecs until it is awaited anyway.
+template <>
+class leg_io< FSDisk > {
+    FSDisk* _leg{nullptr};
+    ublk_io_data const* _data{nullptr};
+    cqe_state* _state{nullptr};
+    int _res{0};
+    // Set while waiting for room in the ring
+    struct waiter : sq_waiter {
+        leg_io* io{nullptr};
+        ublksrv_queue const* q{nullptr};
+        iovec* iovecs{nullptr};
+        uint32_t nr_vecs{0};
+        uint64_t addr{0};
+        std::coroutine_handle<> h{}; // The composite, once it awaits this leg
+    };
+    std::optional< waiter > _waiting;
+
+    static void on_space(sq_waiter* w) {
+        auto& wait = static_cast< waiter& >(*w);
+        auto& self = *wait.io;
+        std::tie(self._res, self._state) = self._leg->submit(wait.q, self._data, wait.iovecs, wait.nr_vecs, wait.addr);
+        if (-EBUSY == self._res && sq_full(wait.q)) return sq_space::park(wait.q, w);
+        auto const h = wait.h;
+        self._waiting.reset();
+        if (!h) return;
+        if (self._state)
+            self._state->_waiter = h;
+        else
+            h.resume();
+    }
+
+public:
+    leg_io() = default;
+    leg_io(leg_io const&) = delete;
+    leg_io& operator=(leg_io const&) = delete;
+    leg_io& operator=(leg_io&&) = delete;
+
+    void start(ublk_disk& leg, ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
+               uint64_t addr) {
+        _leg = &static_cast< FSDisk& >(leg);
+        _data = data;
+        std::tie(_res, _state) = _leg->submit(q, data, iovecs, nr_vecs, addr);
+        if (-EBUSY == _res && rings_of(q) && sq_full(q)) {
+            _waiting.emplace();
+            _waiting->io = this;
+            _waiting->q = q;
+            _waiting->iovecs = iovecs;
+            _waiting->nr_vecs = nr_vecs;
+            _waiting->addr = addr;
+            _waiting->owner = reinterpret_cast< async_io const* >(data->private_data);
+            _waiting->on_space = &on_space;
+            sq_space::park(q, &*_waiting);
+        }
+    }
+    bool started() const noexcept { return nullptr != _leg; }
+    leg_io& wait() noexcept { return *this; }
+    void reset() noexcept {
+        _leg = nullptr;
+        _data = nullptr;
+        _state = nullptr;
+        _res = 0;
+        _waiting.reset();
+    }
+
+    bool await_ready() const noexcept { return !_waiting && (!_state || _state->_result_ready); }
+    void await_suspend(std::coroutine_handle<> h) noexcept {
+        if (_waiting)
+            _waiting->h = h;
+        else
+            _state->_waiter = h;
+    }
+    int await_resume() noexcept {
+        if (!_state) return _res;
+        _leg->finish(_data);
+        return _state->_result;
+    }
+};
+
+// Whether every one of `disks` is a `Leg`, as a composite issuing leg_io< Leg > requires
+template < typename Leg >
+bool all_legs_are(std::vector< disk_handle > const& disks) noexcept {
+    return std::ranges::all_of(disks, [](auto const& d) { return nullptr != dynamic_cast< Leg const* >(d.get()); });
+}
+
+} // namespace ublkpp
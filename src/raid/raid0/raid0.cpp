@@ -1,6 +1,11 @@
 #include "ublkpp/raid.hpp"
 
+#include <atomic>
 #include <bit>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <thread>
 #include <boost/uuid/uuid_io.hpp>
 #include <ublksrv.h>
 #include <ublksrv_utils.h>
@@ -8,19 +13,23 @@
 #include <ublkpp/lib/cqe_state.hpp>
 #include <ublkpp/lib/ublk_disk.hpp>
 
+#include "ublkpp/stack.hpp"
 #include "raid0_impl.hpp"
+#include "raid/leg_io.hpp"
 #include "lib/logging.hpp"
 
 namespace ublkpp {
-constexpr uint32_t _max_stripe_cnt{64};
-// max(max_io_size) / min(stripe_size) = 1 MiB / 64 KiB = 16
-constexpr uint32_t k_max_iovecs_per_stripe{16};
-
-struct StripeAccum {
-    uint64_t io_addr;
-    uint32_t nr_vecs;
-    std::array< iovec, k_max_iovecs_per_stripe > io_array; // filled before read; no zero-init needed
-};
+constexpr uint32_t _max_stripe_cnt{raid0::k_max_legs};
+// A discard over every leg fits one wide plan
+static_assert(raid0::wide_io_plan::k_capacity >= _max_stripe_cnt);
+// _cursor / _window_end value while no reshape is running: every address is in the current layout
+constexpr uint64_t k_no_reshape{UINT64_MAX};
+// I/Os count themselves in one of this many cache lines, picked per thread, so queues never contend
+constexpr uint32_t k_inflight_shards{16};
+// How long an I/O into the range being restriped parks before looking again
+constexpr long k_window_backoff_ns{20000};
+// Most array bytes a reshape moves (and I/O waits for) between superblock updates
+constexpr uint64_t k_reshape_window{4 * Mi};
 
 class StripeDevice {
     struct destroy_sb {
@@ -40,30 +49,115 @@ public:
 static raid0::SuperBlock* read_superblock(ublk_disk& device);
 static io_result write_superblock(ublk_disk& device, raid0::SuperBlock* sb);
 static std::expected< raid0::SuperBlock*, std::error_condition >
-load_superblock(ublk_disk& device, boost::uuids::uuid const& uuid, uint32_t& stripe_size, uint16_t const stripe_off);
+load_superblock(ublk_disk& device, boost::uuids::uuid const& uuid, uint32_t& stripe_size, uint16_t const stripe_off,
+                uint16_t const width, std::span< uint8_t const > weights);
+
+// An I/O's registration in Raid0Disk's inflight counters; see Raid0Disk::__quiesce().
+struct inflight_guard {
+    std::atomic< int64_t >* cnt{nullptr};
+
+    inflight_guard() = default;
+    inflight_guard(inflight_guard const&) = delete;
+    inflight_guard& operator=(inflight_guard const&) = delete;
+    ~inflight_guard() { release(); }
+    void release() noexcept {
+        if (cnt) std::exchange(cnt, nullptr)->fetch_sub(1, std::memory_order_release);
+    }
+};
 
 // File-local concrete ublk_disk; constructed only via the make_raid0_disk factory below. The
 // public header exposes only the factory + raid0:: free functions; consumers operate against
 // the ublk_disk virtual interface.
+//
+// Legs can be added while the array is live (see expand()). A background thread then restripes
+// the data onto the wider layout in address order: bytes below _cursor are in the new layout,
+// bytes from _window_end up are still in the old one, and I/O into [_cursor, _window_end), the
+// few stripes being moved, waits for them.
 class Raid0Disk : public ublk_disk {
+    // Reserved to _max_stripe_cnt up front, so appending a leg never moves the ones I/O is using
     std::vector< std::unique_ptr< StripeDevice > > _stripe_array;
 
+    boost::uuids::uuid const _uuid;
     uint32_t _stripe_size{0};
-    uint64_t _stride_width{0}; // L1: widened to uint64_t; large configs (e.g. 128MiB × 64) overflow uint32_t
+    uint32_t _stripe_shift{0};
+    bool _compact_io{true}; // The largest read or write fits an io_plan; set at assembly
+    raid0::weighted_map _map; // Empty unless legs take unequal shares of each cycle
+    std::atomic< uint32_t > _width{0};                 // Legs in the current layout
+    std::atomic< uint32_t > _old_width{0};             // Legs in the layout being reshaped away from
+    std::atomic< uint64_t > _cursor{k_no_reshape};     // Array bytes below this are in the current layout
+    std::atomic< uint64_t > _window_end{k_no_reshape}; // [_cursor, _window_end) is being restriped
+
+    // I/Os in flight, counted per epoch; the reshape thread flips the epoch and waits out the old one
+    struct alignas(64) inflight_shard {
+        std::array< std::atomic< int64_t >, 2 > n{};
+    };
+    std::array< inflight_shard, k_inflight_shards > _inflight;
+    std::atomic< uint32_t > _epoch{0};
+
+    std::mutex _queues_lock;                     // Guards _queues and _prepared_width
+    std::vector< ublksrv_queue const* > _queues; // Every queue prepare() has seen
+    std::atomic< uint32_t > _prepared_width{0};  // Legs the queues sized their cqe_state pools for
+    std::atomic< size_t > _leg_sqes{1};          // Largest max_sqes_per_io of any leg
+    std::atomic< bool > _scatter_gather{true};   // Every leg takes scattered reads and writes
+
+    std::mutex _sb_lock; // Guards _age, expansion and superblock writes
+    uint64_t _age{0};
+    std::thread _reshape_thread;
+    std::atomic< bool > _stopping{false};
+
+    // The layouts an I/O was admitted under: bytes below `cursor` use `width` legs, the rest `old_width`
+    struct layout_view {
+        uint32_t width;
+        uint32_t old_width;
+        uint64_t cursor;
+
+        // Bytes at the front of [addr, addr + len) that are in the current layout
+        uint64_t lead(uint64_t const addr, uint64_t const len) const noexcept {
+            return (cursor > addr) ? std::min(len, cursor - addr) : 0;
+        }
+    };
+
+    // L1: uint64_t; large configs (e.g. 128MiB × 64) overflow uint32_t
+    uint64_t __stride(uint32_t const width) const noexcept { return static_cast< uint64_t >(_stripe_size) * width; }
 
-    io_result __distribute(std::array< StripeAccum, _max_stripe_cnt >& sub_cmds, iovec* iov, uint64_t addr,
-                           auto&& func) const;
+    raid0::geometry __geometry(uint32_t const width) const noexcept {
+        return {.stripe_shift = _stripe_shift, .width = width, .map = (0 < _map.cycle) ? &_map : nullptr};
+    }
+    template < typename Plan >
+    uint64_t __plan(Plan& plan, raid0::iov_cursor* src, layout_view const& view, uint64_t addr,
+                    uint64_t len) const noexcept;
+    template < typename Plan, typename Leg >
+    disk_task< int > __async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
+                                 uint64_t addr);
+
+    std::optional< layout_view > __enter(inflight_guard& guard, uint64_t addr, uint64_t len) noexcept;
+    disk_task< int > __backoff(ublksrv_queue const* q);
+    void __quiesce() noexcept;
+    bool __persist_sb(uint32_t width, uint32_t old_width, uint64_t pos);
+    void __reshape();
+
+protected:
+    // The I/O path with legs of type `Leg` (see leg_io); async_iov() takes it with Leg = ublk_disk
+    template < typename Leg >
+    disk_task< int > __dispatch(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
+                                uint64_t addr);
+    // Whether expand() may add `leg`; subclasses fixing the leg type refuse others
+    virtual bool __accepts(ublk_disk const&) const noexcept { return true; }
 
 public:
     Raid0Disk(boost::uuids::uuid const& uuid, uint32_t const stripe_size_bytes,
-              std::vector< std::shared_ptr< ublk_disk > >&& disks);
+              std::vector< std::shared_ptr< ublk_disk > >&& disks, std::vector< uint32_t > const& weights);
     ~Raid0Disk() override;
 
     std::shared_ptr< ublk_disk > get_device(uint32_t stripe_offset) const noexcept;
     uint32_t stripe_size() const noexcept { return _stripe_size; }
 
+    bool expand(std::vector< std::shared_ptr< ublk_disk > >&& legs);
+    uint64_t reshape_remaining() const noexcept;
+
     std::string id() const noexcept override { return "RAID0"; }
     prepare_result prepare(ublksrv_queue const*, int const iouring_device) override;
+    bool scatter_gather() const noexcept override { return _scatter_gather.load(std::memory_order_relaxed); }
 
     disk_task< int > async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
                                uint64_t addr) override;
@@ -74,8 +168,8 @@ public:
 };
 
 Raid0Disk::Raid0Disk(boost::uuids::uuid const& uuid, uint32_t const stripe_size_bytes,
-                     std::vector< std::shared_ptr< ublk_disk > >&& disks) :
-        ublk_disk(), _stripe_size(stripe_size_bytes), _stride_width(_stripe_size * disks.size()) {
+                     std::vector< std::shared_ptr< ublk_disk > >&& disks, std::vector< uint32_t > const& weights) :
+        ublk_disk(), _uuid(uuid), _stripe_size(stripe_size_bytes) {
     if (disks.empty()) throw std::invalid_argument("Raid0Disk: at least one disk required");
     if (stripe_size_bytes == 0) throw std::invalid_argument("Raid0Disk: stripe_size_bytes must be non-zero");
     // L2: ilog2 rounds down for non-power-of-2 inputs, producing wrong geometry silently.
@@ -86,6 +180,22 @@ Raid0Disk::Raid0Disk(boost::uuids::uuid const& uuid, uint32_t const stripe_size_
     if (disks.size() > _max_stripe_cnt)
         throw std::invalid_argument(
             fmt::format("Raid0Disk: too many disks ({}), max is {}", disks.size(), _max_stripe_cnt));
+    if (!weights.empty() &&
+        (weights.size() != disks.size() || raid0::k_max_weighted_legs < weights.size() ||
+         std::ranges::any_of(weights, [](uint32_t w) { return 0 == w || UINT8_MAX < w; }) ||
+         raid0::k_max_cycle < std::accumulate(weights.begin(), weights.end(), 0UL)))
+        throw std::invalid_argument(
+            fmt::format("Raid0Disk: need one weight of 1-255 per disk (at most {} disks), summing to at most {}",
+                        raid0::k_max_weighted_legs, raid0::k_max_cycle));
+    _stripe_array.reserve(_max_stripe_cnt);
+    auto const nr_disks = static_cast< uint16_t >(disks.size());
+    // Only arrays this narrow can be weighted; the superblock has room for no more weights
+    auto const nr_weighted_legs = std::min< uint32_t >(nr_disks, raid0::k_max_weighted_legs);
+    auto new_weights = std::array< uint8_t, raid0::k_max_weighted_legs >{};
+    std::ranges::copy(weights, new_weights.begin());
+    // Equal weights are the plain layout, and are recorded as such
+    if (0 == raid0::make_weighted_map(std::span(new_weights.data(), nr_weighted_legs)).cycle) new_weights.fill(0);
+
     // Discover overall Device parameters
     auto& our_params = *params();
     our_params.types |= UBLK_PARAM_TYPE_DISCARD;
@@ -93,23 +203,23 @@ Raid0Disk::Raid0Disk(boost::uuids::uuid const& uuid, uint32_t const stripe_size_
     _direct_io = true;
 
     auto alt_stripe = false;
+    auto child_max_sectors = UINT32_MAX;
     our_params.basic.physical_bs_shift = ilog2(stripe_size_bytes);
-    our_params.basic.io_opt_shift = ilog2(_stride_width);
     for (auto&& device : disks) {
         // We'll use dev_sectors to track the smallest array device we have
         our_params.basic.dev_sectors =
             std::min< uint64_t >(our_params.basic.dev_sectors, device->capacity() >> SECTOR_SHIFT);
         our_params.basic.logical_bs_shift =
             std::max(our_params.basic.logical_bs_shift, static_cast< uint8_t >(ilog2(device->block_size())));
-        our_params.basic.max_sectors = std::min(
-            our_params.basic.max_sectors, static_cast< uint32_t >((device->max_tx() >> SECTOR_SHIFT) * disks.size()));
+        child_max_sectors = std::min(child_max_sectors, static_cast< uint32_t >(device->max_tx() >> SECTOR_SHIFT));
 
         if (!device->can_discard()) our_params.types &= ~UBLK_PARAM_TYPE_DISCARD;
 
         _direct_io = _direct_io ? device->direct_io() : false;
+        if (!device->scatter_gather()) _scatter_gather.store(false, std::memory_order_relaxed);
 
         auto this_alt_stripe = _stripe_size;
-        auto sb = load_superblock(*device, uuid, this_alt_stripe, _stripe_array.size());
+        auto sb = load_superblock(*device, uuid, this_alt_stripe, _stripe_array.size(), nr_disks, new_weights);
         if (_stripe_size != this_alt_stripe) {
             if (!alt_stripe) {
                 alt_stripe = true;
@@ -121,14 +231,56 @@ Raid0Disk::Raid0Disk(boost::uuids::uuid const& uuid, uint32_t const stripe_size_
         _stripe_array.emplace_back(std::make_unique< StripeDevice >(std::move(device), sb.value()));
     }
 
-    // Recompute _stride_width in case load_superblock corrected _stripe_size from the on-disk
-    // superblock value (the initializer-list computed it from the caller-supplied stripe_size_bytes
-    // before any superblock was read, so it may be stale).
+    // The copy with the highest age describes the array, including any reshape that was running
+    auto const* found = _stripe_array.front()->_sb.get();
+    for (auto const& stripe : _stripe_array)
+        if (be64toh(stripe->_sb->fields.age) > be64toh(found->fields.age)) found = stripe->_sb.get();
+    _age = be64toh(found->fields.age);
+    uint16_t const width = (0 == found->fields.width) ? nr_disks : be16toh(found->fields.width);
+    uint16_t const old_width = (0 == found->fields.old_width) ? width : be16toh(found->fields.old_width);
+    if (nr_disks != width || old_width > width)
+        throw std::runtime_error(fmt::format("Could not read superblock! Array has {} legs (was {}), {} given", width,
+                                             old_width, nr_disks));
+    _width.store(width, std::memory_order_release);
+    _old_width.store(old_width, std::memory_order_release);
+
+    // The weights the array was created with win over the ones given
+    auto const on_disk = std::span(found->fields.weights, std::min< uint32_t >(width, raid0::k_max_weighted_legs));
+    auto const nr_weighted = std::ranges::count_if(on_disk, [](uint8_t w) { return 0 < w; });
+    if (0 < nr_weighted && (width != nr_weighted || old_width != width))
+        throw std::runtime_error("Raid0Disk: on-disk stripe weights are incomplete (possible data corruption)");
+    if (!weights.empty() && !std::ranges::equal(on_disk, std::span(new_weights.data(), on_disk.size())))
+        RLOGW("Ignoring the stripe weights given for RAID0; the array keeps those it was created with")
+    _map = raid0::make_weighted_map(on_disk);
+    auto const max_weight = std::ranges::max(on_disk);
+    // How many legs a long I/O spreads over at the least, for the limits below
+    auto const spread = (0 < _map.cycle) ? std::max(1U, _map.cycle / max_weight) : old_width;
+
+    // load_superblock may have corrected _stripe_size from the on-disk superblock value, so the
+    // geometry below is only derived from here on.
     if (_stripe_size == 0)
         throw std::runtime_error("Raid0Disk: on-disk superblock delivered zero stripe_size (possible data corruption)");
-    _stride_width = static_cast< uint64_t >(_stripe_size) * _stripe_array.size(); // L1: keep uint64_t arithmetic
-    // Recompute io_opt_shift to match the corrected stride width.
-    our_params.basic.io_opt_shift = ilog2(_stride_width);
+    if (!std::has_single_bit(_stripe_size))
+        throw std::runtime_error(fmt::format(
+            "Raid0Disk: on-disk stripe_size ({}) is not a power of 2 (possible data corruption)", _stripe_size));
+    _stripe_shift = static_cast< uint32_t >(std::countr_zero(_stripe_size));
+    if (old_width != width) {
+        auto const pos = be64toh(found->fields.reshape_pos);
+        if (0 != pos % _stripe_size)
+            throw std::runtime_error("Raid0Disk: on-disk reshape position is not stripe aligned (possible data corruption)");
+        _cursor.store(pos, std::memory_order_release);
+        _window_end.store(pos, std::memory_order_release);
+    }
+    // Until a reshape completes the data only spans the legs it started from, and the kernel
+    // cannot take a new size on a live device anyway: size the array by the old layout. The added
+    // capacity shows up on the first assembly after the reshape.
+    our_params.basic.max_sectors = std::min(our_params.basic.max_sectors,
+                                            static_cast< uint32_t >(static_cast< uint64_t >(child_max_sectors) * spread));
+    our_params.basic.io_opt_shift = ilog2((0 < _map.cycle) ? __stride(_map.cycle) : __stride(old_width));
+    // Every stripe of an I/O, plus one for an unaligned start, must fit one wide plan. This only
+    // bites on stripes so small that a full-size I/O spans more than k_max_wide_frags - 1 of them.
+    our_params.basic.max_sectors =
+        std::min(our_params.basic.max_sectors, (raid0::k_max_wide_frags - 1) * (_stripe_size >> SECTOR_SHIFT));
 
     // Finally we'll calculate the volume size as a multiple of the smallest array device
     // and adjust to account for the superblock we will write at the HEAD of each array device.
@@ -150,15 +302,23 @@ Raid0Disk::Raid0Disk(boost::uuids::uuid const& uuid, uint32_t const stripe_size_
             fmt::format("Raid0Disk: device capacity ({} sectors) is too small for stripe_size ({} sectors)",
                         our_params.basic.dev_sectors, stripe_size_sectors));
     our_params.basic.dev_sectors -= stripe_size_sectors;
-    our_params.basic.dev_sectors *= _stripe_array.size();
+    if (0 < _map.cycle) {
+        // Every cycle takes weight[i] stripes from leg i; the leg that runs out first bounds the array
+        auto cycles = UINT64_MAX;
+        for (auto i = 0U; width > i; ++i)
+            cycles = std::min(cycles,
+                              ((_stripe_array[i]->disk->capacity() >> SECTOR_SHIFT) / stripe_size_sectors - 1) /
+                                  _map.weight[i]);
+        our_params.basic.dev_sectors = cycles * _map.cycle * stripe_size_sectors;
+        if (0 == cycles)
+            throw std::runtime_error(
+                fmt::format("Raid0Disk: devices are too small for a cycle of {} stripes", _map.cycle));
+    } else
+        our_params.basic.dev_sectors *= old_width;
     // M2: guard against division by zero if max_sectors is 0 (e.g. child device reported max_tx()==0).
     if (our_params.basic.max_sectors == 0)
         throw std::runtime_error("Raid0Disk: max_sectors is zero; child device reported max_tx() == 0");
-    if ((max_tx() + _stripe_size - 1) / _stripe_size > k_max_iovecs_per_stripe)
-        throw std::invalid_argument(
-            fmt::format("Raid0Disk: ceil(max_io_size/stripe_size)={} exceeds k_max_iovecs_per_stripe={}; "
-                        "reduce max_io_size or increase stripe_size",
-                        (max_tx() + _stripe_size - 1) / _stripe_size, k_max_iovecs_per_stripe));
+    _compact_io = raid0::io_plan::k_capacity > (max_tx() + _stripe_size - 1) / _stripe_size;
     // Align size to max_sector size
     our_params.basic.dev_sectors -= (our_params.basic.dev_sectors % our_params.basic.max_sectors);
 
@@ -169,170 +329,272 @@ Raid0Disk::Raid0Disk(boost::uuids::uuid const& uuid, uint32_t const stripe_size_
         uint32_t child_min = UINT32_MAX;
         for (auto const& s : _stripe_array)
             child_min = std::min(child_min, s->disk->max_discard_sectors());
-        our_params.discard.max_discard_sectors = static_cast< uint32_t >(
-            std::min< uint64_t >(static_cast< uint64_t >(child_min) * _stripe_array.size(), UINT32_MAX));
+        our_params.discard.max_discard_sectors =
+            static_cast< uint32_t >(std::min< uint64_t >(static_cast< uint64_t >(child_min) * spread, UINT32_MAX));
+    }
+
+    if (old_width != width) {
+        RLOGI("Resuming reshape of RAID0 from {} to {} legs at {:#0x}", old_width, width, _cursor.load())
+        _reshape_thread = std::thread([this] { __reshape(); });
     }
 }
 
-Raid0Disk::~Raid0Disk() = default;
+Raid0Disk::~Raid0Disk() {
+    _stopping.store(true, std::memory_order_release);
+    if (_reshape_thread.joinable()) _reshape_thread.join();
+}
 
 std::shared_ptr< ublk_disk > Raid0Disk::get_device(uint32_t stripe_offset) const noexcept {
-    if (auto const width = _stripe_array.size(); width <= stripe_offset) {
+    if (auto const width = _width.load(std::memory_order_acquire); width <= stripe_offset) {
         RLOGW("Stripe offset [{}] larger than array width [{}]", stripe_offset, width)
         return nullptr;
     }
     return _stripe_array[stripe_offset]->disk;
 }
 
-// Upper bound on distinct stripes touched by a single I/O.
-// +1 for start-alignment: an unaligned start can spill into one extra stripe.
-// Denominator is stripe_size (not stride_width): an io_size < stride_width can still touch
-// multiple per-disk stripes if it crosses a stripe boundary. Capped by device count because
-// __distribute gathers all iovecs per device into one task.
-static inline size_t stripes_for_io(size_t io_size, size_t stripe_size, size_t nr_stripes) {
-    return std::min((io_size + stripe_size - 1) / stripe_size + 1, nr_stripes);
-}
-
 Raid0Disk::prepare_result Raid0Disk::prepare(ublksrv_queue const* q, int const iouring_device_start) {
     prepare_result result;
     result.max_sqes_per_io = 0;
-    // Sum all N children: DISCARD/WRITE_ZEROES always fans out to every disk via merged_subcmds,
+    // Sum all N children: DISCARD/WRITE_ZEROES always fans out to every disk via plan_discard,
     // consuming one pool slot per disk regardless of I/O size. The READ/WRITE path caps fan-out
-    // at k = stripes_for_io(max_tx) ≤ N, so the pool is over-allocated by at most (N-k) slots
-    // in the read/write case — harmless; under-allocation on DISCARD is a P1 crash.
-    for (auto& stripe : _stripe_array) {
-        auto child = stripe->disk->prepare(q, iouring_device_start + static_cast< int >(result.fds.size()));
+    // at k = min(ceil(max_tx / stripe_size) + 1, N), so the pool is over-allocated by at most (N-k)
+    // slots in the read/write case — harmless; under-allocation on DISCARD is a P1 crash.
+    auto const width = _width.load(std::memory_order_acquire);
+    for (auto i = 0U; width > i; ++i) {
+        auto child = _stripe_array[i]->disk->prepare(q, iouring_device_start + static_cast< int >(result.fds.size()));
         result.fds.insert(result.fds.end(), child.fds.begin(), child.fds.end());
         result.max_sqes_per_io += child.max_sqes_per_io;
+        result.polled = result.polled || child.polled;
+        if (child.max_sqes_per_io > _leg_sqes.load(std::memory_order_relaxed))
+            _leg_sqes.store(child.max_sqes_per_io, std::memory_order_relaxed);
+    }
+    // Remember the queues, so legs added later can be prepared for them too
+    if (q) {
+        auto lk = std::scoped_lock(_queues_lock);
+        _queues.push_back(q);
+        auto const prepared = _prepared_width.load(std::memory_order_relaxed);
+        _prepared_width.store((0 == prepared) ? width : std::min(prepared, width), std::memory_order_release);
     }
     return result;
 }
 
 void Raid0Disk::probe_tick(ublksrv_queue const* q) noexcept {
-    for (auto const& stripe : _stripe_array) {
-        stripe->disk->probe_tick(q);
+    auto const width = _width.load(std::memory_order_acquire);
+    for (auto i = 0U; width > i; ++i) {
+        _stripe_array[i]->disk->probe_tick(q);
     }
 }
 
 /// This is the primary I/O handler call for RAID0
 //
 //  RAID0 is primarily responsible for splitting an I/O request across several stripes. These operations can cross
-//  stripe boundaries and even wrap around several strides. This routine handles this calculation and calls
-//  the given routine `func` for each stripe that it has collected scatter (struct iovec) operations for.
-io_result Raid0Disk::__distribute(std::array< StripeAccum, _max_stripe_cnt >& sub_cmds, iovec* iovecs, uint64_t addr,
-                                  auto&& func) const {
-    DEBUG_ASSERT_GT(_stride_width, 0ULL) // LCOV_EXCL_LINE
-
-    if (1 == _stripe_array.size()) return func(0, iovecs, 1, addr);
-
-    DEBUG_ASSERT_LE(iovecs->iov_len, UINT32_MAX) // LCOV_EXCL_LINE
-    auto const len = static_cast< uint32_t >(iovecs->iov_len);
-    uint32_t cnt{0};
-    uint64_t dirty_mask{0};
-    for (auto off = 0U; len > off;) {
-        auto const [stripe_off, logical_off, sz] =
-            raid0::next_subcmd(_stride_width, _stripe_size, addr + off, len - off);
-        auto buf_cursor = static_cast< uint8_t* >(iovecs->iov_base) + off;
-        off += sz;
-
-        auto& acc = sub_cmds[stripe_off];
-        if (!(dirty_mask & (1ULL << stripe_off))) {
-            dirty_mask |= 1ULL << stripe_off;
-            acc.nr_vecs = 0;
-            acc.io_addr = logical_off;
-        }
-        DEBUG_ASSERT_LT(acc.nr_vecs, k_max_iovecs_per_stripe) // LCOV_EXCL_LINE
-        acc.io_array[acc.nr_vecs++] = {buf_cursor, sz};
+//  stripe boundaries and even wrap around several strides. This routine cuts as much of [addr, addr + len) as fits
+//  into `plan`, one run of scatter (struct iovec) operations per leg, and returns the bytes planned. The front of
+//  the range may use the current layout and the rest the one a running reshape is moving away from; `src` is the
+//  data, or null for an I/O without a buffer (discard), whose runs are merged across strides.
+template < typename Plan >
+uint64_t Raid0Disk::__plan(Plan& plan, raid0::iov_cursor* src, layout_view const& view, uint64_t const addr,
+                           uint64_t const len) const noexcept {
+    auto planned = 0UL;
+    while (len > planned) {
+        auto const lead = view.lead(addr + planned, len - planned);
+        auto const part = (0 < lead) ? lead : len - planned;
+        auto const geo = __geometry((0 < lead) ? view.width : view.old_width);
+        auto const n = src ? raid0::plan_io(plan, geo, *src, addr + planned, part)
+                           : raid0::plan_discard(plan, geo, addr + planned, part);
+        planned += n;
+        if (part > n) break;
+    }
+    return planned;
+}
 
-        // Dispatch once the remaining bytes fit within a single (N-1)-stripe remainder,
-        // guaranteeing this stripe cannot accumulate more iovecs in the same call.
-        if ((_stride_width - _stripe_size) >= (len - off)) {
-            auto res = func(stripe_off, acc.io_array.data(), acc.nr_vecs, acc.io_addr);
-            if (!res) return res;
-            cnt += res.value();
+// Register an I/O on [addr, addr + len) and return the layouts it must use; or return nothing,
+// unregistered, while part of the range is being restriped.
+//
+// Every I/O counts itself in the current epoch before it looks at the layout. To move the window
+// the reshape thread publishes it, flips the epoch and waits for the previous epoch to drain
+// (__quiesce()), so no I/O still using the old layout for those stripes remains. Re-reading the
+// epoch after counting closes the race with a flip in between.
+std::optional< Raid0Disk::layout_view > Raid0Disk::__enter(inflight_guard& guard, uint64_t const addr,
+                                                           uint64_t const len) noexcept {
+    static thread_local auto const shard =
+        static_cast< uint32_t >(std::hash< std::thread::id >{}(std::this_thread::get_id()) % k_inflight_shards);
+    auto& counters = _inflight[shard].n;
+    while (true) {
+        auto const epoch = _epoch.load() & 1;
+        counters[epoch].fetch_add(1);
+        if (epoch == (_epoch.load() & 1)) {
+            guard.cnt = &counters[epoch];
+            break;
         }
+        counters[epoch].fetch_sub(1);
     }
-    return cnt;
+    // Width first: expand() publishes it last and finishing a reshape never shrinks the view
+    auto const view = layout_view{.width = _width.load(), .old_width = _old_width.load(), .cursor = _cursor.load()};
+    if (auto const window_end = _window_end.load();
+        view.cursor < window_end && addr < window_end && view.cursor < addr + len) {
+        guard.release();
+        return std::nullopt;
+    }
+    return view;
+}
+
+// Wait until every I/O that may have looked at the layout before the caller's last change is done.
+void Raid0Disk::__quiesce() noexcept {
+    auto const old = _epoch.fetch_add(1) & 1;
+    for (auto& shard : _inflight)
+        while (0 != shard.n[old].load())
+            std::this_thread::yield();
+}
+
+// Park this I/O on a short ring timeout while the reshape thread moves the stripes it needs. The
+// queue thread must keep running meanwhile, so spinning here is not an option.
+disk_task< int > Raid0Disk::__backoff(ublksrv_queue const* q) {
+    auto* sqe = next_sqe(q);
+    while (!sqe && co_await sq_space(q))
+        sqe = next_sqe(q);
+    if (!sqe) [[unlikely]]
+        co_return -EBUSY;
+    // Stand-alone cqe_state: lives in this frame, not the I/O's pool
+    auto state = cqe_state{};
+    __kernel_timespec ts{.tv_sec = 0, .tv_nsec = k_window_backoff_ns};
+    io_uring_prep_timeout(sqe, &ts, 0, 0);
+    sqe->user_data = sisl::async::encode_managed_user_data(&state);
+    co_await state;
+    co_return 0;
 }
 
 io_result Raid0Disk::sync_iov(uint8_t op, iovec* iovecs, uint32_t nr_vecs, off_t addr) noexcept {
-    // RAID-0 only supports not-scattered I/O currently!
     if (1 > nr_vecs) return std::unexpected(std::make_error_condition(std::errc::invalid_argument));
 
-    // Adjust the address for our superblock area, do not use _addr_ beyond this.
-    addr += _stride_width;
-
-    std::array< StripeAccum, _max_stripe_cnt > sub_cmds;
-    return __distribute(sub_cmds, iovecs, addr,
-                        [op, this](uint32_t stripe_off, iovec* iov, uint32_t nr_iovs, uint64_t logical_off) {
-                            RLOGT("Perform {}: ublk sync_io -> "
-                                  "[stripe_off:{}|logical_sector:{}|logical_len:{:#0x}]",
-                                  op == UBLK_IO_OP_READ ? "READ" : "WRITE", stripe_off, logical_off >> SECTOR_SHIFT,
-                                  iovec_len(iov, iov + nr_iovs))
-                            return _stripe_array[stripe_off]->disk->sync_iov(op, iov, nr_iovs, logical_off);
-                        });
+    auto const len = iovec_len(iovecs, iovecs + nr_vecs);
+    auto guard = inflight_guard();
+    auto view = __enter(guard, addr, len);
+    // Plain threads never hold the window themselves, so yielding until it moves on is safe
+    while (!view) {
+        std::this_thread::yield();
+        view = __enter(guard, addr, len);
+    }
+
+    // Off the I/O path, so the plan that takes any I/O in one round is used throughout
+    raid0::wide_io_plan plan; // Not value-initialized: only the entries counted in it are read
+    auto src = raid0::iov_cursor{.iov = iovecs, .nr_vecs = nr_vecs};
+    auto total = 0;
+    for (auto pos = 0UL; len > pos;) {
+        plan.clear();
+        auto const planned = __plan(plan, &src, *view, addr + pos, len - pos);
+        if (0 == planned) [[unlikely]] // LCOV_EXCL_LINE
+            return std::unexpected(std::make_error_condition(std::errc::invalid_argument));
+        pos += planned;
+        for (auto const& run : std::span(plan.runs.data(), plan.nr_runs)) {
+            auto* iov = &plan.vecs[run.first];
+            RLOGT("Perform {}: ublk sync_io -> "
+                  "[stripe_off:{}|logical_sector:{}|logical_len:{:#0x}]",
+                  op == UBLK_IO_OP_READ ? "READ" : "WRITE", run.leg, run.addr >> SECTOR_SHIFT,
+                  iovec_len(iov, iov + run.nr_vecs))
+            auto res = _stripe_array[run.leg]->disk->sync_iov(op, iov, run.nr_vecs, run.addr);
+            if (!res) return res;
+            total += res.value();
+        }
+    }
+    return total;
 }
 
 disk_task< int > Raid0Disk::async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
                                       uint64_t addr) {
+    return __dispatch< ublk_disk >(q, data, iovecs, nr_vecs, addr);
+}
+
+template < typename Leg >
+disk_task< int > Raid0Disk::__dispatch(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs,
+                                       uint32_t nr_vecs, uint64_t addr) {
+    // Every I/O's frame holds its plan. Small arrays keep to the compact one; arrays wider than it,
+    // or with stripes too small for their largest I/O to fit it, take the wide one so that any
+    // I/O the kernel sends is still issued in a single round.
+    if (_compact_io && raid0::io_plan::k_capacity >= _width.load(std::memory_order_relaxed)) [[likely]]
+        return __async_iov< raid0::io_plan, Leg >(q, data, iovecs, nr_vecs, addr);
+    return __async_iov< raid0::wide_io_plan, Leg >(q, data, iovecs, nr_vecs, addr);
+}
+
+template < typename Plan, typename Leg >
+disk_task< int > Raid0Disk::__async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs,
+                                        uint32_t nr_vecs, uint64_t addr) {
     auto const op = ublksrv_get_op(data->iod);
 
     if (op == UBLK_IO_OP_FLUSH) co_return 0;
 
-    addr += _stride_width;
-
-    // Eagerly start each child task so all SQEs are in-flight before the first co_await,
-    // preserving kernel parallelism. All tasks must be drained even on error to avoid
-    // dangling _waiter handles in cqe_state.
-    std::vector< hot_task< int > > stripe_tasks;
-    try {
-        stripe_tasks.reserve(stripes_for_io(iovec_len(iovecs, iovecs + nr_vecs), _stripe_size, _stripe_array.size()));
-    } catch (std::bad_alloc const&) { co_return -EAGAIN; } // LCOV_EXCL_LINE
-
-    // sub_cmds is declared at function scope (not inside the else block) so its lifetime extends
-    // past the if/else and covers the co_await loop below; iovec pointers into io_array remain
-    // valid for the lifetime of all child tasks. Slots are initialized lazily in __distribute
-    // via dirty_mask on first touch, so no upfront zeroing is needed here.
-    std::array< StripeAccum, _max_stripe_cnt > sub_cmds;
-
-    if (op == UBLK_IO_OP_DISCARD || op == UBLK_IO_OP_WRITE_ZEROES) {
-        uint32_t const len = (nr_vecs > 0) ? static_cast< uint32_t >(iovecs[0].iov_len) : 0;
-
-        // No data buffer: contiguous stripe ranges can be coalesced rather than scattered per-stripe.
-        for (auto const& [stripe_off, region] : raid0::merged_subcmds(_stride_width, _stripe_size, addr, len)) {
-            auto const& [logical_off, logical_len] = region;
-            // stripe_iov is a loop-local variable; start() advances async_iov past the iov_len
-            // read before suspending, so the stack variable is safe.
-            auto stripe_iov = iovec{.iov_base = nullptr, .iov_len = logical_len};
-            stripe_tasks.push_back(
-                _stripe_array[stripe_off]->disk->async_iov(q, data, &stripe_iov, 1, logical_off).start());
-        }
-    } else {
-        // READ / WRITE: fan out across stripes via __distribute.
-        auto res = __distribute(
-            sub_cmds, iovecs, addr,
-            [q, data, &stripe_tasks, this](uint32_t stripe_off, iovec* iov, uint32_t nr_iovs,
-                                           uint64_t logical_off) -> io_result {
-                stripe_tasks.push_back(
-                    _stripe_array[stripe_off]->disk->async_iov(q, data, iov, nr_iovs, logical_off).start());
-                return 1;
-            });
-
-        // INVARIANT: the lambda always returns io_result{1} so !res is unreachable today.
-        // If the lambda ever becomes fallible, stripe_tasks must be drained here before returning
-        // to avoid dangling cqe_state::_waiter handles in the CQE ring.
-        if (!res) co_return -EIO;
+    auto const len = iovec_len(iovecs, iovecs + nr_vecs);
+    auto guard = inflight_guard();
+    auto view = __enter(guard, addr, len);
+    while (!view) {
+        if (auto const r = co_await __backoff(q).start(); 0 > r) co_return r;
+        view = __enter(guard, addr, len);
     }
+    // No data buffer for these: contiguous stripe ranges are coalesced per leg rather than scattered per-stripe
+    auto const discard = (op == UBLK_IO_OP_DISCARD || op == UBLK_IO_OP_WRITE_ZEROES);
+    auto const lead = view->lead(addr, len);
+    auto const split = (0 < lead) && (len > lead);
+
+    // The plan lives in this frame, so the iovecs handed to the legs stay valid until they are
+    // drained below. A single round covers any I/O the kernel sends; scattered input with more
+    // seams than a plan holds, or a discard split across a reshape of a wide array, takes more.
+    Plan plan; // Not value-initialized: only the entries counted in it are read
+    auto src = raid0::iov_cursor{.iov = iovecs, .nr_vecs = nr_vecs};
+    std::array< leg_io< Leg >, Plan::k_capacity > tasks;
+
+    // The queues sized each I/O's cqe_state pool for the legs and layout they were prepared with.
+    // Legs added since, an I/O split across a reshape, or a later round may need more: such I/Os
+    // hand their legs a pool of their own (same tag and home queue) when the one they were given
+    // could run short.
+    auto spill = std::optional< async_io >();
+    auto spill_data = ublk_io_data{};
+    auto const* child_data = data;
 
     int total = 0;
     int err = 0;
-    for (auto& t : stripe_tasks) {
-        auto r = co_await t;
-        if (r < 0 && !err)
-            err = r;
-        else
-            total += r;
+    for (auto pos = 0UL, round = 0UL; len > pos && !err; ++round) {
+        plan.clear();
+        auto const planned = __plan(plan, discard ? nullptr : &src, *view, addr + pos, len - pos);
+        if (0 == planned) [[unlikely]] // LCOV_EXCL_LINE
+            co_return -EINVAL;
+        pos += planned;
+
+        if (view->width != _prepared_width.load(std::memory_order_acquire) || split || 0 < round) {
+            auto const* io = reinterpret_cast< async_io const* >(child_data->private_data);
+            auto const need = plan.nr_runs * _leg_sqes.load(std::memory_order_relaxed);
+            if (need > io->_pool.capacity() - io->_pool.size()) {
+                // Every task of an earlier round is drained, so a previous spill pool can go
+                try {
+                    spill.emplace();
+                    spill->_pool.reserve(need);
+                } catch (std::bad_alloc const&) { co_return -EAGAIN; } // LCOV_EXCL_LINE
+                spill->_tag = reinterpret_cast< async_io const* >(data->private_data)->_tag;
+                spill->_ioprio = io_priority(data);
+                spill->_merge_next = reinterpret_cast< async_io const* >(data->private_data)->_merge_next;
+                spill->_home = reinterpret_cast< async_io const* >(data->private_data)->_home;
+                spill_data = *data;
+                spill_data.private_data = &*spill;
+                child_data = &spill_data;
+            }
+        }
+
+        // Eagerly start each child task so all SQEs are in-flight before the first co_await,
+        // preserving kernel parallelism. All tasks must be drained even on error to avoid
+        // dangling _waiter handles in cqe_state.
+        for (auto r = 0U; plan.nr_runs > r; ++r) {
+            auto const& run = plan.runs[r];
+            tasks[r].start(*_stripe_array[run.leg]->disk, q, child_data, &plan.vecs[run.first], run.nr_vecs, run.addr);
+        }
+        for (auto r = 0U; plan.nr_runs > r; ++r) {
+            auto res = co_await tasks[r].wait();
+            tasks[r].reset();
+            if (res < 0 && !err)
+                err = res;
+            else
+                total += res;
+        }
     }
+    guard.release();
     co_return err ? err : total;
 }
 
@@ -373,9 +635,11 @@ static io_result write_superblock(ublk_disk& device, raid0::SuperBlock* sb) {
 }
 
 // Read and load the RAID0 superblock off a device. If it is not set, meaning the Magic is missing, then initialize
-// the superblock to the current version. Otherwise migrate any changes needed after version discovery.
+// the superblock to the current version for an array of `width` legs with the stripe `weights` (none for
+// round-robin). Otherwise migrate any changes needed after version discovery.
 static std::expected< raid0::SuperBlock*, std::error_condition >
-load_superblock(ublk_disk& device, boost::uuids::uuid const& uuid, uint32_t& stripe_size, uint16_t const stripe_off) {
+load_superblock(ublk_disk& device, boost::uuids::uuid const& uuid, uint32_t& stripe_size, uint16_t const stripe_off,
+                uint16_t const width, std::span< uint8_t const > weights) {
     auto sb = read_superblock(device);
     if (!sb) return std::unexpected(std::make_error_condition(std::errc::io_error));
 
@@ -387,6 +651,9 @@ load_superblock(ublk_disk& device, boost::uuids::uuid const& uuid, uint32_t& str
         memcpy(sb->header.uuid, uuid.data, sizeof(sb->header.uuid));
         sb->fields.stripe_off = htobe16(stripe_off);
         sb->fields.stripe_size = htobe32(stripe_size);
+        sb->fields.width = htobe16(width);
+        sb->fields.old_width = htobe16(width);
+        std::ranges::copy(weights.first(std::min(weights.size(), sizeof(sb->fields.weights))), sb->fields.weights);
     }
 
     // Verify some details in the superblock
@@ -424,6 +691,11 @@ load_superblock(ublk_disk& device, boost::uuids::uuid const& uuid, uint32_t& str
     // Migrating to latest version
     if (k_sb_version > sb_ver) {
         sb->header.version = htobe16(k_sb_version);
+        // v1 did not record the width; it is the array being assembled
+        if (0 == sb->fields.width) {
+            sb->fields.width = htobe16(width);
+            sb->fields.old_width = htobe16(width);
+        }
         if (!write_superblock(device, sb)) {
             free(sb);
             return std::unexpected(std::make_error_condition(std::errc::io_error));
@@ -432,10 +704,193 @@ load_superblock(ublk_disk& device, boost::uuids::uuid const& uuid, uint32_t& str
     return sb;
 }
 
+// Record the layout on legs [0, width). Caller holds _sb_lock.
+bool Raid0Disk::__persist_sb(uint32_t const width, uint32_t const old_width, uint64_t const pos) {
+    ++_age;
+    auto ok = true;
+    for (auto i = 0U; width > i; ++i) {
+        auto* sb = _stripe_array[i]->_sb.get();
+        sb->fields.width = htobe16(static_cast< uint16_t >(width));
+        sb->fields.old_width = htobe16(static_cast< uint16_t >(old_width));
+        sb->fields.reshape_pos = htobe64(pos);
+        sb->fields.age = htobe64(_age);
+        if (!write_superblock(*_stripe_array[i]->disk, sb)) ok = false;
+    }
+    return ok;
+}
+
+// Append `legs` to the array and restripe onto them in the background.
+bool Raid0Disk::expand(std::vector< std::shared_ptr< ublk_disk > >&& legs) {
+    {
+        auto lk = std::scoped_lock(_sb_lock);
+        auto const width = _width.load(std::memory_order_acquire);
+        if (legs.empty() || width != _old_width.load(std::memory_order_acquire) ||
+            _max_stripe_cnt < width + legs.size() || 0 < _map.cycle) {
+            RLOGW("Refusing to add {} legs to {}: a reshape is running, the layout is weighted or the array would "
+                  "exceed {} legs",
+                  legs.size(), id(), _max_stripe_cnt)
+            return false;
+        }
+        // Added legs must take a share of every I/O the kernel may send and hold as many stripes
+        // as the legs already there, so the array can grow into them once restriped.
+        auto leg_capacity = UINT64_MAX;
+        auto leg_tx = UINT32_MAX;
+        for (auto i = 0U; width > i; ++i) {
+            leg_capacity = std::min(leg_capacity, _stripe_array[i]->disk->capacity());
+            leg_tx = std::min(leg_tx, _stripe_array[i]->disk->max_tx());
+        }
+        for (auto const& leg : legs) {
+            if (!leg || leg->is_missing()) return false;
+            if (leg->capacity() < leg_capacity || leg->block_size() > block_size() || leg->max_tx() < leg_tx ||
+                (can_discard() && !leg->can_discard()) || !__accepts(*leg)) {
+                RLOGW("Refusing to add {} to {}: smaller than the current legs or incompatible", *leg, id())
+                return false;
+            }
+        }
+
+        // Legs past _width are invisible to I/O until published below
+        auto const new_width = static_cast< uint32_t >(width + legs.size());
+        for (auto& leg : legs) {
+            auto stripe_size = _stripe_size;
+            auto sb = load_superblock(*leg, _uuid, stripe_size, static_cast< uint16_t >(_stripe_array.size()),
+                                      static_cast< uint16_t >(new_width), {});
+            if (!sb || _stripe_size != stripe_size) {
+                RLOGE("Could not add {} to {}: {}", *leg, id(), sb ? "stripe size differs" : sb.error().message())
+                if (sb) free(sb.value());
+                _stripe_array.resize(width);
+                return false;
+            }
+            _stripe_array.emplace_back(std::make_unique< StripeDevice >(leg, sb.value()));
+        }
+        if (!__persist_sb(new_width, width, 0)) {
+            RLOGE("Could not record the expansion of {}; keeping {} legs", id(), width)
+            std::ignore = __persist_sb(width, width, 0);
+            _stripe_array.resize(width);
+            return false;
+        }
+        // Running queues get the newcomers prepared as well. Pools they already sized stay as
+        // they are; async_iov() brings its own when they could run short.
+        {
+            auto qlk = std::scoped_lock(_queues_lock);
+            for (auto const& leg : legs) {
+                auto const sqes = leg->prepare(nullptr, 0).max_sqes_per_io;
+                if (sqes > _leg_sqes.load(std::memory_order_relaxed)) _leg_sqes.store(sqes, std::memory_order_relaxed);
+                for (auto const* q : _queues)
+                    std::ignore = leg->prepare(q, 0);
+                if (!leg->scatter_gather()) _scatter_gather.store(false, std::memory_order_relaxed);
+            }
+        }
+        // The whole array is still in the old layout; publish the width last (see __enter())
+        _cursor.store(0);
+        _window_end.store(0);
+        _width.store(new_width);
+        RLOGI("Expanding {} from {} to {} legs; restriping in the background", id(), width, new_width)
+    }
+    if (_reshape_thread.joinable()) _reshape_thread.join();
+    _reshape_thread = std::thread([this] { __reshape(); });
+    return true;
+}
+
+uint64_t Raid0Disk::reshape_remaining() const noexcept {
+    auto const cursor = _cursor.load(std::memory_order_acquire);
+    if (k_no_reshape == cursor) return 0;
+    return capacity() - std::min(capacity(), cursor);
+}
+
+// Background restripe from _old_width onto _width legs, in address order through a window of
+// stripes that I/O waits out. A window never copies a stripe over the old home of another one at
+// or past its start, and is recorded in the superblocks before I/O may use the new layout there:
+// an interrupted reshape resumes from the recorded position with the old layout above it intact.
+void Raid0Disk::__reshape() {
+    auto const width = _width.load(std::memory_order_acquire);
+    auto const old_width = _old_width.load(std::memory_order_acquire);
+    auto const stripe = static_cast< uint64_t >(_stripe_size);
+    auto const end = capacity();
+    auto buf = iovec{.iov_base = nullptr, .iov_len = _stripe_size};
+    if (0 != ::posix_memalign(&buf.iov_base, 4096, _stripe_size)) {
+        RLOGE("Out of memory starting reshape of {}", id())
+        return;
+    }
+    auto const release_buf = std::unique_ptr< void, decltype(&free) >(buf.iov_base, &free);
+
+    auto pos = _cursor.load(std::memory_order_acquire);
+    RLOGI("Restriping {} from {} to {} legs from {:#0x} of {:#0x}", id(), old_width, width, pos, end)
+    while (end > pos) {
+        if (_stopping.load(std::memory_order_acquire)) return;
+        auto hi = pos;
+        while (end > hi && k_reshape_window > hi - pos) {
+            auto const idx = hi / stripe;
+            if (auto const victim = raid0::displaced_stripe(idx, old_width, width); idx != victim && pos / stripe <= victim)
+                break;
+            hi += stripe;
+        }
+        _window_end.store(hi);
+        __quiesce();
+
+        auto ok = true;
+        for (auto idx = pos / stripe; ok && hi / stripe > idx; ++idx) {
+            auto const from = static_cast< uint32_t >(idx % old_width);
+            auto const from_off = (idx / old_width + 1) * stripe;
+            auto const to = static_cast< uint32_t >(idx % width);
+            auto const to_off = (idx / width + 1) * stripe;
+            if (from == to && from_off == to_off) continue;
+            ok = _stripe_array[from]->disk->sync_iov(UBLK_IO_OP_READ, &buf, 1, from_off) &&
+                _stripe_array[to]->disk->sync_iov(UBLK_IO_OP_WRITE, &buf, 1, to_off);
+            if (!ok) RLOGE("Reshape of {} could not move stripe {}", id(), idx)
+        }
+        if (ok) {
+            auto lk = std::scoped_lock(_sb_lock);
+            ok = __persist_sb(width, old_width, hi);
+        }
+        if (!ok) {
+            // The window still holds its old layout; give it back and leave the rest for the next assembly
+            RLOGE("Reshape of {} stopped at {:#0x}; it resumes when the array is next assembled", id(), pos)
+            _window_end.store(pos);
+            return;
+        }
+        _cursor.store(hi);
+        pos = hi;
+    }
+
+    auto lk = std::scoped_lock(_sb_lock);
+    if (!__persist_sb(width, width, 0))
+        RLOGE("Could not record the end of the reshape of {}; it is redone on the next assembly", id())
+    // Old width first: an I/O seeing it with the final cursor has nothing left above the cursor
+    _old_width.store(width);
+    _cursor.store(k_no_reshape);
+    _window_end.store(k_no_reshape);
+    RLOGI("Restriped {} onto {} legs", id(), width)
+}
+
 std::shared_ptr< ublk_disk > make_raid0_disk(boost::uuids::uuid const& uuid, uint32_t stripe_size_bytes,
-                                             std::vector< std::shared_ptr< ublk_disk > >&& disks) {
-    return std::make_shared< Raid0Disk >(uuid, stripe_size_bytes, std::move(disks));
+                                             std::vector< std::shared_ptr< ublk_disk > >&& disks,
+                                             std::vector< uint32_t > const& weights) {
+    return std::make_shared< Raid0Disk >(uuid, stripe_size_bytes, std::move(disks), weights);
+}
+
+// A Raid0Disk whose legs are all of type `Leg`, so that leg I/O takes leg_io< Leg >; built by
+// stack::make_stack() for RAID0 over stack::fs.
+template < typename Leg >
+class Raid0Stack final : public Raid0Disk {
+    bool __accepts(ublk_disk const& leg) const noexcept override { return nullptr != dynamic_cast< Leg const* >(&leg); }
+
+public:
+    using Raid0Disk::Raid0Disk;
+
+    disk_task< int > async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
+                               uint64_t addr) override {
+        return __dispatch< Leg >(q, data, iovecs, nr_vecs, addr);
+    }
+};
+
+namespace stack::detail {
+disk_handle make_raid0_over_fs(boost::uuids::uuid const& uuid, uint32_t stripe_size_bytes,
+                               std::vector< disk_handle >&& disks, std::vector< uint32_t > const& weights) {
+    if (!all_legs_are< FSDisk >(disks))
+        throw std::invalid_argument("Raid0Disk: every leg of a stacked RAID0 over fs must come from make_fs_disk()");
+    return std::make_shared< Raid0Stack< FSDisk > >(uuid, stripe_size_bytes, std::move(disks), weights);
 }
+} // namespace stack::detail
 
 namespace raid0 {
 
@@ -445,5 +900,44 @@ std::shared_ptr< ublk_disk > get_device(ublk_disk const& disk, uint32_t stripe_o
     return r0->get_device(stripe_offset);
 }
 
+bool expand(ublk_disk& disk, std::vector< disk_handle >&& legs) {
+    auto* r0 = dynamic_cast< Raid0Disk* >(&disk);
+    if (!r0) return false;
+    return r0->expand(std::move(legs));
+}
+
+uint64_t reshape_remaining(ublk_disk const& disk) noexcept {
+    auto const* r0 = dynamic_cast< Raid0Disk const* >(&disk);
+    if (!r0) return 0;
+    return r0->reshape_remaining();
+}
+
+std::vector< uint32_t > weights_by_capacity(std::vector< disk_handle > const& disks, uint32_t stripe_size_bytes) {
+    if (2 > disks.size() || raid0::k_max_weighted_legs < disks.size() || 0 == stripe_size_bytes) return {};
+    // Usable stripes per leg, less the superblock stripe
+    auto stripes = std::vector< uint64_t >();
+    for (auto const& disk : disks)
+        stripes.push_back(std::max< uint64_t >(1, disk->capacity() / stripe_size_bytes) - 1);
+    auto const total = std::accumulate(stripes.begin(), stripes.end(), 0UL);
+    if (0 == total) return {};
+    // Share out cycles of every length that fits and keep the one leaving the least capacity
+    // unused; rounding down (and up to 1) never overruns the budget.
+    auto best = std::vector< uint32_t >();
+    auto best_capacity = 0UL;
+    auto res = std::vector< uint32_t >(disks.size());
+    for (auto budget = disks.size(); raid0::k_max_cycle - disks.size() >= budget; ++budget) {
+        auto cycles = UINT64_MAX;
+        for (auto i = 0U; disks.size() > i; ++i) {
+            res[i] = static_cast< uint32_t >(std::max< uint64_t >(1, (stripes[i] * budget) / total));
+            cycles = std::min(cycles, stripes[i] / res[i]);
+        }
+        if (auto const capacity = cycles * std::accumulate(res.begin(), res.end(), 0UL); best_capacity < capacity) {
+            best_capacity = capacity;
+            best = res;
+        }
+    }
+    return best;
+}
+
 } // namespace raid0
 } // namespace ublkpp
@@ -5,7 +5,11 @@ extern "C" {
 }
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <map>
+#include <numeric>
+#include <span>
 #include <tuple>
 
 #include "lib/common.hpp"
@@ -51,6 +55,316 @@ inline auto merged_subcmds(uint64_t const stride_width, uint32_t const stripe_si
     return ret;
 }
 
+// Online expansion restripes the array from `old_width` onto `width` legs in address order, one
+// stripe (stripe_size bytes of the array) at a time. Under a w-leg layout stripe `idx` sits on leg
+// idx % w in row idx / w + 1 (row 0 holds the superblock). Copying stripe `idx` to its new home
+// overwrites the old home of the stripe returned here, which never follows `idx`; `idx` itself
+// means nothing is overwritten (the new home is on an added leg, or the stripe does not move).
+inline uint64_t displaced_stripe(uint64_t const idx, uint32_t const old_width, uint32_t const width) noexcept {
+    auto const leg = idx % width;
+    if (old_width <= leg) return idx;
+    return (idx / width) * old_width + leg;
+}
+
+// Most stripes in one cycle of a weighted layout, and so the largest weight sum
+constexpr uint32_t k_max_cycle = 256;
+// Weights are recorded per leg in the superblock; this many fit
+constexpr uint32_t k_max_weighted_legs = 64;
+
+// Weighted layout: every cycle of `cycle` stripes gives leg i weight[i] of them, interleaved by
+// smooth weighted round-robin so neighbouring stripes still land on different legs. Within a leg
+// the stripes sit in consecutive rows (row 0 holds the superblock), so a contiguous range of the
+// array is contiguous on every leg it touches. The slot order is part of the on-disk format.
+struct weighted_map {
+    uint32_t cycle{0}; // 0: plain round-robin; the tables are unused
+    std::array< uint8_t, k_max_cycle > leg{};            // Slot in the cycle -> leg
+    std::array< uint8_t, k_max_cycle > rank{};           // Slot -> stripes of its leg earlier in the cycle
+    std::array< uint8_t, k_max_weighted_legs > weight{}; // Leg -> stripes per cycle
+};
+
+// Build the map for `weights` (each 1-255, summing to at most k_max_cycle), reduced by their
+// common divisor. Equal weights give an empty map: that is the plain layout.
+inline weighted_map make_weighted_map(std::span< uint8_t const > const weights) noexcept {
+    auto map = weighted_map();
+    auto const div = std::accumulate(weights.begin(), weights.end(), 0U,
+                                     [](uint32_t acc, uint8_t w) { return std::gcd(acc, static_cast< uint32_t >(w)); });
+    if (0 == div || std::ranges::all_of(weights, [&](uint8_t w) { return w == weights.front(); })) return map;
+    auto current = std::array< int32_t, k_max_weighted_legs >{};
+    for (auto i = 0U; weights.size() > i; ++i) {
+        map.weight[i] = static_cast< uint8_t >(weights[i] / div);
+        map.cycle += map.weight[i];
+    }
+    auto seen = std::array< uint8_t, k_max_weighted_legs >{};
+    for (auto slot = 0U; map.cycle > slot; ++slot) {
+        auto pick = 0U;
+        for (auto i = 0U; weights.size() > i; ++i) {
+            current[i] += map.weight[i];
+            if (current[i] > current[pick]) pick = i;
+        }
+        current[pick] -= static_cast< int32_t >(map.cycle);
+        map.leg[slot] = static_cast< uint8_t >(pick);
+        map.rank[slot] = seen[pick]++;
+    }
+    return map;
+}
+
+// Most legs in an array
+constexpr uint32_t k_max_legs = 256;
+// Pieces and runs one io_plan holds. The common read or write is cut into a few pieces and a
+// discard into one per leg; the rest absorbs the seams of scattered input.
+constexpr uint32_t k_max_plan_frags = 64;
+// As k_max_plan_frags for a wide_io_plan: a discard over every leg, or a read or write of up to
+// k_max_wide_frags - 1 stripes (plus one for an unaligned start), fits one
+constexpr uint32_t k_max_wide_frags = k_max_legs;
+
+// Stripe geometry of one layout. Stripes are a power of two in size, so locating an address costs
+// shifts and masks, plus one division per I/O when the width (or cycle) is not a power of two.
+struct geometry {
+    uint32_t stripe_shift{0};
+    uint32_t width{1};                // Legs of a round-robin layout
+    weighted_map const* map{nullptr}; // Set for a weighted layout, which then ignores `width`
+};
+
+// Walks a layout's stripes in array order; only finding the first one divides.
+class stripe_walk {
+    geometry const& _geo;
+    uint64_t _period{0}; // Row (round-robin) or cycle (weighted) of the current stripe
+    uint32_t _slot{0};   // Leg (round-robin) or slot in the cycle (weighted)
+
+public:
+    stripe_walk(geometry const& geo, uint64_t const idx) noexcept : _geo(geo) {
+        auto const n = period_len();
+        if (std::has_single_bit(n)) {
+            _period = idx >> std::countr_zero(n);
+            _slot = static_cast< uint32_t >(idx & (n - 1));
+        } else {
+            _period = idx / n;
+            _slot = static_cast< uint32_t >(idx - (_period * n));
+        }
+    }
+
+    // Stripes in one row or cycle
+    uint32_t period_len() const noexcept { return _geo.map ? _geo.map->cycle : _geo.width; }
+    bool at_period_start() const noexcept { return 0 == _slot; }
+    uint32_t leg() const noexcept { return _geo.map ? _geo.map->leg[_slot] : _slot; }
+    // Stripes `leg` holds in every period
+    uint32_t share(uint32_t const leg) const noexcept { return _geo.map ? _geo.map->weight[leg] : 1U; }
+    // Offset of the current stripe on its leg; row 0 holds the superblock
+    uint64_t leg_offset() const noexcept {
+        auto const row = _geo.map ? (_period * _geo.map->weight[leg()]) + _geo.map->rank[_slot] : _period;
+        return (row + 1) << _geo.stripe_shift;
+    }
+
+    void next() noexcept {
+        if (period_len() == ++_slot) {
+            _slot = 0;
+            ++_period;
+        }
+    }
+    void skip_periods(uint64_t const n) noexcept { _period += n; }
+};
+
+// One leg's part of a planned I/O: nr_vecs pieces from the plan's vecs[first], contiguous on the leg
+struct leg_run {
+    uint64_t addr; // Offset on the leg
+    uint16_t leg;
+    uint16_t first;
+    uint16_t nr_vecs;
+};
+
+// Per-leg scatter lists for an I/O, built with no allocation. Runs are in the order their legs
+// are first touched. io_plan is small enough for every I/O's coroutine frame; arrays it cannot
+// serve in one round use the larger wide_io_plan.
+template < uint32_t N >
+struct basic_io_plan {
+    static constexpr uint32_t k_capacity = N;
+
+    std::array< iovec, N > vecs; // filled before read; no zero-init needed
+    std::array< leg_run, N > runs;
+    uint32_t nr_vecs{0};
+    uint32_t nr_runs{0};
+
+    void clear() noexcept { nr_vecs = nr_runs = 0; }
+};
+using io_plan = basic_io_plan< k_max_plan_frags >;
+using wide_io_plan = basic_io_plan< k_max_wide_frags >;
+
+// Read position in a caller's scatter list
+struct iov_cursor {
+    iovec const* iov;
+    uint32_t nr_vecs;
+    uint64_t off{0}; // Bytes of *iov already taken
+
+    void advance(uint64_t const n) noexcept {
+        off += n;
+        while (0 < nr_vecs && iov->iov_len == off) {
+            ++iov;
+            --nr_vecs;
+            off = 0;
+        }
+    }
+};
+
+// The run each leg's pieces go to, among those one plan_io() / plan_discard() call adds. A
+// round-robin walk first touches the legs in slot order, so a stripe's run follows from how many
+// stripes (modulo the width) it lies past the first and no per-leg table is needed; weighted
+// layouts (at most k_max_weighted_legs legs) look it up.
+class run_finder {
+    static constexpr uint16_t k_none = UINT16_MAX;
+    std::array< uint16_t, k_max_weighted_legs > _run_of; // Weighted only
+    uint32_t const _base;
+    uint32_t const _width;
+    uint32_t _rel{0}; // Round-robin: stripes walked, modulo the width
+    bool const _weighted;
+
+public:
+    run_finder(geometry const& geo, uint32_t const base) noexcept :
+            _base(base), _width(geo.width), _weighted(nullptr != geo.map) {
+        if (_weighted) _run_of.fill(k_none);
+    }
+
+    // Run of `leg`, which the walk is on, or nr_runs if it has none yet
+    uint32_t find(uint32_t const leg, uint32_t const nr_runs) const noexcept {
+        if (_weighted) return (k_none == _run_of[leg]) ? nr_runs : _run_of[leg];
+        return std::min(_base + _rel, nr_runs);
+    }
+    void add(uint32_t const leg, uint32_t const run) noexcept {
+        if (_weighted) _run_of[leg] = static_cast< uint16_t >(run);
+    }
+    void next() noexcept {
+        if (!_weighted && _width == ++_rel) _rel = 0;
+    }
+};
+
+// Cut [addr, addr + len) of the array, laid out by `geo`, into per-leg runs appended to `plan`,
+// taking the buffers from `src`. A leg's part of a contiguous range is contiguous on the leg, so
+// each touched leg gets one run (per call); pieces that meet in memory are joined. Stops when
+// `plan` or `src` runs out and returns the bytes planned, which is never 0 for an empty plan.
+template < uint32_t N >
+uint64_t plan_io(basic_io_plan< N >& plan, geometry const& geo, iov_cursor& src, uint64_t const addr,
+                 uint64_t const len) noexcept {
+    auto const stripe_size = 1UL << geo.stripe_shift;
+    auto walk = stripe_walk(geo, addr >> geo.stripe_shift);
+    auto chunk_off = addr & (stripe_size - 1);
+    // Most small I/O sits in one stripe and one buffer: a single run, with nothing to group
+    if (0 < src.nr_vecs && stripe_size - chunk_off >= len && src.iov->iov_len - src.off >= len && N > plan.nr_vecs &&
+        N > plan.nr_runs) [[likely]] {
+        plan.runs[plan.nr_runs++] = leg_run{.addr = walk.leg_offset() + chunk_off,
+                                            .leg = static_cast< uint16_t >(walk.leg()),
+                                            .first = static_cast< uint16_t >(plan.nr_vecs),
+                                            .nr_vecs = 1};
+        plan.vecs[plan.nr_vecs++] =
+            iovec{.iov_base = static_cast< uint8_t* >(src.iov->iov_base) + src.off, .iov_len = len};
+        src.advance(len);
+        return len;
+    }
+
+    auto const base_run = plan.nr_runs;
+    auto runs = run_finder(geo, base_run);
+    // Pieces in array order, grouped by leg below; only the first nr_pieces are ever read
+    std::array< iovec, N > pieces;
+    std::array< uint16_t, N > piece_run;
+    auto nr_pieces = 0U;
+    auto pos = 0UL;
+    while (len > pos && 0 < src.nr_vecs && N > plan.nr_vecs + nr_pieces) {
+        auto const leg = walk.leg();
+        auto const run = runs.find(leg, plan.nr_runs);
+        if (plan.nr_runs == run) {
+            if (N == plan.nr_runs) break;
+            runs.add(leg, run);
+            plan.runs[plan.nr_runs++] = leg_run{
+                .addr = walk.leg_offset() + chunk_off, .leg = static_cast< uint16_t >(leg), .first = 0, .nr_vecs = 0};
+        }
+        auto const sz = std::min({stripe_size - chunk_off, len - pos, src.iov->iov_len - src.off});
+        pieces[nr_pieces] = iovec{.iov_base = static_cast< uint8_t* >(src.iov->iov_base) + src.off, .iov_len = sz};
+        piece_run[nr_pieces++] = static_cast< uint16_t >(run);
+        src.advance(sz);
+        pos += sz;
+        chunk_off += sz;
+        if (stripe_size == chunk_off) {
+            chunk_off = 0;
+            walk.next();
+            runs.next();
+        }
+    }
+
+    // Give every new run room for all its pieces, then place them in array order
+    for (auto i = 0U; nr_pieces > i; ++i)
+        ++plan.runs[piece_run[i]].nr_vecs;
+    for (auto r = base_run; plan.nr_runs > r; ++r) {
+        auto& run = plan.runs[r];
+        run.first = static_cast< uint16_t >(plan.nr_vecs);
+        plan.nr_vecs += run.nr_vecs;
+        run.nr_vecs = 0;
+    }
+    for (auto i = 0U; nr_pieces > i; ++i) {
+        auto& run = plan.runs[piece_run[i]];
+        if (0 < run.nr_vecs) {
+            auto& last = plan.vecs[run.first + run.nr_vecs - 1];
+            if (static_cast< uint8_t* >(last.iov_base) + last.iov_len == pieces[i].iov_base) {
+                last.iov_len += pieces[i].iov_len;
+                continue;
+            }
+        }
+        plan.vecs[run.first + run.nr_vecs++] = pieces[i];
+    }
+    return pos;
+}
+
+// As plan_io() for an I/O with no buffer (discard): one run per leg holding a single iovec with no
+// base. Whole rows or cycles past the first are added to each leg at once, so the cost is bounded
+// by the width, not the length. Returns the bytes planned, never 0 for an empty plan.
+template < uint32_t N >
+uint64_t plan_discard(basic_io_plan< N >& plan, geometry const& geo, uint64_t const addr, uint64_t const len) noexcept {
+    auto const base_run = plan.nr_runs;
+    auto runs = run_finder(geo, base_run);
+
+    auto const stripe_size = 1UL << geo.stripe_shift;
+    auto walk = stripe_walk(geo, addr >> geo.stripe_shift);
+    auto const period_bytes = static_cast< uint64_t >(walk.period_len()) << geo.stripe_shift;
+    auto chunk_off = addr & (stripe_size - 1);
+    auto pos = 0UL;
+    auto seen_period_start = false;
+    auto skipped = false;
+    while (len > pos) {
+        if (0 == chunk_off && walk.at_period_start() && !skipped) {
+            // A full period has been walked since the first boundary, so every leg has its run
+            if (auto const periods = (len - pos) / period_bytes; seen_period_start && 0 < periods) {
+                for (auto r = base_run; plan.nr_runs > r; ++r) {
+                    auto const& run = plan.runs[r];
+                    plan.vecs[run.first].iov_len += (periods * walk.share(run.leg)) << geo.stripe_shift;
+                }
+                walk.skip_periods(periods);
+                pos += periods * period_bytes;
+                skipped = true;
+                continue;
+            }
+            seen_period_start = true;
+        }
+        auto const leg = walk.leg();
+        auto const run = runs.find(leg, plan.nr_runs);
+        if (plan.nr_runs == run) {
+            if (N == plan.nr_runs || N == plan.nr_vecs) break;
+            runs.add(leg, run);
+            plan.runs[plan.nr_runs++] = leg_run{.addr = walk.leg_offset() + chunk_off,
+                                                .leg = static_cast< uint16_t >(leg),
+                                                .first = static_cast< uint16_t >(plan.nr_vecs),
+                                                .nr_vecs = 1};
+            plan.vecs[plan.nr_vecs++] = iovec{.iov_base = nullptr, .iov_len = 0};
+        }
+        auto const sz = std::min(stripe_size - chunk_off, len - pos);
+        plan.vecs[plan.runs[run].first].iov_len += sz;
+        pos += sz;
+        chunk_off += sz;
+        if (stripe_size == chunk_off) {
+            chunk_off = 0;
+            walk.next();
+            runs.next();
+        }
+    }
+    return pos;
+}
+
 #ifdef __LITTLE_ENDIAN
 struct __attribute__((__packed__)) SuperBlock {
     struct {
@@ -59,8 +373,13 @@ struct __attribute__((__packed__)) SuperBlock {
         uint8_t uuid[16];
     } header;
     struct {
-        uint16_t stripe_off;  // Position within the array
-        uint32_t stripe_size; // Number of bytes before rotating devices
+        uint16_t stripe_off;                  // Position within the array
+        uint32_t stripe_size;                 // Number of bytes before rotating devices
+        uint16_t width;                       // v2: Legs in the array; 0 if not recorded
+        uint16_t old_width;                   // v2: Legs before the reshape in progress; == width when none is
+        uint64_t reshape_pos;                 // v2: Array bytes below this are already restriped onto `width` legs
+        uint64_t age;                         // v2: Bumped on every update; the highest copy wins on assembly
+        uint8_t weights[k_max_weighted_legs]; // v3: Stripes per cycle on each leg; all 0 for round-robin
     } fields;
     uint8_t _reserved[k_page_size - (sizeof(header) + sizeof(fields))];
 };
@@ -69,6 +388,6 @@ static_assert(k_page_size == sizeof(SuperBlock), "Size of raid0::SuperBlock does
 #error "Big Endian not supported!"
 #endif
 
-constexpr uint16_t k_sb_version = 1;
+constexpr uint16_t k_sb_version = 3;
 
 } // namespace ublkpp::raid0
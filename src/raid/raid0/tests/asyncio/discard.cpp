@@ -15,7 +15,7 @@ TEST_F(AsyncRaid0Fixture, DiscardSingleStripe) {
 }
 
 TEST_F(AsyncRaid0Fixture, DiscardAllStripes) {
-    // 96KB discard spanning all three stripes — merged_subcmds fans out to each.
+    // 96KB discard spanning all three stripes — plan_discard fans out to each.
     EXPECT_CALL(*disk_a, submit_iov(_, _, _, _, _)).Times(1);
     EXPECT_CALL(*disk_b, submit_iov(_, _, _, _, _)).Times(1);
     EXPECT_CALL(*disk_c, submit_iov(_, _, _, _, _)).Times(1);
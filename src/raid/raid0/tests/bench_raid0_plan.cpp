@@ -0,0 +1,137 @@
+// Per-I/O cost of RAID0 request planning: cutting one I/O into per-leg scatter lists.
+//
+// No device is touched, so this isolates the address math and bookkeeping of raid0::plan_io() /
+// plan_discard() from the I/O itself. Each case is also run through the per-fragment
+// next_subcmd() / merged_subcmds() helpers (divide and modulo per stripe, a std::map per
+// discard) for comparison. Not registered with ctest; run by hand:
+//
+//     bench_raid0_plan [--iterations=1000000]
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <sisl/logging/logging.h>
+#include <sisl/options/options.h>
+
+#include "raid/raid0/raid0_impl.hpp"
+
+SISL_OPTION_GROUP(bench_raid0_plan,
+                  (iterations, "", "iterations", "I/Os planned per case",
+                   ::cxxopts::value< uint32_t >()->default_value("1000000"), "<count>"))
+
+#define ENABLED_OPTIONS logging, bench_raid0_plan
+
+SISL_LOGGING_INIT(ublk_raid)
+SISL_OPTIONS_ENABLE(ENABLED_OPTIONS)
+
+using namespace ublkpp;
+
+namespace {
+struct bench_case {
+    std::string name;
+    uint32_t stripe_size;
+    uint32_t width;                // Ignored when `weights` is set
+    std::vector< uint8_t > weights; // Weighted layout when not empty
+    uint64_t io_size;
+    uint32_t nr_pieces; // Scatter-list entries the I/O arrives in; 0 for a discard
+};
+
+// Defeats dead-code elimination of the planned results
+uint64_t volatile g_sink;
+
+// Array address of the i-th I/O: spread over 1 TiB, aligned to 4 KiB
+uint64_t address_of(uint64_t const i) { return ((i * 2654435761ULL) << 12) & (Ti - 1); }
+
+double ns_per_io(uint32_t const iterations, auto&& body) {
+    auto sink = 0UL;
+    auto const start = std::chrono::steady_clock::now();
+    for (auto i = 0U; iterations > i; ++i)
+        sink += body(address_of(i));
+    auto const ns = std::chrono::duration< double, std::nano >(std::chrono::steady_clock::now() - start).count();
+    g_sink = sink;
+    return ns / iterations;
+}
+
+// The plan built for every I/O; Raid0Disk takes the wide one for arrays the compact one cannot serve
+template < typename Plan >
+double planned(bench_case const& c, uint32_t const iterations, std::vector< uint8_t >& buf) {
+    auto const map = raid0::make_weighted_map(c.weights);
+    auto const geo = raid0::geometry{.stripe_shift = static_cast< uint32_t >(std::countr_zero(c.stripe_size)),
+                                     .width = c.width,
+                                     .map = (0 < map.cycle) ? &map : nullptr};
+    auto iovs = std::vector< iovec >();
+    for (auto i = 0U; c.nr_pieces > i; ++i) {
+        auto const piece = c.io_size / c.nr_pieces;
+        iovs.push_back(iovec{.iov_base = buf.data() + (2 * i * piece), .iov_len = piece});
+    }
+    Plan plan;
+    return ns_per_io(iterations, [&](uint64_t const addr) {
+        plan.clear();
+        if (0 == c.nr_pieces) return raid0::plan_discard(plan, geo, addr, c.io_size) + plan.nr_runs;
+        auto src = raid0::iov_cursor{.iov = iovs.data(), .nr_vecs = static_cast< uint32_t >(iovs.size())};
+        return raid0::plan_io(plan, geo, src, addr, c.io_size) + plan.nr_runs;
+    });
+}
+
+// The same split one stripe at a time; weighted layouts locate each stripe afresh
+double per_fragment(bench_case const& c, uint32_t const iterations) {
+    auto const map = raid0::make_weighted_map(c.weights);
+    auto const geo = raid0::geometry{.stripe_shift = static_cast< uint32_t >(std::countr_zero(c.stripe_size)),
+                                     .map = &map};
+    auto const stride = static_cast< uint64_t >(c.stripe_size) * c.width;
+    return ns_per_io(iterations, [&](uint64_t const addr) {
+        if (0 == c.nr_pieces) return raid0::merged_subcmds(stride, c.stripe_size, addr + stride, c.io_size).size();
+        auto sum = 0UL;
+        for (auto off = 0UL; c.io_size > off;) {
+            auto const left = static_cast< uint32_t >(c.io_size - off);
+            if (0 < map.cycle) {
+                auto const walk = raid0::stripe_walk(geo, (addr + off) / c.stripe_size);
+                auto const chunk_off = (addr + off) % c.stripe_size;
+                sum += walk.leg() + walk.leg_offset() + chunk_off;
+                off += std::min< uint64_t >(left, c.stripe_size - chunk_off);
+                continue;
+            }
+            auto const [leg, leg_off, sz] = raid0::next_subcmd(stride, c.stripe_size, addr + stride + off, left);
+            sum += leg + leg_off;
+            off += sz;
+        }
+        return sum;
+    });
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SISL_OPTIONS_LOAD(argc, argv, ENABLED_OPTIONS);
+    sisl::logging::SetLogger(std::string(argv[0]));
+    spdlog::set_pattern("[%D %T.%e] [%n] [%^%l%$] [%t] %v");
+
+    auto const iterations = SISL_OPTIONS["iterations"].as< uint32_t >();
+    auto const cases = std::vector< bench_case >{
+        {"x4 128K, 4K", 128 * Ki, 4, {}, 4 * Ki, 1},
+        {"x4 128K, 128K", 128 * Ki, 4, {}, 128 * Ki, 1},
+        {"x4 64K, 1M", 64 * Ki, 4, {}, 1 * Mi, 1},
+        {"x3 64K, 1M", 64 * Ki, 3, {}, 1 * Mi, 1},
+        {"x8 64K, 1M x16", 64 * Ki, 8, {}, 1 * Mi, 16},
+        {"3:1:2 64K, 512K", 64 * Ki, 3, {3, 1, 2}, 512 * Ki, 1},
+        {"x4 128K, discard 1G", 128 * Ki, 4, {}, 1 * Gi, 0},
+        {"x128 128K, 1M", 128 * Ki, 128, {}, 1 * Mi, 1},
+        {"x128 4K, 1M-4K", 4 * Ki, 128, {}, 1 * Mi - 4 * Ki, 1},
+        {"x128 4K, discard 1G", 4 * Ki, 128, {}, 1 * Gi, 0},
+        {"x256 16K, 1M", 16 * Ki, 256, {}, 1 * Mi, 1},
+        {"x256 4K, 4K", 4 * Ki, 256, {}, 4 * Ki, 1},
+        {"x256 128K, discard 1G", 128 * Ki, 256, {}, 1 * Gi, 0},
+    };
+    auto buf = std::vector< uint8_t >(2 * Mi);
+    fmt::print("{:<22} {:>12} {:>16}   ({} I/Os per case)\n", "layout, I/O", "plan ns/IO", "per-stripe ns/IO",
+               iterations);
+    for (auto const& c : cases) {
+        auto const stripes = (c.io_size + c.stripe_size - 1) / c.stripe_size;
+        auto const compact = raid0::io_plan::k_capacity >= c.width && raid0::io_plan::k_capacity > stripes;
+        auto const p = compact ? planned< raid0::io_plan >(c, iterations, buf)
+                               : planned< raid0::wide_io_plan >(c, iterations, buf);
+        // A map per discard is far slower; a fraction of the I/Os is enough to compare
+        auto const f = per_fragment(c, (0 == c.nr_pieces) ? std::max(1U, iterations / 1000) : iterations);
+        fmt::print("{:<22} {:>12.1f} {:>16.1f}\n", c.name, p, f);
+    }
+    return 0;
+}
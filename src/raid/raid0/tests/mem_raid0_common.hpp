@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <boost/uuid/string_generator.hpp>
+
+#include "test_raid0_common.hpp"
+
+using ::testing::NiceMock;
+using ::ublkpp::Mi;
+
+constexpr uint32_t k_stripe = 32 * Ki;
+constexpr uint64_t k_leg_capacity = 2 * Mi;
+
+inline mem_leg make_leg(std::string const& id, uint64_t capacity = k_leg_capacity) {
+    return make_mem_leg(id, capacity);
+}
+
+inline std::vector< mem_leg > make_legs(uint32_t width, char first = 'A') {
+    return make_mem_legs(width, k_leg_capacity, first);
+}
+
+inline std::shared_ptr< ublk_disk > make_array(std::vector< mem_leg > const& legs,
+                                               std::vector< uint32_t > const& weights = {}) {
+    return ublkpp::make_raid0_disk(boost::uuids::string_generator()(test_uuid), k_stripe, handles_of(legs), weights);
+}
+
+// Decoded superblock on `leg`
+inline ublkpp::raid0::SuperBlock read_sb(mem_leg const& leg) {
+    auto sb = ublkpp::raid0::SuperBlock();
+    memcpy(&sb, leg.data->data(), sizeof(sb));
+    return sb;
+}
+
+// Byte `off` of the pattern the tests fill arrays with
+inline uint8_t pattern_at(uint64_t off, uint8_t seed = 0) {
+    return static_cast< uint8_t >((off / 512) * 131 + (off % 512) + seed);
+}
+
+inline io_result array_io(ublk_disk& raid, uint8_t op, uint8_t* buf, uint64_t len, uint64_t off) {
+    auto iov = iovec{.iov_base = buf, .iov_len = len};
+    return raid.sync_iov(op, &iov, 1, static_cast< off_t >(off));
+}
+
+// Fill [0, len) of the array with the pattern
+inline void fill_array(ublk_disk& raid, uint64_t len, uint8_t seed = 0) {
+    auto buf = std::vector< uint8_t >(256 * Ki);
+    for (auto off = 0UL; len > off; off += buf.size()) {
+        auto const sz = std::min< uint64_t >(buf.size(), len - off);
+        for (auto i = 0UL; sz > i; ++i)
+            buf[i] = pattern_at(off + i, seed);
+        ASSERT_TRUE(array_io(raid, UBLK_IO_OP_WRITE, buf.data(), sz, off));
+    }
+}
+
+// Read [0, expected.size()) of the array back and compare
+inline void expect_contents(ublk_disk& raid, std::vector< uint8_t > const& expected) {
+    auto buf = std::vector< uint8_t >(256 * Ki);
+    for (auto off = 0UL; expected.size() > off; off += buf.size()) {
+        auto const sz = std::min< uint64_t >(buf.size(), expected.size() - off);
+        ASSERT_TRUE(array_io(raid, UBLK_IO_OP_READ, buf.data(), sz, off));
+        ASSERT_EQ(0, memcmp(buf.data(), expected.data() + off, sz)) << "mismatch in [" << off << ", " << off + sz << ")";
+    }
+}
+
+inline std::vector< uint8_t > pattern(uint64_t len, uint8_t seed = 0) {
+    auto res = std::vector< uint8_t >(len);
+    for (auto i = 0UL; len > i; ++i)
+        res[i] = pattern_at(i, seed);
+    return res;
+}
+
+// Wait for the background restripe to finish
+inline bool wait_reshaped(ublk_disk const& raid, std::chrono::seconds timeout = std::chrono::seconds(30)) {
+    auto const deadline = std::chrono::steady_clock::now() + timeout;
+    while (0 < ublkpp::raid0::reshape_remaining(raid)) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Wait for a leg set up with `fail_from` to stop the reshape
+inline bool wait_failed(mem_leg const& leg, std::chrono::seconds timeout = std::chrono::seconds(30)) {
+    auto const deadline = std::chrono::steady_clock::now() + timeout;
+    while (!*leg.failed) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
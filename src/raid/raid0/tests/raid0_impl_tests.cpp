@@ -223,3 +223,315 @@ TEST(Raid0Impl, SuperBlockLayout) {
     EXPECT_EQ(sb.fields.stripe_off, 0);
     EXPECT_EQ(be32toh(sb.fields.stripe_size), 128 * Ki);
 }
+
+// Test: restriping 2 -> 3 legs; stripes 0-2 stay put or land on the new leg, stripe 3 overwrites
+// the old home of stripe 2 and so on
+TEST(Raid0Impl, DisplacedStripeExamples) {
+    EXPECT_EQ(0UL, ublkpp::raid0::displaced_stripe(0, 2, 3));
+    EXPECT_EQ(1UL, ublkpp::raid0::displaced_stripe(1, 2, 3));
+    EXPECT_EQ(2UL, ublkpp::raid0::displaced_stripe(2, 2, 3));
+    EXPECT_EQ(2UL, ublkpp::raid0::displaced_stripe(3, 2, 3));
+    EXPECT_EQ(3UL, ublkpp::raid0::displaced_stripe(4, 2, 3));
+    EXPECT_EQ(5UL, ublkpp::raid0::displaced_stripe(5, 2, 3));
+    EXPECT_EQ(4UL, ublkpp::raid0::displaced_stripe(6, 2, 3));
+}
+
+// Test: the displaced stripe never follows the one moved, and its old home is the new one
+TEST(Raid0Impl, DisplacedStripeNeverAhead) {
+    for (auto old_width = 1U; 8 >= old_width; ++old_width) {
+        for (auto width = old_width + 1; old_width + 4 >= width; ++width) {
+            for (auto idx = 0UL; 512 > idx; ++idx) {
+                auto const victim = ublkpp::raid0::displaced_stripe(idx, old_width, width);
+                ASSERT_LE(victim, idx);
+                if (victim == idx) continue;
+                EXPECT_EQ(idx % width, victim % old_width);
+                EXPECT_EQ(idx / width, victim / old_width);
+            }
+        }
+    }
+}
+
+// Test: equal weights (after dividing out their common factor) are the plain layout
+TEST(Raid0Impl, WeightedMapEqualIsPlain) {
+    auto const weights = std::array< uint8_t, 3 >{2, 2, 2};
+    EXPECT_EQ(0U, ublkpp::raid0::make_weighted_map(weights).cycle);
+}
+
+// Test: smooth weighted round-robin order, ties going to the lower leg
+TEST(Raid0Impl, WeightedMapInterleaves) {
+    auto const weights = std::array< uint8_t, 2 >{6, 2};
+    auto const map = ublkpp::raid0::make_weighted_map(weights);
+    ASSERT_EQ(4U, map.cycle);
+    EXPECT_EQ(3, map.weight[0]);
+    EXPECT_EQ(1, map.weight[1]);
+    EXPECT_EQ((std::array< uint8_t, 4 >{0, 0, 1, 0}), (std::array< uint8_t, 4 >{map.leg[0], map.leg[1], map.leg[2], map.leg[3]}));
+    EXPECT_EQ((std::array< uint8_t, 4 >{0, 1, 0, 2}),
+              (std::array< uint8_t, 4 >{map.rank[0], map.rank[1], map.rank[2], map.rank[3]}));
+}
+
+// Test: weighted stripe placement, superblock row included
+TEST(Raid0Impl, WeightedStripeWalk) {
+    auto const weights = std::array< uint8_t, 2 >{2, 1};
+    auto const map = ublkpp::raid0::make_weighted_map(weights);
+    auto const geo = ublkpp::raid0::geometry{.stripe_shift = 12, .map = &map};
+    // Cycle: leg 0, leg 1, leg 0
+    auto check = [&](uint64_t idx, uint32_t leg, uint64_t off) {
+        auto const walk = ublkpp::raid0::stripe_walk(geo, idx);
+        EXPECT_EQ(leg, walk.leg()) << idx;
+        EXPECT_EQ(off, walk.leg_offset()) << idx;
+    };
+    check(0, 0, 4 * Ki);
+    check(1, 1, 4 * Ki);
+    check(2, 0, 8 * Ki);
+    check(3, 0, 12 * Ki);
+    check(4, 1, 8 * Ki);
+}
+
+// Test: every leg's stripes fill its rows in order, so contiguous ranges stay contiguous per leg
+TEST(Raid0Impl, WeightedRowsAreConsecutive) {
+    for (auto const& weights : {std::vector< uint8_t >{1, 2}, std::vector< uint8_t >{5, 3, 1},
+                                std::vector< uint8_t >{255, 1}, std::vector< uint8_t >{7, 7, 7, 3}}) {
+        auto const map = ublkpp::raid0::make_weighted_map(weights);
+        ASSERT_LT(0U, map.cycle);
+        auto const geo = ublkpp::raid0::geometry{.stripe_shift = 12, .map = &map};
+        auto next_row = std::vector< uint64_t >(weights.size(), 1);
+        auto walk = ublkpp::raid0::stripe_walk(geo, 0);
+        for (auto idx = 0UL; 4 * map.cycle > idx; ++idx, walk.next()) {
+            // Stepping agrees with starting afresh at each stripe
+            ASSERT_EQ(ublkpp::raid0::stripe_walk(geo, idx).leg_offset(), walk.leg_offset());
+            ASSERT_EQ(next_row[walk.leg()]++ * 4 * Ki, walk.leg_offset());
+        }
+        for (auto i = 0U; weights.size() > i; ++i)
+            EXPECT_EQ(1 + 4 * map.weight[i], next_row[i]);
+    }
+}
+
+// Flatten a plan into (leg, offset on the leg, bytes) per byte range, in array order of the pieces
+template < uint32_t N >
+static std::vector< std::tuple< uint32_t, uint64_t, uint64_t > >
+pieces_of(ublkpp::raid0::basic_io_plan< N > const& plan) {
+    auto res = std::vector< std::tuple< uint32_t, uint64_t, uint64_t > >();
+    for (auto r = 0U; plan.nr_runs > r; ++r) {
+        auto const& run = plan.runs[r];
+        auto off = run.addr;
+        for (auto v = 0U; run.nr_vecs > v; ++v) {
+            res.emplace_back(run.leg, off, plan.vecs[run.first + v].iov_len);
+            off += plan.vecs[run.first + v].iov_len;
+        }
+    }
+    return res;
+}
+
+// Test: a planned write puts every byte where next_subcmd() does, one run per leg
+TEST(Raid0Impl, PlanMatchesNextSubcmd) {
+    constexpr uint64_t stripe = 4 * Ki;
+    auto buf = std::vector< uint8_t >(17 * stripe);
+    for (auto width = 1U; 7 >= width; ++width) {
+        auto const geo = ublkpp::raid0::geometry{.stripe_shift = 12, .width = width};
+        for (auto const addr : {0UL, 512UL, 3 * stripe - 512, 1000 * stripe + 1536}) {
+            for (auto const len : {512UL, stripe, 5 * stripe + 1024, 16 * stripe}) {
+                auto plan = ublkpp::raid0::io_plan();
+                auto iov = iovec{.iov_base = buf.data(), .iov_len = len};
+                auto src = ublkpp::raid0::iov_cursor{.iov = &iov, .nr_vecs = 1};
+                ASSERT_EQ(len, ublkpp::raid0::plan_io(plan, geo, src, addr, len));
+                ASSERT_LE(plan.nr_runs, width);
+                // Per leg: where each byte of the buffer went
+                auto placed = std::map< std::pair< uint32_t, uint64_t >, uint8_t const* >();
+                for (auto r = 0U; plan.nr_runs > r; ++r) {
+                    auto const& run = plan.runs[r];
+                    auto off = run.addr;
+                    for (auto v = 0U; run.nr_vecs > v; ++v) {
+                        auto const& piece = plan.vecs[run.first + v];
+                        for (auto b = 0UL; piece.iov_len > b; b += 512)
+                            placed[{run.leg, off + b}] = static_cast< uint8_t const* >(piece.iov_base) + b;
+                        off += piece.iov_len;
+                    }
+                }
+                auto const stride = stripe * width;
+                for (auto off = 0UL; len > off;) {
+                    auto const [leg, leg_off, sz] = ublkpp::raid0::next_subcmd(
+                        stride, stripe, addr + stride + off, static_cast< uint32_t >(len - off));
+                    for (auto b = 0UL; sz > b; b += 512) {
+                        auto const* const at = placed[std::make_pair(leg, leg_off + b)];
+                        ASSERT_EQ(buf.data() + off + b, at) << width << " " << addr << " " << len;
+                    }
+                    off += sz;
+                }
+            }
+        }
+    }
+}
+
+// Test: scattered input is gathered per leg, joining pieces that meet in memory
+TEST(Raid0Impl, PlanGathersScatteredInput) {
+    auto buf = std::vector< uint8_t >(64 * Ki);
+    // 4 KiB stripes over 2 legs: stripes 0, 2 on leg 0 and 1, 3 on leg 1
+    auto const geo = ublkpp::raid0::geometry{.stripe_shift = 12, .width = 2};
+    auto const iovs = std::array< iovec, 3 >{iovec{.iov_base = buf.data(), .iov_len = 6 * Ki},
+                                             iovec{.iov_base = buf.data() + 6 * Ki, .iov_len = 2 * Ki},
+                                             iovec{.iov_base = buf.data() + 32 * Ki, .iov_len = 8 * Ki}};
+    auto plan = ublkpp::raid0::io_plan();
+    auto src = ublkpp::raid0::iov_cursor{.iov = iovs.data(), .nr_vecs = 3};
+    ASSERT_EQ(16 * Ki, ublkpp::raid0::plan_io(plan, geo, src, 0, 16 * Ki));
+    EXPECT_EQ(0U, src.nr_vecs);
+    ASSERT_EQ(2U, plan.nr_runs);
+    EXPECT_EQ(0U, plan.runs[0].leg);
+    EXPECT_EQ(4 * Ki, plan.runs[0].addr);
+    ASSERT_EQ(2U, plan.runs[0].nr_vecs);
+    EXPECT_EQ(buf.data(), plan.vecs[plan.runs[0].first].iov_base);
+    EXPECT_EQ(buf.data() + 32 * Ki, plan.vecs[plan.runs[0].first + 1].iov_base);
+    EXPECT_EQ(1U, plan.runs[1].leg);
+    ASSERT_EQ(2U, plan.runs[1].nr_vecs);
+    // The seam at 6 KiB falls inside stripe 1 and is joined again
+    EXPECT_EQ(buf.data() + 4 * Ki, plan.vecs[plan.runs[1].first].iov_base);
+    EXPECT_EQ(4 * Ki, plan.vecs[plan.runs[1].first].iov_len);
+    EXPECT_EQ(4 * Ki, plan.vecs[plan.runs[1].first + 1].iov_len);
+}
+
+// Test: a full plan stops early and reports how far it got; a fresh one carries on
+TEST(Raid0Impl, PlanStopsWhenFull) {
+    constexpr auto nr = ublkpp::raid0::k_max_plan_frags + 8;
+    auto buf = std::vector< uint8_t >(2 * nr * 512);
+    auto iovs = std::vector< iovec >();
+    for (auto i = 0U; nr > i; ++i)
+        iovs.push_back(iovec{.iov_base = buf.data() + (2 * i * 512), .iov_len = 512});
+    auto const geo = ublkpp::raid0::geometry{.stripe_shift = 16, .width = 3};
+    auto src = ublkpp::raid0::iov_cursor{.iov = iovs.data(), .nr_vecs = nr};
+    auto plan = ublkpp::raid0::io_plan();
+    EXPECT_EQ(ublkpp::raid0::k_max_plan_frags * 512UL, ublkpp::raid0::plan_io(plan, geo, src, 0, nr * 512));
+    EXPECT_EQ(0UL, ublkpp::raid0::plan_io(plan, geo, src, 0, nr * 512));
+    plan.clear();
+    EXPECT_EQ(8 * 512UL, ublkpp::raid0::plan_io(plan, geo, src, ublkpp::raid0::k_max_plan_frags * 512UL, 8 * 512));
+    EXPECT_EQ(0U, src.nr_vecs);
+}
+
+// Test: discard plans agree with merged_subcmds(), including over many whole strides
+TEST(Raid0Impl, PlanDiscardMatchesMerged) {
+    constexpr uint64_t stripe = 4 * Ki;
+    for (auto width = 1U; 7 >= width; ++width) {
+        auto const geo = ublkpp::raid0::geometry{.stripe_shift = 12, .width = width};
+        auto const stride = stripe * width;
+        for (auto const addr : {0UL, 512UL, 5 * stripe - 512UL, 777 * stripe}) {
+            for (auto const len : {512UL, 3 * stripe + 512UL, 10 * stride, 1000 * stride + 4 * stripe + 1024}) {
+                auto plan = ublkpp::raid0::io_plan();
+                ASSERT_EQ(len, ublkpp::raid0::plan_discard(plan, geo, addr, len));
+                auto const merged = ublkpp::raid0::merged_subcmds(stride, stripe, addr + stride, len);
+                ASSERT_EQ(merged.size(), plan.nr_runs);
+                for (auto const& [leg, off, sz] : pieces_of(plan))
+                    EXPECT_EQ(std::make_pair(off, sz), merged.at(leg)) << width << " " << addr << " " << len;
+            }
+        }
+    }
+}
+
+// Test: weighted discard regions are merged per leg, by walking and in bulk
+TEST(Raid0Impl, PlanWeightedDiscard) {
+    auto const weights = std::array< uint8_t, 2 >{1, 2};
+    auto const map = ublkpp::raid0::make_weighted_map(weights);
+    auto const geo = ublkpp::raid0::geometry{.stripe_shift = 12, .map = &map};
+    // Cycle: leg 1, leg 0, leg 1. Stripes 0-5: leg 1 takes 0, 2, 3, 5; leg 0 takes 1, 4
+    auto plan = ublkpp::raid0::io_plan();
+    ASSERT_EQ(24 * Ki, ublkpp::raid0::plan_discard(plan, geo, 0, 24 * Ki));
+    EXPECT_EQ((std::vector< std::tuple< uint32_t, uint64_t, uint64_t > >{{1, 4 * Ki, 16 * Ki}, {0, 4 * Ki, 8 * Ki}}),
+              pieces_of(plan));
+    // From stripe 1 over 100 cycles and a stripe: leg 0 from row 1, leg 1 from row 2
+    plan.clear();
+    ASSERT_EQ(301 * 4 * Ki, ublkpp::raid0::plan_discard(plan, geo, 4 * Ki, 301 * 4 * Ki));
+    EXPECT_EQ((std::vector< std::tuple< uint32_t, uint64_t, uint64_t > >{{0, 4 * Ki, 101 * 4 * Ki},
+                                                                        {1, 8 * Ki, 200 * 4 * Ki}}),
+              pieces_of(plan));
+}
+
+// Test: a planned write over a weighted layout puts every byte where stripe_walk places its stripe
+TEST(Raid0Impl, PlanMatchesWeightedWalk) {
+    constexpr uint64_t stripe = 4 * Ki;
+    auto const weights = std::array< uint8_t, 3 >{3, 1, 2};
+    auto const map = ublkpp::raid0::make_weighted_map(weights);
+    auto const geo = ublkpp::raid0::geometry{.stripe_shift = 12, .map = &map};
+    auto buf = std::vector< uint8_t >(15 * stripe);
+    for (auto const addr : {0UL, 1536UL, 7 * stripe, 601 * stripe + 512}) {
+        auto plan = ublkpp::raid0::io_plan();
+        auto iov = iovec{.iov_base = buf.data(), .iov_len = 14 * stripe};
+        auto src = ublkpp::raid0::iov_cursor{.iov = &iov, .nr_vecs = 1};
+        ASSERT_EQ(14 * stripe, ublkpp::raid0::plan_io(plan, geo, src, addr, 14 * stripe));
+        ASSERT_EQ(3U, plan.nr_runs);
+        auto placed = std::map< std::pair< uint32_t, uint64_t >, uint8_t const* >();
+        for (auto r = 0U; plan.nr_runs > r; ++r) {
+            auto const& run = plan.runs[r];
+            auto off = run.addr;
+            for (auto v = 0U; run.nr_vecs > v; ++v) {
+                auto const& piece = plan.vecs[run.first + v];
+                for (auto b = 0UL; piece.iov_len > b; b += 512)
+                    placed[std::make_pair(run.leg, off + b)] = static_cast< uint8_t const* >(piece.iov_base) + b;
+                off += piece.iov_len;
+            }
+        }
+        for (auto off = 0UL; 14 * stripe > off;) {
+            auto const walk = ublkpp::raid0::stripe_walk(geo, (addr + off) / stripe);
+            auto const chunk_off = (addr + off) % stripe;
+            auto const sz = std::min(14 * stripe - off, stripe - chunk_off);
+            for (auto b = 0UL; sz > b; b += 512) {
+                auto const* const at = placed[std::make_pair(walk.leg(), walk.leg_offset() + chunk_off + b)];
+                ASSERT_EQ(buf.data() + off + b, at) << addr;
+            }
+            off += sz;
+        }
+    }
+}
+
+// Test: wide arrays of small stripes are planned in one round, whatever the width
+TEST(Raid0Impl, WidePlanMatchesNextSubcmd) {
+    constexpr uint64_t stripe = 4 * Ki;
+    constexpr auto cap = ublkpp::raid0::wide_io_plan::k_capacity;
+    auto buf = std::vector< uint8_t >(cap * stripe);
+    for (auto const width : {2U, 65U, 128U, 200U, 256U}) {
+        auto const geo = ublkpp::raid0::geometry{.stripe_shift = 12, .width = width};
+        auto const stride = stripe * width;
+        // Up to cap - 1 stripes from an unaligned start: as many pieces as the plan holds
+        for (auto const& [addr, len] : {std::pair{0UL, cap * stripe}, std::pair{512UL, (cap - 1) * stripe},
+                                       std::pair{999 * stripe + 1024, 100 * stripe}}) {
+            auto plan = std::make_unique< ublkpp::raid0::wide_io_plan >();
+            auto iov = iovec{.iov_base = buf.data(), .iov_len = len};
+            auto src = ublkpp::raid0::iov_cursor{.iov = &iov, .nr_vecs = 1};
+            ASSERT_EQ(len, ublkpp::raid0::plan_io(*plan, geo, src, addr, len)) << width;
+            ASSERT_EQ(std::min< uint64_t >(width, (len + (addr % stripe) + stripe - 1) / stripe), plan->nr_runs);
+            auto placed = std::map< std::pair< uint32_t, uint64_t >, uint8_t const* >();
+            for (auto r = 0U; plan->nr_runs > r; ++r) {
+                auto const& run = plan->runs[r];
+                auto off = run.addr;
+                for (auto v = 0U; run.nr_vecs > v; ++v) {
+                    auto const& piece = plan->vecs[run.first + v];
+                    placed[std::make_pair(static_cast< uint32_t >(run.leg), off)] =
+                        static_cast< uint8_t const* >(piece.iov_base);
+                    off += piece.iov_len;
+                }
+            }
+            for (auto off = 0UL; len > off;) {
+                auto const [leg, leg_off, sz] = ublkpp::raid0::next_subcmd(stride, stripe, addr + stride + off,
+                                                                           static_cast< uint32_t >(len - off));
+                auto const* const at = placed[std::make_pair(leg, leg_off)];
+                ASSERT_EQ(buf.data() + off, at) << width << " " << addr << " " << len;
+                off += sz;
+            }
+        }
+    }
+}
+
+// Test: a discard over every leg of the widest array is one run per leg
+TEST(Raid0Impl, WideDiscardMatchesMerged) {
+    constexpr uint64_t stripe = 4 * Ki;
+    for (auto const width : {65U, 256U}) {
+        auto const geo = ublkpp::raid0::geometry{.stripe_shift = 12, .width = width};
+        auto const stride = stripe * width;
+        for (auto const& [addr, len] :
+             {std::pair{0UL, stride}, std::pair{3 * stripe + 512, 40 * stride + 7 * stripe}}) {
+            auto plan = std::make_unique< ublkpp::raid0::wide_io_plan >();
+            ASSERT_EQ(len, ublkpp::raid0::plan_discard(*plan, geo, addr, len));
+            auto const merged = ublkpp::raid0::merged_subcmds(stride, stripe, addr + stride, len);
+            ASSERT_EQ(width, plan->nr_runs);
+            ASSERT_EQ(merged.size(), plan->nr_runs);
+            for (auto const& [leg, off, sz] : pieces_of(*plan))
+                EXPECT_EQ(std::make_pair(off, sz), merged.at(leg)) << width << " " << addr << " " << len;
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include "mem_raid0_common.hpp"
+
+#include "raid/tests/raid_test_common.hpp"
+#include "tests/mock_ublksrv/mock_ublksrv.hpp"
+
+using ::ublkpp::test::make_async_iov_action;
+
+// Async I/O below the restripe cursor uses the wide layout and I/O above it the old one
+TEST(Raid0Reshape, AsyncFollowsCursor) {
+    auto legs = make_legs(2);
+    auto raid = make_array(legs);
+    fill_array(*raid, raid->capacity());
+
+    // Restriping 2 -> 3 legs moves stripes in windows [0,3), [3,4), [4,6), [6,9); reading stripe 8
+    // (leg A, data row 5) fails, so the cursor stays at stripe 6.
+    *legs[0].fail_from = 5 * k_stripe;
+    auto added = make_legs(1, 'C');
+    ASSERT_TRUE(ublkpp::raid0::expand(*raid, handles_of(added)));
+    ASSERT_TRUE(wait_failed(legs[0]));
+    legs.insert(legs.end(), added.begin(), added.end());
+    ASSERT_EQ(raid->capacity() - 6 * k_stripe, ublkpp::raid0::reshape_remaining(*raid));
+
+    for (auto const& leg : legs)
+        ON_CALL(*leg.disk, submit_iov(_, _, _, _, _)).WillByDefault(make_async_iov_action());
+    auto mock = std::make_unique< ublkpp::MockUblksrv >(raid);
+
+    {
+        // Stripe 4 moved to leg B, data row 2
+        EXPECT_CALL(*legs[0].disk, submit_iov(_, _, _, _, _)).Times(0);
+        EXPECT_CALL(*legs[1].disk, submit_iov(_, _, _, _, 2 * k_stripe)).Times(1);
+        EXPECT_CALL(*legs[2].disk, submit_iov(_, _, _, _, _)).Times(0);
+        auto res = mock->submit_io(0, UBLK_IO_OP_WRITE, 4 * k_stripe >> 9, 4 * Ki >> 9, nullptr);
+        ASSERT_TRUE(res);
+        EXPECT_EQ(1U, res.value());
+        auto completions = mock->inject_cqe(0, 4 * Ki);
+        ASSERT_EQ(1U, completions.size());
+        EXPECT_EQ(4 * Ki, completions[0].result);
+        ::testing::Mock::VerifyAndClearExpectations(legs[1].disk.get());
+    }
+    {
+        // Stripe 8 has not moved yet: still leg A, data row 5, not leg C, data row 3
+        EXPECT_CALL(*legs[0].disk, submit_iov(_, _, _, _, 5 * k_stripe)).Times(1);
+        EXPECT_CALL(*legs[1].disk, submit_iov(_, _, _, _, _)).Times(0);
+        EXPECT_CALL(*legs[2].disk, submit_iov(_, _, _, _, _)).Times(0);
+        auto res = mock->submit_io(0, UBLK_IO_OP_READ, 8 * k_stripe >> 9, 4 * Ki >> 9, nullptr);
+        ASSERT_TRUE(res);
+        EXPECT_EQ(1U, res.value());
+        auto completions = mock->inject_cqe(0, 4 * Ki);
+        ASSERT_EQ(1U, completions.size());
+        EXPECT_EQ(4 * Ki, completions[0].result);
+    }
+    mock.reset();
+}
+
+// An I/O another queue took over (--steal_io) that spills into a pool of its own keeps its home
+// queue there: a leg failing is completed on that queue, not on the one serving the I/O.
+TEST(Raid0Reshape, SpillKeepsHomeQueue) {
+    auto legs = make_legs(2);
+    auto raid = make_array(legs);
+    fill_array(*raid, raid->capacity());
+
+    // Every leg holds on to its child I/O, to be completed below
+    auto children = std::vector< ublk_io_data const* >();
+    auto added = make_legs(1, 'C');
+    legs.insert(legs.end(), added.begin(), added.end());
+    for (auto const& leg : legs)
+        ON_CALL(*leg.disk, submit_iov(_, _, _, _, _))
+            .WillByDefault([&children](ublksrv_queue const*, ublk_io_data const* data, iovec*, uint32_t,
+                                       uint64_t) -> io_result {
+                children.push_back(data);
+                return 1;
+            });
+    // The queues size their pools for two legs, one fewer than a full row of three
+    auto mock = std::make_unique< ublkpp::MockUblksrv >(raid, 128, 2);
+
+    // As in AsyncFollowsCursor, the restripe stops with the cursor at stripe 6
+    *legs[0].fail_from = 5 * k_stripe;
+    ASSERT_TRUE(ublkpp::raid0::expand(*raid, handles_of(added)));
+    ASSERT_TRUE(wait_failed(legs[0]));
+
+    // Tag 0 belongs to queue 1 but is served on queue 0
+    mock->io_state(0)._home = mock->queue(1);
+    ASSERT_TRUE(mock->submit_io(0, UBLK_IO_OP_READ, 0, 3 * k_stripe >> 9, mock->io_buf(0)));
+    ASSERT_EQ(3U, children.size());
+    auto* spill = reinterpret_cast< ublkpp::async_io* >(children[0]->private_data);
+    ASSERT_NE(&mock->io_state(0), spill);
+    EXPECT_EQ(mock->queue(1), spill->_home);
+    EXPECT_EQ(0, spill->_tag);
+    ASSERT_EQ(3U, spill->_pool.size());
+
+    // Leg B fails; fail_io() would complete the I/O on the _home of the state's owner. The last
+    // resume ends the I/O, and the spill pool with it.
+    for (auto i = 0U; 3U > i; ++i) {
+        auto& state = spill->_pool[i];
+        EXPECT_EQ(mock->queue(1), state._owner->_home);
+        state._result = (1 == i) ? -EIO : static_cast< int >(k_stripe);
+        state._result_ready = true;
+        std::exchange(state._waiter, {}).resume();
+    }
+    auto completions = mock->inject_cqe(0, 0);
+    ASSERT_EQ(1U, completions.size());
+    EXPECT_EQ(-EIO, completions[0].result);
+    mock.reset();
+}
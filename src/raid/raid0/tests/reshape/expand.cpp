@@ -0,0 +1,158 @@
+#include "mem_raid0_common.hpp"
+
+#include <random>
+
+// Adding legs restripes everything onto them; the data reads back the same throughout
+TEST(Raid0Reshape, ExpandRestripes) {
+    auto legs = make_legs(2);
+    auto raid = make_array(legs);
+    auto const capacity = raid->capacity();
+    fill_array(*raid, capacity);
+
+    auto added = make_legs(2, 'C');
+    ASSERT_TRUE(ublkpp::raid0::expand(*raid, handles_of(added)));
+    ASSERT_TRUE(wait_reshaped(*raid));
+    legs.insert(legs.end(), added.begin(), added.end());
+
+    // The array only grows on the next assembly
+    EXPECT_EQ(capacity, raid->capacity());
+    expect_contents(*raid, pattern(capacity));
+    EXPECT_EQ(legs[3].disk, ublkpp::raid0::get_device(*raid, 3));
+
+    // Stripe 7 now lives on leg 3, second data row; it was on leg 1, fourth data row
+    EXPECT_EQ(0, memcmp(legs[3].data->data() + 2 * k_stripe, pattern(8 * k_stripe).data() + 7 * k_stripe, k_stripe));
+    for (auto const& leg : legs) {
+        auto const sb = read_sb(leg);
+        EXPECT_EQ(ublkpp::raid0::k_sb_version, be16toh(sb.header.version));
+        EXPECT_EQ(4, be16toh(sb.fields.width));
+        EXPECT_EQ(4, be16toh(sb.fields.old_width));
+    }
+}
+
+// Writes racing the restripe land in whichever layout their stripes are in at the time
+TEST(Raid0Reshape, ExpandUnderWrites) {
+    auto legs = make_legs(3);
+    auto raid = make_array(legs);
+    auto const capacity = raid->capacity();
+    fill_array(*raid, capacity);
+    auto expected = pattern(capacity);
+
+    ASSERT_TRUE(ublkpp::raid0::expand(*raid, handles_of(make_legs(2, 'D'))));
+    auto rng = std::mt19937_64(42);
+    auto buf = std::vector< uint8_t >(128 * Ki);
+    auto writes = 0U;
+    while (0 < ublkpp::raid0::reshape_remaining(*raid) || 64 > writes) {
+        auto const len = (1 + rng() % (buf.size() / 4 / Ki)) * 4 * Ki;
+        auto const off = (rng() % ((capacity - len) / (4 * Ki))) * 4 * Ki;
+        for (auto i = 0UL; len > i; ++i)
+            buf[i] = static_cast< uint8_t >(rng());
+        ASSERT_TRUE(array_io(*raid, UBLK_IO_OP_WRITE, buf.data(), len, off));
+        memcpy(expected.data() + off, buf.data(), len);
+        ++writes;
+    }
+    ASSERT_TRUE(wait_reshaped(*raid));
+    expect_contents(*raid, expected);
+}
+
+// An interrupted restripe resumes where its superblocks say it got to when next assembled
+TEST(Raid0Reshape, ResumeAfterRestart) {
+    auto legs = make_legs(2);
+    auto raid = make_array(legs);
+    auto const capacity = raid->capacity();
+    fill_array(*raid, capacity);
+
+    // Leg A fails reads from data row 21 on (stripe 40), part way into the array
+    *legs[0].fail_from = 21 * k_stripe;
+    auto added = make_legs(1, 'C');
+    ASSERT_TRUE(ublkpp::raid0::expand(*raid, handles_of(added)));
+    ASSERT_TRUE(wait_failed(legs[0]));
+    legs.insert(legs.end(), added.begin(), added.end());
+    // Stopped, not finished: a second expansion has to wait
+    EXPECT_LT(0UL, ublkpp::raid0::reshape_remaining(*raid));
+    EXPECT_FALSE(ublkpp::raid0::expand(*raid, handles_of(make_legs(1, 'D'))));
+    raid.reset();
+
+    auto const sb = read_sb(legs[2]);
+    EXPECT_EQ(3, be16toh(sb.fields.width));
+    EXPECT_EQ(2, be16toh(sb.fields.old_width));
+    auto const pos = be64toh(sb.fields.reshape_pos);
+    EXPECT_LT(0UL, pos);
+    EXPECT_GT(40 * k_stripe, pos);
+
+    // Without the added leg the array cannot be put back together
+    EXPECT_THROW(make_array({legs[0], legs[1]}), std::runtime_error);
+
+    *legs[0].fail_from = UINT64_MAX;
+    raid = make_array(legs);
+    EXPECT_EQ(capacity, raid->capacity());
+    ASSERT_TRUE(wait_reshaped(*raid));
+    expect_contents(*raid, pattern(capacity));
+}
+
+// Once restriped the next assembly spans every leg
+TEST(Raid0Reshape, CapacityGrowsOnReassembly) {
+    auto legs = make_legs(2);
+    auto raid = make_array(legs);
+    auto const capacity = raid->capacity();
+    fill_array(*raid, capacity);
+
+    auto added = make_legs(2, 'C');
+    ASSERT_TRUE(ublkpp::raid0::expand(*raid, handles_of(added)));
+    ASSERT_TRUE(wait_reshaped(*raid));
+    legs.insert(legs.end(), added.begin(), added.end());
+    raid.reset();
+
+    raid = make_array(legs);
+    EXPECT_LT(capacity, raid->capacity());
+    EXPECT_EQ(0UL, ublkpp::raid0::reshape_remaining(*raid));
+    auto expected = pattern(raid->capacity());
+    expect_contents(*raid, std::vector< uint8_t >(expected.begin(), expected.begin() + capacity));
+    fill_array(*raid, raid->capacity(), 7);
+    expect_contents(*raid, pattern(raid->capacity(), 7));
+}
+
+TEST(Raid0Reshape, RefusesBadLegs) {
+    auto legs = make_legs(2);
+    auto raid = make_array(legs);
+
+    EXPECT_FALSE(ublkpp::raid0::expand(*raid, {}));
+    // Smaller than the legs already there
+    EXPECT_FALSE(ublkpp::raid0::expand(*raid, {make_leg("DiskC", k_leg_capacity / 2).disk}));
+    // Cannot take the I/O size the array advertises
+    auto const small_tx = std::make_shared< NiceMock< ublkpp::TestDisk > >(
+        TestParams{.capacity = k_leg_capacity, .id = "DiskC", .max_io = 64 * Ki});
+    EXPECT_FALSE(ublkpp::raid0::expand(*raid, {small_tx}));
+    // Cannot discard while the array does
+    auto const no_discard = std::make_shared< NiceMock< ublkpp::TestDisk > >(
+        TestParams{.capacity = k_leg_capacity, .id = "DiskC", .can_discard = false});
+    EXPECT_FALSE(ublkpp::raid0::expand(*raid, {no_discard}));
+    // Not a RAID0 array
+    EXPECT_FALSE(ublkpp::raid0::expand(*legs[0].disk, handles_of(make_legs(1, 'C'))));
+    EXPECT_EQ(0UL, ublkpp::raid0::reshape_remaining(*legs[0].disk));
+
+    // Nothing changed
+    EXPECT_EQ(nullptr, ublkpp::raid0::get_device(*raid, 2));
+    EXPECT_EQ(2, be16toh(read_sb(legs[0]).fields.width));
+}
+
+// Superblocks from before the width was recorded take it from the array being assembled
+TEST(Raid0Reshape, MigratesV1Superblocks) {
+    auto legs = make_legs(2);
+    for (auto i = 0U; legs.size() > i; ++i) {
+        auto sb = normal_superblock;
+        sb.header.version = htobe16(1);
+        sb.fields.stripe_off = htobe16(static_cast< uint16_t >(i));
+        sb.fields.stripe_size = htobe32(k_stripe);
+        sb.fields.width = 0;
+        sb.fields.old_width = 0;
+        memcpy(legs[i].data->data(), &sb, sizeof(sb));
+    }
+    auto raid = make_array(legs);
+    for (auto const& leg : legs) {
+        auto const sb = read_sb(leg);
+        EXPECT_EQ(ublkpp::raid0::k_sb_version, be16toh(sb.header.version));
+        EXPECT_EQ(2, be16toh(sb.fields.width));
+        EXPECT_EQ(2, be16toh(sb.fields.old_width));
+    }
+    EXPECT_EQ(0UL, ublkpp::raid0::reshape_remaining(*raid));
+}
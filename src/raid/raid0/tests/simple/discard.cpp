@@ -1,7 +1,7 @@
 #include "test_raid0_common.hpp"
 
 // Verifies that Raid0Disk::prepare() sizes the CQE pool for the DISCARD fan-out of N disks,
-// not the read/write fan-out k = stripes_for_io(max_tx, stripe_size, N).
+// not the read/write fan-out k = min(ceil(max_tx / stripe_size) + 1, N).
 //
 // With stripe_size=128 KiB and max_tx=512 KiB, k = min((512/128)+1, N) = min(5, N).
 // For N=10: k=5 < N=10. Before the fix, prepare() accumulated only 5 children's
@@ -12,3 +12,18 @@ TEST(Raid0, GetDevice) {
     EXPECT_TRUE(ublkpp::raid0::get_device(*raid_device, 2) == device_c);
     EXPECT_FALSE(ublkpp::raid0::get_device(*raid_device, 3));
 }
+
+// The array merges scattered requests only when every leg does
+TEST(Raid0, ScatterGatherFollowsLegs) {
+    auto device_a = CREATE_DISK(TestParams{.capacity = Gi, .scatter_gather = true});
+    auto device_b = CREATE_DISK(TestParams{.capacity = Gi, .scatter_gather = true});
+    auto raid_device = ublkpp::make_raid0_disk(boost::uuids::random_generator()(), 32 * Ki,
+                                               std::vector< std::shared_ptr< ublk_disk > >{device_a, device_b});
+    EXPECT_TRUE(raid_device->scatter_gather());
+
+    auto device_c = CREATE_DISK(TestParams{.capacity = Gi, .scatter_gather = true});
+    auto device_d = CREATE_DISK(TestParams{.capacity = Gi});
+    auto mixed = ublkpp::make_raid0_disk(boost::uuids::random_generator()(), 32 * Ki,
+                                         std::vector< std::shared_ptr< ublk_disk > >{device_c, device_d});
+    EXPECT_FALSE(mixed->scatter_gather());
+}
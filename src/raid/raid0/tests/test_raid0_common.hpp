@@ -20,13 +20,18 @@ using ::ublkpp::ublk_disk;
 // This RAID0 header is copied to simulate loading a previous clean device
 static const ublkpp::raid0::SuperBlock normal_superblock =
     {.header = {.magic = {0127, 0345, 072, 0211, 0254, 033, 070, 0146, 0125, 0377, 0204, 065, 0131, 0120, 0306, 047},
-                .version = htobe16(1),
+                .version = htobe16(3),
                 .uuid = {0xad, 0xa4, 0x07, 0x37, 0x30, 0xe3, 0x49, 0xfe, 0x99, 0x42, 0x5a, 0x28, 0x7d, 0x71, 0xeb,
                          0x3f}},
      .fields =
          {
              .stripe_off = 0,
              .stripe_size = htobe32(128 * Ki),
+             .width = htobe16(2),
+             .old_width = htobe16(2),
+             .reshape_pos = 0,
+             .age = 0,
+             .weights = {0},
          },
      ._reserved = {0x00}};
 
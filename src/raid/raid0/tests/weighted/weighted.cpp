@@ -0,0 +1,121 @@
+#include "mem_raid0_common.hpp"
+
+#include "raid/tests/raid_test_common.hpp"
+#include "tests/mock_ublksrv/mock_ublksrv.hpp"
+
+using ::ublkpp::test::make_async_iov_action;
+
+// A 4 MiB and an 8 MiB leg: weights 1:2 use all but the superblock stripes
+static std::vector< mem_leg > uneven_legs() { return {make_leg("DiskA", 4 * Mi), make_leg("DiskB", 8 * Mi)}; }
+
+TEST(Raid0Weighted, WeightsByCapacity) {
+    auto legs = uneven_legs();
+    EXPECT_EQ((std::vector< uint32_t >{1, 2}), ublkpp::raid0::weights_by_capacity(handles_of(legs), k_stripe));
+    EXPECT_EQ((std::vector< uint32_t >{1, 1}), ublkpp::raid0::weights_by_capacity(handles_of(make_legs(2)), k_stripe));
+    EXPECT_TRUE(ublkpp::raid0::weights_by_capacity(handles_of(make_legs(1)), k_stripe).empty());
+}
+
+// The larger leg takes twice the stripes, so the array spans (nearly) all of both legs
+TEST(Raid0Weighted, UsesEveryLeg) {
+    auto legs = uneven_legs();
+    auto raid = make_array(legs, {1, 2});
+    // Plain round-robin would stop at twice the smaller leg (254 stripes)
+    EXPECT_LT(254 * k_stripe, raid->capacity());
+    EXPECT_GE(381 * k_stripe, raid->capacity());
+    // One leg may take a whole I/O
+    EXPECT_GE(legs[0].disk->max_tx(), raid->max_tx());
+
+    auto const capacity = raid->capacity();
+    fill_array(*raid, capacity);
+    expect_contents(*raid, pattern(capacity));
+
+    // Cycle of 3: leg B, leg A, leg B; each leg's stripes fill its rows in order
+    auto const expected = pattern(6 * k_stripe);
+    EXPECT_EQ(0, memcmp(legs[1].data->data() + 1 * k_stripe, expected.data() + 0 * k_stripe, k_stripe));
+    EXPECT_EQ(0, memcmp(legs[0].data->data() + 1 * k_stripe, expected.data() + 1 * k_stripe, k_stripe));
+    EXPECT_EQ(0, memcmp(legs[1].data->data() + 2 * k_stripe, expected.data() + 2 * k_stripe, k_stripe));
+    EXPECT_EQ(0, memcmp(legs[1].data->data() + 3 * k_stripe, expected.data() + 3 * k_stripe, k_stripe));
+    EXPECT_EQ(0, memcmp(legs[0].data->data() + 2 * k_stripe, expected.data() + 4 * k_stripe, k_stripe));
+}
+
+// The weights are recorded; later assemblies keep them whatever they are given
+TEST(Raid0Weighted, RecordedInSuperblock) {
+    auto legs = uneven_legs();
+    auto raid = make_array(legs, {2, 4});
+    auto const capacity = raid->capacity();
+    fill_array(*raid, capacity);
+    for (auto const& leg : legs) {
+        auto const sb = read_sb(leg);
+        EXPECT_EQ(ublkpp::raid0::k_sb_version, be16toh(sb.header.version));
+        EXPECT_EQ(2, sb.fields.weights[0]);
+        EXPECT_EQ(4, sb.fields.weights[1]);
+    }
+    // Weighted arrays keep their layout: no expansion
+    EXPECT_FALSE(ublkpp::raid0::expand(*raid, handles_of(make_legs(1, 'C'))));
+    raid.reset();
+
+    for (auto const& weights : {std::vector< uint32_t >{}, std::vector< uint32_t >{1, 1}}) {
+        raid = make_array(legs, weights);
+        EXPECT_EQ(capacity, raid->capacity());
+        expect_contents(*raid, pattern(capacity));
+        raid.reset();
+    }
+}
+
+// Equal weights are the plain layout and are not recorded
+TEST(Raid0Weighted, EqualWeightsArePlain) {
+    auto legs = make_legs(2);
+    auto raid = make_array(legs, {3, 3});
+    EXPECT_EQ(0, read_sb(legs[0]).fields.weights[0]);
+    EXPECT_TRUE(ublkpp::raid0::expand(*raid, handles_of(make_legs(1, 'C'))));
+    EXPECT_TRUE(wait_reshaped(*raid));
+}
+
+TEST(Raid0Weighted, BadWeights) {
+    for (auto const& weights : {std::vector< uint32_t >{1}, std::vector< uint32_t >{1, 0},
+                                std::vector< uint32_t >{1, 256}, std::vector< uint32_t >{200, 57}}) {
+        auto legs = make_legs(2);
+        EXPECT_THROW(make_array(legs, weights), std::invalid_argument);
+    }
+}
+
+// Each leg gets a single task per I/O, its stripes gathered at consecutive offsets
+TEST(Raid0Weighted, AsyncOneTaskPerLeg) {
+    auto legs = uneven_legs();
+    auto raid = make_array(legs, {1, 2});
+    for (auto const& leg : legs)
+        ON_CALL(*leg.disk, submit_iov(_, _, _, _, _)).WillByDefault(make_async_iov_action());
+    auto mock = std::make_unique< ublkpp::MockUblksrv >(raid);
+
+    {
+        // Stripes 0 and 2 on leg B rows 1-2, stripe 1 on leg A row 1
+        EXPECT_CALL(*legs[0].disk, submit_iov(_, _, _, 1, k_stripe)).Times(1);
+        EXPECT_CALL(*legs[1].disk, submit_iov(_, _, _, 2, k_stripe)).Times(1);
+        auto res = mock->submit_io(0, UBLK_IO_OP_WRITE, 0, 3 * k_stripe >> 9, nullptr);
+        ASSERT_TRUE(res);
+        EXPECT_EQ(2U, res.value());
+        EXPECT_TRUE(mock->inject_cqe(0, k_stripe).empty());
+        auto completions = mock->inject_cqe(0, 2 * k_stripe);
+        ASSERT_EQ(1U, completions.size());
+        EXPECT_EQ(3 * k_stripe, completions[0].result);
+    }
+    {
+        // Discard of the second cycle: leg B rows 3-4, leg A row 2
+        EXPECT_CALL(*legs[0].disk, submit_iov(_, _, _, 1, 2 * k_stripe))
+            .WillOnce([](ublksrv_queue const*, ublk_io_data const*, iovec* iov, uint32_t, uint64_t) -> io_result {
+                EXPECT_EQ(k_stripe, iov->iov_len);
+                return 1;
+            });
+        EXPECT_CALL(*legs[1].disk, submit_iov(_, _, _, 1, 3 * k_stripe))
+            .WillOnce([](ublksrv_queue const*, ublk_io_data const*, iovec* iov, uint32_t, uint64_t) -> io_result {
+                EXPECT_EQ(2 * k_stripe, iov->iov_len);
+                return 1;
+            });
+        auto res = mock->submit_io(1, UBLK_IO_OP_DISCARD, 3 * k_stripe >> 9, 3 * k_stripe >> 9, nullptr);
+        ASSERT_TRUE(res);
+        EXPECT_TRUE(mock->inject_cqe(1, k_stripe).empty());
+        auto completions = mock->inject_cqe(1, 2 * k_stripe);
+        ASSERT_EQ(1U, completions.size());
+    }
+    mock.reset();
+}
@@ -0,0 +1,99 @@
+#include "mem_raid0_common.hpp"
+
+#include "raid/tests/raid_test_common.hpp"
+#include "tests/mock_ublksrv/mock_ublksrv.hpp"
+
+using ::ublkpp::test::make_async_iov_action;
+
+constexpr uint32_t k_small_stripe = 4 * Ki;
+
+// `width` legs of 16 small stripes each, one of which holds the superblock
+static std::vector< mem_leg > small_legs(uint32_t width) {
+    auto legs = std::vector< mem_leg >();
+    for (auto i = 0U; width > i; ++i)
+        legs.push_back(make_leg(fmt::format("Disk{}", i), 16 * k_small_stripe));
+    return legs;
+}
+
+static std::shared_ptr< ublk_disk > make_small_array(std::vector< mem_leg > const& legs) {
+    return ublkpp::make_raid0_disk(boost::uuids::string_generator()(test_uuid), k_small_stripe, handles_of(legs));
+}
+
+// Well past 64 legs, with stripes small enough that a full-size I/O spans hundreds of them
+TEST(Raid0Wide, DataPlacement) {
+    for (auto const width : {128U, 256U}) {
+        auto legs = small_legs(width);
+        auto raid = make_small_array(legs);
+        // Every stripe of an I/O, plus an unaligned start, fits a single plan
+        EXPECT_GE((ublkpp::raid0::k_max_wide_frags - 1) * k_small_stripe, raid->max_tx());
+        EXPECT_GE(15UL * width * k_small_stripe, raid->capacity());
+
+        auto const capacity = raid->capacity();
+        fill_array(*raid, capacity);
+        expect_contents(*raid, pattern(capacity));
+        // Stripe i sits on leg i % width, in row i / width after the superblock
+        auto const expected = pattern(capacity);
+        for (auto const idx : {0U, width - 1, width + 5, 5 * width + width / 2}) {
+            ASSERT_GT(capacity, (idx + 1) * k_small_stripe);
+            EXPECT_EQ(0,
+                      memcmp(legs[idx % width].data->data() + (idx / width + 1) * k_small_stripe,
+                             expected.data() + idx * k_small_stripe, k_small_stripe))
+                << width << " " << idx;
+        }
+    }
+}
+
+TEST(Raid0Wide, Limits) {
+    EXPECT_THROW(make_small_array(small_legs(ublkpp::raid0::k_max_legs + 1)), std::invalid_argument);
+    // The superblock records weights for the first 64 legs only
+    auto legs = small_legs(ublkpp::raid0::k_max_weighted_legs + 1);
+    EXPECT_TRUE(ublkpp::raid0::weights_by_capacity(handles_of(legs), k_small_stripe).empty());
+    EXPECT_THROW(ublkpp::make_raid0_disk(boost::uuids::string_generator()(test_uuid), k_small_stripe,
+                                         handles_of(legs), std::vector< uint32_t >(legs.size(), 1)),
+                 std::invalid_argument);
+}
+
+// A discard over every leg of a wide array goes out in one round, a task per leg
+TEST(Raid0Wide, AsyncDiscardEveryLeg) {
+    constexpr auto width = 128U;
+    auto legs = small_legs(width);
+    auto raid = make_small_array(legs);
+    for (auto const& leg : legs) {
+        ON_CALL(*leg.disk, submit_iov(_, _, _, _, _)).WillByDefault(make_async_iov_action());
+        EXPECT_CALL(*leg.disk, submit_iov(_, _, _, 1, 2 * k_small_stripe)).Times(1);
+    }
+    auto mock = std::make_unique< ublkpp::MockUblksrv >(raid);
+
+    // The second row, whole
+    auto const row = width * k_small_stripe;
+    auto res = mock->submit_io(0, UBLK_IO_OP_DISCARD, row >> 9, row >> 9, nullptr);
+    ASSERT_TRUE(res);
+    EXPECT_EQ(width, res.value());
+    for (auto i = 1U; width > i; ++i)
+        EXPECT_TRUE(mock->inject_cqe(0, k_small_stripe).empty());
+    auto completions = mock->inject_cqe(0, k_small_stripe);
+    ASSERT_EQ(1U, completions.size());
+    EXPECT_EQ(row, completions[0].result);
+    mock.reset();
+}
+
+// A narrow array of small stripes gathers many stripes per leg into one task
+TEST(Raid0Wide, AsyncSmallStripes) {
+    auto legs = small_legs(4);
+    auto raid = make_small_array(legs);
+    // 40 stripes from the start: ten on every leg, from row 1
+    for (auto const& leg : legs) {
+        ON_CALL(*leg.disk, submit_iov(_, _, _, _, _)).WillByDefault(make_async_iov_action());
+        EXPECT_CALL(*leg.disk, submit_iov(_, _, _, 10, k_small_stripe)).Times(1);
+    }
+    auto mock = std::make_unique< ublkpp::MockUblksrv >(raid);
+    auto res = mock->submit_io(0, UBLK_IO_OP_WRITE, 0, 40 * k_small_stripe >> 9, nullptr);
+    ASSERT_TRUE(res);
+    EXPECT_EQ(4U, res.value());
+    for (auto i = 1U; 4 > i; ++i)
+        EXPECT_TRUE(mock->inject_cqe(0, 10 * k_small_stripe).empty());
+    auto completions = mock->inject_cqe(0, 10 * k_small_stripe);
+    ASSERT_EQ(1U, completions.size());
+    EXPECT_EQ(40 * k_small_stripe, completions[0].result);
+    mock.reset();
+}
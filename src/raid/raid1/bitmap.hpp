@@ -74,6 +74,7 @@ public:
            std::string const& id = "");
 
     static uint64_t page_size() noexcept;
+    uint32_t chunk_size() const noexcept { return _chunk_size; }
     size_t dirty_pages() noexcept;
     uint64_t dirty_data_est() const noexcept;
 
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "lib/logging.hpp"
+
+namespace ublkpp::raid1 {
+
+// Lock-free bounded set of chunk-aligned regions the I/O path asked the resync task to repair
+// ahead of its LBA-ordered sweep. Producers are the queue threads (a degraded read or write that
+// hit a dirty region); the single consumer is the resync thread.
+//
+// Slot layout — single atomic uint64_t holding a chunk index, UINT64_MAX when free.
+//
+// push() never blocks and never allocates: a full queue or an already-queued chunk simply drops
+// the hint, since the sweep will reach the region anyway. Two producers racing on the same chunk
+// may both claim a slot; the consumer then repairs it once and finds it clean the second time.
+class HotRegionQueue {
+public:
+    static constexpr uint64_t k_free = std::numeric_limits< uint64_t >::max();
+
+    explicit HotRegionQueue(uint32_t max_slots, uint32_t chunk_size) : _slots(max_slots), _chunk_size(chunk_size) {
+        DEBUG_ASSERT(max_slots > 0, "HotRegionQueue requires at least one slot");
+        DEBUG_ASSERT(chunk_size > 0, "HotRegionQueue chunk_size must be non-zero");
+    }
+
+    // Queue the chunk containing lba. Returns true if a new slot was claimed.
+    bool push(uint64_t lba) noexcept {
+        auto const chunk = lba / _chunk_size;
+        auto const start = chunk % _slots.size();
+        for (size_t i = 0; i < _slots.size(); ++i) {
+            auto& slot = _slots[(start + i) % _slots.size()].chunk;
+            auto cur = slot.load(std::memory_order_relaxed);
+            if (chunk == cur) return false;
+            if (k_free != cur) continue;
+            if (slot.compare_exchange_strong(cur, chunk, std::memory_order_release, std::memory_order_relaxed)) {
+                _queued.fetch_add(1, std::memory_order_release);
+                return true;
+            }
+            if (chunk == cur) return false;
+        }
+        return false;
+    }
+
+    // Queue every chunk [lba, lba+len) touches, so a large I/O is repaired ahead of the sweep in
+    // full rather than only its first chunk. At most one pass over the slots: a range wider than the
+    // queue keeps its leading chunks. Returns the number of new slots claimed.
+    uint32_t push_range(uint64_t lba, uint32_t len) noexcept {
+        auto const first = lba / _chunk_size;
+        auto const last = (lba + std::max(len, 1U) - 1) / _chunk_size;
+        auto claimed = uint32_t{0};
+        for (auto chunk = first; last >= chunk && _slots.size() > chunk - first; ++chunk)
+            if (push(chunk * _chunk_size)) ++claimed;
+        return claimed;
+    }
+
+    // Remove and return the byte offset of one queued chunk. Single consumer only.
+    std::optional< uint64_t > pop() noexcept {
+        if (empty()) return std::nullopt;
+        for (size_t i = 0; i < _slots.size(); ++i) {
+            auto& slot = _slots[(_cursor + i) % _slots.size()].chunk;
+            auto const chunk = slot.exchange(k_free, std::memory_order_acq_rel);
+            if (k_free == chunk) continue;
+            _cursor = (_cursor + i + 1) % _slots.size();
+            _queued.fetch_sub(1, std::memory_order_relaxed);
+            return chunk * _chunk_size;
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return 0 == _queued.load(std::memory_order_acquire); }
+    [[nodiscard]] uint32_t chunk_size() const noexcept { return _chunk_size; }
+
+private:
+    struct Slot {
+        std::atomic< uint64_t > chunk{k_free};
+    };
+
+    std::vector< Slot > _slots;
+    std::atomic< uint32_t > _queued{0};
+    uint32_t const _chunk_size;
+    // Consumer-only scan position; rotates so a producer that keeps re-queuing one chunk
+    // cannot starve the others.
+    size_t _cursor{0};
+};
+
+} // namespace ublkpp::raid1
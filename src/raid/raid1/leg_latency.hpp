@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace ublkpp::raid1 {
+
+// Per-leg fail-slow detector. Every timed I/O on a leg feeds an integer EWMA (alpha = 1/8); the leg
+// trips SLOW once the average is at or above the threshold and the last k_trip_samples samples were
+// all over it, so a single stalled request cannot demote a healthy device. It recovers once the
+// average falls below half the threshold. Either way it first holds its state for a minimum dwell
+// (the slow_dwell option, k_default_dwell_ns unless set), so a leg hovering around the threshold
+// does not flap in and out of read rotation. Only sampled I/O moves the average, so a SLOW leg is
+// still sent one read in k_probe_every (probe()) for it to be seen to recover.
+//
+// Updates are relaxed load/store rather than a CAS loop: two queue threads racing on the same leg
+// lose one sample, which the average does not notice. Only the transition itself is a CAS.
+class LegLatency {
+public:
+    static constexpr uint32_t k_trip_samples = 8;
+    static constexpr uint64_t k_default_dwell_ns = 10'000'000'000UL;
+    static constexpr uint32_t k_probe_every = 64;
+
+    enum class transition : uint8_t { NONE, BECAME_SLOW, RECOVERED };
+
+    // CLOCK_MONOTONIC, the clock `now_ns` is taken from
+    static uint64_t now_ns() noexcept {
+        return static_cast< uint64_t >(std::chrono::duration_cast< std::chrono::nanoseconds >(
+                                           std::chrono::steady_clock::now().time_since_epoch())
+                                           .count());
+    }
+
+    transition record(uint32_t sample_us, uint32_t threshold_us, uint64_t now_ns,
+                      uint64_t dwell_ns = k_default_dwell_ns) noexcept {
+        auto const cur = _ewma_us.load(std::memory_order_relaxed);
+        auto const next = static_cast< uint32_t >((uint64_t{cur} * 7 + sample_us) / 8);
+        _ewma_us.store(next, std::memory_order_relaxed);
+        auto const over = (sample_us >= threshold_us) ? _over.load(std::memory_order_relaxed) + 1 : 0U;
+        _over.store(over, std::memory_order_relaxed);
+
+        if (next >= threshold_us && over >= k_trip_samples) {
+            if (__transition(false, now_ns, dwell_ns)) return transition::BECAME_SLOW;
+        } else if (next < threshold_us / 2) {
+            if (__transition(true, now_ns, dwell_ns)) return transition::RECOVERED;
+        }
+        return transition::NONE;
+    }
+
+    // Forget history, e.g. when the leg is degraded and will be measured afresh once it rejoins. It
+    // then holds CLEAN for the minimum dwell from `now_ns`.
+    void reset(uint64_t now_ns) noexcept {
+        _ewma_us.store(0, std::memory_order_relaxed);
+        _over.store(0, std::memory_order_relaxed);
+        _since_ns.store(now_ns, std::memory_order_relaxed);
+        _slow.store(false, std::memory_order_release);
+    }
+
+    [[nodiscard]] bool slow() const noexcept { return _slow.load(std::memory_order_acquire); }
+    // Whether a read about to be steered off this SLOW leg should go to it anyway: one in
+    // k_probe_every does
+    [[nodiscard]] bool probe() noexcept {
+        return 0 == (_steered.fetch_add(1, std::memory_order_relaxed) + 1) % k_probe_every;
+    }
+    [[nodiscard]] uint32_t ewma_us() const noexcept { return _ewma_us.load(std::memory_order_relaxed); }
+    // How long the leg has held its current state
+    [[nodiscard]] uint64_t dwell_ns(uint64_t now_ns) const noexcept {
+        auto const since = _since_ns.load(std::memory_order_relaxed);
+        return (now_ns > since) ? now_ns - since : 0;
+    }
+
+private:
+    bool __transition(bool from_slow, uint64_t now_ns, uint64_t min_dwell_ns) noexcept {
+        if (from_slow != _slow.load(std::memory_order_relaxed)) return false;
+        if (0 != _since_ns.load(std::memory_order_relaxed) && min_dwell_ns > dwell_ns(now_ns)) return false;
+        if (!_slow.compare_exchange_strong(from_slow, !from_slow, std::memory_order_acq_rel)) return false;
+        _since_ns.store(now_ns, std::memory_order_relaxed);
+        return true;
+    }
+
+    std::atomic< uint32_t > _ewma_us{0};
+    std::atomic< uint32_t > _over{0};
+    std::atomic< uint64_t > _since_ns{0}; // When _slow last changed; 0 if it never has
+    std::atomic< bool > _slow{false};
+    std::atomic< uint32_t > _steered{0}; // Reads steered off while SLOW, for probe()
+};
+
+} // namespace ublkpp::raid1
@@ -1,8 +1,12 @@
 #include "ublkpp/raid.hpp"
 
+#include <array>
+#include <chrono>
+#include <coroutine>
 #include <optional>
 #include <set>
 
+#include <boost/uuid/name_generator_sha1.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <ublksrv.h>
 #include <ublksrv_utils.h>
@@ -23,7 +27,22 @@ SISL_OPTION_GROUP(raid1,
                   (resync_delay, "", "resync_delay", "Delay between I/O and Resync context switches",
                    cxxopts::value< std::uint32_t >()->default_value("300"), "<microseconds> (us)"),
                   (avail_delay, "", "avail_delay", "Seconds between idle device availability probes",
-                   cxxopts::value< std::uint32_t >()->default_value("5"), "<seconds>"))
+                   cxxopts::value< std::uint32_t >()->default_value("5"), "<seconds>"),
+                  (write_behind, "", "write_behind",
+                   "Max MiB a write-mostly second leg may lag behind the first before writes wait on it (0=off)",
+                   cxxopts::value< std::uint32_t >()->default_value("0"), "<MiB>"),
+                  (split_read, "", "split_read", "Split reads of at least this many KiB across both legs (0=off)",
+                   cxxopts::value< std::uint32_t >()->default_value("0"), "<KiB>"),
+                  (slow_threshold, "", "slow_threshold",
+                   "Average I/O latency in ms at which a leg is demoted from reads (0=off)",
+                   cxxopts::value< std::uint32_t >()->default_value("0"), "<ms>"),
+                  (slow_degrade, "", "slow_degrade", "Also degrade a leg demoted by slow_threshold",
+                   cxxopts::value< bool >()->default_value("false"), ""),
+                  (slow_dwell, "", "slow_dwell",
+                   "Seconds a leg demoted by slow_threshold, or back from it, holds that state at least",
+                   cxxopts::value< std::uint32_t >()->default_value("10"), "<seconds>"),
+                  (resync_ioprio, "", "resync_ioprio", "I/O priority class of resync (idle, be)",
+                   cxxopts::value< std::string >()->default_value("idle"), "<class>"))
 
 namespace ublkpp {
 
@@ -84,8 +103,17 @@ struct RouteState {
 };
 
 Raid1Disk::Raid1Disk(boost::uuids::uuid const& uuid, std::shared_ptr< ublk_disk > dev_a,
-                     std::shared_ptr< ublk_disk > dev_b, std::string const& parent_id) :
-        ublk_disk(), _uuid(uuid), _str_uuid(boost::uuids::to_string(uuid)) {
+                     std::shared_ptr< ublk_disk > dev_b, std::string const& parent_id,
+                     std::shared_ptr< ublk_disk > meta) :
+        ublk_disk(),
+        _uuid(uuid),
+        _str_uuid(boost::uuids::to_string(uuid)),
+        _meta(std::move(meta)),
+        _write_behind_max(static_cast< uint64_t >(SISL_OPTIONS["write_behind"].as< uint32_t >()) * Mi),
+        _split_read_min(SISL_OPTIONS["split_read"].as< uint32_t >() * Ki),
+        _slow_threshold_us(SISL_OPTIONS["slow_threshold"].as< uint32_t >() * 1000),
+        _slow_degrade(SISL_OPTIONS["slow_degrade"].as< bool >()),
+        _slow_dwell_ns(uint64_t{SISL_OPTIONS["slow_dwell"].as< uint32_t >()} * 1'000'000'000UL) {
     // At least one device has to be "real"
     if (dev_a->is_missing() && dev_b->is_missing())
         throw std::runtime_error("Can not run with both devices missing"); // LCOV_EXCL_LINE
@@ -95,6 +123,8 @@ Raid1Disk::Raid1Disk(boost::uuids::uuid const& uuid, std::shared_ptr< ublk_disk
 
     // Load devices and select best superblock first so __init_params can read _sb->header.version.
     __load_and_select_superblock(uuid, std::move(dev_a), std::move(dev_b), parent_id);
+    __load_meta_superblock(uuid);
+    __update_read_weights();
 
     // Discover parameters and calculate reserved space (uses _device_a/_device_b/_sb).
     __init_params();
@@ -108,10 +138,13 @@ Raid1Disk::Raid1Disk(boost::uuids::uuid const& uuid, std::shared_ptr< ublk_disk
     uint32_t const resync_slots = SISL_OPTIONS.count("qdepth") ? 2u * SISL_OPTIONS["qdepth"].as< uint16_t >() : 256u;
     _resync_task = std::make_shared< Raid1ResyncTask >(_dirty_bitmap, _reserved_size, block_size(),
                                                        params()->basic.max_sectors << SECTOR_SHIFT, resync_slots,
-                                                       be32toh(_sb->fields.bitmap.chunk_size), _raid_metrics);
+                                                       be32toh(_sb->fields.bitmap.chunk_size), _raid_metrics, _meta);
+    if (0 < _write_behind_max)
+        _behind = std::make_shared< BehindWindow >(_write_behind_max, be32toh(_sb->fields.bitmap.chunk_size));
 
     // Write the up-to-date superblocks and mark devices as in use
     __become_active();
+    if (_behind) _repair_thread = std::thread([this] { __repair_loop(); });
 }
 
 void Raid1Disk::__init_params() {
@@ -147,7 +180,18 @@ void Raid1Disk::__init_params() {
     }
 
     auto const sb_version = be16toh(_sb->header.version);
-    if (sb_version < 2) {
+    if (_meta) {
+        // External bitmap: the legs hold only their superblock page. The metadata device gets the
+        // same v2 layout a leg would have reserved.
+        _reserved_size = sizeof(SuperBlock);
+        auto const meta_size = sizeof(SuperBlock) + (k_superbitmap_bits * k_page_size);
+        if (_meta->capacity() < meta_size || k_page_size < _meta->block_size()) {
+            RLOGE("Metadata device {} unusable: requires [lbs<={} && cap>={}Ki] [uuid:{}]", *_meta, k_page_size,
+                  meta_size / Ki, _str_uuid)
+            throw std::runtime_error(fmt::format("metadata device too small: {} bytes < {} bytes", _meta->capacity(),
+                                                 meta_size));
+        }
+    } else if (sb_version < 2) {
         // v1: capacity-proportional reserved region — reconstruct the exact on-disk layout.
         auto const bitmap_size = ((our_params.basic.dev_sectors << SECTOR_SHIFT) / k_min_chunk_size) / k_bits_in_byte;
         _reserved_size = sizeof(SuperBlock) + bitmap_size;
@@ -219,13 +263,64 @@ void Raid1Disk::__load_and_select_superblock(boost::uuids::uuid const& uuid, std
     if (_device_a->new_device && _device_b->new_device) _sb->fields.bitmap.age = htobe64(1);
 }
 
+// Runs after __load_and_select_superblock. Arrays are created with or without a metadata device;
+// switching an existing array's bitmap location is refused because it moves the user data.
+void Raid1Disk::__load_meta_superblock(boost::uuids::uuid const& uuid) {
+    bool const fresh_array = _device_a->new_device && _device_b->new_device;
+    if (!_meta) {
+        if (_sb->fields.ext_bitmap && !fresh_array) {
+            RLOGE("Array keeps its bitmap on a metadata device, none given [uuid:{}]", _str_uuid)
+            throw std::runtime_error("RAID1 array requires its metadata device");
+        }
+        _sb->fields.ext_bitmap = 0;
+        return;
+    }
+    if (!_sb->fields.ext_bitmap && !fresh_array) {
+        RLOGE("Array keeps its bitmap on its legs, refusing metadata device {} [uuid:{}]", *_meta, _str_uuid)
+        throw std::runtime_error("RAID1 array was not created with a metadata device");
+    }
+    _sb->fields.ext_bitmap = 1;
+    _sb->header.version = htobe16(k_sb_version_ext);
+
+    auto res = load_superblock(*_meta, uuid, be32toh(_sb->fields.bitmap.chunk_size));
+    if (!res) {
+        RLOGE("Could not load superblock from metadata device {} [uuid:{}]", *_meta, _str_uuid)
+        throw std::runtime_error("Could not load metadata device superblock");
+    }
+    auto meta_sb = std::unique_ptr< SuperBlock, decltype(&free) >(res.value().first, free);
+    _meta_new = res.value().second;
+    // The rule a leg's own pages follow: they hold for the age they were written at. Degrading moves
+    // the age on the legs alone, which leaves these pages untrusted until a clean shutdown.
+    _meta_trusted = !_meta_new && (meta_sb->fields.bitmap.age == _sb->fields.bitmap.age);
+    if (!_meta_new && !_meta_trusted)
+        RLOGW("Metadata device {} is behind the array superblock, its bitmap will not be used [uuid:{}]", *_meta,
+              _str_uuid)
+}
+
+// Loads the bitmap pages saved alongside `leg`'s superblock. A metadata device that cannot vouch
+// for its pages leaves nothing to load from, so the whole bitmap is dirtied instead.
+void Raid1Disk::__load_bitmap(std::shared_ptr< ublk_disk > const& leg) {
+    if (_meta && !_meta_trusted) {
+        RLOGW("No trusted bitmap on metadata device, dirty all of BITMAP [uuid:{}]", _str_uuid)
+        _dirty_bitmap->dirty_region(0, capacity());
+        return;
+    }
+    _dirty_bitmap->load_from(*__bitmap_device(leg));
+}
+
 void Raid1Disk::__init_bitmap_and_degraded_route() {
     // Read in existing dirty BITMAP pages
     _dirty_bitmap = std::make_shared< Bitmap >(capacity(), be32toh(_sb->fields.bitmap.chunk_size), block_size(),
                                                _sb->superbitmap_reserved, _str_uuid);
-    // Initialize bitmap pages for any new (or defunct) device slots
-    if (_device_a->new_device) _dirty_bitmap->init_to(_device_a->disk);
-    if (_device_b->new_device) _dirty_bitmap->init_to(_device_b->disk);
+    // Initialize bitmap pages for any new (or defunct) device slots; with a metadata device there is
+    // one set of pages, initialized once. A missing-leg placeholder is not new: it holds no pages.
+    if (_meta) {
+        auto const fresh = [](MirrorDevice const& dev) { return dev.new_device && !dev.disk->is_missing(); };
+        if (_meta_new || fresh(*_device_a) || fresh(*_device_b)) _dirty_bitmap->init_to(_meta);
+    } else {
+        if (_device_a->new_device) _dirty_bitmap->init_to(_device_a->disk);
+        if (_device_b->new_device) _dirty_bitmap->init_to(_device_b->disk);
+    }
 
     // Use physical slot references (_device_a/_device_b) directly to avoid the ambiguity of
     // role-relative state captured by __capture_route_state(). The read_route enum refers to
@@ -244,7 +339,7 @@ void Raid1Disk::__init_bitmap_and_degraded_route() {
             RLOGW("Unclean shutdown while degraded with missing device! Dirty all of BITMAP")
             _dirty_bitmap->dirty_region(0, capacity());
         } else {
-            _dirty_bitmap->load_from(*(a_is_missing ? _device_b : _device_a)->disk);
+            __load_bitmap((a_is_missing ? _device_b : _device_a)->disk);
         }
     } else if (_device_a->new_device xor _device_b->new_device) {
         // Bump the bitmap age
@@ -268,7 +363,7 @@ void Raid1Disk::__init_bitmap_and_degraded_route() {
         // If empty, Fix 1 in _start() (complete() on STOPPING) should have prevented this.
         if (!_dirty_bitmap->superbitmap_nonempty())
             RLOGW("Degraded + clean unmount + empty superbitmap [uuid:{}]", _str_uuid)
-        _dirty_bitmap->load_from(*active_dev->disk);
+        __load_bitmap(active_dev->disk);
     } else if (0 == _sb->fields.clean_unmount) {
         // Both-present unclean: reads may diverge across legs. Pin to device_a (canonical),
         // dirty all, mark device_b stale. __become_active skips device_b's SB (unavail guard)
@@ -298,6 +393,10 @@ void Raid1Disk::__become_active() {
     auto const state = __capture_route_state();
     _sb->fields.clean_unmount = 0x0;
     _sb->fields.device_b = 0; // Reset this in case we loaded from dev_b
+    // Marks the metadata device in use at the array's age; a later change of age leaves its pages
+    // untrusted until a clean shutdown rewrites it.
+    if (_meta && !write_superblock(*_meta, _sb.get(), false, state.route))
+        RLOGW("Could not mark metadata device {} active [uuid:{}]", *_meta, _str_uuid)
     if (!write_superblock(*state.active_dev->disk, _sb.get(), read_route::DEVB == state.route, state.route)) {
         // If already degraded this is Fatal
         if (state.is_degraded) { throw std::runtime_error(fmt::format("Could not initialize superblocks!")); }
@@ -328,15 +427,37 @@ Raid1Disk::~Raid1Disk() {
     RLOGD("Shutting down; [uuid:{}]", _str_uuid)
     _resync_task->stop();
 
+    if (_behind) {
+        // The target drains the copies (detached_io) before it lets go of the array
+        while (0 < _behind->bytes())
+            std::this_thread::sleep_for(k_state_spin_time);
+        {
+            auto lk = std::scoped_lock(_repair_lock);
+            _repair_stop = true;
+        }
+        _repair_cv.notify_all();
+        if (_repair_thread.joinable()) _repair_thread.join();
+    }
+
     if (!_sb) return;
 
+    // Regions the backup missed go out with the degraded array's bitmap. This also waits out the
+    // last copy's retire, which holds _clean_transition_mutex past bytes().
+    if (_behind) __repair_behind(false);
     auto const state = __capture_route_state();
+    // Only a degraded array writes out its bitmap: should degrading have failed, the array is left
+    // marked unclean, so the next assembly resyncs the backup in full from the other leg.
+    if (!state.is_degraded && 0 < _dirty_bitmap->dirty_pages()) {
+        RLOGW("Device {} lacks acked writes at shutdown, full resync upon next assembly [uuid:{}]",
+              *state.backup_dev->disk, _str_uuid)
+        return;
+    }
     // Write out our dirty bitmap to the active device.
     // M11: flush even when backup_dev is a missing placeholder — the active device still needs
     // the current bitmap so the next startup can do an incremental resync rather than a full one.
     if (state.is_degraded) {
         RLOGI("Synchronizing BITMAP [uuid: {}] to clean device: {}", _str_uuid, *state.active_dev->disk)
-        if (auto res = _dirty_bitmap->sync_to(*state.active_dev->disk, sizeof(SuperBlock)); !res) {
+        if (auto res = _dirty_bitmap->sync_to(*__bitmap_device(state.active_dev->disk), sizeof(SuperBlock)); !res) {
             RLOGW("Could not sync Bitmap to device on shutdown, will require full resync next time! [uuid:{}]",
                   _str_uuid)
             return;
@@ -357,6 +478,8 @@ Raid1Disk::~Raid1Disk() {
     if (!state.is_degraded)
         std::ignore =
             write_superblock(*state.backup_dev->disk, _sb.get(), read_route::DEVB != state.route, state.route, true);
+    // Last, so the metadata device only vouches for pages already written above
+    if (_meta) std::ignore = write_superblock(*_meta, _sb.get(), false, state.route, true);
 }
 
 Raid1Disk::prepare_result Raid1Disk::prepare(ublksrv_queue const* q, int const iouring_device_start) {
@@ -366,9 +489,14 @@ Raid1Disk::prepare_result Raid1Disk::prepare(ublksrv_queue const* q, int const i
     auto result = _device_a->disk->prepare(q, iouring_device_start);
     auto b = _device_b->disk->prepare(q, iouring_device_start + static_cast< int >(result.fds.size()));
     result.fds.insert(result.fds.end(), b.fds.begin(), b.fds.end());
+    result.polled = result.polled || b.polled;
     // Writes fan out to both mirrors concurrently; both SQE sets land in the same pool simultaneously.
-    // Failover reads are sequential (max of the two), but write is the worst case.
+    // Failover reads are sequential (max of the two), but write is the worst case -- unless split
+    // reads are on, where both fragments may fail over onto the same (larger) leg at once.
+    auto const widest = std::max(result.max_sqes_per_io, b.max_sqes_per_io);
+    _leg_sqes = std::max(_leg_sqes, widest);
     result.max_sqes_per_io += b.max_sqes_per_io;
+    if (0 < _split_read_min) result.max_sqes_per_io = std::max(result.max_sqes_per_io, 2 * widest);
 
     // Enable resync only on the first real queue init (q != nullptr guards the probe-only call).
     if (q && _nr_hw_queues.fetch_add(1, std::memory_order_acq_rel) == 0) toggle_resync(true);
@@ -428,11 +556,25 @@ bool Raid1Disk::__swap_device(std::string const& outgoing_device_id, std::shared
 
     // Dirty entire bitmap if this is a new device
     if (outgoing_dev->new_device) _dirty_bitmap->dirty_region(0, capacity());
+    __update_read_weights();
     // Open up for Large WRITES and RESYNC
     outgoing_dev->unavail.clear(std::memory_order_release);
     return true;
 }
 
+// Leaf replicas behind a mirror slot: a nested Raid1Disk (N-way chain) contributes its own
+// leaves, anything else (including a missing placeholder) is a single leg.
+static uint32_t __leaf_count(ublk_disk const& disk) noexcept {
+    auto const* nested = dynamic_cast< Raid1Disk const* >(&disk);
+    return nested ? nested->replica_count() : 1U;
+}
+
+// Called from the constructor and under _ctrl_lock from __swap_device, the only writers of the slots.
+void Raid1Disk::__update_read_weights() noexcept {
+    _read_weight_a.store(__leaf_count(*_device_a->disk), std::memory_order_relaxed);
+    _read_weight_b.store(__leaf_count(*_device_b->disk), std::memory_order_relaxed);
+}
+
 // ##########################################!! WARNING !!##########################################
 // One should not directly access _device_a, _device_b or _read_route directly following this point.
 // It is subject to multi-threading in that case and subject to hotswap or degradation altering
@@ -537,6 +679,13 @@ std::shared_ptr< ublk_disk > Raid1Disk::swap_device(std::string const& outgoing_
     // then we ensure that the incoming device is actually a different device
     // from what we already have. If either is not true, do nothing.
     if ((state.active_dev->disk->id() != outgoing_device_id) && (state.backup_dev->disk->id() != outgoing_device_id)) {
+        // N-way chains: the leg may live in a nested mirror, which applies these same rules itself.
+        for (auto const& dev : {state.active_dev, state.backup_dev}) {
+            if (auto* nested = dynamic_cast< Raid1Disk* >(dev->disk.get()); nested) {
+                if (auto res = nested->swap_device(outgoing_device_id, incoming_device); res != incoming_device)
+                    return res;
+            }
+        }
         RLOGE("Refusing to replace unrecognized mirror!")
         return incoming_device;
     } else if ((state.active_dev->disk->id() == incoming_device->id()) ||
@@ -574,7 +723,7 @@ std::shared_ptr< ublk_disk > Raid1Disk::swap_device(std::string const& outgoing_
     try {
         // TODO we need to save the SuperBitmap Here!
         if (!incoming_mirror->disk->is_missing() && incoming_mirror->new_device)
-            _dirty_bitmap->init_to(incoming_mirror->disk);
+            _dirty_bitmap->init_to(__bitmap_device(incoming_mirror->disk));
     } catch (std::runtime_error const&) {
         toggle_resync(old_resync_flag);
         return incoming_device;
@@ -592,6 +741,40 @@ std::shared_ptr< ublk_disk > Raid1Disk::swap_device(std::string const& outgoing_
     return incoming_mirror->disk;
 }
 
+// Severity order CLEAN < SLOW < UNAVAIL < SYNCING < ERROR. A leaf of a nested mirror is never healthier
+// than the slot holding that mirror: if the outer array is resyncing the slot, every leaf in it is.
+static replica_state __worse_of(replica_state lhs, replica_state rhs) noexcept {
+    auto const rank = [](replica_state s) -> int {
+        switch (s) {
+        case replica_state::CLEAN:
+            return 0;
+        case replica_state::SLOW:
+            return 1;
+        case replica_state::UNAVAIL:
+            return 2;
+        case replica_state::SYNCING:
+            return 3;
+        case replica_state::ERROR:
+        default:
+            return 4;
+        }
+    };
+    return rank(lhs) >= rank(rhs) ? lhs : rhs;
+}
+
+// Appends the leaves behind `leg`, whose slot is in `slot_state`: the leg itself, or every leaf of
+// a nested mirror, each no healthier than the slot.
+static void __append_legs(std::vector< leg_state >& legs, std::shared_ptr< ublk_disk > const& leg,
+                          replica_state slot_state) {
+    auto const* nested = dynamic_cast< Raid1Disk const* >(leg.get());
+    if (!nested) {
+        legs.push_back({.id = leg->id(), .state = slot_state});
+        return;
+    }
+    for (auto& leaf : nested->replica_states().legs)
+        legs.push_back({.id = std::move(leaf.id), .state = __worse_of(leaf.state, slot_state)});
+}
+
 raid1::array_state Raid1Disk::replica_states() const noexcept {
     auto const sz_to_sync = _dirty_bitmap->dirty_data_est();
     auto const state = __capture_route_state();
@@ -610,25 +793,45 @@ raid1::array_state Raid1Disk::replica_states() const noexcept {
             return replica_state::UNAVAIL; // Has data, can't reach it
         }
 
-        return replica_state::CLEAN;
+        return dev->latency.slow() ? replica_state::SLOW : replica_state::CLEAN;
     };
 
+    auto result = raid1::array_state{};
     switch (state.route) {
     case read_route::DEVA: // Device B is write-degraded
-        return {.device_a = get_state(state.active_dev.get(), true, sz_to_sync),
-                .device_b = get_state(state.backup_dev.get(), false, sz_to_sync),
-                .bytes_to_sync = sz_to_sync};
+        result = {.device_a = get_state(state.active_dev.get(), true, sz_to_sync),
+                  .device_b = get_state(state.backup_dev.get(), false, sz_to_sync),
+                  .bytes_to_sync = sz_to_sync};
+        break;
     case read_route::DEVB: // Device A is write-degraded
-        return {.device_a = get_state(state.backup_dev.get(), false, sz_to_sync),
-                .device_b = get_state(state.active_dev.get(), true, sz_to_sync),
-                .bytes_to_sync = sz_to_sync};
+        result = {.device_a = get_state(state.backup_dev.get(), false, sz_to_sync),
+                  .device_b = get_state(state.active_dev.get(), true, sz_to_sync),
+                  .bytes_to_sync = sz_to_sync};
+        break;
     case read_route::EITHER: // Healthy array
     default:
         // For EITHER route: active_dev==device_a, backup_dev==device_b by convention
-        return {.device_a = get_state(state.active_dev.get(), true, 0),
-                .device_b = get_state(state.backup_dev.get(), true, 0),
-                .bytes_to_sync = 0};
+        result = {.device_a = get_state(state.active_dev.get(), true, 0),
+                  .device_b = get_state(state.backup_dev.get(), true, 0),
+                  .bytes_to_sync = 0};
+        // A write-behind leg is catching up on the copies in flight
+        if (_behind && 0 < _behind->bytes()) {
+            result.device_b = replica_state::SYNCING;
+            result.bytes_to_sync = _behind->bytes();
+        }
+        break;
     }
+
+    // Leaves in leg order, from the same route capture as the slot states. Listing them allocates;
+    // should that fail the list is left empty and the slot states still stand.
+    auto const& leg_a = (state.route == read_route::DEVB) ? state.backup_dev->disk : state.active_dev->disk;
+    auto const& leg_b = (state.route == read_route::DEVB) ? state.active_dev->disk : state.backup_dev->disk;
+    try {
+        result.legs.reserve(replica_count());
+        __append_legs(result.legs, leg_a, result.device_a);
+        __append_legs(result.legs, leg_b, result.device_b);
+    } catch (std::exception const&) { result.legs.clear(); } // LCOV_EXCL_LINE
+    return result;
 }
 
 std::pair< std::shared_ptr< ublk_disk >, std::shared_ptr< ublk_disk > > Raid1Disk::replicas() const noexcept {
@@ -644,6 +847,124 @@ std::pair< std::shared_ptr< ublk_disk >, std::shared_ptr< ublk_disk > > Raid1Dis
     }
 }
 
+uint32_t Raid1Disk::replica_count() const noexcept {
+    return _read_weight_a.load(std::memory_order_relaxed) + _read_weight_b.load(std::memory_order_relaxed);
+}
+
+bool Raid1Disk::set_write_mostly(std::string const& device_id, bool write_mostly) {
+    std::shared_ptr< MirrorDevice > dev_a, dev_b;
+    {
+        auto lg = std::scoped_lock< std::mutex >(_ctrl_lock);
+        dev_a = _device_a;
+        dev_b = _device_b;
+    }
+    for (auto const& dev : {dev_a, dev_b}) {
+        if (dev->disk->id() != device_id) continue;
+        dev->write_mostly.store(write_mostly, std::memory_order_relaxed);
+        RLOGI("{} write-mostly on {} [uuid:{}]", write_mostly ? "Enabled" : "Disabled", *dev->disk, _str_uuid)
+        return true;
+    }
+    for (auto const& dev : {dev_a, dev_b}) {
+        if (auto* nested = dynamic_cast< Raid1Disk* >(dev->disk.get()); nested) {
+            if (nested->set_write_mostly(device_id, write_mostly)) return true;
+        }
+    }
+    return false;
+}
+
+// Split-mirror: detach a leg of a clean array as a point-in-time copy. The leg's slot is taken by a
+// missing placeholder and the array degrades onto the staying leg exactly as if the leg had failed:
+// the age advances by one (not k_age_bump) and every later write is tracked in the dirty bitmap.
+// Unlike swap_device() the bitmap is not dirtied wholesale, so rejoin_mirror() hands the same leg
+// back through swap_device() -- which accepts a leg within one age of the array without init_to()
+// -- and resync copies only what changed while it was away.
+//
+// The cut is the route change; writes that captured the route before it are drained (with any
+// write-behind copies) before the leg is handed out, so it holds every write acked before the call
+// returned and none issued after. Lock order matches the failure sites: _clean_transition_mutex,
+// then _ctrl_lock; both are released before draining, as those writes may need them.
+std::shared_ptr< ublk_disk > Raid1Disk::split_mirror(std::string const& device_id) {
+    auto const state = __capture_route_state();
+    if ((state.active_dev->disk->id() != device_id) && (state.backup_dev->disk->id() != device_id)) {
+        for (auto const& dev : {state.active_dev, state.backup_dev}) {
+            if (auto* nested = dynamic_cast< Raid1Disk* >(dev->disk.get()); nested) {
+                if (auto res = nested->split_mirror(device_id); res) return res;
+            }
+        }
+        RLOGE("Refusing to split unrecognized mirror {} [uuid:{}]", device_id, _str_uuid)
+        return nullptr;
+    }
+
+    // The placeholder has nothing to initialize: the bitmap records everything the split leg misses.
+    auto placeholder = std::make_shared< MirrorDevice >(_uuid, make_missing_disk());
+    placeholder->new_device = false;
+    placeholder->unavail.test_and_set(std::memory_order_release);
+
+    {
+        std::lock_guard clean_lock(_clean_transition_mutex);
+        auto lg = std::scoped_lock< std::mutex >(_ctrl_lock);
+        bool const split_a = (_device_a->disk->id() == device_id);
+        auto& outgoing_dev = split_a ? _device_a : _device_b;
+        auto& staying_dev = split_a ? _device_b : _device_a;
+        if (outgoing_dev->disk->id() != device_id) return nullptr; // Raced a swap_device()
+        if (staying_dev->unavail.test(std::memory_order_acquire) || 0 < _dirty_bitmap->dirty_pages() ||
+            __backup_lagging()) {
+            RLOGE("Refusing to split {} from an array that is not clean [uuid:{}]", device_id, _str_uuid)
+            return nullptr;
+        }
+        auto const new_route = split_a ? read_route::DEVB : read_route::DEVA;
+        auto old_route = read_route::EITHER;
+        if (!_read_route_cache.compare_exchange_strong(old_route, new_route)) {
+            RLOGE("Refusing to split {} from a degraded array [uuid:{}]", device_id, _str_uuid)
+            return nullptr;
+        }
+
+        auto const old_age = be64toh(_sb->fields.bitmap.age);
+        outgoing_dev.swap(placeholder);
+        _sb->fields.bitmap.age = htobe64(old_age + 1);
+        if (auto sync_res = write_superblock(*staying_dev->disk, _sb.get(), split_a, new_route); !sync_res) {
+            RLOGE("Could not split {} [uuid:{}]: {}", device_id, _str_uuid, sync_res.error().message())
+            _sb->fields.bitmap.age = htobe64(old_age);
+            outgoing_dev.swap(placeholder);
+            auto rollback_route = new_route;
+            _read_route_cache.compare_exchange_strong(rollback_route, read_route::EITHER);
+            return nullptr;
+        }
+        __update_read_weights();
+        if (_raid_metrics) { // GCOVR_EXCL_BR_LINE
+            // LCOV_EXCL_START
+            _raid_metrics->record_degraded_state(true);
+        } // LCOV_EXCL_STOP
+        RLOGI("Split {} from mirror [age:{}] [uuid:{}]", *placeholder->disk, old_age + 1, _str_uuid)
+    }
+    __drain_writes();
+    return placeholder->disk;
+}
+
+void Raid1Disk::__drain_writes() noexcept {
+    auto const prev = _write_epoch.fetch_add(1, std::memory_order_seq_cst) & 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (auto const& shard : _epoch_writes)
+        while (0 < shard.n[prev].load(std::memory_order_acquire))
+            std::this_thread::sleep_for(k_state_spin_time);
+    // Write-behind copies outlive their writes; none start once the route is degraded
+    while (_behind && 0 < _behind->bytes())
+        std::this_thread::sleep_for(k_state_spin_time);
+}
+
+bool Raid1Disk::rejoin_mirror(std::shared_ptr< ublk_disk > leg) {
+    auto const state = __capture_route_state();
+    if (state.is_degraded && state.backup_dev->disk->is_missing())
+        return swap_device(state.backup_dev->disk->id(), leg) != leg;
+    for (auto const& dev : {state.active_dev, state.backup_dev}) {
+        if (auto* nested = dynamic_cast< Raid1Disk* >(dev->disk.get()); nested) {
+            if (nested->rejoin_mirror(leg)) return true;
+        }
+    }
+    RLOGE("No split slot to rejoin {} into [uuid:{}]", *leg, _str_uuid)
+    return false;
+}
+
 // Returns true if the array successfully transitioned to EITHER (clean superblocks written),
 // or if another concurrent path already won the EITHER CAS (idempotent).
 // Returns false in three cases that require the caller to keep resyncing:
@@ -787,7 +1108,8 @@ bool Raid1Disk::__try_persist_degraded_sb(bool spawn_resync) {
 // and __swap_device. Both hold _ctrl_lock across their CAS, so the winner is determined under
 // the lock. The loser sees old_route != EITHER and returns early (already degraded or swap
 // in progress).
-bool Raid1Disk::__become_degraded(bool failed_is_active, RouteState const* cur_state, bool spawn_resync) {
+bool Raid1Disk::__become_degraded(bool failed_is_active, RouteState const* cur_state, bool spawn_resync,
+                                  bool lagging) {
     // Surviving device is backup if active failed, active if backup failed.
     // new_route = the physical slot (DEVA/DEVB) of the surviving device.
     bool const active_is_b = (cur_state->route == read_route::DEVB);
@@ -818,15 +1140,20 @@ bool Raid1Disk::__become_degraded(bool failed_is_active, RouteState const* cur_s
         return false; // __swap_device won the CAS
     }
     auto& working_device = *working_disk;
-    RLOGW("Device became degraded {} [age:{}] [uuid:{}]", *failed_device->disk,
-          static_cast< uint64_t >(be64toh(_sb->fields.bitmap.age)), _str_uuid);
+    if (lagging) {
+        RLOGD("Write-behind: {} lagging [age:{}] [uuid:{}]", *failed_device->disk,
+              static_cast< uint64_t >(be64toh(_sb->fields.bitmap.age)), _str_uuid);
+    } else {
+        RLOGW("Device became degraded {} [age:{}] [uuid:{}]", *failed_device->disk,
+              static_cast< uint64_t >(be64toh(_sb->fields.bitmap.age)), _str_uuid);
+    }
 
     // Record degradation event in metrics with device name
     if (_raid_metrics) { // GCOVR_EXCL_BR_LINE -- UblkRaidMetrics requires prometheus registry; not constructible in
                          // unit tests
         // LCOV_EXCL_START
         auto device_name = (new_route == read_route::DEVA) ? "device_b" : "device_a";
-        _raid_metrics->record_device_degraded(device_name);
+        if (!lagging) _raid_metrics->record_device_degraded(device_name);
         _raid_metrics->record_degraded_state(true);
     } // LCOV_EXCL_STOP
 
@@ -858,7 +1185,7 @@ bool Raid1Disk::__become_degraded(bool failed_is_active, RouteState const* cur_s
         // the write before acking.
         RLOGE("Could not persist degradation [uuid:{}]: {}", _str_uuid, sync_res.error().message())
     }
-    failed_device->unavail.test_and_set(std::memory_order_acq_rel);
+    if (!lagging) failed_device->unavail.test_and_set(std::memory_order_acq_rel);
     if (was_pending && spawn_resync && _resync_enabled.load(std::memory_order_relaxed)) toggle_resync(true);
     return bool(sync_res);
 }
@@ -870,7 +1197,24 @@ disk_task< int > Raid1Disk::__failover_read_async(ublksrv_queue const* q, ublk_i
     auto& primary_dev = devices.first;
     auto& failover_dev = devices.second;
 
-    auto primary_task = primary_dev->disk->async_iov(q, data, iovecs, nr_vecs, addr + _reserved_size).start();
+    // Striped read: one fragment per leg in parallel, each failing over to the other leg on its own.
+    // failover_dev is only present when the region is valid on both legs.
+    if (auto const head_len = failover_dev ? __split_point(state, *primary_dev, **failover_dev, len, nr_vecs) : 0U;
+        0 < head_len) {
+        auto frags = std::array< iovec, 2 >{
+            iovec{.iov_base = iovecs->iov_base, .iov_len = head_len},
+            iovec{.iov_base = static_cast< uint8_t* >(iovecs->iov_base) + head_len, .iov_len = len - head_len}};
+        auto head_task = __read_fragment(q, data, &frags[0], addr, state.is_degraded, primary_dev, *failover_dev).start();
+        auto tail_task =
+            __read_fragment(q, data, &frags[1], addr + head_len, state.is_degraded, *failover_dev, primary_dev).start();
+        auto const head_res = co_await head_task;
+        auto const tail_res = co_await tail_task;
+        if (head_res < 0) co_return head_res;
+        if (tail_res < 0) co_return tail_res;
+        co_return head_res + tail_res;
+    }
+
+    auto primary_task = __leg_iov(primary_dev, q, data, iovecs, nr_vecs, addr + _reserved_size).start();
     auto const r = co_await primary_task;
 
     if (r >= 0) {
@@ -882,7 +1226,7 @@ disk_task< int > Raid1Disk::__failover_read_async(ublksrv_queue const* q, ublk_i
 
     if (!failover_dev) co_return -EAGAIN;
 
-    auto failover_task = (*failover_dev)->disk->async_iov(q, data, iovecs, nr_vecs, addr + _reserved_size).start();
+    auto failover_task = __leg_iov(*failover_dev, q, data, iovecs, nr_vecs, addr + _reserved_size).start();
     co_return co_await failover_task;
 }
 
@@ -891,8 +1235,17 @@ Raid1Disk::__select_read_devices(RouteState const& state, uint64_t addr, uint32_
     thread_local raid1::read_route last_read = raid1::read_route::DEVB;
 
     auto route = read_route::DEVA;
+    bool spread = false;
     if (state.is_degraded && state.backup_dev->unavail.test(std::memory_order_acquire)) {
         route = state.route;
+    } else if (auto const wa = _read_weight_a.load(std::memory_order_relaxed),
+               wb = _read_weight_b.load(std::memory_order_relaxed);
+               wa != wb) {
+        // N-way chain: split by chunk address in proportion to the leaves behind each slot. This
+        // leaves last_read alone so the nested mirror's round-robin stays balanced on this thread.
+        auto const chunk = addr >> params()->basic.io_opt_shift;
+        route = (chunk % (wa + wb)) < wa ? read_route::DEVA : read_route::DEVB;
+        spread = true;
     } else {
         route = (last_read == read_route::DEVB) ? read_route::DEVA : read_route::DEVB;
     }
@@ -902,13 +1255,34 @@ Raid1Disk::__select_read_devices(RouteState const& state, uint64_t addr, uint32_
     if (state.is_degraded && _dirty_bitmap->is_dirty(addr, len)) {
         if (route != state.route) route = state.route;
         backup_stale = true;
+        // Reads pinned to one leg by a dirty region get that region repaired ahead of the sweep.
+        _resync_task->prioritize(addr, len);
+    }
+    // Nor does a write-behind leg that lacks acked writes serve the read, not even as the failover.
+    if (!backup_stale && __backup_lagging()) {
+        route = (read_route::DEVB == state.route) ? read_route::DEVB : read_route::DEVA;
+        backup_stale = true;
     }
-    if (!state.is_degraded && __route_to_device(state, route)->unavail.test(std::memory_order_acquire)) {
+    if (!backup_stale && !state.is_degraded &&
+        __route_to_device(state, route)->unavail.test(std::memory_order_acquire)) {
         route = (route == read_route::DEVA) ? read_route::DEVB : read_route::DEVA;
         RLOGD("Skipping unavail device, routing to alternate")
     }
+    // Write-mostly and fail-slow legs serve reads only when the other leg cannot (they remain the
+    // failover). A fail-slow leg still gets the odd probe read: only sampled I/O can show it has
+    // recovered, and a read-mostly workload would otherwise leave it SLOW for good.
+    auto const demoted = [](MirrorDevice const& dev) {
+        return dev.write_mostly.load(std::memory_order_relaxed) || dev.latency.slow();
+    };
+    if (auto& dev = *__route_to_device(state, route); !backup_stale && demoted(dev)) {
+        auto const alt_route = (route == read_route::DEVA) ? read_route::DEVB : read_route::DEVA;
+        auto const& alt = __route_to_device(state, alt_route);
+        if (!demoted(*alt) && !alt->unavail.test(std::memory_order_acquire) &&
+            (dev.write_mostly.load(std::memory_order_relaxed) || !dev.latency.probe()))
+            route = alt_route;
+    }
 
-    last_read = route;
+    if (!spread) last_read = route;
     auto const other_route = (route == read_route::DEVA) ? read_route::DEVB : read_route::DEVA;
     return {__route_to_device(state, route),
             backup_stale ? std::nullopt : std::optional{__route_to_device(state, other_route)}};
@@ -919,6 +1293,230 @@ bool Raid1Disk::__backup_writable(RouteState const& state, uint64_t addr, uint32
              (state.backup_dev->unavail.test(std::memory_order_acquire) || _dirty_bitmap->is_dirty(addr, len)));
 }
 
+// Only the backup leg can lag: in a clean array that is device_b, so the write-mostly leg belongs
+// in the second slot for write-behind. After a crash the array assembles unclean and device_b is
+// resynced in full from device_a, so a lagging device_b never becomes the source.
+bool Raid1Disk::__write_behind(RouteState const& state) const noexcept {
+    return _behind && state.backup_dev->write_mostly.load(std::memory_order_relaxed) &&
+        !state.active_dev->write_mostly.load(std::memory_order_relaxed);
+}
+
+namespace {
+// A coroutine nothing awaits: it runs from the call and frees itself once done
+struct detached_task {
+    struct promise_type {
+        detached_task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {}
+    };
+};
+
+struct free_buf {
+    void operator()(uint8_t* p) const { free(p); }
+};
+
+// What a write-behind copy keeps once its request has completed: the data, and the per-I/O state a
+// leg's driver expects of a request. Its async_io completes no tag (_tag -1).
+struct behind_io {
+    ublksrv_io_desc iod{};
+    async_io io{};
+    ublk_io_data data{};
+    std::unique_ptr< uint8_t, free_buf > buf;
+    std::vector< iovec > iovecs;
+};
+} // namespace
+
+template < typename Retire >
+static detached_task write_behind_io(std::shared_ptr< MirrorDevice > dev, ublksrv_queue const* q,
+                                     std::unique_ptr< behind_io > io, uint64_t addr, uint32_t len, uint64_t dev_addr,
+                                     Retire retire) {
+    auto const detached = detached_io(q);
+    auto res = -EIO;
+    try {
+        res = co_await dev->disk
+                  ->async_iov(q, &io->data, io->iovecs.data(), static_cast< uint32_t >(io->iovecs.size()), dev_addr)
+                  .start();
+    } catch (std::exception const& e) {
+        RLOGE("Write-behind threw exception: [{}]", e.what()) // LCOV_EXCL_LINE
+    }
+    if (0 > res) RLOGW("Write-behind to {} failed [lba:{:#0x}|len:{:#0x}]: {}", *dev->disk, addr, len, res)
+    retire(0 <= res);
+}
+
+// The caller admitted the write to _behind and dirtied its region. The data is copied: the
+// request's buffer goes back to the kernel once the active leg's result is returned.
+//
+// A copy retires under _clean_transition_mutex, as failure sites dirty regions and degrade: it
+// clears its region only in a clean array, where that region holds no other write (a write
+// overlapping a copy in flight leaves it stale). A degraded array's resync owns the bitmap.
+void Raid1Disk::__write_behind_copy(RouteState const& state, ublksrv_queue const* q, ublk_io_data const* data,
+                                    iovec const* iovecs, uint32_t nr_vecs, uint64_t addr, uint32_t len) {
+    auto retire = [this, addr, len](bool ok) {
+        std::lock_guard lock(_clean_transition_mutex);
+        _behind->retire(addr, len, ok, [&](bool landed) {
+            if (landed && read_route::EITHER == _read_route_cache.load(std::memory_order_acquire))
+                __behind_landed(addr, len);
+            if (_behind->stale()) __want_repair();
+        });
+    };
+    auto io = std::make_unique< behind_io >();
+    io->iod = *data->iod;
+    io->io._tag = -1;
+    io->io._ioprio = io_priority(data);
+    io->io._pool.reserve(_leg_sqes);
+    io->data = *data;
+    io->data.iod = &io->iod;
+    io->data.private_data = &io->io;
+    if (UBLK_IO_OP_WRITE == ublksrv_get_op(data->iod)) {
+        void* buf{nullptr};
+        if (0 != ::posix_memalign(&buf, block_size(), len)) { // LCOV_EXCL_START
+            RLOGE("Could not allocate write-behind buffer, leaving region to resync [uuid:{}]", _str_uuid)
+            _behind->mark_stale(addr, len);
+            retire(true);
+            return;
+        } // LCOV_EXCL_STOP
+        io->buf.reset(static_cast< uint8_t* >(buf));
+        auto off = size_t{0};
+        for (auto const* v = iovecs; iovecs + nr_vecs != v; ++v) {
+            memcpy(io->buf.get() + off, v->iov_base, v->iov_len);
+            off += v->iov_len;
+        }
+        io->iovecs.push_back(iovec{.iov_base = buf, .iov_len = len});
+    } else {
+        io->iovecs.assign(iovecs, iovecs + nr_vecs); // Only the lengths matter
+    }
+    write_behind_io(state.backup_dev, q, std::move(io), addr, len, addr + _reserved_size, std::move(retire));
+}
+
+// The write dirtied every chunk it touches, and no other write to them was in flight (BehindWindow
+// refuses overlaps): all of them are clean again. clean_region() takes whole chunks.
+void Raid1Disk::__behind_landed(uint64_t addr, uint32_t len) noexcept {
+    auto const chunk = uint64_t{_dirty_bitmap->chunk_size()};
+    auto cur = addr - (addr % chunk);
+    auto const end = ((addr + std::max(len, 1U) + chunk - 1) / chunk) * chunk;
+    while (end > cur)
+        cur += std::get< 2 >(_dirty_bitmap->clean_region(cur, static_cast< uint32_t >(end - cur)));
+}
+
+// For failure sites: a write-behind copy in flight to the region could land after it was resynced
+void Raid1Disk::__dirty_region(uint64_t addr, uint32_t len) {
+    if (_behind) _behind->stale_if_in_flight(addr, len);
+    _dirty_bitmap->dirty_region(addr, len);
+}
+
+void Raid1Disk::__want_repair() {
+    {
+        auto lk = std::scoped_lock(_repair_lock);
+        _repair_wanted = true;
+    }
+    _repair_cv.notify_one();
+}
+
+// Repairs run here, off the write path: degrading writes a superblock
+void Raid1Disk::__repair_loop() {
+    auto lk = std::unique_lock(_repair_lock);
+    while (!_repair_stop) {
+        if (!std::exchange(_repair_wanted, false)) {
+            _repair_cv.wait(lk);
+            continue;
+        }
+        lk.unlock();
+        __repair_behind();
+        lk.lock();
+    }
+}
+
+// Regions are handed over only once no copy in flight touches them, so resync cannot be overtaken
+// by a late one. They have been dirty since they went stale; the array is degraded (without
+// marking the leg unavailable unless a copy failed) so the resync task runs. Holding the lock
+// across the hand-over keeps a copy admitted since from clearing them before the array degrades.
+void Raid1Disk::__repair_behind(bool spawn_resync) {
+    std::lock_guard lock(_clean_transition_mutex);
+    auto stale = _behind->take_stale();
+    if (stale.regions.empty()) return;
+    auto const state = __capture_route_state();
+    RLOGI("Write-behind: {} missed {} region(s), resyncing [uuid:{}]", *state.backup_dev->disk, stale.regions.size(),
+          _str_uuid)
+    for (auto const& [addr, len] : stale.regions)
+        _dirty_bitmap->dirty_region(addr, len);
+    std::ignore = __become_degraded(false, &state, spawn_resync, !stale.failed);
+}
+
+disk_task< int > Raid1Disk::__leg_iov(std::shared_ptr< MirrorDevice > const& dev, ublksrv_queue const* q,
+                                      ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs, uint64_t addr) {
+    if (0 == _slow_threshold_us) return dev->disk->async_iov(q, data, iovecs, nr_vecs, addr);
+    return __timed_iov(dev, q, data, iovecs, nr_vecs, addr);
+}
+
+// Failed I/O is not sampled: errors have their own handling and a fast -EIO says nothing about
+// the leg's speed.
+disk_task< int > Raid1Disk::__timed_iov(std::shared_ptr< MirrorDevice > dev, ublksrv_queue const* q,
+                                        ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs, uint64_t addr) {
+    auto const start = std::chrono::steady_clock::now();
+    auto const r = co_await dev->disk->async_iov(q, data, iovecs, nr_vecs, addr).start();
+    if (r >= 0) {
+        auto const us = std::chrono::duration_cast< std::chrono::microseconds >(std::chrono::steady_clock::now() - start);
+        auto const sample = static_cast< uint32_t >(std::min< int64_t >(us.count(), UINT32_MAX));
+        if (auto const t = dev->latency.record(sample, _slow_threshold_us, LegLatency::now_ns(), _slow_dwell_ns);
+            LegLatency::transition::NONE != t)
+            __on_latency_transition(*dev, t);
+    }
+    co_return r;
+}
+
+void Raid1Disk::__on_latency_transition(MirrorDevice const& dev, LegLatency::transition t) {
+    bool const slow = (LegLatency::transition::BECAME_SLOW == t);
+    bool is_slot_a;
+    {
+        auto lg = std::scoped_lock< std::mutex >(_ctrl_lock);
+        is_slot_a = (&dev == _device_a.get());
+    }
+    if (slow) {
+        RLOGW("Device is fail-slow, demoting from reads: {} [avg:{}us] [uuid:{}]", *dev.disk, dev.latency.ewma_us(),
+              _str_uuid)
+    } else {
+        RLOGI("Device recovered from fail-slow: {} [avg:{}us] [uuid:{}]", *dev.disk, dev.latency.ewma_us(), _str_uuid)
+    }
+    if (_raid_metrics) { // GCOVR_EXCL_BR_LINE -- UblkRaidMetrics requires prometheus registry; not constructible in
+                         // unit tests
+        // LCOV_EXCL_START
+        _raid_metrics->record_device_slow(is_slot_a ? "device_a" : "device_b", slow);
+    } // LCOV_EXCL_STOP
+}
+
+disk_task< int > Raid1Disk::__read_fragment(ublksrv_queue const* q, ublk_io_data const* data, iovec* iov, uint64_t addr,
+                                            bool is_degraded, std::shared_ptr< MirrorDevice > primary_dev,
+                                            std::shared_ptr< MirrorDevice > failover_dev) {
+    auto const r = co_await __leg_iov(primary_dev, q, data, iov, 1, addr + _reserved_size).start();
+    if (r >= 0) {
+        primary_dev->unavail.clear(std::memory_order_release);
+        co_return r;
+    }
+    if (!is_degraded && !primary_dev->unavail.test_and_set(std::memory_order_acq_rel))
+        RLOGW("Device marked unavailable due to read failure: {}", *primary_dev->disk)
+    co_return co_await __leg_iov(failover_dev, q, data, iov, 1, addr + _reserved_size).start();
+}
+
+// Splits in proportion to the leaves behind each leg (even for a plain 2-way mirror), on a
+// logical-block boundary. Legs that are unavailable, write-mostly or slow keep the read whole.
+uint32_t Raid1Disk::__split_point(RouteState const& state, MirrorDevice const& primary, MirrorDevice const& other,
+                                  uint32_t len, uint32_t nr_vecs) const noexcept {
+    if (0 == _split_read_min || len < _split_read_min || 1 != nr_vecs) return 0;
+    for (auto const* dev : {&primary, &other}) {
+        if (dev->unavail.test(std::memory_order_acquire) || dev->write_mostly.load(std::memory_order_relaxed) ||
+            dev->latency.slow())
+            return 0;
+    }
+    auto const wa = uint64_t{_read_weight_a.load(std::memory_order_relaxed)};
+    auto const wb = uint64_t{_read_weight_b.load(std::memory_order_relaxed)};
+    auto const w_primary = (&primary == __route_to_device(state, read_route::DEVA).get()) ? wa : wb;
+    auto const lbs_mask = (uint64_t{1} << params()->basic.logical_bs_shift) - 1;
+    auto const head_len = static_cast< uint32_t >(((len * w_primary) / (wa + wb)) & ~lbs_mask);
+    return (head_len < len) ? head_len : 0;
+}
+
 disk_task< int > Raid1Disk::async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
                                       uint64_t addr) {
     auto const op = ublksrv_get_op(data->iod);
@@ -935,38 +1533,43 @@ disk_task< int > Raid1Disk::async_iov(ublksrv_queue const* q, ublk_io_data const
     if (op == UBLK_IO_OP_READ) co_return co_await __failover_read_async(q, data, iovecs, nr_vecs, addr, len);
 
     // Write / Discard / WriteZeroes: replicate to both devices
+    auto const _epoch = WriteEpochGuard{*this};
     auto const state = __capture_route_state();
 
     // Register this write's LBA range in the region tracker so resync skips only the
     // conflicting chunk rather than pausing globally.
     auto _guard = raid1::ResyncWriteGuard{*_resync_task, addr, len};
     auto const backup_write = __backup_writable(state, addr, len);
+    // Write-behind: the backup's copy is only issued once the active leg holds the data
+    auto const behind = backup_write && __write_behind(state);
 
     auto const adj_addr = addr + _reserved_size;
-    auto active_task = state.active_dev->disk->async_iov(q, data, iovecs, nr_vecs, adj_addr).start();
+    auto active_task = __leg_iov(state.active_dev, q, data, iovecs, nr_vecs, adj_addr).start();
 
     std::optional< hot_task< int > > backup_task;
-    if (backup_write)
-        backup_task.emplace(state.backup_dev->disk->async_iov(q, data, iovecs, nr_vecs, adj_addr).start());
+    if (backup_write && !behind)
+        backup_task.emplace(__leg_iov(state.backup_dev, q, data, iovecs, nr_vecs, adj_addr).start());
 
     auto const active_res = co_await active_task;
 
+    if (active_res < 0 && (behind || __backup_lagging())) {
+        // A backup lacking acked writes cannot take over: fail the write and leave the route be.
+        if (backup_task) std::ignore = co_await *backup_task;
+        co_return active_res;
+    }
     if (active_res < 0) {
         // Site 1: active fails with backup_write==true — newly dirties a clean region.
         // dirty_region() is inside the mutex so __become_clean's dirty_pages() gate
         // cannot pass while this region is in-flight.
         bool const become_degraded_ok = [&] {
             std::lock_guard lock(_clean_transition_mutex);
-            _dirty_bitmap->dirty_region(addr, len);
+            __dirty_region(addr, len);
             return __become_degraded(true, &state);
         }();
-        // CAS lost and no backup to drain — nothing to await.
-        if (!become_degraded_ok && !backup_task) co_return -EAGAIN;
-        // Either __become_degraded succeeded (backup guaranteed by invariant) or failed with a
-        // backup present. Always drain backup before returning: leaving it in-flight while the
-        // coroutine exits is unsafe.
-        DEBUG_ASSERT(!become_degraded_ok || backup_task.has_value(),
-                     "backup_task must exist when become_degraded succeeds"); // LCOV_EXCL_BR_LINE
+        // No backup to drain or fall back on (already degraded, and it is stale here).
+        if (!backup_task) co_return -EAGAIN;
+        // Always drain backup before returning: leaving it in-flight while the coroutine exits is
+        // unsafe.
         auto const backup_res = co_await *backup_task;
         if (!become_degraded_ok) co_return -EAGAIN;
         co_return backup_res >= 0 ? backup_res : -EAGAIN;
@@ -977,14 +1580,34 @@ disk_task< int > Raid1Disk::async_iov(ublksrv_queue const* q, ublk_io_data const
         state.active_dev->unavail.clear(std::memory_order_release);
     }
 
+    if (behind) {
+        switch (_behind->admit(addr, len)) {
+        case BehindWindow::admit_result::BEHIND:
+            // Dirty until the copy lands: the backup lacks the write once it is acked
+            _dirty_bitmap->dirty_region(addr, len);
+            __write_behind_copy(state, q, data, iovecs, nr_vecs, addr, len);
+            co_return active_res;
+        case BehindWindow::admit_result::OVERLAP:
+            // Stale first, so the copy in flight does not clear the region as it lands
+            _behind->mark_stale(addr, len);
+            _dirty_bitmap->dirty_region(addr, len);
+            co_return active_res;
+        case BehindWindow::admit_result::FULL:
+            // The window is full: this write waits on the backup like any other
+            backup_task.emplace(__leg_iov(state.backup_dev, q, data, iovecs, nr_vecs, adj_addr).start());
+            break;
+        }
+    }
+
     if (!backup_write) {
         // Site 2: backup unavailable — dirty_region() is inside the mutex so
         // __become_clean's dirty_pages() gate cannot pass while this region is in-flight.
         bool const become_degraded_ok = [&] {
             std::lock_guard lock(_clean_transition_mutex);
-            _dirty_bitmap->dirty_region(addr, len);
+            __dirty_region(addr, len);
             return __become_degraded(false, &state);
         }();
+        if (state.is_degraded) _resync_task->prioritize(addr, len);
         if (!become_degraded_ok) co_return -EAGAIN;
         co_return active_res;
     }
@@ -995,11 +1618,26 @@ disk_task< int > Raid1Disk::async_iov(ublksrv_queue const* q, ublk_io_data const
         // Site 3: backup write failed — dirty_region() is inside the mutex so
         // __become_clean's dirty_pages() gate cannot pass while this region is in-flight.
         std::lock_guard lock(_clean_transition_mutex);
-        _dirty_bitmap->dirty_region(addr, len);
+        __dirty_region(addr, len);
         if (auto d = __become_degraded(false, &state); !d) co_return -EAGAIN;
     } else if (state.backup_dev->unavail.test(std::memory_order_relaxed)) {
         RLOGI("Device {} back online (write succeeded) [uuid:{}]", *state.backup_dev->disk, _str_uuid)
         state.backup_dev->unavail.clear(std::memory_order_release);
+    } else if (auto const slow_active = state.active_dev->latency.slow();
+               _slow_degrade && !state.is_degraded && slow_active != state.backup_dev->latency.slow() &&
+               !(slow_active && __backup_lagging())) {
+        // Fail-slow: both legs took the write, but one keeps dragging the array down. Degrade it as
+        // if this write had failed there (Site 1 or 3); the region is dirtied so resync re-copies it.
+        // Only once it has been slow for a full dwell: the demotion from reads comes first. Reset,
+        // it then holds CLEAN for another, so a leg cannot cycle through degrade and resync faster.
+        auto const& slow_dev = slow_active ? state.active_dev : state.backup_dev;
+        auto const now = LegLatency::now_ns();
+        if (_slow_dwell_ns > slow_dev->latency.dwell_ns(now)) co_return active_res;
+        std::lock_guard lock(_clean_transition_mutex);
+        __dirty_region(addr, len);
+        if (auto d = __become_degraded(slow_active, &state); !d) co_return -EAGAIN;
+        slow_dev->latency.reset(now);
+        co_return slow_active ? backup_res : active_res;
     }
 
     co_return active_res;
@@ -1011,6 +1649,8 @@ io_result Raid1Disk::sync_iov(uint8_t op, iovec* iovecs, uint32_t nr_vecs, off_t
     RLOGT("Received {}: [lba:{:#0x}|len:{:#0x}] [uuid:{}]", op == UBLK_IO_OP_READ ? "READ" : "WRITE", lba, len,
           _str_uuid)
 
+    auto epoch = std::optional< WriteEpochGuard >{};
+    if (UBLK_IO_OP_READ != op) epoch.emplace(*this);
     auto const state = __capture_route_state();
     auto const adj_addr = addr + static_cast< off_t >(_reserved_size);
 
@@ -1037,19 +1677,19 @@ io_result Raid1Disk::sync_iov(uint8_t op, iovec* iovecs, uint32_t nr_vecs, off_t
 
     auto const active_res = state.active_dev->disk->sync_iov(op, iovecs, nr_vecs, adj_addr);
 
+    // A backup lacking acked writes (write-behind) cannot take over: fail the write instead.
+    if (!active_res && __backup_lagging()) return active_res;
     if (!active_res) {
         // Site 1 (sync): active fails — dirty_region() is inside the mutex so
         // __become_clean's dirty_pages() gate cannot pass while this region is in-flight.
         bool const become_degraded_ok = [&] {
             std::lock_guard lock(_clean_transition_mutex);
-            _dirty_bitmap->dirty_region(static_cast< uint64_t >(addr), len);
+            __dirty_region(static_cast< uint64_t >(addr), len);
             return __become_degraded(true, &state);
         }();
-        if (!become_degraded_ok)
+        // Already degraded with the backup stale here: nothing to fall back on.
+        if (!become_degraded_ok || !backup_write)
             return std::unexpected(std::make_error_condition(std::errc::resource_unavailable_try_again));
-        // become_degraded succeeded → state was EITHER → bm was WRITE → backup is reachable.
-        DEBUG_ASSERT(backup_write,
-                     "backup_write must be true when become_degraded succeeds"); // LCOV_EXCL_BR_LINE
         auto const backup_res = state.backup_dev->disk->sync_iov(op, iovecs, nr_vecs, adj_addr);
         return backup_res ? backup_res
                           : std::unexpected(std::make_error_condition(std::errc::resource_unavailable_try_again));
@@ -1065,13 +1705,20 @@ io_result Raid1Disk::sync_iov(uint8_t op, iovec* iovecs, uint32_t nr_vecs, off_t
         // __become_clean's dirty_pages() gate cannot pass while this region is in-flight.
         bool const become_degraded_ok = [&] {
             std::lock_guard lock(_clean_transition_mutex);
-            _dirty_bitmap->dirty_region(static_cast< uint64_t >(addr), len);
+            __dirty_region(static_cast< uint64_t >(addr), len);
             return __become_degraded(false, &state);
         }();
+        if (state.is_degraded) _resync_task->prioritize(static_cast< uint64_t >(addr), len);
         if (!become_degraded_ok)
             return std::unexpected(std::make_error_condition(std::errc::resource_unavailable_try_again));
         return active_res;
     }
+    // sync_iov issues no write-behind copies, but one of async_iov's may be in flight here and land
+    // after this write: leave the region to resync.
+    if (_behind && _behind->stale_if_in_flight(static_cast< uint64_t >(addr), len)) {
+        _dirty_bitmap->dirty_region(static_cast< uint64_t >(addr), len);
+        return active_res;
+    }
 
     auto const backup_res = state.backup_dev->disk->sync_iov(op, iovecs, nr_vecs, adj_addr);
 
@@ -1079,7 +1726,7 @@ io_result Raid1Disk::sync_iov(uint8_t op, iovec* iovecs, uint32_t nr_vecs, off_t
         // Site 3 (sync): backup write failed — dirty_region() is inside the mutex so
         // __become_clean's dirty_pages() gate cannot pass while this region is in-flight.
         std::lock_guard lock(_clean_transition_mutex);
-        _dirty_bitmap->dirty_region(static_cast< uint64_t >(addr), len);
+        __dirty_region(static_cast< uint64_t >(addr), len);
         if (auto d = __become_degraded(false, &state); !d)
             return std::unexpected(std::make_error_condition(std::errc::resource_unavailable_try_again));
     } else if (state.backup_dev->unavail.test(std::memory_order_relaxed)) {
@@ -1090,6 +1737,13 @@ io_result Raid1Disk::sync_iov(uint8_t op, iovec* iovecs, uint32_t nr_vecs, off_t
     return active_res;
 }
 
+// A missing leg takes no I/O, so it does not hold the mirror back
+bool Raid1Disk::scatter_gather() const noexcept {
+    auto const state = __capture_route_state();
+    return (state.active_dev->disk->is_missing() || state.active_dev->disk->scatter_gather()) &&
+        (state.backup_dev->disk->is_missing() || state.backup_dev->disk->scatter_gather());
+}
+
 void Raid1Disk::probe_tick(ublksrv_queue const*) noexcept {
     auto const state = __capture_route_state();
     if (state.is_degraded) return; // resync task handles probing in degraded mode
@@ -1146,11 +1800,56 @@ std::pair< std::shared_ptr< ublk_disk >, std::shared_ptr< ublk_disk > > replicas
     return r1->replicas();
 }
 
+bool set_write_mostly(ublk_disk& disk, std::string const& device_id, bool write_mostly) {
+    auto* r1 = as_raid1(disk);
+    if (!r1) {
+        RLOGW("set_write_mostly called on non-Raid1 disk: {}", disk);
+        return false;
+    }
+    return r1->set_write_mostly(device_id, write_mostly);
+}
+
+std::shared_ptr< ublk_disk > split_mirror(ublk_disk& disk, std::string const& device_id) {
+    auto* r1 = as_raid1(disk);
+    if (!r1) {
+        RLOGW("split_mirror called on non-Raid1 disk: {}", disk);
+        return nullptr;
+    }
+    return r1->split_mirror(device_id);
+}
+
+bool rejoin_mirror(ublk_disk& disk, std::shared_ptr< ublk_disk > leg) {
+    auto* r1 = as_raid1(disk);
+    if (!r1) {
+        RLOGW("rejoin_mirror called on non-Raid1 disk: {}", disk);
+        return false;
+    }
+    return r1->rejoin_mirror(std::move(leg));
+}
+
 } // namespace raid1
 
 std::shared_ptr< ublk_disk > make_raid1_disk(boost::uuids::uuid const& uuid, std::shared_ptr< ublk_disk > dev_a,
-                                             std::shared_ptr< ublk_disk > dev_b, std::string const& parent_id) {
-    return std::make_shared< raid1::Raid1Disk >(uuid, std::move(dev_a), std::move(dev_b), parent_id);
+                                             std::shared_ptr< ublk_disk > dev_b, std::string const& parent_id,
+                                             std::shared_ptr< ublk_disk > meta) {
+    return std::make_shared< raid1::Raid1Disk >(uuid, std::move(dev_a), std::move(dev_b), parent_id, std::move(meta));
+}
+
+std::shared_ptr< ublk_disk > make_raid1_disk(boost::uuids::uuid const& uuid,
+                                             std::vector< std::shared_ptr< ublk_disk > >&& legs,
+                                             std::string const& parent_id) {
+    if (2 > legs.size()) throw std::invalid_argument(fmt::format("RAID1 requires at least 2 legs, got {}", legs.size()));
+
+    // Assemble from the tail: the last two legs form the innermost mirror and each earlier leg
+    // mirrors the chain behind it. Nested mirrors get a UUID derived from the array's UUID and
+    // their depth, so passing the same legs in the same order re-assembles the same chain.
+    auto chain = std::move(legs.back());
+    for (auto depth = legs.size() - 1; 0 < depth--;) {
+        auto const level_uuid =
+            (0 == depth) ? uuid : boost::uuids::name_generator_sha1(uuid)(fmt::format("raid1-chain-{}", depth));
+        chain = std::make_shared< raid1::Raid1Disk >(level_uuid, std::move(legs[depth]), std::move(chain), parent_id);
+    }
+    return chain;
 }
 
 } // namespace ublkpp
@@ -1,11 +1,19 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <thread>
 
 #include "ublkpp/raid.hpp"
 #include "metrics/ublk_raid_metrics.hpp"
+#include "leg_latency.hpp"
 #include "raid1_superblock.hpp"
+#include "write_behind.hpp"
 
 namespace ublkpp {
 
@@ -22,6 +30,11 @@ struct MirrorDevice {
     std::shared_ptr< SuperBlock > sb; // Only used during load_superblock time
     std::atomic_flag
         unavail; // not ready for IO; also set at startup self-heal to prevent SB writes that would destroy the age gap
+    // Runtime-only: excluded from read selection while the other leg can serve the read, and the
+    // lagging side of write-behind. Not persisted; a swapped-in device starts cleared.
+    std::atomic< bool > write_mostly{false};
+    // Runtime-only fail-slow detector; a SLOW leg is dropped from read selection like write_mostly.
+    LegLatency latency;
 
     bool new_device{true};
 };
@@ -34,6 +47,14 @@ class Raid1Disk : public ublk_disk {
     std::shared_ptr< MirrorDevice > _device_a;
     std::shared_ptr< MirrorDevice > _device_b;
 
+    // External bitmap: when set, the bitmap pages (and a copy of the superblock vouching for them)
+    // live on this device at the same offsets a leg would use, and each leg reserves only its
+    // superblock page. _meta_trusted is true when the on-disk pages match the selected superblock
+    // (same age, as for a leg's own pages); otherwise a degraded array falls back to a full resync.
+    std::shared_ptr< ublk_disk > _meta;
+    bool _meta_new{false};
+    bool _meta_trusted{false};
+
     // Persistent state
     std::shared_ptr< raid1::SuperBlock > _sb;
     std::shared_ptr< raid1::Bitmap > _dirty_bitmap;
@@ -41,6 +62,12 @@ class Raid1Disk : public ublk_disk {
     // Runtime cached state (to avoid races on _sb bitfields)
     std::atomic< raid1::read_route > _read_route_cache{raid1::read_route::EITHER};
 
+    // Number of leaf replicas behind each slot; > 1 when the slot holds a nested mirror of an
+    // N-way chain. Unequal weights switch read selection from round-robin to a chunk-address
+    // spread so every leaf serves an equal share of reads.
+    std::atomic< uint32_t > _read_weight_a{1};
+    std::atomic< uint32_t > _read_weight_b{1};
+
     // Metrics
     std::shared_ptr< ublkpp::UblkRaidMetrics > _raid_metrics;
     // Active Re-Sync Task
@@ -59,7 +86,8 @@ class Raid1Disk : public ublk_disk {
     //   (a) dirty_pages() sees all in-flight regions — prevents premature clean transition.
     //   (b) Failure-path DEVA SB writes always serialize after EITHER SB writes, so the
     //       on-disk SBs cannot show EITHER+dirty on crash (crash-recovery P0).
-    // The success path (both legs succeed) does not hold this lock.
+    // The success path (both legs succeed) does not hold this lock; a write-behind copy retires
+    // under it, as it may clear its region (__write_behind_copy).
     std::mutex _clean_transition_mutex;
 
     // Counts prepare() calls; used to enable resync on the first queue init.
@@ -87,19 +115,101 @@ class Raid1Disk : public ublk_disk {
     // likewise. Used identically by both async_iov and sync_iov.
     bool __backup_writable(RouteState const& state, uint64_t addr, uint32_t len) const noexcept;
 
+    // Write-behind: a write-mostly backup leg may lag the active leg by up to this many bytes of
+    // writes in flight (0 disables). Their requests are acked once the active leg completes, their
+    // region dirtied first, and the copy to the backup runs on detached (a detached_io on its
+    // queue), tracked in _behind; the destructor waits for the copies. A copy that lands clears its
+    // region again. While the backup lags it serves no reads and never takes over from a failing
+    // active leg. Regions it missed (a failed or refused copy) stay dirty and are resynced by
+    // __repair_behind, which _repair_thread runs when a copy retires with some pending.
+    uint64_t const _write_behind_max{0};
+    std::shared_ptr< raid1::BehindWindow > _behind;
+    uint32_t _leg_sqes{1}; // Most SQEs a single leg issues for one I/O (prepare)
+    std::mutex _repair_lock;
+    std::condition_variable _repair_cv;
+    bool _repair_wanted{false}; // Guarded by _repair_lock
+    bool _repair_stop{false};   // Guarded by _repair_lock
+    std::thread _repair_thread;
+    bool __write_behind(RouteState const& state) const noexcept;
+    bool __backup_lagging() const noexcept { return _behind && _behind->lagging(); }
+    void __write_behind_copy(RouteState const& state, ublksrv_queue const* q, ublk_io_data const* data,
+                             iovec const* iovecs, uint32_t nr_vecs, uint64_t addr, uint32_t len);
+    void __behind_landed(uint64_t addr, uint32_t len) noexcept;
+    void __dirty_region(uint64_t addr, uint32_t len);
+    void __want_repair();
+    void __repair_loop();
+    void __repair_behind(bool spawn_resync = true);
+
+    // Writes in flight, counted per epoch. split_mirror() advances the epoch after its cut and waits
+    // out the previous one: those writes captured the route before the cut and may still land on
+    // the outgoing leg. A write counts itself before capturing the route, so it either sees the cut
+    // or is waited for (the seq_cst fences on both sides order the two). Writes count themselves in
+    // one of k_write_shards cache lines, picked per thread, so queues never contend on them.
+    static constexpr uint32_t k_write_shards{16};
+    struct alignas(64) write_shard {
+        std::array< std::atomic< uint32_t >, 2 > n{};
+    };
+    std::atomic< uint32_t > _write_epoch{0};
+    std::array< write_shard, k_write_shards > _epoch_writes{};
+    class WriteEpochGuard {
+    public:
+        explicit WriteEpochGuard(Raid1Disk& raid) noexcept {
+            static thread_local auto const shard =
+                static_cast< uint32_t >(std::hash< std::thread::id >{}(std::this_thread::get_id()) % k_write_shards);
+            _count = &raid._epoch_writes[shard].n[raid._write_epoch.load(std::memory_order_relaxed) & 1];
+            _count->fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        ~WriteEpochGuard() noexcept { _count->fetch_sub(1, std::memory_order_release); }
+        WriteEpochGuard(WriteEpochGuard&&) = delete;
+        WriteEpochGuard(WriteEpochGuard const&) = delete;
+        WriteEpochGuard& operator=(WriteEpochGuard&&) = delete;
+        WriteEpochGuard& operator=(WriteEpochGuard const&) = delete;
+
+    private:
+        std::atomic< uint32_t >* _count{nullptr};
+    };
+    void __drain_writes() noexcept;
+
     // Internal routines
     bool __become_clean();
     // Transitions in-memory route from EITHER→DEVA/DEVB and persists the superblock. Returns true
     // if the array is durably degraded (ack is safe); false if the SB write failed (caller must
     // return -EAGAIN — a crash before the SB is written would corrupt self-heal direction).
     // Idempotent when already degraded: delegates to __try_persist_degraded_sb.
-    bool __become_degraded(bool failed_is_active, RouteState const* state, bool spawn_resync = true);
+    // lagging=true is the write-behind entry: the backup is healthy but missed some writes, so it
+    // is neither marked unavailable nor counted as a degradation event.
+    bool __become_degraded(bool failed_is_active, RouteState const* state, bool spawn_resync = true,
+                           bool lagging = false);
     // Called from __become_degraded when the array is already degraded. Retries any pending SB
     // write (_degraded_sb_pending) and, on success, optionally spawns resync. Returns true if the
     // SB is now durable (no write was pending, or the retry succeeded); false if the retry failed.
     bool __try_persist_degraded_sb(bool spawn_resync);
     disk_task< int > __failover_read_async(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs,
                                            uint32_t nr_vecs, uint64_t addr, uint32_t len);
+    disk_task< int > __read_fragment(ublksrv_queue const* q, ublk_io_data const* data, iovec* iov, uint64_t addr,
+                                     bool is_degraded, std::shared_ptr< MirrorDevice > primary_dev,
+                                     std::shared_ptr< MirrorDevice > failover_dev);
+
+    // Striped reads: a single-buffer read of at least this many bytes whose region is valid on
+    // both legs is split into one fragment per leg (0 disables). __split_point returns the length
+    // of the primary leg's fragment, or 0 when the read should not be split.
+    uint32_t const _split_read_min{0};
+
+    // Fail-slow detection: leg I/O in async_iov is timed when _slow_threshold_us is non-zero. A leg
+    // that trips its LegLatency leaves read rotation; with _slow_degrade it is also degraded while
+    // the other leg is healthy, and measured afresh once resync brings it back. Either state is
+    // held for at least _slow_dwell_ns.
+    uint32_t const _slow_threshold_us{0};
+    bool const _slow_degrade{false};
+    uint64_t const _slow_dwell_ns{LegLatency::k_default_dwell_ns};
+    disk_task< int > __leg_iov(std::shared_ptr< MirrorDevice > const& dev, ublksrv_queue const* q,
+                               ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs, uint64_t addr);
+    disk_task< int > __timed_iov(std::shared_ptr< MirrorDevice > dev, ublksrv_queue const* q, ublk_io_data const* data,
+                                 iovec* iovecs, uint32_t nr_vecs, uint64_t addr);
+    void __on_latency_transition(MirrorDevice const& dev, LegLatency::transition t);
+    uint32_t __split_point(RouteState const& state, MirrorDevice const& primary, MirrorDevice const& other,
+                           uint32_t len, uint32_t nr_vecs) const noexcept;
     bool __swap_device(std::string const& outgoing_device_id, std::shared_ptr< MirrorDevice >& incoming_mirror,
                        raid1::read_route const& cur_route);
 
@@ -108,9 +218,16 @@ class Raid1Disk : public ublk_disk {
     // decide the user-data alignment policy.
     void __load_and_select_superblock(boost::uuids::uuid const& uuid, std::shared_ptr< ublk_disk > dev_a,
                                       std::shared_ptr< ublk_disk > dev_b, std::string const& parent_id);
+    void __load_meta_superblock(boost::uuids::uuid const& uuid);
     void __init_params();
     void __init_bitmap_and_degraded_route();
+    // Device holding the bitmap pages for `leg`: the metadata device when there is one.
+    std::shared_ptr< ublk_disk > const& __bitmap_device(std::shared_ptr< ublk_disk > const& leg) const noexcept {
+        return _meta ? _meta : leg;
+    }
+    void __load_bitmap(std::shared_ptr< ublk_disk > const& leg);
     void __become_active();
+    void __update_read_weights() noexcept;
 
     // ☠️ ☠️ ☠️  DANGER: LOCK-FREE SYNCHRONIZATION - DO NOT MODIFY  ☠️ ☠️ ☠️
     //
@@ -150,7 +267,7 @@ class Raid1Disk : public ublk_disk {
 
 public:
     Raid1Disk(boost::uuids::uuid const& uuid, std::shared_ptr< ublk_disk > dev_a, std::shared_ptr< ublk_disk > dev_b,
-              std::string const& parent_id = "");
+              std::string const& parent_id = "", std::shared_ptr< ublk_disk > meta = nullptr);
     ~Raid1Disk() override;
 
     /// Raid1Disk API
@@ -160,12 +277,18 @@ public:
     uint64_t reserved_size() const noexcept { return _reserved_size; }
     void toggle_resync(bool t);
     std::pair< std::shared_ptr< ublk_disk >, std::shared_ptr< ublk_disk > > replicas() const noexcept;
+    // Leaf replicas of this mirror, counting through nested Raid1Disk legs of an N-way chain.
+    uint32_t replica_count() const noexcept;
+    bool set_write_mostly(std::string const& device_id, bool write_mostly);
+    std::shared_ptr< ublk_disk > split_mirror(std::string const& device_id);
+    bool rejoin_mirror(std::shared_ptr< ublk_disk > leg);
     /// =============
 
     /// UBlkDisk Interface Overrides
     /// ============================
     std::string id() const noexcept override { return "RAID1"; }
     prepare_result prepare(ublksrv_queue const* q, int const iouring_device) override;
+    bool scatter_gather() const noexcept override;
     void probe_tick(ublksrv_queue const* q) noexcept override;
 
     disk_task< int > async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
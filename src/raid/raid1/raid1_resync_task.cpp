@@ -1,7 +1,10 @@
 #include "raid1_resync_task.hpp"
 
+#include <linux/ioprio.h>
 #include <pthread.h>
 #include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include <ublksrv.h>
 #include <sisl/utility/thread_factory.hpp>
 
@@ -11,15 +14,26 @@
 
 namespace ublkpp::raid1 {
 
+// Resync I/O is issued synchronously from its own thread, so the thread's ioprio is what reaches
+// the legs. Idle by default: resync then only gets a leg's bandwidth that front I/O leaves unused.
+static void set_resync_ioprio() {
+    auto const cls = (SISL_OPTIONS["resync_ioprio"].as< std::string >() == "be") ? IOPRIO_CLASS_BE : IOPRIO_CLASS_IDLE;
+    if (0 != syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_PRIO_VALUE(cls, 0)))
+        RLOGW("resync thread: failed to set I/O priority: {}", strerror(errno))
+}
+
 Raid1ResyncTask::Raid1ResyncTask(std::shared_ptr< raid1::Bitmap >& bitmap, uint64_t offset, uint32_t io_size,
                                  uint32_t max_io, uint32_t slot_count, uint32_t chunk_size,
-                                 std::shared_ptr< ublkpp::UblkRaidMetrics > metrics) :
+                                 std::shared_ptr< ublkpp::UblkRaidMetrics > metrics,
+                                 std::shared_ptr< ublk_disk > bitmap_device) :
         _dirty_bitmap(bitmap),
         _metrics(metrics),
+        _bitmap_device(std::move(bitmap_device)),
         _io_size(io_size),
         _max_size(max_io),
         _offset(offset),
         _region_tracker(slot_count, chunk_size),
+        _hot_regions(slot_count, chunk_size),
         _resync_task() {
     if (!_dirty_bitmap) throw std::runtime_error("No Bitmap");
 }
@@ -200,6 +214,7 @@ void Raid1ResyncTask::launch(std::string const& str_uuid, std::shared_ptr< Mirro
                                           sched_param sp{.sched_priority = 0};
                                           if (int rc = pthread_setschedparam(pthread_self(), SCHED_OTHER, &sp); rc != 0)
                                               RLOGE("resync thread: failed to reset to SCHED_OTHER: {}", strerror(rc))
+                                          set_resync_ioprio();
                                           _start(uuid, clean, dirty, std::move(compl_cb));
                                       });
 }
@@ -207,6 +222,8 @@ void Raid1ResyncTask::launch(std::string const& str_uuid, std::shared_ptr< Mirro
 void Raid1ResyncTask::__clean(uint64_t addr, uint32_t len, MirrorDevice& clean_mirror) {
     auto const pg_size = _dirty_bitmap->page_size();
     auto iov = iovec{.iov_base = nullptr, .iov_len = pg_size};
+    // With a metadata device the legs only reserve the superblock: this offset is user data there.
+    auto& device = _bitmap_device ? *_bitmap_device : *clean_mirror.disk;
 
     auto const end = addr + len;
     auto cur_off = addr;
@@ -220,8 +237,8 @@ void Raid1ResyncTask::__clean(uint64_t addr, uint32_t len, MirrorDevice& clean_m
 
         // These don't actually need to succeed; this page will remain dirty and loaded the next time
         // we use this bitmap (extra copies for this page).
-        if (auto res = clean_mirror.disk->sync_iov(UBLK_IO_OP_WRITE, &iov, 1, page_addr); !res) {
-            RLOGW("Failed to clear bitmap page to: {}", *clean_mirror.disk)
+        if (auto res = device.sync_iov(UBLK_IO_OP_WRITE, &iov, 1, page_addr); !res) {
+            RLOGW("Failed to clear bitmap page to: {}", device)
         }
     }
 }
@@ -239,6 +256,38 @@ static inline io_result __copy_region(iovec* iovec, int nr_vecs, uint64_t addr,
     return res;
 }
 
+bool Raid1ResyncTask::__repair_hot_regions(auto& clean_mirror, auto& dirty_mirror, iovec* iov,
+                                           uint32_t& copies_left) noexcept {
+    while (0U < copies_left) {
+        auto const hot = _hot_regions.pop();
+        if (!hot) break;
+
+        // The sweep (or an earlier hint) may have repaired the region since it was queued.
+        auto const [logical_off, sz] = _dirty_bitmap->next_dirty_after(*hot);
+        if (0 == sz || *hot != logical_off) continue;
+
+        // Same two-phase conflict check as the sweep; a conflicting region is left for the
+        // sweep rather than re-queued so a write-hot chunk cannot monopolize the resync.
+        auto const iov_len = std::min(sz, _max_size);
+        auto const gen_before = _region_tracker.snapshot_gen();
+        if (_region_tracker.overlaps(logical_off, iov_len)) continue;
+
+        iov->iov_len = iov_len;
+        if (auto res = __copy_region(iov, 1, logical_off + _offset, *clean_mirror->disk, *dirty_mirror->disk); !res) {
+            dirty_mirror->unavail.test_and_set(std::memory_order_acq_rel);
+            return false;
+        }
+        if (!_region_tracker.overlaps(logical_off, iov_len) &&
+            !_region_tracker.completed_since(logical_off, iov_len, gen_before)) {
+            __clean(logical_off, iov->iov_len, *clean_mirror);
+            if (_metrics) { _metrics->record_resync_progress(iov->iov_len); } // GCOVR_EXCL_BR_LINE
+        }
+        RLOGT("Resync repaired hot region [lba:{:#0x}|len:{:#0x}]", logical_off, iov_len)
+        --copies_left;
+    }
+    return true;
+}
+
 resync_state Raid1ResyncTask::__run(auto& clean_mirror, auto& dirty_mirror, iovec* iov) noexcept {
     static auto const unavail_delay = std::chrono::seconds(SISL_OPTIONS["avail_delay"].as< uint32_t >());
     static auto const avail_delay = std::chrono::microseconds(SISL_OPTIONS["resync_delay"].as< uint32_t >());
@@ -271,6 +320,13 @@ resync_state Raid1ResyncTask::__run(auto& clean_mirror, auto& dirty_mirror, iove
         // TODO Change this so it's easier to control with a future QoS algorithm
         auto copies_left = ((std::min(32U, SISL_OPTIONS["resync_level"].as< uint32_t >()) * 100U) / 32U) * 5U;
 
+        // Regions the I/O path is actively hitting go first; they share this sweep's copy budget.
+        if (!_hot_regions.empty() && !__repair_hot_regions(clean_mirror, dirty_mirror, iov, copies_left)) {
+            if (cur_state = __yield(unavail_delay, avail_delay); resync_state::STOPPING == cur_state) break;
+            nr_pages = _dirty_bitmap->dirty_pages();
+            continue;
+        }
+
         // Use the skip cursor if a fully-conflicting run was detected last sweep.
         auto [logical_off, sz] =
             resync_skip_from > 0 ? _dirty_bitmap->next_dirty_after(resync_skip_from) : _dirty_bitmap->next_dirty();
@@ -7,6 +7,7 @@
 #include <thread>
 
 #include "metrics/ublk_raid_metrics.hpp"
+#include "hot_region_queue.hpp"
 #include "raid1_superblock.hpp"
 #include "region_tracker.hpp"
 #include "ublkpp/raid.hpp"
@@ -52,6 +53,8 @@ class Raid1ResyncTask {
 
     std::shared_ptr< raid1::Bitmap > const _dirty_bitmap;
     std::shared_ptr< ublkpp::UblkRaidMetrics > const _metrics;
+    // Where cleaned bitmap pages are written: the metadata device, or the clean leg when null
+    std::shared_ptr< ublk_disk > const _bitmap_device;
 
     // The smallest I/O both devices support (RAID logical block size)
     uint32_t const _io_size;
@@ -68,6 +71,10 @@ class Raid1ResyncTask {
     // unrelated regions proceed without any global pause.
     RegionTracker _region_tracker;
 
+    // Dirty regions foreground I/O touched while degraded; repaired ahead of the LBA sweep so
+    // hot data stops being served from a single leg as early as possible.
+    HotRegionQueue _hot_regions;
+
     std::mutex _launch_lock;
     std::thread _resync_task;
 
@@ -80,6 +87,10 @@ class Raid1ResyncTask {
 
     resync_state __run(auto& clean_mirror, auto& dirty_mirror, iovec* iov) noexcept;
 
+    // Drains _hot_regions, copying each still-dirty region before the sweep resumes. Returns
+    // false if a copy failed (the dirty mirror has been marked unavailable).
+    bool __repair_hot_regions(auto& clean_mirror, auto& dirty_mirror, iovec* iov, uint32_t& copies_left) noexcept;
+
     // Generic state transition helper - reduces duplication across launch/stop.
     // noinline: gcov attributes inlined template instructions to the call-site line numbers
     // rather than to the template body, making the entire retry loop appear uncovered.
@@ -96,7 +107,8 @@ class Raid1ResyncTask {
 public:
     Raid1ResyncTask(std::shared_ptr< raid1::Bitmap >& bitmap, uint64_t offset, uint32_t io_size, uint32_t max_io,
                     uint32_t slot_count = k_default_slot_count, uint32_t chunk_size = k_min_chunk_size,
-                    std::shared_ptr< ublkpp::UblkRaidMetrics > metrics = nullptr);
+                    std::shared_ptr< ublkpp::UblkRaidMetrics > metrics = nullptr,
+                    std::shared_ptr< ublk_disk > bitmap_device = nullptr);
     ~Raid1ResyncTask() noexcept;
 
     // Probe a mirror device: reads at reserved_size, clears unavail on success,
@@ -113,6 +125,10 @@ public:
 
     void dequeue_write(uint64_t lba, uint32_t len) noexcept { _region_tracker.untrack(lba, len); }
 
+    // Hint that [lba, lba+len) is dirty and being accessed; the resync task repairs every chunk of
+    // it before continuing its sweep. Cheap and non-blocking — safe to call from the I/O path.
+    void prioritize(uint64_t lba, uint32_t len) noexcept { _hot_regions.push_range(lba, len); }
+
     // Number of times __yield() has been called. Tests poll this to wait for at least one
     // resync sweep without relying on wall-clock timing.
     uint64_t yield_count() const noexcept { return _yield_count.load(std::memory_order_acquire); }
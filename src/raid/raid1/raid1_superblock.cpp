@@ -10,10 +10,11 @@ namespace ublkpp::raid1 {
 auto format_as(SuperBlock const& sb) {
     auto read_uuid = boost::uuids::uuid();
     memcpy(read_uuid.data, sb.header.uuid, sizeof(sb.header.uuid));
-    return fmt::format("[uuid:{}, ver:{:#0x}, age:{}, chunk_sz:{}Ki, read_route:{} (Side-{}:{})]", to_string(read_uuid),
-                       be16toh(sb.header.version), be64toh(sb.fields.bitmap.age),
+    return fmt::format("[uuid:{}, ver:{:#0x}, age:{}, chunk_sz:{}Ki, read_route:{} (Side-{}:{}){}]",
+                       to_string(read_uuid), be16toh(sb.header.version), be64toh(sb.fields.bitmap.age),
                        be32toh(sb.fields.bitmap.chunk_size) / Ki, static_cast< read_route >(sb.fields.read_route),
-                       sb.fields.device_b ? "B" : "A", sb.fields.clean_unmount ? "Clean" : "Active");
+                       sb.fields.device_b ? "B" : "A", sb.fields.clean_unmount ? "Clean" : "Active",
+                       sb.fields.ext_bitmap ? " ext-bitmap" : "");
 }
 
 raid1::SuperBlock* pick_superblock(raid1::SuperBlock* dev_a, raid1::SuperBlock* dev_b) {
@@ -126,9 +127,10 @@ load_superblock(ublk_disk& device, boost::uuids::uuid const& uuid, uint32_t cons
         RLOGE("Superblock did not have a matching UUID expected: {} read: {}", to_string(uuid), to_string(read_uuid))
         return std::unexpected(std::make_error_condition(std::errc::invalid_argument));
     }
-    if (be16toh(sb->header.version) > k_sb_version) {
+    if (auto const supported = sb->fields.ext_bitmap ? k_sb_version_ext : k_sb_version;
+        be16toh(sb->header.version) > supported) {
         RLOGE("Superblock version {:#0x} is newer than supported {:#0x} — refusing to open",
-              be16toh(sb->header.version), k_sb_version)
+              be16toh(sb->header.version), supported)
         return std::unexpected(std::make_error_condition(std::errc::not_supported));
     }
     if (chunk_size != be32toh(sb->fields.bitmap.chunk_size)) {
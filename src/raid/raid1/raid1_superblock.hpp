@@ -17,6 +17,9 @@ namespace ublkpp {
 namespace raid1 {
 constexpr auto const k_bits_in_byte = 8UL;
 constexpr uint16_t k_sb_version = 2;
+// Stamped on arrays whose bitmap lives on a metadata device (fields.ext_bitmap). Builds that
+// predate it refuse the array rather than misplace user data by the legs' reserved region.
+constexpr uint16_t k_sb_version_ext = 3;
 //  Cap some array parameters so we can make simple assumptions later
 constexpr auto k_min_chunk_size = 32 * Ki;
 // Use a single bit to represent each chunk
@@ -39,7 +42,8 @@ struct __attribute__((__packed__)) SuperBlock {
     } header;             // 34 bytes
     struct {
         // was cleanly unmounted, position in RAID1 and current Healthy device
-        uint8_t clean_unmount : 1, read_route : 2, device_b : 1, : 0;
+        // ext_bitmap: bitmap pages live on a separate metadata device; the legs reserve only this page
+        uint8_t clean_unmount : 1, read_route : 2, device_b : 1, ext_bitmap : 1, : 0;
         struct {
             uint8_t _reserved[16]; // Unused
             uint32_t chunk_size;   // Number of bytes each bit represents
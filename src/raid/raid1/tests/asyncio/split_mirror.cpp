@@ -0,0 +1,38 @@
+// Split-mirror fences writes in flight: the detached leg is handed out only once every write that
+// captured the route before the split has completed on it.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "async_raid1_common.hpp"
+
+using namespace std::chrono_literals;
+using ublkpp::raid1::replica_state;
+
+TEST_F(AsyncRaid1Fixture, SplitMirrorDrainsWritesInFlight) {
+    std::thread([this] {
+        ASSERT_TRUE(mock->submit_io(0, UBLK_IO_OP_WRITE, 0, 4 * Ki / 512, mock->io_buf(0)));
+        ASSERT_TRUE(mock->inject_cqe(0, 4 * Ki).empty()); // DiskA done, DiskB still in flight
+
+        std::atomic< bool > split{false};
+        auto leg = std::shared_ptr< ublk_disk >{};
+        auto splitter = std::thread([&] {
+            leg = ublkpp::raid1::split_mirror(*raid, "DiskB");
+            split.store(true, std::memory_order_release);
+        });
+        std::this_thread::sleep_for(20ms);
+        EXPECT_FALSE(split.load(std::memory_order_acquire));
+
+        auto completions = mock->inject_cqe(0, 4 * Ki);
+        ASSERT_EQ(completions.size(), 1u);
+        EXPECT_EQ(completions[0].result, 4 * Ki);
+        splitter.join();
+        EXPECT_EQ(disk_b, leg);
+
+        // The write reached both legs before the cut: nothing for a rejoin to resync
+        auto const state = raid->replica_states();
+        EXPECT_EQ(replica_state::CLEAN, state.device_a);
+        EXPECT_EQ(0UL, state.bytes_to_sync);
+    }).join();
+}
@@ -0,0 +1,72 @@
+// Striped reads: a large read of a clean region is issued as one fragment per leg. Only meaningful
+// when the binary is invoked with --split_read (8-64 KiB); skipped otherwise (see CMakeLists.txt:
+// Raid1SplitRead target).
+
+#include <sisl/options/options.h>
+
+#include "async_raid1_common.hpp"
+
+TEST_F(AsyncRaid1Fixture, SplitReadBothLegs) {
+    if (SISL_OPTIONS["split_read"].as< uint32_t >() == 0) GTEST_SKIP();
+    std::thread([this] {
+        EXPECT_CALL(*disk_a, submit_iov(_, _, _, _, _)).Times(1).WillRepeatedly(make_async_iov_action());
+        EXPECT_CALL(*disk_b, submit_iov(_, _, _, _, _)).Times(1).WillRepeatedly(make_async_iov_action());
+
+        auto res = mock->submit_io(0, UBLK_IO_OP_READ, 0, 64 * Ki / 512, mock->io_buf(0));
+        ASSERT_TRUE(res);
+        EXPECT_EQ(res.value(), 2u); // one fragment per leg, both in flight
+
+        EXPECT_TRUE(mock->inject_cqe(0, 32 * Ki).empty());
+        auto completions = mock->inject_cqe(0, 32 * Ki);
+        ASSERT_EQ(completions.size(), 1u);
+        EXPECT_EQ(completions[0].result, 64 * Ki);
+    }).join();
+}
+
+// A failed fragment fails over to the other leg on its own; the other fragment is unaffected.
+TEST_F(AsyncRaid1Fixture, SplitReadFragmentFailover) {
+    if (SISL_OPTIONS["split_read"].as< uint32_t >() == 0) GTEST_SKIP();
+    std::thread([this] {
+        EXPECT_CALL(*disk_a, submit_iov(_, _, _, _, _)).Times(1).WillRepeatedly(make_async_iov_action());
+        EXPECT_CALL(*disk_b, submit_iov(_, _, _, _, _)).Times(2).WillRepeatedly(make_async_iov_action());
+
+        auto res = mock->submit_io(0, UBLK_IO_OP_READ, 0, 64 * Ki / 512, mock->io_buf(0));
+        ASSERT_TRUE(res);
+        EXPECT_EQ(res.value(), 2u);
+
+        // Head fragment on DiskA fails -> re-issued on DiskB
+        EXPECT_TRUE(mock->inject_cqe(0, -EIO).empty());
+        EXPECT_TRUE(mock->inject_cqe(0, 32 * Ki).empty());
+        auto completions = mock->inject_cqe(0, 32 * Ki);
+        ASSERT_EQ(completions.size(), 1u);
+        EXPECT_EQ(completions[0].result, 64 * Ki);
+    }).join();
+}
+
+// Both copies of one fragment fail: the whole read fails even though the other fragment succeeded.
+TEST_F(AsyncRaid1Fixture, SplitReadFragmentBothLegsFail) {
+    if (SISL_OPTIONS["split_read"].as< uint32_t >() == 0) GTEST_SKIP();
+    std::thread([this] {
+        auto res = mock->submit_io(0, UBLK_IO_OP_READ, 0, 64 * Ki / 512, mock->io_buf(0));
+        ASSERT_TRUE(res);
+
+        EXPECT_TRUE(mock->inject_cqe(0, -EIO).empty());
+        EXPECT_TRUE(mock->inject_cqe(0, 32 * Ki).empty());
+        auto completions = mock->inject_cqe(0, -EIO);
+        ASSERT_EQ(completions.size(), 1u);
+        EXPECT_EQ(completions[0].result, -EIO);
+    }).join();
+}
+
+// Reads below the threshold stay on a single leg.
+TEST_F(AsyncRaid1Fixture, SplitReadBelowThreshold) {
+    if (SISL_OPTIONS["split_read"].as< uint32_t >() == 0) GTEST_SKIP();
+    std::thread([this] {
+        auto res = mock->submit_io(0, UBLK_IO_OP_READ, 0, 4 * Ki / 512, mock->io_buf(0));
+        ASSERT_TRUE(res);
+        EXPECT_EQ(res.value(), 1u);
+        auto completions = mock->inject_cqe(0, 4 * Ki);
+        ASSERT_EQ(completions.size(), 1u);
+        EXPECT_EQ(completions[0].result, 4 * Ki);
+    }).join();
+}
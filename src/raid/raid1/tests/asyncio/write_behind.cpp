@@ -0,0 +1,215 @@
+// Write-behind: with DiskB write-mostly, writes are acked once DiskA completes and their copy to
+// DiskB is left in flight. Only meaningful when the binary is invoked with --write_behind; skipped
+// otherwise (see CMakeLists.txt: Raid1WriteBehind target).
+
+#include <chrono>
+#include <thread>
+
+#include <sisl/options/options.h>
+
+#include "async_raid1_common.hpp"
+
+using ublkpp::raid1::replica_state;
+
+namespace {
+// Completes the write-behind copy DiskB was handed as `data`
+void complete_copy(ublk_io_data const* data, int res) {
+    auto& state = reinterpret_cast< ublkpp::async_io* >(data->private_data)->_pool.back();
+    state._result = res;
+    state._result_ready = true;
+    std::exchange(state._waiter, {}).resume();
+}
+
+// DiskB takes a copy and holds it in flight, handing it back through `copy`
+auto hold_copy(ublk_io_data const*& copy) {
+    return [&copy](ublksrv_queue const*, ublk_io_data const* data, iovec*, uint32_t, uint64_t) -> io_result {
+        copy = data;
+        return 1;
+    };
+}
+
+// Repairs run on the array's own thread: waits (a while) for one to show
+template < typename F >
+bool eventually(F&& done) {
+    for (auto i = 0; 5000 > i; ++i) {
+        if (done()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+} // namespace
+
+TEST_F(AsyncRaid1Fixture, WriteBehindAcksOnActive) {
+    if (0 == SISL_OPTIONS["write_behind"].as< uint32_t >()) GTEST_SKIP();
+    ASSERT_TRUE(ublkpp::raid1::set_write_mostly(*raid, "DiskB", true));
+    std::thread([this] {
+        ublk_io_data const* copy{nullptr};
+        void* copy_buf{nullptr};
+        EXPECT_CALL(*disk_a, submit_iov(_, _, _, _, _)).Times(1).WillOnce(make_async_iov_action());
+        EXPECT_CALL(*disk_b, submit_iov(_, _, _, _, _))
+            .Times(1)
+            .WillOnce([&](ublksrv_queue const*, ublk_io_data const* data, iovec* iov, uint32_t nr_vecs,
+                          uint64_t) -> io_result {
+                EXPECT_EQ(1U, nr_vecs);
+                EXPECT_EQ(4 * Ki, iov->iov_len);
+                copy = data;
+                copy_buf = iov->iov_base;
+                return 1;
+            });
+
+        memset(mock->io_buf(0), 0xab, 4 * Ki);
+        auto res = mock->submit_io(0, UBLK_IO_OP_WRITE, 0, 4 * Ki / 512, mock->io_buf(0));
+        ASSERT_TRUE(res);
+        EXPECT_EQ(res.value(), 1u); // Only DiskA is awaited
+        auto completions = mock->inject_cqe(0, 4 * Ki);
+        ASSERT_EQ(completions.size(), 1u);
+        EXPECT_EQ(completions[0].result, 4 * Ki);
+
+        // The copy holds its own data: the request's buffer goes back to the kernel
+        ASSERT_NE(nullptr, copy);
+        ASSERT_NE(mock->io_buf(0), copy_buf);
+        memset(mock->io_buf(0), 0x00, 4 * Ki);
+        EXPECT_EQ(0xab, static_cast< uint8_t* >(copy_buf)[4 * Ki - 1]);
+
+        // Lagging, not degraded
+        auto state = raid->replica_states();
+        EXPECT_EQ(replica_state::CLEAN, state.device_a);
+        EXPECT_EQ(replica_state::SYNCING, state.device_b);
+        EXPECT_EQ(4 * Ki, state.bytes_to_sync);
+
+        complete_copy(copy, 4 * Ki);
+        state = raid->replica_states();
+        EXPECT_EQ(replica_state::CLEAN, state.device_a);
+        EXPECT_EQ(replica_state::CLEAN, state.device_b);
+        EXPECT_EQ(0UL, state.bytes_to_sync);
+    }).join();
+}
+
+// A failed write on DiskA is returned as is: DiskB lacks writes, so it must not take over.
+TEST_F(AsyncRaid1Fixture, WriteBehindActiveFailKeepsRoute) {
+    if (0 == SISL_OPTIONS["write_behind"].as< uint32_t >()) GTEST_SKIP();
+    ASSERT_TRUE(ublkpp::raid1::set_write_mostly(*raid, "DiskB", true));
+    std::thread([this] {
+        EXPECT_CALL(*disk_b, submit_iov(_, _, _, _, _)).Times(0);
+
+        auto res = mock->submit_io(0, UBLK_IO_OP_WRITE, 0, 4 * Ki / 512, mock->io_buf(0));
+        ASSERT_TRUE(res);
+        auto completions = mock->inject_cqe(0, -EIO);
+        ASSERT_EQ(completions.size(), 1u);
+        EXPECT_EQ(completions[0].result, -EIO);
+
+        auto const state = raid->replica_states();
+        EXPECT_EQ(replica_state::CLEAN, state.device_a);
+        EXPECT_EQ(replica_state::CLEAN, state.device_b);
+    }).join();
+}
+
+// While a copy is in flight a read failing on DiskA does not fail over to DiskB.
+TEST_F(AsyncRaid1Fixture, WriteBehindLaggingLegServesNoReads) {
+    if (0 == SISL_OPTIONS["write_behind"].as< uint32_t >()) GTEST_SKIP();
+    ASSERT_TRUE(ublkpp::raid1::set_write_mostly(*raid, "DiskB", true));
+    std::thread([this] {
+        ublk_io_data const* copy{nullptr};
+        EXPECT_CALL(*disk_a, submit_iov(_, _, _, _, _)).Times(2).WillRepeatedly(make_async_iov_action());
+        EXPECT_CALL(*disk_b, submit_iov(_, _, _, _, _)).Times(1).WillOnce(hold_copy(copy));
+
+        ASSERT_TRUE(mock->submit_io(0, UBLK_IO_OP_WRITE, 0, 4 * Ki / 512, mock->io_buf(0)));
+        ASSERT_EQ(mock->inject_cqe(0, 4 * Ki).size(), 1u);
+
+        ASSERT_TRUE(mock->submit_io(1, UBLK_IO_OP_READ, 64 * Ki / 512, 4 * Ki / 512, mock->io_buf(1)));
+        auto completions = mock->inject_cqe(1, -EIO);
+        ASSERT_EQ(completions.size(), 1u);
+        EXPECT_EQ(completions[0].result, -EAGAIN);
+
+        complete_copy(copy, 4 * Ki);
+    }).join();
+}
+
+// A write to a chunk whose copy is still in flight skips DiskB; the region is resynced once that
+// copy has landed.
+TEST_F(AsyncRaid1Fixture, WriteBehindOverlapResyncs) {
+    if (0 == SISL_OPTIONS["write_behind"].as< uint32_t >()) GTEST_SKIP();
+    ASSERT_TRUE(ublkpp::raid1::set_write_mostly(*raid, "DiskB", true));
+    std::thread([this] {
+        ublk_io_data const* first{nullptr};
+        EXPECT_CALL(*disk_a, submit_iov(_, _, _, _, _)).Times(2).WillRepeatedly(make_async_iov_action());
+        EXPECT_CALL(*disk_b, submit_iov(_, _, _, _, _)).Times(1).WillOnce(hold_copy(first));
+
+        ASSERT_TRUE(mock->submit_io(0, UBLK_IO_OP_WRITE, 0, 4 * Ki / 512, mock->io_buf(0)));
+        ASSERT_EQ(mock->inject_cqe(0, 4 * Ki).size(), 1u);
+        ASSERT_TRUE(mock->submit_io(1, UBLK_IO_OP_WRITE, 4 * Ki / 512, 4 * Ki / 512, mock->io_buf(1)));
+        auto completions = mock->inject_cqe(1, 4 * Ki);
+        ASSERT_EQ(completions.size(), 1u);
+        EXPECT_EQ(completions[0].result, 4 * Ki);
+        EXPECT_EQ(replica_state::CLEAN, raid->replica_states().device_a);
+
+        complete_copy(first, 4 * Ki);
+        ASSERT_TRUE(eventually([this] { return replica_state::SYNCING == raid->replica_states().device_b; }));
+
+        auto const state = raid->replica_states();
+        EXPECT_EQ(replica_state::CLEAN, state.device_a);
+        EXPECT_EQ(replica_state::SYNCING, state.device_b);
+        EXPECT_LT(0UL, state.bytes_to_sync);
+    }).join();
+}
+
+// A failed copy degrades DiskB, as a failed mirrored write would.
+TEST_F(AsyncRaid1Fixture, WriteBehindCopyFailDegrades) {
+    if (0 == SISL_OPTIONS["write_behind"].as< uint32_t >()) GTEST_SKIP();
+    ASSERT_TRUE(ublkpp::raid1::set_write_mostly(*raid, "DiskB", true));
+    std::thread([this] {
+        ublk_io_data const* copy{nullptr};
+        EXPECT_CALL(*disk_a, submit_iov(_, _, _, _, _)).Times(2).WillRepeatedly(make_async_iov_action());
+        EXPECT_CALL(*disk_b, submit_iov(_, _, _, _, _)).Times(1).WillOnce(hold_copy(copy));
+
+        ASSERT_TRUE(mock->submit_io(0, UBLK_IO_OP_WRITE, 0, 4 * Ki / 512, mock->io_buf(0)));
+        ASSERT_EQ(mock->inject_cqe(0, 4 * Ki).size(), 1u);
+        complete_copy(copy, -EIO);
+        ASSERT_TRUE(eventually([this] { return replica_state::ERROR == raid->replica_states().device_b; }));
+
+        // DiskB is now unavailable, so this write goes to DiskA alone
+        ASSERT_TRUE(mock->submit_io(1, UBLK_IO_OP_WRITE, ublkpp::Mi / 512, 4 * Ki / 512, mock->io_buf(1)));
+        auto completions = mock->inject_cqe(1, 4 * Ki);
+        ASSERT_EQ(completions.size(), 1u);
+        EXPECT_EQ(completions[0].result, 4 * Ki);
+
+        auto const state = raid->replica_states();
+        EXPECT_EQ(replica_state::CLEAN, state.device_a);
+        EXPECT_EQ(replica_state::ERROR, state.device_b);
+    }).join();
+}
+
+// A write is dirty from before it is acked until its copy lands, so a region DiskB missed goes to
+// resync along with the copies still in flight, but not with those that landed.
+TEST_F(AsyncRaid1Fixture, WriteBehindDirtyUntilLanded) {
+    if (0 == SISL_OPTIONS["write_behind"].as< uint32_t >()) GTEST_SKIP();
+    ASSERT_TRUE(ublkpp::raid1::set_write_mostly(*raid, "DiskB", true));
+    std::thread([this] {
+        ublk_io_data const* landed{nullptr};
+        ublk_io_data const* in_flight{nullptr};
+        ublk_io_data const* failed{nullptr};
+        EXPECT_CALL(*disk_a, submit_iov(_, _, _, _, _)).Times(3).WillRepeatedly(make_async_iov_action());
+        EXPECT_CALL(*disk_b, submit_iov(_, _, _, _, _))
+            .Times(3)
+            .WillOnce(hold_copy(landed))
+            .WillOnce(hold_copy(in_flight))
+            .WillOnce(hold_copy(failed));
+
+        ASSERT_TRUE(mock->submit_io(0, UBLK_IO_OP_WRITE, 0, 4 * Ki / 512, mock->io_buf(0)));
+        ASSERT_EQ(mock->inject_cqe(0, 4 * Ki).size(), 1u);
+        complete_copy(landed, 4 * Ki);
+        ASSERT_TRUE(mock->submit_io(1, UBLK_IO_OP_WRITE, ublkpp::Mi / 512, 4 * Ki / 512, mock->io_buf(1)));
+        ASSERT_EQ(mock->inject_cqe(1, 4 * Ki).size(), 1u);
+        ASSERT_TRUE(mock->submit_io(2, UBLK_IO_OP_WRITE, 2 * ublkpp::Mi / 512, 4 * Ki / 512, mock->io_buf(2)));
+        ASSERT_EQ(mock->inject_cqe(2, 4 * Ki).size(), 1u);
+        complete_copy(failed, -EIO);
+
+        // One 32KiB chunk each for the copy in flight and the failed one
+        ASSERT_TRUE(eventually([this] { return replica_state::ERROR == raid->replica_states().device_b; }));
+        EXPECT_EQ(64 * Ki, raid->replica_states().bytes_to_sync);
+
+        // Landing in a degraded array, the copy leaves its region to resync
+        complete_copy(in_flight, 4 * Ki);
+        EXPECT_EQ(64 * Ki, raid->replica_states().bytes_to_sync);
+    }).join();
+}
@@ -21,3 +21,22 @@ TEST(Raid1, IdenticalDeviceProbing) {
     EXPECT_TO_WRITE_SB(device_a);
     EXPECT_TO_WRITE_SB(device_b);
 }
+
+// The mirror takes scattered requests when both legs do; a missing leg does not hold it back
+TEST(Raid1, ScatterGatherFollowsLegs) {
+    {
+        auto device_a = CREATE_DISK_A((TestParams{.capacity = Gi, .scatter_gather = true}));
+        auto device_b = CREATE_DISK_B((TestParams{.capacity = Gi}));
+        auto raid_device = ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), device_a, device_b);
+        EXPECT_FALSE(raid_device.scatter_gather());
+        EXPECT_TO_WRITE_SB(device_a);
+        EXPECT_TO_WRITE_SB(device_b);
+    }
+    {
+        auto device_a = CREATE_DISK_A((TestParams{.capacity = Gi, .scatter_gather = true}));
+        auto device_b = ublkpp::make_missing_disk();
+        auto raid_device = ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), device_a, device_b);
+        EXPECT_TRUE(raid_device.scatter_gather());
+        EXPECT_TO_WRITE_SB(device_a);
+    }
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include "raid/raid1/leg_latency.hpp"
+
+using ublkpp::raid1::LegLatency;
+using transition = LegLatency::transition;
+
+static constexpr uint32_t k_threshold_us = 50'000;
+static constexpr uint64_t k_now = 1'000'000'000;
+
+TEST(LegLatency, FastLegStaysClean) {
+    LegLatency lat;
+    for (auto i = 0U; i < 100; ++i)
+        EXPECT_EQ(transition::NONE, lat.record(200, k_threshold_us, k_now));
+    EXPECT_FALSE(lat.slow());
+    EXPECT_LT(lat.ewma_us(), k_threshold_us);
+}
+
+// A single stall pushes the average over the threshold but must not demote the leg.
+TEST(LegLatency, OutlierDoesNotTrip) {
+    LegLatency lat;
+    for (auto i = 0U; i < 16; ++i)
+        lat.record(200, k_threshold_us, k_now);
+    EXPECT_EQ(transition::NONE, lat.record(1'000'000, k_threshold_us, k_now));
+    EXPECT_FALSE(lat.slow());
+    for (auto i = 0U; i < 16; ++i)
+        EXPECT_EQ(transition::NONE, lat.record(200, k_threshold_us, k_now));
+    EXPECT_FALSE(lat.slow());
+}
+
+TEST(LegLatency, SustainedSlownessTrips) {
+    LegLatency lat;
+    auto tripped_at = 0U;
+    for (auto i = 1U; i <= 32 && 0 == tripped_at; ++i)
+        if (transition::BECAME_SLOW == lat.record(200'000, k_threshold_us, k_now)) tripped_at = i;
+    EXPECT_GE(tripped_at, LegLatency::k_trip_samples);
+    EXPECT_TRUE(lat.slow());
+    // Already slow: no repeated transition
+    EXPECT_EQ(transition::NONE, lat.record(200'000, k_threshold_us, k_now));
+}
+
+// Recovery needs the average below half the threshold, not merely below it.
+TEST(LegLatency, RecoveryHysteresis) {
+    LegLatency lat;
+    for (auto i = 0U; i < 32; ++i)
+        lat.record(200'000, k_threshold_us, k_now);
+    ASSERT_TRUE(lat.slow());
+
+    for (auto i = 0U; i < 64; ++i)
+        EXPECT_EQ(transition::NONE, lat.record(30'000, k_threshold_us, k_now));
+    EXPECT_TRUE(lat.slow());
+
+    auto recovered = false;
+    for (auto i = 0U; i < 64 && !recovered; ++i)
+        recovered =
+            (transition::RECOVERED == lat.record(1'000, k_threshold_us, k_now + LegLatency::k_default_dwell_ns));
+    EXPECT_TRUE(recovered);
+    EXPECT_FALSE(lat.slow());
+}
+
+TEST(LegLatency, Reset) {
+    LegLatency lat;
+    for (auto i = 0U; i < 32; ++i)
+        lat.record(200'000, k_threshold_us, k_now);
+    ASSERT_TRUE(lat.slow());
+    lat.reset(k_now);
+    EXPECT_FALSE(lat.slow());
+    EXPECT_EQ(0U, lat.ewma_us());
+}
+
+// A leg holds each state for the minimum dwell, however its average moves meanwhile.
+TEST(LegLatency, MinimumDwell) {
+    LegLatency lat;
+    for (auto i = 0U; i < 32; ++i)
+        lat.record(200'000, k_threshold_us, k_now);
+    ASSERT_TRUE(lat.slow());
+
+    auto const early = k_now + LegLatency::k_default_dwell_ns - 1;
+    for (auto i = 0U; i < 64; ++i)
+        EXPECT_EQ(transition::NONE, lat.record(1'000, k_threshold_us, early));
+    EXPECT_TRUE(lat.slow());
+    EXPECT_EQ(LegLatency::k_default_dwell_ns - 1, lat.dwell_ns(early));
+
+    auto const rejoin = k_now + LegLatency::k_default_dwell_ns;
+    EXPECT_EQ(transition::RECOVERED, lat.record(1'000, k_threshold_us, rejoin));
+
+    // Slow again at once: it stays in rotation until the dwell since rejoining has passed
+    for (auto i = 0U; i < 32; ++i)
+        EXPECT_EQ(transition::NONE, lat.record(200'000, k_threshold_us, rejoin + 1));
+    EXPECT_FALSE(lat.slow());
+    EXPECT_EQ(transition::BECAME_SLOW,
+              lat.record(200'000, k_threshold_us, rejoin + LegLatency::k_default_dwell_ns));
+}
+
+// A reset leg (degraded by --slow_degrade) is held CLEAN for a dwell from the reset.
+TEST(LegLatency, ResetStartsDwell) {
+    LegLatency lat;
+    lat.reset(k_now);
+    for (auto i = 0U; i < 32; ++i)
+        EXPECT_EQ(transition::NONE, lat.record(200'000, k_threshold_us, k_now + 1));
+    EXPECT_FALSE(lat.slow());
+    EXPECT_EQ(transition::BECAME_SLOW, lat.record(200'000, k_threshold_us, k_now + LegLatency::k_default_dwell_ns));
+}
+
+// The dwell is the caller's to choose
+TEST(LegLatency, ShorterDwell) {
+    constexpr uint64_t k_dwell_ns = 1'000'000;
+    LegLatency lat;
+    for (auto i = 0U; i < 32; ++i)
+        lat.record(200'000, k_threshold_us, k_now, k_dwell_ns);
+    ASSERT_TRUE(lat.slow());
+    for (auto i = 0U; i < 64; ++i)
+        EXPECT_EQ(transition::NONE, lat.record(1'000, k_threshold_us, k_now + k_dwell_ns - 1, k_dwell_ns));
+    EXPECT_TRUE(lat.slow());
+    EXPECT_EQ(transition::RECOVERED, lat.record(1'000, k_threshold_us, k_now + k_dwell_ns, k_dwell_ns));
+}
+
+// One read in k_probe_every still reaches a SLOW leg
+TEST(LegLatency, ProbeEvery) {
+    LegLatency lat;
+    auto probes = 0U;
+    for (auto i = 0U; i < 4 * LegLatency::k_probe_every; ++i)
+        if (lat.probe()) ++probes;
+    EXPECT_EQ(4U, probes);
+}
@@ -0,0 +1,87 @@
+#include "../test_raid1_common.hpp"
+
+using ::testing::AnyNumber;
+
+TEST(Raid1, NWayRequiresTwoLegs) {
+    auto legs = std::vector< ublkpp::disk_handle >{make_leg("DiskA")};
+    EXPECT_THROW(ublkpp::make_raid1_disk(boost::uuids::string_generator()(test_uuid), std::move(legs)),
+                 std::invalid_argument);
+}
+
+TEST(Raid1, NWayTwoLegsIsPlainMirror) {
+    auto raid =
+        ublkpp::make_raid1_disk(boost::uuids::string_generator()(test_uuid), {make_leg("DiskA"), make_leg("DiskB")});
+    auto const legs = ublkpp::raid1::replica_states(*raid).legs;
+    ASSERT_EQ(2U, legs.size());
+    EXPECT_EQ("DiskA", legs[0].id);
+    EXPECT_EQ("DiskB", legs[1].id);
+    auto const* r1 = dynamic_cast< ublkpp::raid1::Raid1Disk const* >(raid.get());
+    ASSERT_NE(nullptr, r1);
+    EXPECT_EQ(2U, r1->replica_count());
+}
+
+TEST(Raid1, NWayThreeLegs) {
+    auto two_way =
+        ublkpp::make_raid1_disk(boost::uuids::string_generator()(test_uuid), {make_leg("DiskA"), make_leg("DiskB")});
+    auto raid = ublkpp::make_raid1_disk(boost::uuids::string_generator()(test_uuid),
+                                        {make_leg("DiskA"), make_leg("DiskB"), make_leg("DiskC")});
+    auto const* r1 = dynamic_cast< ublkpp::raid1::Raid1Disk const* >(raid.get());
+    ASSERT_NE(nullptr, r1);
+    EXPECT_EQ(3U, r1->replica_count());
+    // The nested mirror reserves its own superblock/bitmap region
+    EXPECT_LT(raid->capacity(), two_way->capacity());
+
+    auto const legs = ublkpp::raid1::replica_states(*raid).legs;
+    ASSERT_EQ(3U, legs.size());
+    EXPECT_EQ("DiskA", legs[0].id);
+    EXPECT_EQ("DiskB", legs[1].id);
+    EXPECT_EQ("DiskC", legs[2].id);
+    for (auto const& leg : legs)
+        EXPECT_EQ(ublkpp::raid1::replica_state::CLEAN, leg.state) << leg.id;
+}
+
+// Chunk-address spread: every leaf of a 3-way mirror serves one of three consecutive chunks.
+TEST(Raid1, NWayReadsSpreadAcrossLeaves) {
+    auto leg_a = make_leg("DiskA");
+    auto leg_b = make_leg("DiskB");
+    auto leg_c = make_leg("DiskC");
+    auto raid = ublkpp::make_raid1_disk(boost::uuids::string_generator()(test_uuid), {leg_a, leg_b, leg_c});
+
+    RUN_IN_THREAD({
+        for (auto const& leg : {leg_a, leg_b, leg_c}) {
+            EXPECT_CALL(*leg, sync_iov(UBLK_IO_OP_WRITE, _, _, _)).Times(AnyNumber());
+            EXPECT_CALL(*leg, sync_iov(UBLK_IO_OP_READ, _, _, _)).Times(1).WillOnce(sync_iov_zero_on_read());
+        }
+        alignas(4096) uint8_t buf[4 * Ki];
+        auto iov = iovec{.iov_base = buf, .iov_len = sizeof(buf)};
+        for (auto chunk = 0UL; chunk < 3; ++chunk) {
+            auto const res = raid->sync_iov(UBLK_IO_OP_READ, &iov, 1, static_cast< off_t >(chunk * 32 * Ki));
+            ASSERT_TRUE(res);
+        }
+    });
+}
+
+TEST(Raid1, NWaySwapNestedLeg) {
+    auto raid = ublkpp::make_raid1_disk(boost::uuids::string_generator()(test_uuid),
+                                        {make_leg("DiskA"), make_leg("DiskB"), make_leg("DiskC")});
+    // Keep the nested mirror's resync parked so the replaced leg is observed mid-sync
+    auto* nested = dynamic_cast< ublkpp::raid1::Raid1Disk* >(ublkpp::raid1::replicas(*raid).second.get());
+    ASSERT_NE(nullptr, nested);
+    nested->toggle_resync(false);
+
+    auto incoming = make_leg("DiskD");
+    auto outgoing = ublkpp::raid1::swap_device(*raid, "DiskC", incoming);
+    ASSERT_NE(incoming, outgoing);
+    EXPECT_EQ("DiskC", outgoing->id());
+
+    auto const legs = ublkpp::raid1::replica_states(*raid).legs;
+    ASSERT_EQ(3U, legs.size());
+    EXPECT_EQ("DiskD", legs[2].id);
+    EXPECT_NE(ublkpp::raid1::replica_state::CLEAN, legs[2].state);
+}
+
+// The wrong-type sentinel lists no leaves
+TEST(Raid1, NWayLegsOfNonMirror) {
+    auto leg = make_leg("DiskA");
+    EXPECT_TRUE(ublkpp::raid1::replica_states(*leg).legs.empty());
+}
@@ -76,3 +76,24 @@ TEST(Raid1, OpenForUringOffsetCalculation) {
     EXPECT_TO_WRITE_SB(device_a);
     EXPECT_TO_WRITE_SB(device_b);
 }
+
+// Test: one leg that polls is enough for the mirror to ask for a polled ring
+TEST(Raid1, PreparePolledFollowsLegs) {
+    auto device_a = CREATE_DISK_A(TestParams{.capacity = Gi});
+    auto device_b = CREATE_DISK_B(TestParams{.capacity = Gi});
+
+    EXPECT_CALL(*device_a, prepare(_, 0)).Times(1).WillOnce(::testing::Return(ublkpp::ublk_disk::prepare_result{}));
+    EXPECT_CALL(*device_b, prepare(_, 0))
+        .Times(1)
+        .WillOnce(::testing::Return(ublkpp::ublk_disk::prepare_result{.polled = true}));
+
+    auto raid_device = ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), device_a, device_b);
+
+    auto result = raid_device.prepare(nullptr, 0);
+    EXPECT_TRUE(result.polled);
+    EXPECT_EQ(2U, result.max_sqes_per_io);
+
+    // Expect unmount_clean update
+    EXPECT_TO_WRITE_SB(device_a);
+    EXPECT_TO_WRITE_SB(device_b);
+}
@@ -0,0 +1,75 @@
+#include "../test_raid1_common.hpp"
+
+using ::testing::AllOf;
+using ::testing::AnyNumber;
+using ::testing::Ge;
+using ::testing::Gt;
+using ::testing::Lt;
+
+namespace {
+void write_chunk(ublkpp::ublk_disk& raid, off_t addr) {
+    alignas(4096) static uint8_t buf[4 * Ki];
+    auto iov = iovec{.iov_base = buf, .iov_len = sizeof(buf)};
+    ASSERT_TRUE(raid.sync_iov(UBLK_IO_OP_WRITE, &iov, 1, addr));
+}
+} // namespace
+
+// The detached leg stops receiving writes; the bitmap tracks what it misses.
+TEST(Raid1, SplitMirrorDetachesLeg) {
+    auto leg_a = make_sb_leg("DiskA");
+    auto leg_b = make_sb_leg("DiskB");
+    auto raid = ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), leg_a, leg_b);
+
+    EXPECT_EQ(leg_b, ublkpp::raid1::split_mirror(raid, "DiskB"));
+    EXPECT_CALL(*leg_b, sync_iov(_, _, _, _)).Times(0);
+    EXPECT_CALL(*leg_a, sync_iov(UBLK_IO_OP_WRITE, _, _, _)).Times(AnyNumber());
+    write_chunk(raid, Mi);
+
+    auto const state = raid.replica_states();
+    EXPECT_EQ(ublkpp::raid1::replica_state::CLEAN, state.device_a);
+    EXPECT_NE(ublkpp::raid1::replica_state::CLEAN, state.device_b);
+    EXPECT_EQ(32 * Ki, state.bytes_to_sync);
+    EXPECT_TRUE(raid.replicas().second->is_missing());
+}
+
+TEST(Raid1, SplitMirrorRefused) {
+    auto raid = ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), make_sb_leg("DiskA"),
+                                         make_sb_leg("DiskB"));
+    EXPECT_EQ(nullptr, ublkpp::raid1::split_mirror(raid, "DiskZ"));
+    ASSERT_NE(nullptr, ublkpp::raid1::split_mirror(raid, "DiskA"));
+    // Already degraded: the last leg cannot be split off
+    EXPECT_EQ(nullptr, ublkpp::raid1::split_mirror(raid, "DiskB"));
+    // Nothing is missing from a clean array
+    auto other = ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), make_sb_leg("DiskC"),
+                                          make_sb_leg("DiskD"));
+    EXPECT_FALSE(ublkpp::raid1::rejoin_mirror(other, make_sb_leg("DiskE")));
+}
+
+// Rejoining resyncs only the chunk written during the split: no bitmap init_to() on the returning
+// leg, and the array becomes clean again.
+TEST(Raid1, RejoinMirrorResyncsChanges) {
+    auto leg_a = make_sb_leg("DiskA");
+    auto leg_b = make_sb_leg("DiskB");
+    auto raid = ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), leg_a, leg_b);
+    auto const reserved = static_cast< off_t >(raid.reserved_size());
+
+    auto split = ublkpp::raid1::split_mirror(raid, "DiskB");
+    ASSERT_EQ(leg_b, split);
+    write_chunk(raid, Mi);
+    ASSERT_EQ(32 * Ki, raid.replica_states().bytes_to_sync);
+
+    EXPECT_CALL(*leg_b, sync_iov(_, _, _, _)).Times(AnyNumber());
+    EXPECT_CALL(*leg_b, sync_iov(UBLK_IO_OP_WRITE, _, _, AllOf(Gt(0), Lt(reserved)))).Times(0);
+    EXPECT_CALL(*leg_b, sync_iov(UBLK_IO_OP_WRITE, _, _, Ge(reserved))).Times(testing::AtLeast(1));
+    EXPECT_TRUE(ublkpp::raid1::rejoin_mirror(raid, split));
+    EXPECT_TRUE(wait_for_clean_state(raid, std::chrono::seconds(5)));
+    EXPECT_EQ(leg_b, raid.replicas().second);
+}
+
+TEST(Raid1, SplitMirrorNestedLeg) {
+    auto leg_c = make_sb_leg("DiskC");
+    auto raid = ublkpp::make_raid1_disk(boost::uuids::string_generator()(test_uuid),
+                                        {make_sb_leg("DiskA"), make_sb_leg("DiskB"), leg_c});
+    EXPECT_EQ(leg_c, ublkpp::raid1::split_mirror(*raid, "DiskC"));
+    EXPECT_TRUE(ublkpp::raid1::rejoin_mirror(*raid, leg_c));
+}
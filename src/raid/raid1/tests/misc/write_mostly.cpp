@@ -0,0 +1,60 @@
+#include "../test_raid1_common.hpp"
+
+using ::testing::AnyNumber;
+
+TEST(Raid1, WriteMostlyUnknownDevice) {
+    auto raid =
+        ublkpp::make_raid1_disk(boost::uuids::string_generator()(test_uuid), {make_leg("DiskA"), make_leg("DiskB")});
+    EXPECT_FALSE(ublkpp::raid1::set_write_mostly(*raid, "DiskZ", true));
+    EXPECT_TRUE(ublkpp::raid1::set_write_mostly(*raid, "DiskB", true));
+}
+
+// Every read lands on the fast leg while the write-mostly leg is healthy
+TEST(Raid1, WriteMostlyExcludedFromReads) {
+    auto leg_a = make_leg("DiskA");
+    auto leg_b = make_leg("DiskB");
+    auto raid = ublkpp::make_raid1_disk(boost::uuids::string_generator()(test_uuid), leg_a, leg_b);
+    ASSERT_TRUE(ublkpp::raid1::set_write_mostly(*raid, "DiskA", true));
+
+    RUN_IN_THREAD({
+        EXPECT_CALL(*leg_a, sync_iov(UBLK_IO_OP_WRITE, _, _, _)).Times(AnyNumber());
+        EXPECT_CALL(*leg_b, sync_iov(UBLK_IO_OP_WRITE, _, _, _)).Times(AnyNumber());
+        EXPECT_CALL(*leg_a, sync_iov(UBLK_IO_OP_READ, _, _, _)).Times(0);
+        EXPECT_CALL(*leg_b, sync_iov(UBLK_IO_OP_READ, _, _, _)).Times(4).WillRepeatedly(sync_iov_zero_on_read());
+        alignas(4096) uint8_t buf[4 * Ki];
+        auto iov = iovec{.iov_base = buf, .iov_len = sizeof(buf)};
+        for (auto i = 0UL; i < 4; ++i) {
+            auto const res = raid->sync_iov(UBLK_IO_OP_READ, &iov, 1, static_cast< off_t >(i * 32 * Ki));
+            ASSERT_TRUE(res);
+        }
+    });
+}
+
+// Clearing the flag restores round-robin reads
+TEST(Raid1, WriteMostlyCleared) {
+    auto leg_a = make_leg("DiskA");
+    auto leg_b = make_leg("DiskB");
+    auto raid = ublkpp::make_raid1_disk(boost::uuids::string_generator()(test_uuid), leg_a, leg_b);
+    ASSERT_TRUE(ublkpp::raid1::set_write_mostly(*raid, "DiskB", true));
+    ASSERT_TRUE(ublkpp::raid1::set_write_mostly(*raid, "DiskB", false));
+
+    RUN_IN_THREAD({
+        EXPECT_CALL(*leg_a, sync_iov(UBLK_IO_OP_WRITE, _, _, _)).Times(AnyNumber());
+        EXPECT_CALL(*leg_b, sync_iov(UBLK_IO_OP_WRITE, _, _, _)).Times(AnyNumber());
+        EXPECT_CALL(*leg_a, sync_iov(UBLK_IO_OP_READ, _, _, _)).Times(1).WillOnce(sync_iov_zero_on_read());
+        EXPECT_CALL(*leg_b, sync_iov(UBLK_IO_OP_READ, _, _, _)).Times(1).WillOnce(sync_iov_zero_on_read());
+        alignas(4096) uint8_t buf[4 * Ki];
+        auto iov = iovec{.iov_base = buf, .iov_len = sizeof(buf)};
+        for (auto i = 0UL; i < 2; ++i) {
+            auto const res = raid->sync_iov(UBLK_IO_OP_READ, &iov, 1, static_cast< off_t >(i * 32 * Ki));
+            ASSERT_TRUE(res);
+        }
+    });
+}
+
+TEST(Raid1, WriteMostlyNestedLeg) {
+    auto raid = ublkpp::make_raid1_disk(boost::uuids::string_generator()(test_uuid),
+                                        {make_leg("DiskA"), make_leg("DiskB"), make_leg("DiskC")});
+    EXPECT_TRUE(ublkpp::raid1::set_write_mostly(*raid, "DiskC", true));
+    EXPECT_FALSE(ublkpp::raid1::set_write_mostly(*raid, "DiskD", true));
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include "lib/common.hpp"
+#include "raid/raid1/write_behind.hpp"
+
+using ublkpp::Ki;
+using ublkpp::raid1::BehindWindow;
+using admit_result = BehindWindow::admit_result;
+
+static constexpr uint32_t k_chunk = 32 * Ki;
+
+TEST(BehindWindow, AdmitAndRetire) {
+    BehindWindow window(64 * Ki, k_chunk);
+    EXPECT_FALSE(window.lagging());
+    EXPECT_EQ(admit_result::BEHIND, window.admit(0, 4 * Ki));
+    EXPECT_TRUE(window.lagging());
+    EXPECT_EQ(4 * Ki, window.bytes());
+    EXPECT_TRUE(window.in_flight(k_chunk - 4 * Ki, 4 * Ki));
+    EXPECT_FALSE(window.in_flight(k_chunk, 4 * Ki));
+    window.retire(0, 4 * Ki, true);
+    EXPECT_FALSE(window.lagging());
+    EXPECT_FALSE(window.in_flight(0, 4 * Ki));
+    EXPECT_TRUE(window.take_stale().regions.empty());
+}
+
+TEST(BehindWindow, FullWindow) {
+    BehindWindow window(64 * Ki, k_chunk);
+    EXPECT_EQ(admit_result::BEHIND, window.admit(0, 64 * Ki));
+    EXPECT_EQ(admit_result::FULL, window.admit(4 * k_chunk, 4 * Ki));
+    window.retire(0, 64 * Ki, true);
+    EXPECT_EQ(admit_result::BEHIND, window.admit(4 * k_chunk, 4 * Ki));
+}
+
+// Writes sharing a chunk with one in flight are refused, even when their bytes do not overlap
+TEST(BehindWindow, OverlapRefused) {
+    BehindWindow window(1024 * Ki, k_chunk);
+    EXPECT_EQ(admit_result::BEHIND, window.admit(k_chunk - 4 * Ki, 8 * Ki));
+    EXPECT_EQ(admit_result::OVERLAP, window.admit(0, 4 * Ki));
+    EXPECT_EQ(admit_result::OVERLAP, window.admit(k_chunk + 8 * Ki, 4 * Ki));
+    EXPECT_EQ(admit_result::BEHIND, window.admit(2 * k_chunk, 4 * Ki));
+}
+
+// A stale region is only handed over once no write in flight touches it
+TEST(BehindWindow, StaleHeldWhileInFlight) {
+    BehindWindow window(1024 * Ki, k_chunk);
+    EXPECT_EQ(admit_result::BEHIND, window.admit(0, 4 * Ki));
+    window.mark_stale(4 * Ki, 4 * Ki);
+    EXPECT_TRUE(window.take_stale().regions.empty());
+    window.retire(0, 4 * Ki, true);
+    EXPECT_TRUE(window.lagging());
+    auto const stale = window.take_stale();
+    ASSERT_EQ(1U, stale.regions.size());
+    EXPECT_EQ(4 * Ki, stale.regions[0].first);
+    EXPECT_FALSE(stale.failed);
+    EXPECT_FALSE(window.lagging());
+}
+
+TEST(BehindWindow, FailedRetireIsStale) {
+    BehindWindow window(1024 * Ki, k_chunk);
+    EXPECT_EQ(admit_result::BEHIND, window.admit(0, 4 * Ki));
+    window.retire(0, 4 * Ki, false);
+    EXPECT_TRUE(window.lagging());
+    auto const stale = window.take_stale();
+    ASSERT_EQ(1U, stale.regions.size());
+    EXPECT_TRUE(stale.failed);
+    EXPECT_FALSE(window.take_stale().failed);
+}
+
+// A write lands unless it failed or a stale region shares a chunk with it; it is still counted
+// while done() runs
+TEST(BehindWindow, RetireReportsLanded) {
+    BehindWindow window(1024 * Ki, k_chunk);
+    EXPECT_EQ(admit_result::BEHIND, window.admit(0, 4 * Ki));
+    EXPECT_EQ(admit_result::BEHIND, window.admit(2 * k_chunk, 4 * Ki));
+    EXPECT_EQ(admit_result::BEHIND, window.admit(4 * k_chunk, 4 * Ki));
+    EXPECT_TRUE(window.stale_if_in_flight(2 * k_chunk + 8 * Ki, 4 * Ki));
+    EXPECT_FALSE(window.stale_if_in_flight(6 * k_chunk, 4 * Ki));
+    EXPECT_TRUE(window.stale());
+
+    auto landed = std::vector< bool >{};
+    auto const done = [&](bool l) {
+        EXPECT_LT(0UL, window.bytes());
+        landed.push_back(l);
+    };
+    window.retire(0, 4 * Ki, true, done);
+    window.retire(2 * k_chunk, 4 * Ki, true, done);
+    window.retire(4 * k_chunk, 4 * Ki, false, done);
+    EXPECT_EQ((std::vector< bool >{true, false, false}), landed);
+    EXPECT_EQ(0UL, window.bytes());
+    EXPECT_EQ(2U, window.take_stale().regions.size());
+}
@@ -0,0 +1,105 @@
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "lib/common.hpp"
+#include "raid/raid1/hot_region_queue.hpp"
+
+using ublkpp::Ki;
+using ublkpp::raid1::HotRegionQueue;
+
+static constexpr uint32_t k_chunk = 32 * Ki;
+
+TEST(HotRegionQueue, EmptyPop) {
+    HotRegionQueue queue(8, k_chunk);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop().has_value());
+}
+
+TEST(HotRegionQueue, PushAlignsToChunk) {
+    HotRegionQueue queue(8, k_chunk);
+    EXPECT_TRUE(queue.push(3 * k_chunk + 4 * Ki));
+    EXPECT_FALSE(queue.empty());
+    auto const hot = queue.pop();
+    ASSERT_TRUE(hot.has_value());
+    EXPECT_EQ(3 * k_chunk, *hot);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(HotRegionQueue, DuplicateIsDropped) {
+    HotRegionQueue queue(8, k_chunk);
+    EXPECT_TRUE(queue.push(5 * k_chunk));
+    EXPECT_FALSE(queue.push(5 * k_chunk + 512));
+    EXPECT_TRUE(queue.pop().has_value());
+    EXPECT_FALSE(queue.pop().has_value());
+}
+
+TEST(HotRegionQueue, FullQueueDropsHint) {
+    HotRegionQueue queue(4, k_chunk);
+    for (uint64_t i = 0; i < 4; ++i)
+        EXPECT_TRUE(queue.push(i * k_chunk));
+    EXPECT_FALSE(queue.push(100 * k_chunk));
+
+    auto popped = std::set< uint64_t >();
+    while (auto hot = queue.pop())
+        popped.insert(*hot);
+    EXPECT_EQ((std::set< uint64_t >{0, k_chunk, 2 * k_chunk, 3 * k_chunk}), popped);
+}
+
+// A range queues every chunk it touches, not only the one holding its first byte
+TEST(HotRegionQueue, RangeQueuesEveryChunk) {
+    HotRegionQueue queue(8, k_chunk);
+    EXPECT_EQ(3U, queue.push_range(2 * k_chunk + 4 * Ki, 2 * k_chunk));
+    EXPECT_EQ(1U, queue.push_range(4 * k_chunk, 2 * k_chunk));
+    EXPECT_EQ(0U, queue.push_range(3 * k_chunk, 4 * Ki));
+
+    auto popped = std::set< uint64_t >();
+    while (auto hot = queue.pop())
+        popped.insert(*hot);
+    EXPECT_EQ((std::set< uint64_t >{2 * k_chunk, 3 * k_chunk, 4 * k_chunk, 5 * k_chunk}), popped);
+}
+
+// A range wider than the queue keeps its leading chunks
+TEST(HotRegionQueue, RangeWiderThanQueue) {
+    HotRegionQueue queue(4, k_chunk);
+    EXPECT_EQ(4U, queue.push_range(0, 16 * k_chunk));
+    auto popped = std::set< uint64_t >();
+    while (auto hot = queue.pop())
+        popped.insert(*hot);
+    EXPECT_EQ((std::set< uint64_t >{0, k_chunk, 2 * k_chunk, 3 * k_chunk}), popped);
+}
+
+// Consumer rotates its scan so a slot that is re-filled right after being drained does not
+// shadow the others.
+TEST(HotRegionQueue, PopRotates) {
+    HotRegionQueue queue(4, k_chunk);
+    EXPECT_TRUE(queue.push(0));
+    EXPECT_TRUE(queue.push(k_chunk));
+    EXPECT_EQ(0UL, queue.pop().value());
+    EXPECT_TRUE(queue.push(0));
+    EXPECT_EQ(k_chunk, queue.pop().value());
+    EXPECT_EQ(0UL, queue.pop().value());
+}
+
+TEST(HotRegionQueue, ConcurrentProducers) {
+    static constexpr uint64_t k_per_thread = 64;
+    HotRegionQueue queue(256, k_chunk);
+    auto producers = std::vector< std::thread >();
+    for (uint64_t t = 0; t < 4; ++t) {
+        producers.emplace_back([&queue, t] {
+            for (uint64_t i = 0; i < k_per_thread; ++i)
+                queue.push((t * k_per_thread + i) * k_chunk);
+        });
+    }
+    for (auto& p : producers)
+        p.join();
+
+    auto popped = std::set< uint64_t >();
+    while (auto hot = queue.pop())
+        popped.insert(*hot);
+    EXPECT_EQ(4 * k_per_thread, popped.size());
+    EXPECT_TRUE(queue.empty());
+}
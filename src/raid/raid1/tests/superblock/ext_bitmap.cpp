@@ -0,0 +1,205 @@
+#include "test_raid1_common.hpp"
+
+#include <algorithm>
+
+using ::testing::AnyNumber;
+using ::testing::Ge;
+using ::testing::Gt;
+using ::testing::NiceMock;
+
+namespace {
+// Returns `sb` (if any) for reads at offset 0 and zeroes for everything else.
+std::shared_ptr< NiceMock< ublkpp::TestDisk > > make_disk(TestParams params,
+                                                          std::optional< ublkpp::raid1::SuperBlock > sb = {}) {
+    auto disk = std::make_shared< NiceMock< ublkpp::TestDisk > >(params);
+    ON_CALL(*disk, sync_iov(_, _, _, _))
+        .WillByDefault([sb](uint8_t op, iovec* iovecs, uint32_t, off_t addr) -> io_result {
+            if (op == UBLK_IO_OP_READ && iovecs->iov_base) {
+                memset(iovecs->iov_base, 0, iovecs->iov_len);
+                if (sb && 0 == addr) memcpy(iovecs->iov_base, &*sb, ublkpp::raid1::k_page_size);
+            }
+            return static_cast< int >(iovecs->iov_len);
+        });
+    return disk;
+}
+
+ublkpp::raid1::SuperBlock ext_superblock(bool device_b) {
+    auto sb = normal_superblock;
+    sb.header.version = htobe16(ublkpp::raid1::k_sb_version_ext);
+    sb.fields.ext_bitmap = 1;
+    sb.fields.device_b = device_b ? 1 : 0;
+    return sb;
+}
+} // namespace
+
+// A new array given a metadata device initializes its bitmap there; the legs reserve one page.
+TEST(Raid1, ExtBitmapNewArray) {
+    auto device_a = make_disk(TestParams{.capacity = Gi});
+    auto device_b = make_disk(TestParams{.capacity = Gi});
+    auto meta = make_disk(TestParams{.capacity = 256 * Mi});
+
+    EXPECT_CALL(*device_a, sync_iov(UBLK_IO_OP_WRITE, _, _, Gt(0))).Times(0);
+    EXPECT_CALL(*device_b, sync_iov(UBLK_IO_OP_WRITE, _, _, Gt(0))).Times(0);
+    EXPECT_CALL(*meta, sync_iov(UBLK_IO_OP_WRITE, _, _, Ge(ublkpp::raid1::k_page_size))).Times(testing::AtLeast(1));
+    EXPECT_CALL(*device_a, sync_iov(UBLK_IO_OP_WRITE, _, _, 0))
+        .Times(AnyNumber())
+        .WillRepeatedly([](uint8_t, iovec* iovecs, uint32_t, off_t) -> io_result {
+            auto const* sb = static_cast< ublkpp::raid1::SuperBlock const* >(iovecs->iov_base);
+            EXPECT_EQ(1, sb->fields.ext_bitmap);
+            EXPECT_EQ(htobe16(ublkpp::raid1::k_sb_version_ext), sb->header.version);
+            return ublkpp::raid1::k_page_size;
+        });
+
+    auto raid = ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), device_a, device_b, "", meta);
+    EXPECT_EQ(sizeof(ublkpp::raid1::SuperBlock), raid.reserved_size());
+    EXPECT_EQ(Gi - ublkpp::raid1::k_page_size, raid.capacity());
+}
+
+TEST(Raid1, ExtBitmapRequiresMeta) {
+    auto device_a = make_disk(TestParams{.capacity = Gi}, ext_superblock(false));
+    auto device_b = make_disk(TestParams{.capacity = Gi}, ext_superblock(true));
+    EXPECT_THROW(ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), device_a, device_b),
+                 std::runtime_error);
+}
+
+// An existing array keeps its bitmap where it was created; adding a metadata device would move data.
+TEST(Raid1, ExtBitmapRefusesConversion) {
+    auto sb_b = normal_superblock;
+    sb_b.fields.device_b = 1;
+    auto device_a = make_disk(TestParams{.capacity = Gi}, normal_superblock);
+    auto device_b = make_disk(TestParams{.capacity = Gi}, sb_b);
+    auto meta = make_disk(TestParams{.capacity = 256 * Mi});
+    EXPECT_THROW(
+        ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), device_a, device_b, "", meta),
+        std::runtime_error);
+}
+
+TEST(Raid1, ExtBitmapMetaTooSmall) {
+    auto device_a = make_disk(TestParams{.capacity = Gi});
+    auto device_b = make_disk(TestParams{.capacity = Gi});
+    auto meta = make_disk(TestParams{.capacity = 4 * Mi});
+    EXPECT_THROW(
+        ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), device_a, device_b, "", meta),
+        std::runtime_error);
+}
+
+// Degraded + clean shutdown: the bitmap is loaded from the metadata device when it vouches for it,
+// never from the active leg.
+TEST(Raid1, ExtBitmapLoadsFromMeta) {
+    auto sb_a = ext_superblock(false);
+    sb_a.fields.read_route = static_cast< uint8_t >(ublkpp::raid1::read_route::DEVA);
+    sb_a.fields.bitmap.age = htobe64(5);
+    sb_a.superbitmap_reserved[0] = 0x01; // page 0 of the bitmap is dirty
+    auto sb_b = ext_superblock(true);
+    sb_b.fields.bitmap.age = htobe64(4);
+    auto meta_sb = sb_a;
+
+    auto device_a = make_disk(TestParams{.capacity = Gi}, sb_a);
+    auto device_b = make_disk(TestParams{.capacity = Gi}, sb_b);
+    auto meta = make_disk(TestParams{.capacity = 256 * Mi}, meta_sb);
+
+    EXPECT_CALL(*device_a, sync_iov(UBLK_IO_OP_READ, _, _, Gt(0))).Times(0);
+    EXPECT_CALL(*meta, sync_iov(UBLK_IO_OP_READ, _, _, ublkpp::raid1::k_page_size))
+        .Times(1)
+        .WillOnce([](uint8_t, iovec* iovecs, uint32_t, off_t) -> io_result {
+            memset(iovecs->iov_base, 0, iovecs->iov_len);
+            static_cast< uint8_t* >(iovecs->iov_base)[0] = 0x01;
+            return static_cast< int >(iovecs->iov_len);
+        });
+
+    auto raid = ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), device_a, device_b, "", meta);
+    raid.toggle_resync(false);
+    EXPECT_GT(raid.replica_states().bytes_to_sync, 0U);
+}
+
+// A metadata device behind the array's age cannot vouch for its pages: dirty everything.
+TEST(Raid1, ExtBitmapUntrustedMeta) {
+    auto sb_a = ext_superblock(false);
+    sb_a.fields.read_route = static_cast< uint8_t >(ublkpp::raid1::read_route::DEVA);
+    sb_a.fields.bitmap.age = htobe64(5);
+    sb_a.superbitmap_reserved[0] = 0x01;
+    auto sb_b = ext_superblock(true);
+    sb_b.fields.bitmap.age = htobe64(4);
+    auto meta_sb = sb_a;
+    meta_sb.fields.bitmap.age = htobe64(4);
+
+    auto device_a = make_disk(TestParams{.capacity = Gi}, sb_a);
+    auto device_b = make_disk(TestParams{.capacity = Gi}, sb_b);
+    auto meta = make_disk(TestParams{.capacity = 256 * Mi}, meta_sb);
+
+    EXPECT_CALL(*meta, sync_iov(UBLK_IO_OP_READ, _, _, Gt(0))).Times(0);
+
+    auto raid = ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), device_a, device_b, "", meta);
+    raid.toggle_resync(false);
+    EXPECT_GE(raid.replica_states().bytes_to_sync, raid.capacity());
+}
+
+// A healthy array that crashed and comes back with a leg missing trusts the metadata device at its
+// age, as it would its own pages on the legs: the bitmap is loaded, not dirtied in full.
+TEST(Raid1, ExtBitmapCrashedHealthyLoadsFromMeta) {
+    auto sb_a = ext_superblock(false);
+    sb_a.fields.clean_unmount = 0;
+    sb_a.fields.bitmap.age = htobe64(5);
+    sb_a.superbitmap_reserved[0] = 0x01;
+
+    auto device_a = make_disk(TestParams{.capacity = Gi}, sb_a);
+    auto meta = make_disk(TestParams{.capacity = 256 * Mi}, sb_a);
+    EXPECT_CALL(*device_a, sync_iov(UBLK_IO_OP_READ, _, _, Gt(0))).Times(0);
+    EXPECT_CALL(*meta, sync_iov(UBLK_IO_OP_READ, _, _, ublkpp::raid1::k_page_size))
+        .Times(1)
+        .WillOnce([](uint8_t, iovec* iovecs, uint32_t, off_t) -> io_result {
+            memset(iovecs->iov_base, 0, iovecs->iov_len);
+            static_cast< uint8_t* >(iovecs->iov_base)[0] = 0x01;
+            return static_cast< int >(iovecs->iov_len);
+        });
+
+    auto raid = ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), device_a,
+                                         ublkpp::make_missing_disk(), "", meta);
+    raid.toggle_resync(false);
+    EXPECT_GT(raid.replica_states().bytes_to_sync, 0U);
+    EXPECT_LT(raid.replica_states().bytes_to_sync, raid.capacity());
+}
+
+// Resync clears bitmap pages on the metadata device. On the legs that offset is user data, which
+// must read back unchanged once the array is clean.
+TEST(Raid1, ExtBitmapResyncCleansMeta) {
+    auto sb_a = ext_superblock(false);
+    sb_a.fields.read_route = static_cast< uint8_t >(ublkpp::raid1::read_route::DEVA);
+    sb_a.fields.bitmap.age = htobe64(5);
+    sb_a.superbitmap_reserved[0] = 0x01;
+    auto sb_b = ext_superblock(true);
+    sb_b.fields.bitmap.age = htobe64(4);
+
+    // DiskA's user data past its superblock, readable by resync and checked afterwards
+    auto data = std::make_shared< std::vector< uint8_t > >(64 * Ki, 0x5a);
+    auto device_a = std::make_shared< NiceMock< ublkpp::TestDisk > >(TestParams{.capacity = Gi});
+    ON_CALL(*device_a, sync_iov(_, _, _, _))
+        .WillByDefault([sb_a, data](uint8_t op, iovec* iovecs, uint32_t, off_t addr) -> io_result {
+            auto const off = static_cast< uint64_t >(addr) - ublkpp::raid1::k_page_size;
+            auto const in_data = 0 < addr && data->size() >= off + iovecs->iov_len;
+            if (op == UBLK_IO_OP_READ && iovecs->iov_base) {
+                memset(iovecs->iov_base, 0, iovecs->iov_len);
+                if (0 == addr) memcpy(iovecs->iov_base, &sb_a, ublkpp::raid1::k_page_size);
+                if (in_data) memcpy(iovecs->iov_base, data->data() + off, iovecs->iov_len);
+            } else if (op == UBLK_IO_OP_WRITE && in_data && iovecs->iov_base) {
+                memcpy(data->data() + off, iovecs->iov_base, iovecs->iov_len);
+            }
+            return static_cast< int >(iovecs->iov_len);
+        });
+    auto device_b = make_disk(TestParams{.capacity = Gi}, sb_b);
+    auto meta = make_disk(TestParams{.capacity = 256 * Mi}, sb_a);
+    ON_CALL(*meta, sync_iov(UBLK_IO_OP_READ, _, _, ublkpp::raid1::k_page_size))
+        .WillByDefault([](uint8_t, iovec* iovecs, uint32_t, off_t) -> io_result {
+            memset(iovecs->iov_base, 0, iovecs->iov_len);
+            static_cast< uint8_t* >(iovecs->iov_base)[0] = 0x01;
+            return static_cast< int >(iovecs->iov_len);
+        });
+
+    EXPECT_CALL(*device_a, sync_iov(UBLK_IO_OP_WRITE, _, _, Gt(0))).Times(0);
+    EXPECT_CALL(*meta, sync_iov(UBLK_IO_OP_WRITE, _, _, ublkpp::raid1::k_page_size)).Times(testing::AtLeast(1));
+
+    auto raid = ublkpp::raid1::Raid1Disk(boost::uuids::string_generator()(test_uuid), device_a, device_b, "", meta);
+    raid.toggle_resync(true);
+    EXPECT_TRUE(wait_for_clean_state(raid, std::chrono::seconds(5)));
+    EXPECT_TRUE(std::ranges::all_of(*data, [](uint8_t b) { return 0x5a == b; }));
+}
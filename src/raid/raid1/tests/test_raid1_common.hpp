@@ -45,6 +45,13 @@ inline auto sync_iov_zero_on_read() {
     };
 }
 
+// A leg of 1GiB that reads as zeroes and accepts every write
+inline std::shared_ptr< ::testing::NiceMock< ublkpp::TestDisk > > make_leg(std::string const& id) {
+    auto leg = std::make_shared< ::testing::NiceMock< ublkpp::TestDisk > >(TestParams{.capacity = Gi, .id = id});
+    ON_CALL(*leg, sync_iov(_, _, _, _)).WillByDefault(sync_iov_zero_on_read());
+    return leg;
+}
+
 // Helper for tests: allocate a SuperBitmap buffer for Bitmap constructor
 inline std::unique_ptr< uint8_t[] > make_test_superbitmap() {
     auto buf = std::make_unique< uint8_t[] >(ublkpp::raid1::k_superbitmap_size);
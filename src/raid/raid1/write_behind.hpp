@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "lib/logging.hpp"
+
+namespace ublkpp::raid1 {
+
+// The writes a write-mostly backup leg still has in flight after their request was acked
+// (write-behind). Queue threads admit a write before issuing it to the lagging leg and retire it
+// once that leg completes; the array keeps reads and failover off the leg while lagging().
+//
+// A write overlapping one still in flight is refused: the two could land on the leg in either
+// order. The caller skips the leg for it and marks the region stale, as a failed behind write is.
+// Stale regions are handed over (take_stale()) once nothing in flight touches them, for the caller
+// to dirty and resync; a region handed over earlier could be overwritten by a late behind write.
+class BehindWindow {
+public:
+    enum class admit_result : uint8_t {
+        BEHIND,  // Admitted: issue the write to the lagging leg without awaiting it
+        FULL,    // The window holds max_bytes already: write the leg and await it
+        OVERLAP, // A write to the same chunk is in flight: skip the leg and mark_stale()
+    };
+
+    struct stale_regions {
+        std::vector< std::pair< uint64_t, uint32_t > > regions;
+        bool failed{false}; // Some behind write failed, rather than being refused
+    };
+
+    BehindWindow(uint64_t max_bytes, uint32_t chunk_size) : _max_bytes(max_bytes), _chunk_size(chunk_size) {
+        DEBUG_ASSERT(chunk_size > 0, "BehindWindow chunk_size must be non-zero");
+    }
+
+    admit_result admit(uint64_t addr, uint32_t len) {
+        auto lk = std::scoped_lock< std::mutex >(_lock);
+        if (__in_flight(addr, len)) return admit_result::OVERLAP;
+        if (_max_bytes < _bytes.load(std::memory_order_relaxed) + len) return admit_result::FULL;
+        for (auto chunk = __first(addr); __last(addr, len) >= chunk; ++chunk)
+            ++_chunks[chunk];
+        _bytes.fetch_add(len, std::memory_order_release);
+        return admit_result::BEHIND;
+    }
+
+    // An admitted write completed on the lagging leg; one that failed leaves its region stale.
+    // done(landed) runs under the window's lock before the write leaves it (bytes() counts it until
+    // then): landed when it succeeded and no stale region touches it, so the leg holds the region.
+    template < typename Done >
+    void retire(uint64_t addr, uint32_t len, bool ok, Done&& done) {
+        auto lk = std::scoped_lock< std::mutex >(_lock);
+        for (auto chunk = __first(addr); __last(addr, len) >= chunk; ++chunk) {
+            if (auto it = _chunks.find(chunk); _chunks.end() != it && 0 == --it->second) _chunks.erase(it);
+        }
+        if (!ok) {
+            _failed = true;
+            __mark_stale(addr, len);
+        }
+        done(ok && !__stale(addr, len));
+        _bytes.fetch_sub(len, std::memory_order_release);
+    }
+    void retire(uint64_t addr, uint32_t len, bool ok) {
+        retire(addr, len, ok, [](bool) {});
+    }
+
+    // The lagging leg missed this region
+    void mark_stale(uint64_t addr, uint32_t len) {
+        auto lk = std::scoped_lock< std::mutex >(_lock);
+        __mark_stale(addr, len);
+    }
+
+    // Marks the region stale if a write to it is in flight on the lagging leg, which could land
+    // after the region was resynced. Returns whether it did.
+    bool stale_if_in_flight(uint64_t addr, uint32_t len) {
+        if (0 == _bytes.load(std::memory_order_acquire)) return false;
+        auto lk = std::scoped_lock< std::mutex >(_lock);
+        if (!__in_flight(addr, len)) return false;
+        __mark_stale(addr, len);
+        return true;
+    }
+
+    // Whether a write to the region is in flight on the lagging leg
+    bool in_flight(uint64_t addr, uint32_t len) {
+        if (0 == _bytes.load(std::memory_order_acquire)) return false;
+        auto lk = std::scoped_lock< std::mutex >(_lock);
+        return __in_flight(addr, len);
+    }
+
+    // Hands over the stale regions nothing in flight touches any more
+    stale_regions take_stale() {
+        auto out = stale_regions{};
+        if (!_has_stale.load(std::memory_order_acquire)) return out;
+        auto lk = std::scoped_lock< std::mutex >(_lock);
+        auto keep = std::vector< std::pair< uint64_t, uint32_t > >{};
+        for (auto const& r : _stale)
+            (__in_flight(r.first, r.second) ? keep : out.regions).push_back(r);
+        _stale = std::move(keep);
+        _has_stale.store(!_stale.empty(), std::memory_order_release);
+        if (!out.regions.empty()) out.failed = std::exchange(_failed, false);
+        return out;
+    }
+
+    // The lagging leg lacks acked data: writes are in flight on it, or regions await resync
+    bool lagging() const noexcept {
+        return 0 < _bytes.load(std::memory_order_acquire) || _has_stale.load(std::memory_order_acquire);
+    }
+    uint64_t bytes() const noexcept { return _bytes.load(std::memory_order_acquire); }
+    bool stale() const noexcept { return _has_stale.load(std::memory_order_acquire); }
+
+private:
+    uint64_t __first(uint64_t addr) const noexcept { return addr / _chunk_size; }
+    uint64_t __last(uint64_t addr, uint32_t len) const noexcept { return (addr + std::max(len, 1U) - 1) / _chunk_size; }
+
+    bool __in_flight(uint64_t addr, uint32_t len) const {
+        if (_chunks.empty()) return false;
+        for (auto chunk = __first(addr); __last(addr, len) >= chunk; ++chunk)
+            if (_chunks.contains(chunk)) return true;
+        return false;
+    }
+
+    bool __stale(uint64_t addr, uint32_t len) const {
+        return std::any_of(_stale.begin(), _stale.end(), [&](auto const& r) {
+            return __first(addr) <= __last(r.first, r.second) && __first(r.first) <= __last(addr, len);
+        });
+    }
+
+    void __mark_stale(uint64_t addr, uint32_t len) {
+        _stale.emplace_back(addr, len);
+        _has_stale.store(true, std::memory_order_release);
+    }
+
+    uint64_t const _max_bytes;
+    uint32_t const _chunk_size;
+    std::atomic< uint64_t > _bytes{0};
+    std::atomic< bool > _has_stale{false};
+
+    std::mutex _lock; // Guards the members below
+    std::unordered_map< uint64_t, uint32_t > _chunks; // Chunk index -> behind writes in flight touching it
+    std::vector< std::pair< uint64_t, uint32_t > > _stale;
+    bool _failed{false};
+};
+
+} // namespace ublkpp::raid1
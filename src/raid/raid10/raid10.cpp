@@ -0,0 +1,1067 @@
+#include "ublkpp/raid.hpp"
+
+#include <bit>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <boost/uuid/uuid_io.hpp>
+#include <sisl/options/options.h>
+#include <ublksrv.h>
+#include <ublksrv_utils.h>
+
+#include <ublkpp/lib/cqe_state.hpp>
+#include <ublkpp/lib/ublk_disk.hpp>
+
+#include "ublkpp/stack.hpp"
+#include "raid10_impl.hpp"
+#include "raid/leg_io.hpp"
+#include "raid/superblock.hpp"
+#include "raid/raid1/region_tracker.hpp"
+#include "lib/logging.hpp"
+
+namespace ublkpp {
+// Same bound as RAID0: max(max_io_size) / min(stripe_size) = 1 MiB / 64 KiB = 16
+constexpr uint32_t k_max_fragments{16};
+// A failed write is reissued this many times on the same leg before the leg is failed
+constexpr uint32_t k_write_retries{1};
+// Rebuild progress is persisted every this many leg rows
+constexpr uint64_t k_checkpoint_rows{256};
+// How long the rebuild waits out writes to the row it is about to copy
+constexpr auto k_rebuild_backoff = std::chrono::microseconds(50);
+// Once this many regions are dirty, marking more first clears those with no write in flight
+constexpr uint32_t k_dirty_high_water{256};
+// Regions are marked dirty this many at a time, as with RAID5
+constexpr uint32_t k_dirty_group{16};
+static_assert(0 == 64 % k_dirty_group, "a group must not straddle a word of the dirty bitmap");
+// How long a write parks on its ring between checks that its regions have been marked
+constexpr long k_mark_backoff_ns{50'000};
+
+// One stripe-sized piece of a user I/O and the two places it lives. The iovec must stay alive
+// until every child I/O on it completes: io_uring reads it at submit time.
+struct Fragment {
+    std::array< raid10::copy_loc, 2 > copies;
+    iovec iov;
+};
+
+class MirrorLeg {
+    struct destroy_sb {
+        void operator()(raid10::SuperBlock* p) const {
+            DEBUG_ASSERT_NOTNULL(p, "Freeing NULL ptr!") // LCOV_EXCL_LINE
+            free(p);
+        }
+    };
+
+public:
+    MirrorLeg(std::shared_ptr< ublk_disk > device, raid10::SuperBlock* super) :
+            disk(std::move(device)), io(disk.get()), _sb(super, destroy_sb()) {}
+    std::shared_ptr< ublk_disk > disk;    // Guarded by _sb_lock
+    std::shared_ptr< ublk_disk > retired; // Previous disk of a replaced leg, kept for racing I/O
+    std::atomic< ublk_disk* > io;         // What the I/O path dereferences
+    std::unique_ptr< raid10::SuperBlock, destroy_sb > _sb; // nullptr for a missing leg
+};
+
+static const uint8_t magic_bytes[16] = {0264, 0013, 0327, 0145, 0376, 0222, 0061, 0130,
+                                        0007, 0233, 0350, 0116, 0312, 0045, 0171, 0244};
+using raid10::k_dirty_regions;
+using raid10::k_dirty_words;
+using raid10::k_no_slot;
+using raid10::k_sb_version;
+
+// File-local concrete ublk_disk; constructed only via the make_raid10_disk factory below.
+//
+// Unlike RAID0 over RAID1, both copies of a stripe are addressed directly on the legs: each user
+// I/O is split once and fanned out as child I/Os, with a single superblock set describing the
+// whole array. A failed leg is brought back by replace_device(), which copies every row back onto
+// the new leg from its mirror in the background.
+class Raid10Disk : public ublk_disk {
+    std::vector< std::unique_ptr< MirrorLeg > > _legs;
+    raid10::Geometry _geo;
+
+    // Legs that missed a write (or were absent at assembly); excluded from all I/O.
+    std::atomic< uint64_t > _failed{0};
+    std::atomic< uint32_t > _rebuild_leg{k_no_slot};
+    std::atomic< uint64_t > _rebuild_cursor{0}; // Leg rows below this are rebuilt on _rebuild_leg
+    mutable std::mutex _sb_lock; // Guards _age, _queues, leg replacement and superblock writes
+    uint64_t _age{0};
+    std::thread _rebuild_thread;
+    std::atomic< bool > _stopping{false};
+
+    // Writes in flight on _rebuild_leg, by leg offset; the rebuild copies no row one of them touches
+    std::unique_ptr< raid1::RegionTracker > _rebuild_writes;
+    // Writes in flight by epoch, so the rebuild can wait out those that sampled the array before it
+    std::atomic< uint32_t > _write_epoch{0};
+    std::array< std::atomic< uint32_t >, 2 > _epoch_writes{};
+    std::vector< ublksrv_queue const* > _queues; // Every queue prepare() has seen
+    size_t _leg_sqes{0};                         // SQEs per I/O the queues sized their pools for per leg
+
+    // Write-intent log, as in RAID5: stripes are grouped into regions of _region_stripes, and a
+    // region's bit is persisted in the superblock before any write to it goes out. A crash between
+    // the writes of a stripe's two copies leaves them different; __resync() copies the first over
+    // the second in the regions found dirty at assembly.
+    uint64_t _region_stripes{1};
+    std::array< std::atomic< uint64_t >, k_dirty_words > _dirty{};    // Set under _sb_lock
+    std::array< std::atomic< uint64_t >, k_dirty_words > _unsynced{}; // Found dirty at assembly
+    std::unique_ptr< std::atomic< uint32_t >[] > _region_writes;     // Writes in flight per region
+    // Regions writes are waiting on, persisted in batches by _mark_thread off the queue threads
+    std::array< std::atomic< uint64_t >, k_dirty_words > _wanted{};
+    std::array< uint64_t, k_dirty_words > _marking{}; // Being persisted; guarded by _sb_lock
+    std::mutex _mark_lock;
+    std::condition_variable _mark_cv;
+    bool _mark_wanted{false}; // Guarded by _mark_lock
+    std::thread _mark_thread;
+    // Writes in flight by array offset while __resync() runs; it copies no stripe one of them touches
+    std::unique_ptr< raid1::RegionTracker > _resync_writes;
+    std::atomic< bool > _resyncing{false};
+
+    // Held by a write for its whole life: counts it in its epoch and, while a rebuild runs, keeps
+    // the rebuild off the rows it writes on the rebuilding leg.
+    class WriteGuard {
+    public:
+        WriteGuard(Raid10Disk& raid, std::array< Fragment, k_max_fragments > const& frags, uint32_t cnt) noexcept;
+        ~WriteGuard() noexcept;
+        WriteGuard(WriteGuard&&) = delete;
+        WriteGuard(WriteGuard const&) = delete;
+        WriteGuard& operator=(WriteGuard&&) = delete;
+        WriteGuard& operator=(WriteGuard const&) = delete;
+
+    private:
+        Raid10Disk& _raid;
+        std::atomic< uint32_t >* _count;
+        // Hulls of the write on the rebuilding leg: one per half of a FAR leg
+        std::array< std::pair< uint64_t, uint32_t >, 2 > _tracked{};
+        uint32_t _nr_tracked{0};
+    };
+
+    // Held by a write for its whole life: counts it in the regions it touches, which
+    // __clear_region() leaves dirty meanwhile, and keeps __resync() off its stripes.
+    class DirtyGuard {
+    public:
+        DirtyGuard(Raid10Disk& raid, uint64_t addr, uint64_t len) noexcept;
+        ~DirtyGuard() noexcept;
+        DirtyGuard(DirtyGuard&&) = delete;
+        DirtyGuard(DirtyGuard const&) = delete;
+        DirtyGuard& operator=(DirtyGuard&&) = delete;
+        DirtyGuard& operator=(DirtyGuard const&) = delete;
+        uint64_t first() const noexcept { return _first; }
+        uint64_t last() const noexcept { return _last; }
+
+    private:
+        Raid10Disk& _raid;
+        uint64_t const _addr;
+        uint32_t const _len;
+        uint64_t const _first;
+        uint64_t const _last;
+        bool _tracked{false};
+    };
+
+    bool __usable(uint32_t const leg, uint64_t const off) const noexcept {
+        if (_failed.load(std::memory_order_acquire) & (1ULL << leg)) return false;
+        return _rebuild_leg.load(std::memory_order_acquire) != leg ||
+            off / _geo.stripe_size < _rebuild_cursor.load(std::memory_order_acquire);
+    }
+    ublk_disk& __dev(uint32_t const leg) const noexcept { return *_legs[leg]->io.load(std::memory_order_acquire); }
+    uint32_t __plan(std::array< Fragment, k_max_fragments >& frags, iovec const& iov, uint64_t addr) const noexcept;
+    void __fail_leg(uint32_t leg);
+    void __persist_sb();
+    void __stamp_dirty(raid10::SuperBlock& sb) const noexcept;
+    void __drain_writes() noexcept;
+    void __rebuild();
+
+    uint64_t __region_of(uint64_t const addr) const noexcept { return addr / _geo.stripe_size / _region_stripes; }
+    bool __is_dirty(uint64_t const region) const noexcept {
+        return _dirty[region / 64].load(std::memory_order_seq_cst) & (1ULL << (region % 64));
+    }
+    bool __want_marked(uint64_t first, uint64_t last) noexcept;
+    disk_task< int > __await_dirty(ublksrv_queue const* q, ublk_io_data const* data, uint64_t first, uint64_t last);
+    void __mark_dirty(uint64_t first, uint64_t last);
+    void __flush_marks();
+    void __persist_marks();
+    bool __clear_region(uint64_t region) noexcept;
+    bool __clear_idle() noexcept;
+    void __resync();
+
+protected:
+    // The I/O path with legs of type `Leg` (see leg_io); async_iov() takes it with Leg = ublk_disk
+    template < typename Leg >
+    disk_task< int > __async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
+                                 uint64_t addr);
+    // Whether replace_device() may take `leg`; subclasses fixing the leg type refuse others
+    virtual bool __accepts(ublk_disk const&) const noexcept { return true; }
+
+public:
+    Raid10Disk(boost::uuids::uuid const& uuid, uint32_t const stripe_size_bytes,
+               std::vector< std::shared_ptr< ublk_disk > >&& disks, raid10::layout lay);
+    ~Raid10Disk() override;
+
+    std::vector< std::string > failed_devices() const;
+    bool replace_device(std::string const& old_device_id, std::shared_ptr< ublk_disk > new_device);
+    uint64_t rebuild_remaining() const noexcept;
+
+    std::string id() const noexcept override { return "RAID10"; }
+    prepare_result prepare(ublksrv_queue const*, int const iouring_device) override;
+
+    disk_task< int > async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
+                               uint64_t addr) override;
+
+    void probe_tick(ublksrv_queue const* q) noexcept override;
+
+    io_result sync_iov(uint8_t op, iovec* iovecs, uint32_t nr_vecs, off_t offset) noexcept override;
+};
+
+Raid10Disk::Raid10Disk(boost::uuids::uuid const& uuid, uint32_t const stripe_size_bytes,
+                       std::vector< std::shared_ptr< ublk_disk > >&& disks, raid10::layout lay) :
+        ublk_disk() {
+    if (stripe_size_bytes == 0 || (stripe_size_bytes & (stripe_size_bytes - 1)))
+        throw std::invalid_argument(
+            fmt::format("Raid10Disk: stripe_size_bytes ({}) must be a non-zero power of 2", stripe_size_bytes));
+    if (disks.size() < 2 || disks.size() > raid10::k_max_width)
+        throw std::invalid_argument(
+            fmt::format("Raid10Disk: {} disks given, need 2 to {}", disks.size(), raid10::k_max_width));
+    if (raid10::layout::NEAR == lay && (disks.size() % 2))
+        throw std::invalid_argument(fmt::format("Raid10Disk: near layout needs an even disk count, got {}",
+                                                disks.size()));
+    _geo = raid10::Geometry{.lay = lay,
+                            .width = static_cast< uint32_t >(disks.size()),
+                            .stripe_size = stripe_size_bytes,
+                            .rows = 0};
+
+    // Discover overall Device parameters
+    auto& our_params = *params();
+    our_params.types |= UBLK_PARAM_TYPE_DISCARD;
+    our_params.basic.dev_sectors = UINT64_MAX;
+    _direct_io = true;
+
+    // Read every leg's superblock; the initialized one with the highest age decides the geometry
+    // and which legs have failed.
+    auto fresh = uint64_t{0};
+    auto failed = uint64_t{0};
+    auto found = std::optional< raid10::SuperBlock >();
+    for (auto&& device : disks) {
+        auto const slot = static_cast< uint16_t >(_legs.size());
+        auto const bit = 1ULL << slot;
+        if (device->is_missing()) {
+            RLOGW("RAID10 leg {} is missing [uuid:{}]", slot, to_string(uuid))
+            failed |= bit;
+            _legs.emplace_back(std::make_unique< MirrorLeg >(std::move(device), nullptr));
+            continue;
+        }
+        our_params.basic.dev_sectors =
+            std::min< uint64_t >(our_params.basic.dev_sectors, device->capacity() >> SECTOR_SHIFT);
+        our_params.basic.logical_bs_shift =
+            std::max(our_params.basic.logical_bs_shift, static_cast< uint8_t >(ilog2(device->block_size())));
+        our_params.basic.max_sectors =
+            std::min(our_params.basic.max_sectors, static_cast< uint32_t >(device->max_tx() >> SECTOR_SHIFT));
+        if (!device->can_discard()) our_params.types &= ~UBLK_PARAM_TYPE_DISCARD;
+        _direct_io = _direct_io ? device->direct_io() : false;
+
+        auto sb = read_superblock< raid10::SuperBlock >(*device);
+        if (!sb) throw std::runtime_error(fmt::format("Could not read superblock from {}!", *device));
+        _legs.emplace_back(std::make_unique< MirrorLeg >(device, sb));
+
+        if (memcmp(sb->header.magic, magic_bytes, sizeof(magic_bytes))) {
+            memset(sb, 0x00, sizeof(raid10::SuperBlock));
+            memcpy(sb->header.magic, magic_bytes, sizeof(magic_bytes));
+            memcpy(sb->header.uuid, uuid.data, sizeof(sb->header.uuid));
+            sb->header.version = htobe16(k_sb_version);
+            sb->fields.slot = htobe16(slot);
+            fresh |= bit;
+            continue;
+        }
+        auto read_uuid = boost::uuids::uuid();
+        memcpy(read_uuid.data, sb->header.uuid, sizeof(sb->header.uuid));
+        if (uuid != read_uuid)
+            throw std::runtime_error(fmt::format("Superblock on {} did not have a matching UUID expected: {} read: {}",
+                                                 *device, to_string(uuid), to_string(read_uuid)));
+        if (auto const sb_ver = be16toh(sb->header.version); sb_ver > k_sb_version)
+            throw std::runtime_error(fmt::format("Superblock version {:#0x} on {} is newer than supported {:#0x}",
+                                                 sb_ver, *device, k_sb_version));
+        if (slot != be16toh(sb->fields.slot) || _geo.width != be16toh(sb->fields.width))
+            throw std::runtime_error(fmt::format(
+                "Superblock on {} does not match given array: Expected [slot:{}, width:{}] != Found [slot:{}, width:{}]",
+                *device, slot, _geo.width, be16toh(sb->fields.slot), be16toh(sb->fields.width)));
+        if (found &&
+            (found->fields.stripe_size != sb->fields.stripe_size || found->fields.layout != sb->fields.layout))
+            throw std::runtime_error(fmt::format("Superblock on {} has mismatched array geometry!", *device));
+        if (!found || be64toh(found->fields.age) < be64toh(sb->fields.age)) found = *sb;
+    }
+
+    auto rebuild = k_no_slot;
+    auto rebuild_row = uint64_t{1};
+    if (found) {
+        // The on-disk geometry wins over the requested one, as with RAID0
+        auto const disk_stripe = be32toh(found->fields.stripe_size);
+        auto const disk_layout = static_cast< raid10::layout >(found->fields.layout);
+        if (disk_stripe != _geo.stripe_size || disk_layout != _geo.lay)
+            RLOGW("Superblock does not match given array parameters: Expected [stripe_sz:{:#0x}, layout:{}] != "
+                  "Found [stripe_sz:{:#0x}, layout:{}]",
+                  _geo.stripe_size, enum_name(_geo.lay), disk_stripe, enum_name(disk_layout))
+        _geo.stripe_size = disk_stripe;
+        _geo.lay = disk_layout;
+        if (raid10::layout::NEAR == _geo.lay && (_geo.width % 2))
+            throw std::runtime_error(fmt::format("Raid10Disk: on-disk near layout with odd width {}", _geo.width));
+        _age = be64toh(found->fields.age);
+        failed |= be64toh(found->fields.failed);
+        // A blank leg joining an existing array holds none of its data
+        if (fresh) RLOGW("RAID10 legs {:#x} are blank in an existing array; marking them failed", fresh)
+        failed |= fresh;
+        // Version 1 superblocks predate rebuilds. A rebuild onto a leg that has since failed or
+        // been swapped out is abandoned.
+        if (auto const slot = be16toh(found->fields.rebuild_slot); 2 <= be16toh(found->header.version) &&
+            k_no_slot != slot && _geo.width > slot && !(failed & (1ULL << slot))) {
+            rebuild = slot;
+            rebuild_row = std::max< uint64_t >(1, be64toh(found->fields.rebuild_row));
+        }
+        if (failed != be64toh(found->fields.failed)) ++_age;
+    } else
+        RLOGI("Initializing RAID-10 [stripe_size:{}KiB, layout:{}, width:{}, uuid:{}]", _geo.stripe_size / Ki,
+              enum_name(_geo.lay), _geo.width, to_string(uuid))
+    // Rows a rebuild has yet to reach are as good as lost on its leg
+    if (auto const lost = failed | ((k_no_slot != rebuild) ? 1ULL << rebuild : 0); _geo.loses_data(lost))
+        throw std::runtime_error(
+            fmt::format("Raid10Disk: failed legs {:#x} hold both copies of some stripe; refusing to assemble", lost));
+    _failed.store(failed, std::memory_order_release);
+    _rebuild_cursor.store(rebuild_row, std::memory_order_release);
+    _rebuild_leg.store(rebuild, std::memory_order_release);
+
+    // Each leg gives up its first stripe for the superblock; only whole stripes are usable.
+    auto const stripe_size_sectors = static_cast< uint64_t >(_geo.stripe_size >> SECTOR_SHIFT);
+    _geo.rows = our_params.basic.dev_sectors / stripe_size_sectors;
+    _geo.rows = (0 < _geo.rows) ? _geo.rows - 1 : 0;
+    if (_geo.capacity() == 0)
+        throw std::runtime_error(
+            fmt::format("Raid10Disk: device capacity ({} sectors) is too small for stripe_size ({} sectors)",
+                        our_params.basic.dev_sectors, stripe_size_sectors));
+
+    // Pick up the regions a crash left dirty. Every copy is merged: a leg that failed since only
+    // adds regions to check. One from before version 3 kept no record, and a bitmap kept at another
+    // granularity cannot be mapped onto ours; either way every region is checked.
+    _region_stripes = std::max< uint64_t >(1, (_geo.capacity() / _geo.stripe_size + k_dirty_regions - 1) /
+                                                   k_dirty_regions);
+    _region_writes = std::make_unique< std::atomic< uint32_t >[] >(k_dirty_regions);
+    auto remap = false;
+    for (auto slot = 0U; _legs.size() > slot; ++slot) {
+        auto const* sb = _legs[slot]->_sb.get();
+        if (!sb || (fresh & (1ULL << slot)) || sb->fields.clean) continue;
+        if (3 > be16toh(sb->header.version) || be32toh(sb->fields.dirty_stripes) != _region_stripes) {
+            remap = true;
+            continue;
+        }
+        for (auto w = 0U; k_dirty_words > w; ++w)
+            _unsynced[w].fetch_or(be64toh(sb->fields.dirty[w]), std::memory_order_relaxed);
+    }
+    if (remap)
+        for (auto region = 0UL; __region_of(_geo.capacity() - 1) >= region; ++region)
+            _unsynced[region / 64].fetch_or(1ULL << (region % 64), std::memory_order_relaxed);
+    auto unsynced = 0U;
+    for (auto w = 0U; k_dirty_words > w; ++w) {
+        auto const bits = _unsynced[w].load(std::memory_order_relaxed);
+        _dirty[w].store(bits, std::memory_order_relaxed);
+        unsynced += static_cast< uint32_t >(std::popcount(bits));
+    }
+    if (0 < unsynced)
+        RLOGW("RAID10 was not shut down cleanly: copying {} regions over to their second copies [uuid:{}]", unsynced,
+              to_string(uuid))
+
+    // Bring every reachable superblock up to the authoritative state; until a clean shutdown,
+    // none of them is clean
+    for (auto slot = 0U; _legs.size() > slot; ++slot) {
+        auto& leg = *_legs[slot];
+        if (!leg._sb) continue;
+        auto& fields = leg._sb->fields;
+        auto const stale = (fresh & (1ULL << slot)) || be64toh(fields.age) != _age ||
+            be64toh(fields.failed) != failed || be16toh(fields.rebuild_slot) != rebuild ||
+            be16toh(leg._sb->header.version) != k_sb_version || 0 != fields.clean ||
+            be32toh(fields.dirty_stripes) != _region_stripes;
+        if (!stale) continue;
+        leg._sb->header.version = htobe16(k_sb_version);
+        fields.width = htobe16(static_cast< uint16_t >(_geo.width));
+        fields.layout = static_cast< uint8_t >(_geo.lay);
+        fields.stripe_size = htobe32(_geo.stripe_size);
+        fields.age = htobe64(_age);
+        fields.failed = htobe64(failed);
+        fields.rebuild_slot = htobe16(rebuild);
+        fields.rebuild_row = htobe64(rebuild_row);
+        fields.clean = 0;
+        __stamp_dirty(*leg._sb);
+        if (!write_superblock(*leg.disk, leg._sb.get()) && !(failed & (1ULL << slot)))
+            throw std::runtime_error(fmt::format("Could not write superblock to {}!", *leg.disk));
+    }
+
+    our_params.basic.physical_bs_shift = ilog2(_geo.stripe_size);
+    our_params.basic.dev_sectors = _geo.capacity() >> SECTOR_SHIFT;
+
+    // A user I/O is split at stripe boundaries; cap it so the fragments fit k_max_fragments.
+    if (our_params.basic.max_sectors == 0)
+        throw std::runtime_error("Raid10Disk: max_sectors is zero; child device reported max_tx() == 0");
+    our_params.basic.max_sectors = static_cast< uint32_t >(std::min< uint64_t >(
+        static_cast< uint64_t >(our_params.basic.max_sectors) * (raid10::layout::FAR == _geo.lay ? _geo.width
+                                                                                                 : _geo.width / 2),
+        (k_max_fragments - 1) * stripe_size_sectors));
+    // Align size to max_sector size
+    our_params.basic.dev_sectors -= (our_params.basic.dev_sectors % our_params.basic.max_sectors);
+
+    if (can_discard()) {
+        our_params.discard.discard_granularity = std::max(our_params.discard.discard_granularity, block_size());
+        our_params.discard.max_discard_sectors = our_params.basic.max_sectors;
+    }
+
+    // A write holds up to two slots (see WriteGuard); size for 2×qdepth writes in flight
+    auto const slots = SISL_OPTIONS.count("qdepth") ? 4u * SISL_OPTIONS["qdepth"].as< uint16_t >() : 512u;
+    _rebuild_writes = std::make_unique< raid1::RegionTracker >(slots, _geo.stripe_size);
+    _resync_writes = std::make_unique< raid1::RegionTracker >(slots / 2, _geo.stripe_size);
+    _resyncing.store(0 < unsynced, std::memory_order_release);
+    if (k_no_slot != rebuild || 0 < unsynced) _rebuild_thread = std::thread([this] {
+        __rebuild();
+        __resync();
+    });
+    _mark_thread = std::thread([this] { __persist_marks(); });
+}
+
+Raid10Disk::~Raid10Disk() {
+    {
+        auto lk = std::scoped_lock(_mark_lock);
+        _stopping.store(true, std::memory_order_release);
+    }
+    _mark_cv.notify_all();
+    if (_mark_thread.joinable()) _mark_thread.join();
+    if (_rebuild_thread.joinable()) _rebuild_thread.join();
+    // Every write has completed: only regions still awaiting a resync stay dirty, and with none
+    // left the array is clean
+    auto lk = std::scoped_lock(_sb_lock);
+    __clear_idle();
+    auto clean = true;
+    for (auto const& w : _unsynced)
+        clean = clean && (0 == w.load(std::memory_order_acquire));
+    for (auto const& leg : _legs)
+        if (leg->_sb) leg->_sb->fields.clean = clean ? 1 : 0;
+    __persist_sb();
+}
+
+std::vector< std::string > Raid10Disk::failed_devices() const {
+    auto lk = std::scoped_lock(_sb_lock);
+    auto res = std::vector< std::string >();
+    auto const failed = _failed.load(std::memory_order_acquire);
+    for (auto slot = 0U; _legs.size() > slot; ++slot)
+        if (failed & (1ULL << slot)) res.push_back(_legs[slot]->disk->id());
+    return res;
+}
+
+Raid10Disk::prepare_result Raid10Disk::prepare(ublksrv_queue const* q, int const iouring_device_start) {
+    prepare_result result;
+    auto child_max = size_t{1};
+    auto lk = std::scoped_lock(_sb_lock);
+    for (auto& leg : _legs) {
+        auto child = leg->disk->prepare(q, iouring_device_start + static_cast< int >(result.fds.size()));
+        result.fds.insert(result.fds.end(), child.fds.begin(), child.fds.end());
+        child_max = std::max(child_max, child.max_sqes_per_io);
+        result.polled = result.polled || child.polled;
+    }
+    // Remember the queues, so a replacement leg can be prepared for them too
+    if (q) _queues.push_back(q);
+    _leg_sqes = child_max;
+    // Every fragment is written to two legs, each write reissued up to k_write_retries times; a read
+    // issues at most one retry per fragment. +1 fragment for an unaligned start.
+    auto const frags = std::min< size_t >((max_tx() + _geo.stripe_size - 1) / _geo.stripe_size + 1, k_max_fragments);
+    result.max_sqes_per_io = 2 * (1 + k_write_retries) * frags * child_max;
+    return result;
+}
+
+void Raid10Disk::probe_tick(ublksrv_queue const* q) noexcept {
+    for (auto i = 0U; _legs.size() > i; ++i) {
+        __dev(i).probe_tick(q);
+    }
+}
+
+uint64_t Raid10Disk::rebuild_remaining() const noexcept {
+    if (k_no_slot == _rebuild_leg.load(std::memory_order_acquire)) return 0;
+    auto const cursor = _rebuild_cursor.load(std::memory_order_acquire);
+    return (_geo.rows + 1 > cursor) ? (_geo.rows + 1 - cursor) * _geo.stripe_size : 0;
+}
+
+// Split [addr, addr + iov.iov_len) at stripe boundaries. Returns the number of fragments, or 0 if
+// the I/O would need more than k_max_fragments.
+uint32_t Raid10Disk::__plan(std::array< Fragment, k_max_fragments >& frags, iovec const& iov,
+                            uint64_t addr) const noexcept {
+    DEBUG_ASSERT_LE(iov.iov_len, UINT32_MAX) // LCOV_EXCL_LINE
+    auto const len = static_cast< uint32_t >(iov.iov_len);
+    auto cnt = 0U;
+    for (auto off = 0U; len > off; ++cnt) {
+        if (k_max_fragments == cnt) [[unlikely]]
+            return 0;
+        auto& frag = frags[cnt];
+        auto const sz = _geo.map(addr + off, len - off, frag.copies);
+        frag.iov = iovec{.iov_base = iov.iov_base ? static_cast< uint8_t* >(iov.iov_base) + off : nullptr,
+                         .iov_len = sz};
+        off += sz;
+    }
+    return cnt;
+}
+
+// Drop `leg` from the array and record it in every surviving superblock. Called once a write
+// missed the leg even after k_write_retries reissues, so its copy can no longer be trusted.
+void Raid10Disk::__fail_leg(uint32_t const leg) {
+    auto lk = std::scoped_lock(_sb_lock);
+    auto const failed = _failed.load(std::memory_order_acquire);
+    if (failed & (1ULL << leg)) return;
+    RLOGE("RAID10 leg {} [{}] failed; array is degraded", leg, *_legs[leg]->disk)
+    _failed.store(failed | (1ULL << leg), std::memory_order_release);
+    if (leg == _rebuild_leg.load(std::memory_order_acquire)) _rebuild_leg.store(k_no_slot, std::memory_order_release);
+    ++_age;
+    __persist_sb();
+}
+
+// Write the current array state to every leg still in it. Caller holds _sb_lock.
+void Raid10Disk::__persist_sb() {
+    auto const failed = _failed.load(std::memory_order_acquire);
+    auto const rebuild = static_cast< uint16_t >(_rebuild_leg.load(std::memory_order_acquire));
+    auto const cursor = _rebuild_cursor.load(std::memory_order_acquire);
+    for (auto slot = 0U; _legs.size() > slot; ++slot) {
+        auto& sb = _legs[slot]->_sb;
+        if (!sb || (failed & (1ULL << slot))) continue;
+        sb->fields.age = htobe64(_age);
+        sb->fields.failed = htobe64(failed);
+        sb->fields.rebuild_slot = htobe16(rebuild);
+        sb->fields.rebuild_row = htobe64(cursor);
+        __stamp_dirty(*sb);
+        if (!write_superblock(*_legs[slot]->disk, sb.get()))
+            RLOGE("Could not record array state on {}", *_legs[slot]->disk)
+    }
+}
+
+// Record the dirty regions, and those being marked, in `sb`
+void Raid10Disk::__stamp_dirty(raid10::SuperBlock& sb) const noexcept {
+    sb.fields.dirty_stripes = htobe32(static_cast< uint32_t >(_region_stripes));
+    for (auto w = 0U; k_dirty_words > w; ++w)
+        sb.fields.dirty[w] = htobe64(_dirty[w].load(std::memory_order_acquire) | _marking[w]);
+}
+
+// Park the I/O `data` on a ring timeout of `ns`, letting the queue get on with others meanwhile
+static disk_task< int > park(ublksrv_queue const* q, ublk_io_data const* data, long const ns) {
+    auto* sqe = next_sqe(q);
+    while (!sqe && co_await sq_space(q, data))
+        sqe = next_sqe(q);
+    if (!sqe) [[unlikely]]
+        co_return -EBUSY;
+    // Lives in this frame, not the I/O's pool, which has no room for it; the I/O still owns it, so
+    // an exception on resume fails the I/O
+    auto state = cqe_state{._owner = reinterpret_cast< async_io* >(data->private_data)};
+    __kernel_timespec ts{.tv_sec = 0, .tv_nsec = ns};
+    io_uring_prep_timeout(sqe, &ts, 0, 0);
+    sqe->user_data = sisl::async::encode_managed_user_data(&state);
+    co_await state;
+    co_return 0;
+}
+
+Raid10Disk::DirtyGuard::DirtyGuard(Raid10Disk& raid, uint64_t const addr, uint64_t const len) noexcept :
+        _raid(raid),
+        _addr(addr),
+        _len(static_cast< uint32_t >(std::max< uint64_t >(len, 1))),
+        _first(raid.__region_of(addr)),
+        _last(raid.__region_of(addr + _len - 1)) {
+    for (auto region = _first; _last >= region; ++region)
+        _raid._region_writes[region].fetch_add(1, std::memory_order_seq_cst);
+    // __resync() only runs from assembly, before any write, so no write can miss it starting
+    if (_raid._resyncing.load(std::memory_order_acquire)) {
+        _raid._resync_writes->track(_addr, _len);
+        _tracked = true;
+    }
+}
+
+Raid10Disk::DirtyGuard::~DirtyGuard() noexcept {
+    if (_tracked) _raid._resync_writes->untrack(_addr, _len);
+    for (auto region = _first; _last >= region; ++region)
+        _raid._region_writes[region].fetch_sub(1, std::memory_order_release);
+}
+
+// Ask for the groups of regions [first, last] to be marked dirty; false if they all are already
+bool Raid10Disk::__want_marked(uint64_t const first, uint64_t const last) noexcept {
+    auto const end = __region_of(_geo.capacity() - 1) + 1;
+    auto wanted = false;
+    for (auto region = first; last >= region; ++region) {
+        if (__is_dirty(region)) continue;
+        auto const group = region - region % k_dirty_group;
+        auto bits = uint64_t{0};
+        for (auto r = group; std::min< uint64_t >(group + k_dirty_group, end) > r; ++r)
+            bits |= 1ULL << (r % 64);
+        _wanted[group / 64].fetch_or(bits, std::memory_order_release);
+        wanted = true;
+    }
+    return wanted;
+}
+
+// Make sure every superblock records regions [first, last] dirty before a write to them goes out.
+// The queue thread does not write superblocks: it hands the regions to the marking thread, which
+// persists them with whatever else is waiting, and parks the I/O on its ring until that is done.
+disk_task< int > Raid10Disk::__await_dirty(ublksrv_queue const* q, ublk_io_data const* data, uint64_t const first,
+                                           uint64_t const last) {
+    if (!__want_marked(first, last)) co_return 0;
+    {
+        auto lk = std::scoped_lock(_mark_lock);
+        _mark_wanted = true;
+    }
+    _mark_cv.notify_one();
+    for (auto region = first; last >= region; ++region)
+        while (!__is_dirty(region))
+            if (auto const r = co_await park(q, data, k_mark_backoff_ns).start(); 0 > r) co_return r;
+    co_return 0;
+}
+
+// As __await_dirty(), for plain threads, which may block: the regions are persisted right here
+void Raid10Disk::__mark_dirty(uint64_t const first, uint64_t const last) {
+    if (!__want_marked(first, last)) return;
+    auto lk = std::scoped_lock(_sb_lock);
+    __flush_marks();
+}
+
+// Persist every region asked for in one superblock write per leg, then publish them: writes that
+// find their bits set go straight out. Caller holds _sb_lock.
+void Raid10Disk::__flush_marks() {
+    auto any = false;
+    for (auto w = 0U; k_dirty_words > w; ++w) {
+        _marking[w] = _wanted[w].exchange(0, std::memory_order_acq_rel) & ~_dirty[w].load(std::memory_order_acquire);
+        any = any || (0 != _marking[w]);
+    }
+    if (!any) return;
+    // Keep the set small, so a crash leaves little to copy
+    auto dirty = 0U;
+    for (auto w = 0U; k_dirty_words > w; ++w)
+        dirty += static_cast< uint32_t >(std::popcount(_dirty[w].load(std::memory_order_acquire) | _marking[w]));
+    if (k_dirty_high_water <= dirty) __clear_idle();
+    __persist_sb();
+    for (auto w = 0U; k_dirty_words > w; ++w)
+        if (0 != _marking[w]) _dirty[w].fetch_or(std::exchange(_marking[w], 0), std::memory_order_seq_cst);
+}
+
+// Marking thread: persists the regions parked writes wait on, as many at once as have piled up
+void Raid10Disk::__persist_marks() {
+    auto lk = std::unique_lock(_mark_lock);
+    while (!_stopping.load(std::memory_order_acquire)) {
+        if (!std::exchange(_mark_wanted, false)) {
+            _mark_cv.wait(lk);
+            continue;
+        }
+        lk.unlock();
+        {
+            auto sb_lk = std::scoped_lock(_sb_lock);
+            __flush_marks();
+        }
+        lk.lock();
+    }
+}
+
+// Clear a region's bit unless a write is in flight there or it still awaits __resync(). Pairs with
+// __await_dirty(): a write that counted itself before the bit was cleared is seen here and the bit
+// restored; one that counts itself after finds the bit clear and marks it again. Returns whether
+// the bit was cleared. Caller holds _sb_lock.
+bool Raid10Disk::__clear_region(uint64_t const region) noexcept {
+    auto const bit = 1ULL << (region % 64);
+    auto& word = _dirty[region / 64];
+    if (!(word.load(std::memory_order_acquire) & bit) || (_unsynced[region / 64].load(std::memory_order_acquire) & bit))
+        return false;
+    word.fetch_and(~bit, std::memory_order_seq_cst);
+    if (0 == _region_writes[region].load(std::memory_order_seq_cst)) return true;
+    word.fetch_or(bit, std::memory_order_seq_cst);
+    return false;
+}
+
+// Clear every dirty region with nothing in flight. Caller holds _sb_lock and persists the result.
+bool Raid10Disk::__clear_idle() noexcept {
+    auto cleared = false;
+    for (auto w = 0U; k_dirty_words > w; ++w)
+        for (auto bits = _dirty[w].load(std::memory_order_acquire); 0 != bits; bits &= bits - 1)
+            cleared = __clear_region(w * 64ULL + static_cast< uint64_t >(std::countr_zero(bits))) || cleared;
+    return cleared;
+}
+
+Raid10Disk::WriteGuard::WriteGuard(Raid10Disk& raid, std::array< Fragment, k_max_fragments > const& frags,
+                                   uint32_t const cnt) noexcept :
+        _raid(raid), _count(&raid._epoch_writes[raid._write_epoch.load(std::memory_order_seq_cst) & 1]) {
+    _count->fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // A rebuild published before the fence is seen here; one published later waits for this write
+    auto const leg = _raid._rebuild_leg.load(std::memory_order_acquire);
+    if (k_no_slot == leg) return;
+    auto const half = (raid10::layout::FAR == _raid._geo.lay) ? (1 + _raid._geo.rows / 2) * _raid._geo.stripe_size
+                                                              : UINT64_MAX;
+    std::array< std::pair< uint64_t, uint64_t >, 2 > hull{{{UINT64_MAX, 0}, {UINT64_MAX, 0}}};
+    for (auto i = 0U; cnt > i; ++i) {
+        for (auto const& copy : frags[i].copies) {
+            if (leg != copy.leg) continue;
+            auto& h = hull[(half <= copy.off) ? 1 : 0];
+            h.first = std::min(h.first, copy.off);
+            h.second = std::max(h.second, copy.off + frags[i].iov.iov_len);
+        }
+    }
+    for (auto const& h : hull) {
+        if (h.first >= h.second) continue;
+        _tracked[_nr_tracked++] = {h.first, static_cast< uint32_t >(h.second - h.first)};
+        _raid._rebuild_writes->track(h.first, static_cast< uint32_t >(h.second - h.first));
+    }
+}
+
+Raid10Disk::WriteGuard::~WriteGuard() noexcept {
+    for (auto i = 0U; _nr_tracked > i; ++i)
+        _raid._rebuild_writes->untrack(_tracked[i].first, _tracked[i].second);
+    _count->fetch_sub(1, std::memory_order_release);
+}
+
+// Wait for every write that may have sampled the array state before the caller changed it.
+void Raid10Disk::__drain_writes() noexcept {
+    auto const prev = _write_epoch.fetch_add(1, std::memory_order_seq_cst) & 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (0 < _epoch_writes[prev].load(std::memory_order_acquire))
+        std::this_thread::sleep_for(k_rebuild_backoff);
+}
+
+// Swap a failed leg for `new_device` and rebuild it in the background.
+bool Raid10Disk::replace_device(std::string const& old_device_id, std::shared_ptr< ublk_disk > new_device) {
+    if (!new_device || new_device->is_missing() || !__accepts(*new_device)) return false;
+    if (new_device->capacity() < (_geo.rows + 1) * _geo.stripe_size || new_device->block_size() > block_size()) {
+        RLOGW("Refusing replacement {} for {}: too small or incompatible block size", *new_device, id())
+        return false;
+    }
+    {
+        auto lk = std::scoped_lock(_sb_lock);
+        auto slot = 0U;
+        while (_legs.size() > slot && _legs[slot]->disk->id() != old_device_id)
+            ++slot;
+        auto const failed = _failed.load(std::memory_order_acquire);
+        if (_legs.size() == slot || !(failed & (1ULL << slot)) ||
+            k_no_slot != _rebuild_leg.load(std::memory_order_acquire)) {
+            RLOGW("Refusing replacement of [{}] in {}: no such failed leg or a rebuild is running", old_device_id,
+                  id())
+            return false;
+        }
+        // The running queues sized their cqe_state pools for the legs they were prepared with
+        if (0 < _leg_sqes && new_device->prepare(nullptr, 0).max_sqes_per_io > _leg_sqes) {
+            RLOGW("Refusing replacement {} for {}: needs more SQEs per I/O than the queues reserved", *new_device,
+                  id())
+            return false;
+        }
+        // Start the newcomer from a live leg's superblock
+        auto sb = static_cast< raid10::SuperBlock* >(nullptr);
+        for (auto i = 0U; _legs.size() > i && !sb; ++i)
+            if (_legs[i]->_sb && !(failed & (1ULL << i))) sb = read_superblock< raid10::SuperBlock >(*_legs[i]->disk);
+        if (!sb) return false;
+        sb->fields.slot = htobe16(static_cast< uint16_t >(slot));
+        for (auto const* q : _queues)
+            std::ignore = new_device->prepare(q, 0);
+
+        auto& leg = *_legs[slot];
+        leg.retired = std::exchange(leg.disk, new_device);
+        leg._sb.reset(sb);
+        leg.io.store(new_device.get(), std::memory_order_release);
+        // Publish the rebuild before the leg stops counting as failed: rows past the cursor
+        // serve no reads until rebuilt.
+        _rebuild_cursor.store(1, std::memory_order_release);
+        _rebuild_leg.store(slot, std::memory_order_release);
+        _failed.store(failed & ~(1ULL << slot), std::memory_order_release);
+        ++_age;
+        __persist_sb();
+        RLOGI("Replaced {} leg {} [{}] with {}; rebuilding", id(), slot, old_device_id, *new_device)
+    }
+    if (_rebuild_thread.joinable()) _rebuild_thread.join();
+    _rebuild_thread = std::thread([this] { __rebuild(); });
+    return true;
+}
+
+// Background rebuild: copy each row of the replaced leg from its mirror. Writes keep going to the
+// leg meanwhile; a row is only counted rebuilt once no write touched it while it was copied, so
+// the copy can never land over newer data.
+void Raid10Disk::__rebuild() {
+    auto const leg = _rebuild_leg.load(std::memory_order_acquire);
+    if (k_no_slot == leg) return;
+    auto buf = iovec{.iov_base = nullptr, .iov_len = _geo.stripe_size};
+    if (0 != ::posix_memalign(&buf.iov_base, 4096, _geo.stripe_size)) {
+        RLOGE("Out of memory starting rebuild of RAID10 leg {}", leg)
+        return;
+    }
+    auto const release_buf = std::unique_ptr< void, decltype(&free) >(buf.iov_base, &free);
+    // Writes that sampled the array while the leg was still failed skipped it and are not tracked
+    __drain_writes();
+    RLOGI("Rebuilding RAID10 leg {} [{}] from row {} of {}", leg, __dev(leg),
+          _rebuild_cursor.load(std::memory_order_acquire), _geo.rows)
+
+    for (auto row = _rebuild_cursor.load(std::memory_order_acquire); _geo.rows >= row;) {
+        if (_stopping.load(std::memory_order_acquire) || leg != _rebuild_leg.load(std::memory_order_acquire)) return;
+        auto const off = row * _geo.stripe_size;
+        auto src = raid10::copy_loc{};
+        if (_geo.mirror(leg, row, src)) {
+            auto const gen = _rebuild_writes->snapshot_gen();
+            if (_rebuild_writes->overlaps(off, _geo.stripe_size)) {
+                std::this_thread::sleep_for(k_rebuild_backoff);
+                continue;
+            }
+            if (!__usable(src.leg, src.off) || !__dev(src.leg).sync_iov(UBLK_IO_OP_READ, &buf, 1, src.off) ||
+                !__dev(leg).sync_iov(UBLK_IO_OP_WRITE, &buf, 1, off)) {
+                RLOGE("Rebuild of RAID10 leg {} stopped at row {}", leg, row)
+                __fail_leg(leg);
+                return;
+            }
+            // A write to the row raced the copy, which may have landed over it: copy it again
+            if (_rebuild_writes->overlaps(off, _geo.stripe_size) ||
+                _rebuild_writes->completed_since(off, _geo.stripe_size, gen))
+                continue;
+        }
+        _rebuild_cursor.store(++row, std::memory_order_release);
+        if (0 == row % k_checkpoint_rows) {
+            auto lk = std::scoped_lock(_sb_lock);
+            __persist_sb();
+        }
+    }
+    auto lk = std::scoped_lock(_sb_lock);
+    if (leg != _rebuild_leg.load(std::memory_order_acquire)) return;
+    _rebuild_leg.store(k_no_slot, std::memory_order_release);
+    ++_age;
+    __persist_sb();
+    RLOGI("Rebuild of RAID10 leg {} complete", leg)
+}
+
+// Background resync of the regions found dirty at assembly: copy the first copy of each stripe,
+// which reads are served from, over the second. As in __rebuild(), a stripe a write touches is
+// waited out and copied again if a write landed during the copy. A stripe with a copy out of the
+// array is skipped; the rebuild bringing that copy back copies it whole. A region whose copy
+// fails stays dirty for the next assembly.
+void Raid10Disk::__resync() {
+    if (!_resyncing.load(std::memory_order_acquire)) return;
+    auto buf = iovec{.iov_base = nullptr, .iov_len = _geo.stripe_size};
+    if (0 != ::posix_memalign(&buf.iov_base, 4096, _geo.stripe_size)) {
+        RLOGE("Out of memory starting resync of RAID10")
+        return;
+    }
+    auto const release_buf = std::unique_ptr< void, decltype(&free) >(buf.iov_base, &free);
+    auto const stripes = _geo.capacity() / _geo.stripe_size;
+    for (auto w = 0U; k_dirty_words > w; ++w) {
+        for (auto bits = _unsynced[w].load(std::memory_order_acquire); 0 != bits; bits &= bits - 1) {
+            auto const region = w * 64ULL + static_cast< uint64_t >(std::countr_zero(bits));
+            auto const end = std::min(stripes, (region + 1) * _region_stripes);
+            auto ok = true;
+            for (auto stripe = region * _region_stripes; end > stripe && ok;) {
+                if (_stopping.load(std::memory_order_acquire)) return;
+                auto const addr = stripe * _geo.stripe_size;
+                auto copies = std::array< raid10::copy_loc, 2 >();
+                _geo.map(addr, _geo.stripe_size, copies);
+                if (!__usable(copies[0].leg, copies[0].off) || !__usable(copies[1].leg, copies[1].off)) {
+                    ++stripe;
+                    continue;
+                }
+                auto const gen = _resync_writes->snapshot_gen();
+                if (_resync_writes->overlaps(addr, _geo.stripe_size)) {
+                    std::this_thread::sleep_for(k_rebuild_backoff);
+                    continue;
+                }
+                ok = __dev(copies[0].leg).sync_iov(UBLK_IO_OP_READ, &buf, 1, copies[0].off) &&
+                    __dev(copies[1].leg).sync_iov(UBLK_IO_OP_WRITE, &buf, 1, copies[1].off);
+                if (!ok) {
+                    RLOGE("Resync of RAID10 stripe {} failed; its region stays dirty", stripe)
+                    break;
+                }
+                // A write to the stripe raced the copy, which may have landed over it: copy it again
+                if (_resync_writes->overlaps(addr, _geo.stripe_size) ||
+                    _resync_writes->completed_since(addr, _geo.stripe_size, gen))
+                    continue;
+                ++stripe;
+            }
+            if (!ok) continue;
+            _unsynced[w].fetch_and(~(1ULL << (region % 64)), std::memory_order_release);
+            auto lk = std::scoped_lock(_sb_lock);
+            if (__clear_region(region)) __persist_sb();
+        }
+    }
+    _resyncing.store(false, std::memory_order_release);
+    RLOGI("Resync of RAID10 complete")
+}
+
+io_result Raid10Disk::sync_iov(uint8_t op, iovec* iovecs, uint32_t nr_vecs, off_t addr) noexcept {
+    // RAID-10 only supports not-scattered I/O currently!
+    if (1 > nr_vecs) return std::unexpected(std::make_error_condition(std::errc::invalid_argument));
+
+    std::array< Fragment, k_max_fragments > frags;
+    auto const cnt = __plan(frags, iovecs[0], addr);
+    if (0 == cnt && 0 < iovecs[0].iov_len) return std::unexpected(std::make_error_condition(std::errc::invalid_argument));
+
+    auto const is_read = (UBLK_IO_OP_READ == op);
+    auto dirty = std::optional< DirtyGuard >();
+    auto guard = std::optional< WriteGuard >();
+    if (!is_read) {
+        dirty.emplace(*this, addr, iovecs[0].iov_len);
+        __mark_dirty(dirty->first(), dirty->last());
+        guard.emplace(*this, frags, cnt);
+    }
+    size_t total = 0;
+    for (auto i = 0U; cnt > i; ++i) {
+        auto& frag = frags[i];
+        auto ok = false;
+        for (auto const& copy : frag.copies) {
+            if (is_read) {
+                if (!__usable(copy.leg, copy.off)) continue;
+                if (__dev(copy.leg).sync_iov(op, &frag.iov, 1, copy.off)) {
+                    ok = true;
+                    break;
+                }
+                RLOGW("Read of {:#0x}B at {:#0x} failed on RAID10 leg {}, trying its mirror", frag.iov.iov_len,
+                      copy.off, copy.leg)
+                continue;
+            }
+            // Writes also go to a leg being rebuilt, but only count once the rebuild has passed them
+            if (_failed.load(std::memory_order_acquire) & (1ULL << copy.leg)) continue;
+            auto res = __dev(copy.leg).sync_iov(op, &frag.iov, 1, copy.off);
+            for (auto n = 0U; k_write_retries > n && !res; ++n) {
+                RLOGW("Write of {:#0x}B at {:#0x} failed on RAID10 leg {}, reissuing it", frag.iov.iov_len, copy.off,
+                      copy.leg)
+                res = __dev(copy.leg).sync_iov(op, &frag.iov, 1, copy.off);
+            }
+            if (!res)
+                __fail_leg(copy.leg);
+            else if (__usable(copy.leg, copy.off))
+                ok = true;
+        }
+        if (!ok) return std::unexpected(std::make_error_condition(std::errc::io_error));
+        total += frag.iov.iov_len;
+    }
+    return total;
+}
+
+disk_task< int > Raid10Disk::async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs,
+                                       uint32_t nr_vecs, uint64_t addr) {
+    return __async_iov< ublk_disk >(q, data, iovecs, nr_vecs, addr);
+}
+
+template < typename Leg >
+disk_task< int > Raid10Disk::__async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs,
+                                         uint32_t nr_vecs, uint64_t addr) {
+    auto const op = ublksrv_get_op(data->iod);
+
+    if (op == UBLK_IO_OP_FLUSH) co_return 0;
+    if (1 > nr_vecs) co_return -EINVAL;
+
+    // frags lives in this frame until every child task is drained; the child iovecs point into it.
+    std::array< Fragment, k_max_fragments > frags;
+    auto const cnt = __plan(frags, iovecs[0], addr);
+    if (0 == cnt) co_return (0 == iovecs[0].iov_len) ? 0 : -EINVAL;
+
+    // Eagerly start every child so all SQEs are in flight before the first co_await. Slot 2i+c
+    // holds copy c of fragment i. All tasks must be drained even on error to avoid dangling
+    // _waiter handles in cqe_state.
+    auto const is_read = (UBLK_IO_OP_READ == op);
+    auto dirty = std::optional< DirtyGuard >();
+    auto guard = std::optional< WriteGuard >();
+    if (!is_read) {
+        dirty.emplace(*this, addr, iovecs[0].iov_len);
+        if (auto const r = co_await __await_dirty(q, data, dirty->first(), dirty->last()).start(); 0 > r) co_return r;
+        guard.emplace(*this, frags, cnt);
+    }
+    std::array< leg_io< Leg >, 2 * k_max_fragments > tasks;
+    auto const failed = _failed.load(std::memory_order_acquire);
+    for (auto i = 0U; cnt > i; ++i) {
+        auto& frag = frags[i];
+        for (auto c = 0U; 2 > c; ++c) {
+            auto const& copy = frag.copies[c];
+            // Writes also go to a leg being rebuilt; reads only where the rebuild has passed
+            if ((failed & (1ULL << copy.leg)) || (is_read && !__usable(copy.leg, copy.off))) continue;
+            tasks[2 * i + c].start(__dev(copy.leg), q, data, &frag.iov, 1, copy.off);
+            // Reads need only one copy
+            if (is_read) break;
+        }
+    }
+
+    int total = 0;
+    int err = 0;
+    for (auto i = 0U; cnt > i; ++i) {
+        auto& frag = frags[i];
+        auto ok = false;
+        for (auto c = 0U; 2 > c; ++c) {
+            if (!tasks[2 * i + c].started()) continue;
+            auto const& copy = frag.copies[c];
+            auto r = co_await tasks[2 * i + c].wait();
+            if (is_read) {
+                if (0 <= r) {
+                    ok = true;
+                    continue;
+                }
+                // Retry on the mirror; the pool was sized for one retry per fragment
+                auto const& alt = frag.copies[1 - c];
+                if (0 == c && __usable(alt.leg, alt.off)) {
+                    RLOGW("Read of {:#0x}B at {:#0x} failed on RAID10 leg {}, trying its mirror", frag.iov.iov_len,
+                          copy.off, copy.leg)
+                    auto retry = leg_io< Leg >();
+                    retry.start(__dev(alt.leg), q, data, &frag.iov, 1, alt.off);
+                    ok = (0 <= co_await retry.wait());
+                }
+                continue;
+            }
+            // A write error may be transient: reissue it before giving up on the leg
+            for (auto n = 0U; k_write_retries > n && 0 > r; ++n) {
+                RLOGW("Write of {:#0x}B at {:#0x} failed on RAID10 leg {}, reissuing it", frag.iov.iov_len, copy.off,
+                      copy.leg)
+                auto retry = leg_io< Leg >();
+                retry.start(__dev(copy.leg), q, data, &frag.iov, 1, copy.off);
+                r = co_await retry.wait();
+            }
+            if (0 > r)
+                __fail_leg(copy.leg);
+            else if (__usable(copy.leg, copy.off))
+                ok = true;
+        }
+        if (ok)
+            total += static_cast< int >(frag.iov.iov_len);
+        else if (!err)
+            err = -EIO;
+    }
+    co_return err ? err : total;
+}
+
+std::shared_ptr< ublk_disk > make_raid10_disk(boost::uuids::uuid const& uuid, uint32_t stripe_size_bytes,
+                                              std::vector< std::shared_ptr< ublk_disk > >&& disks,
+                                              raid10::layout lay) {
+    return std::make_shared< Raid10Disk >(uuid, stripe_size_bytes, std::move(disks), lay);
+}
+
+// A Raid10Disk whose legs are all of type `Leg`, so that leg I/O takes leg_io< Leg >; built by
+// stack::make_stack() for RAID10 over stack::fs. Missing legs are not possible here.
+template < typename Leg >
+class Raid10Stack final : public Raid10Disk {
+    bool __accepts(ublk_disk const& leg) const noexcept override { return nullptr != dynamic_cast< Leg const* >(&leg); }
+
+public:
+    using Raid10Disk::Raid10Disk;
+
+    disk_task< int > async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
+                               uint64_t addr) override {
+        return __async_iov< Leg >(q, data, iovecs, nr_vecs, addr);
+    }
+};
+
+namespace stack::detail {
+disk_handle make_raid10_over_fs(boost::uuids::uuid const& uuid, uint32_t stripe_size_bytes,
+                                std::vector< disk_handle >&& disks, ::ublkpp::raid10::layout lay) {
+    if (!all_legs_are< FSDisk >(disks))
+        throw std::invalid_argument("Raid10Disk: every leg of a stacked RAID10 over fs must come from make_fs_disk()");
+    return std::make_shared< Raid10Stack< FSDisk > >(uuid, stripe_size_bytes, std::move(disks), lay);
+}
+} // namespace stack::detail
+
+namespace raid10 {
+
+std::vector< std::string > failed_devices(ublk_disk const& disk) {
+    auto const* r10 = dynamic_cast< Raid10Disk const* >(&disk);
+    if (!r10) return {};
+    return r10->failed_devices();
+}
+
+bool replace_device(ublk_disk& disk, std::string const& old_device_id, disk_handle new_device) {
+    auto* r10 = dynamic_cast< Raid10Disk* >(&disk);
+    if (!r10) return false;
+    return r10->replace_device(old_device_id, std::move(new_device));
+}
+
+uint64_t rebuild_remaining(ublk_disk const& disk) noexcept {
+    auto const* r10 = dynamic_cast< Raid10Disk const* >(&disk);
+    if (!r10) return 0;
+    return r10->rebuild_remaining();
+}
+
+} // namespace raid10
+} // namespace ublkpp
@@ -0,0 +1,132 @@
+#pragma once
+
+extern "C" {
+#include <endian.h>
+}
+
+#include <algorithm>
+#include <array>
+
+#include "ublkpp/raid.hpp"
+#include "lib/common.hpp"
+
+namespace ublkpp::raid10 {
+
+constexpr auto k_page_size = 4 * Ki;
+// The failed-leg bitmask in the SuperBlock is 64 bits wide
+constexpr uint32_t k_max_width{64};
+constexpr uint16_t k_no_slot{UINT16_MAX};
+// Stripes are grouped into at most this many regions for the dirty bitmap in the SuperBlock
+constexpr uint32_t k_dirty_words{256};
+constexpr uint32_t k_dirty_regions{64 * k_dirty_words};
+
+// One copy of a stripe fragment: which leg holds it and at what byte offset. Offsets already
+// include the reserved first stripe of each leg.
+struct copy_loc {
+    uint32_t leg;
+    uint64_t off;
+};
+
+// Maps logical array offsets onto the two copies of each stripe.
+//
+//  NEAR: legs are paired (0,1), (2,3), ...; stripe s lives at the same offset on both legs of
+//        pair (s % pairs), so the array reads like RAID0 over N/2 mirrors.
+//  FAR:  each leg is split into a near half and a far half. Stripe s lives in the near half of
+//        leg (s % N) and in the far half of the next leg, so sequential reads from the near
+//        halves stripe across all N legs like RAID0 while any single leg can still be lost.
+struct Geometry {
+    layout lay{layout::NEAR};
+    uint32_t width{0};
+    uint32_t stripe_size{0};
+    uint64_t rows{0}; // Usable stripes per leg, not counting the superblock stripe
+
+    uint64_t capacity() const noexcept {
+        if (layout::FAR == lay) return (rows / 2) * width * stripe_size;
+        return rows * (width / 2) * stripe_size;
+    }
+
+    // Fill `copies` for the stripe holding `addr` and return how much of `len` it covers. The
+    // first copy is the preferred read source.
+    uint32_t map(uint64_t const addr, uint32_t const len, std::array< copy_loc, 2 >& copies) const noexcept {
+        auto const stripe = addr / stripe_size;
+        auto const chunk_off = addr % stripe_size;
+        auto const sz = static_cast< uint32_t >(std::min< uint64_t >(len, stripe_size - chunk_off));
+        if (layout::FAR == lay) {
+            auto const leg = static_cast< uint32_t >(stripe % width);
+            auto const row = stripe / width;
+            copies[0] = {leg, (1 + row) * stripe_size + chunk_off};
+            copies[1] = {(leg + 1) % width, (1 + rows / 2 + row) * stripe_size + chunk_off};
+        } else {
+            auto const pairs = width / 2;
+            auto const pair = static_cast< uint32_t >(stripe % pairs);
+            auto const row = stripe / pairs;
+            auto const off = (1 + row) * stripe_size + chunk_off;
+            // Alternate the preferred leg by row so reads spread over both halves of each pair
+            auto const first = static_cast< uint32_t >(row & 1);
+            copies[0] = {2 * pair + first, off};
+            copies[1] = {2 * pair + (1 - first), off};
+        }
+        return sz;
+    }
+
+    // The other copy of what `leg` holds at leg row `row` (offset row * stripe_size, counting the
+    // superblock stripe as row 0). False if that row holds no stripe.
+    bool mirror(uint32_t const leg, uint64_t const row, copy_loc& other) const noexcept {
+        if (1 > row || rows < row) return false;
+        if (layout::FAR == lay) {
+            auto const half = rows / 2;
+            if (half >= row)
+                other = {(leg + 1) % width, (row + half) * stripe_size};
+            else if (2 * half >= row)
+                other = {(leg + width - 1) % width, (row - half) * stripe_size};
+            else
+                return false;
+        } else
+            other = {leg ^ 1U, row * stripe_size};
+        return true;
+    }
+
+    // True if losing every leg in `failed` leaves some stripe with no surviving copy.
+    bool loses_data(uint64_t const failed) const noexcept {
+        for (auto leg = 0U; width > leg; ++leg) {
+            if (!(failed & (1ULL << leg))) continue;
+            auto const partner = (layout::FAR == lay) ? (leg + 1) % width : (leg ^ 1U);
+            if (failed & (1ULL << partner)) return true;
+        }
+        return false;
+    }
+};
+
+#ifdef __LITTLE_ENDIAN
+// One combined superblock per leg. Every leg carries the full array state; the copy with the
+// highest age is authoritative when the array is assembled.
+struct __attribute__((__packed__)) SuperBlock {
+    static constexpr size_t SIZE = k_page_size;
+    struct {
+        uint8_t magic[16]; // 128-bit magic to detect an initialized superblock
+        uint16_t version;
+        uint8_t uuid[16];
+    } header;
+    struct {
+        uint16_t slot;        // Position within the array
+        uint16_t width;       // Number of legs in the array
+        uint8_t layout;       // raid10::layout
+        uint32_t stripe_size; // Number of bytes before rotating devices
+        uint64_t age;         // Bumped each time the failed set changes
+        uint64_t failed;      // Bitmask of legs that no longer hold current data
+        uint16_t rebuild_slot; // Leg being rebuilt, or k_no_slot (since version 2)
+        uint64_t rebuild_row;  // Leg rows below this are already rebuilt (since version 2)
+        uint8_t clean;          // Shut down with both copies of every stripe alike (since version 3)
+        uint32_t dirty_stripes; // Stripes per bit of `dirty` (since version 3)
+        uint64_t dirty[k_dirty_words]; // Regions that may have writes on only one copy (since version 3)
+    } fields;
+    uint8_t _reserved[k_page_size - (sizeof(header) + sizeof(fields))];
+};
+static_assert(k_page_size == sizeof(SuperBlock), "Size of raid10::SuperBlock does not match SIZE!");
+#else
+#error "Big Endian not supported!"
+#endif
+
+constexpr uint16_t k_sb_version = 3;
+
+} // namespace ublkpp::raid10
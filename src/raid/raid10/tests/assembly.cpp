@@ -0,0 +1,82 @@
+#include "test_raid10_common.hpp"
+
+TEST(Raid10, RejectsBadGeometry) {
+    EXPECT_THROW(make_array(legs_of({make_leg("DiskA")})), std::invalid_argument);
+    EXPECT_THROW(make_array(legs_of({make_leg("DiskA"), make_leg("DiskB"), make_leg("DiskC")})),
+                 std::invalid_argument);
+    EXPECT_THROW(ublkpp::make_raid10_disk(boost::uuids::string_generator()(test_uuid), 96 * Ki,
+                                          legs_of({make_leg("DiskA"), make_leg("DiskB")})),
+                 std::invalid_argument);
+    // Three legs are fine with the far layout
+    EXPECT_NO_THROW(make_array(legs_of({make_leg("DiskA"), make_leg("DiskB"), make_leg("DiskC")}), layout::FAR));
+}
+
+TEST(Raid10, InitializesFreshArray) {
+    auto legs = std::vector< leg_ptr >{make_leg("DiskA"), make_leg("DiskB"), make_leg("DiskC"), make_leg("DiskD")};
+    auto raid = make_array({legs.begin(), legs.end()});
+    EXPECT_EQ("RAID10", raid->id());
+    // (Gi / stripe - 1) rows on each of two pairs, trimmed to a whole number of max-size I/Os
+    EXPECT_GE(2 * (Gi - k_stripe), raid->capacity());
+    EXPECT_LT(2 * (Gi - k_stripe) - raid->max_tx(), raid->capacity());
+    EXPECT_EQ(0U, raid->capacity() % raid->max_tx());
+    EXPECT_TRUE(ublkpp::raid10::failed_devices(*raid).empty());
+
+    for (auto slot = 0U; legs.size() > slot; ++slot) {
+        auto const sb = read_sb(*legs[slot]);
+        EXPECT_EQ(slot, be16toh(sb.fields.slot));
+        EXPECT_EQ(4U, be16toh(sb.fields.width));
+        EXPECT_EQ(k_stripe, be32toh(sb.fields.stripe_size));
+        EXPECT_EQ(0U, be64toh(sb.fields.failed));
+    }
+}
+
+TEST(Raid10, OnDiskGeometryWins) {
+    auto legs = std::vector< leg_ptr >{make_leg("DiskA"), make_leg("DiskB")};
+    auto const far = make_array({legs.begin(), legs.end()}, layout::FAR)->capacity();
+    // Re-assembled as NEAR with another stripe size, the array keeps its FAR geometry
+    auto raid = ublkpp::make_raid10_disk(boost::uuids::string_generator()(test_uuid), 128 * Ki,
+                                         {legs.begin(), legs.end()}, layout::NEAR);
+    EXPECT_EQ(far, raid->capacity());
+}
+
+TEST(Raid10, RefusesWrongSlot) {
+    auto legs = std::vector< leg_ptr >{make_leg("DiskA"), make_leg("DiskB")};
+    make_array({legs.begin(), legs.end()});
+    EXPECT_THROW(make_array(legs_of({legs[1], legs[0]})), std::runtime_error);
+}
+
+TEST(Raid10, MissingLegIsFailed) {
+    auto raid = make_array({make_leg("DiskA"), ublkpp::make_missing_disk(), make_leg("DiskC"), make_leg("DiskD")});
+    EXPECT_EQ(std::vector< std::string >{"~MISSING~"}, ublkpp::raid10::failed_devices(*raid));
+}
+
+TEST(Raid10, RefusesLostStripe) {
+    EXPECT_THROW(make_array({ublkpp::make_missing_disk(), ublkpp::make_missing_disk(), make_leg("DiskC"),
+                             make_leg("DiskD")}),
+                 std::runtime_error);
+    EXPECT_THROW(make_array({make_leg("DiskA"), ublkpp::make_missing_disk(), ublkpp::make_missing_disk()},
+                            layout::FAR),
+                 std::runtime_error);
+}
+
+// The failed set is persisted: a leg that missed a write stays out of the array after a restart,
+// as does a blank disk put in place of an existing leg.
+TEST(Raid10, ReassemblyHonorsFailedLegs) {
+    auto legs = std::vector< leg_ptr >{make_leg("DiskA"), make_leg("DiskB"), make_leg("DiskC"), make_leg("DiskD")};
+    {
+        auto raid = make_array({legs.begin(), legs.end()});
+        EXPECT_CALL(*legs[2], sync_iov(_, _, _, _)).Times(AnyNumber());
+        EXPECT_LEG_WRITE_FAILS(legs[2], k_stripe)
+        alignas(4096) static uint8_t buf[4 * Ki];
+        auto iov = iovec{.iov_base = buf, .iov_len = sizeof(buf)};
+        // Stripe 1 lives on the second pair
+        EXPECT_TRUE(raid->sync_iov(UBLK_IO_OP_WRITE, &iov, 1, k_stripe));
+        EXPECT_EQ(std::vector< std::string >{"DiskC"}, ublkpp::raid10::failed_devices(*raid));
+        EXPECT_EQ(0b0100U, be64toh(read_sb(*legs[0]).fields.failed));
+        EXPECT_EQ(1U, be64toh(read_sb(*legs[3]).fields.age));
+    }
+    auto raid = make_array({legs[0], make_leg("DiskE"), legs[2], legs[3]});
+    EXPECT_EQ((std::vector< std::string >{"DiskE", "DiskC"}), ublkpp::raid10::failed_devices(*raid));
+    // Replacing DiskD as well would leave stripes on the second pair with no copy
+    EXPECT_THROW(make_array({legs[0], legs[1], legs[2], make_leg("DiskF")}), std::runtime_error);
+}
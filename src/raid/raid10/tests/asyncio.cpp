@@ -0,0 +1,98 @@
+#include "test_raid10_common.hpp"
+
+#include "ublkpp/lib/cqe_state.hpp"
+#include "raid/tests/raid_test_common.hpp"
+#include "tests/mock_ublksrv/mock_ublksrv.hpp"
+
+using ::ublkpp::test::make_async_iov_action;
+
+namespace {
+struct AsyncRaid10Fixture : public ::testing::Test {
+    std::shared_ptr< ublkpp::AsyncTestDisk > disk_a, disk_b;
+    ublkpp::disk_handle raid;
+    std::unique_ptr< ublkpp::MockUblksrv > mock;
+
+    void SetUp() override {
+        using ::testing::StrictMock;
+
+        TestParams const p{.capacity = Gi};
+        disk_a = std::make_shared< StrictMock< ublkpp::AsyncTestDisk > >(p);
+        disk_b = std::make_shared< StrictMock< ublkpp::AsyncTestDisk > >(p);
+        for (auto& d : {disk_a, disk_b}) {
+            EXPECT_CALL(*d, prepare(_, _))
+                .Times(AnyNumber())
+                .WillRepeatedly(Return(ublkpp::ublk_disk::prepare_result{}));
+            EXPECT_CALL(*d, sync_iov(_, _, _, _))
+                .Times(AnyNumber())
+                .WillRepeatedly([](uint8_t op, iovec* iovecs, uint32_t, off_t) -> io_result {
+                    if (op == UBLK_IO_OP_READ && iovecs && iovecs->iov_base)
+                        memset(iovecs->iov_base, 0, iovecs->iov_len);
+                    return sizeof(ublkpp::raid10::SuperBlock);
+                });
+            EXPECT_CALL(*d, submit_iov(_, _, _, _, _)).Times(AnyNumber()).WillRepeatedly(make_async_iov_action());
+        }
+        raid = make_array({disk_a, disk_b});
+        // A write to a clean region parks until the marking thread has recorded it dirty; the tests
+        // count child I/O in flight right away, so a sync write marks the first group up front
+        alignas(4096) static uint8_t buf[4 * Ki];
+        auto iov = iovec{.iov_base = buf, .iov_len = sizeof(buf)};
+        ASSERT_TRUE(raid->sync_iov(UBLK_IO_OP_WRITE, &iov, 1, 0));
+        mock = std::make_unique< ublkpp::MockUblksrv >(raid);
+    }
+};
+} // namespace
+
+TEST_F(AsyncRaid10Fixture, WriteFansOutToBothCopies) {
+    EXPECT_CALL(*disk_a, submit_iov(_, _, _, _, k_stripe)).Times(1);
+    EXPECT_CALL(*disk_b, submit_iov(_, _, _, _, k_stripe)).Times(1);
+
+    auto res = mock->submit_io(0, UBLK_IO_OP_WRITE, 0, 4 * Ki / 512, nullptr);
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res.value(), 2u); // both copies dispatched before the first co_await
+
+    EXPECT_TRUE(mock->inject_cqe(0, 4 * Ki).empty());
+    auto completions = mock->inject_cqe(0, 4 * Ki);
+    ASSERT_EQ(completions.size(), 1u);
+    EXPECT_EQ(completions[0].result, static_cast< int >(4 * Ki));
+}
+
+TEST_F(AsyncRaid10Fixture, ReadRetriesMirror) {
+    EXPECT_CALL(*disk_a, submit_iov(_, _, _, _, k_stripe)).Times(1);
+    EXPECT_CALL(*disk_b, submit_iov(_, _, _, _, k_stripe)).Times(1);
+
+    auto res = mock->submit_io(0, UBLK_IO_OP_READ, 0, 4 * Ki / 512, nullptr);
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res.value(), 1u); // one copy only
+
+    EXPECT_TRUE(mock->inject_cqe(0, -EIO).empty()); // retry goes to disk_b
+    auto completions = mock->inject_cqe(0, 4 * Ki);
+    ASSERT_EQ(completions.size(), 1u);
+    EXPECT_EQ(completions[0].result, static_cast< int >(4 * Ki));
+    EXPECT_TRUE(ublkpp::raid10::failed_devices(*raid).empty());
+}
+
+TEST_F(AsyncRaid10Fixture, WriteRetrySavesLeg) {
+    EXPECT_CALL(*disk_a, submit_iov(_, _, _, _, k_stripe)).Times(2);
+    EXPECT_CALL(*disk_b, submit_iov(_, _, _, _, k_stripe)).Times(1);
+
+    auto res = mock->submit_io(0, UBLK_IO_OP_WRITE, 0, 4 * Ki / 512, nullptr);
+    ASSERT_TRUE(res);
+    EXPECT_TRUE(mock->inject_cqe(0, -EIO).empty());  // disk_a fails; the write is reissued to it
+    EXPECT_TRUE(mock->inject_cqe(0, 4 * Ki).empty()); // disk_b
+    auto completions = mock->inject_cqe(0, 4 * Ki);   // the reissue lands
+    ASSERT_EQ(completions.size(), 1u);
+    EXPECT_EQ(completions[0].result, static_cast< int >(4 * Ki));
+    EXPECT_TRUE(ublkpp::raid10::failed_devices(*raid).empty());
+}
+
+TEST_F(AsyncRaid10Fixture, WriteErrorDegradesLeg) {
+    auto res = mock->submit_io(0, UBLK_IO_OP_WRITE, 0, 4 * Ki / 512, nullptr);
+    ASSERT_TRUE(res);
+    EXPECT_TRUE(mock->inject_cqe(0, -EIO).empty());
+    EXPECT_TRUE(mock->inject_cqe(0, 4 * Ki).empty());
+    // The reissue fails as well
+    auto completions = mock->inject_cqe(0, -EIO);
+    ASSERT_EQ(completions.size(), 1u);
+    EXPECT_EQ(completions[0].result, static_cast< int >(4 * Ki));
+    EXPECT_EQ(std::vector< std::string >{"TestDisk"}, ublkpp::raid10::failed_devices(*raid));
+}
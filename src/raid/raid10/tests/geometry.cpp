@@ -0,0 +1,72 @@
+#include "test_raid10_common.hpp"
+
+using ublkpp::raid10::copy_loc;
+using ublkpp::raid10::Geometry;
+
+static void expect_copies(Geometry const& geo, uint64_t addr, copy_loc first, copy_loc second) {
+    auto copies = std::array< copy_loc, 2 >();
+    geo.map(addr, 4 * Ki, copies);
+    EXPECT_EQ(first.leg, copies[0].leg);
+    EXPECT_EQ(first.off, copies[0].off);
+    EXPECT_EQ(second.leg, copies[1].leg);
+    EXPECT_EQ(second.off, copies[1].off);
+}
+
+TEST(Raid10Geometry, NearMapping) {
+    auto const geo = Geometry{.lay = layout::NEAR, .width = 4, .stripe_size = k_stripe, .rows = 10};
+    EXPECT_EQ(20U * k_stripe, geo.capacity());
+    // Stripes rotate across pairs; the first stripe of each leg is the superblock
+    expect_copies(geo, 0, {0, k_stripe}, {1, k_stripe});
+    expect_copies(geo, k_stripe + 8 * Ki, {2, k_stripe + 8 * Ki}, {3, k_stripe + 8 * Ki});
+    // Odd rows prefer the second leg of the pair
+    expect_copies(geo, 2 * k_stripe, {1, 2 * k_stripe}, {0, 2 * k_stripe});
+}
+
+TEST(Raid10Geometry, FarMapping) {
+    auto const geo = Geometry{.lay = layout::FAR, .width = 3, .stripe_size = k_stripe, .rows = 11};
+    // Odd row counts lose the last row: 5 near + 5 far rows per leg
+    EXPECT_EQ(15U * k_stripe, geo.capacity());
+    expect_copies(geo, 0, {0, k_stripe}, {1, 6 * k_stripe});
+    expect_copies(geo, 2 * k_stripe, {2, k_stripe}, {0, 6 * k_stripe});
+    expect_copies(geo, 4 * k_stripe, {1, 2 * k_stripe}, {2, 7 * k_stripe});
+}
+
+TEST(Raid10Geometry, FragmentsStopAtStripeEnd) {
+    auto const geo = Geometry{.lay = layout::FAR, .width = 2, .stripe_size = k_stripe, .rows = 10};
+    auto copies = std::array< copy_loc, 2 >();
+    EXPECT_EQ(4 * Ki, geo.map(k_stripe - 4 * Ki, 16 * Ki, copies));
+    EXPECT_EQ(16 * Ki, geo.map(k_stripe, 16 * Ki, copies));
+}
+
+TEST(Raid10Geometry, LosesData) {
+    auto const near = Geometry{.lay = layout::NEAR, .width = 4, .stripe_size = k_stripe, .rows = 10};
+    EXPECT_FALSE(near.loses_data(0b0101));
+    EXPECT_TRUE(near.loses_data(0b0011));
+    EXPECT_TRUE(near.loses_data(0b1100));
+    // Far copies sit on the next leg, wrapping around
+    auto const far = Geometry{.lay = layout::FAR, .width = 4, .stripe_size = k_stripe, .rows = 10};
+    EXPECT_FALSE(far.loses_data(0b0101));
+    EXPECT_TRUE(far.loses_data(0b0110));
+    EXPECT_TRUE(far.loses_data(0b1001));
+}
+
+// mirror() names the other copy of every leg row that holds a stripe, as map() places them
+TEST(Raid10Geometry, MirrorMatchesMap) {
+    for (auto const lay : {layout::NEAR, layout::FAR}) {
+        auto const geo = Geometry{.lay = lay, .width = 4, .stripe_size = k_stripe, .rows = 11};
+        for (auto addr = uint64_t{0}; geo.capacity() > addr; addr += k_stripe) {
+            auto copies = std::array< copy_loc, 2 >();
+            geo.map(addr, 4 * Ki, copies);
+            for (auto c = 0U; 2 > c; ++c) {
+                auto other = copy_loc{};
+                ASSERT_TRUE(geo.mirror(copies[c].leg, copies[c].off / k_stripe, other));
+                EXPECT_EQ(copies[1 - c].leg, other.leg);
+                EXPECT_EQ(copies[1 - c].off, other.off);
+            }
+        }
+        auto other = copy_loc{};
+        // The superblock row, and the odd last row of a FAR leg, hold no stripe
+        EXPECT_FALSE(geo.mirror(0, 0, other));
+        EXPECT_EQ(layout::NEAR == lay, geo.mirror(0, 11, other));
+    }
+}
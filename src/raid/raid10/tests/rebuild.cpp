@@ -0,0 +1,185 @@
+#include "test_raid10_common.hpp"
+
+#include <chrono>
+#include <future>
+#include <thread>
+
+using ::testing::AllOf;
+using ::testing::Gt;
+using ::testing::Lt;
+
+namespace {
+// Legs of 63 rows after the superblock stripe; leg row r holds stripe r - 1, filled with r by make()
+constexpr uint64_t k_leg_rows{63};
+
+struct Raid10Rebuild : public ::testing::Test {
+    std::vector< leg_ptr > legs;
+    ublkpp::disk_handle raid;
+
+    void make() {
+        legs = {make_image_leg("DiskA"), make_image_leg("DiskB")};
+        assemble();
+        // Fill every row with a pattern of its own
+        alignas(4096) static uint8_t buf[k_stripe];
+        for (auto addr = uint64_t{0}; raid->capacity() > addr; addr += k_stripe) {
+            memset(buf, static_cast< int >(1 + addr / k_stripe), k_stripe);
+            auto iov = iovec{.iov_base = buf, .iov_len = k_stripe};
+            ASSERT_TRUE(raid->sync_iov(UBLK_IO_OP_WRITE, &iov, 1, addr));
+        }
+    }
+
+    // Superblock traffic and anything not explicitly expected
+    void expect_any() {
+        for (auto& leg : legs)
+            EXPECT_CALL(*leg, sync_iov(_, _, _, _)).Times(AnyNumber());
+    }
+
+    void assemble() {
+        expect_any();
+        raid = make_array({legs.begin(), legs.end()});
+    }
+
+    void wait_for_rebuild() {
+        while (0 < ublkpp::raid10::rebuild_remaining(*raid))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        // Joins the rebuild thread, which records the end of the rebuild last
+        raid.reset();
+    }
+
+    // The resync at assembly clears each region once its copies agree
+    void wait_for_resync() {
+        while (0 != read_sb(*legs[0]).fields.dirty[0])
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Both legs hold the same rows
+    void expect_mirrored() {
+        alignas(4096) static uint8_t a[k_stripe], b[k_stripe];
+        for (auto row = uint64_t{1}; k_leg_rows >= row; ++row) {
+            auto iov_a = iovec{.iov_base = a, .iov_len = k_stripe};
+            auto iov_b = iovec{.iov_base = b, .iov_len = k_stripe};
+            ASSERT_TRUE(legs[0]->sync_iov(UBLK_IO_OP_READ, &iov_a, 1, row * k_stripe));
+            ASSERT_TRUE(legs[1]->sync_iov(UBLK_IO_OP_READ, &iov_b, 1, row * k_stripe));
+            EXPECT_EQ(0, memcmp(a, b, k_stripe)) << "row " << row;
+        }
+    }
+};
+} // namespace
+
+TEST_F(Raid10Rebuild, ReplaceRebuildsFromMirror) {
+    make();
+    EXPECT_EQ(0U, ublkpp::raid10::rebuild_remaining(*raid));
+    // DiskB misses a write, which only DiskA then holds
+    EXPECT_LEG_WRITE_FAILS(legs[1], k_stripe)
+    alignas(4096) static uint8_t buf[4 * Ki];
+    memset(buf, 0xee, sizeof(buf));
+    auto iov = iovec{.iov_base = buf, .iov_len = sizeof(buf)};
+    ASSERT_TRUE(raid->sync_iov(UBLK_IO_OP_WRITE, &iov, 1, 0));
+    ASSERT_EQ(std::vector< std::string >{"DiskB"}, ublkpp::raid10::failed_devices(*raid));
+
+    // Only failed legs can be replaced, and only with something large enough
+    EXPECT_FALSE(ublkpp::raid10::replace_device(*raid, "DiskA", make_image_leg("DiskX")));
+    EXPECT_FALSE(ublkpp::raid10::replace_device(*raid, "DiskB", make_image_leg("DiskX", Mi)));
+
+    legs[1] = make_image_leg("DiskC");
+    EXPECT_CALL(*legs[1], sync_iov(_, _, _, _)).Times(AnyNumber());
+    ASSERT_TRUE(ublkpp::raid10::replace_device(*raid, "DiskB", legs[1]));
+    EXPECT_TRUE(ublkpp::raid10::failed_devices(*raid).empty());
+    wait_for_rebuild();
+    expect_mirrored();
+
+    auto const sb = read_sb(*legs[1]);
+    EXPECT_EQ(1U, be16toh(sb.fields.slot));
+    EXPECT_EQ(0U, be64toh(sb.fields.failed));
+    EXPECT_EQ(ublkpp::raid10::k_no_slot, be16toh(sb.fields.rebuild_slot));
+    EXPECT_EQ(be64toh(read_sb(*legs[0]).fields.age), be64toh(sb.fields.age));
+
+    // The rebuilt leg carries its share: the array assembles and reads from it
+    assemble();
+    EXPECT_TRUE(ublkpp::raid10::failed_devices(*raid).empty());
+}
+
+// A restart part way through a rebuild picks it up from the recorded row. Until the rebuild
+// passes a row, reads of it stay on the mirror.
+TEST_F(Raid10Rebuild, RebuildResumesFromCheckpoint) {
+    constexpr uint64_t k_cursor{32};
+    make();
+    raid.reset();
+    // As left by a crash: DiskB is rebuilt below k_cursor and blank above it
+    alignas(4096) static uint8_t zero[k_stripe];
+    for (auto row = k_cursor; k_leg_rows >= row; ++row) {
+        auto iov = iovec{.iov_base = zero, .iov_len = k_stripe};
+        ASSERT_TRUE(legs[1]->sync_iov(UBLK_IO_OP_WRITE, &iov, 1, row * k_stripe));
+    }
+    for (auto& leg : legs) {
+        auto sb = read_sb(*leg);
+        sb.fields.age = htobe64(be64toh(sb.fields.age) + 1);
+        sb.fields.rebuild_slot = htobe16(1);
+        sb.fields.rebuild_row = htobe64(k_cursor);
+        auto iov = iovec{.iov_base = &sb, .iov_len = sizeof(sb)};
+        ASSERT_TRUE(leg->sync_iov(UBLK_IO_OP_WRITE, &iov, 1, 0));
+    }
+
+    // Hold the rebuild at its first row; nothing below it is copied again
+    auto release = std::promise< void >();
+    auto held = release.get_future().share();
+    expect_any();
+    EXPECT_CALL(*legs[0], sync_iov(UBLK_IO_OP_READ, _, _, static_cast< off_t >(k_cursor * k_stripe)))
+        .WillOnce([held](uint8_t, iovec* iovecs, uint32_t, off_t) -> io_result {
+            held.wait();
+            memset(iovecs->iov_base, static_cast< int >(k_cursor), iovecs->iov_len);
+            return static_cast< int >(iovecs->iov_len);
+        });
+    EXPECT_CALL(*legs[1], sync_iov(UBLK_IO_OP_WRITE, _, _, AllOf(Gt(0), Lt(static_cast< off_t >(k_cursor * k_stripe)))))
+        .Times(0);
+    raid = make_array({legs.begin(), legs.end()});
+    EXPECT_EQ((k_leg_rows + 1 - k_cursor) * k_stripe, ublkpp::raid10::rebuild_remaining(*raid));
+    EXPECT_TRUE(ublkpp::raid10::failed_devices(*raid).empty());
+
+    // Odd stripes prefer DiskB: stripe 1 is read from it, stripe k_cursor + 1 past the cursor is not
+    alignas(4096) static uint8_t buf[4 * Ki];
+    auto iov = iovec{.iov_base = buf, .iov_len = sizeof(buf)};
+    EXPECT_CALL(*legs[1], sync_iov(UBLK_IO_OP_READ, _, _, Gt(0))).Times(1);
+    ASSERT_TRUE(raid->sync_iov(UBLK_IO_OP_READ, &iov, 1, k_stripe));
+    ASSERT_TRUE(raid->sync_iov(UBLK_IO_OP_READ, &iov, 1, (k_cursor + 1) * k_stripe));
+    EXPECT_EQ(static_cast< uint8_t >(k_cursor + 2), buf[0]);
+
+    EXPECT_CALL(*legs[1], sync_iov(UBLK_IO_OP_READ, _, _, _)).Times(AnyNumber());
+    release.set_value();
+    wait_for_rebuild();
+    expect_mirrored();
+    EXPECT_EQ(ublkpp::raid10::k_no_slot, be16toh(read_sb(*legs[1]).fields.rebuild_slot));
+}
+
+// A crash can leave a write on only one copy of a stripe. Its region was recorded dirty before the
+// write went out, so the next assembly copies the first copy of each stripe there over the second.
+TEST_F(Raid10Rebuild, CrashResyncsDirtyRegions) {
+    make();
+    raid.reset();
+    EXPECT_EQ(1U, read_sb(*legs[0]).fields.clean);
+    // As left by a crash: stripe 1 was rewritten only on DiskB, its first copy, and stripe 2 only on
+    // DiskA, its first copy. Each stripe has a region of its own here.
+    alignas(4096) static uint8_t buf[k_stripe];
+    memset(buf, 0xaa, sizeof(buf));
+    auto iov = iovec{.iov_base = buf, .iov_len = sizeof(buf)};
+    ASSERT_TRUE(legs[1]->sync_iov(UBLK_IO_OP_WRITE, &iov, 1, 2 * k_stripe));
+    ASSERT_TRUE(legs[0]->sync_iov(UBLK_IO_OP_WRITE, &iov, 1, 3 * k_stripe));
+    for (auto& leg : legs) {
+        auto sb = read_sb(*leg);
+        sb.fields.clean = 0;
+        sb.fields.dirty[0] = htobe64(0b110);
+        auto sb_iov = iovec{.iov_base = &sb, .iov_len = sizeof(sb)};
+        ASSERT_TRUE(leg->sync_iov(UBLK_IO_OP_WRITE, &sb_iov, 1, 0));
+    }
+
+    assemble();
+    wait_for_resync();
+    expect_mirrored();
+    EXPECT_TRUE(ublkpp::raid10::failed_devices(*raid).empty());
+    for (auto const addr : {k_stripe, 2 * k_stripe}) {
+        ASSERT_TRUE(raid->sync_iov(UBLK_IO_OP_READ, &iov, 1, addr));
+        EXPECT_EQ(0xaa, buf[0]) << addr;
+    }
+    raid.reset();
+    EXPECT_EQ(1U, read_sb(*legs[0]).fields.clean);
+}
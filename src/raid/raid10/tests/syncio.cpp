@@ -0,0 +1,102 @@
+#include "test_raid10_common.hpp"
+
+namespace {
+struct Raid10Sync : public ::testing::Test {
+    std::vector< leg_ptr > legs;
+    ublkpp::disk_handle raid;
+
+    void make(uint32_t width, layout lay) {
+        for (auto i = 0U; width > i; ++i)
+            legs.push_back(make_leg(fmt::format("Disk{}", static_cast< char >('A' + i))));
+        raid = make_array({legs.begin(), legs.end()}, lay);
+        // Superblock traffic and anything not explicitly expected below
+        for (auto& leg : legs)
+            EXPECT_CALL(*leg, sync_iov(_, _, _, _)).Times(AnyNumber());
+    }
+
+    io_result io(uint8_t op, uint64_t addr, uint32_t len) {
+        alignas(4096) static uint8_t buf[256 * Ki];
+        auto iov = iovec{.iov_base = buf, .iov_len = len};
+        return raid->sync_iov(op, &iov, 1, addr);
+    }
+};
+} // namespace
+
+TEST_F(Raid10Sync, NearReadSpreadsOverPair) {
+    make(4, layout::NEAR);
+    EXPECT_LEG_OP(UBLK_IO_OP_READ, legs[0], k_stripe, false)
+    EXPECT_LEG_OP(UBLK_IO_OP_READ, legs[2], k_stripe, false)
+    EXPECT_LEG_OP(UBLK_IO_OP_READ, legs[1], 2 * k_stripe, false)
+    // Three stripes: pair 0 row 0, pair 1 row 0, pair 0 row 1
+    auto res = io(UBLK_IO_OP_READ, 0, 2 * k_stripe + 4 * Ki);
+    ASSERT_TRUE(res);
+    EXPECT_EQ(2 * k_stripe + 4 * Ki, res.value());
+}
+
+TEST_F(Raid10Sync, NearWriteMirrors) {
+    make(4, layout::NEAR);
+    EXPECT_LEG_OP(UBLK_IO_OP_WRITE, legs[2], k_stripe + 4 * Ki, false)
+    EXPECT_LEG_OP(UBLK_IO_OP_WRITE, legs[3], k_stripe + 4 * Ki, false)
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, k_stripe + 4 * Ki, 8 * Ki));
+}
+
+// Sequential reads come from the near halves of every leg; writes also land in the far halves.
+TEST_F(Raid10Sync, FarLayout) {
+    make(2, layout::FAR);
+    auto const far = (1 + (Gi / k_stripe - 1) / 2) * k_stripe;
+    EXPECT_LEG_OP(UBLK_IO_OP_READ, legs[0], k_stripe, false)
+    EXPECT_LEG_OP(UBLK_IO_OP_READ, legs[1], k_stripe, false)
+    EXPECT_TRUE(io(UBLK_IO_OP_READ, 0, 2 * k_stripe));
+
+    EXPECT_LEG_OP(UBLK_IO_OP_WRITE, legs[0], k_stripe, false)
+    EXPECT_LEG_OP(UBLK_IO_OP_WRITE, legs[1], far, false)
+    EXPECT_LEG_OP(UBLK_IO_OP_WRITE, legs[1], k_stripe, false)
+    EXPECT_LEG_OP(UBLK_IO_OP_WRITE, legs[0], far, false)
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 0, 2 * k_stripe));
+}
+
+TEST_F(Raid10Sync, ReadFailsOverToMirror) {
+    make(2, layout::NEAR);
+    EXPECT_LEG_OP(UBLK_IO_OP_READ, legs[0], k_stripe, true)
+    EXPECT_LEG_OP(UBLK_IO_OP_READ, legs[1], k_stripe, false)
+    EXPECT_TRUE(io(UBLK_IO_OP_READ, 0, 4 * Ki));
+    // A read error alone does not fail the leg
+    EXPECT_TRUE(ublkpp::raid10::failed_devices(*raid).empty());
+}
+
+// A write that fails once is reissued; the leg stays in the array if that lands
+TEST_F(Raid10Sync, WriteRetrySavesLeg) {
+    make(2, layout::NEAR);
+    EXPECT_LEG_OP(UBLK_IO_OP_WRITE, legs[0], k_stripe, false)
+    EXPECT_CALL(*legs[1], sync_iov(UBLK_IO_OP_WRITE, _, _, k_stripe))
+        .WillOnce([](uint8_t, iovec*, uint32_t, off_t) -> io_result {
+            return std::unexpected(std::make_error_condition(std::errc::io_error));
+        })
+        .WillOnce([](uint8_t, iovec* iovecs, uint32_t, off_t) -> io_result {
+            return static_cast< int >(iovecs->iov_len);
+        });
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 0, 4 * Ki));
+    EXPECT_TRUE(ublkpp::raid10::failed_devices(*raid).empty());
+}
+
+TEST_F(Raid10Sync, WriteFailureDegradesLeg) {
+    make(2, layout::NEAR);
+    EXPECT_LEG_OP(UBLK_IO_OP_WRITE, legs[0], k_stripe, false)
+    EXPECT_LEG_WRITE_FAILS(legs[1], k_stripe)
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 0, 4 * Ki));
+    EXPECT_EQ(std::vector< std::string >{"DiskB"}, ublkpp::raid10::failed_devices(*raid));
+
+    // The failed leg gets no more I/O, even reads it would otherwise serve
+    EXPECT_CALL(*legs[1], sync_iov(_, _, _, _)).Times(0);
+    EXPECT_LEG_OP(UBLK_IO_OP_READ, legs[0], 2 * k_stripe, false)
+    EXPECT_TRUE(io(UBLK_IO_OP_READ, k_stripe, 4 * Ki));
+    EXPECT_LEG_OP(UBLK_IO_OP_WRITE, legs[0], 2 * k_stripe, false)
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, k_stripe, 4 * Ki));
+}
+
+TEST_F(Raid10Sync, WriteFailsWithoutSurvivingCopy) {
+    make(4, layout::NEAR);
+    EXPECT_LEG_WRITE_FAILS(legs[0], k_stripe)
+    EXPECT_LEG_WRITE_FAILS(legs[1], k_stripe)
+    EXPECT_FALSE(io(UBLK_IO_OP_WRITE, 0, 4 * Ki));
+}
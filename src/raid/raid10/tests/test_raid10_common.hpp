@@ -0,0 +1,80 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include <boost/uuid/string_generator.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <ublksrv.h>
+
+#include "ublkpp/raid.hpp"
+#include "raid/raid10/raid10_impl.hpp"
+#include "tests/test_disk.hpp"
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::ublkpp::Gi;
+using ::ublkpp::io_result;
+using ::ublkpp::Mi;
+using ::ublkpp::ublk_disk;
+using ::ublkpp::raid10::layout;
+
+static std::string const test_uuid("ada40737-30e3-49fe-9942-5a287d71eb3f");
+static constexpr uint32_t k_stripe = 64 * Ki;
+
+using leg_ptr = std::shared_ptr< NiceMock< ublkpp::TestDisk > >;
+
+inline leg_ptr make_leg(std::string const& id, uint64_t capacity = Gi) {
+    return make_sb_leg(id, capacity, ublkpp::raid10::k_page_size);
+}
+
+// Expect one data I/O of `op` on `leg` at `addr`, optionally failing it.
+#define EXPECT_LEG_OP(OP, leg, addr, fail)                                                                             \
+    EXPECT_CALL(*(leg), sync_iov(OP, _, _, addr))                                                                      \
+        .WillOnce([f = (fail)](uint8_t, iovec* iovecs, uint32_t, off_t) -> io_result {                                \
+            if (f) return std::unexpected(std::make_error_condition(std::errc::io_error));                             \
+            return static_cast< int >(iovecs->iov_len);                                                                \
+        });
+
+// Expect a write of `leg` at `addr` to fail, and fail the reissue too, so the leg is failed.
+#define EXPECT_LEG_WRITE_FAILS(leg, addr)                                                                              \
+    EXPECT_CALL(*(leg), sync_iov(UBLK_IO_OP_WRITE, _, _, addr))                                                        \
+        .Times(2)                                                                                                      \
+        .WillRepeatedly([](uint8_t, iovec*, uint32_t, off_t) -> io_result {                                           \
+            return std::unexpected(std::make_error_condition(std::errc::io_error));                                    \
+        });
+
+// A leg backed by an in-memory image of `capacity` bytes, superblock included.
+inline leg_ptr make_image_leg(std::string const& id, uint64_t capacity = 4 * Mi) {
+    auto leg = std::make_shared< NiceMock< ublkpp::TestDisk > >(TestParams{.capacity = capacity, .id = id});
+    auto image = std::make_shared< std::vector< uint8_t > >(capacity);
+    auto lock = std::make_shared< std::mutex >();
+    ON_CALL(*leg, sync_iov(_, _, _, _))
+        .WillByDefault([image, lock](uint8_t op, iovec* iovecs, uint32_t, off_t addr) -> io_result {
+            auto lk = std::scoped_lock(*lock);
+            if (UBLK_IO_OP_WRITE == op) memcpy(image->data() + addr, iovecs->iov_base, iovecs->iov_len);
+            if (UBLK_IO_OP_READ == op) memcpy(iovecs->iov_base, image->data() + addr, iovecs->iov_len);
+            return static_cast< int >(iovecs->iov_len);
+        });
+    return leg;
+}
+
+inline std::vector< ublkpp::disk_handle > legs_of(std::initializer_list< leg_ptr > legs) {
+    return std::vector< ublkpp::disk_handle >(legs.begin(), legs.end());
+}
+
+inline ublkpp::disk_handle make_array(std::vector< ublkpp::disk_handle >&& legs, layout lay = layout::NEAR) {
+    return ublkpp::make_raid10_disk(boost::uuids::string_generator()(test_uuid), k_stripe, std::move(legs), lay);
+}
+
+// Decoded superblock last written to `leg`
+inline ublkpp::raid10::SuperBlock read_sb(ublk_disk& leg) {
+    alignas(4096) static ublkpp::raid10::SuperBlock sb;
+    auto iov = iovec{.iov_base = &sb, .iov_len = sizeof(sb)};
+    EXPECT_TRUE(leg.sync_iov(UBLK_IO_OP_READ, &iov, 1, 0));
+    return sb;
+}
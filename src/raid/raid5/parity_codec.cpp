@@ -0,0 +1,86 @@
+#include "parity_codec.hpp"
+
+#include <array>
+#include <bit>
+#include <stdexcept>
+
+#include <isa-l/erasure_code.h>
+#include <isa-l/raid.h>
+
+#include "raid5_impl.hpp"
+
+namespace ublkpp::raid5 {
+
+ParityCodec::ParityCodec(uint32_t k, uint32_t m) : _k(k), _m(m), _matrix((k + m) * k, 0), _tables(k * m * 32) {
+    if (m < 1 || m > k_max_parity || k < 2 || k + m > k_max_width)
+        throw std::invalid_argument("ParityCodec: unsupported geometry");
+    for (auto i = 0U; k > i; ++i)
+        _matrix[i * k + i] = 1;
+    auto coef = uint8_t{1};
+    for (auto i = 0U; k > i; ++i) {
+        _matrix[k * k + i] = 1; // P
+        if (2 == m) _matrix[(k + 1) * k + i] = coef; // Q
+        coef = gf_mul(coef, 2);
+    }
+    ec_init_tables(static_cast< int >(k), static_cast< int >(m), &_matrix[k * k], _tables.data());
+}
+
+void ParityCodec::encode(uint32_t len, uint8_t* const* data, uint8_t* const* parity) const noexcept {
+    if (1 == _m) {
+        // xor_gen takes the sources followed by the destination
+        auto vects = std::array< void*, k_max_width + 1 >();
+        for (auto i = 0U; _k > i; ++i)
+            vects[i] = data[i];
+        vects[_k] = parity[0];
+        xor_gen(static_cast< int >(_k + 1), static_cast< int >(len), vects.data());
+        return;
+    }
+    ec_encode_data(static_cast< int >(len), static_cast< int >(_k), static_cast< int >(_m),
+                   const_cast< uint8_t* >(_tables.data()), const_cast< uint8_t** >(data),
+                   const_cast< uint8_t** >(parity));
+}
+
+bool ParityCodec::reconstruct(uint32_t len, uint8_t* const* blocks, uint64_t lost) const noexcept {
+    if (0 == lost) return true;
+    if (static_cast< uint32_t >(std::popcount(lost)) > _m) return false;
+    auto const data_lost = lost & ((1ULL << _k) - 1);
+    if (0 != data_lost) {
+        // One lost data block with P intact: XOR of everything else
+        if (1 == std::popcount(data_lost) && !(lost & (1ULL << _k))) {
+            auto vects = std::array< void*, k_max_width + 1 >();
+            auto n = 0;
+            for (auto i = 0U; _k + 1 > i; ++i)
+                if (!(lost & (1ULL << i))) vects[n++] = blocks[i];
+            vects[n++] = blocks[std::countr_zero(data_lost)];
+            xor_gen(n, static_cast< int >(len), vects.data());
+        } else {
+            // Invert the generator rows of k survivors, then apply the rows of the lost data
+            auto sub = std::array< uint8_t, k_max_width * k_max_width >();
+            auto inv = std::array< uint8_t, k_max_width * k_max_width >();
+            auto sources = std::array< uint8_t*, k_max_width >();
+            for (auto i = 0U, n = 0U; _k > n; ++i) {
+                if (lost & (1ULL << i)) continue;
+                std::copy_n(&_matrix[i * _k], _k, &sub[n * _k]);
+                sources[n++] = blocks[i];
+            }
+            if (0 != gf_invert_matrix(sub.data(), inv.data(), static_cast< int >(_k))) return false;
+            auto decode = std::array< uint8_t, k_max_parity * k_max_width >();
+            auto targets = std::array< uint8_t*, k_max_parity >();
+            auto rows = 0U;
+            for (auto d = 0U; _k > d; ++d) {
+                if (!(data_lost & (1ULL << d))) continue;
+                std::copy_n(&inv[d * _k], _k, &decode[rows * _k]);
+                targets[rows++] = blocks[d];
+            }
+            auto tables = std::array< uint8_t, k_max_parity * k_max_width * 32 >();
+            ec_init_tables(static_cast< int >(_k), static_cast< int >(rows), decode.data(), tables.data());
+            ec_encode_data(static_cast< int >(len), static_cast< int >(_k), static_cast< int >(rows), tables.data(),
+                           sources.data(), targets.data());
+        }
+    }
+    // Data is whole again; lost parity is simply regenerated
+    if (lost >> _k) encode(len, blocks, blocks + _k);
+    return true;
+}
+
+} // namespace ublkpp::raid5
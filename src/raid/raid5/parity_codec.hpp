@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace ublkpp::raid5 {
+
+// ISA-L backed P (+Q) parity over k data blocks.
+//
+// Blocks are indexed 0..k-1 for data, k for P and k+1 for Q. P is plain XOR (xor_gen); Q uses
+// the usual RAID6 coefficients (Q = sum of 2^i * D_i over GF(2^8)) and goes through
+// ec_encode_data, so both share one generator matrix and any m lost blocks can be rebuilt by
+// inverting the surviving rows.
+class ParityCodec {
+public:
+    // m is 1 (RAID5) or 2 (RAID6); k + m must not exceed k_max_width.
+    ParityCodec(uint32_t k, uint32_t m);
+
+    uint32_t data_count() const noexcept { return _k; }
+    uint32_t parity_count() const noexcept { return _m; }
+
+    // Compute the m parity blocks of `len` bytes from the k data blocks.
+    void encode(uint32_t len, uint8_t* const* data, uint8_t* const* parity) const noexcept;
+
+    // `blocks` holds k data then m parity pointers of `len` bytes each. Recompute every block whose
+    // bit is set in `lost` from the others. Returns false if more than m blocks are lost.
+    bool reconstruct(uint32_t len, uint8_t* const* blocks, uint64_t lost) const noexcept;
+
+private:
+    uint32_t const _k;
+    uint32_t const _m;
+    std::vector< uint8_t > _matrix; // (k + m) x k generator: identity, then the parity rows
+    std::vector< uint8_t > _tables; // ec_init_tables() expansion of the parity rows
+};
+
+} // namespace ublkpp::raid5
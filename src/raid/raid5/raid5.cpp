@@ -0,0 +1,1271 @@
+#include "ublkpp/raid.hpp"
+
+#include <bit>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <boost/uuid/uuid_io.hpp>
+#include <ublksrv.h>
+#include <ublksrv_utils.h>
+
+#include <ublkpp/lib/cqe_state.hpp>
+#include <ublkpp/lib/ublk_disk.hpp>
+
+#include "raid5_impl.hpp"
+#include "parity_codec.hpp"
+#include "stripe_cache.hpp"
+#include "raid/superblock.hpp"
+#include "lib/logging.hpp"
+
+namespace ublkpp {
+using raid5::k_dirty_regions;
+using raid5::k_dirty_words;
+using raid5::k_max_width;
+using raid5::k_no_slot;
+
+// A user I/O touches at most this many rows; max_tx is capped to (k_max_rows - 1) rows so an
+// unaligned I/O still fits.
+constexpr uint32_t k_max_rows{3};
+// Full-row images kept by the stripe cache
+constexpr uint32_t k_cache_rows{16};
+// How long an I/O parks on its ring before retrying a row lock held elsewhere
+constexpr long k_lock_backoff_ns{20'000};
+// Rebuild progress is persisted every this many rows
+constexpr uint64_t k_checkpoint_rows{256};
+// Once this many regions are dirty, marking more first clears those with no write in flight
+constexpr uint32_t k_dirty_high_water{256};
+// Regions are marked dirty this many at a time: a write to one records its neighbours too, so
+// writes moving through the array reach the superblocks once per group rather than per region
+constexpr uint32_t k_dirty_group{16};
+static_assert(0 == 64 % k_dirty_group, "a group must not straddle a word of the dirty bitmap");
+// How long a write parks on its ring between checks that its region has been marked
+constexpr long k_mark_backoff_ns{50'000};
+
+struct free_buf {
+    void operator()(uint8_t* p) const { free(p); }
+};
+using scratch_ptr = std::unique_ptr< uint8_t, free_buf >;
+
+static scratch_ptr alloc_scratch(size_t const sz) {
+    void* p{nullptr};
+    if (0 != ::posix_memalign(&p, 4096, sz)) return nullptr;
+    return scratch_ptr(static_cast< uint8_t* >(p));
+}
+
+static uint64_t all_blocks(uint32_t const width) { return (64 == width) ? ~0ULL : (1ULL << width) - 1; }
+
+struct ChildIo {
+    uint32_t leg;
+    uint64_t off;
+    iovec iov;
+};
+
+// The child I/Os of one phase of a row operation; at most one per leg. The iovecs must stay
+// alive until the I/Os complete: io_uring reads them at submit time.
+struct ChildBatch {
+    std::array< ChildIo, k_max_width > io;
+    uint32_t cnt{0};
+    void add(uint32_t const leg, uint64_t const off, uint8_t* buf, uint32_t const len) {
+        io[cnt++] = ChildIo{.leg = leg, .off = off, .iov = {.iov_base = buf, .iov_len = len}};
+    }
+};
+using batch_result = std::array< int, k_max_width >;
+
+// One row's share of a user I/O: which columns of each data block it covers and where those
+// bytes live in the user buffer. Writes also carry the parity work for the row.
+struct RowOp {
+    enum class mode : uint8_t { FULL, HIT, FILL, RCW };
+
+    uint64_t row{0};
+    uint32_t lo{UINT32_MAX}; // Column hull [lo, hi) of the blocks touched
+    uint32_t hi{0};
+    std::array< uint32_t, k_max_width > wlo{}; // Columns per data block; wlo == whi if untouched
+    std::array< uint32_t, k_max_width > whi{};
+    std::array< uint8_t*, k_max_width > src{}; // User bytes for [wlo, whi) of each data block
+
+    mode how{mode::RCW};
+    std::array< uint8_t*, k_max_width > blocks{}; // k data then m parity images of columns [lo, hi)
+    uint8_t* image{nullptr};                      // Stripe cache entry (HIT / FILL)
+    scratch_ptr scratch;
+    uint64_t skip{0}; // Legs whose reads failed during this operation
+    uint64_t lost{0}; // Blocks to reconstruct once the reads are in
+    ChildBatch batch;
+
+    bool touches(uint32_t const d) const noexcept { return whi[d] > wlo[d]; }
+    bool covers(uint32_t const d) const noexcept { return wlo[d] == lo && whi[d] == hi; }
+};
+
+struct row_guard {
+    raid5::RowLocks& locks;
+    uint64_t row;
+    ~row_guard() { locks.unlock(row); }
+};
+
+class ParityLeg {
+    struct destroy_sb {
+        void operator()(raid5::SuperBlock* p) const {
+            DEBUG_ASSERT_NOTNULL(p, "Freeing NULL ptr!") // LCOV_EXCL_LINE
+            free(p);
+        }
+    };
+
+public:
+    ParityLeg(std::shared_ptr< ublk_disk > device, raid5::SuperBlock* super) :
+            disk(std::move(device)), io(disk.get()), _sb(super, destroy_sb()) {}
+    std::shared_ptr< ublk_disk > disk;    // Guarded by _sb_lock
+    std::shared_ptr< ublk_disk > retired; // Previous disk of a replaced leg, kept for racing I/O
+    std::atomic< ublk_disk* > io;         // What the I/O path dereferences
+    std::unique_ptr< raid5::SuperBlock, destroy_sb > _sb; // nullptr for a missing leg
+};
+
+static const uint8_t magic_bytes[16] = {0316, 0057, 0241, 0012, 0133, 0370, 0226, 0105,
+                                        0321, 0064, 0177, 0250, 0013, 0346, 0132, 0271};
+using raid5::k_sb_version;
+
+// File-local concrete ublk_disk behind make_raid5_disk / make_raid6_disk.
+//
+// Rows are striped as in RAID0 with m rotating parity blocks. Every write locks the rows it
+// touches and takes one of four routes per row:
+//   FULL: the whole row is new; parity comes straight from the user buffer, nothing is read.
+//   HIT:  the stripe cache holds the row; overlay the new bytes and recompute from memory.
+//   FILL: a write starting a row (likely sequential); load the rest of the row into a cache
+//         entry so the writes that follow hit.
+//   RCW:  reconstruct-write; read the untouched parts of the column range, recompute parity.
+// Blocks on failed (or not yet rebuilt) legs are reconstructed from the others on the fly.
+class ParityDisk : public ublk_disk {
+    std::vector< std::unique_ptr< ParityLeg > > _legs;
+    raid5::Layout _layout;
+    std::unique_ptr< raid5::ParityCodec > _codec;
+    std::unique_ptr< raid5::StripeCache > _cache;
+    raid5::RowLocks _locks;
+    uint64_t _rows{0}; // Data rows per leg: 1.._rows, row 0 holds the superblock
+
+    std::atomic< uint64_t > _failed{0};
+    std::atomic< uint32_t > _rebuild_leg{k_no_slot};
+    std::atomic< uint64_t > _rebuild_cursor{0}; // Rows below this are rebuilt on _rebuild_leg
+    mutable std::mutex _sb_lock;                // Guards _age, leg replacement and superblock writes
+    uint64_t _age{0};
+    std::thread _rebuild_thread;
+    std::atomic< bool > _stopping{false};
+
+    // Write-hole tracking: rows are grouped into regions of _region_rows, and a region's bit is
+    // persisted in the superblock before any write to it goes out. A crash can leave data and
+    // parity of such rows out of step; their parity is recomputed (__resync) at assembly.
+    uint64_t _region_rows{1};
+    std::array< std::atomic< uint64_t >, k_dirty_words > _dirty{};    // Set under _sb_lock
+    std::array< std::atomic< uint64_t >, k_dirty_words > _unsynced{}; // Found dirty at assembly
+    std::unique_ptr< std::atomic< uint32_t >[] > _region_writes;     // Row writes in flight per region
+    // Regions writes are waiting on. The marking thread persists them in batches, off the queue
+    // threads; plain threads writing (sync I/O) persist them, and whatever else waits, themselves.
+    std::array< std::atomic< uint64_t >, k_dirty_words > _wanted{};
+    std::array< uint64_t, k_dirty_words > _marking{}; // Being persisted; guarded by _sb_lock
+    std::mutex _mark_lock;
+    std::condition_variable _mark_cv;
+    bool _mark_wanted{false}; // Guarded by _mark_lock
+    std::thread _mark_thread;
+
+    // Counts one row write in flight in its region, which __clear_region() leaves dirty meanwhile
+    class DirtyGuard {
+        ParityDisk& _raid;
+        uint64_t const _region;
+
+    public:
+        DirtyGuard(ParityDisk& raid, uint64_t const row) : _raid(raid), _region(raid.__region_of(row)) {
+            _raid._region_writes[_region].fetch_add(1, std::memory_order_seq_cst);
+        }
+        ~DirtyGuard() { _raid._region_writes[_region].fetch_sub(1, std::memory_order_release); }
+        DirtyGuard(DirtyGuard const&) = delete;
+        DirtyGuard& operator=(DirtyGuard const&) = delete;
+        uint64_t region() const noexcept { return _region; }
+    };
+
+    bool __usable(uint32_t const leg, uint64_t const row) const noexcept {
+        if (_failed.load(std::memory_order_acquire) & (1ULL << leg)) return false;
+        return _rebuild_leg.load(std::memory_order_acquire) != leg ||
+            row < _rebuild_cursor.load(std::memory_order_acquire);
+    }
+    uint64_t __unavailable(uint64_t row, uint64_t skip) const noexcept;
+    ublk_disk& __dev(uint32_t const leg) const noexcept { return *_legs[leg]->io.load(std::memory_order_acquire); }
+    uint64_t __dev_off(uint64_t const row, uint32_t const col) const noexcept {
+        return row * _layout.chunk_size + col;
+    }
+    void __queue_reads(RowOp& op, uint64_t mask) const noexcept;
+    uint32_t __split_rows(std::array< RowOp, k_max_rows >& rows, uint8_t* base, uint32_t len,
+                          uint64_t addr) const noexcept;
+
+    // Steps of a row write, shared by the async and sync paths
+    int __row_begin(RowOp& op);
+    int __row_plan_reads(RowOp& op);
+    bool __row_reads_done(RowOp& op, batch_result const& res) const noexcept;
+    void __row_compute(RowOp& op) const noexcept;
+    int __row_finish(RowOp& op, batch_result const& res);
+    void __row_abort(RowOp& op);
+    // Steps of a degraded row read
+    int __read_plan(RowOp& op, bool first);
+    int __read_finish(RowOp& op) const noexcept;
+
+    disk_task< int > __acquire_row(ublksrv_queue const* q, uint64_t row);
+    void __acquire_row_sync(uint64_t row) noexcept;
+    disk_task< int > __run_batch(ublksrv_queue const* q, ublk_io_data const* data, uint8_t op, ChildBatch& batch,
+                                 batch_result& res);
+    void __run_batch_sync(uint8_t op, ChildBatch& batch, batch_result& res) noexcept;
+    disk_task< int > __write_row(ublksrv_queue const* q, ublk_io_data const* data, RowOp& op);
+    int __write_row_sync(RowOp& op);
+    disk_task< int > __read_row(ublksrv_queue const* q, ublk_io_data const* data, RowOp& op);
+    int __read_row_sync(RowOp& op);
+
+    void __fail_leg(uint32_t leg);
+    void __persist_sb();
+    void __stamp_dirty(raid5::SuperBlock& sb) const noexcept;
+    void __rebuild();
+
+    uint64_t __region_of(uint64_t const row) const noexcept { return (row - 1) / _region_rows; }
+    bool __is_dirty(uint64_t const region) const noexcept {
+        return _dirty[region / 64].load(std::memory_order_seq_cst) & (1ULL << (region % 64));
+    }
+    void __want_marked(uint64_t region) noexcept;
+    disk_task< int > __await_dirty(ublksrv_queue const* q, uint64_t region);
+    void __mark_dirty(uint64_t region);
+    void __flush_marks();
+    void __persist_marks();
+    bool __clear_region(uint64_t region) noexcept;
+    bool __clear_idle() noexcept;
+    void __resync();
+
+public:
+    ParityDisk(boost::uuids::uuid const& uuid, uint32_t const chunk_size_bytes,
+               std::vector< std::shared_ptr< ublk_disk > >&& disks, uint32_t const parity);
+    ~ParityDisk() override;
+
+    std::vector< std::string > failed_devices() const;
+    bool replace_device(std::string const& old_device_id, std::shared_ptr< ublk_disk > new_device);
+    uint64_t rebuild_remaining() const noexcept;
+
+    std::string id() const noexcept override { return (1 == _layout.parity) ? "RAID5" : "RAID6"; }
+    prepare_result prepare(ublksrv_queue const*, int const iouring_device) override;
+
+    disk_task< int > async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
+                               uint64_t addr) override;
+
+    void probe_tick(ublksrv_queue const* q) noexcept override;
+
+    io_result sync_iov(uint8_t op, iovec* iovecs, uint32_t nr_vecs, off_t offset) noexcept override;
+};
+
+ParityDisk::ParityDisk(boost::uuids::uuid const& uuid, uint32_t const chunk_size_bytes,
+                       std::vector< std::shared_ptr< ublk_disk > >&& disks, uint32_t const parity) :
+        ublk_disk() {
+    auto const name = (1 == parity) ? "Raid5Disk" : "Raid6Disk";
+    if (chunk_size_bytes < raid5::k_page_size || (chunk_size_bytes & (chunk_size_bytes - 1)))
+        throw std::invalid_argument(
+            fmt::format("{}: chunk_size_bytes ({}) must be a power of 2 of at least 4KiB", name, chunk_size_bytes));
+    if (disks.size() < parity + 2 || disks.size() > k_max_width)
+        throw std::invalid_argument(
+            fmt::format("{}: {} disks given, need {} to {}", name, disks.size(), parity + 2, k_max_width));
+    _layout = raid5::Layout{.width = static_cast< uint32_t >(disks.size()),
+                            .parity = parity,
+                            .chunk_size = chunk_size_bytes};
+
+    // Discover overall Device parameters. Discard would leave parity stale, so it is not offered.
+    auto& our_params = *params();
+    our_params.types &= ~UBLK_PARAM_TYPE_DISCARD;
+    our_params.basic.dev_sectors = UINT64_MAX;
+    _direct_io = true;
+
+    // Read every leg's superblock; the initialized one with the highest age decides the chunk
+    // size, the failed legs and any rebuild in progress.
+    auto fresh = uint64_t{0};
+    auto failed = uint64_t{0};
+    auto found = std::optional< raid5::SuperBlock >();
+    for (auto&& device : disks) {
+        auto const slot = static_cast< uint16_t >(_legs.size());
+        auto const bit = 1ULL << slot;
+        if (device->is_missing()) {
+            RLOGW("{} leg {} is missing [uuid:{}]", name, slot, to_string(uuid))
+            failed |= bit;
+            _legs.emplace_back(std::make_unique< ParityLeg >(std::move(device), nullptr));
+            continue;
+        }
+        our_params.basic.dev_sectors =
+            std::min< uint64_t >(our_params.basic.dev_sectors, device->capacity() >> SECTOR_SHIFT);
+        our_params.basic.logical_bs_shift =
+            std::max(our_params.basic.logical_bs_shift, static_cast< uint8_t >(ilog2(device->block_size())));
+        our_params.basic.max_sectors =
+            std::min(our_params.basic.max_sectors, static_cast< uint32_t >(device->max_tx() >> SECTOR_SHIFT));
+        _direct_io = _direct_io ? device->direct_io() : false;
+
+        auto sb = read_superblock< raid5::SuperBlock >(*device);
+        if (!sb) throw std::runtime_error(fmt::format("Could not read superblock from {}!", *device));
+        _legs.emplace_back(std::make_unique< ParityLeg >(device, sb));
+
+        if (memcmp(sb->header.magic, magic_bytes, sizeof(magic_bytes))) {
+            memset(sb, 0x00, sizeof(raid5::SuperBlock));
+            memcpy(sb->header.magic, magic_bytes, sizeof(magic_bytes));
+            memcpy(sb->header.uuid, uuid.data, sizeof(sb->header.uuid));
+            sb->fields.slot = htobe16(slot);
+            fresh |= bit;
+            continue;
+        }
+        auto read_uuid = boost::uuids::uuid();
+        memcpy(read_uuid.data, sb->header.uuid, sizeof(sb->header.uuid));
+        if (uuid != read_uuid)
+            throw std::runtime_error(fmt::format("Superblock on {} did not have a matching UUID expected: {} read: {}",
+                                                 *device, to_string(uuid), to_string(read_uuid)));
+        if (auto const sb_ver = be16toh(sb->header.version); sb_ver > k_sb_version)
+            throw std::runtime_error(fmt::format("Superblock version {:#0x} on {} is newer than supported {:#0x}",
+                                                 sb_ver, *device, k_sb_version));
+        if (slot != be16toh(sb->fields.slot) || _layout.width != be16toh(sb->fields.width) ||
+            parity != sb->fields.parity)
+            throw std::runtime_error(
+                fmt::format("Superblock on {} does not match given array: Expected [slot:{}, width:{}, parity:{}] "
+                            "!= Found [slot:{}, width:{}, parity:{}]",
+                            *device, slot, _layout.width, parity, be16toh(sb->fields.slot),
+                            be16toh(sb->fields.width), static_cast< uint32_t >(sb->fields.parity)));
+        if (found && found->fields.chunk_size != sb->fields.chunk_size)
+            throw std::runtime_error(fmt::format("Superblock on {} has mismatched chunk size!", *device));
+        if (!found || be64toh(found->fields.age) < be64toh(sb->fields.age)) found = *sb;
+    }
+
+    auto rebuild = k_no_slot;
+    auto rebuild_row = uint64_t{1};
+    if (found) {
+        // The on-disk chunk size wins over the requested one, as with RAID0
+        if (auto const disk_chunk = be32toh(found->fields.chunk_size); disk_chunk != _layout.chunk_size) {
+            RLOGW("Superblock does not match given array parameters: Expected [chunk_sz:{:#0x}] != Found "
+                  "[chunk_sz:{:#0x}]",
+                  _layout.chunk_size, disk_chunk)
+            _layout.chunk_size = disk_chunk;
+        }
+        _age = be64toh(found->fields.age);
+        failed |= be64toh(found->fields.failed);
+        // A blank leg joining an existing array holds none of its data
+        if (fresh) RLOGW("{} legs {:#x} are blank in an existing array; marking them failed", name, fresh)
+        failed |= fresh;
+        if (auto const slot = be16toh(found->fields.rebuild_slot); k_no_slot != slot) {
+            // A rebuild onto a leg that has since failed or been swapped out is abandoned
+            if (!(failed & (1ULL << slot))) {
+                rebuild = slot;
+                rebuild_row = std::max< uint64_t >(1, be64toh(found->fields.rebuild_row));
+            }
+        }
+        if (failed != be64toh(found->fields.failed)) ++_age;
+    } else
+        RLOGI("Initializing {} [chunk_size:{}KiB, width:{}, uuid:{}]", id(), _layout.chunk_size / Ki, _layout.width,
+              to_string(uuid))
+    if (static_cast< uint32_t >(std::popcount(failed)) + (k_no_slot != rebuild ? 1 : 0) > parity)
+        throw std::runtime_error(
+            fmt::format("{}: legs {:#x} are unavailable, more than parity can cover; refusing to assemble", name,
+                        failed));
+    _failed.store(failed, std::memory_order_release);
+    _rebuild_cursor.store(rebuild_row, std::memory_order_release);
+    _rebuild_leg.store(rebuild, std::memory_order_release);
+
+    // Each leg gives up its first chunk for the superblock; only whole rows are usable.
+    auto const chunk_sectors = static_cast< uint64_t >(_layout.chunk_size >> SECTOR_SHIFT);
+    _rows = our_params.basic.dev_sectors / chunk_sectors;
+    if (_rows < 2)
+        throw std::runtime_error(fmt::format("{}: device capacity ({} sectors) is too small for chunk_size ({} sectors)",
+                                             name, our_params.basic.dev_sectors, chunk_sectors));
+    _rows -= 1;
+    our_params.basic.physical_bs_shift = ilog2(_layout.chunk_size);
+    our_params.basic.io_opt_shift = ilog2(_layout.row_width());
+    our_params.basic.dev_sectors = (_rows * _layout.row_width()) >> SECTOR_SHIFT;
+    if (our_params.basic.max_sectors == 0)
+        throw std::runtime_error(fmt::format("{}: max_sectors is zero; child device reported max_tx() == 0", name));
+    our_params.basic.max_sectors = static_cast< uint32_t >(
+        std::min< uint64_t >(static_cast< uint64_t >(our_params.basic.max_sectors) * _layout.data_count(),
+                             ((k_max_rows - 1) * _layout.row_width()) >> SECTOR_SHIFT));
+    // Align size to max_sector size
+    our_params.basic.dev_sectors -= (our_params.basic.dev_sectors % our_params.basic.max_sectors);
+
+    // Pick up the regions a crash left dirty. Every copy is merged: a leg that failed since only
+    // adds regions to check.
+    _region_rows = std::max< uint64_t >(1, (_rows + k_dirty_regions - 1) / k_dirty_regions);
+    _region_writes = std::make_unique< std::atomic< uint32_t >[] >(k_dirty_regions);
+    auto remap = false;
+    for (auto const& leg : _legs) {
+        auto const* sb = leg->_sb.get();
+        if (!sb) continue;
+        auto any = false;
+        for (auto w = 0U; k_dirty_words > w && !any; ++w)
+            any = (0 != sb->fields.dirty[w]);
+        if (!any) continue;
+        // A bitmap kept at another granularity cannot be mapped onto ours; check every row
+        if (be32toh(sb->fields.dirty_rows) != _region_rows) {
+            remap = true;
+            continue;
+        }
+        for (auto w = 0U; k_dirty_words > w; ++w)
+            _unsynced[w].fetch_or(be64toh(sb->fields.dirty[w]), std::memory_order_relaxed);
+    }
+    if (remap)
+        for (auto region = 0UL; __region_of(_rows) >= region; ++region)
+            _unsynced[region / 64].fetch_or(1ULL << (region % 64), std::memory_order_relaxed);
+    auto unsynced = 0U;
+    for (auto w = 0U; k_dirty_words > w; ++w) {
+        auto const bits = _unsynced[w].load(std::memory_order_relaxed);
+        _dirty[w].store(bits, std::memory_order_relaxed);
+        unsynced += static_cast< uint32_t >(std::popcount(bits));
+    }
+    if (0 < unsynced && (failed || k_no_slot != rebuild))
+        RLOGE("{} was not shut down cleanly while degraded: parity of {} regions may be stale and is resynced "
+              "only once the array is whole [uuid:{}]",
+              name, unsynced, to_string(uuid))
+    else if (0 < unsynced)
+        RLOGW("{} was not shut down cleanly: resyncing parity of {} regions [uuid:{}]", name, unsynced,
+              to_string(uuid))
+
+    _codec = std::make_unique< raid5::ParityCodec >(_layout.data_count(), parity);
+    _cache = std::make_unique< raid5::StripeCache >(k_cache_rows, _layout.row_width());
+
+    // Bring every reachable superblock up to the authoritative state
+    for (auto slot = 0U; _legs.size() > slot; ++slot) {
+        auto& leg = *_legs[slot];
+        auto* sb = leg._sb.get();
+        if (!sb) continue;
+        auto const stale = (fresh & (1ULL << slot)) || be64toh(sb->fields.age) != _age ||
+            be64toh(sb->fields.failed) != failed || be16toh(sb->fields.rebuild_slot) != rebuild ||
+            be16toh(sb->header.version) != k_sb_version || be32toh(sb->fields.dirty_rows) != _region_rows;
+        if (!stale) continue;
+        sb->header.version = htobe16(k_sb_version);
+        sb->fields.width = htobe16(static_cast< uint16_t >(_layout.width));
+        sb->fields.parity = static_cast< uint8_t >(parity);
+        sb->fields.chunk_size = htobe32(_layout.chunk_size);
+        sb->fields.age = htobe64(_age);
+        sb->fields.failed = htobe64(failed);
+        sb->fields.rebuild_slot = htobe16(rebuild);
+        sb->fields.rebuild_row = htobe64(rebuild_row);
+        __stamp_dirty(*sb);
+        if (!write_superblock(*leg.disk, sb) && !(failed & (1ULL << slot)))
+            throw std::runtime_error(fmt::format("Could not write superblock to {}!", *leg.disk));
+    }
+
+    if (k_no_slot != rebuild || 0 < unsynced) _rebuild_thread = std::thread([this] {
+        __rebuild();
+        __resync();
+    });
+    _mark_thread = std::thread([this] { __persist_marks(); });
+}
+
+ParityDisk::~ParityDisk() {
+    {
+        auto lk = std::scoped_lock(_mark_lock);
+        _stopping.store(true, std::memory_order_release);
+    }
+    _mark_cv.notify_all();
+    if (_mark_thread.joinable()) _mark_thread.join();
+    if (_rebuild_thread.joinable()) _rebuild_thread.join();
+    // Every write has completed: only regions still awaiting a resync stay dirty
+    auto lk = std::scoped_lock(_sb_lock);
+    if (__clear_idle()) __persist_sb();
+}
+
+std::vector< std::string > ParityDisk::failed_devices() const {
+    auto lk = std::scoped_lock(_sb_lock);
+    auto res = std::vector< std::string >();
+    auto const failed = _failed.load(std::memory_order_acquire);
+    for (auto slot = 0U; _legs.size() > slot; ++slot)
+        if (failed & (1ULL << slot)) res.push_back(_legs[slot]->disk->id());
+    return res;
+}
+
+uint64_t ParityDisk::rebuild_remaining() const noexcept {
+    if (k_no_slot == _rebuild_leg.load(std::memory_order_acquire)) return 0;
+    auto const cursor = _rebuild_cursor.load(std::memory_order_acquire);
+    return (_rows + 1 > cursor) ? (_rows + 1 - cursor) * _layout.chunk_size : 0;
+}
+
+ParityDisk::prepare_result ParityDisk::prepare(ublksrv_queue const* q, int const iouring_device_start) {
+    prepare_result result;
+    auto child_max = size_t{1};
+    for (auto& leg : _legs) {
+        auto child = leg->disk->prepare(q, iouring_device_start + static_cast< int >(result.fds.size()));
+        result.fds.insert(result.fds.end(), child.fds.begin(), child.fds.end());
+        child_max = std::max(child_max, child.max_sqes_per_io);
+        result.polled = result.polled || child.polled;
+    }
+    // Per row: up to m + 1 read passes (each retry skips a leg that failed the last one) and a
+    // write pass, each at most one I/O per leg. Degraded reads stay within the same bound.
+    result.max_sqes_per_io = k_max_rows * (_layout.parity + 2) * _layout.width * child_max;
+    return result;
+}
+
+void ParityDisk::probe_tick(ublksrv_queue const* q) noexcept {
+    // Skip a tick rather than wait out a leg replacement
+    auto lk = std::unique_lock(_sb_lock, std::try_to_lock);
+    if (!lk.owns_lock()) return;
+    for (auto const& leg : _legs) {
+        leg->disk->probe_tick(q);
+    }
+}
+
+uint64_t ParityDisk::__unavailable(uint64_t const row, uint64_t const skip) const noexcept {
+    auto lost = uint64_t{0};
+    for (auto i = 0U; _layout.width > i; ++i) {
+        auto const leg = _layout.leg_of(row, i);
+        if (!__usable(leg, row) || (skip & (1ULL << leg))) lost |= 1ULL << i;
+    }
+    return lost;
+}
+
+// Queue reads of columns [lo, hi) of every block in `mask` into op.blocks.
+void ParityDisk::__queue_reads(RowOp& op, uint64_t const mask) const noexcept {
+    op.batch.cnt = 0;
+    for (auto i = 0U; _layout.width > i; ++i)
+        if (mask & (1ULL << i))
+            op.batch.add(_layout.leg_of(op.row, i), __dev_off(op.row, op.lo), op.blocks[i], op.hi - op.lo);
+}
+
+// Split [addr, addr + len) into per-row pieces. Returns the row count, or 0 if it exceeds
+// k_max_rows.
+uint32_t ParityDisk::__split_rows(std::array< RowOp, k_max_rows >& rows, uint8_t* base, uint32_t const len,
+                                  uint64_t const addr) const noexcept {
+    auto nr = 0U;
+    for (auto off = 0U; len > off;) {
+        auto const [idx, row, col, sz] = _layout.map(addr + off, len - off);
+        if (0 == nr || rows[nr - 1].row != row) {
+            if (k_max_rows == nr) [[unlikely]]
+                return 0;
+            rows[nr++].row = row;
+        }
+        auto& op = rows[nr - 1];
+        op.wlo[idx] = col;
+        op.whi[idx] = col + sz;
+        op.src[idx] = base ? base + off : nullptr;
+        op.lo = std::min(op.lo, col);
+        op.hi = std::max(op.hi, col + sz);
+        off += sz;
+    }
+    return nr;
+}
+
+// Pick how to fold the write into the parity and point op.blocks at the column images.
+int ParityDisk::__row_begin(RowOp& op) {
+    auto const k = _layout.data_count();
+    auto const m = _layout.parity;
+    auto const chunk = _layout.chunk_size;
+
+    auto full = true;
+    for (auto d = 0U; k > d && full; ++d)
+        full = (0 == op.wlo[d] && chunk == op.whi[d]);
+    if (full) {
+        op.how = RowOp::mode::FULL;
+        _cache->invalidate(op.row);
+        for (auto d = 0U; k > d; ++d)
+            op.blocks[d] = op.src[d];
+    } else {
+        auto hit = false;
+        auto const starts_row = op.touches(0) && 0 == op.wlo[0];
+        if ((op.image = _cache->acquire(op.row, starts_row, hit))) {
+            op.how = hit ? RowOp::mode::HIT : RowOp::mode::FILL;
+            if (!hit) {
+                op.lo = 0;
+                op.hi = chunk;
+            }
+            for (auto d = 0U; k > d; ++d)
+                op.blocks[d] = op.image + d * chunk + op.lo;
+        }
+    }
+
+    // Parity images, plus room to read every data block for RCW
+    auto const len = op.hi - op.lo;
+    auto const rcw = (RowOp::mode::RCW == op.how);
+    op.scratch = alloc_scratch((rcw ? k + m : m) * len);
+    if (!op.scratch) [[unlikely]] {
+        __row_abort(op);
+        return -ENOMEM;
+    }
+    for (auto i = rcw ? 0 : k; k + m > i; ++i)
+        op.blocks[i] = op.scratch.get() + (rcw ? i : i - k) * len;
+    if (rcw)
+        for (auto d = 0U; k > d; ++d)
+            if (op.covers(d)) op.blocks[d] = op.src[d];
+    return 0;
+}
+
+// Queue the reads a write needs before it can compute parity: the untouched columns of the
+// data blocks, or everything still readable when some of those are unavailable.
+int ParityDisk::__row_plan_reads(RowOp& op) {
+    op.batch.cnt = 0;
+    op.lost = 0;
+    if (RowOp::mode::FULL == op.how || RowOp::mode::HIT == op.how) return 0;
+
+    auto const k = _layout.data_count();
+    auto need = uint64_t{0};
+    for (auto d = 0U; k > d; ++d)
+        if (!op.covers(d)) need |= 1ULL << d;
+    auto const unavailable = __unavailable(op.row, op.skip);
+    if (0 == (unavailable & need)) {
+        __queue_reads(op, need);
+        return 0;
+    }
+    if (static_cast< uint32_t >(std::popcount(unavailable)) > _layout.parity) return -EIO;
+    // Reconstruction needs the old contents of every block, so none may alias the user buffer
+    if (RowOp::mode::RCW == op.how)
+        for (auto d = 0U; k > d; ++d)
+            op.blocks[d] = op.scratch.get() + d * (op.hi - op.lo);
+    op.lost = unavailable;
+    __queue_reads(op, all_blocks(_layout.width) & ~unavailable);
+    return 0;
+}
+
+// Returns false if any read failed; those legs are skipped when the reads are planned again.
+bool ParityDisk::__row_reads_done(RowOp& op, batch_result const& res) const noexcept {
+    auto ok = true;
+    for (auto i = 0U; op.batch.cnt > i; ++i) {
+        if (0 <= res[i]) continue;
+        RLOGW("Read of row {} failed on {} leg {} [res:{}], reconstructing", op.row, id(), op.batch.io[i].leg, res[i])
+        op.skip |= 1ULL << op.batch.io[i].leg;
+        ok = false;
+    }
+    return ok;
+}
+
+// Rebuild missing blocks, overlay the new data, compute parity and queue the writes.
+void ParityDisk::__row_compute(RowOp& op) const noexcept {
+    auto const k = _layout.data_count();
+    auto const len = op.hi - op.lo;
+    if (op.lost) _codec->reconstruct(len, op.blocks.data(), op.lost);
+    for (auto d = 0U; k > d; ++d)
+        if (op.touches(d) && op.blocks[d] != op.src[d])
+            memcpy(op.blocks[d] + (op.wlo[d] - op.lo), op.src[d], op.whi[d] - op.wlo[d]);
+    _codec->encode(len, op.blocks.data(), op.blocks.data() + k);
+
+    // Blocks on unavailable legs are simply not written: their content lives in the parity
+    op.batch.cnt = 0;
+    for (auto d = 0U; k > d; ++d)
+        if (auto const leg = _layout.leg_of(op.row, d); op.touches(d) && __usable(leg, op.row))
+            op.batch.add(leg, __dev_off(op.row, op.wlo[d]), op.src[d], op.whi[d] - op.wlo[d]);
+    for (auto p = k; _layout.width > p; ++p)
+        if (auto const leg = _layout.leg_of(op.row, p); __usable(leg, op.row))
+            op.batch.add(leg, __dev_off(op.row, op.lo), op.blocks[p], len);
+}
+
+int ParityDisk::__row_finish(RowOp& op, batch_result const& res) {
+    for (auto i = 0U; op.batch.cnt > i; ++i)
+        if (0 > res[i]) __fail_leg(op.batch.io[i].leg);
+    auto const ok = static_cast< uint32_t >(std::popcount(__unavailable(op.row, 0))) <= _layout.parity;
+    if (op.image) _cache->release(op.row, ok);
+    return ok ? 0 : -EIO;
+}
+
+void ParityDisk::__row_abort(RowOp& op) {
+    if (op.image) _cache->release(op.row, false);
+    op.image = nullptr;
+}
+
+// Plan the reads for a row whose requested blocks cannot (all) be read directly: read the column
+// hull of every available block and reconstruct the rest.
+int ParityDisk::__read_plan(RowOp& op, bool const first) {
+    auto const len = op.hi - op.lo;
+    if (first) {
+        op.scratch = alloc_scratch(_layout.width * len);
+        if (!op.scratch) [[unlikely]]
+            return -ENOMEM;
+        for (auto i = 0U; _layout.width > i; ++i)
+            op.blocks[i] = op.scratch.get() + i * len;
+    }
+    auto const k = _layout.data_count();
+    auto need = uint64_t{0};
+    for (auto d = 0U; k > d; ++d)
+        if (op.touches(d)) need |= 1ULL << d;
+    auto const unavailable = __unavailable(op.row, op.skip);
+    if (static_cast< uint32_t >(std::popcount(unavailable)) > _layout.parity) return -EIO;
+    op.lost = (unavailable & need) ? unavailable : 0;
+    __queue_reads(op, op.lost ? all_blocks(_layout.width) & ~unavailable : need);
+    return 0;
+}
+
+int ParityDisk::__read_finish(RowOp& op) const noexcept {
+    if (op.lost) _codec->reconstruct(op.hi - op.lo, op.blocks.data(), op.lost);
+    auto total = 0U;
+    for (auto d = 0U; _layout.data_count() > d; ++d) {
+        if (!op.touches(d)) continue;
+        memcpy(op.src[d], op.blocks[d] + (op.wlo[d] - op.lo), op.whi[d] - op.wlo[d]);
+        total += op.whi[d] - op.wlo[d];
+    }
+    return static_cast< int >(total);
+}
+
+// Park this I/O on a ring timeout of `ns`, letting the queue get on with others meanwhile
+static disk_task< int > park(ublksrv_queue const* q, long const ns) {
+    auto* sqe = next_sqe(q);
+    while (!sqe && co_await sq_space(q))
+        sqe = next_sqe(q);
+    if (!sqe) [[unlikely]]
+        co_return -EBUSY;
+    // Stand-alone cqe_state: lives in this frame, not the I/O's pool
+    auto state = cqe_state{};
+    __kernel_timespec ts{.tv_sec = 0, .tv_nsec = ns};
+    io_uring_prep_timeout(sqe, &ts, 0, 0);
+    sqe->user_data = sisl::async::encode_managed_user_data(&state);
+    co_await state;
+    co_return 0;
+}
+
+// Take the row lock, parking this I/O on a short ring timeout while someone else holds it. The
+// holder may be another coroutine on this very queue, so spinning here could deadlock it.
+disk_task< int > ParityDisk::__acquire_row(ublksrv_queue const* q, uint64_t const row) {
+    while (!_locks.try_lock(row))
+        if (auto const r = co_await park(q, k_lock_backoff_ns).start(); 0 > r) co_return r;
+    co_return 0;
+}
+
+// Plain threads (sync callers, rebuild) never hold a row lock across a suspension, so yielding
+// until the holder finishes is safe here.
+void ParityDisk::__acquire_row_sync(uint64_t const row) noexcept {
+    while (!_locks.try_lock(row))
+        std::this_thread::yield();
+}
+
+// Issue the whole batch at once and wait for all of it; per-I/O results land in `res`.
+disk_task< int > ParityDisk::__run_batch(ublksrv_queue const* q, ublk_io_data const* data, uint8_t const op,
+                                         ChildBatch& batch, batch_result& res) {
+    // Children take the opcode from the request descriptor, so e.g. the reads of a user write go
+    // out under a copy of it that says READ. Tag and cqe_state pool stay those of the user I/O.
+    auto iod = *data->iod;
+    iod.op_flags = (iod.op_flags & ~0xffU) | op;
+    auto shadow = *data;
+    shadow.iod = &iod;
+
+    std::array< std::optional< hot_task< int > >, k_max_width > tasks;
+    for (auto i = 0U; batch.cnt > i; ++i) {
+        auto& child = batch.io[i];
+        tasks[i].emplace(__dev(child.leg).async_iov(q, &shadow, &child.iov, 1, child.off).start());
+    }
+    for (auto i = 0U; batch.cnt > i; ++i)
+        res[i] = co_await *tasks[i];
+    co_return 0;
+}
+
+void ParityDisk::__run_batch_sync(uint8_t const op, ChildBatch& batch, batch_result& res) noexcept {
+    for (auto i = 0U; batch.cnt > i; ++i) {
+        auto& child = batch.io[i];
+        auto r = __dev(child.leg).sync_iov(op, &child.iov, 1, static_cast< off_t >(child.off));
+        res[i] = r ? static_cast< int >(child.iov.iov_len) : -r.error().value();
+    }
+}
+
+disk_task< int > ParityDisk::__write_row(ublksrv_queue const* q, ublk_io_data const* data, RowOp& op) {
+    if (auto const r = co_await __acquire_row(q, op.row).start(); 0 > r) co_return r;
+    auto const unlock = row_guard{_locks, op.row};
+    auto const dirty = DirtyGuard(*this, op.row);
+    if (auto const r = co_await __await_dirty(q, dirty.region()).start(); 0 > r) co_return r;
+    if (auto const r = __row_begin(op); 0 > r) co_return r;
+    auto res = batch_result();
+    // Each failed pass skips at least one more leg, so __row_plan_reads ends the loop
+    do {
+        if (auto const r = __row_plan_reads(op); 0 > r) {
+            __row_abort(op);
+            co_return r;
+        }
+        co_await __run_batch(q, data, UBLK_IO_OP_READ, op.batch, res);
+    } while (!__row_reads_done(op, res));
+    __row_compute(op);
+    co_await __run_batch(q, data, UBLK_IO_OP_WRITE, op.batch, res);
+    co_return __row_finish(op, res);
+}
+
+int ParityDisk::__write_row_sync(RowOp& op) {
+    __acquire_row_sync(op.row);
+    auto const unlock = row_guard{_locks, op.row};
+    auto const dirty = DirtyGuard(*this, op.row);
+    __mark_dirty(dirty.region());
+    if (auto const r = __row_begin(op); 0 > r) return r;
+    auto res = batch_result();
+    do {
+        if (auto const r = __row_plan_reads(op); 0 > r) {
+            __row_abort(op);
+            return r;
+        }
+        __run_batch_sync(UBLK_IO_OP_READ, op.batch, res);
+    } while (!__row_reads_done(op, res));
+    __row_compute(op);
+    __run_batch_sync(UBLK_IO_OP_WRITE, op.batch, res);
+    return __row_finish(op, res);
+}
+
+disk_task< int > ParityDisk::__read_row(ublksrv_queue const* q, ublk_io_data const* data, RowOp& op) {
+    // Hold the row so a concurrent write cannot change data and parity under the reconstruction
+    if (auto const r = co_await __acquire_row(q, op.row).start(); 0 > r) co_return r;
+    auto const unlock = row_guard{_locks, op.row};
+    auto res = batch_result();
+    auto first = true;
+    do {
+        if (auto const r = __read_plan(op, std::exchange(first, false)); 0 > r) co_return r;
+        co_await __run_batch(q, data, UBLK_IO_OP_READ, op.batch, res);
+    } while (!__row_reads_done(op, res));
+    co_return __read_finish(op);
+}
+
+int ParityDisk::__read_row_sync(RowOp& op) {
+    __acquire_row_sync(op.row);
+    auto const unlock = row_guard{_locks, op.row};
+    auto res = batch_result();
+    auto first = true;
+    do {
+        if (auto const r = __read_plan(op, std::exchange(first, false)); 0 > r) return r;
+        __run_batch_sync(UBLK_IO_OP_READ, op.batch, res);
+    } while (!__row_reads_done(op, res));
+    return __read_finish(op);
+}
+
+io_result ParityDisk::sync_iov(uint8_t op, iovec* iovecs, uint32_t nr_vecs, off_t addr) noexcept {
+    // Parity RAID only supports not-scattered I/O currently!
+    if (1 > nr_vecs) return std::unexpected(std::make_error_condition(std::errc::invalid_argument));
+    if (UBLK_IO_OP_READ != op && UBLK_IO_OP_WRITE != op)
+        return std::unexpected(std::make_error_condition(std::errc::operation_not_supported));
+
+    // Skip the superblock row, do not use _addr_ beyond this.
+    auto const start = static_cast< uint64_t >(addr) + _layout.row_width();
+    auto* const base = static_cast< uint8_t* >(iovecs->iov_base);
+    auto const len = static_cast< uint32_t >(iovecs->iov_len);
+    // One row at a time
+    for (auto off = 0U; len > off;) {
+        auto const pos = start + off;
+        auto const sz = static_cast< uint32_t >(
+            std::min< uint64_t >(len - off, _layout.row_width() - (pos % _layout.row_width())));
+        auto rows = std::array< RowOp, k_max_rows >();
+        __split_rows(rows, base + off, sz, pos);
+        auto& row = rows[0];
+        auto res = 0;
+        if (UBLK_IO_OP_WRITE == op)
+            res = __write_row_sync(row);
+        else {
+            for (auto d = 0U; _layout.data_count() > d && 0 <= res; ++d) {
+                if (!row.touches(d)) continue;
+                auto const leg = _layout.leg_of(row.row, d);
+                if (!__usable(leg, row.row)) {
+                    res = -EAGAIN;
+                    break;
+                }
+                auto iov = iovec{.iov_base = row.src[d], .iov_len = row.whi[d] - row.wlo[d]};
+                if (!__dev(leg).sync_iov(op, &iov, 1, static_cast< off_t >(__dev_off(row.row, row.wlo[d])))) {
+                    row.skip |= 1ULL << leg;
+                    res = -EAGAIN;
+                }
+            }
+            if (-EAGAIN == res) res = __read_row_sync(row);
+        }
+        if (0 > res) return std::unexpected(std::make_error_condition(static_cast< std::errc >(-res)));
+        off += sz;
+    }
+    return len;
+}
+
+disk_task< int > ParityDisk::async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs,
+                                       uint32_t nr_vecs, uint64_t addr) {
+    auto const op = ublksrv_get_op(data->iod);
+
+    if (op == UBLK_IO_OP_FLUSH) co_return 0;
+    if (UBLK_IO_OP_READ != op && UBLK_IO_OP_WRITE != op) co_return -EOPNOTSUPP;
+    if (1 > nr_vecs) co_return -EINVAL;
+
+    // Skip the superblock row, do not use _addr_ beyond this.
+    addr += _layout.row_width();
+    auto const len = static_cast< uint32_t >(iovecs->iov_len);
+
+    // rows lives in this frame until every child task is drained; child iovecs point into it.
+    std::array< RowOp, k_max_rows > rows;
+    auto const nr = __split_rows(rows, static_cast< uint8_t* >(iovecs->iov_base), len, addr);
+    if (0 == nr) co_return (0 == len) ? 0 : -EINVAL;
+
+    // Eagerly start every child so all SQEs are in flight before the first co_await. All tasks
+    // must be drained even on error to avoid dangling _waiter handles in cqe_state.
+    int err = 0;
+    if (UBLK_IO_OP_WRITE == op) {
+        std::array< std::optional< hot_task< int > >, k_max_rows > tasks;
+        for (auto i = 0U; nr > i; ++i)
+            tasks[i].emplace(__write_row(q, data, rows[i]).start());
+        for (auto i = 0U; nr > i; ++i)
+            if (auto const r = co_await *tasks[i]; 0 > r && !err) err = r;
+        co_return err ? err : static_cast< int >(len);
+    }
+
+    // READ: straight from the data legs; rows with a block on an unavailable leg are
+    // reconstructed as a whole. Slot i * k_max_width + d holds the read of block d of row i.
+    std::array< std::optional< hot_task< int > >, k_max_rows * k_max_width > tasks;
+    std::array< bool, k_max_rows > degraded{};
+    auto const k = _layout.data_count();
+    for (auto i = 0U; nr > i; ++i) {
+        auto& row = rows[i];
+        for (auto d = 0U; k > d; ++d)
+            degraded[i] = degraded[i] || (row.touches(d) && !__usable(_layout.leg_of(row.row, d), row.row));
+        if (degraded[i]) {
+            tasks[i * k_max_width].emplace(__read_row(q, data, row).start());
+            continue;
+        }
+        for (auto d = 0U; k > d; ++d) {
+            if (!row.touches(d)) continue;
+            auto const leg = _layout.leg_of(row.row, d);
+            row.batch.add(leg, __dev_off(row.row, row.wlo[d]), row.src[d], row.whi[d] - row.wlo[d]);
+            auto& child = row.batch.io[row.batch.cnt - 1];
+            tasks[i * k_max_width + d].emplace(__dev(leg).async_iov(q, data, &child.iov, 1, child.off).start());
+        }
+    }
+    for (auto i = 0U; nr > i; ++i) {
+        auto& row = rows[i];
+        auto direct_failed = false;
+        for (auto d = 0U; k > d; ++d) {
+            auto& t = tasks[i * k_max_width + d];
+            if (!t) continue;
+            if (auto const r = co_await *t; 0 > r) {
+                if (degraded[i]) {
+                    if (!err) err = r;
+                    continue;
+                }
+                row.skip |= 1ULL << _layout.leg_of(row.row, d);
+                direct_failed = true;
+            }
+        }
+        if (direct_failed) {
+            RLOGW("Direct read of row {} failed on {}, reconstructing", row.row, id())
+            row.batch.cnt = 0;
+            if (auto const r = co_await __read_row(q, data, row).start(); 0 > r && !err) err = r;
+        }
+    }
+    co_return err ? err : static_cast< int >(len);
+}
+
+// Drop `leg` from the array and record it in every surviving superblock.
+void ParityDisk::__fail_leg(uint32_t const leg) {
+    auto lk = std::scoped_lock(_sb_lock);
+    auto const failed = _failed.load(std::memory_order_acquire);
+    if (failed & (1ULL << leg)) return;
+    RLOGE("{} leg {} [{}] failed; array is degraded", id(), leg, *_legs[leg]->disk)
+    _failed.store(failed | (1ULL << leg), std::memory_order_release);
+    if (leg == _rebuild_leg.load(std::memory_order_acquire)) _rebuild_leg.store(k_no_slot, std::memory_order_release);
+    ++_age;
+    __persist_sb();
+}
+
+// Write the current array state to every leg still in it, with the regions being marked already
+// recorded dirty. Caller holds _sb_lock.
+void ParityDisk::__persist_sb() {
+    auto const failed = _failed.load(std::memory_order_acquire);
+    auto const rebuild = static_cast< uint16_t >(_rebuild_leg.load(std::memory_order_acquire));
+    auto const cursor = _rebuild_cursor.load(std::memory_order_acquire);
+    for (auto slot = 0U; _legs.size() > slot; ++slot) {
+        auto& sb = _legs[slot]->_sb;
+        if (!sb || (failed & (1ULL << slot))) continue;
+        sb->fields.age = htobe64(_age);
+        sb->fields.failed = htobe64(failed);
+        sb->fields.rebuild_slot = htobe16(rebuild);
+        sb->fields.rebuild_row = htobe64(cursor);
+        __stamp_dirty(*sb);
+        if (!write_superblock(*_legs[slot]->disk, sb.get()))
+            RLOGE("Could not record array state on {}", *_legs[slot]->disk)
+    }
+}
+
+void ParityDisk::__stamp_dirty(raid5::SuperBlock& sb) const noexcept {
+    sb.fields.dirty_rows = htobe32(static_cast< uint32_t >(_region_rows));
+    for (auto w = 0U; k_dirty_words > w; ++w)
+        sb.fields.dirty[w] = htobe64(_dirty[w].load(std::memory_order_acquire) | _marking[w]);
+}
+
+// Ask for the group of `region` to be marked dirty
+void ParityDisk::__want_marked(uint64_t const region) noexcept {
+    auto const first = region - region % k_dirty_group;
+    auto const end = std::min< uint64_t >(first + k_dirty_group, __region_of(_rows) + 1);
+    auto bits = uint64_t{0};
+    for (auto r = first; end > r; ++r)
+        bits |= 1ULL << (r % 64);
+    _wanted[first / 64].fetch_or(bits, std::memory_order_release);
+}
+
+// Make sure every superblock records `region` dirty before a write to it goes out. The queue
+// thread does not write superblocks: it hands the region to the marking thread, which persists it
+// with whatever else is waiting, and parks the I/O on its ring until that is done.
+disk_task< int > ParityDisk::__await_dirty(ublksrv_queue const* q, uint64_t const region) {
+    if (__is_dirty(region)) co_return 0;
+    __want_marked(region);
+    {
+        auto lk = std::scoped_lock(_mark_lock);
+        _mark_wanted = true;
+    }
+    _mark_cv.notify_one();
+    while (!__is_dirty(region))
+        if (auto const r = co_await park(q, k_mark_backoff_ns).start(); 0 > r) co_return r;
+    co_return 0;
+}
+
+// As __await_dirty(), for plain threads, which may block: the region is persisted right here
+void ParityDisk::__mark_dirty(uint64_t const region) {
+    if (__is_dirty(region)) return;
+    __want_marked(region);
+    auto lk = std::scoped_lock(_sb_lock);
+    __flush_marks();
+}
+
+// Persist every region asked for in one superblock write per leg, then publish them: writes that
+// find their bit set go straight out. Caller holds _sb_lock.
+void ParityDisk::__flush_marks() {
+    auto any = false;
+    for (auto w = 0U; k_dirty_words > w; ++w) {
+        _marking[w] = _wanted[w].exchange(0, std::memory_order_acq_rel) & ~_dirty[w].load(std::memory_order_acquire);
+        any = any || (0 != _marking[w]);
+    }
+    if (!any) return;
+    // Keep the set small, so a crash leaves little to resync
+    auto dirty = 0U;
+    for (auto w = 0U; k_dirty_words > w; ++w)
+        dirty += static_cast< uint32_t >(std::popcount(_dirty[w].load(std::memory_order_acquire) | _marking[w]));
+    if (k_dirty_high_water <= dirty) __clear_idle();
+    __persist_sb();
+    for (auto w = 0U; k_dirty_words > w; ++w)
+        if (0 != _marking[w]) _dirty[w].fetch_or(std::exchange(_marking[w], 0), std::memory_order_seq_cst);
+}
+
+// Marking thread: persists the regions parked writes wait on, as many at once as have piled up
+void ParityDisk::__persist_marks() {
+    auto lk = std::unique_lock(_mark_lock);
+    while (!_stopping.load(std::memory_order_acquire)) {
+        if (!std::exchange(_mark_wanted, false)) {
+            _mark_cv.wait(lk);
+            continue;
+        }
+        lk.unlock();
+        {
+            auto sb_lk = std::scoped_lock(_sb_lock);
+            __flush_marks();
+        }
+        lk.lock();
+    }
+}
+
+// Clear a region's bit unless a write is in flight there or its parity still awaits __resync().
+// Pairs with __await_dirty(): a write that counted itself before the bit was cleared is seen here
+// and the bit restored; one that counts itself after finds the bit clear and marks it again.
+// Returns whether the bit was cleared. Caller holds _sb_lock.
+bool ParityDisk::__clear_region(uint64_t const region) noexcept {
+    auto const bit = 1ULL << (region % 64);
+    auto& word = _dirty[region / 64];
+    if (!(word.load(std::memory_order_acquire) & bit) || (_unsynced[region / 64].load(std::memory_order_acquire) & bit))
+        return false;
+    word.fetch_and(~bit, std::memory_order_seq_cst);
+    if (0 == _region_writes[region].load(std::memory_order_seq_cst)) return true;
+    word.fetch_or(bit, std::memory_order_seq_cst);
+    return false;
+}
+
+// Clear every dirty region with nothing in flight. Caller holds _sb_lock and persists the result.
+bool ParityDisk::__clear_idle() noexcept {
+    auto cleared = false;
+    for (auto w = 0U; k_dirty_words > w; ++w)
+        for (auto bits = _dirty[w].load(std::memory_order_acquire); 0 != bits; bits &= bits - 1)
+            cleared = __clear_region(w * 64ULL + static_cast< uint64_t >(std::countr_zero(bits))) || cleared;
+    return cleared;
+}
+
+// Swap a failed leg for `new_device` and rebuild it in the background.
+bool ParityDisk::replace_device(std::string const& old_device_id, std::shared_ptr< ublk_disk > new_device) {
+    if (!new_device || new_device->is_missing()) return false;
+    if (new_device->capacity() < (_rows + 1) * _layout.chunk_size || new_device->block_size() > block_size()) {
+        RLOGW("Refusing replacement {} for {}: too small or incompatible block size", *new_device, id())
+        return false;
+    }
+    {
+        auto lk = std::scoped_lock(_sb_lock);
+        auto slot = 0U;
+        while (_legs.size() > slot && _legs[slot]->disk->id() != old_device_id)
+            ++slot;
+        auto const failed = _failed.load(std::memory_order_acquire);
+        if (_legs.size() == slot || !(failed & (1ULL << slot)) ||
+            k_no_slot != _rebuild_leg.load(std::memory_order_acquire)) {
+            RLOGW("Refusing replacement of [{}] in {}: no such failed leg or a rebuild is running", old_device_id,
+                  id())
+            return false;
+        }
+        // Start the newcomer from a live leg's superblock
+        auto sb = static_cast< raid5::SuperBlock* >(nullptr);
+        for (auto const& leg : _legs)
+            if (leg->_sb && !(failed & (1ULL << (&leg - _legs.data())))) {
+                sb = read_superblock< raid5::SuperBlock >(*leg->disk);
+                break;
+            }
+        if (!sb) return false;
+        sb->fields.slot = htobe16(static_cast< uint16_t >(slot));
+
+        auto& leg = *_legs[slot];
+        leg.retired = std::exchange(leg.disk, new_device);
+        leg._sb.reset(sb);
+        leg.io.store(new_device.get(), std::memory_order_release);
+        // Publish the rebuild before the leg stops counting as failed: rows past the cursor
+        // stay unavailable until rebuilt.
+        _rebuild_cursor.store(1, std::memory_order_release);
+        _rebuild_leg.store(slot, std::memory_order_release);
+        _failed.store(failed & ~(1ULL << slot), std::memory_order_release);
+        ++_age;
+        __persist_sb();
+        RLOGI("Replaced {} leg {} [{}] with {}; rebuilding", id(), slot, old_device_id, *new_device)
+    }
+    if (_rebuild_thread.joinable()) _rebuild_thread.join();
+    _rebuild_thread = std::thread([this] {
+        __rebuild();
+        __resync();
+    });
+    return true;
+}
+
+// Background rebuild: reconstruct the replaced leg row by row under the row lock, so user writes
+// and the rebuild never interleave within a row.
+void ParityDisk::__rebuild() {
+    auto const leg = _rebuild_leg.load(std::memory_order_acquire);
+    if (k_no_slot == leg) return;
+    auto const chunk = _layout.chunk_size;
+    auto op = RowOp();
+    op.lo = 0;
+    op.hi = chunk;
+    op.scratch = alloc_scratch(_layout.width * chunk);
+    if (!op.scratch) {
+        RLOGE("Out of memory starting rebuild of {} leg {}", id(), leg)
+        return;
+    }
+    for (auto i = 0U; _layout.width > i; ++i)
+        op.blocks[i] = op.scratch.get() + i * chunk;
+    RLOGI("Rebuilding {} leg {} [{}] from row {} of {}", id(), leg, __dev(leg),
+          _rebuild_cursor.load(std::memory_order_acquire), _rows)
+
+    auto res = batch_result();
+    for (auto row = _rebuild_cursor.load(std::memory_order_acquire); _rows >= row; ++row) {
+        if (_stopping.load(std::memory_order_acquire) || leg != _rebuild_leg.load(std::memory_order_acquire)) return;
+        __acquire_row_sync(row);
+        auto const unlock = row_guard{_locks, row};
+        op.row = row;
+        op.skip = 0;
+        auto const idx = _layout.index_of(row, leg);
+        auto ok = false;
+        while (true) {
+            op.lost = __unavailable(row, op.skip);
+            if (static_cast< uint32_t >(std::popcount(op.lost)) > _layout.parity) break;
+            __queue_reads(op, all_blocks(_layout.width) & ~op.lost);
+            __run_batch_sync(UBLK_IO_OP_READ, op.batch, res);
+            if (!__row_reads_done(op, res)) continue;
+            _codec->reconstruct(chunk, op.blocks.data(), op.lost);
+            op.batch.cnt = 0;
+            op.batch.add(leg, __dev_off(row, 0), op.blocks[idx], chunk);
+            __run_batch_sync(UBLK_IO_OP_WRITE, op.batch, res);
+            ok = (0 <= res[0]);
+            break;
+        }
+        if (!ok) {
+            RLOGE("Rebuild of {} leg {} stopped at row {}", id(), leg, row)
+            if (!(op.skip & (1ULL << leg))) __fail_leg(leg);
+            return;
+        }
+        _rebuild_cursor.store(row + 1, std::memory_order_release);
+        if (0 == row % k_checkpoint_rows) {
+            auto lk = std::scoped_lock(_sb_lock);
+            __persist_sb();
+        }
+    }
+    auto lk = std::scoped_lock(_sb_lock);
+    if (leg != _rebuild_leg.load(std::memory_order_acquire)) return;
+    _rebuild_leg.store(k_no_slot, std::memory_order_release);
+    ++_age;
+    __persist_sb();
+    RLOGI("Rebuild of {} leg {} complete", id(), leg)
+}
+
+// Recompute the parity of every row in the regions found dirty at assembly, under the row lock.
+// Runs after any rebuild and stops while the array is degraded: the data cannot be checked
+// against parity then, and the regions stay dirty for the next assembly.
+void ParityDisk::__resync() {
+    auto const whole = [this] {
+        return 0 == _failed.load(std::memory_order_acquire) &&
+            k_no_slot == _rebuild_leg.load(std::memory_order_acquire);
+    };
+    auto const k = _layout.data_count();
+    auto const chunk = _layout.chunk_size;
+    auto op = RowOp();
+    op.lo = 0;
+    op.hi = chunk;
+    auto res = batch_result();
+    for (auto region = 0UL; __region_of(_rows) >= region; ++region) {
+        auto const bit = 1ULL << (region % 64);
+        if (!(_unsynced[region / 64].load(std::memory_order_acquire) & bit)) continue;
+        if (!op.scratch) {
+            if (!whole()) return;
+            op.scratch = alloc_scratch(_layout.width * chunk);
+            if (!op.scratch) {
+                RLOGE("Out of memory starting parity resync of {}", id())
+                return;
+            }
+            for (auto i = 0U; _layout.width > i; ++i)
+                op.blocks[i] = op.scratch.get() + i * chunk;
+            RLOGI("Resyncing parity of {} from region {}", id(), region)
+        }
+        auto const last = std::min(_rows, (region + 1) * _region_rows);
+        for (auto row = region * _region_rows + 1; last >= row; ++row) {
+            if (_stopping.load(std::memory_order_acquire)) return;
+            if (!whole()) {
+                RLOGW("{} is degraded; parity resync stopped at row {}", id(), row)
+                return;
+            }
+            __acquire_row_sync(row);
+            auto const unlock = row_guard{_locks, row};
+            op.row = row;
+            op.skip = 0;
+            __queue_reads(op, all_blocks(k));
+            __run_batch_sync(UBLK_IO_OP_READ, op.batch, res);
+            if (!__row_reads_done(op, res)) {
+                RLOGE("Parity resync of {} stopped at row {}", id(), row)
+                return;
+            }
+            _codec->encode(chunk, op.blocks.data(), op.blocks.data() + k);
+            op.batch.cnt = 0;
+            for (auto p = k; _layout.width > p; ++p)
+                op.batch.add(_layout.leg_of(row, p), __dev_off(row, 0), op.blocks[p], chunk);
+            __run_batch_sync(UBLK_IO_OP_WRITE, op.batch, res);
+            for (auto i = 0U; op.batch.cnt > i; ++i)
+                if (0 > res[i]) __fail_leg(op.batch.io[i].leg);
+        }
+        auto lk = std::scoped_lock(_sb_lock);
+        if (!whole()) continue;
+        _unsynced[region / 64].fetch_and(~bit, std::memory_order_release);
+        if (__clear_region(region)) __persist_sb();
+    }
+    if (op.scratch) RLOGI("Parity resync of {} complete", id())
+}
+
+static std::shared_ptr< ublk_disk > make_parity_disk(boost::uuids::uuid const& uuid, uint32_t chunk_size_bytes,
+                                                     std::vector< std::shared_ptr< ublk_disk > >&& disks,
+                                                     uint32_t parity) {
+    return std::make_shared< ParityDisk >(uuid, chunk_size_bytes, std::move(disks), parity);
+}
+
+std::shared_ptr< ublk_disk > make_raid5_disk(boost::uuids::uuid const& uuid, uint32_t chunk_size_bytes,
+                                             std::vector< std::shared_ptr< ublk_disk > >&& disks) {
+    return make_parity_disk(uuid, chunk_size_bytes, std::move(disks), 1);
+}
+
+std::shared_ptr< ublk_disk > make_raid6_disk(boost::uuids::uuid const& uuid, uint32_t chunk_size_bytes,
+                                             std::vector< std::shared_ptr< ublk_disk > >&& disks) {
+    return make_parity_disk(uuid, chunk_size_bytes, std::move(disks), 2);
+}
+
+namespace raid5 {
+
+std::vector< std::string > failed_devices(ublk_disk const& disk) {
+    auto const* pd = dynamic_cast< ParityDisk const* >(&disk);
+    if (!pd) return {};
+    return pd->failed_devices();
+}
+
+bool replace_device(ublk_disk& disk, std::string const& old_device_id, disk_handle new_device) {
+    auto* pd = dynamic_cast< ParityDisk* >(&disk);
+    if (!pd) return false;
+    return pd->replace_device(old_device_id, std::move(new_device));
+}
+
+uint64_t rebuild_remaining(ublk_disk const& disk) noexcept {
+    auto const* pd = dynamic_cast< ParityDisk const* >(&disk);
+    if (!pd) return 0;
+    return pd->rebuild_remaining();
+}
+
+} // namespace raid5
+} // namespace ublkpp
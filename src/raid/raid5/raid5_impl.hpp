@@ -0,0 +1,109 @@
+#pragma once
+
+extern "C" {
+#include <endian.h>
+}
+
+#include <array>
+#include <atomic>
+
+#include "raid/raid0/raid0_impl.hpp"
+#include "lib/common.hpp"
+
+namespace ublkpp::raid5 {
+
+constexpr auto k_page_size = 4 * Ki;
+// The failed-leg bitmask in the SuperBlock is 64 bits wide
+constexpr uint32_t k_max_width{64};
+constexpr uint32_t k_max_parity{2};
+constexpr uint16_t k_no_slot{UINT16_MAX};
+// Rows are grouped into at most this many regions for the dirty bitmap in the SuperBlock
+constexpr uint32_t k_dirty_words{256};
+constexpr uint32_t k_dirty_regions{64 * k_dirty_words};
+
+// Maps logical offsets onto legs. Rows are striped exactly like a RAID0 over the k = width - m
+// data blocks (raid0::next_subcmd() does the split), then the parity blocks are rotated
+// left-symmetrically as md does by default: P walks backwards one leg per row, Q follows it and
+// the data blocks continue after the parity.
+//
+// Row 0 of every leg holds the superblock; `addr` passed to map() must already include it.
+struct Layout {
+    uint32_t width{0};
+    uint32_t parity{1};
+    uint32_t chunk_size{0};
+
+    uint32_t data_count() const noexcept { return width - parity; }
+    uint64_t row_width() const noexcept { return static_cast< uint64_t >(chunk_size) * data_count(); }
+
+    // Leg holding block `idx` of `row`: data blocks are 0..k-1, P is k and Q is k+1.
+    uint32_t leg_of(uint64_t const row, uint32_t const idx) const noexcept {
+        auto const p_leg = static_cast< uint32_t >((width - 1) - (row % width));
+        auto const k = data_count();
+        if (k <= idx) return (p_leg + (idx - k)) % width;
+        return (p_leg + parity + idx) % width;
+    }
+    // Inverse of leg_of()
+    uint32_t index_of(uint64_t const row, uint32_t const leg) const noexcept {
+        auto const p_leg = static_cast< uint32_t >((width - 1) - (row % width));
+        auto const pos = (leg + width - p_leg) % width;
+        return (parity > pos) ? data_count() + pos : pos - parity;
+    }
+
+    // Returns {data block, row, column within the chunk, length} of the piece of [addr, addr+len)
+    // that starts at addr.
+    auto map(uint64_t const addr, uint32_t const len) const noexcept {
+        auto const [idx, logical_off, sz] = raid0::next_subcmd(row_width(), chunk_size, addr, len);
+        return std::make_tuple(static_cast< uint32_t >(idx), logical_off / chunk_size,
+                               static_cast< uint32_t >(logical_off % chunk_size), static_cast< uint32_t >(sz));
+    }
+};
+
+// Serializes parity updates per row across every queue and the rebuild thread. Rows hash onto a
+// fixed set of flags, so two rows may share one; that only costs a little false contention.
+// try_lock() never blocks: callers decide how to wait (coroutines park on a ring timeout, plain
+// threads yield).
+class RowLocks {
+public:
+    static constexpr uint32_t k_slots{1024};
+
+    bool try_lock(uint64_t const row) noexcept {
+        return !_held[row % k_slots].exchange(true, std::memory_order_acquire);
+    }
+    void unlock(uint64_t const row) noexcept { _held[row % k_slots].store(false, std::memory_order_release); }
+
+private:
+    std::array< std::atomic< bool >, k_slots > _held{};
+};
+
+#ifdef __LITTLE_ENDIAN
+// One combined superblock per leg. Every leg carries the full array state; the copy with the
+// highest age is authoritative when the array is assembled.
+struct __attribute__((__packed__)) SuperBlock {
+    static constexpr size_t SIZE = k_page_size;
+    struct {
+        uint8_t magic[16]; // 128-bit magic to detect an initialized superblock
+        uint16_t version;
+        uint8_t uuid[16];
+    } header;
+    struct {
+        uint16_t slot;        // Position within the array
+        uint16_t width;       // Number of legs in the array
+        uint8_t parity;       // 1 for RAID5, 2 for RAID6
+        uint32_t chunk_size;  // Bytes per block before rotating devices
+        uint64_t age;         // Bumped each time the failed set changes
+        uint64_t failed;      // Bitmask of legs that no longer hold current data
+        uint16_t rebuild_slot; // Leg being rebuilt, or k_no_slot
+        uint64_t rebuild_row;  // Rows below this are already rebuilt
+        uint32_t dirty_rows;   // Rows per bit of `dirty`; 0 before version 2
+        uint64_t dirty[k_dirty_words]; // Regions that may have writes whose parity never landed
+    } fields;
+    uint8_t _reserved[k_page_size - (sizeof(header) + sizeof(fields))];
+};
+static_assert(k_page_size == sizeof(SuperBlock), "Size of raid5::SuperBlock does not match SIZE!");
+#else
+#error "Big Endian not supported!"
+#endif
+
+constexpr uint16_t k_sb_version = 2;
+
+} // namespace ublkpp::raid5
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace ublkpp::raid5 {
+
+// Small LRU of full-row data images, so a sequential stream of sub-row writes reads each row
+// from the legs at most once: the first write into a row loads the rest of it, later writes
+// overlay their bytes and recompute parity from memory instead of reading it back.
+//
+// The caller must hold the row lock for `row` between acquire() and release(); that makes the
+// entry exclusively theirs. The mutex only guards the index, never I/O.
+class StripeCache {
+public:
+    static constexpr uint64_t k_none = UINT64_MAX;
+
+    StripeCache(uint32_t entries, size_t row_bytes) : _row_bytes(row_bytes), _entries(entries) {
+        void* buf{nullptr};
+        if (0 != ::posix_memalign(&buf, 4096, row_bytes * entries)) throw std::bad_alloc();
+        _buf.reset(static_cast< uint8_t* >(buf));
+    }
+
+    size_t row_bytes() const noexcept { return _row_bytes; }
+
+    // Returns the image of `row` and sets `hit`. On a miss with `fill` set, claims the least
+    // recently used idle entry for `row` (the caller loads it); otherwise returns nullptr.
+    uint8_t* acquire(uint64_t const row, bool const fill, bool& hit) {
+        auto lk = std::scoped_lock(_lock);
+        auto victim = _entries.end();
+        for (auto it = _entries.begin(); _entries.end() != it; ++it) {
+            if (row == it->row) {
+                hit = true;
+                it->busy = true;
+                it->tick = ++_tick;
+                return __data(it);
+            }
+            if (!it->busy && (_entries.end() == victim || it->tick < victim->tick)) victim = it;
+        }
+        hit = false;
+        if (!fill || _entries.end() == victim) return nullptr;
+        *victim = entry{.row = row, .tick = ++_tick, .busy = true};
+        return __data(victim);
+    }
+
+    // Hand back an entry from acquire(). `valid` false drops it (e.g. the write failed, so the
+    // image no longer matches the legs).
+    void release(uint64_t const row, bool const valid) {
+        auto lk = std::scoped_lock(_lock);
+        for (auto& e : _entries) {
+            if (row != e.row) continue;
+            e.busy = false;
+            if (!valid) e.row = k_none;
+            return;
+        }
+    }
+
+    // Forget `row`; for writes that replace it without going through the cache.
+    void invalidate(uint64_t const row) { release(row, false); }
+
+private:
+    struct entry {
+        uint64_t row{k_none};
+        uint64_t tick{0};
+        bool busy{false};
+    };
+    struct free_buf {
+        void operator()(uint8_t* p) const { free(p); }
+    };
+
+    uint8_t* __data(std::vector< entry >::iterator it) const noexcept {
+        return _buf.get() + (it - _entries.begin()) * _row_bytes;
+    }
+
+    size_t const _row_bytes;
+    std::mutex _lock;
+    std::vector< entry > _entries;
+    std::unique_ptr< uint8_t, free_buf > _buf;
+    uint64_t _tick{0};
+};
+
+} // namespace ublkpp::raid5
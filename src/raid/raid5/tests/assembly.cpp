@@ -0,0 +1,73 @@
+#include "test_raid5_common.hpp"
+
+TEST(Raid5, RejectsBadGeometry) {
+    EXPECT_THROW(make_array(handles_of(make_legs(2))), std::invalid_argument);
+    EXPECT_THROW(make_array(handles_of(make_legs(3)), 2), std::invalid_argument);
+    EXPECT_THROW(make_array(handles_of(make_legs(3)), 1, 24 * Ki), std::invalid_argument);
+    EXPECT_THROW(make_array(handles_of(make_legs(3)), 1, 2 * Ki), std::invalid_argument);
+    EXPECT_NO_THROW(make_array(handles_of(make_legs(4)), 2));
+}
+
+TEST(Raid5, InitializesFreshArray) {
+    auto legs = make_legs(4);
+    auto raid = make_array(handles_of(legs));
+    EXPECT_EQ("RAID5", raid->id());
+    // 63 data rows of three chunks each, trimmed to a whole number of max-size I/Os
+    EXPECT_GE(63 * 3 * k_chunk, raid->capacity());
+    EXPECT_EQ(0U, raid->capacity() % raid->max_tx());
+    EXPECT_FALSE(raid->can_discard());
+    EXPECT_TRUE(ublkpp::raid5::failed_devices(*raid).empty());
+    EXPECT_EQ(0U, ublkpp::raid5::rebuild_remaining(*raid));
+
+    for (auto slot = 0U; legs.size() > slot; ++slot) {
+        auto const sb = read_sb(legs[slot]);
+        EXPECT_EQ(slot, be16toh(sb.fields.slot));
+        EXPECT_EQ(4U, be16toh(sb.fields.width));
+        EXPECT_EQ(1U, static_cast< uint32_t >(sb.fields.parity));
+        EXPECT_EQ(k_chunk, be32toh(sb.fields.chunk_size));
+        EXPECT_EQ(0U, be64toh(sb.fields.failed));
+        EXPECT_EQ(ublkpp::raid5::k_no_slot, be16toh(sb.fields.rebuild_slot));
+    }
+    EXPECT_EQ("RAID6", make_array(handles_of(make_legs(4)), 2)->id());
+}
+
+TEST(Raid5, ReassemblesWithOnDiskChunk) {
+    auto legs = make_legs(3);
+    alignas(4096) static uint8_t buf[64 * Ki];
+    fill_random(buf, sizeof(buf), 7);
+    auto iov = iovec{.iov_base = buf, .iov_len = sizeof(buf)};
+    {
+        auto raid = make_array(handles_of(legs));
+        ASSERT_TRUE(raid->sync_iov(UBLK_IO_OP_WRITE, &iov, 1, 12 * Ki));
+    }
+    auto raid = make_array(handles_of(legs), 1, 64 * Ki);
+    alignas(4096) static uint8_t check[64 * Ki];
+    auto check_iov = iovec{.iov_base = check, .iov_len = sizeof(check)};
+    ASSERT_TRUE(raid->sync_iov(UBLK_IO_OP_READ, &check_iov, 1, 12 * Ki));
+    EXPECT_EQ(0, memcmp(buf, check, sizeof(buf)));
+}
+
+TEST(Raid5, RefusesWrongLevelOrSlot) {
+    auto legs = make_legs(4);
+    make_array(handles_of(legs));
+    EXPECT_THROW(make_array(handles_of(legs), 2), std::runtime_error);
+    EXPECT_THROW(make_array({legs[1].disk, legs[0].disk, legs[2].disk, legs[3].disk}), std::runtime_error);
+}
+
+TEST(Raid5, MissingLegIsFailed) {
+    auto legs = make_legs(3);
+    auto raid = make_array({legs[0].disk, ublkpp::make_missing_disk(), legs[2].disk});
+    EXPECT_EQ(std::vector< std::string >{"~MISSING~"}, ublkpp::raid5::failed_devices(*raid));
+    EXPECT_THROW(make_array({legs[0].disk, ublkpp::make_missing_disk(), ublkpp::make_missing_disk()}),
+                 std::runtime_error);
+}
+
+TEST(Raid5, BlankLegInExistingArrayIsFailed) {
+    auto legs = make_legs(3);
+    make_array(handles_of(legs));
+    legs[1] = make_leg("DiskZ");
+    auto raid = make_array(handles_of(legs));
+    EXPECT_EQ(std::vector< std::string >{"DiskZ"}, ublkpp::raid5::failed_devices(*raid));
+    // It can be rebuilt in place
+    EXPECT_TRUE(ublkpp::raid5::replace_device(*raid, "DiskZ", legs[1].disk));
+}
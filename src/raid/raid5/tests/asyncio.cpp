@@ -0,0 +1,102 @@
+#include "test_raid5_common.hpp"
+
+#include "ublkpp/lib/cqe_state.hpp"
+#include "raid/tests/raid_test_common.hpp"
+#include "tests/mock_ublksrv/mock_ublksrv.hpp"
+
+using ::ublkpp::test::make_async_iov_action;
+
+namespace {
+// Three legs: row 1 holds D0 on leg 2, D1 on leg 0 and P on leg 1
+struct AsyncRaid5Fixture : public ::testing::Test {
+    std::vector< std::shared_ptr< ublkpp::AsyncTestDisk > > disks;
+    ublkpp::disk_handle raid;
+    std::unique_ptr< ublkpp::MockUblksrv > mock;
+
+    void SetUp() override {
+        using ::testing::StrictMock;
+
+        for (auto i = 0U; 3 > i; ++i) {
+            auto d = std::make_shared< StrictMock< ublkpp::AsyncTestDisk > >(TestParams{.capacity = k_leg_capacity});
+            EXPECT_CALL(*d, prepare(_, _))
+                .Times(AnyNumber())
+                .WillRepeatedly(Return(ublkpp::ublk_disk::prepare_result{}));
+            EXPECT_CALL(*d, sync_iov(_, _, _, _))
+                .Times(AnyNumber())
+                .WillRepeatedly([](uint8_t op, iovec* iovecs, uint32_t, off_t) -> io_result {
+                    if (op == UBLK_IO_OP_READ && iovecs && iovecs->iov_base)
+                        memset(iovecs->iov_base, 0, iovecs->iov_len);
+                    return iovecs->iov_len;
+                });
+            EXPECT_CALL(*d, submit_iov(_, _, _, _, _)).Times(AnyNumber()).WillRepeatedly(make_async_iov_action());
+            disks.push_back(d);
+        }
+        raid = make_array({disks.begin(), disks.end()});
+        // A write to a clean region parks until the marking thread has recorded it dirty; the tests
+        // count child I/O in flight right away, so a write into row 2 marks the group up front
+        alignas(4096) static uint8_t buf[4 * Ki];
+        auto iov = iovec{.iov_base = buf, .iov_len = sizeof(buf)};
+        ASSERT_TRUE(raid->sync_iov(UBLK_IO_OP_WRITE, &iov, 1, 2 * k_chunk + 4 * Ki));
+        mock = std::make_unique< ublkpp::MockUblksrv >(raid);
+    }
+};
+
+// Matches a child I/O issued with the given opcode
+MATCHER_P(IoOp, op, "") { return op == ublksrv_get_op(arg->iod); }
+} // namespace
+
+TEST_F(AsyncRaid5Fixture, FullRowWriteNeedsNoReads) {
+    EXPECT_CALL(*disks[2], submit_iov(_, IoOp(UBLK_IO_OP_WRITE), _, _, k_chunk)).Times(1);
+    EXPECT_CALL(*disks[0], submit_iov(_, IoOp(UBLK_IO_OP_WRITE), _, _, k_chunk)).Times(1);
+    EXPECT_CALL(*disks[1], submit_iov(_, IoOp(UBLK_IO_OP_WRITE), _, _, k_chunk)).Times(1);
+
+    auto res = mock->submit_io(0, UBLK_IO_OP_WRITE, 0, 2 * k_chunk / 512, nullptr);
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res.value(), 3u); // both data blocks and P in flight at once
+
+    EXPECT_TRUE(mock->inject_cqe(0, k_chunk).empty());
+    EXPECT_TRUE(mock->inject_cqe(0, k_chunk).empty());
+    auto completions = mock->inject_cqe(0, k_chunk);
+    ASSERT_EQ(completions.size(), 1u);
+    EXPECT_EQ(completions[0].result, static_cast< int >(2 * k_chunk));
+}
+
+TEST_F(AsyncRaid5Fixture, PartialWriteReadsTheRestOfTheColumn) {
+    auto const col = k_chunk + 4 * Ki;
+    {
+        ::testing::InSequence s;
+        // The untouched block is read under a READ descriptor, although the user I/O is a write
+        EXPECT_CALL(*disks[0], submit_iov(_, IoOp(UBLK_IO_OP_READ), _, _, col)).Times(1);
+        EXPECT_CALL(*disks[2], submit_iov(_, IoOp(UBLK_IO_OP_WRITE), _, _, col)).Times(1);
+        EXPECT_CALL(*disks[1], submit_iov(_, IoOp(UBLK_IO_OP_WRITE), _, _, col)).Times(1);
+    }
+
+    // Not at the start of a row, so this goes around the stripe cache
+    auto res = mock->submit_io(0, UBLK_IO_OP_WRITE, 4 * Ki / 512, 4 * Ki / 512, nullptr);
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res.value(), 1u);
+
+    EXPECT_TRUE(mock->inject_cqe(0, 4 * Ki).empty());
+    EXPECT_TRUE(mock->inject_cqe(0, 4 * Ki).empty());
+    auto completions = mock->inject_cqe(0, 4 * Ki);
+    ASSERT_EQ(completions.size(), 1u);
+    EXPECT_EQ(completions[0].result, static_cast< int >(4 * Ki));
+}
+
+TEST_F(AsyncRaid5Fixture, ReadErrorReconstructs) {
+    EXPECT_CALL(*disks[2], submit_iov(_, IoOp(UBLK_IO_OP_READ), _, _, k_chunk)).Times(1);
+    // D1 and P rebuild D0
+    EXPECT_CALL(*disks[0], submit_iov(_, IoOp(UBLK_IO_OP_READ), _, _, k_chunk)).Times(1);
+    EXPECT_CALL(*disks[1], submit_iov(_, IoOp(UBLK_IO_OP_READ), _, _, k_chunk)).Times(1);
+
+    auto res = mock->submit_io(0, UBLK_IO_OP_READ, 0, 4 * Ki / 512, nullptr);
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res.value(), 1u);
+
+    EXPECT_TRUE(mock->inject_cqe(0, -EIO).empty());
+    EXPECT_TRUE(mock->inject_cqe(0, 4 * Ki).empty());
+    auto completions = mock->inject_cqe(0, 4 * Ki);
+    ASSERT_EQ(completions.size(), 1u);
+    EXPECT_EQ(completions[0].result, static_cast< int >(4 * Ki));
+    EXPECT_TRUE(ublkpp::raid5::failed_devices(*raid).empty());
+}
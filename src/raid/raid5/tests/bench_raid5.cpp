@@ -0,0 +1,121 @@
+// Sequential throughput of the parity arrays against RAID0 and RAID1 over memory-backed legs.
+//
+// The legs are plain buffers, so this measures what each array costs on top of the devices:
+// splitting, parity (ISA-L) and the read-modify-write traffic of sub-row writes. Not registered
+// with ctest; run by hand:
+//
+//     bench_raid5 [--mib=64] [--io_kib=128]
+#include <chrono>
+#include <cstring>
+
+#include <boost/uuid/string_generator.hpp>
+#include <sisl/logging/logging.h>
+#include <sisl/options/options.h>
+#include <ublksrv.h>
+
+#include "ublkpp/raid.hpp"
+#include "lib/common.hpp"
+
+SISL_OPTION_GROUP(bench_raid5,
+                  (mib, "", "mib", "Data written and read per array (MiB)",
+                   ::cxxopts::value< uint32_t >()->default_value("64"), "<size>"),
+                  (io_kib, "", "io_kib", "Size of each I/O (KiB)", ::cxxopts::value< uint32_t >()->default_value("128"),
+                   "<size>"))
+
+#define ENABLED_OPTIONS logging, raid1, bench_raid5
+
+SISL_LOGGING_INIT(ublk_raid)
+SISL_OPTIONS_ENABLE(ENABLED_OPTIONS)
+
+extern "C" {
+struct ublksrv_queue;
+extern int ublksrv_queue_send_event(ublksrv_queue const*) { return 0; }
+}
+
+using namespace ublkpp;
+
+namespace {
+class MemDisk : public ublk_disk {
+    std::string _id;
+    std::vector< uint8_t > _data;
+
+public:
+    MemDisk(std::string id, uint64_t capacity) : _id(std::move(id)), _data(capacity) {
+        auto& our_params = *params();
+        our_params.basic.dev_sectors = capacity >> SECTOR_SHIFT;
+        our_params.basic.logical_bs_shift = DEFAULT_BS_SHIFT;
+        our_params.basic.physical_bs_shift = DEFAULT_BS_SHIFT;
+        our_params.basic.max_sectors = (1 * Mi) >> SECTOR_SHIFT;
+        _direct_io = true;
+    }
+    std::string id() const noexcept override { return _id; }
+    io_result sync_iov(uint8_t op, iovec* iovecs, uint32_t nr_vecs, off_t addr) noexcept override {
+        auto total = size_t{0};
+        for (auto i = 0U; nr_vecs > i; ++i) {
+            if (_data.size() < addr + total + iovecs[i].iov_len)
+                return std::unexpected(std::make_error_condition(std::errc::invalid_argument));
+            if (UBLK_IO_OP_READ == op)
+                memcpy(iovecs[i].iov_base, _data.data() + addr + total, iovecs[i].iov_len);
+            else if (UBLK_IO_OP_WRITE == op)
+                memcpy(_data.data() + addr + total, iovecs[i].iov_base, iovecs[i].iov_len);
+            total += iovecs[i].iov_len;
+        }
+        return total;
+    }
+};
+
+std::vector< disk_handle > make_legs(uint32_t count, uint64_t capacity) {
+    auto legs = std::vector< disk_handle >();
+    for (auto i = 0U; count > i; ++i)
+        legs.push_back(std::make_shared< MemDisk >(fmt::format("mem{}", i), capacity));
+    return legs;
+}
+
+// MiB/s of a sequential pass over the first `bytes` of `disk`
+double pass(ublk_disk& disk, uint8_t op, uint64_t bytes, uint32_t io_size, uint8_t* buf) {
+    auto const start = std::chrono::steady_clock::now();
+    for (auto off = 0UL; bytes > off; off += io_size) {
+        auto iov = iovec{.iov_base = buf, .iov_len = io_size};
+        if (!disk.sync_iov(op, &iov, 1, static_cast< off_t >(off))) {
+            fmt::print(stderr, "{} failed at {}\n", disk.id(), off);
+            return 0;
+        }
+    }
+    auto const secs = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+    return static_cast< double >(bytes) / Mi / secs;
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SISL_OPTIONS_LOAD(argc, argv, ENABLED_OPTIONS);
+    sisl::logging::SetLogger(std::string(argv[0]));
+    spdlog::set_pattern("[%D %T.%e] [%n] [%^%l%$] [%t] %v");
+
+    auto const bytes = SISL_OPTIONS["mib"].as< uint32_t >() * Mi;
+    auto const io_size = SISL_OPTIONS["io_kib"].as< uint32_t >() * static_cast< uint32_t >(Ki);
+    auto const uuid = boost::uuids::string_generator()("5e0a3cbe-7d51-4e0b-9a3f-0c2d6b7e8f91");
+    constexpr uint32_t chunk = 32 * Ki;
+
+    void* buf{nullptr};
+    if (0 != ::posix_memalign(&buf, 4096, io_size)) return 1;
+    memset(buf, 0x5a, io_size);
+
+    // Enough room on every leg for `bytes` of data plus metadata
+    auto const leg_cap = bytes + 64 * Mi;
+    auto arrays = std::vector< std::pair< std::string, disk_handle > >{
+        {"RAID0 x4", make_raid0_disk(uuid, chunk, make_legs(4, leg_cap))},
+        {"RAID1 x2", make_raid1_disk(uuid, make_legs(2, leg_cap))},
+        {"RAID5 x4", make_raid5_disk(uuid, chunk, make_legs(4, leg_cap))},
+        {"RAID6 x4", make_raid6_disk(uuid, chunk, make_legs(4, leg_cap))},
+    };
+    fmt::print("{:<10} {:>12} {:>12}   ({} MiB in {} KiB I/Os)\n", "array", "write MiB/s", "read MiB/s",
+               bytes / Mi, io_size / Ki);
+    for (auto& [name, disk] : arrays) {
+        auto const len = std::min< uint64_t >(bytes, disk->capacity() - disk->capacity() % io_size);
+        auto const w = pass(*disk, UBLK_IO_OP_WRITE, len, io_size, static_cast< uint8_t* >(buf));
+        auto const r = pass(*disk, UBLK_IO_OP_READ, len, io_size, static_cast< uint8_t* >(buf));
+        fmt::print("{:<10} {:>12.0f} {:>12.0f}\n", name, w, r);
+    }
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "test_raid5_common.hpp"
+
+using ublkpp::raid5::ParityCodec;
+
+namespace {
+// k data + m parity blocks of random data with the parity computed
+struct Stripe {
+    uint32_t k, m;
+    std::vector< std::vector< uint8_t > > bufs;
+    std::array< uint8_t*, ublkpp::raid5::k_max_width > blocks{};
+
+    Stripe(ParityCodec const& codec, uint32_t len) : k(codec.data_count()), m(codec.parity_count()) {
+        for (auto i = 0U; k + m > i; ++i) {
+            bufs.emplace_back(len);
+            blocks[i] = bufs.back().data();
+            if (k > i) fill_random(blocks[i], len, i);
+        }
+        codec.encode(len, blocks.data(), blocks.data() + k);
+    }
+};
+} // namespace
+
+TEST(Raid5Codec, XorParity) {
+    auto const codec = ParityCodec(3, 1);
+    auto s = Stripe(codec, 4 * Ki);
+    for (auto b = 0U; 4 * Ki > b; ++b)
+        ASSERT_EQ(s.bufs[0][b] ^ s.bufs[1][b] ^ s.bufs[2][b], s.bufs[3][b]);
+}
+
+TEST(Raid5Codec, RecoversAnySingleBlock) {
+    auto const codec = ParityCodec(4, 1);
+    for (auto lost = 0U; 5 > lost; ++lost) {
+        auto s = Stripe(codec, 4 * Ki);
+        auto const saved = s.bufs[lost];
+        std::fill(s.bufs[lost].begin(), s.bufs[lost].end(), 0xa5);
+        ASSERT_TRUE(codec.reconstruct(4 * Ki, s.blocks.data(), 1ULL << lost));
+        EXPECT_EQ(saved, s.bufs[lost]) << "block " << lost;
+    }
+}
+
+TEST(Raid5Codec, Raid6RecoversAnyPair) {
+    auto const codec = ParityCodec(5, 2);
+    for (auto a = 0U; 7 > a; ++a) {
+        for (auto b = a + 1; 7 > b; ++b) {
+            auto s = Stripe(codec, 4 * Ki);
+            auto const saved_a = s.bufs[a];
+            auto const saved_b = s.bufs[b];
+            std::fill(s.bufs[a].begin(), s.bufs[a].end(), 0);
+            std::fill(s.bufs[b].begin(), s.bufs[b].end(), 0xff);
+            ASSERT_TRUE(codec.reconstruct(4 * Ki, s.blocks.data(), (1ULL << a) | (1ULL << b)));
+            EXPECT_EQ(saved_a, s.bufs[a]) << "blocks " << a << "," << b;
+            EXPECT_EQ(saved_b, s.bufs[b]) << "blocks " << a << "," << b;
+        }
+    }
+}
+
+TEST(Raid5Codec, RefusesTooManyLosses) {
+    auto const codec = ParityCodec(3, 1);
+    auto s = Stripe(codec, 4 * Ki);
+    EXPECT_FALSE(codec.reconstruct(4 * Ki, s.blocks.data(), 0b11));
+    EXPECT_THROW(ParityCodec(3, 3), std::invalid_argument);
+    EXPECT_THROW(ParityCodec(1, 1), std::invalid_argument);
+}
@@ -0,0 +1,44 @@
+#include "test_raid5_common.hpp"
+
+using ublkpp::raid5::Layout;
+
+TEST(Raid5Layout, ParityRotates) {
+    auto const layout = Layout{.width = 4, .parity = 1, .chunk_size = k_chunk};
+    // P walks backwards one leg per row; data follows it
+    EXPECT_EQ(3U, layout.leg_of(0, 3));
+    EXPECT_EQ(0U, layout.leg_of(0, 0));
+    EXPECT_EQ(2U, layout.leg_of(1, 3));
+    EXPECT_EQ(3U, layout.leg_of(1, 0));
+    EXPECT_EQ(0U, layout.leg_of(1, 1));
+    EXPECT_EQ(3U, layout.leg_of(4, 3));
+}
+
+TEST(Raid5Layout, QFollowsP) {
+    auto const layout = Layout{.width = 5, .parity = 2, .chunk_size = k_chunk};
+    for (auto row = 0UL; 10 > row; ++row)
+        EXPECT_EQ((layout.leg_of(row, 3) + 1) % 5, layout.leg_of(row, 4));
+}
+
+TEST(Raid5Layout, IndexOfInvertsLegOf) {
+    for (auto parity = 1U; 2 >= parity; ++parity) {
+        auto const layout = Layout{.width = 6, .parity = parity, .chunk_size = k_chunk};
+        for (auto row = 0UL; 12 > row; ++row) {
+            auto seen = 0ULL;
+            for (auto idx = 0U; 6 > idx; ++idx) {
+                auto const leg = layout.leg_of(row, idx);
+                seen |= 1ULL << leg;
+                EXPECT_EQ(idx, layout.index_of(row, leg));
+            }
+            EXPECT_EQ(0b111111ULL, seen);
+        }
+    }
+}
+
+TEST(Raid5Layout, MapSplitsAtChunks) {
+    auto const layout = Layout{.width = 4, .parity = 1, .chunk_size = k_chunk};
+    auto const [idx, row, col, sz] = layout.map(layout.row_width() + k_chunk + 4 * Ki, 64 * Ki);
+    EXPECT_EQ(1U, idx);
+    EXPECT_EQ(1UL, row);
+    EXPECT_EQ(4 * Ki, col);
+    EXPECT_EQ(k_chunk - 4 * Ki, sz);
+}
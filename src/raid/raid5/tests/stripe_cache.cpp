@@ -0,0 +1,57 @@
+#include "test_raid5_common.hpp"
+
+#include "raid/raid5/stripe_cache.hpp"
+
+using ublkpp::raid5::StripeCache;
+
+TEST(Raid5StripeCache, MissOnlyClaimsWhenFilling) {
+    auto cache = StripeCache(2, 8 * Ki);
+    auto hit = true;
+    EXPECT_EQ(nullptr, cache.acquire(1, false, hit));
+    EXPECT_FALSE(hit);
+    auto* image = cache.acquire(1, true, hit);
+    ASSERT_NE(nullptr, image);
+    EXPECT_FALSE(hit);
+    cache.release(1, true);
+    EXPECT_EQ(image, cache.acquire(1, false, hit));
+    EXPECT_TRUE(hit);
+    cache.release(1, true);
+}
+
+TEST(Raid5StripeCache, EvictsLeastRecentlyUsed) {
+    auto cache = StripeCache(2, 8 * Ki);
+    auto hit = false;
+    for (auto row : {1UL, 2UL, 1UL}) {
+        ASSERT_NE(nullptr, cache.acquire(row, true, hit));
+        cache.release(row, true);
+    }
+    // Row 2 is the oldest and makes room for row 3
+    ASSERT_NE(nullptr, cache.acquire(3, true, hit));
+    cache.release(3, true);
+    EXPECT_NE(nullptr, cache.acquire(1, false, hit));
+    EXPECT_TRUE(hit);
+    cache.release(1, true);
+    EXPECT_EQ(nullptr, cache.acquire(2, false, hit));
+}
+
+TEST(Raid5StripeCache, BusyEntriesStay) {
+    auto cache = StripeCache(1, 8 * Ki);
+    auto hit = false;
+    ASSERT_NE(nullptr, cache.acquire(1, true, hit));
+    EXPECT_EQ(nullptr, cache.acquire(2, true, hit));
+    cache.release(1, true);
+    EXPECT_NE(nullptr, cache.acquire(2, true, hit));
+    cache.release(2, true);
+}
+
+TEST(Raid5StripeCache, InvalidateDrops) {
+    auto cache = StripeCache(2, 8 * Ki);
+    auto hit = false;
+    ASSERT_NE(nullptr, cache.acquire(1, true, hit));
+    cache.release(1, false);
+    EXPECT_EQ(nullptr, cache.acquire(1, false, hit));
+    ASSERT_NE(nullptr, cache.acquire(1, true, hit));
+    cache.release(1, true);
+    cache.invalidate(1);
+    EXPECT_EQ(nullptr, cache.acquire(1, false, hit));
+}
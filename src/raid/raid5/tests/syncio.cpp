@@ -0,0 +1,207 @@
+#include "test_raid5_common.hpp"
+
+#include <chrono>
+#include <thread>
+
+namespace {
+struct Raid5Sync : public ::testing::Test {
+    std::vector< mem_leg > legs;
+    ublkpp::disk_handle raid;
+    uint32_t parity{1};
+    std::vector< uint8_t > model; // What the array should read back
+
+    void make(uint32_t width, uint32_t p = 1) {
+        parity = p;
+        legs = make_legs(width);
+        raid = make_array(handles_of(legs), parity);
+        model.assign(raid->capacity(), 0);
+    }
+
+    io_result io(uint8_t op, uint64_t addr, uint32_t len, uint64_t seed = 0) {
+        alignas(4096) static uint8_t buf[256 * Ki];
+        auto iov = iovec{.iov_base = buf, .iov_len = len};
+        if (UBLK_IO_OP_WRITE == op) {
+            fill_random(buf, len, seed);
+            memcpy(model.data() + addr, buf, len);
+        }
+        auto res = raid->sync_iov(op, &iov, 1, addr);
+        if (res && UBLK_IO_OP_READ == op) {
+            EXPECT_EQ(0, memcmp(model.data() + addr, buf, len)) << "at " << addr;
+        }
+        return res;
+    }
+
+    // Count the reads the legs see while running `fn`
+    template < typename F >
+    uint32_t reads_during(F&& fn) {
+        auto before = 0U;
+        for (auto const& leg : legs)
+            before += *leg.reads;
+        fn();
+        auto after = 0U;
+        for (auto const& leg : legs)
+            after += *leg.reads;
+        return after - before;
+    }
+
+    void wait_for_rebuild() {
+        while (0 < ublkpp::raid5::rebuild_remaining(*raid))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Whether the superblock on `leg` records any region dirty
+    static bool dirty(mem_leg const& leg) {
+        auto const sb = read_sb(leg);
+        for (auto w = 0U; ublkpp::raid5::k_dirty_words > w; ++w)
+            if (0 != sb.fields.dirty[w]) return true;
+        return false;
+    }
+
+    // The resync at assembly clears each region once its parity is rewritten
+    void wait_for_resync() {
+        while (dirty(legs[0]))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+};
+} // namespace
+
+TEST_F(Raid5Sync, WriteReadRoundTrip) {
+    make(4);
+    // Unaligned writes spanning chunk and row boundaries
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 0, 4 * Ki, 1));
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, k_chunk - 4 * Ki, 24 * Ki, 2));
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 3 * k_chunk - 512, 3 * k_chunk, 3));
+    EXPECT_TRUE(io(UBLK_IO_OP_READ, 0, 128 * Ki));
+    expect_parity(legs, parity);
+}
+
+TEST_F(Raid5Sync, FullRowWriteSkipsReads) {
+    make(4);
+    auto const row = 3 * k_chunk;
+    EXPECT_EQ(0U, reads_during([&] { EXPECT_TRUE(io(UBLK_IO_OP_WRITE, row, row, 1)); }));
+    EXPECT_TRUE(io(UBLK_IO_OP_READ, row, row));
+    expect_parity(legs, parity);
+}
+
+TEST_F(Raid5Sync, SequentialWritesUseStripeCache) {
+    make(4);
+    // The first write into the row loads it; the rest of the row is written from memory
+    EXPECT_LT(0U, reads_during([&] { EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 0, 8 * Ki, 1)); }));
+    EXPECT_EQ(0U, reads_during([&] {
+                  for (auto off = 8 * Ki; 3 * k_chunk > off; off += 8 * Ki)
+                      EXPECT_TRUE(io(UBLK_IO_OP_WRITE, off, 8 * Ki, off));
+              }));
+    EXPECT_TRUE(io(UBLK_IO_OP_READ, 0, 3 * k_chunk));
+    expect_parity(legs, parity);
+}
+
+TEST_F(Raid5Sync, DegradedReadsReconstruct) {
+    make(4);
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 0, 192 * Ki, 1));
+    *legs[1].broken = true;
+    // A read error alone reconstructs without failing the leg
+    EXPECT_TRUE(io(UBLK_IO_OP_READ, 0, 192 * Ki));
+    EXPECT_TRUE(ublkpp::raid5::failed_devices(*raid).empty());
+
+    // A write error does fail it; I/O carries on without it
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 4 * Ki, 96 * Ki, 2));
+    EXPECT_EQ(std::vector< std::string >{"DiskB"}, ublkpp::raid5::failed_devices(*raid));
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 100 * Ki, 3 * Ki, 3));
+    EXPECT_TRUE(io(UBLK_IO_OP_READ, 0, 192 * Ki));
+    EXPECT_EQ(0b10U, be64toh(read_sb(legs[0]).fields.failed));
+}
+
+TEST_F(Raid5Sync, SecondFailureIsFatal) {
+    make(3);
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 0, 64 * Ki, 1));
+    *legs[0].broken = true;
+    *legs[2].broken = true;
+    EXPECT_FALSE(io(UBLK_IO_OP_READ, 0, 64 * Ki));
+}
+
+TEST_F(Raid5Sync, Raid6SurvivesTwoFailures) {
+    make(5, 2);
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 0, 160 * Ki, 1));
+    expect_parity(legs, parity);
+    *legs[0].broken = true;
+    *legs[3].broken = true;
+    EXPECT_TRUE(io(UBLK_IO_OP_READ, 0, 160 * Ki));
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 20 * Ki, 140 * Ki, 2));
+    EXPECT_EQ(2U, ublkpp::raid5::failed_devices(*raid).size());
+    EXPECT_TRUE(io(UBLK_IO_OP_READ, 0, 160 * Ki));
+}
+
+TEST_F(Raid5Sync, ReplaceRebuildsLeg) {
+    make(4);
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 0, 192 * Ki, 1));
+    *legs[2].broken = true;
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 64 * Ki, 64 * Ki, 2));
+    ASSERT_EQ(std::vector< std::string >{"DiskC"}, ublkpp::raid5::failed_devices(*raid));
+
+    // Only failed legs can be replaced, and only with something large enough
+    EXPECT_FALSE(ublkpp::raid5::replace_device(*raid, "DiskA", make_leg("DiskX").disk));
+    EXPECT_FALSE(ublkpp::raid5::replace_device(*raid, "DiskC", make_leg("DiskX", 64 * Ki).disk));
+
+    auto spare = make_leg("DiskE");
+    ASSERT_TRUE(ublkpp::raid5::replace_device(*raid, "DiskC", spare.disk));
+    legs[2] = spare;
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 32 * Ki, 8 * Ki, 3));
+    wait_for_rebuild();
+    EXPECT_TRUE(ublkpp::raid5::failed_devices(*raid).empty());
+    expect_parity(legs, parity);
+
+    // The rebuilt leg carries its share: lose another and everything still reads back
+    *legs[0].broken = true;
+    EXPECT_TRUE(io(UBLK_IO_OP_READ, 0, 192 * Ki));
+}
+
+// A crash between the data and parity writes of a row leaves its parity stale. The row's region is
+// recorded dirty before the write goes out, so the next assembly rewrites that parity before a
+// lost leg has to be reconstructed from it.
+TEST_F(Raid5Sync, CrashMidRowResyncsParity) {
+    make(4);
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 0, 192 * Ki, 1));
+    EXPECT_TRUE(dirty(legs[0]));
+
+    // Row 1 gets new data on its first block, but the parity write never lands
+    auto const layout = ublkpp::raid5::Layout{.width = 4, .parity = 1, .chunk_size = k_chunk};
+    auto& p_leg = legs[layout.leg_of(1, layout.data_count())];
+    *p_leg.lossy = true;
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 4 * Ki, 8 * Ki, 2));
+    *p_leg.lossy = false;
+    auto crashed = std::vector< std::vector< uint8_t > >();
+    for (auto const& leg : legs)
+        crashed.push_back(*leg.data);
+
+    // A clean shutdown leaves nothing dirty; the crash did not get that far
+    raid.reset();
+    EXPECT_FALSE(dirty(legs[0]));
+    for (auto i = 0U; legs.size() > i; ++i)
+        *legs[i].data = crashed[i];
+
+    raid = make_array(handles_of(legs), parity);
+    wait_for_resync();
+    expect_parity(legs, parity);
+    // Reconstruct the rewritten block from the resynced parity
+    *legs[layout.leg_of(1, 0)].broken = true;
+    EXPECT_TRUE(io(UBLK_IO_OP_READ, 0, 192 * Ki));
+}
+
+// Regions are marked a group at a time, so the writes that follow into its neighbours go straight
+// out without another superblock write
+TEST_F(Raid5Sync, MarksWholeGroupDirty) {
+    make(4);
+    // One row per region here: rows 1 to 16 make up the first group
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 4 * Ki, 4 * Ki, 1));
+    EXPECT_EQ(0xffffULL, be64toh(read_sb(legs[0]).fields.dirty[0]));
+    // Row 17 starts the next one
+    EXPECT_TRUE(io(UBLK_IO_OP_WRITE, 16 * 3 * k_chunk + 4 * Ki, 4 * Ki, 2));
+    EXPECT_EQ(0xffffffffULL, be64toh(read_sb(legs[0]).fields.dirty[0]));
+}
+
+TEST_F(Raid5Sync, RejectsOtherOps) {
+    make(3);
+    auto iov = iovec{.iov_base = nullptr, .iov_len = 4 * Ki};
+    EXPECT_FALSE(raid->sync_iov(UBLK_IO_OP_DISCARD, &iov, 1, 0));
+    EXPECT_FALSE(raid->sync_iov(UBLK_IO_OP_READ, &iov, 0, 0));
+}
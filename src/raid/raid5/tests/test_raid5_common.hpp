@@ -0,0 +1,73 @@
+#pragma once
+
+#include <random>
+
+#include <boost/uuid/string_generator.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <ublksrv.h>
+
+#include "ublkpp/raid.hpp"
+#include "raid/raid5/parity_codec.hpp"
+#include "raid/raid5/raid5_impl.hpp"
+#include "tests/test_disk.hpp"
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::ublkpp::io_result;
+using ::ublkpp::Mi;
+using ::ublkpp::ublk_disk;
+
+static std::string const test_uuid("3b6d0c0e-6f8e-4d55-8f5b-2f0a6c1d9e47");
+static constexpr uint32_t k_chunk = 16 * Ki;
+static constexpr uint64_t k_leg_capacity = Mi; // 63 data rows of k_chunk after the superblock
+
+inline mem_leg make_leg(std::string const& id, uint64_t capacity = k_leg_capacity) {
+    return make_mem_leg(id, capacity);
+}
+
+inline std::vector< mem_leg > make_legs(uint32_t width, char first = 'A') {
+    return make_mem_legs(width, k_leg_capacity, first);
+}
+
+inline ublkpp::disk_handle make_array(std::vector< ublkpp::disk_handle >&& legs, uint32_t parity = 1,
+                                      uint32_t chunk = k_chunk) {
+    auto const uuid = boost::uuids::string_generator()(test_uuid);
+    if (2 == parity) return ublkpp::make_raid6_disk(uuid, chunk, std::move(legs));
+    return ublkpp::make_raid5_disk(uuid, chunk, std::move(legs));
+}
+
+// Decoded superblock on `leg`
+inline ublkpp::raid5::SuperBlock read_sb(mem_leg const& leg) {
+    auto sb = ublkpp::raid5::SuperBlock();
+    auto lk = std::scoped_lock(*leg.lock);
+    memcpy(&sb, leg.data->data(), sizeof(sb));
+    return sb;
+}
+
+// Check every data row on the legs against freshly computed parity
+inline void expect_parity(std::vector< mem_leg > const& legs, uint32_t parity) {
+    auto const layout = ublkpp::raid5::Layout{
+        .width = static_cast< uint32_t >(legs.size()), .parity = parity, .chunk_size = k_chunk};
+    auto const codec = ublkpp::raid5::ParityCodec(layout.data_count(), parity);
+    auto expected = std::vector< uint8_t >(parity * k_chunk);
+    for (auto row = 1UL; k_leg_capacity / k_chunk > row; ++row) {
+        auto blocks = std::array< uint8_t*, ublkpp::raid5::k_max_width >();
+        for (auto i = 0U; layout.width > i; ++i)
+            blocks[i] = legs[layout.leg_of(row, i)].data->data() + row * k_chunk;
+        auto computed = std::array< uint8_t*, ublkpp::raid5::k_max_parity >{expected.data(), expected.data() + k_chunk};
+        codec.encode(k_chunk, blocks.data(), computed.data());
+        for (auto p = 0U; parity > p; ++p)
+            ASSERT_EQ(0, memcmp(computed[p], blocks[layout.data_count() + p], k_chunk))
+                << "parity " << p << " of row " << row << " is stale";
+    }
+}
+
+inline void fill_random(uint8_t* buf, size_t len, uint64_t seed) {
+    auto rng = std::mt19937_64(seed);
+    for (auto i = 0UL; len > i; ++i)
+        buf[i] = static_cast< uint8_t >(rng());
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace ublkpp {
+
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// How long a queue spins on its CQ ring before sleeping in io_uring_enter().
+//
+// Fixed, the window is `max_ns`. Adaptive, it follows the gaps observe()d between the queue
+// running out of completions and the next one arriving, whether that one was caught spinning or
+// woke the thread: twice their running average while at least half of them are short enough to
+// catch within `max_ns`, and no spinning otherwise. An idle or slow queue so stops burning CPU,
+// and picks spinning up again as soon as its completions come back within reach.
+class poll_window {
+public:
+    static constexpr uint64_t k_min_ns = 1000;
+
+    poll_window(uint64_t max_ns, bool adaptive) noexcept :
+            _max_ns(max_ns), _adaptive(adaptive), _window_ns(adaptive ? 0 : max_ns) {}
+
+    uint64_t window_ns() const noexcept { return _window_ns; }
+
+    void observe(uint64_t gap_ns) noexcept {
+        if (!_adaptive) return;
+        auto const near = gap_ns <= _max_ns;
+        // Both averages move by 1/8 of the difference per sample
+        _near_rate = _near_rate - (_near_rate >> 3) + (near ? k_one >> 3 : 0);
+        if (near) _near_ns = _near_ns - (_near_ns >> 3) + (gap_ns >> 3);
+        _window_ns = (k_one / 2 <= _near_rate) ? std::clamp(2 * _near_ns, std::min(k_min_ns, _max_ns), _max_ns) : 0;
+    }
+
+private:
+    static constexpr uint64_t k_one = 1024; // _near_rate of 1.0
+
+    uint64_t const _max_ns;
+    bool const _adaptive;
+    uint64_t _window_ns;
+    uint64_t _near_ns{0};
+    uint64_t _near_rate{0};
+};
+
+} // namespace ublkpp
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "ublkpp/target.hpp"
+#include "lib/common.hpp"
+
+namespace ublkpp {
+
+// Changed-block tracking bitmap for one target: one bit per k_chunk_size region of the volume.
+//
+// mark() is the write-path hook: a relaxed fetch_or per 64 chunks touched, no locks and no
+// allocation, so it is cheap enough to leave on permanently (2 GiB of tracked capacity costs
+// 8 KiB). collect() coalesces set bits into byte extents; with reset=true each word is exchanged
+// for zero, so a mark() racing the collection lands either in the returned extents or in the
+// bitmap that is left behind — never in neither.
+class ChangeTracker {
+public:
+    static constexpr uint64_t k_chunk_size = 32 * Ki;
+
+    explicit ChangeTracker(uint64_t capacity) :
+            _capacity(capacity), _words((capacity + k_chunk_size * 64 - 1) / (k_chunk_size * 64)) {}
+
+    void mark(uint64_t addr, uint64_t len) noexcept {
+        if (0 == len || addr >= _capacity) return;
+        auto const first = addr / k_chunk_size;
+        auto const last = (std::min(addr + len, _capacity) - 1) / k_chunk_size;
+        for (auto w = first / 64; w <= last / 64; ++w) {
+            auto const lo = (w == first / 64) ? first % 64 : 0;
+            auto const hi = (w == last / 64) ? last % 64 : 63;
+            auto const bits = (~0ULL >> (63 - hi)) & (~0ULL << lo);
+            // Skip the RMW when already marked: repeated writes to a hot region stay read-only.
+            if ((_words[w].load(std::memory_order_relaxed) & bits) == bits) continue;
+            _words[w].fetch_or(bits, std::memory_order_relaxed);
+        }
+    }
+
+    std::vector< changed_extent > collect(bool reset) {
+        auto res = std::vector< changed_extent >{};
+        for (auto w = 0UL; w < _words.size(); ++w) {
+            auto bits = reset ? _words[w].exchange(0, std::memory_order_acq_rel)
+                              : _words[w].load(std::memory_order_acquire);
+            while (0 != bits) {
+                auto const lo = static_cast< uint64_t >(std::countr_zero(bits));
+                auto const run = static_cast< uint64_t >(std::countr_one(bits >> lo));
+                bits = (64 == lo + run) ? 0 : bits & (~0ULL << (lo + run));
+                auto const off = (w * 64 + lo) * k_chunk_size;
+                auto const len = std::min(run * k_chunk_size, _capacity - off);
+                if (!res.empty() && res.back().offset + res.back().length == off)
+                    res.back().length += len;
+                else
+                    res.push_back({off, len});
+            }
+        }
+        return res;
+    }
+
+    uint64_t capacity() const noexcept { return _capacity; }
+
+private:
+    uint64_t const _capacity;
+    std::vector< std::atomic< uint64_t > > _words;
+};
+
+} // namespace ublkpp
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+#include <linux/ublk_cmd.h>
+
+#include "lib/common.hpp"
+
+struct ublk_io_data;
+
+namespace ublkpp {
+
+// Most requests a queue merges into one backend I/O
+constexpr uint32_t k_max_merge = 16;
+
+// A request a plugging queue (--plug_merge) holds back until the end of its CQE batch
+struct plugged_io {
+    uint32_t op_flags; // ublksrv_io_desc::op_flags: the op in the low byte, its flags above
+    uint32_t nr_sectors;
+    uint64_t start_sector;
+    ublk_io_data const* data;
+};
+
+// How far the disk a queue serves lets it merge
+struct merge_limits {
+    bool vectored{false};          // Reads and writes may go as several iovecs (ublk_disk::scatter_gather())
+    uint64_t max_bytes{0};         // Largest read or write
+    uint64_t max_discard_bytes{0}; // Largest DISCARD / WRITE_ZEROES
+};
+
+// Puts requests of the same op and flags next to each other, in address order
+inline void order_plug(std::span< plugged_io > batch) {
+    std::ranges::sort(batch, {}, [](plugged_io const& p) { return std::pair(p.op_flags, p.start_sector); });
+}
+
+// How many requests at the front of an order_plug()ed batch go as one I/O: a run of the same op
+// and flags, each starting where the one before it ends, within `limits`. Reads and writes are
+// merged into one iovec each, DISCARD and WRITE_ZEROES into one longer range; other ops go alone.
+inline uint32_t merge_run(std::span< plugged_io const > batch, merge_limits const& limits) noexcept {
+    if (batch.empty()) return 0;
+    auto const& head = batch.front();
+    auto max_bytes = uint64_t{0};
+    switch (head.op_flags & 0xff) {
+    case UBLK_IO_OP_READ:
+    case UBLK_IO_OP_WRITE:
+        max_bytes = limits.vectored ? limits.max_bytes : 0;
+        break;
+    case UBLK_IO_OP_DISCARD:
+    case UBLK_IO_OP_WRITE_ZEROES:
+        max_bytes = limits.max_discard_bytes;
+        break;
+    default:
+        return 1;
+    }
+    auto bytes = uint64_t{head.nr_sectors} << SECTOR_SHIFT;
+    auto n = 1U;
+    for (; std::min< size_t >(batch.size(), k_max_merge) > n; ++n) {
+        auto const& prev = batch[n - 1];
+        auto const& cur = batch[n];
+        if (cur.op_flags != head.op_flags || 0 == cur.nr_sectors ||
+            prev.start_sector + prev.nr_sectors != cur.start_sector)
+            break;
+        auto const len = uint64_t{cur.nr_sectors} << SECTOR_SHIFT;
+        if (max_bytes < bytes + len) break;
+        bytes += len;
+    }
+    return n;
+}
+
+// What the request of `bytes` gets from a merged I/O's `result`, `done` bytes of it having gone to
+// the requests before it: its full length, the part a short result reaches (the kernel reissues
+// the rest), or -EIO once the result has run out. Errors and a driver's 0 go to every request.
+inline int merged_result(int const result, uint64_t const done, uint64_t const bytes) noexcept {
+    if (0 >= result) return result;
+    auto const total = static_cast< uint64_t >(result);
+    if (total <= done) return -EIO;
+    return static_cast< int >(std::min(bytes, total - done));
+}
+
+} // namespace ublkpp
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+
+#include "ublkpp/target.hpp"
+
+namespace ublkpp {
+
+// One token bucket of a target's QoS, shared by all of its queues without a lock.
+//
+// Kept as the bucket's theoretical arrival time (GCRA): the instant it would next be empty had
+// every unit taken so far gone at exactly the rate. reserve() moves it forward by the cost of its
+// units in one CAS and hands back when those units may go; a caller never fails, it is told how
+// long to wait. Lagging `burst` units behind that instant is allowed, which is what lets a burst
+// through at once after a quiet spell; the instant never trails the present, so quiet time does
+// not bank more than that.
+class rate_limiter {
+public:
+    void set(qos_limit const& limit) noexcept {
+        _rate.store(limit.rate, std::memory_order_relaxed);
+        _burst.store(limit.burst, std::memory_order_relaxed);
+        _tat.store(0, std::memory_order_relaxed);
+    }
+
+    bool limited() const noexcept { return 0 < _rate.load(std::memory_order_relaxed); }
+
+    // Takes `n` units at `now_ns` and returns when they may go: `now_ns` when within the limit
+    uint64_t reserve(uint64_t n, uint64_t now_ns) noexcept {
+        auto const rate = _rate.load(std::memory_order_relaxed);
+        if (0 == rate) return now_ns;
+        auto const cost = ns_for(n, rate);
+        auto const tolerance = ns_for(_burst.load(std::memory_order_relaxed), rate);
+        auto tat = _tat.load(std::memory_order_relaxed);
+        auto start = uint64_t{0};
+        do {
+            start = std::max(tat, now_ns);
+        } while (!_tat.compare_exchange_weak(tat, sat_add(start, cost), std::memory_order_relaxed));
+        return std::max(now_ns, start - std::min(start, tolerance));
+    }
+
+private:
+    static uint64_t ns_for(uint64_t units, uint64_t rate) noexcept {
+        auto const ns = static_cast< unsigned __int128 >(units) * 1000000000U / rate;
+        return static_cast< uint64_t >(std::min< unsigned __int128 >(ns, std::numeric_limits< uint64_t >::max()));
+    }
+    static uint64_t sat_add(uint64_t a, uint64_t b) noexcept {
+        return (std::numeric_limits< uint64_t >::max() - a < b) ? std::numeric_limits< uint64_t >::max() : a + b;
+    }
+
+    std::atomic< uint64_t > _rate{0};
+    std::atomic< uint64_t > _burst{0};
+    std::atomic< uint64_t > _tat{0};
+};
+
+// The four buckets of a target. admit() is the queue threads' hot path: with no limit set it is
+// one relaxed load. set() starts every bucket afresh and bumps generation(), which tells the
+// queues to re-admit what they hold parked under the old limits.
+class qos_throttle {
+public:
+    void set(qos_limits const& limits) {
+        auto lk = std::scoped_lock< std::mutex >(_lock);
+        _limits = limits;
+        _read_iops.set(limits.read_iops);
+        _write_iops.set(limits.write_iops);
+        _read_bytes.set(limits.read_bytes);
+        _write_bytes.set(limits.write_bytes);
+        _limited.store(_read_iops.limited() || _write_iops.limited() || _read_bytes.limited() ||
+                           _write_bytes.limited(),
+                       std::memory_order_relaxed);
+        _generation.fetch_add(1, std::memory_order_release);
+    }
+
+    qos_limits get() const {
+        auto lk = std::scoped_lock< std::mutex >(_lock);
+        return _limits;
+    }
+
+    bool limited() const noexcept { return _limited.load(std::memory_order_relaxed); }
+    uint64_t generation() const noexcept { return _generation.load(std::memory_order_acquire); }
+
+    // When an I/O moving `bytes` (0 for DISCARD / WRITE_ZEROES) that arrived at `now_ns` may go
+    uint64_t admit(bool is_read, uint64_t bytes, uint64_t now_ns) noexcept {
+        auto& iops = is_read ? _read_iops : _write_iops;
+        auto& bw = is_read ? _read_bytes : _write_bytes;
+        auto const at = iops.reserve(1, now_ns);
+        return (0 < bytes) ? std::max(at, bw.reserve(bytes, now_ns)) : at;
+    }
+
+private:
+    rate_limiter _read_iops;
+    rate_limiter _write_iops;
+    rate_limiter _read_bytes;
+    rate_limiter _write_bytes;
+    std::atomic< bool > _limited{false};
+    std::atomic< uint64_t > _generation{0};
+    mutable std::mutex _lock;
+    qos_limits _limits{};
+};
+
+} // namespace ublkpp
@@ -0,0 +1,82 @@
+#pragma once
+
+extern "C" {
+#include <sched.h>
+}
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace ublkpp {
+
+// CPU placement of a target's queue threads.
+//
+// The kernel maps every CPU to one ublk queue; I/O submitted on a CPU is handed to the daemon by
+// the queue it maps to. A queue thread running on one of its own CPUs completes that I/O without
+// a cross-CPU wakeup, and memory it allocates there (ring, cqe_state pools, I/O buffers) lands on
+// the node that uses it.
+
+// Queues for --nr_hw_queues=0: one per CPU the daemon may run on
+inline uint16_t auto_queue_count(cpu_set_t const& allowed) noexcept {
+    return static_cast< uint16_t >(std::max(1, CPU_COUNT(&allowed)));
+}
+
+// One CPU per queue. Queue q takes the first CPU of masks[q] that `allowed` holds and no earlier
+// queue took; a queue left without one takes the next untaken allowed CPU, and once every
+// allowed CPU is taken queues share them round-robin. -1 only when `allowed` is empty.
+inline std::vector< int > plan_queue_cpus(std::vector< cpu_set_t > const& masks, cpu_set_t const& allowed) {
+    auto cpus = std::vector< int >(masks.size(), -1);
+    auto usable = std::vector< int >();
+    for (auto cpu = 0; CPU_SETSIZE > cpu; ++cpu)
+        if (CPU_ISSET(cpu, &allowed)) usable.push_back(cpu);
+    if (usable.empty()) return cpus;
+
+    auto taken = cpu_set_t{};
+    CPU_ZERO(&taken);
+    for (auto q = 0UL; masks.size() > q; ++q) {
+        for (auto const cpu : usable) {
+            if (!CPU_ISSET(cpu, &masks[q]) || CPU_ISSET(cpu, &taken)) continue;
+            cpus[q] = cpu;
+            CPU_SET(cpu, &taken);
+            break;
+        }
+    }
+    auto next = 0UL;
+    for (auto q = 0UL; masks.size() > q; ++q) {
+        if (0 <= cpus[q]) continue;
+        while (usable.size() > next && CPU_ISSET(usable[next], &taken))
+            ++next;
+        if (usable.size() > next) {
+            cpus[q] = usable[next];
+            CPU_SET(usable[next], &taken);
+        } else
+            cpus[q] = usable[q % usable.size()];
+    }
+    return cpus;
+}
+
+// One CPU per queue for shared reactors (--shared_reactors), where the reactor of a CPU serves the
+// queues of many targets. Queue q takes the CPU of masks[q] that `allowed` holds with the fewest
+// queues on it, lowest first on a tie; `load` counts the queues already served by CPU, and each
+// queue planned here adds to it, so a target's queues spread out as targets do. A queue whose mask
+// holds no allowed CPU picks among all of them. -1 only when `allowed` is empty.
+inline std::vector< int > plan_reactor_cpus(std::vector< cpu_set_t > const& masks, cpu_set_t const& allowed,
+                                            std::vector< uint32_t > load) {
+    auto cpus = std::vector< int >(masks.size(), -1);
+    load.resize(CPU_SETSIZE, 0);
+    for (auto q = 0UL; masks.size() > q; ++q) {
+        auto const pick = [&](bool const in_mask) {
+            for (auto cpu = 0; CPU_SETSIZE > cpu; ++cpu) {
+                if (!CPU_ISSET(cpu, &allowed) || (in_mask && !CPU_ISSET(cpu, &masks[q]))) continue;
+                if (0 > cpus[q] || load[cpu] < load[cpus[q]]) cpus[q] = cpu;
+            }
+        };
+        pick(true);
+        if (0 > cpus[q]) pick(false);
+        if (0 <= cpus[q]) ++load[cpus[q]];
+    }
+    return cpus;
+}
+
+} // namespace ublkpp
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace ublkpp {
+
+// Shared reactors (--shared_reactors): one thread per CPU serves the queues of every target placed
+// on that CPU, in place of a thread per queue. Each queue keeps the io_uring libublksrv sets up for
+// it; the reactor sleeps on one of its own, polling the ring fds of the queues it serves, and
+// takes their completions in turn.
+
+// Most CQEs a reactor reaps from one queue before it turns to the next with completions
+constexpr uint32_t k_reactor_budget = 64;
+
+// The queues a reactor serves, in slots reused as they free up. A queue is known by a key: its
+// slot and that slot's generation, which moves on each time the slot is freed, so a completion
+// raised for the queue that held the slot before is not taken for the one holding it now. Key 0
+// is never handed out.
+template < typename T >
+class reactor_slots {
+public:
+    uint64_t add(std::unique_ptr< T > item) {
+        auto slot = uint32_t{0};
+        if (_free.empty()) {
+            slot = static_cast< uint32_t >(_slots.size());
+            _slots.emplace_back();
+        } else {
+            slot = _free.back();
+            _free.pop_back();
+        }
+        _slots[slot].item = std::move(item);
+        ++_live;
+        return key(slot);
+    }
+
+    // The item `k` was handed out for, or nullptr once it has been removed
+    T* find(uint64_t const k) const noexcept {
+        auto const slot = slot_of(k);
+        if (_slots.size() <= slot || _slots[slot].gen != static_cast< uint32_t >(k >> 32)) return nullptr;
+        return _slots[slot].item.get();
+    }
+
+    // The item in `slot`, whatever its generation; nullptr for a free slot
+    T* at(uint32_t const slot) const noexcept { return (_slots.size() > slot) ? _slots[slot].item.get() : nullptr; }
+
+    std::unique_ptr< T > remove(uint64_t const k) {
+        if (!find(k)) return nullptr;
+        auto& s = _slots[slot_of(k)];
+        ++s.gen;
+        --_live;
+        _free.push_back(slot_of(k));
+        return std::move(s.item);
+    }
+
+    static uint32_t slot_of(uint64_t const k) noexcept { return static_cast< uint32_t >(k & 0xffffffff) - 1; }
+    size_t size() const noexcept { return _live; }
+
+    template < typename F >
+    void for_each(F&& f) const {
+        for (auto slot = uint32_t{0}; _slots.size() > slot; ++slot)
+            if (_slots[slot].item) f(slot, *_slots[slot].item);
+    }
+
+private:
+    struct entry {
+        std::unique_ptr< T > item;
+        uint32_t gen{0};
+    };
+
+    uint64_t key(uint32_t const slot) const noexcept { return (uint64_t{_slots[slot].gen} << 32) | (slot + 1); }
+
+    std::vector< entry > _slots;
+    std::vector< uint32_t > _free;
+    size_t _live{0};
+};
+
+// The order a reactor serves the slots with completions in: round robin. A slot marked while it
+// is already waiting keeps its place; one that used up its budget is marked again behind the rest,
+// so a busy device cannot hold back the others on its CPU.
+class ready_ring {
+public:
+    void mark(uint32_t const slot) {
+        if (_queued.size() <= slot) _queued.resize(slot + 1, false);
+        if (_queued[slot]) return;
+        _queued[slot] = true;
+        _order.push_back(slot);
+    }
+
+    std::optional< uint32_t > next() {
+        if (_order.empty()) return std::nullopt;
+        auto const slot = _order.front();
+        _order.pop_front();
+        _queued[slot] = false;
+        return slot;
+    }
+
+    size_t size() const noexcept { return _order.size(); }
+    bool empty() const noexcept { return _order.empty(); }
+
+private:
+    std::deque< uint32_t > _order;
+    std::vector< bool > _queued;
+};
+
+} // namespace ublkpp
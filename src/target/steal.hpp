@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+namespace ublkpp {
+
+// Work stealing between the queues of a target (--steal_io).
+//
+// A ublk request is fetched and committed by the thread of the queue its tag belongs to, but what
+// lies between - the stack's coroutine, its backend SQEs and their completions - may run on any.
+// A queue whose CQE batch brings more requests than it serves at once (--steal_batch) offers the
+// rest, and sibling queues with room to spare take them; a stolen request's backend I/O goes to
+// the thief's ring, and its result back to the queue it came from to be committed there.
+
+// What a lending queue has on offer. The owner serves from the front, oldest first, and thieves
+// take from the back. Not locked itself: the target's steal lock guards the offers of all its
+// queues.
+template < typename T >
+class offer_queue {
+public:
+    void offer(T item) { _items.push_back(std::move(item)); }
+
+    // Hands up to `n` items to `f`, oldest first; returns how many
+    template < typename F >
+    size_t take_front(size_t const n, F&& f) {
+        auto taken = size_t{0};
+        for (; n > taken && !_items.empty(); ++taken) {
+            f(std::move(_items.front()));
+            _items.pop_front();
+        }
+        return taken;
+    }
+
+    // Hands up to `n` items to `f`, newest first; returns how many
+    template < typename F >
+    size_t take_back(size_t const n, F&& f) {
+        auto taken = size_t{0};
+        for (; n > taken && !_items.empty(); ++taken) {
+            f(std::move(_items.back()));
+            _items.pop_back();
+        }
+        return taken;
+    }
+
+    size_t size() const noexcept { return _items.size(); }
+    bool empty() const noexcept { return _items.empty(); }
+
+private:
+    std::deque< T > _items;
+};
+
+// How many offered I/Os a queue that took `own` of its own in this pass may steal: what is left of
+// the `batch` a queue serves at once
+inline uint32_t steal_quota(size_t const own, uint32_t const batch) noexcept {
+    return (batch > own) ? batch - static_cast< uint32_t >(own) : 0;
+}
+
+} // namespace ublkpp
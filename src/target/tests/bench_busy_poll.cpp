@@ -0,0 +1,110 @@
+// Per-I/O latency of a ublk target at low queue depth, with its queue sleeping, busy-polling a
+// fixed window, and busy-polling an adaptive one.
+//
+// One load thread reads a null disk through the ublk block device, so the latency is that of the
+// daemon's queue path: with a sleeping queue every I/O pays the queue thread's wakeup. The target
+// runs one queue pinned to the first CPU of this process and the load thread the last one; give
+// the process two dedicated CPUs (taskset) for stable numbers. Each row runs in its own process.
+// Needs root and the ublk_drv module; not registered with ctest, run by hand:
+//
+//     bench_busy_poll [--seconds=5] [--iodepth=1] [--bs=4096] [--window_us=50]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/uuid/random_generator.hpp>
+#include <sisl/logging/logging.h>
+#include <sisl/options/options.h>
+
+#include "ublkpp/target.hpp"
+#include "bench_target.hpp"
+
+SISL_OPTION_GROUP(bench_busy_poll,
+                  (seconds, "", "seconds", "Seconds per row", ::cxxopts::value< uint32_t >()->default_value("5"),
+                   "<secs>"),
+                  (iodepth, "", "iodepth", "I/Os in flight", ::cxxopts::value< uint32_t >()->default_value("1"),
+                   "<depth>"),
+                  (bs, "", "bs", "Read size", ::cxxopts::value< uint32_t >()->default_value("4096"), "<bytes>"),
+                  (window_us, "", "window_us", "Spin window of the polling rows",
+                   ::cxxopts::value< uint32_t >()->default_value("50"), "<usecs>"),
+                  (bench_child, "", "bench_child", "Run a single row (set by the parent)", ::cxxopts::value< bool >(),
+                   ""))
+
+#define ENABLED_OPTIONS logging, ublkpp_tgt, bench_busy_poll
+
+SISL_OPTIONS_ENABLE(ENABLED_OPTIONS)
+SISL_LOGGING_INIT(ublksrv, UBLKPP_LOG_MODS)
+
+using namespace ublkpp;
+using namespace ublkpp::bench;
+
+namespace {
+double percentile_us(std::vector< uint32_t > const& sorted, double const p) {
+    if (sorted.empty()) return 0;
+    auto const i = std::min(sorted.size() - 1, static_cast< size_t >(p * static_cast< double >(sorted.size())));
+    return static_cast< double >(sorted[i]) / 1000;
+}
+
+// One row: a target polling as the command line says, read for --seconds
+int run_row() {
+    auto tgt = ublkpp_tgt::run(boost::uuids::random_generator()(), std::make_shared< NullDisk >());
+    if (!tgt) {
+        LOGERROR("Could not start target: {}", tgt.error().message())
+        return EXIT_FAILURE;
+    }
+    auto const dev = tgt.value()->device_path().native();
+    wait_for_node(dev);
+
+    auto const cpus = allowed_cpus();
+    auto stop = std::atomic< bool >{false};
+    auto result = job_result{};
+    auto const proc_start = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+    auto const start = std::chrono::steady_clock::now();
+    auto const depth = SISL_OPTIONS["iodepth"].as< uint32_t >();
+    auto const bs = SISL_OPTIONS["bs"].as< uint32_t >();
+    auto load = std::thread([&] { result = read_job(dev, cpus.back(), depth, bs, stop, true); });
+    std::this_thread::sleep_for(std::chrono::seconds(SISL_OPTIONS["seconds"].as< uint32_t >()));
+    stop.store(true, std::memory_order_relaxed);
+    load.join();
+    auto const secs = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+    auto const daemon_ns = clock_ns(CLOCK_PROCESS_CPUTIME_ID) - proc_start - result.cpu_ns;
+
+    std::ranges::sort(result.latency_ns);
+    auto const poll_us = SISL_OPTIONS["busy_poll_us"].as< uint32_t >();
+    auto mode = std::string("sleep");
+    if (0 < poll_us)
+        mode = (0 < SISL_OPTIONS["busy_poll_adaptive"].count()) ? fmt::format("adaptive <= {}us", poll_us)
+                                                                : fmt::format("spin {}us", poll_us);
+    fmt::print("{:<18} {:>10.0f} {:>10.1f} {:>10.1f} {:>10.1f} {:>14.2f}\n", mode,
+               static_cast< double >(result.ios) / secs, percentile_us(result.latency_ns, 0.5),
+               percentile_us(result.latency_ns, 0.99), percentile_us(result.latency_ns, 0.999),
+               static_cast< double >(daemon_ns) / 1e9 / secs);
+    ublkpp_tgt::remove(std::move(tgt.value()));
+    return EXIT_SUCCESS;
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SISL_OPTIONS_LOAD(argc, argv, ENABLED_OPTIONS);
+    sisl::logging::SetLogger(std::string(argv[0]));
+    spdlog::set_pattern("[%D %T.%e] [%n] [%^%l%$] [%t] %v");
+
+    if (0 < SISL_OPTIONS["bench_child"].count()) return run_row();
+
+    fmt::print("{:<18} {:>10} {:>10} {:>10} {:>10} {:>14}   (qd {}, {}s per row)\n", "queue", "IOPS", "p50 us",
+               "p99 us", "p99.9 us", "daemon CPUs", SISL_OPTIONS["iodepth"].as< uint32_t >(),
+               SISL_OPTIONS["seconds"].as< uint32_t >());
+    auto const window = fmt::format("--busy_poll_us={}", SISL_OPTIONS["window_us"].as< uint32_t >());
+    auto const rows = std::vector< std::vector< std::string > >{
+        {"--busy_poll_us=0"}, {window}, {window, "--busy_poll_adaptive"}};
+    for (auto row : rows) {
+        row.insert(row.end(), {"--nr_hw_queues=1", "--pin_queues", "--bench_child"});
+        if (auto const rc = rerun(argc, argv, row); EXIT_SUCCESS != rc) return rc;
+    }
+    return 0;
+}
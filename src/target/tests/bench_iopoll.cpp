@@ -0,0 +1,127 @@
+// Per-I/O latency at low queue depth of an NVMe device read through a ublk target, with backend
+// completions taken by interrupt and by polling (--iopoll), against reading the device itself.
+//
+// One load thread reads --dev directly, then through a target over an FSDisk of it. The target
+// runs one queue pinned to the first CPU of this process and the load thread the last one; give
+// the process two dedicated CPUs (taskset) for stable numbers. The device is only read, at random
+// offsets within its first 16 GiB. Polling needs NVMe poll queues (nvme.poll_queues=N); without
+// them the --iopoll row runs as the interrupt one. Each row runs in its own process. Needs root
+// and the ublk_drv module; not registered with ctest, run by hand:
+//
+//     bench_iopoll --dev=/dev/nvme0n1 [--seconds=5] [--iodepth=1] [--bs=4096]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/uuid/random_generator.hpp>
+#include <sisl/logging/logging.h>
+#include <sisl/options/options.h>
+
+#include "ublkpp/drivers.hpp"
+#include "ublkpp/target.hpp"
+#include "bench_target.hpp"
+
+SISL_OPTION_GROUP(bench_iopoll,
+                  (dev, "", "dev", "NVMe block device to read", ::cxxopts::value< std::string >(), "<path>"),
+                  (seconds, "", "seconds", "Seconds per row", ::cxxopts::value< uint32_t >()->default_value("5"),
+                   "<secs>"),
+                  (iodepth, "", "iodepth", "I/Os in flight", ::cxxopts::value< uint32_t >()->default_value("1"),
+                   "<depth>"),
+                  (bs, "", "bs", "Read size", ::cxxopts::value< uint32_t >()->default_value("4096"), "<bytes>"),
+                  (direct, "", "direct", "Read --dev itself (set by the parent)", ::cxxopts::value< bool >(), ""),
+                  (bench_child, "", "bench_child", "Run a single row (set by the parent)", ::cxxopts::value< bool >(),
+                   ""))
+
+#define ENABLED_OPTIONS logging, ublkpp_tgt, bench_iopoll
+
+SISL_OPTIONS_ENABLE(ENABLED_OPTIONS)
+SISL_LOGGING_INIT(ublksrv, UBLKPP_LOG_MODS)
+
+using namespace ublkpp;
+using namespace ublkpp::bench;
+
+namespace {
+double percentile_us(std::vector< uint32_t > const& sorted, double const p) {
+    if (sorted.empty()) return 0;
+    auto const i = std::min(sorted.size() - 1, static_cast< size_t >(p * static_cast< double >(sorted.size())));
+    return static_cast< double >(sorted[i]) / 1000;
+}
+
+// One row: --dev read for --seconds, directly or through a target completing as the command line says
+int run_row() {
+    auto const backing = SISL_OPTIONS["dev"].as< std::string >();
+    auto const direct = 0 < SISL_OPTIONS["direct"].count();
+    auto dev = backing;
+    auto target = std::unique_ptr< ublkpp_tgt >();
+    if (!direct) {
+        auto disk = make_fs_disk(backing);
+        if (k_capacity > disk->capacity()) {
+            LOGERROR("{} is smaller than {} GiB", backing, k_capacity / Gi)
+            return EXIT_FAILURE;
+        }
+        if (!disk->direct_io()) {
+            LOGERROR("{} does not take O_DIRECT I/O", backing)
+            return EXIT_FAILURE;
+        }
+        auto tgt = ublkpp_tgt::run(boost::uuids::random_generator()(), disk);
+        if (!tgt) {
+            LOGERROR("Could not start target: {}", tgt.error().message())
+            return EXIT_FAILURE;
+        }
+        target = std::move(tgt.value());
+        dev = target->device_path().native();
+        wait_for_node(dev);
+    }
+
+    auto const cpus = allowed_cpus();
+    auto stop = std::atomic< bool >{false};
+    auto result = job_result{};
+    auto const proc_start = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+    auto const start = std::chrono::steady_clock::now();
+    auto const depth = SISL_OPTIONS["iodepth"].as< uint32_t >();
+    auto const bs = SISL_OPTIONS["bs"].as< uint32_t >();
+    auto load = std::thread([&] { result = read_job(dev, cpus.back(), depth, bs, stop, true); });
+    std::this_thread::sleep_for(std::chrono::seconds(SISL_OPTIONS["seconds"].as< uint32_t >()));
+    stop.store(true, std::memory_order_relaxed);
+    load.join();
+    auto const secs = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+    auto const daemon_ns = clock_ns(CLOCK_PROCESS_CPUTIME_ID) - proc_start - result.cpu_ns;
+
+    std::ranges::sort(result.latency_ns);
+    auto mode = std::string("device");
+    if (!direct) mode = (0 < SISL_OPTIONS["iopoll"].count()) ? "ublk, iopoll" : "ublk, interrupt";
+    fmt::print("{:<16} {:>10.0f} {:>10.1f} {:>10.1f} {:>10.1f} {:>14.2f}\n", mode,
+               static_cast< double >(result.ios) / secs, percentile_us(result.latency_ns, 0.5),
+               percentile_us(result.latency_ns, 0.99), percentile_us(result.latency_ns, 0.999),
+               static_cast< double >(daemon_ns) / 1e9 / secs);
+    if (target) ublkpp_tgt::remove(std::move(target));
+    return EXIT_SUCCESS;
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SISL_OPTIONS_LOAD(argc, argv, ENABLED_OPTIONS);
+    sisl::logging::SetLogger(std::string(argv[0]));
+    spdlog::set_pattern("[%D %T.%e] [%n] [%^%l%$] [%t] %v");
+
+    if (0 == SISL_OPTIONS["dev"].count()) {
+        LOGERROR("--dev is required")
+        return EXIT_FAILURE;
+    }
+    if (0 < SISL_OPTIONS["bench_child"].count()) return run_row();
+
+    fmt::print("{:<16} {:>10} {:>10} {:>10} {:>10} {:>14}   (qd {}, {}s per row)\n", "reads", "IOPS", "p50 us",
+               "p99 us", "p99.9 us", "daemon CPUs", SISL_OPTIONS["iodepth"].as< uint32_t >(),
+               SISL_OPTIONS["seconds"].as< uint32_t >());
+    auto const rows = std::vector< std::vector< std::string > >{{"--direct"}, {}, {"--iopoll"}};
+    for (auto row : rows) {
+        row.insert(row.end(), {"--nr_hw_queues=1", "--pin_queues", "--bench_child"});
+        if (auto const rc = rerun(argc, argv, row); EXIT_SUCCESS != rc) return rc;
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Sequential small-block writes through a ublk target with and without --plug_merge: the
+// requests the load issues against the I/Os the disk is handed for them.
+//
+// One load thread writes a null disk through the ublk block device, each write starting where
+// the one before ended and those that complete together resubmitted as one batch. The null disk
+// counts its async_iov() calls, so "disk I/Os/req" below 1 is the merging at work. The queue runs
+// on the first CPU of this process and the load thread on the last. Each row runs in its own
+// process. Needs root and the ublk_drv module; not registered with ctest, run by hand:
+//
+//     bench_plug [--seconds=5] [--iodepth=32] [--bs=4096]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/uuid/random_generator.hpp>
+#include <sisl/logging/logging.h>
+#include <sisl/options/options.h>
+
+#include "ublkpp/target.hpp"
+#include "bench_target.hpp"
+
+SISL_OPTION_GROUP(bench_plug,
+                  (seconds, "", "seconds", "Seconds per row", ::cxxopts::value< uint32_t >()->default_value("5"),
+                   "<secs>"),
+                  (iodepth, "", "iodepth", "I/Os in flight", ::cxxopts::value< uint32_t >()->default_value("32"),
+                   "<depth>"),
+                  (bs, "", "bs", "Write size", ::cxxopts::value< uint32_t >()->default_value("4096"), "<bytes>"),
+                  (bench_child, "", "bench_child", "Run a single row (set by the parent)", ::cxxopts::value< bool >(),
+                   ""))
+
+#define ENABLED_OPTIONS logging, ublkpp_tgt, bench_plug
+
+SISL_OPTIONS_ENABLE(ENABLED_OPTIONS)
+SISL_LOGGING_INIT(ublksrv, UBLKPP_LOG_MODS)
+
+using namespace ublkpp;
+using namespace ublkpp::bench;
+
+namespace {
+// One row: a target plugging as the command line says, written for --seconds
+int run_row() {
+    auto disk = std::make_shared< NullDisk >();
+    auto tgt = ublkpp_tgt::run(boost::uuids::random_generator()(), disk);
+    if (!tgt) {
+        LOGERROR("Could not start target: {}", tgt.error().message())
+        return EXIT_FAILURE;
+    }
+    auto const dev = tgt.value()->device_path().native();
+    wait_for_node(dev);
+
+    auto const cpus = allowed_cpus();
+    auto stop = std::atomic< bool >{false};
+    auto result = job_result{};
+    auto const depth = SISL_OPTIONS["iodepth"].as< uint32_t >();
+    auto const bs = SISL_OPTIONS["bs"].as< uint32_t >();
+    auto const calls_start = disk->calls();
+    auto const proc_start = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+    auto const start = std::chrono::steady_clock::now();
+    auto load = std::thread(
+        [&] { result = io_job(dev, cpus.back(), std::max(1U, depth), bs, stop, io_pattern::SEQUENTIAL_WRITE); });
+    std::this_thread::sleep_for(std::chrono::seconds(SISL_OPTIONS["seconds"].as< uint32_t >()));
+    stop.store(true, std::memory_order_relaxed);
+    load.join();
+    auto const secs = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+    auto const daemon_ns = clock_ns(CLOCK_PROCESS_CPUTIME_ID) - proc_start - result.cpu_ns;
+    auto const calls = disk->calls() - calls_start;
+
+    auto const ios = static_cast< double >(std::max(1UL, result.ios));
+    fmt::print("{:<8} {:>10.0f} {:>10.1f} {:>16.0f} {:>16.3f} {:>14.0f}\n",
+               (0 < SISL_OPTIONS["plug_merge"].count()) ? "plug" : "no plug", static_cast< double >(result.ios) / secs,
+               static_cast< double >(result.ios) * bs / secs / (1 << 20), static_cast< double >(calls) / secs,
+               static_cast< double >(calls) / ios, static_cast< double >(daemon_ns) / ios);
+    ublkpp_tgt::remove(std::move(tgt.value()));
+    return EXIT_SUCCESS;
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SISL_OPTIONS_LOAD(argc, argv, ENABLED_OPTIONS);
+    sisl::logging::SetLogger(std::string(argv[0]));
+    spdlog::set_pattern("[%D %T.%e] [%n] [%^%l%$] [%t] %v");
+
+    if (0 < SISL_OPTIONS["bench_child"].count()) return run_row();
+
+    fmt::print("{:<8} {:>10} {:>10} {:>16} {:>16} {:>14}   (qd {}, {}B writes, {}s per row)\n", "queue", "IOPS",
+               "MiB/s", "disk I/Os per s", "disk I/Os/req", "daemon ns/req", SISL_OPTIONS["iodepth"].as< uint32_t >(),
+               SISL_OPTIONS["bs"].as< uint32_t >(), SISL_OPTIONS["seconds"].as< uint32_t >());
+    auto const rows = std::vector< std::vector< std::string > >{{}, {"--plug_merge"}};
+    for (auto row : rows) {
+        row.insert(row.end(), {"--nr_hw_queues=1", "--pin_queues", "--bench_child"});
+        if (auto const rc = rerun(argc, argv, row); EXIT_SUCCESS != rc) return rc;
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+// Random-read IOPS of a ublk target as its queue count grows from 1 to one per CPU.
+//
+// The target exposes a null disk whose I/O completes without touching storage, so what scales
+// is the daemon's queue path. --jobs threads (by default one per CPU this process may use, each
+// pinned to it) read the ublk block device with O_DIRECT through their own io_uring. Every row
+// runs in a fresh process, this binary re-executed with --nr_hw_queues=<n>, since the target
+// reads its options once; the last row is --nr_hw_queues=0, the automatic per-CPU layout with
+// pinned queues. Daemon CPU is the process's CPU time less that of the load threads. Needs root
+// and the ublk_drv module; not registered with ctest, run by hand:
+//
+//     bench_queue_scaling [--seconds=5] [--jobs=<cpus>] [--iodepth=32] [--bs=4096] [--pin_queues]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/uuid/random_generator.hpp>
+#include <sisl/logging/logging.h>
+#include <sisl/options/options.h>
+
+#include "ublkpp/target.hpp"
+#include "bench_target.hpp"
+
+SISL_OPTION_GROUP(bench_queue_scaling,
+                  (seconds, "", "seconds", "Seconds per row", ::cxxopts::value< uint32_t >()->default_value("5"),
+                   "<secs>"),
+                  (jobs, "", "jobs", "Load threads; 0 for one per CPU",
+                   ::cxxopts::value< uint32_t >()->default_value("0"), "<count>"),
+                  (iodepth, "", "iodepth", "I/Os in flight per load thread",
+                   ::cxxopts::value< uint32_t >()->default_value("32"), "<depth>"),
+                  (bs, "", "bs", "Read size", ::cxxopts::value< uint32_t >()->default_value("4096"), "<bytes>"),
+                  (bench_child, "", "bench_child", "Run a single row (set by the parent)", ::cxxopts::value< bool >(),
+                   ""))
+
+#define ENABLED_OPTIONS logging, ublkpp_tgt, bench_queue_scaling
+
+SISL_OPTIONS_ENABLE(ENABLED_OPTIONS)
+SISL_LOGGING_INIT(ublksrv, UBLKPP_LOG_MODS)
+
+using namespace ublkpp;
+using namespace ublkpp::bench;
+
+namespace {
+// One row: a target with the queues given on the command line, loaded for --seconds
+int run_row() {
+    auto tgt = ublkpp_tgt::run(boost::uuids::random_generator()(), std::make_shared< NullDisk >());
+    if (!tgt) {
+        LOGERROR("Could not start target: {}", tgt.error().message())
+        return EXIT_FAILURE;
+    }
+    auto const dev = tgt.value()->device_path().native();
+    wait_for_node(dev);
+
+    auto cpus = allowed_cpus();
+    auto const jobs = (0 < SISL_OPTIONS["jobs"].as< uint32_t >()) ? SISL_OPTIONS["jobs"].as< uint32_t >()
+                                                                   : static_cast< uint32_t >(cpus.size());
+    auto const depth = SISL_OPTIONS["iodepth"].as< uint32_t >();
+    auto const bs = SISL_OPTIONS["bs"].as< uint32_t >();
+    auto stop = std::atomic< bool >{false};
+    auto results = std::vector< job_result >(jobs);
+    auto threads = std::vector< std::thread >();
+
+    auto const proc_start = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+    auto const start = std::chrono::steady_clock::now();
+    for (auto j = 0U; jobs > j; ++j)
+        threads.emplace_back([&, j] { results[j] = read_job(dev, cpus[j % cpus.size()], depth, bs, stop); });
+    std::this_thread::sleep_for(std::chrono::seconds(SISL_OPTIONS["seconds"].as< uint32_t >()));
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& t : threads)
+        t.join();
+    auto const secs = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+    auto const proc_ns = clock_ns(CLOCK_PROCESS_CPUTIME_ID) - proc_start;
+
+    auto const ios =
+        std::accumulate(results.begin(), results.end(), 0UL, [](auto a, auto const& r) { return a + r.ios; });
+    auto const load_ns =
+        std::accumulate(results.begin(), results.end(), 0UL, [](auto a, auto const& r) { return a + r.cpu_ns; });
+    auto const queues = SISL_OPTIONS["nr_hw_queues"].as< uint16_t >();
+    fmt::print("{:<10} {:>12.0f} {:>16.0f} {:>18.2f}\n", (0 == queues) ? "auto" : std::to_string(queues),
+               static_cast< double >(ios) / secs, static_cast< double >(proc_ns - load_ns) / std::max(1UL, ios),
+               static_cast< double >(proc_ns - load_ns) / 1e9 / secs);
+    ublkpp_tgt::remove(std::move(tgt.value()));
+    return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SISL_OPTIONS_LOAD(argc, argv, ENABLED_OPTIONS);
+    sisl::logging::SetLogger(std::string(argv[0]));
+    spdlog::set_pattern("[%D %T.%e] [%n] [%^%l%$] [%t] %v");
+
+    if (0 < SISL_OPTIONS["bench_child"].count()) return run_row();
+
+    auto const nr_cpus = static_cast< uint32_t >(allowed_cpus().size());
+    fmt::print("{:<10} {:>12} {:>16} {:>18}   ({} CPUs, {}s per row)\n", "queues", "IOPS", "daemon ns/IO",
+               "daemon CPUs busy", nr_cpus, SISL_OPTIONS["seconds"].as< uint32_t >());
+    auto counts = std::vector< uint32_t >();
+    for (auto n = 1U; nr_cpus > n; n *= 2)
+        counts.push_back(n);
+    counts.push_back(nr_cpus);
+    counts.push_back(0);
+    for (auto const n : counts)
+        if (auto const rc = rerun(argc, argv, {fmt::format("--nr_hw_queues={}", n), "--bench_child"});
+            EXIT_SUCCESS != rc)
+            return rc;
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Many lightly loaded ublk targets served by a thread per queue, and by shared reactors
+// (--shared_reactors): the threads, context switches and memory the daemon needs for them.
+//
+// --targets targets each expose a null disk with one queue and are read at --iodepth by a load
+// thread of their own, the load threads spread over the CPUs of this process. Threads are those of
+// the process less the load threads; context switches are those of the whole process, load threads
+// included, so compare rows rather than read them alone. Each row runs in its own process. Needs
+// root and the ublk_drv module; not registered with ctest, run by hand:
+//
+//     bench_reactor [--seconds=5] [--targets=64] [--iodepth=1] [--bs=4096]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <boost/uuid/random_generator.hpp>
+#include <sisl/logging/logging.h>
+#include <sisl/options/options.h>
+
+#include "ublkpp/target.hpp"
+#include "bench_target.hpp"
+
+SISL_OPTION_GROUP(bench_reactor,
+                  (seconds, "", "seconds", "Seconds per row", ::cxxopts::value< uint32_t >()->default_value("5"),
+                   "<secs>"),
+                  (targets, "", "targets", "Targets to run", ::cxxopts::value< uint32_t >()->default_value("64"),
+                   "<count>"),
+                  (iodepth, "", "iodepth", "I/Os in flight per target",
+                   ::cxxopts::value< uint32_t >()->default_value("1"), "<depth>"),
+                  (bs, "", "bs", "Read size", ::cxxopts::value< uint32_t >()->default_value("4096"), "<bytes>"),
+                  (bench_child, "", "bench_child", "Run a single row (set by the parent)", ::cxxopts::value< bool >(),
+                   ""))
+
+#define ENABLED_OPTIONS logging, ublkpp_tgt, bench_reactor
+
+SISL_OPTIONS_ENABLE(ENABLED_OPTIONS)
+SISL_LOGGING_INIT(ublksrv, UBLKPP_LOG_MODS)
+
+using namespace ublkpp;
+using namespace ublkpp::bench;
+
+namespace {
+uint64_t context_switches() {
+    auto usage = rusage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast< uint64_t >(usage.ru_nvcsw + usage.ru_nivcsw);
+}
+
+uint64_t process_threads() {
+    auto const tasks = std::filesystem::directory_iterator("/proc/self/task");
+    return static_cast< uint64_t >(std::distance(begin(tasks), end(tasks)));
+}
+
+// One row: --targets targets served as the command line says, each loaded for --seconds
+int run_row() {
+    auto const count = std::max(1U, SISL_OPTIONS["targets"].as< uint32_t >());
+    auto targets = std::vector< std::unique_ptr< ublkpp_tgt > >();
+    for (auto t = 0U; count > t; ++t) {
+        auto tgt = ublkpp_tgt::run(boost::uuids::random_generator()(), std::make_shared< NullDisk >());
+        if (!tgt) {
+            LOGERROR("Could not start target {}: {}", t, tgt.error().message())
+            return EXIT_FAILURE;
+        }
+        targets.push_back(std::move(tgt.value()));
+    }
+    for (auto const& tgt : targets)
+        wait_for_node(tgt->device_path().native());
+    auto const daemon_threads = process_threads() - 1;
+
+    auto const cpus = allowed_cpus();
+    auto const depth = std::max(1U, SISL_OPTIONS["iodepth"].as< uint32_t >());
+    auto const bs = SISL_OPTIONS["bs"].as< uint32_t >();
+    auto stop = std::atomic< bool >{false};
+    auto results = std::vector< job_result >(count);
+    auto threads = std::vector< std::thread >();
+
+    auto const switches_start = context_switches();
+    auto const proc_start = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+    auto const start = std::chrono::steady_clock::now();
+    for (auto t = 0U; count > t; ++t)
+        threads.emplace_back([&, t] {
+            results[t] = read_job(targets[t]->device_path().native(), cpus[t % cpus.size()], depth, bs, stop);
+        });
+    std::this_thread::sleep_for(std::chrono::seconds(SISL_OPTIONS["seconds"].as< uint32_t >()));
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& t : threads)
+        t.join();
+    auto const secs = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+    auto const proc_ns = clock_ns(CLOCK_PROCESS_CPUTIME_ID) - proc_start;
+    auto const switches = context_switches() - switches_start;
+
+    auto const ios =
+        std::accumulate(results.begin(), results.end(), 0UL, [](auto a, auto const& r) { return a + r.ios; });
+    auto const load_ns =
+        std::accumulate(results.begin(), results.end(), 0UL, [](auto a, auto const& r) { return a + r.cpu_ns; });
+    auto usage = rusage{};
+    getrusage(RUSAGE_SELF, &usage);
+    fmt::print("{:<10} {:>8} {:>12.0f} {:>14.0f} {:>16.0f} {:>12.3f} {:>10}\n",
+               (0 < SISL_OPTIONS["shared_reactors"].count()) ? "reactors" : "threads", daemon_threads,
+               static_cast< double >(ios) / secs, static_cast< double >(proc_ns - load_ns) / std::max(1UL, ios),
+               static_cast< double >(switches) / secs,
+               static_cast< double >(switches) / static_cast< double >(std::max(1UL, ios)), usage.ru_maxrss);
+    for (auto& tgt : targets)
+        ublkpp_tgt::remove(std::move(tgt));
+    return EXIT_SUCCESS;
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SISL_OPTIONS_LOAD(argc, argv, ENABLED_OPTIONS);
+    sisl::logging::SetLogger(std::string(argv[0]));
+    spdlog::set_pattern("[%D %T.%e] [%n] [%^%l%$] [%t] %v");
+
+    if (0 < SISL_OPTIONS["bench_child"].count()) return run_row();
+
+    fmt::print("{:<10} {:>8} {:>12} {:>14} {:>16} {:>12} {:>10}   ({} targets, qd {}, {}s per row)\n", "queues",
+               "threads", "IOPS", "daemon ns/IO", "ctx switches/s", "switches/IO", "max RSS KiB",
+               SISL_OPTIONS["targets"].as< uint32_t >(), SISL_OPTIONS["iodepth"].as< uint32_t >(),
+               SISL_OPTIONS["seconds"].as< uint32_t >());
+    auto const rows = std::vector< std::vector< std::string > >{{}, {"--shared_reactors"}};
+    for (auto row : rows) {
+        row.insert(row.end(), {"--nr_hw_queues=1", "--bench_child"});
+        if (auto const rc = rerun(argc, argv, row); EXIT_SUCCESS != rc) return rc;
+    }
+    return 0;
+}
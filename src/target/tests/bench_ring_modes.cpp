@@ -0,0 +1,166 @@
+// Syscalls and latency per I/O of a ublk target for each io_uring setup of its queue ring
+// (--ring_mode), with and without a registered ring fd (--ring_fd).
+//
+// One load thread reads a null disk through the ublk block device. io_uring_enter(2) calls are
+// counted with a perf tracepoint counter on syscalls:sys_enter_io_uring_enter, opened before the
+// target starts so its queue threads inherit it; those of the load thread are taken out, leaving
+// the daemon's. The column shows "-" where tracepoints are not readable (tracefs not mounted, or
+// perf_event_paranoid). The queue runs on the first CPU of this process and the load thread on
+// the last; an SQPOLL ring's kernel thread runs where the scheduler puts it. Each row runs in its
+// own process. Needs root and the ublk_drv module; not registered with ctest, run by hand:
+//
+//     bench_ring_modes [--seconds=5] [--iodepth=1,32] [--bs=4096]
+extern "C" {
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+}
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/uuid/random_generator.hpp>
+#include <sisl/logging/logging.h>
+#include <sisl/options/options.h>
+
+#include "ublkpp/target.hpp"
+#include "bench_target.hpp"
+
+SISL_OPTION_GROUP(bench_ring_modes,
+                  (seconds, "", "seconds", "Seconds per row", ::cxxopts::value< uint32_t >()->default_value("5"),
+                   "<secs>"),
+                  (iodepth, "", "iodepth", "I/Os in flight, one row set per depth",
+                   ::cxxopts::value< std::vector< uint32_t > >()->default_value("1,32"), "<depth,...>"),
+                  (bs, "", "bs", "Read size", ::cxxopts::value< uint32_t >()->default_value("4096"), "<bytes>"),
+                  (bench_depth, "", "bench_depth", "Depth of a single row (set by the parent)",
+                   ::cxxopts::value< uint32_t >()->default_value("0"), "<depth>"))
+
+#define ENABLED_OPTIONS logging, ublkpp_tgt, bench_ring_modes
+
+SISL_OPTIONS_ENABLE(ENABLED_OPTIONS)
+SISL_LOGGING_INIT(ublksrv, UBLKPP_LOG_MODS)
+
+using namespace ublkpp;
+using namespace ublkpp::bench;
+
+namespace {
+// io_uring_enter(2) calls of the calling thread, and with `inherit` of the threads it starts
+// after; nullopt where the tracepoint cannot be opened
+class enter_counter {
+    int _fd{-1};
+
+    static std::optional< uint64_t > tracepoint_id() {
+        for (auto const* const root : {"/sys/kernel/tracing", "/sys/kernel/debug/tracing"}) {
+            auto id = uint64_t{0};
+            if (std::ifstream(fmt::format("{}/events/syscalls/sys_enter_io_uring_enter/id", root)) >> id) return id;
+        }
+        return std::nullopt;
+    }
+
+public:
+    explicit enter_counter(bool const inherit) {
+        auto const id = tracepoint_id();
+        if (!id) return;
+        auto attr = perf_event_attr{};
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.size = sizeof(attr);
+        attr.config = *id;
+        attr.inherit = inherit ? 1 : 0;
+        _fd = static_cast< int >(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+    enter_counter(enter_counter const&) = delete;
+    ~enter_counter() {
+        if (0 <= _fd) close(_fd);
+    }
+    // Inherited counts are summed in, live threads included
+    std::optional< uint64_t > read() const noexcept {
+        auto count = uint64_t{0};
+        if (0 > _fd || sizeof(count) != ::read(_fd, &count, sizeof(count))) return std::nullopt;
+        return count;
+    }
+};
+
+double percentile_us(std::vector< uint32_t > const& sorted, double const p) {
+    if (sorted.empty()) return 0;
+    auto const i = std::min(sorted.size() - 1, static_cast< size_t >(p * static_cast< double >(sorted.size())));
+    return static_cast< double >(sorted[i]) / 1000;
+}
+
+// One row: a target with the ring setup of the command line, read for --seconds
+int run_row() {
+    auto const all = enter_counter(true);
+    auto tgt = ublkpp_tgt::run(boost::uuids::random_generator()(), std::make_shared< NullDisk >());
+    if (!tgt) {
+        LOGERROR("Could not start target: {}", tgt.error().message())
+        return EXIT_FAILURE;
+    }
+    auto const dev = tgt.value()->device_path().native();
+    wait_for_node(dev);
+
+    auto const cpus = allowed_cpus();
+    auto stop = std::atomic< bool >{false};
+    auto result = job_result{};
+    auto load_enters = std::optional< uint64_t >();
+    auto const depth = SISL_OPTIONS["bench_depth"].as< uint32_t >();
+    auto const bs = SISL_OPTIONS["bs"].as< uint32_t >();
+    auto const enters_start = all.read();
+    auto const proc_start = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+    auto const start = std::chrono::steady_clock::now();
+    auto load = std::thread([&] {
+        auto const own = enter_counter(false);
+        result = read_job(dev, cpus.back(), depth, bs, stop, true);
+        load_enters = own.read();
+    });
+    std::this_thread::sleep_for(std::chrono::seconds(SISL_OPTIONS["seconds"].as< uint32_t >()));
+    stop.store(true, std::memory_order_relaxed);
+    load.join();
+    auto const secs = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+    auto const daemon_ns = clock_ns(CLOCK_PROCESS_CPUTIME_ID) - proc_start - result.cpu_ns;
+    auto const enters_end = all.read();
+
+    auto enters = std::string("-");
+    if (enters_start && enters_end && load_enters)
+        enters = fmt::format("{:.3f}", static_cast< double >(*enters_end - *enters_start - *load_enters) /
+                                           static_cast< double >(std::max(1UL, result.ios)));
+    std::ranges::sort(result.latency_ns);
+    auto mode = SISL_OPTIONS["ring_mode"].as< std::string >();
+    if (0 < SISL_OPTIONS["ring_fd"].count()) mode += " +fd";
+    fmt::print("{:<20} {:>4} {:>10.0f} {:>12} {:>10.1f} {:>10.1f} {:>14.2f}\n", mode, depth,
+               static_cast< double >(result.ios) / secs, enters, percentile_us(result.latency_ns, 0.5),
+               percentile_us(result.latency_ns, 0.99), static_cast< double >(daemon_ns) / 1e9 / secs);
+    ublkpp_tgt::remove(std::move(tgt.value()));
+    return EXIT_SUCCESS;
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SISL_OPTIONS_LOAD(argc, argv, ENABLED_OPTIONS);
+    sisl::logging::SetLogger(std::string(argv[0]));
+    spdlog::set_pattern("[%D %T.%e] [%n] [%^%l%$] [%t] %v");
+
+    if (0 < SISL_OPTIONS["bench_depth"].as< uint32_t >()) return run_row();
+
+    fmt::print("{:<20} {:>4} {:>10} {:>12} {:>10} {:>10} {:>14}   ({}s per row)\n", "ring", "qd", "IOPS",
+               "enters/IO", "p50 us", "p99 us", "daemon CPUs", SISL_OPTIONS["seconds"].as< uint32_t >());
+    for (auto const depth : SISL_OPTIONS["iodepth"].as< std::vector< uint32_t > >()) {
+        for (auto const* const mode : {"coop_taskrun", "defer_taskrun", "sqpoll"}) {
+            for (auto const fd : {false, true}) {
+                auto row = std::vector< std::string >{fmt::format("--ring_mode={}", mode),
+                                                      fmt::format("--bench_depth={}", std::max(1U, depth)),
+                                                      "--nr_hw_queues=1", "--pin_queues"};
+                if (fd) row.emplace_back("--ring_fd");
+                if (auto const rc = rerun(argc, argv, row); EXIT_SUCCESS != rc) return rc;
+            }
+        }
+    }
+    return 0;
+}
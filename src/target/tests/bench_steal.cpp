@@ -0,0 +1,134 @@
+// Random-read IOPS and tail latency of a ublk target whose load all lands on one of its queues,
+// with and without work stealing (--steal_io).
+//
+// The target has a queue per CPU (--nr_hw_queues=0) and exposes a disk that spins --work_ns of CPU
+// in each I/O before completing it, standing in for a stack whose I/O costs the queue thread real
+// work (checksums, RAID bookkeeping). In the skewed rows every load thread runs on the first CPU
+// this process may use, so blk-mq hands every request to that CPU's queue; the spread row runs them
+// one per CPU for reference. Each row runs in its own process. Needs root and the ublk_drv module;
+// not registered with ctest, run by hand:
+//
+//     bench_steal [--seconds=5] [--jobs=4] [--iodepth=32] [--bs=4096] [--work_ns=5000] [--steal_batch=8]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/uuid/random_generator.hpp>
+#include <sisl/logging/logging.h>
+#include <sisl/options/options.h>
+
+#include "ublkpp/target.hpp"
+#include "target/busy_poll.hpp"
+#include "bench_target.hpp"
+
+SISL_OPTION_GROUP(bench_steal,
+                  (seconds, "", "seconds", "Seconds per row", ::cxxopts::value< uint32_t >()->default_value("5"),
+                   "<secs>"),
+                  (jobs, "", "jobs", "Load threads", ::cxxopts::value< uint32_t >()->default_value("4"), "<count>"),
+                  (iodepth, "", "iodepth", "I/Os in flight per load thread",
+                   ::cxxopts::value< uint32_t >()->default_value("32"), "<depth>"),
+                  (bs, "", "bs", "Read size", ::cxxopts::value< uint32_t >()->default_value("4096"), "<bytes>"),
+                  (work_ns, "", "work_ns", "CPU each I/O costs the queue thread serving it",
+                   ::cxxopts::value< uint32_t >()->default_value("5000"), "<ns>"),
+                  (skewed, "", "skewed", "Run every load thread on one CPU (set by the parent)",
+                   ::cxxopts::value< bool >(), ""),
+                  (bench_child, "", "bench_child", "Run a single row (set by the parent)", ::cxxopts::value< bool >(),
+                   ""))
+
+#define ENABLED_OPTIONS logging, ublkpp_tgt, bench_steal
+
+SISL_OPTIONS_ENABLE(ENABLED_OPTIONS)
+SISL_LOGGING_INIT(ublksrv, UBLKPP_LOG_MODS)
+
+using namespace ublkpp;
+using namespace ublkpp::bench;
+
+namespace {
+// A NullDisk whose every I/O first spins for `work_ns` on the thread serving it
+class BusyDisk : public NullDisk {
+    uint64_t const _work_ns;
+
+public:
+    explicit BusyDisk(uint64_t const work_ns) : _work_ns(work_ns) {}
+    std::string id() const noexcept override { return "BusyDisk"; }
+    disk_task< int > async_iov(ublksrv_queue const* q, ublk_io_data const* data, iovec* iovecs, uint32_t nr_vecs,
+                               uint64_t addr) override {
+        auto const until = clock_ns(CLOCK_MONOTONIC) + _work_ns;
+        while (clock_ns(CLOCK_MONOTONIC) < until)
+            cpu_relax();
+        return NullDisk::async_iov(q, data, iovecs, nr_vecs, addr);
+    }
+};
+
+// One row: the target the command line asks for, read by --jobs threads for --seconds
+int run_row() {
+    auto tgt = ublkpp_tgt::run(boost::uuids::random_generator()(),
+                               std::make_shared< BusyDisk >(SISL_OPTIONS["work_ns"].as< uint32_t >()));
+    if (!tgt) {
+        LOGERROR("Could not start target: {}", tgt.error().message())
+        return EXIT_FAILURE;
+    }
+    auto const dev = tgt.value()->device_path().native();
+    wait_for_node(dev);
+
+    auto const cpus = allowed_cpus();
+    auto const skewed = (0 < SISL_OPTIONS["skewed"].count());
+    auto const jobs = std::max(1U, SISL_OPTIONS["jobs"].as< uint32_t >());
+    auto const depth = SISL_OPTIONS["iodepth"].as< uint32_t >();
+    auto const bs = SISL_OPTIONS["bs"].as< uint32_t >();
+    auto stop = std::atomic< bool >{false};
+    auto results = std::vector< job_result >(jobs);
+    auto threads = std::vector< std::thread >();
+
+    auto const start = std::chrono::steady_clock::now();
+    for (auto j = 0U; jobs > j; ++j)
+        threads.emplace_back([&, j] {
+            results[j] = read_job(dev, cpus[skewed ? 0 : j % cpus.size()], depth, bs, stop, true);
+        });
+    std::this_thread::sleep_for(std::chrono::seconds(SISL_OPTIONS["seconds"].as< uint32_t >()));
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& t : threads)
+        t.join();
+    auto const secs = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+
+    auto latencies = std::vector< uint32_t >();
+    for (auto const& r : results)
+        latencies.insert(latencies.end(), r.latency_ns.begin(), r.latency_ns.end());
+    auto const pct = [&](double const p) {
+        if (latencies.empty()) return 0.0;
+        auto const at = latencies.begin() + static_cast< ptrdiff_t >(p * static_cast< double >(latencies.size() - 1));
+        std::nth_element(latencies.begin(), at, latencies.end());
+        return static_cast< double >(*at) / 1000.0;
+    };
+    fmt::print("{:<10} {:<10} {:>12.0f} {:>12.1f} {:>12.1f}\n", skewed ? "skewed" : "spread",
+               (0 < SISL_OPTIONS["steal_io"].count()) ? "steal" : "-", static_cast< double >(latencies.size()) / secs,
+               pct(0.50), pct(0.99));
+    ublkpp_tgt::remove(std::move(tgt.value()));
+    return EXIT_SUCCESS;
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SISL_OPTIONS_LOAD(argc, argv, ENABLED_OPTIONS);
+    sisl::logging::SetLogger(std::string(argv[0]));
+    spdlog::set_pattern("[%D %T.%e] [%n] [%^%l%$] [%t] %v");
+
+    if (0 < SISL_OPTIONS["bench_child"].count()) return run_row();
+
+    fmt::print("{:<10} {:<10} {:>12} {:>12} {:>12}   ({} CPUs, {} jobs at qd {}, {} ns/IO, {}s per row)\n", "load",
+               "queues", "IOPS", "p50 us", "p99 us", allowed_cpus().size(), SISL_OPTIONS["jobs"].as< uint32_t >(),
+               SISL_OPTIONS["iodepth"].as< uint32_t >(), SISL_OPTIONS["work_ns"].as< uint32_t >(),
+               SISL_OPTIONS["seconds"].as< uint32_t >());
+    auto const rows = std::vector< std::vector< std::string > >{{}, {"--skewed"}, {"--skewed", "--steal_io"}};
+    for (auto row : rows) {
+        row.insert(row.end(), {"--nr_hw_queues=0", "--bench_child"});
+        if (auto const rc = rerun(argc, argv, row); EXIT_SUCCESS != rc) return rc;
+    }
+    return 0;
+}
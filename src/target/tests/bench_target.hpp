@@ -0,0 +1,176 @@
+#pragma once
+
+// Shared pieces of the target benchmarks: a null disk to expose, load threads reading the ublk
+// block device, and re-running the benchmark binary with other target options.
+extern "C" {
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+}
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <liburing.h>
+#include <sisl/logging/logging.h>
+
+#include "ublkpp/lib/ublk_disk.hpp"
+#include "lib/common.hpp"
+
+namespace ublkpp::bench {
+
+constexpr uint64_t k_capacity = 16 * Gi;
+
+// Completes every I/O at once with its full length, so only the daemon's queue path is measured.
+// Counts the I/Os it is handed.
+class NullDisk : public ublk_disk {
+    std::atomic< uint64_t > _calls{0};
+
+public:
+    NullDisk() { params()->basic.dev_sectors = k_capacity >> SECTOR_SHIFT; }
+    std::string id() const noexcept override { return "NullDisk"; }
+    bool scatter_gather() const noexcept override { return true; }
+    disk_task< int > async_iov(ublksrv_queue const*, ublk_io_data const*, iovec* iovecs, uint32_t nr_vecs,
+                               uint64_t) override {
+        _calls.fetch_add(1, std::memory_order_relaxed);
+        co_return static_cast< int >(length(iovecs, nr_vecs));
+    }
+    uint64_t calls() const noexcept { return _calls.load(std::memory_order_relaxed); }
+    io_result sync_iov(uint8_t, iovec* iovecs, uint32_t nr_vecs, off_t) noexcept override {
+        return length(iovecs, nr_vecs);
+    }
+
+private:
+    static uint64_t length(iovec const* iovecs, uint32_t nr_vecs) noexcept {
+        return std::accumulate(iovecs, iovecs + nr_vecs, 0UL, [](auto a, iovec const& v) { return a + v.iov_len; });
+    }
+};
+
+inline std::vector< int > allowed_cpus() {
+    auto set = cpu_set_t{};
+    CPU_ZERO(&set);
+    sched_getaffinity(0, sizeof(set), &set);
+    auto cpus = std::vector< int >();
+    for (auto cpu = 0; CPU_SETSIZE > cpu; ++cpu)
+        if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+    return cpus;
+}
+
+inline uint64_t clock_ns(clockid_t const clock) {
+    auto ts = timespec{};
+    clock_gettime(clock, &ts);
+    return static_cast< uint64_t >(ts.tv_sec) * 1000000000UL + static_cast< uint64_t >(ts.tv_nsec);
+}
+
+// Waits for the block device node, which may trail the target start
+inline void wait_for_node(std::string const& dev) {
+    for (auto i = 0; 100 > i && 0 != access(dev.c_str(), R_OK); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+struct job_result {
+    uint64_t ios{0};
+    uint64_t cpu_ns{0};
+    std::vector< uint32_t > latency_ns{}; // Per I/O, when asked for
+};
+
+enum class io_pattern : uint8_t { RANDOM_READ, SEQUENTIAL_WRITE };
+
+// I/Os of `bs` to `dev` on `cpu`, `depth` at a time, until `stop`: random aligned reads, or writes
+// each starting where the one before ended. Writes that complete together are resubmitted as one
+// batch, as writeback does, so the target sees runs of adjacent requests.
+inline job_result io_job(std::string const& dev, int const cpu, uint32_t const depth, uint32_t const bs,
+                         std::atomic< bool > const& stop, io_pattern const pattern, bool const latencies = false) {
+    auto set = cpu_set_t{};
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+    auto res = job_result{};
+    auto const writes = (io_pattern::SEQUENTIAL_WRITE == pattern);
+    auto const fd = open(dev.c_str(), (writes ? O_WRONLY : O_RDONLY) | O_DIRECT);
+    RELEASE_ASSERT_LE(0, fd, "cannot open {}", dev);
+    auto ring = io_uring{};
+    RELEASE_ASSERT_EQ(0, io_uring_queue_init(depth, &ring, 0), "io_uring_queue_init failed");
+    auto bufs = std::unique_ptr< uint8_t, decltype(&free) >(
+        static_cast< uint8_t* >(std::aligned_alloc(4 * Ki, static_cast< size_t >(depth) * bs)), &free);
+    auto issued = std::vector< uint64_t >(depth);
+    auto const slots = k_capacity / bs;
+    auto seq = static_cast< uint64_t >(cpu) << 32;
+    auto const submit = [&](uint64_t const slot) {
+        auto* sqe = io_uring_get_sqe(&ring);
+        if (writes)
+            io_uring_prep_write(sqe, fd, bufs.get() + slot * bs, bs, (seq++ % slots) * bs);
+        else
+            io_uring_prep_read(sqe, fd, bufs.get() + slot * bs, bs, ((seq++ * 2654435761ULL) % slots) * bs);
+        io_uring_sqe_set_data64(sqe, slot);
+        if (latencies) issued[slot] = clock_ns(CLOCK_MONOTONIC);
+    };
+
+    auto const start = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    for (auto slot = 0UL; depth > slot; ++slot)
+        submit(slot);
+    io_uring_submit(&ring);
+    auto inflight = depth;
+    while (0 < inflight) {
+        io_uring_cqe* cqe{};
+        if (0 > io_uring_wait_cqe(&ring, &cqe)) continue;
+        unsigned head{};
+        auto reaped = 0U;
+        io_uring_for_each_cqe(&ring, head, cqe) {
+            RELEASE_ASSERT_LE(0, cqe->res, "I/O failed");
+            auto const slot = io_uring_cqe_get_data64(cqe);
+            ++reaped;
+            ++res.ios;
+            if (latencies)
+                res.latency_ns.push_back(static_cast< uint32_t >(clock_ns(CLOCK_MONOTONIC) - issued[slot]));
+            if (stop.load(std::memory_order_relaxed))
+                --inflight;
+            else
+                submit(slot);
+            if (!writes) break;
+        }
+        io_uring_cq_advance(&ring, reaped);
+        io_uring_submit(&ring);
+    }
+    res.cpu_ns = clock_ns(CLOCK_THREAD_CPUTIME_ID) - start;
+    io_uring_queue_exit(&ring);
+    close(fd);
+    return res;
+}
+
+inline job_result read_job(std::string const& dev, int const cpu, uint32_t const depth, uint32_t const bs,
+                           std::atomic< bool > const& stop, bool const latencies = false) {
+    return io_job(dev, cpu, depth, bs, stop, io_pattern::RANDOM_READ, latencies);
+}
+
+// Runs this binary again with `extra` appended to its arguments and waits for it. Target options
+// are read once per process, so each configuration measured runs in its own.
+inline int rerun(int argc, char* argv[], std::vector< std::string > const& extra) {
+    auto args = std::vector< std::string >(argv, argv + argc);
+    args.insert(args.end(), extra.begin(), extra.end());
+    auto cargs = std::vector< char* >();
+    for (auto& a : args)
+        cargs.push_back(a.data());
+    cargs.push_back(nullptr);
+
+    auto const pid = fork();
+    if (0 == pid) {
+        execv("/proc/self/exe", cargs.data());
+        _exit(EXIT_FAILURE);
+    }
+    auto status = 0;
+    if (0 > pid || 0 > waitpid(pid, &status, 0)) return EXIT_FAILURE;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : EXIT_FAILURE;
+}
+
+} // namespace ublkpp::bench
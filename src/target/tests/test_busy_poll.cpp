@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include "target/busy_poll.hpp"
+
+using ublkpp::poll_window;
+
+static constexpr uint64_t k_max_ns = 50000;
+
+TEST(PollWindow, FixedWindowIgnoresGaps) {
+    auto w = poll_window(k_max_ns, false);
+    EXPECT_EQ(k_max_ns, w.window_ns());
+    for (auto i = 0; 100 > i; ++i)
+        w.observe(10 * k_max_ns);
+    EXPECT_EQ(k_max_ns, w.window_ns());
+}
+
+// Adaptive starts asleep and spins once completions keep coming back within reach
+TEST(PollWindow, AdaptiveFollowsShortGaps) {
+    auto w = poll_window(k_max_ns, true);
+    EXPECT_EQ(0U, w.window_ns());
+    for (auto i = 0; 64 > i; ++i)
+        w.observe(8000);
+    // About twice the average gap
+    EXPECT_LE(14000U, w.window_ns());
+    EXPECT_GE(16000U, w.window_ns());
+}
+
+TEST(PollWindow, AdaptiveCapsAtMax) {
+    auto w = poll_window(k_max_ns, true);
+    for (auto i = 0; 64 > i; ++i)
+        w.observe(k_max_ns);
+    EXPECT_EQ(k_max_ns, w.window_ns());
+}
+
+TEST(PollWindow, AdaptiveFloor) {
+    auto w = poll_window(k_max_ns, true);
+    for (auto i = 0; 64 > i; ++i)
+        w.observe(0);
+    EXPECT_EQ(poll_window::k_min_ns, w.window_ns());
+}
+
+// A queue that goes quiet stops spinning, and starts again when the traffic returns
+TEST(PollWindow, AdaptiveBacksOffWhenIdle) {
+    auto w = poll_window(k_max_ns, true);
+    for (auto i = 0; 64 > i; ++i)
+        w.observe(8000);
+    ASSERT_LT(0U, w.window_ns());
+    for (auto i = 0; 8 > i; ++i)
+        w.observe(20 * k_max_ns);
+    EXPECT_EQ(0U, w.window_ns());
+    for (auto i = 0; 16 > i; ++i)
+        w.observe(8000);
+    EXPECT_LT(0U, w.window_ns());
+}
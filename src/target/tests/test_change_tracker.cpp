@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include "ublkpp/lib/ublk_disk.hpp"
+#include "ublkpp/target_testing.hpp"
+#include "lib/common.hpp"
+#include "target/change_tracker.hpp"
+
+using ublkpp::changed_extent;
+using ublkpp::ChangeTracker;
+using ublkpp::Ki;
+using ublkpp::Mi;
+
+static constexpr auto k_chunk = ChangeTracker::k_chunk_size;
+
+TEST(ChangeTracker, EmptyUntilMarked) {
+    auto cbt = ChangeTracker(64 * Mi);
+    EXPECT_TRUE(cbt.collect(false).empty());
+    cbt.mark(0, 0);
+    cbt.mark(64 * Mi, 4 * Ki); // Past the end
+    EXPECT_TRUE(cbt.collect(true).empty());
+}
+
+TEST(ChangeTracker, RoundsToChunks) {
+    auto cbt = ChangeTracker(64 * Mi);
+    cbt.mark(k_chunk + 512, 512);
+    auto const res = cbt.collect(false);
+    ASSERT_EQ(1U, res.size());
+    EXPECT_EQ((changed_extent{k_chunk, k_chunk}), res[0]);
+    // Straddling a chunk boundary marks both chunks
+    cbt.mark(4 * k_chunk - 4 * Ki, 8 * Ki);
+    auto const res2 = cbt.collect(false);
+    ASSERT_EQ(2U, res2.size());
+    EXPECT_EQ((changed_extent{3 * k_chunk, 2 * k_chunk}), res2[1]);
+}
+
+TEST(ChangeTracker, CoalescesAcrossWords) {
+    auto cbt = ChangeTracker(64 * Mi);
+    // Chunks 60..70 span the first two bitmap words
+    cbt.mark(60 * k_chunk, 11 * k_chunk);
+    cbt.mark(200 * k_chunk, 4 * Ki);
+    auto const res = cbt.collect(false);
+    ASSERT_EQ(2U, res.size());
+    EXPECT_EQ((changed_extent{60 * k_chunk, 11 * k_chunk}), res[0]);
+    EXPECT_EQ((changed_extent{200 * k_chunk, k_chunk}), res[1]);
+}
+
+TEST(ChangeTracker, ClipsToCapacity) {
+    // Capacity ends mid-chunk; the last extent must not run past it
+    auto const cap = 10 * k_chunk + 4 * Ki;
+    auto cbt = ChangeTracker(cap);
+    cbt.mark(9 * k_chunk, 8 * Mi);
+    auto const res = cbt.collect(false);
+    ASSERT_EQ(1U, res.size());
+    EXPECT_EQ((changed_extent{9 * k_chunk, k_chunk + 4 * Ki}), res[0]);
+}
+
+TEST(ChangeTracker, ResetClears) {
+    auto cbt = ChangeTracker(64 * Mi);
+    cbt.mark(0, 4 * Ki);
+    EXPECT_EQ(1U, cbt.collect(false).size());
+    EXPECT_EQ(1U, cbt.collect(true).size());
+    EXPECT_TRUE(cbt.collect(false).empty());
+}
+
+struct SizedDisk : ublkpp::ublk_disk {
+    explicit SizedDisk(uint64_t capacity) { params()->basic.dev_sectors = capacity >> ublkpp::SECTOR_SHIFT; }
+    std::string id() const noexcept override { return "test-sized-disk"; }
+};
+
+TEST(ChangedBlockTracking, OffUntilFirstEpoch) {
+    auto tgt = ublkpp::ublkpp_tgt_test_peer::make(std::make_shared< SizedDisk >(64 * Mi));
+    EXPECT_EQ(0U, tgt.cbt_epoch());
+    EXPECT_TRUE(tgt.cbt_changed().empty());
+    EXPECT_TRUE(tgt.cbt_new_epoch().empty());
+    EXPECT_EQ(1U, tgt.cbt_epoch());
+    tgt.begin_shutdown();
+}
+
+TEST(ChangedBlockTracking, EpochRotation) {
+    auto tgt = ublkpp::ublkpp_tgt_test_peer::make(std::make_shared< SizedDisk >(64 * Mi));
+    tgt.cbt_new_epoch();
+    ublkpp::ublkpp_tgt_test_peer::change_tracker(tgt)->mark(Mi, 64 * Ki);
+    auto const open = tgt.cbt_changed();
+    ASSERT_EQ(1U, open.size());
+    EXPECT_EQ((changed_extent{Mi, 64 * Ki}), open[0]);
+
+    auto const closed = tgt.cbt_new_epoch();
+    EXPECT_EQ(2U, tgt.cbt_epoch());
+    ASSERT_EQ(1U, closed.size());
+    EXPECT_EQ((changed_extent{Mi, 64 * Ki}), closed[0]);
+    EXPECT_TRUE(tgt.cbt_changed().empty());
+    EXPECT_TRUE(tgt.cbt_new_epoch().empty());
+    EXPECT_EQ(3U, tgt.cbt_epoch());
+    tgt.begin_shutdown();
+}
@@ -0,0 +1,90 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "target/plug.hpp"
+
+using ublkpp::k_max_merge;
+using ublkpp::merge_limits;
+using ublkpp::merge_run;
+using ublkpp::merged_result;
+using ublkpp::order_plug;
+using ublkpp::plugged_io;
+
+static constexpr auto k_limits = merge_limits{.vectored = true, .max_bytes = 512 * 1024, .max_discard_bytes = 1 << 30};
+
+static plugged_io req(uint32_t op_flags, uint64_t sector, uint32_t sectors = 8) {
+    return {.op_flags = op_flags, .nr_sectors = sectors, .start_sector = sector, .data = nullptr};
+}
+
+// Sequential writes arriving out of order come together in address order
+TEST(Plug, OrdersByOpThenAddress) {
+    auto batch = std::vector< plugged_io >{req(UBLK_IO_OP_WRITE, 16), req(UBLK_IO_OP_READ, 0),
+                                           req(UBLK_IO_OP_WRITE, 0), req(UBLK_IO_OP_WRITE, 8)};
+    order_plug(batch);
+    EXPECT_EQ(UBLK_IO_OP_READ, batch[0].op_flags);
+    EXPECT_EQ(0U, batch[1].start_sector);
+    EXPECT_EQ(8U, batch[2].start_sector);
+    EXPECT_EQ(16U, batch[3].start_sector);
+    EXPECT_EQ(1U, merge_run(batch, k_limits));
+    EXPECT_EQ(3U, merge_run(std::span(batch).subspan(1), k_limits));
+}
+
+TEST(Plug, GapEndsTheRun) {
+    auto const batch = std::vector< plugged_io >{req(UBLK_IO_OP_WRITE, 0), req(UBLK_IO_OP_WRITE, 8),
+                                                 req(UBLK_IO_OP_WRITE, 24)};
+    EXPECT_EQ(2U, merge_run(batch, k_limits));
+}
+
+// FUA and non-FUA writes are not merged with each other
+TEST(Plug, FlagsMustMatch) {
+    auto const batch = std::vector< plugged_io >{req(UBLK_IO_OP_WRITE, 0), req(UBLK_IO_OP_WRITE | UBLK_IO_F_FUA, 8)};
+    EXPECT_EQ(1U, merge_run(batch, k_limits));
+}
+
+// Reads and writes need a disk that takes several iovecs; discards are one range either way
+TEST(Plug, ReadsAndWritesNeedScatterGather) {
+    auto const no_sg = merge_limits{.max_bytes = 512 * 1024, .max_discard_bytes = 1 << 30};
+    auto const writes = std::vector< plugged_io >{req(UBLK_IO_OP_WRITE, 0), req(UBLK_IO_OP_WRITE, 8)};
+    EXPECT_EQ(1U, merge_run(writes, no_sg));
+    auto const discards = std::vector< plugged_io >{req(UBLK_IO_OP_DISCARD, 0), req(UBLK_IO_OP_DISCARD, 8)};
+    EXPECT_EQ(2U, merge_run(discards, no_sg));
+}
+
+TEST(Plug, FlushGoesAlone) {
+    auto const batch = std::vector< plugged_io >{req(UBLK_IO_OP_FLUSH, 0, 0), req(UBLK_IO_OP_FLUSH, 0, 0)};
+    EXPECT_EQ(1U, merge_run(batch, k_limits));
+}
+
+TEST(Plug, StopsAtMaxBytes) {
+    auto batch = std::vector< plugged_io >();
+    for (auto i = 0U; 8 > i; ++i)
+        batch.push_back(req(UBLK_IO_OP_READ, i * 256, 256)); // 128 KiB each
+    EXPECT_EQ(4U, merge_run(batch, k_limits));
+
+    for (auto& r : batch)
+        r.op_flags = UBLK_IO_OP_DISCARD;
+    EXPECT_EQ(2U, merge_run(batch, {.max_discard_bytes = 256 * 1024}));
+}
+
+TEST(Plug, StopsAtMaxMerge) {
+    auto batch = std::vector< plugged_io >();
+    for (auto i = 0U; 2 * k_max_merge > i; ++i)
+        batch.push_back(req(UBLK_IO_OP_WRITE, i * 8));
+    EXPECT_EQ(k_max_merge, merge_run(batch, k_limits));
+}
+
+TEST(Plug, EmptyBatch) { EXPECT_EQ(0U, merge_run({}, k_limits)); }
+
+// A short result completes the requests it reaches, the last of them in part, and fails the rest
+TEST(Plug, ShortResultSplitsInOrder) {
+    constexpr uint64_t k_req = 4096;
+    EXPECT_EQ(4096, merged_result(6144, 0, k_req));
+    EXPECT_EQ(2048, merged_result(6144, k_req, k_req));
+    EXPECT_EQ(-EIO, merged_result(6144, 2 * k_req, k_req));
+    EXPECT_EQ(4096, merged_result(8192, k_req, k_req));
+    EXPECT_EQ(-EIO, merged_result(8192, 2 * k_req, k_req));
+    // Errors and a driver's 0 go to every request as they are
+    EXPECT_EQ(-ENOSPC, merged_result(-ENOSPC, k_req, k_req));
+    EXPECT_EQ(0, merged_result(0, k_req, k_req));
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "target/qos.hpp"
+
+using ublkpp::qos_limits;
+using ublkpp::qos_throttle;
+using ublkpp::rate_limiter;
+
+static constexpr uint64_t k_sec = 1000000000;
+static constexpr uint64_t k_t0 = 1000 * k_sec;
+
+TEST(RateLimiter, UnlimitedNeverWaits) {
+    auto r = rate_limiter();
+    EXPECT_FALSE(r.limited());
+    for (auto i = 0; 1000 > i; ++i)
+        EXPECT_EQ(k_t0, r.reserve(1 << 20, k_t0));
+}
+
+// Without a burst, back-to-back units are spaced at the rate, the first going at once
+TEST(RateLimiter, SpacesAtRate) {
+    auto r = rate_limiter();
+    r.set({.rate = 1000});
+    EXPECT_TRUE(r.limited());
+    EXPECT_EQ(k_t0, r.reserve(1, k_t0));
+    EXPECT_EQ(k_t0 + k_sec / 1000, r.reserve(1, k_t0));
+    EXPECT_EQ(k_t0 + 2 * k_sec / 1000, r.reserve(1, k_t0));
+}
+
+TEST(RateLimiter, BurstPassesAtOnce) {
+    auto r = rate_limiter();
+    r.set({.rate = 100, .burst = 10});
+    for (auto i = 0; 11 > i; ++i)
+        EXPECT_EQ(k_t0, r.reserve(1, k_t0)) << i;
+    EXPECT_LT(k_t0, r.reserve(1, k_t0));
+}
+
+// Quiet time refills the burst but banks no more than it
+TEST(RateLimiter, IdleRefillsOnlyTheBurst) {
+    auto r = rate_limiter();
+    r.set({.rate = 100, .burst = 5});
+    for (auto i = 0; 6 > i; ++i)
+        r.reserve(1, k_t0);
+    auto const later = k_t0 + 60 * k_sec;
+    for (auto i = 0; 6 > i; ++i)
+        EXPECT_EQ(later, r.reserve(1, later)) << i;
+    EXPECT_EQ(later + k_sec / 100, r.reserve(1, later));
+}
+
+// Bytes: a large I/O costs in proportion and delays the next
+TEST(RateLimiter, CostFollowsUnits) {
+    auto r = rate_limiter();
+    r.set({.rate = 1 << 20});
+    EXPECT_EQ(k_t0, r.reserve(1 << 19, k_t0));
+    EXPECT_EQ(k_t0 + k_sec / 2, r.reserve(4096, k_t0));
+}
+
+TEST(RateLimiter, SetStartsAfresh) {
+    auto r = rate_limiter();
+    r.set({.rate = 1});
+    r.reserve(100, k_t0);
+    EXPECT_LT(k_t0, r.reserve(1, k_t0));
+    r.set({.rate = 1});
+    EXPECT_EQ(k_t0, r.reserve(1, k_t0));
+}
+
+// Concurrent reservations hand out distinct slots: N at the rate span N-1 intervals
+TEST(RateLimiter, ConcurrentReservationsSerialize) {
+    auto r = rate_limiter();
+    r.set({.rate = 1000});
+    auto constexpr k_threads = 4;
+    auto constexpr k_each = 1000;
+    auto latest = std::vector< uint64_t >(k_threads, 0);
+    auto threads = std::vector< std::thread >();
+    for (auto t = 0; k_threads > t; ++t)
+        threads.emplace_back([&, t] {
+            for (auto i = 0; k_each > i; ++i)
+                latest[t] = std::max(latest[t], r.reserve(1, k_t0));
+        });
+    for (auto& t : threads)
+        t.join();
+    EXPECT_EQ(k_t0 + (k_threads * k_each - 1) * (k_sec / 1000), *std::ranges::max_element(latest));
+}
+
+TEST(QosThrottle, DefaultsUnlimited) {
+    auto q = qos_throttle();
+    EXPECT_FALSE(q.limited());
+    EXPECT_EQ(qos_limits{}, q.get());
+    EXPECT_EQ(k_t0, q.admit(true, 1 << 20, k_t0));
+    EXPECT_EQ(k_t0, q.admit(false, 1 << 20, k_t0));
+}
+
+TEST(QosThrottle, ReadsAndWritesAreSeparate) {
+    auto q = qos_throttle();
+    q.set({.read_iops = {.rate = 10}});
+    EXPECT_TRUE(q.limited());
+    EXPECT_EQ(k_t0, q.admit(true, 4096, k_t0));
+    EXPECT_LT(k_t0, q.admit(true, 4096, k_t0));
+    for (auto i = 0; 100 > i; ++i)
+        EXPECT_EQ(k_t0, q.admit(false, 4096, k_t0));
+}
+
+// An I/O waits for the later of its IOPS and bytes buckets
+TEST(QosThrottle, TakesTheLaterBucket) {
+    auto q = qos_throttle();
+    q.set({.write_iops = {.rate = 1000}, .write_bytes = {.rate = 4096}});
+    EXPECT_EQ(k_t0, q.admit(false, 4096, k_t0));
+    EXPECT_EQ(k_t0 + k_sec, q.admit(false, 4096, k_t0));
+}
+
+// DISCARD / WRITE_ZEROES move no bytes and take only write IOPS
+TEST(QosThrottle, ZeroBytesSkipsBandwidth) {
+    auto q = qos_throttle();
+    q.set({.write_bytes = {.rate = 1}});
+    EXPECT_EQ(k_t0, q.admit(false, 4096, k_t0));
+    EXPECT_EQ(k_t0, q.admit(false, 0, k_t0));
+}
+
+TEST(QosThrottle, SetBumpsGenerationAndClears) {
+    auto q = qos_throttle();
+    auto const gen = q.generation();
+    auto const limits = qos_limits{.read_bytes = {.rate = 1 << 20, .burst = 1 << 18}};
+    q.set(limits);
+    EXPECT_NE(gen, q.generation());
+    EXPECT_EQ(limits, q.get());
+    q.set({});
+    EXPECT_FALSE(q.limited());
+    EXPECT_EQ(k_t0, q.admit(true, 1 << 30, k_t0));
+}
@@ -0,0 +1,70 @@
+#include <initializer_list>
+
+#include <gtest/gtest.h>
+
+#include "target/queue_placement.hpp"
+
+using ublkpp::auto_queue_count;
+using ublkpp::plan_queue_cpus;
+using ublkpp::plan_reactor_cpus;
+
+static cpu_set_t cpus(std::initializer_list< int > list) {
+    auto set = cpu_set_t{};
+    CPU_ZERO(&set);
+    for (auto const cpu : list)
+        CPU_SET(cpu, &set);
+    return set;
+}
+
+TEST(QueuePlacement, AutoCountFollowsAllowedCpus) {
+    EXPECT_EQ(4, auto_queue_count(cpus({0, 1, 6, 7})));
+    EXPECT_EQ(1, auto_queue_count(cpus({})));
+}
+
+// One queue per CPU, as --nr_hw_queues=0 asks for: every queue on the CPU it serves
+TEST(QueuePlacement, QueuePerCpu) {
+    auto const res = plan_queue_cpus({cpus({0}), cpus({1}), cpus({2}), cpus({3})}, cpus({0, 1, 2, 3}));
+    EXPECT_EQ((std::vector< int >{0, 1, 2, 3}), res);
+}
+
+// Fewer queues than CPUs: distinct CPUs, each within its queue's mask
+TEST(QueuePlacement, SharedMasks) {
+    auto const res = plan_queue_cpus({cpus({0, 1, 4, 5}), cpus({2, 3, 6, 7})}, cpus({0, 1, 2, 3, 4, 5, 6, 7}));
+    EXPECT_EQ((std::vector< int >{0, 2}), res);
+}
+
+// The daemon may be confined to CPUs outside a queue's mask: those queues take the free ones
+TEST(QueuePlacement, MaskOutsideAllowed) {
+    auto const res = plan_queue_cpus({cpus({0, 1}), cpus({2, 3}), cpus({4, 5})}, cpus({2, 3, 5}));
+    EXPECT_EQ((std::vector< int >{3, 2, 5}), res);
+}
+
+// More queues than allowed CPUs: every CPU is used before any is shared
+TEST(QueuePlacement, MoreQueuesThanCpus) {
+    auto const res = plan_queue_cpus({cpus({0}), cpus({1}), cpus({2}), cpus({3})}, cpus({1, 2}));
+    EXPECT_EQ((std::vector< int >{1, 1, 2, 2}), res);
+}
+
+TEST(QueuePlacement, NothingAllowed) {
+    EXPECT_EQ((std::vector< int >{-1, -1}), plan_queue_cpus({cpus({0}), cpus({1})}, cpus({})));
+}
+
+// Single-queue targets on shared reactors: each takes the least served CPU of its mask
+TEST(QueuePlacement, ReactorsSpreadTargets) {
+    auto const all = cpus({0, 1, 2, 3});
+    auto load = std::vector< uint32_t >{1, 0, 2, 0};
+    EXPECT_EQ((std::vector< int >{1}), plan_reactor_cpus({all}, all, load));
+    load = {1, 1, 1, 1};
+    EXPECT_EQ((std::vector< int >{0}), plan_reactor_cpus({all}, all, load));
+}
+
+// A target's own queues count as they are planned, and stay within their masks
+TEST(QueuePlacement, ReactorsCountPlannedQueues) {
+    auto const res = plan_reactor_cpus({cpus({0, 1}), cpus({0, 1}), cpus({2, 3})}, cpus({0, 1, 2, 3}), {0, 0, 5, 1});
+    EXPECT_EQ((std::vector< int >{0, 1, 3}), res);
+}
+
+TEST(QueuePlacement, ReactorsMaskOutsideAllowed) {
+    EXPECT_EQ((std::vector< int >{3}), plan_reactor_cpus({cpus({0, 1})}, cpus({2, 3}), {0, 0, 1, 0}));
+    EXPECT_EQ((std::vector< int >{-1}), plan_reactor_cpus({cpus({0})}, cpus({}), {}));
+}
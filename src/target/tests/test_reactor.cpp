@@ -0,0 +1,60 @@
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "target/reactor.hpp"
+
+using ublkpp::reactor_slots;
+using ublkpp::ready_ring;
+
+TEST(Reactor, SlotsFindByKey) {
+    auto slots = reactor_slots< int >();
+    auto const a = slots.add(std::make_unique< int >(1));
+    auto const b = slots.add(std::make_unique< int >(2));
+    EXPECT_NE(0UL, a);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(2UL, slots.size());
+    EXPECT_EQ(1, *slots.find(a));
+    EXPECT_EQ(2, *slots.at(reactor_slots< int >::slot_of(b)));
+}
+
+// A freed slot is reused under a new key; the old one no longer finds anything
+TEST(Reactor, SlotsRetireOldKeys) {
+    auto slots = reactor_slots< int >();
+    auto const a = slots.add(std::make_unique< int >(1));
+    EXPECT_EQ(1, *slots.remove(a));
+    EXPECT_EQ(nullptr, slots.find(a));
+    EXPECT_EQ(nullptr, slots.remove(a));
+    auto const b = slots.add(std::make_unique< int >(2));
+    EXPECT_EQ(reactor_slots< int >::slot_of(a), reactor_slots< int >::slot_of(b));
+    EXPECT_NE(a, b);
+    EXPECT_EQ(nullptr, slots.find(a));
+    EXPECT_EQ(2, *slots.find(b));
+    EXPECT_EQ(1UL, slots.size());
+}
+
+TEST(Reactor, SlotsForEachSkipsFree) {
+    auto slots = reactor_slots< int >();
+    auto const a = slots.add(std::make_unique< int >(1));
+    slots.add(std::make_unique< int >(2));
+    slots.remove(a);
+    auto seen = std::vector< int >();
+    slots.for_each([&](uint32_t, int const& v) { seen.push_back(v); });
+    EXPECT_EQ((std::vector< int >{2}), seen);
+}
+
+// Marking a slot already waiting keeps its place; marking it again once served puts it last
+TEST(Reactor, ReadyRingRoundRobin) {
+    auto ready = ready_ring();
+    ready.mark(2);
+    ready.mark(0);
+    ready.mark(2);
+    EXPECT_EQ(2UL, ready.size());
+    EXPECT_EQ(2U, ready.next());
+    ready.mark(2);
+    EXPECT_EQ(0U, ready.next());
+    EXPECT_EQ(2U, ready.next());
+    EXPECT_TRUE(ready.empty());
+    EXPECT_FALSE(ready.next().has_value());
+}
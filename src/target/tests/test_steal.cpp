@@ -0,0 +1,40 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "target/steal.hpp"
+
+using ublkpp::offer_queue;
+using ublkpp::steal_quota;
+
+// The owner takes its oldest offers, thieves the newest
+TEST(Steal, OwnerFrontThiefBack) {
+    auto offers = offer_queue< int >();
+    for (auto i = 0; 5 > i; ++i)
+        offers.offer(i);
+    auto owner = std::vector< int >();
+    auto thief = std::vector< int >();
+    EXPECT_EQ(2UL, offers.take_front(2, [&](int v) { owner.push_back(v); }));
+    EXPECT_EQ(2UL, offers.take_back(2, [&](int v) { thief.push_back(v); }));
+    EXPECT_EQ((std::vector< int >{0, 1}), owner);
+    EXPECT_EQ((std::vector< int >{4, 3}), thief);
+    EXPECT_EQ(1UL, offers.size());
+}
+
+TEST(Steal, TakeStopsWhenEmpty) {
+    auto offers = offer_queue< int >();
+    offers.offer(7);
+    auto seen = std::vector< int >();
+    EXPECT_EQ(1UL, offers.take_back(4, [&](int v) { seen.push_back(v); }));
+    EXPECT_EQ(0UL, offers.take_front(4, [&](int v) { seen.push_back(v); }));
+    EXPECT_TRUE(offers.empty());
+    EXPECT_EQ((std::vector< int >{7}), seen);
+}
+
+// A queue steals only with room left in its batch
+TEST(Steal, QuotaIsWhatTheBatchLeaves) {
+    EXPECT_EQ(8U, steal_quota(0, 8));
+    EXPECT_EQ(3U, steal_quota(5, 8));
+    EXPECT_EQ(0U, steal_quota(8, 8));
+    EXPECT_EQ(0U, steal_quota(12, 8));
+}
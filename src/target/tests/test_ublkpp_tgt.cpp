@@ -2,6 +2,8 @@
 #include <chrono>
 #include <thread>
 
+#include <linux/ioprio.h>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -411,6 +413,56 @@ TEST(IOError, DiscardAndWriteZeroesNotCounted) {
     EXPECT_EQ(m._write_errors.load(std::memory_order_relaxed), 0u);
 }
 
+// ---------------------------------------------------------------------------
+// record_io_throttled: QoS wait time per op type
+// ---------------------------------------------------------------------------
+
+TEST(IOThrottled, ReadsAndWritesAccumulate) {
+    ublkpp::UblkIOMetrics m{"test-throttled"};
+    m.record_io_throttled(0, 100);
+    m.record_io_throttled(1, 40);
+    m.record_io_throttled(1, 2);
+    EXPECT_EQ(m._throttled_reads.load(std::memory_order_relaxed), 1u);
+    EXPECT_EQ(m._read_throttled_us.load(std::memory_order_relaxed), 100u);
+    EXPECT_EQ(m._throttled_writes.load(std::memory_order_relaxed), 2u);
+    EXPECT_EQ(m._write_throttled_us.load(std::memory_order_relaxed), 42u);
+}
+
+TEST(IOThrottled, DiscardAndWriteZeroesCountAsWrites) {
+    ublkpp::UblkIOMetrics m{"test-throttled-discard"};
+    m.record_io_throttled(3, 5); // UBLK_IO_OP_DISCARD
+    m.record_io_throttled(5, 5); // UBLK_IO_OP_WRITE_ZEROES
+    m.record_io_throttled(2, 5); // FLUSH is never throttled; ignored
+    EXPECT_EQ(m._throttled_writes.load(std::memory_order_relaxed), 2u);
+    EXPECT_EQ(m._write_throttled_us.load(std::memory_order_relaxed), 10u);
+    EXPECT_EQ(m._throttled_reads.load(std::memory_order_relaxed), 0u);
+}
+
+TEST(Qos, SetQosRoundTrips) {
+    std::atomic< int > destroy_count{0};
+    auto tgt = ublkpp::ublkpp_tgt_test_peer::make(std::make_shared< TrackedDisk >(destroy_count));
+    EXPECT_EQ(ublkpp::qos_limits{}, tgt.qos());
+    auto const limits = ublkpp::qos_limits{.read_iops = {.rate = 5000, .burst = 500},
+                                           .write_bytes = {.rate = 100 * 1024 * 1024}};
+    tgt.set_qos(limits);
+    EXPECT_EQ(limits, tgt.qos());
+    tgt.set_qos({});
+    EXPECT_EQ(ublkpp::qos_limits{}, tgt.qos());
+    tgt.begin_shutdown();
+}
+
+TEST(IoPriority, SetIoPriorityRoundTrips) {
+    std::atomic< int > destroy_count{0};
+    auto tgt = ublkpp::ublkpp_tgt_test_peer::make(std::make_shared< TrackedDisk >(destroy_count));
+    EXPECT_EQ(0U, tgt.io_priority());
+    tgt.set_io_priority(IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 2));
+    EXPECT_EQ(IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 2), tgt.io_priority());
+    // No queue threads to move to SCHED_IDLE; only the value changes
+    tgt.set_io_priority(IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0));
+    EXPECT_EQ(IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0), tgt.io_priority());
+    tgt.begin_shutdown();
+}
+
 // ---------------------------------------------------------------------------
 // UblkRaidMetrics: smoke tests for new methods.
 // SISL gauges have no readable back-channel, so EXPECT_NO_THROW verifies
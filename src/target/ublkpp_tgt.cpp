@@ -1,11 +1,25 @@
 #include "ublkpp/target.hpp"
 #include "ublkpp/target_testing.hpp"
 
+#include <array>
 #include <chrono>
+#include <coroutine>
+#include <functional>
+#include <future>
+#include <limits>
+#include <linux/ioprio.h>
+#include <linux/mempolicy.h>
+#include <map>
+#include <optional>
+#include <poll.h>
 #include <pthread.h>
+#include <queue>
 #include <ranges>
 #include <sched.h>
 #include <semaphore.h>
+#include <span>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
 #include <exec/async_scope.hpp>
 #include <exec/inline_scheduler.hpp>
 #include <exec/task.hpp>
@@ -22,8 +36,15 @@
 #include "ublkpp/lib/ublk_disk.hpp"
 #include "lib/logging.hpp"
 #include "lib/common.hpp"
+#include "metrics/ublk_queue_metrics.hpp"
 #include <ublkpp/lib/cqe_state.hpp>
 #include "ublkpp_tgt_impl.hpp"
+#include "busy_poll.hpp"
+#include "change_tracker.hpp"
+#include "plug.hpp"
+#include "queue_placement.hpp"
+#include "reactor.hpp"
+#include "steal.hpp"
 
 namespace ublkpp::detail {
 struct params_access {
@@ -34,13 +55,46 @@ struct params_access {
 SISL_OPTION_GROUP(ublkpp_tgt,
                   (max_io_size, "", "max_io_size", "Maximum I/O size before split",
                    cxxopts::value< std::uint32_t >()->default_value("524288"), "<io_size>"),
-                  (nr_hw_queues, "", "nr_hw_queues", "Number of Hardware Queues (threads) per target",
+                  (nr_hw_queues, "", "nr_hw_queues",
+                   "Number of Hardware Queues (threads) per target; 0 for one per CPU, pinned",
                    cxxopts::value< std::uint16_t >()->default_value("1"), "<queue_cnt>"),
+                  (pin_queues, "", "pin_queues",
+                   "Pin each queue thread to one CPU of its queue, with its memory on that CPU's NUMA node",
+                   cxxopts::value< bool >(), ""),
                   (qdepth, "", "qdepth", "I/O Queue Depth per target",
                    cxxopts::value< std::uint16_t >()->default_value("128"), "<qd>"),
                   (feature_zero_copy, "", "feature_zero_copy", "Enable ZeroCopy Feature", cxxopts::value< bool >(), ""),
                   (sched, "", "sched", "Queue thread scheduler policy (other, fifo)",
-                   cxxopts::value< std::string >()->default_value("fifo"), "<policy>"))
+                   cxxopts::value< std::string >()->default_value("fifo"), "<policy>"),
+                  (ring_mode, "", "ring_mode",
+                   "io_uring setup of queue rings for targets run without one (coop_taskrun, defer_taskrun, sqpoll)",
+                   cxxopts::value< std::string >()->default_value("coop_taskrun"), "<mode>"),
+                  (ring_fd, "", "ring_fd", "Register queue ring fds (with --ring_mode)", cxxopts::value< bool >(), ""),
+                  (busy_poll_us, "", "busy_poll_us",
+                   "Spin on the completion ring for up to this long before sleeping; 0 to always sleep",
+                   cxxopts::value< std::uint32_t >()->default_value("0"), "<usecs>"),
+                  (busy_poll_adaptive, "", "busy_poll_adaptive",
+                   "Size the spin window from recent completion gaps, up to --busy_poll_us", cxxopts::value< bool >(),
+                   ""),
+                  (plug_merge, "", "plug_merge",
+                   "Merge contiguous requests of a completion batch into one backend I/O", cxxopts::value< bool >(),
+                   ""),
+                  (ring_sqes_per_io, "", "ring_sqes_per_io",
+                   "Backend SQEs per I/O the queue rings are sized for; I/O issuing more waits for room (0 for "
+                   "the most the disk may issue)",
+                   cxxopts::value< std::uint32_t >()->default_value("4"), "<sqes>"),
+                  (iopoll, "", "iopoll",
+                   "Give each queue a polled (IOPOLL) ring for O_DIRECT I/O to block devices that poll",
+                   cxxopts::value< bool >(), ""),
+                  (shared_reactors, "", "shared_reactors",
+                   "Serve the queues of every target from one shared thread per CPU instead of a thread per queue",
+                   cxxopts::value< bool >(), ""),
+                  (steal_io, "", "steal_io",
+                   "Let queue threads with time to spare serve requests a busy sibling queue offers",
+                   cxxopts::value< bool >(), ""),
+                  (steal_batch, "", "steal_batch",
+                   "I/Os a queue serves per pass under --steal_io before offering the rest to its siblings",
+                   cxxopts::value< std::uint32_t >()->default_value("8"), "<ios>"))
 
 using namespace std::chrono_literals;
 
@@ -72,15 +126,85 @@ static bool check_dev(ublksrv_ctrl_dev_info const* info) {
 
 // Matches UBLKSRV_IO_IDLE_SECS defined privately in ublksrv.c
 static constexpr int k_io_idle_secs = 20;
+// Longest a queue holding I/O parked by QoS sleeps before looking at the limits again
+static constexpr uint64_t k_qos_recheck_ns = 100'000'000;
 
-struct ublkpp_queue_state {
+// Longest a queue whose requests siblings serve (--steal_io) sleeps without looking for their
+// results, in case the wake that follows them was lost
+static constexpr uint64_t k_lent_recheck_ns = 1'000'000;
+
+// An I/O waiting on the target's QoS limits until `release_ns`
+struct parked_io {
+    uint64_t release_ns;
+    std::coroutine_handle<> handle;
+    async_io const* io;
+
+    bool operator>(parked_io const& rhs) const noexcept { return release_ns > rhs.release_ns; }
+};
+
+// The requests one backend I/O serves: a single one, or a run merged by unplug() in address order
+struct io_group {
+    std::array< ublk_io_data const*, k_max_merge > data;
+    uint32_t n{0};
+};
+
+// A request a sibling queue served for this one (--steal_io): to be committed with `res` here, or,
+// dropped at shutdown, left uncompleted
+struct served_io {
+    int tag;
+    int res;
+    bool complete;
+};
+
+// q->private_data, as a queue_rings: drivers find the queue's polled ring through it
+struct ublkpp_queue_state : queue_rings {
     std::shared_ptr< ublkpp_tgt_impl > tgt;
+    ublksrv_queue const* q{nullptr};
     exec::async_scope scope;
     bool is_idle{false};
+    int probes_armed{0}; // Idle probe timeouts submitted and not yet completed
+    // Busy-poll (--busy_poll_us); empty when the queue always sleeps
+    std::optional< poll_window > poll;
+    // Plugging (--plug_merge): the requests of this CQE batch, dispatched at its end
+    bool plugging{false};
+    std::vector< plugged_io > plug;
+    // The I/Os unplug() makes of them
+    std::vector< io_group > batch;
+    // Work stealing (--steal_io), see steal.hpp. A lending queue holds its requests back as a
+    // plugging one does and offers what it does not serve in a pass; `offers` is guarded by the
+    // target's steal_lock. `lent` counts its requests offered or served elsewhere, `borrowed` the
+    // I/Os of siblings served here: the queue stops only once both are back to 0.
+    bool lending{false};
+    offer_queue< io_group > offers;
+    bool offering{false}; // `offers` was left non-empty by this thread
+    uint32_t lent{0};
+    uint32_t borrowed{0};
+    std::vector< io_group > stolen;
+    // Asleep waiting for CQEs, and a wake (IORING_OP_MSG_RING) on its way to it
+    std::atomic< bool > sleeping{false};
+    std::atomic< bool > wake_sent{false};
+    // Results of its requests served by siblings
+    std::mutex inbox_lock;
+    std::vector< served_io > inbox;
+    std::vector< served_io > inbox_taken;
+    std::unique_ptr< UblkQueueMetrics > queue_metrics;
+    // I/O parked by QoS, earliest release first, and the limits generation it was parked under
+    std::priority_queue< parked_io, std::vector< parked_io >, std::greater<> > parked;
+    uint64_t qos_generation{0};
+    // Backs queue_rings::polled (--iopoll)
+    io_uring polled_ring{};
+    // Served by a shared reactor (--shared_reactors): its key there, and when a pass last handled
+    // I/O, from which the reactor tells when the queue has gone idle
+    uint64_t reactor_key{0};
+    uint64_t active_ns{0};
 
     explicit ublkpp_queue_state(std::shared_ptr< ublkpp_tgt_impl > t) : tgt(std::move(t)) {}
 };
 
+static ublkpp_queue_state* queue_state(ublksrv_queue const* q) noexcept {
+    return static_cast< ublkpp_queue_state* >(static_cast< queue_rings* >(q->private_data));
+}
+
 static void submit_probe_timeout(ublksrv_queue const* q) {
     if (auto* sqe = next_sqe(q)) {
         // clang-format off
@@ -89,114 +213,830 @@ static void submit_probe_timeout(ublksrv_queue const* q) {
         io_uring_prep_timeout(sqe, &ts, 0, 0);
         sqe->user_data = sisl::async::encode_managed_user_data(nullptr); // sentinel: probe CQE, no cqe_state
         io_uring_submit(q->ring_ptr);
+        ++queue_state(q)->probes_armed;
     }
 }
 
-// Our own CQE processing loop, replacing ublksrv_process_io.
-// Target CQEs have bit 63 set; bits 62:0 hold a raw cqe_state* (non-null) for I/O completions
-// or zero for probe timeout CQEs (null-pointer sentinel). Ublk command CQEs delegate to ublksrv.
-//
-// Drain correctness: ublksrv_queue_is_done returns true only when ublksrv has no pending I/O
-// commands. We call ublksrv_complete_io at the end of __handle_io_async, after co_await
-// device->async_iov returns, so the scope is already empty when the loop exits. on_empty()
-// completes synchronously via its fast path.
-static exec::task< void > run_queue_loop(ublksrv_queue const* q, ublkpp_queue_state* qs) {
+// A probe timeout's own completion: fired or cancelled. The CQE of a timeout removal carries the
+// same sentinel but another result.
+static bool is_probe_done(io_uring_cqe const* cqe) noexcept { return -ETIME == cqe->res || -ECANCELED == cqe->res; }
+
+// Cancels the probe timeouts still armed when the queue stops and reaps them here, so the ring is
+// closed with nothing in flight. Under IORING_SETUP_DEFER_TASKRUN only this thread can run the
+// task work completing them; left to the ring's exit work they keep the ublk char device open
+// and ublksrv_ctrl_del_dev() waits on it. The queue is done, so no other CQE can arrive.
+static void cancel_probes(ublksrv_queue const* q, ublkpp_queue_state* qs) {
     auto* ring = q->ring_ptr;
+    for (auto i = 0; qs->probes_armed > i; ++i) {
+        if (auto* sqe = next_sqe(q)) {
+            io_uring_prep_timeout_remove(sqe, sisl::async::encode_managed_user_data(nullptr), 0);
+            sqe->user_data = sisl::async::encode_managed_user_data(nullptr);
+        }
+    }
     // clang-format off
-    struct __kernel_timespec ts{.tv_sec = k_io_idle_secs, .tv_nsec = 0};
+    __kernel_timespec ts{.tv_sec = 1, .tv_nsec = 0};
     // clang-format on
-    bool queue_done = false;
-
-    while (!queue_done) {
+    while (0 < qs->probes_armed) {
         io_uring_cqe* cqe{};
-        auto const ret = io_uring_submit_and_wait_timeout(ring, &cqe, 1, &ts, nullptr);
-
+        if (auto const ret = io_uring_submit_and_wait_timeout(ring, &cqe, 1, &ts, nullptr); -ETIME == ret) {
+            TLOGW("queue {}: {} idle probes did not cancel", q->q_id, qs->probes_armed) // LCOV_EXCL_LINE
+            break;
+        }
         unsigned head{};
         int count{0};
-        int probe_count{0}; // probe timeout CQEs must not count as work for ublksrv_queue_update_idle
         io_uring_for_each_cqe(ring, head, cqe) {
-            if (sisl::async::is_managed_user_data(cqe->user_data)) {
-                auto* state = static_cast< cqe_state* >(sisl::async::decode_managed_user_data(cqe->user_data));
-                if (!state) {
-                    // probe timeout CQE — only ETIME triggers a probe tick; other results ignored.
-                    // Excluded from io_count: counting it as work triggers idle_exit, setting
-                    // is_idle=false and preventing the probe from re-arming on subsequent fires.
-                    ++probe_count;
-                    if (cqe->res == -ETIME) {
-                        // Gate check before capturing device: if _shutting_down is false,
-                        // begin_shutdown's seq_cst store has not committed yet — so
-                        // device = {} has not been called. Atomic load gives a well-defined
-                        // shared_ptr copy; the local ref keeps the disk alive if device = {}
-                        // fires on another thread immediately after.
-                        if (!qs->tgt->_shutting_down.load(std::memory_order_seq_cst)) {
-                            if (auto dev = qs->tgt->device.load()) dev->probe_tick(q);
-                        }
-                        if (qs->is_idle && !qs->tgt->_shutting_down.load(std::memory_order_relaxed))
-                            submit_probe_timeout(q);
-                    }
-                } else {
-                    // target io_uring CQE — resume the coroutine waiting on this cqe_state
-                    state->_result = cqe->res;
-                    state->_result_ready = true;
-                    try {
-                        if (auto h = std::exchange(state->_waiter, {})) h.resume(); // per-state resume (disk_task path)
-                    } catch (std::exception const& e) {
-                        TLOGE("I/O threw exception: [{}]", e.what())
-                        if (state->_owner) ublksrv_complete_io(q, state->_owner->_tag, -EIO);
-                    } catch (...) {
-                        TLOGE("I/O threw unknown exception")
-                        if (state->_owner) ublksrv_complete_io(q, state->_owner->_tag, -EIO);
+            if (is_probe_done(cqe)) --qs->probes_armed;
+            ++count;
+        }
+        io_uring_cq_advance(ring, count);
+    }
+}
+
+static uint64_t monotonic_ns() noexcept {
+    auto ts = timespec{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast< uint64_t >(ts.tv_sec) * 1000000000UL + static_cast< uint64_t >(ts.tv_nsec);
+}
+
+// io_uring_submit_and_wait_timeout() for a busy-polling queue: submits, then spins on the CQ ring
+// for the queue's window before sleeping. Unless the ring polls its SQ (where the SQ thread runs
+// task work), it is set up with IORING_SETUP_TASKRUN_FLAG, so io_uring_peek_cqe() enters the
+// kernel to run pending task work (ublk command completions) instead of spinning past it. A
+// completion caught spinning returns 0.
+static int poll_and_wait(io_uring* ring, ublkpp_queue_state* qs, __kernel_timespec* ts) {
+    io_uring_cqe* cqe{};
+    io_uring_submit(ring);
+    if (0 == io_uring_peek_cqe(ring, &cqe)) return 0;
+
+    auto const start = monotonic_ns();
+    auto const window = qs->poll->window_ns();
+    auto now = start;
+    if (0 < window) {
+        do {
+            cpu_relax();
+            if (0 == io_uring_peek_cqe(ring, &cqe)) {
+                now = monotonic_ns();
+                qs->queue_metrics->record_spin_hit(now - start);
+                qs->poll->observe(now - start);
+                return 0;
+            }
+            now = monotonic_ns();
+        } while (window > now - start);
+        qs->queue_metrics->record_spin_miss(now - start);
+    }
+    auto const ret = io_uring_submit_and_wait_timeout(ring, &cqe, 1, ts, nullptr);
+    qs->poll->observe(monotonic_ns() - start);
+    if (qs->poll->window_ns() != window) qs->queue_metrics->record_poll_window(qs->poll->window_ns());
+    return ret;
+}
+
+// Suspends an I/O coroutine on its queue until `release_ns` (see release_parked())
+struct park_until {
+    ublkpp_queue_state* qs;
+    uint64_t release_ns;
+    async_io const* io;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) { qs->parked.push({release_ns, h, io}); }
+    void await_resume() const noexcept {}
+};
+
+// Counts a sibling's I/O in `borrowed` while it runs on this queue (--steal_io), which keeps the
+// queue from stopping under it
+struct borrowed_io {
+    uint32_t* borrowed;
+
+    explicit borrowed_io(uint32_t* b) noexcept : borrowed(b) {
+        if (borrowed) ++*borrowed;
+    }
+    borrowed_io(borrowed_io const&) = delete;
+    borrowed_io& operator=(borrowed_io const&) = delete;
+    ~borrowed_io() {
+        if (borrowed) --*borrowed;
+    }
+};
+
+// How long the queue may sleep: until its idle probe, or its earliest parked I/O is due
+static __kernel_timespec queue_wait(ublkpp_queue_state const* qs) {
+    if (qs->parked.empty()) return {.tv_sec = k_io_idle_secs, .tv_nsec = 0};
+    auto const now = monotonic_ns();
+    auto const due = qs->parked.top().release_ns;
+    auto const ns = std::min(k_qos_recheck_ns, (due > now) ? due - now : 0);
+    return {.tv_sec = static_cast< long long >(ns / 1000000000), .tv_nsec = static_cast< long long >(ns % 1000000000)};
+}
+
+static async_io* io_of(ublk_io_data const* data) noexcept { return reinterpret_cast< async_io* >(data->private_data); }
+
+// user_data of a wake posted to a queue's ring by a sibling (IORING_OP_MSG_RING): a managed one
+// that no I/O carries
+static uint64_t wake_user_data() noexcept {
+    static auto token = cqe_state{};
+    return sisl::async::encode_managed_user_data(&token);
+}
+
+// Has the thread of queue `to` run a pass soon, unless a wake is already on its way: a CQE posted
+// to its ring from that of `q`. Submitted at once, while `to` cannot yet have stopped and closed
+// its ring; a wake that fails completes on `q` instead, which takes it as one of its own.
+static void wake_queue(ublksrv_queue const* q, ublkpp_queue_state* to) {
+    if (to->wake_sent.exchange(true, std::memory_order_seq_cst)) return;
+    auto* sqe = next_sqe(q->ring_ptr);
+    if (!sqe) return; // to's own recheck (k_lent_recheck_ns) finds the result
+    io_uring_prep_msg_ring(sqe, to->q->ring_ptr->ring_fd, 0, wake_user_data(), 0);
+    io_uring_sqe_set_data64(sqe, wake_user_data());
+    sqe->flags |= IOSQE_CQE_SKIP_SUCCESS;
+    io_uring_submit(q->ring_ptr);
+}
+
+// Completes a request with `res` on the queue its tag belongs to: at once when that is `q`, the
+// queue whose thread served it, otherwise through that queue's inbox (--steal_io). `complete`
+// false hands back a request dropped at shutdown without completing it.
+static void finish_io(ublksrv_queue const* q, async_io const* io, int const res, bool const complete = true) {
+    if (!io->_home || q == io->_home) {
+        if (complete) ublksrv_complete_io(q, io->_tag, res);
+        return;
+    }
+    auto* home = queue_state(io->_home);
+    // The wake goes out under the lock too: once the home queue has taken the result it may stop
+    auto lk = std::scoped_lock< std::mutex >(home->inbox_lock);
+    home->inbox.push_back({.tag = io->_tag, .res = res, .complete = complete});
+    wake_queue(q, home);
+}
+
+// Fails an I/O whose coroutine threw, along with the requests merged into it
+static void fail_io(ublksrv_queue const* q, async_io const* io) {
+    for (; io; io = io->_merge_next)
+        if (0 <= io->_tag) finish_io(q, io, -EIO);
+}
+
+// Resumes the parked I/O that is due; all of it when the limits changed or the target is shutting
+// down. Each resumed coroutine runs on until it completes, submits, or parks again.
+static void release_parked(ublksrv_queue const* q, ublkpp_queue_state* qs) {
+    if (qs->parked.empty()) return;
+    auto const gen = qs->tgt->qos.generation();
+    auto const all = gen != qs->qos_generation || qs->tgt->_shutting_down.load(std::memory_order_relaxed);
+    qs->qos_generation = gen;
+    auto const now = monotonic_ns();
+    // Popped before any resumes: an I/O re-parked under new limits must wait for the next pass
+    auto due = std::vector< parked_io >();
+    while (!qs->parked.empty() && (all || qs->parked.top().release_ns <= now)) {
+        due.push_back(qs->parked.top());
+        qs->parked.pop();
+    }
+    for (auto const& p : due) {
+        try {
+            p.handle.resume();
+        } catch (std::exception const& e) {
+            TLOGE("I/O threw exception: [{}]", e.what())
+            fail_io(q, p.io);
+        } catch (...) {
+            TLOGE("I/O threw unknown exception")
+            fail_io(q, p.io);
+        }
+    }
+}
+
+// Hands a target CQE's result to the coroutine waiting on its cqe_state
+static void resume_io(ublksrv_queue const* q, cqe_state* state, int const res) {
+    state->_result = res;
+    state->_result_ready = true;
+    try {
+        if (auto h = std::exchange(state->_waiter, {})) h.resume(); // per-state resume (disk_task path)
+    } catch (std::exception const& e) {
+        TLOGE("I/O threw exception: [{}]", e.what())
+        fail_io(q, state->_owner);
+    } catch (...) {
+        TLOGE("I/O threw unknown exception")
+        fail_io(q, state->_owner);
+    }
+}
+
+// io_uring_submit_and_wait_timeout() for a queue with polled I/O in flight, which it must not
+// sleep on: no interrupt wakes it when that I/O completes. Submits both rings, then spins until
+// either has a completion; io_uring_peek_cqe() on the IOPOLL ring enters the kernel to poll the
+// devices. As with busy-poll, the queue ring is set up with IORING_SETUP_TASKRUN_FLAG so peeking
+// it runs pending task work (ublk command completions). Returns 0.
+static int poll_rings(io_uring* ring, ublkpp_queue_state* qs) {
+    io_uring_submit(ring);
+    io_uring_submit(qs->polled);
+    io_uring_cqe* cqe{};
+    while (0 != io_uring_peek_cqe(ring, &cqe) && 0 != io_uring_peek_cqe(qs->polled, &cqe))
+        cpu_relax();
+    return 0;
+}
+
+// Completes what the queue's polled ring has finished, submitting what was queued to it first.
+// Every CQE there belongs to a target I/O. Returns the number reaped.
+static int reap_polled(ublksrv_queue const* q, ublkpp_queue_state* qs) {
+    if (0 == qs->polled_inflight) return 0;
+    auto* ring = qs->polled;
+    io_uring_submit(ring);
+    io_uring_cqe* cqe{};
+    if (0 != io_uring_peek_cqe(ring, &cqe)) return 0;
+    unsigned head{};
+    int count{0};
+    io_uring_for_each_cqe(ring, head, cqe) {
+        --qs->polled_inflight;
+        resume_io(q, static_cast< cqe_state* >(sisl::async::decode_managed_user_data(cqe->user_data)), cqe->res);
+        ++count;
+    }
+    io_uring_cq_advance(ring, count);
+    return count;
+}
+
+// Hands the room the CQEs of this pass freed in the queue ring to the I/O waiting for it (see
+// sq_space), oldest first, while it lasts. Each waiter is woken once per pass at most: one that
+// still finds no room has queued itself again.
+static void wake_sq_waiters(ublksrv_queue const* q, ublkpp_queue_state* qs) {
+    if (!qs->waiters) return;
+    auto const now = monotonic_ns();
+    auto* const last = qs->waiters_tail;
+    qs->waking = true;
+    for (auto done = false; !done && qs->waiters && !sq_full(q);) {
+        auto* w = std::exchange(qs->waiters, qs->waiters->next);
+        if (!qs->waiters) qs->waiters_tail = nullptr;
+        done = (last == w);
+        qs->queue_metrics->record_sq_wait(now - std::min(now, w->since_ns));
+        auto const* owner = w->owner; // w may be gone once on_space() returns
+        try {
+            w->on_space(w);
+        } catch (std::exception const& e) {
+            TLOGE("I/O threw exception: [{}]", e.what())
+            fail_io(q, owner);
+        } catch (...) {
+            TLOGE("I/O threw unknown exception")
+            fail_io(q, owner);
+        }
+    }
+    qs->waking = false;
+}
+
+static uint32_t unplug(ublksrv_queue const* q, ublkpp_queue_state* qs);
+static void dispatch(ublksrv_queue const* q, ublkpp_queue_state* qs, io_group const& group);
+
+// Commits the requests siblings have served for this queue (--steal_io). A sibling may wake it
+// again from here on.
+static void take_inbox(ublksrv_queue const* q, ublkpp_queue_state* qs) {
+    qs->wake_sent.store(false, std::memory_order_seq_cst);
+    if (0 == qs->lent) return;
+    {
+        auto lk = std::scoped_lock< std::mutex >(qs->inbox_lock);
+        qs->inbox.swap(qs->inbox_taken);
+    }
+    for (auto const& served : qs->inbox_taken) {
+        --qs->lent;
+        if (served.complete) ublksrv_complete_io(q, served.tag, served.res);
+    }
+    qs->inbox_taken.clear();
+}
+
+// Serves up to `quota` I/Os that sibling queues have on offer (--steal_io), the newest of each,
+// looking at the siblings from the next queue on
+static void steal(ublksrv_queue const* q, ublkpp_queue_state* qs, uint32_t const quota) {
+    auto& tgt = *qs->tgt;
+    if (0 == quota || 0 == tgt.offered.load(std::memory_order_seq_cst) || ublksrv_queue_is_done(q)) return;
+    {
+        auto lk = std::scoped_lock< std::mutex >(tgt.steal_lock);
+        auto const n = tgt.stealers.size();
+        for (auto i = 1UL; n > i && quota > qs->stolen.size(); ++i) {
+            auto* from = static_cast< ublkpp_queue_state* >(tgt.stealers[(q->q_id + i) % n]);
+            if (!from) continue;
+            auto ios = uint64_t{0};
+            from->offers.take_back(quota - qs->stolen.size(), [&](io_group const& g) {
+                ios += g.n;
+                qs->stolen.push_back(g);
+            });
+            if (0 < ios) from->queue_metrics->record_lent(ios);
+        }
+        tgt.offered.fetch_sub(qs->stolen.size(), std::memory_order_seq_cst);
+    }
+    auto ios = uint64_t{0};
+    for (auto const& g : qs->stolen) {
+        ios += g.n;
+        dispatch(q, qs, g);
+    }
+    if (0 < ios) qs->queue_metrics->record_stolen(ios);
+    qs->stolen.clear();
+}
+
+// How long a queue taking part in work stealing may wait: not at all while it has I/O on offer
+// that it serves itself if no sibling does, or siblings have some it may take; at most
+// k_lent_recheck_ns while siblings serve its requests. The queue is marked asleep before it looks,
+// so a sibling offering I/O after that wakes it. Returns whether the wait was cut short.
+static bool steal_wait(ublksrv_queue const* q, ublkpp_queue_state* qs, __kernel_timespec& ts) {
+    qs->sleeping.store(true, std::memory_order_seq_cst);
+    if (qs->offering || (0 < qs->tgt->offered.load(std::memory_order_seq_cst) && !ublksrv_queue_is_done(q))) {
+        qs->sleeping.store(false, std::memory_order_relaxed);
+        ts = {.tv_sec = 0, .tv_nsec = 0};
+        return true;
+    }
+    if (0 == qs->lent || (0 == ts.tv_sec && k_lent_recheck_ns >= static_cast< uint64_t >(ts.tv_nsec))) return false;
+    ts = {.tv_sec = 0, .tv_nsec = static_cast< long long >(k_lent_recheck_ns)};
+    return true;
+}
+
+// One pass over a queue's completions: reaps up to `budget` CQEs from its ring, then what its
+// polled ring has finished, wakes the I/O waiting for room the CQEs freed, commits what siblings
+// served for it, dispatches the plugged batch, steals from siblings with what room that leaves,
+// and resumes the parked I/O that is due, before telling ublksrv whether the queue is idle. `ret`
+// is what waiting for the completions returned. A wait `cut_short` for parked I/O or for work
+// stealing timing out is not idleness: entering idle would have ublksrv discard the I/O buffers
+// that I/O still holds. Returns the I/O completions handled, idle probes and wakes not counted.
+//
+// Target CQEs have bit 63 set; bits 62:0 hold a raw cqe_state* (non-null) for I/O completions
+// or zero for probe timeout CQEs (null-pointer sentinel). Ublk command CQEs delegate to ublksrv.
+static int queue_pass(ublksrv_queue const* q, ublkpp_queue_state* qs, int const ret, bool const cut_short,
+                      uint32_t const budget) {
+    auto* ring = q->ring_ptr;
+    io_uring_cqe* cqe{};
+    unsigned head{};
+    uint32_t count{0};
+    int probe_count{0}; // probe timeout CQEs must not count as work for ublksrv_queue_update_idle
+    auto const wake = wake_user_data();
+    io_uring_for_each_cqe(ring, head, cqe) {
+        if (budget == count) break;
+        if (wake == cqe->user_data) {
+            // A sibling's wake (--steal_io): the pass itself is what it asked for
+            ++probe_count;
+        } else if (sisl::async::is_managed_user_data(cqe->user_data)) {
+            if (0 < qs->inflight) --qs->inflight; // Its SQE came from next_sqe(q)
+            auto* state = static_cast< cqe_state* >(sisl::async::decode_managed_user_data(cqe->user_data));
+            if (!state) {
+                // probe timeout CQE — only ETIME triggers a probe tick; other results ignored.
+                // Excluded from io_count: counting it as work triggers idle_exit, setting
+                // is_idle=false and preventing the probe from re-arming on subsequent fires.
+                ++probe_count;
+                if (is_probe_done(cqe)) --qs->probes_armed;
+                if (cqe->res == -ETIME) {
+                    // Gate check before capturing device: if _shutting_down is false,
+                    // begin_shutdown's seq_cst store has not committed yet — so
+                    // device = {} has not been called. Atomic load gives a well-defined
+                    // shared_ptr copy; the local ref keeps the disk alive if device = {}
+                    // fires on another thread immediately after.
+                    if (!qs->tgt->_shutting_down.load(std::memory_order_seq_cst)) {
+                        if (auto dev = qs->tgt->device.load()) dev->probe_tick(q);
                     }
+                    if (qs->is_idle && !qs->tgt->_shutting_down.load(std::memory_order_relaxed))
+                        submit_probe_timeout(q);
                 }
             } else {
-                // ublk command CQE (FETCH/COMMIT) -- delegate to libublksrv
-                ublksrv_handle_cmd_cqe(q, cqe);
+                // target io_uring CQE — resume the coroutine waiting on this cqe_state
+                resume_io(q, state, cqe->res);
             }
-            ++count;
+        } else {
+            // ublk command CQE (FETCH/COMMIT) -- delegate to libublksrv
+            ublksrv_handle_cmd_cqe(q, cqe);
         }
-        io_uring_cq_advance(ring, count);
-        ublksrv_queue_update_idle(q, ret, count - probe_count);
-        queue_done = ublksrv_queue_is_done(q);
+        ++count;
     }
+    io_uring_cq_advance(ring, count);
+    auto const polled = reap_polled(q, qs);
+    wake_sq_waiters(q, qs);
+    if (qs->lending) take_inbox(q, qs);
+    auto const own = unplug(q, qs);
+    if (qs->lending) steal(q, qs, steal_quota(own, qs->tgt->steal_batch));
+    release_parked(q, qs);
+    // The pass may have completed the last detached_io the drain waits for
+    if (0 < count && qs->tgt->_shutting_down.load(std::memory_order_seq_cst)) qs->tgt->try_drain();
+    auto const work = static_cast< int >(count) - probe_count + polled;
+    ublksrv_queue_update_idle(q, (cut_short && -ETIME == ret) ? 0 : ret, work);
+    return work;
+}
+
+// A queue stops once ublksrv has no request of it pending, its requests served by siblings are
+// committed, the I/O it took from them is done, and no driver I/O outliving its request (detached_io)
+// is left on the target: that may run on this queue's ring.
+static bool queue_finished(ublksrv_queue const* q, ublkpp_queue_state const* qs) {
+    return ublksrv_queue_is_done(q) && 0 == qs->lent && 0 == qs->borrowed &&
+        0 == qs->tgt->detached.load(std::memory_order_acquire);
+}
 
+// Our own CQE processing loop, replacing ublksrv_process_io: the queue thread waits for
+// completions and runs a pass over all of them.
+//
+// Drain correctness: ublksrv_queue_is_done returns true only when ublksrv has no pending I/O
+// commands. We call ublksrv_complete_io at the end of __handle_io_async, after co_await
+// device->async_iov returns, so the scope is already empty when the loop exits. on_empty()
+// completes synchronously via its fast path. The same holds for the polled ring (--iopoll), whose
+// CQEs are reaped after each pass over the queue ring; with polled I/O in flight the loop spins
+// instead of sleeping. I/O waiting for room in the ring is woken once a pass has reaped its CQEs,
+// before new requests are dispatched. The queue stops once queue_finished().
+static exec::task< void > run_queue_loop(ublksrv_queue const* q, ublkpp_queue_state* qs) {
+    auto* ring = q->ring_ptr;
+    bool queue_done = false;
+
+    while (!queue_done) {
+        io_uring_cqe* cqe{};
+        auto ts = queue_wait(qs);
+        auto cut_short = !qs->parked.empty();
+        if (qs->lending) cut_short = steal_wait(q, qs, ts) || cut_short;
+        auto ret = 0;
+        if (0 < qs->polled_inflight)
+            ret = poll_rings(ring, qs);
+        else if (qs->poll)
+            ret = poll_and_wait(ring, qs, &ts);
+        else
+            ret = io_uring_submit_and_wait_timeout(ring, &cqe, 1, &ts, nullptr);
+
+        qs->sleeping.store(false, std::memory_order_relaxed);
+
+        queue_pass(q, qs, ret, cut_short, std::numeric_limits< uint32_t >::max());
+        queue_done = queue_finished(q, qs);
+    }
+
+    cancel_probes(q, qs);
     co_await qs->scope.on_empty();
 }
 
-static void* ublksrv_queue_handler(std::shared_ptr< ublkpp_tgt_impl > target, int q_id, sem_t* queue_sem,
-                                   int* queue_ok) {
-    if (SISL_OPTIONS["sched"].as< std::string >() == "fifo") {
-        sched_param sp{.sched_priority = sched_get_priority_max(SCHED_FIFO)};
-        if (int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp); rc != 0)
-            TLOGE("queue {}: failed to set SCHED_FIFO: {}", q_id, strerror(rc))
+// IORING_SETUP_SINGLE_ISSUER holds in every mode: only the queue thread submits. SQPOLL moves
+// submission to a kernel thread and does not take the *_TASKRUN flags.
+static unsigned ring_setup_flags(ring_mode const mode) noexcept {
+    switch (mode) {
+    case ring_mode::DEFER_TASKRUN:
+        return IORING_SETUP_DEFER_TASKRUN | IORING_SETUP_SINGLE_ISSUER;
+    case ring_mode::SQPOLL:
+        return IORING_SETUP_SQPOLL | IORING_SETUP_SINGLE_ISSUER;
+    case ring_mode::COOP_TASKRUN:
+    default:
+        return IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SINGLE_ISSUER;
     }
+}
+
+static bool pin_to_cpu(int q_id, int cpu) {
+    auto set = cpu_set_t{};
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); rc != 0) {
+        TLOGW("queue {}: failed to pin to cpu {}: {}", q_id, cpu, strerror(rc))
+        return false;
+    }
+    return true;
+}
+
+// Runs the calling queue thread on `cpu` and has the kernel prefer that CPU's NUMA node for what
+// the thread allocates from here on: the queue's io_uring and I/O buffers (ublksrv_queue_init) and
+// the async_io pools (init_queue). Failures are logged and leave the thread where it was.
+static void place_queue(int q_id, int cpu) {
+    if (!pin_to_cpu(q_id, cpu)) return;
+    auto cur = 0U;
+    auto node = 0U;
+    if (0 != syscall(SYS_getcpu, &cur, &node, nullptr)) return;
+    auto nodes = std::vector< unsigned long >(node / 64 + 1, 0UL);
+    nodes[node / 64] = 1UL << (node % 64);
+    if (0 != syscall(SYS_set_mempolicy, MPOL_PREFERRED, nodes.data(), nodes.size() * 64 + 1)) {
+        TLOGW("queue {}: failed to prefer NUMA node {}: {}", q_id, node, strerror(errno))
+        return;
+    }
+    TLOGD("queue {} placed on cpu {}, node {}", q_id, cpu, node)
+}
+
+// Scheduler policy of a queue thread: --sched, or SCHED_IDLE while the target's I/O is idle class
+static void set_queue_sched(pthread_t thread, int q_id, uint16_t ioprio) {
+    auto policy = SCHED_OTHER;
+    if (IOPRIO_CLASS_IDLE == IOPRIO_PRIO_CLASS(ioprio))
+        policy = SCHED_IDLE;
+    else if (SISL_OPTIONS["sched"].as< std::string >() == "fifo")
+        policy = SCHED_FIFO;
+    sched_param sp{.sched_priority = (SCHED_FIFO == policy) ? sched_get_priority_max(SCHED_FIFO) : 0};
+    if (int rc = pthread_setschedparam(thread, policy, &sp); rc != 0)
+        TLOGE("queue {}: failed to set scheduler policy {}: {}", q_id, policy, strerror(rc))
+}
+
+// Sets up queue `q_id` of `target` on the calling thread, which serves it from here on: its state,
+// polled ring (--iopoll) and ublk queue, the thread pinned back to `cpu` after. nullptr on failure.
+// A shared reactor's queue rings run coop_taskrun whatever the target asks, without busy-poll or
+// registered ring fds: a reactor polls their fds, spins on none of them, and the kernel registers
+// only a handful of ring fds per thread.
+static std::unique_ptr< ublkpp_queue_state > open_queue(std::shared_ptr< ublkpp_tgt_impl > const& target, int q_id,
+                                                        int cpu) {
+    auto const shared = target->shared_reactors;
+    auto const mode = shared ? ring_mode::COOP_TASKRUN : target->ring.mode;
     auto qs = std::make_unique< ublkpp_queue_state >(target);
+    qs->queue_metrics = std::make_unique< UblkQueueMetrics >(to_string(target->volume_uuid), q_id);
+    qs->inflight_max = target->ring_inflight;
+    qs->detached = &target->detached;
+    auto ring_flags = ring_setup_flags(mode);
+    if (auto const poll_us = SISL_OPTIONS["busy_poll_us"].as< uint32_t >(); 0 < poll_us && !shared) {
+        qs->poll.emplace(uint64_t{poll_us} * 1000, 0 < SISL_OPTIONS["busy_poll_adaptive"].count());
+        qs->queue_metrics->record_poll_window(qs->poll->window_ns());
+        if (ring_mode::SQPOLL != mode) ring_flags |= IORING_SETUP_TASKRUN_FLAG;
+    }
+    qs->plugging = (0 < SISL_OPTIONS["plug_merge"].count());
+    qs->lending = target->steal_io;
+    // Without it, polled I/O is submitted to the queue ring like the rest
+    if (auto const depth = target->polled_ring_depth; 0 < depth) {
+        if (auto const ret =
+                io_uring_queue_init(depth, &qs->polled_ring, IORING_SETUP_IOPOLL | IORING_SETUP_SINGLE_ISSUER);
+            0 == ret) {
+            qs->polled = &qs->polled_ring;
+            if (ring_mode::SQPOLL != mode) ring_flags |= IORING_SETUP_TASKRUN_FLAG;
+        } else {
+            TLOGW("queue {}: failed to set up polled ring: {}", q_id, strerror(-ret))
+        }
+    }
 
     // Initialize UBlkSrv IOUring queue and bind queue state pointer
-    // NOTE: Removed IORING_SETUP_DEFER_TASK as it was blocking ublksrv_ctrl_del_dev,
-    // look at adding this back as it theoretically could improve performance.
-    auto q = ublksrv_queue_init_flags(target->ublk_dev, q_id, qs.get(),
-                                      IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SINGLE_ISSUER);
+    auto q = ublksrv_queue_init_flags(target->ublk_dev, q_id, static_cast< queue_rings* >(qs.get()), ring_flags);
+    if (!q) {
+        TLOGE("ublk dev queue {} init queue failed", q_id)
+        if (qs->polled) io_uring_queue_exit(qs->polled);
+        return nullptr;
+    }
+    // A registered ring fd spares io_uring_enter() its fd lookup; liburing unregisters it on exit
+    if (target->ring.register_fd && !shared) {
+        if (auto const ret = io_uring_register_ring_fd(q->ring_ptr); 1 != ret)
+            TLOGW("queue {}: failed to register ring fd: {}", q_id, ret)
+        if (qs->polled) {
+            if (auto const ret = io_uring_register_ring_fd(qs->polled); 1 != ret)
+                TLOGW("queue {}: failed to register polled ring fd: {}", q_id, ret)
+        }
+    }
+    // Queue init moves the thread to the queue's whole affinity mask; narrow it again
+    if (0 <= cpu) pin_to_cpu(q_id, cpu);
+    // One entry per tag at most, so handle_io_async() and unplug() never allocate; nor do the
+    // inbox and steal() with a batch at most
+    if (qs->plugging || qs->lending) {
+        qs->plug.reserve(q->q_depth);
+        qs->batch.reserve(q->q_depth);
+    }
+    if (qs->lending) {
+        qs->inbox.reserve(q->q_depth);
+        qs->inbox_taken.reserve(q->q_depth);
+        qs->stolen.reserve(target->steal_batch);
+    }
+    qs->q = q;
+    return qs;
+}
+
+// Releases a queue that is done. Every I/O has completed, so nothing is left in flight on it.
+static void close_queue(ublkpp_queue_state* qs) {
+    TLOGD("ublk dev queue {} exited", qs->q->q_id)
+    ublksrv_queue_deinit(qs->q);
+    if (qs->polled) io_uring_queue_exit(qs->polled);
+}
+
+static void* ublksrv_queue_handler(std::shared_ptr< ublkpp_tgt_impl > target, int q_id, int cpu, sem_t* queue_sem,
+                                   int* queue_ok) {
+    if (0 <= cpu) place_queue(q_id, cpu);
+    set_queue_sched(pthread_self(), q_id, target->ioprio.load(std::memory_order_relaxed));
+    auto qs = open_queue(target, q_id, cpu);
 
     // Each thread writes to its own slot — no concurrent writes to the same location.
     // sem_post provides the release that pairs with start()'s sem_wait acquire, so no
     // atomic needed: start() reads queue_ok[] only after all sem_waits complete.
-    if (!q) *queue_ok = 0;
+    if (!qs) *queue_ok = 0;
     sem_post(queue_sem);
     target.reset();
 
     // If queue initialization failed, exit
-    if (!q) {
-        TLOGE("ublk dev queue {} init queue failed", q_id)
-        return NULL;
-    }
+    if (!qs) return NULL;
 
-    TLOGD("tid {}: ublk dev queue {} started", ublksrv_gettid(), q->q_id)
-    stdexec::sync_wait(run_queue_loop(q, qs.get()));
-    TLOGD("ublk dev queue {} exited", q->q_id)
-    ublksrv_queue_deinit(q);
+    // Siblings steal from it, and wake it to steal, only while it runs (--steal_io)
+    auto const lending = qs->lending;
+    if (lending) {
+        auto lk = std::scoped_lock< std::mutex >(qs->tgt->steal_lock);
+        qs->tgt->stealers[q_id] = qs.get();
+    }
+    TLOGD("tid {}: ublk dev queue {} started", ublksrv_gettid(), q_id)
+    stdexec::sync_wait(run_queue_loop(qs->q, qs.get()));
+    if (lending) {
+        auto lk = std::scoped_lock< std::mutex >(qs->tgt->steal_lock);
+        qs->tgt->stealers[q_id] = nullptr;
+    }
+    close_queue(qs.get());
     return NULL;
 }
 
+// A shared reactor (--shared_reactors, see reactor.hpp): the thread serving the queues placed on
+// its CPU, of every target. It sleeps on its hub ring, where a multishot poll of each queue's ring
+// fd completes whenever that ring has CQEs, and a poll of an eventfd whenever a job is posted to it.
+// Woken, it runs a queue_pass() over each queue that is ready, round robin and at most
+// k_reactor_budget CQEs at a time, and submits what the pass queued. It sleeps no longer than the
+// queue waits it stands in for (QoS releases, idle), and not at all while a queue has polled I/O
+// in flight. Jobs run on the reactor itself, as queues must be set up by the thread that issues to
+// their rings (IORING_SETUP_SINGLE_ISSUER). Reactors live until the process exits, when they are
+// stopped and joined; every target is destroyed, and its queues retired, before then.
+class reactor {
+public:
+    explicit reactor(int const cpu) : _cpu(cpu) {}
+    ~reactor() {
+        if (!_thread.joinable()) return;
+        _stop.store(true, std::memory_order_release);
+        if (0 <= _event_fd) post([] {});
+        _thread.join();
+    }
+
+    // Starts the thread; false when its hub ring could not be set up
+    bool start() {
+        auto up = std::promise< bool >();
+        auto ok = up.get_future();
+        _thread = sisl::named_thread(fmt::format("reactor_{}", _cpu), [this, up = std::move(up)]() mutable {
+            run(up);
+        });
+        return ok.get();
+    }
+
+    // Sets up queue `q_id` of `target` on the reactor and serves it until it is done; as a queue
+    // thread would, clears *queue_ok on failure and posts `queue_sem` either way
+    void add_queue(std::shared_ptr< ublkpp_tgt_impl > target, int q_id, sem_t* queue_sem, int* queue_ok) {
+        post([this, target = std::move(target), q_id, queue_sem, queue_ok]() mutable {
+            if (auto qs = open_queue(target, q_id, _cpu); qs) {
+                target->reactor_queues.fetch_add(1, std::memory_order_relaxed);
+                TLOGD("reactor {}: ublk dev queue {} started", _cpu, q_id)
+                serve(std::move(qs));
+            } else
+                *queue_ok = 0;
+            target.reset();
+            sem_post(queue_sem);
+        });
+    }
+
+    // Queues served here, for placement
+    uint32_t served() const noexcept { return _served.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr unsigned k_hub_depth = 256;
+    static constexpr uint64_t k_jobs_key = 0; // Hub user_data of the eventfd poll; no queue's key
+    static constexpr uint64_t k_idle_ns = uint64_t{k_io_idle_secs} * 1000000000;
+
+    void post(std::function< void() > job) {
+        {
+            auto lk = std::scoped_lock< std::mutex >(_lock);
+            _jobs.push_back(std::move(job));
+        }
+        eventfd_write(_event_fd, 1);
+    }
+
+    void run_jobs() {
+        auto value = eventfd_t{};
+        eventfd_read(_event_fd, &value);
+        auto jobs = std::vector< std::function< void() > >();
+        {
+            auto lk = std::scoped_lock< std::mutex >(_lock);
+            jobs.swap(_jobs);
+        }
+        for (auto& job : jobs)
+            job();
+    }
+
+    void arm(int const fd, uint64_t const key) {
+        if (auto* sqe = next_sqe(&_hub); sqe) {
+            io_uring_prep_poll_multishot(sqe, fd, POLLIN);
+            io_uring_sqe_set_data64(sqe, key);
+        }
+    }
+
+    void serve(std::unique_ptr< ublkpp_queue_state > qs) {
+        auto* state = qs.get();
+        state->active_ns = monotonic_ns();
+        state->reactor_key = _queues.add(std::move(qs));
+        _served.fetch_add(1, std::memory_order_relaxed);
+        arm(state->q->ring_ptr->ring_fd, state->reactor_key);
+        io_uring_submit(state->q->ring_ptr);
+        _ready.mark(decltype(_queues)::slot_of(state->reactor_key));
+    }
+
+    // One turn of a ready queue. A queue with I/O done for k_io_idle_secs is told it timed out, as
+    // its own thread's wait would have; one with CQEs left over, or polled I/O in flight, is ready
+    // again behind the others.
+    void serve_ready(uint32_t const slot, uint64_t const now) {
+        auto* qs = _queues.at(slot);
+        if (!qs) return;
+        auto const idle = qs->parked.empty() && 0 == qs->polled_inflight && k_idle_ns <= now - qs->active_ns;
+        auto const work = queue_pass(qs->q, qs, idle ? -ETIME : 0, false, k_reactor_budget);
+        if (0 < work || idle) qs->active_ns = now;
+        if (queue_finished(qs->q, qs)) {
+            retire(qs);
+            return;
+        }
+        io_uring_submit(qs->q->ring_ptr);
+        if (0 < io_uring_cq_ready(qs->q->ring_ptr) || 0 < qs->polled_inflight) _ready.mark(slot);
+    }
+
+    // Releases a queue that is done and tells its target, whose destroy() waits for it. The poll
+    // of its ring fd goes first: it holds the ring file, and with it the ublk char device, open.
+    void retire(ublkpp_queue_state* qs) {
+        auto const key = qs->reactor_key;
+        if (auto* sqe = next_sqe(&_hub); sqe) {
+            io_uring_prep_poll_remove(sqe, key);
+            io_uring_sqe_set_data64(sqe, key);
+        }
+        io_uring_submit(&_hub);
+        cancel_probes(qs->q, qs);
+        stdexec::sync_wait(qs->scope.on_empty());
+        close_queue(qs);
+        auto owned = _queues.remove(key);
+        _served.fetch_sub(1, std::memory_order_relaxed);
+        auto tgt = std::move(owned->tgt);
+        owned.reset();
+        tgt->reactor_queues.fetch_sub(1, std::memory_order_release);
+        tgt->reactor_queues.notify_all();
+    }
+
+    // Marks the queues that have CQEs, or whose wait would have ended by now; returns how long the
+    // reactor may sleep before the next one does
+    __kernel_timespec expire(uint64_t const now) {
+        auto wake = now + k_idle_ns;
+        _queues.for_each([&](uint32_t const slot, ublkpp_queue_state const& qs) {
+            auto due = qs.active_ns + k_idle_ns;
+            if (!qs.parked.empty()) due = std::min(qs.parked.top().release_ns, now + k_qos_recheck_ns);
+            if (due <= now || 0 < qs.polled_inflight || 0 < io_uring_cq_ready(qs.q->ring_ptr))
+                _ready.mark(slot);
+            else
+                wake = std::min(wake, due);
+        });
+        auto const ns = _ready.empty() ? wake - now : 0;
+        return {.tv_sec = static_cast< long long >(ns / 1000000000),
+                .tv_nsec = static_cast< long long >(ns % 1000000000)};
+    }
+
+    void run(std::promise< bool >& up) {
+        if (0 <= _cpu) place_queue(-1, _cpu);
+        set_queue_sched(pthread_self(), -1, 0);
+        if (auto const ret = io_uring_queue_init(k_hub_depth, &_hub,
+                                                 IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SINGLE_ISSUER);
+            0 != ret) {
+            TLOGE("reactor {}: failed to set up hub ring: {}", _cpu, strerror(-ret))
+            up.set_value(false);
+            return;
+        }
+        _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        arm(_event_fd, k_jobs_key);
+        io_uring_submit(&_hub);
+        TLOGI("Reactor started on cpu {}", _cpu)
+        up.set_value(true);
+
+        while (!_stop.load(std::memory_order_acquire)) {
+            auto now = monotonic_ns();
+            for (auto n = _ready.size(); 0 < n; --n)
+                serve_ready(*_ready.next(), now);
+
+            now = monotonic_ns();
+            auto ts = expire(now);
+            io_uring_cqe* cqe{};
+            if (0 < ts.tv_sec || 0 < ts.tv_nsec)
+                io_uring_submit_and_wait_timeout(&_hub, &cqe, 1, &ts, nullptr);
+            else
+                io_uring_submit(&_hub);
+
+            auto posted = false;
+            unsigned head{};
+            unsigned count{0};
+            io_uring_for_each_cqe(&_hub, head, cqe) {
+                auto const key = cqe->user_data;
+                // A multishot poll ends on error or overflow; one still wanted is armed again
+                auto const rearm = !(cqe->flags & IORING_CQE_F_MORE);
+                if (k_jobs_key == key) {
+                    posted = true;
+                    if (rearm) arm(_event_fd, k_jobs_key);
+                } else if (auto* qs = _queues.find(key); qs) {
+                    _ready.mark(decltype(_queues)::slot_of(key));
+                    if (rearm) arm(qs->q->ring_ptr->ring_fd, key);
+                }
+                ++count;
+            }
+            io_uring_cq_advance(&_hub, count);
+            if (posted) run_jobs();
+        }
+        // Stopped at exit, where the logger may be gone already: nothing is logged from here
+        io_uring_queue_exit(&_hub);
+        close(_event_fd);
+    }
+
+    int const _cpu;
+    std::atomic< uint32_t > _served{0};
+    std::mutex _lock;
+    std::vector< std::function< void() > > _jobs;
+    int _event_fd{-1};
+    std::atomic< bool > _stop{false};
+    std::thread _thread;
+    // Owned by the reactor thread
+    io_uring _hub{};
+    reactor_slots< ublkpp_queue_state > _queues;
+    ready_ring _ready;
+};
+
+static std::mutex _reactor_lock;
+static std::map< int, std::unique_ptr< reactor > > _reactors;
+
+// The reactor of `cpu`, started on first use; nullptr if it could not be. Kept until the process
+// exits, when destroying _reactors stops and joins each one.
+static reactor* reactor_on(int const cpu) {
+    auto lk = std::scoped_lock< std::mutex >(_reactor_lock);
+    if (auto it = _reactors.find(cpu); _reactors.end() != it) return it->second.get();
+    auto r = std::make_unique< reactor >(cpu);
+    if (!r->start()) return nullptr;
+    return _reactors.emplace(cpu, std::move(r)).first->second.get();
+}
+
+// Queues the reactor of each CPU serves, by CPU
+static std::vector< uint32_t > reactor_loads() {
+    auto lk = std::scoped_lock< std::mutex >(_reactor_lock);
+    auto load = std::vector< uint32_t >(CPU_SETSIZE, 0);
+    for (auto const& [cpu, r] : _reactors)
+        if (0 <= cpu) load[cpu] = r->served();
+    return load;
+}
+
 static std::expected< std::filesystem::path, std::error_condition > start(std::shared_ptr< ublkpp_tgt_impl > tgt) {
     TLOGD("Initializing Ctrl Device")
     if (!tgt->device_recovering) { // NORMAL Path
@@ -239,6 +1079,23 @@ static std::expected< std::filesystem::path, std::error_condition > start(std::s
         return std::unexpected(std::make_error_condition(std::errc::invalid_argument));
     }
 
+    // One CPU per queue from the masks just read, within the CPUs this process may use
+    auto queue_cpus = std::vector< int >(dinfo->nr_hw_queues, -1);
+    if (tgt->pin_queues) {
+        auto allowed = cpu_set_t{};
+        CPU_ZERO(&allowed);
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        auto masks = std::vector< cpu_set_t >(dinfo->nr_hw_queues);
+        for (auto i = 0; i < dinfo->nr_hw_queues; ++i) {
+            if (auto const* mask = ublksrv_get_queue_affinity(tgt->ctrl_dev, i); mask)
+                masks[i] = *mask;
+            else
+                masks[i] = allowed;
+        }
+        queue_cpus = tgt->shared_reactors ? plan_reactor_cpus(masks, allowed, reactor_loads())
+                                          : plan_queue_cpus(masks, allowed);
+    }
+
     TLOGD("Start ublksrv io daemon {}-{}", "ublkpp", tgt->dev_data->dev_id)
 
     // Target is about to initialize! Insert into our map
@@ -262,9 +1119,18 @@ static std::expected< std::filesystem::path, std::error_condition > start(std::s
     sem_t queue_sem;
     sem_init(&queue_sem, 0, 0);
     auto queue_ok = std::vector< int >(dinfo->nr_hw_queues, 1);
+    if (tgt->steal_io) tgt->stealers.assign(dinfo->nr_hw_queues, nullptr);
     for (auto i = 0; i < dinfo->nr_hw_queues; ++i) {
-        tgt->queue_handlers.push_back(sisl::named_thread(fmt::format("q_{}_{}", tgt->dev_data->dev_id, i),
-                                                         ublksrv_queue_handler, tgt, i, &queue_sem, &queue_ok[i]));
+        if (!tgt->shared_reactors) {
+            tgt->queue_handlers.push_back(sisl::named_thread(fmt::format("q_{}_{}", tgt->dev_data->dev_id, i),
+                                                             ublksrv_queue_handler, tgt, i, queue_cpus[i],
+                                                             &queue_sem, &queue_ok[i]));
+        } else if (auto* r = reactor_on(queue_cpus[i]); r) {
+            r->add_queue(tgt, i, &queue_sem, &queue_ok[i]);
+        } else {
+            queue_ok[i] = 0;
+            sem_post(&queue_sem);
+        }
     }
     auto const recovery = tgt->device_recovering;
     auto const dev_name = fmt::format("{}", *tgt->device.load());
@@ -285,8 +1151,8 @@ static std::expected< std::filesystem::path, std::error_condition > start(std::s
     }
 
     // Drop start()'s reference; the impl is now owned by ublkpp_tgt._p and each queue
-    // thread's qs->tgt (shared_ptr<ublkpp_tgt_impl>). The impl stays alive until both
-    // ublkpp_tgt is destroyed AND all queue threads exit and their qs destructs.
+    // thread's (or reactor's) qs->tgt (shared_ptr<ublkpp_tgt_impl>). The impl stays alive until
+    // both ublkpp_tgt is destroyed AND all queues exit and their qs destructs.
     tgt.reset();
 
     // Start processing I/Os
@@ -312,7 +1178,7 @@ static std::expected< std::filesystem::path, std::error_condition > start(std::s
 // See all_idle() for the memory-ordering argument.
 void ublkpp_tgt_impl::try_drain() {
     if (!_shutting_down.load(std::memory_order_acquire)) return;
-    if (metrics.all_idle()) {
+    if (metrics.all_idle() && 0 == detached.load(std::memory_order_seq_cst)) {
         bool expected = false;
         if (_device_reset_done.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
             TLOGI("All I/O drained after shutdown - flushing backing store")
@@ -323,14 +1189,26 @@ void ublkpp_tgt_impl::try_drain() {
     }
 }
 
-static exec::task< void > __handle_io_async(ublksrv_queue const* q, ublk_io_data const* data) {
-    auto* qs = static_cast< ublkpp_queue_state* >(q->private_data);
-
+static exec::task< void > __handle_io_async(ublksrv_queue const* q, io_group const group) {
+    auto* qs = queue_state(q);
+    auto const members = std::span(group.data.data(), group.n);
+    auto const* data = members.front();
+    // Taken from a sibling (--steal_io): served on this queue's ring, committed on its own
+    auto const stolen = io_of(data)->_home && q != io_of(data)->_home;
+    auto const borrow = borrowed_io(stolen ? &qs->borrowed : nullptr);
+
+    for (auto i = 0U; members.size() > i; ++i) {
+        auto* member = reinterpret_cast< async_io* >(members[i]->private_data);
+        member->_tag = members[i]->tag;
+        member->_merge_next =
+            (members.size() > i + 1) ? reinterpret_cast< async_io const* >(members[i + 1]->private_data) : nullptr;
+    }
     auto io = reinterpret_cast< async_io* >(data->private_data);
     io->_pool.clear();
-    io->_tag = data->tag;
+    io->_ioprio = qs->tgt->ioprio.load(std::memory_order_relaxed);
 
     auto const op = ublksrv_get_op(data->iod);
+    auto const req_bytes = [](ublk_io_data const* d) { return uint64_t{d->iod->nr_sectors} << SECTOR_SHIFT; };
 
     // Increment before the shutdown gate: a concurrent drain check that sees counters==0 would
     // otherwise assign device = {} while we are still about to use the raw device* pointer.
@@ -339,75 +1217,214 @@ static exec::task< void > __handle_io_async(ublksrv_queue const* q, ublk_io_data
     // seq_cst store and all_idle()'s seq_cst loads. Either the increment precedes the store in
     // S (begin_shutdown's counter reads see it → skips reset) or the store precedes the
     // increment in S (our gate check below sees _shutting_down=true → drops).
-    qs->tgt->metrics.record_queue_depth_change(q, op, true);
+    for (auto i = 0U; members.size() > i; ++i)
+        qs->tgt->metrics.record_queue_depth_change(q, op, true);
 
     // Drain gate: during shutdown DROP every op (leave it uncompleted / OWNED_BY_SRV) so the kernel
     // requeues it to the next daemon under UBLK_F_USER_RECOVERY(_REISSUE) on exit. Completing with
     // -EAGAIN instead maps to BLK_STS_AGAIN, which the block layer logs as "nonblocking retry error"
     // and fails.
     if (qs->tgt->_shutting_down.load(std::memory_order_seq_cst)) {
-        qs->tgt->metrics.record_queue_depth_change(q, op, false); // undo pre-gate increment (no-op for FLUSH)
-        TLOGD("Dropping I/O [tag:{:#0x}] during shutdown", data->tag)
+        for (auto const* m : members) {
+            qs->tgt->metrics.record_queue_depth_change(q, op, false); // undo pre-gate increment (no-op for FLUSH)
+            TLOGD("Dropping I/O [tag:{:#0x}] during shutdown", m->tag)
+            if (stolen) finish_io(q, io_of(m), 0, false);
+        }
         qs->tgt->try_drain(); // dropped op may be the last in-flight
         co_return;
     }
 
-    uint32_t bytes_transferred = 0;
+    // QoS: park until the target's buckets let this I/O through, each merged request taking its
+    // own share. Parked I/O is still counted in flight, so a drain waits for it; shutdown releases
+    // it at once.
+    if (op != UBLK_IO_OP_FLUSH && qs->tgt->qos.limited()) {
+        auto const arrival = monotonic_ns();
+        auto now = arrival;
+        auto const moves_data = (op == UBLK_IO_OP_READ || op == UBLK_IO_OP_WRITE);
+        for (auto gen = qs->tgt->qos.generation();;) {
+            auto release = now;
+            for (auto const* m : members)
+                release =
+                    std::max(release, qs->tgt->qos.admit(op == UBLK_IO_OP_READ, moves_data ? req_bytes(m) : 0, now));
+            if (release <= now) break;
+            co_await park_until{qs, release, io};
+            now = monotonic_ns();
+            // Released on schedule, or by shutdown; re-admitted when the limits changed
+            if (auto const cur = qs->tgt->qos.generation();
+                cur == gen || qs->tgt->_shutting_down.load(std::memory_order_relaxed))
+                break;
+            else
+                gen = cur;
+        }
+        if (arrival < now)
+            for (auto i = 0U; members.size() > i; ++i)
+                qs->tgt->metrics.record_io_throttled(op, (now - arrival) / 1000);
+    }
+
     int result;
     if (op == UBLK_IO_OP_FLUSH) {
         result = 0;
     } else {
         auto* device = reinterpret_cast< ublk_disk* >(q->dev->tgt.tgt_data);
-        auto const* iod = data->iod;
+        auto const addr = data->iod->start_sector << SECTOR_SHIFT;
         // Frame-local: io_uring reads iov contents at submit time (deferred to the queue loop's
         // submit_and_wait_timeout). thread_local would be overwritten by sibling __handle_io_async
         // coroutines spawned in the same CQE batch before the kernel sees the SQE. The coroutine
-        // frame is alive across co_await, so the iov is valid through the whole IO lifetime.
-        iovec iov{.iov_base = reinterpret_cast< void* >(iod->addr), .iov_len = iod->nr_sectors << SECTOR_SHIFT};
+        // frame is alive across co_await, so the iovs are valid through the whole IO lifetime.
+        // A merged read or write takes one iovec per request; a merged DISCARD / WRITE_ZEROES is
+        // one longer range.
+        std::array< iovec, k_max_merge > iovs;
+        auto nr_vecs = 0U;
+        auto len = uint64_t{0};
+        auto const ranged = (op == UBLK_IO_OP_DISCARD || op == UBLK_IO_OP_WRITE_ZEROES);
+        for (auto const* m : members) {
+            if (!ranged || 0 == nr_vecs)
+                iovs[nr_vecs++] = {.iov_base = reinterpret_cast< void* >(m->iod->addr), .iov_len = 0};
+            iovs[nr_vecs - 1].iov_len += req_bytes(m);
+            len += req_bytes(m);
+        }
         auto const io_start = std::chrono::steady_clock::now();
-        result = co_await device->async_iov(q, data, &iov, 1, iod->start_sector << SECTOR_SHIFT);
+        result = co_await device->async_iov(q, data, iovs.data(), nr_vecs, addr);
         auto const latency_us = static_cast< uint64_t >(
             std::chrono::duration_cast< std::chrono::microseconds >(std::chrono::steady_clock::now() - io_start)
                 .count());
-        qs->tgt->metrics.record_io_latency(op, latency_us);
-        // iov_len not result: ublk delivers full completions; drivers may co_return 0 on success.
-        if (result >= 0) bytes_transferred = static_cast< uint32_t >(iov.iov_len);
+        for (auto i = 0U; members.size() > i; ++i)
+            qs->tgt->metrics.record_io_latency(op, latency_us);
+        // Marked whatever the result: a failed write may still have reached part of the range.
+        if (UBLK_IO_OP_READ != op) {
+            if (auto* cbt = qs->tgt->_cbt.load(std::memory_order_acquire); cbt) cbt->mark(addr, len);
+        }
     }
 
-    qs->tgt->metrics.record_queue_depth_change(q, op, false);
-    if (bytes_transferred > 0) qs->tgt->metrics.record_io_bytes(op, bytes_transferred);
+    auto done = uint64_t{0};
+    for (auto const* m : members) {
+        qs->tgt->metrics.record_queue_depth_change(q, op, false);
+        // Request length not result: ublk delivers full completions; drivers may co_return 0 on
+        // success. A merged I/O's result is handed to its requests in order (merged_result()), so
+        // a short one completes those it reaches and fails the rest.
+        auto res = result;
+        auto bytes = req_bytes(m);
+        if (1 < members.size()) {
+            res = merged_result(result, done, bytes);
+            done += bytes;
+            if (0 < res) bytes = static_cast< uint64_t >(res);
+        }
+        if (0 <= res && op != UBLK_IO_OP_FLUSH) qs->tgt->metrics.record_io_bytes(op, static_cast< uint32_t >(bytes));
 
-    if (0 > result) [[unlikely]] {
-        TLOGE("Returning error for [tag:{:#0x}] [res:{}]", data->tag, result)
-        qs->tgt->metrics.record_io_error(op);
-    } else {
-        TLOGT("I/O complete [tag:{:#0x}] [res:{}]", data->tag, result)
+        if (0 > res) [[unlikely]] {
+            TLOGE("Returning error for [tag:{:#0x}] [res:{}]", m->tag, res)
+            qs->tgt->metrics.record_io_error(op);
+        } else {
+            TLOGT("I/O complete [tag:{:#0x}] [res:{}]", m->tag, res)
+        }
+        finish_io(q, io_of(m), res);
     }
-    ublksrv_complete_io(q, data->tag, result);
 
     // Fire device = {} once the last in-flight op (dispatched before begin_shutdown) drains.
     if (qs->tgt->_shutting_down.load(std::memory_order_seq_cst)) qs->tgt->try_drain();
 }
 
-// I/O Handler, first entry-point to us for all I/O
-static int handle_io_async(ublksrv_queue const* q, ublk_io_data const* data) {
-    auto* qs = static_cast< ublkpp_queue_state* >(q->private_data);
-    // scope.spawn() throws if the scope has been stopped, but that race cannot occur: the
-    // ublksrv io_uring is fully drained before the queue state (and its async_scope) is
-    // destroyed, so no new handle_io_async callbacks can arrive after stop is requested.
-    // Any other exception (e.g. bad_alloc from coroutine frame or spawn control block)
-    // must be caught here: if spawn throws, ublksrv_complete_io is never called and the
-    // tag slot is permanently hung. No I/O was submitted so no data was committed;
-    // EAGAIN is safe for the block layer to retry.
+// Starts the coroutine serving `group`.
+// scope.spawn() throws if the scope has been stopped, but that race cannot occur: the
+// ublksrv io_uring is fully drained before the queue state (and its async_scope) is
+// destroyed, so no new handle_io_async callbacks can arrive after stop is requested.
+// Any other exception (e.g. bad_alloc from coroutine frame or spawn control block)
+// must be caught here: if spawn throws, ublksrv_complete_io is never called and the
+// tag slot is permanently hung. No I/O was submitted so no data was committed;
+// EAGAIN is safe for the block layer to retry.
+static void dispatch(ublksrv_queue const* q, ublkpp_queue_state* qs, io_group const& group) {
     try {
-        qs->scope.spawn(stdexec::on(exec::inline_scheduler{}, __handle_io_async(q, data)));
+        qs->scope.spawn(stdexec::on(exec::inline_scheduler{}, __handle_io_async(q, group)));
     } catch (...) { // LCOV_EXCL_START
-        TLOGE("handle_io_async: scope.spawn threw; completing tag {} with EAGAIN", data->tag)
-        ublksrv_complete_io(q, data->tag, -EAGAIN);
+        for (auto i = 0U; group.n > i; ++i) {
+            TLOGE("handle_io_async: scope.spawn threw; completing tag {} with EAGAIN", group.data[i]->tag)
+            finish_io(q, io_of(group.data[i]), -EAGAIN);
+        }
     } // LCOV_EXCL_STOP
+}
+
+// I/O Handler, first entry-point to us for all I/O. A plugging or lending queue holds it for
+// unplug().
+static int handle_io_async(ublksrv_queue const* q, ublk_io_data const* data) {
+    auto* qs = queue_state(q);
+    io_of(data)->_tag = data->tag;
+    if (qs->plugging || qs->lending) {
+        qs->plug.push_back({.op_flags = data->iod->op_flags,
+                            .nr_sectors = data->iod->nr_sectors,
+                            .start_sector = data->iod->start_sector,
+                            .data = data});
+        return 0;
+    }
+    dispatch(q, qs, io_group{.data = {data}, .n = 1});
     return 0;
 }
 
+// Offers the I/Os of this pass to siblings (--steal_io) and takes back the oldest on offer, up to
+// --steal_batch, to serve itself; wakes as many sleeping siblings as it takes to serve the rest, a
+// batch each. The wakes go out under the steal lock, while every queue registered is still open.
+static void lend(ublksrv_queue const* q, ublkpp_queue_state* qs) {
+    auto& tgt = *qs->tgt;
+    auto lk = std::scoped_lock< std::mutex >(tgt.steal_lock);
+    auto const before = qs->offers.size();
+    for (auto const& g : qs->batch) {
+        qs->offers.offer(g);
+        qs->lent += g.n;
+    }
+    qs->batch.clear();
+    qs->offers.take_front(tgt.steal_batch, [&](io_group const& g) {
+        qs->lent -= g.n;
+        qs->batch.push_back(g);
+    });
+    auto const after = qs->offers.size();
+    if (after > before)
+        tgt.offered.fetch_add(after - before, std::memory_order_seq_cst);
+    else
+        tgt.offered.fetch_sub(before - after, std::memory_order_seq_cst);
+    qs->offering = (0 < after);
+
+    auto wakes = (after + tgt.steal_batch - 1) / tgt.steal_batch;
+    auto const n = tgt.stealers.size();
+    for (auto i = 1UL; n > i && 0 < wakes; ++i) {
+        auto* to = static_cast< ublkpp_queue_state* >(tgt.stealers[(q->q_id + i) % n]);
+        if (!to || !to->sleeping.load(std::memory_order_seq_cst)) continue;
+        wake_queue(q, to);
+        --wakes;
+    }
+}
+
+// End of a CQE batch on a plugging or lending queue: issues the requests it brought, contiguous
+// runs of the same op as one I/O each when plugging. Runs are only merged while the disk can be
+// looked at safely; on the way to shutdown every request goes alone (and is dropped). A lending
+// queue issues what lend() leaves it. Returns the I/Os issued.
+static uint32_t unplug(ublksrv_queue const* q, ublkpp_queue_state* qs) {
+    if (qs->plug.empty() && !qs->offering) return 0;
+    auto limits = merge_limits{};
+    if (qs->plugging && 1 < qs->plug.size() && !qs->tgt->_shutting_down.load(std::memory_order_seq_cst)) {
+        if (auto const dev = qs->tgt->device.load()) {
+            limits = {.vectored = dev->scatter_gather(),
+                      .max_bytes = dev->max_tx(),
+                      .max_discard_bytes = uint64_t{dev->max_discard_sectors()} << SECTOR_SHIFT};
+            order_plug(qs->plug);
+        }
+    }
+    for (auto i = 0UL; qs->plug.size() > i;) {
+        auto group = io_group{};
+        group.n = merge_run(std::span(qs->plug).subspan(i), limits);
+        for (auto m = 0U; group.n > m; ++m)
+            group.data[m] = qs->plug[i + m].data;
+        i += group.n;
+        qs->batch.push_back(group);
+    }
+    if (qs->plugging && !qs->plug.empty()) qs->queue_metrics->record_unplug(qs->plug.size(), qs->batch.size());
+    qs->plug.clear();
+    if (qs->lending) lend(q, qs);
+    for (auto const& group : qs->batch)
+        dispatch(q, qs, group);
+    auto const issued = static_cast< uint32_t >(qs->batch.size());
+    qs->batch.clear();
+    return issued;
+}
+
 // Called in the context of start by ublksrv_dev_init()
 static int init_tgt(ublksrv_dev* dev, int, int, char*[]) {
     // Find the registered disk in the disk map and set the tgt_data
@@ -434,14 +1451,22 @@ static int init_tgt(ublksrv_dev* dev, int, int, char*[]) {
     ublksrv_tgt->io_data_size = sizeof(struct async_io);
     ublksrv_tgt->dev_size = ublk_disk->capacity();
 
-    // Size the io_uring ring to hold all in-flight SQEs across the full queue depth.
+    // Size the io_uring ring to hold the in-flight SQEs of the full queue depth at --ring_sqes_per_io
+    // each (at most the disk's ceiling). I/O fanning out further waits for room as CQEs free it
+    // (sq_space), so a wide stack does not need a ring sized for every I/O at its widest.
     // prepare() with nullptr collects the SQE ceiling without triggering per-queue side effects
     // (e.g. Raid1 resync enable); each queue's pool is reserved separately in init_queue.
     // +1 per I/O slot for the ublksrv FETCH/COMMIT control SQEs that share the same ring.
     // +1 total for the idle probe timeout SQE, which may still be in-flight when I/O resumes.
-    auto const max_sqes = ublk_disk->prepare(nullptr, 0).max_sqes_per_io;
+    auto const prep = ublk_disk->prepare(nullptr, 0);
+    auto sqes = static_cast< unsigned int >(prep.max_sqes_per_io);
+    if (auto const cap = SISL_OPTIONS["ring_sqes_per_io"].as< uint32_t >(); 0 < cap) sqes = std::min(sqes, cap);
     auto const qd = static_cast< unsigned int >(ublksrv_ctrl_get_dev_info(cdev)->queue_depth);
-    ublksrv_tgt->tgt_ring_depth = qd * (static_cast< unsigned int >(max_sqes) + 1) + 1;
+    ublksrv_tgt->tgt_ring_depth = qd * (sqes + 1) + 1;
+    // Held to this, the SQ never fills and the CQ (twice the SQ) never overflows
+    tgt->ring_inflight = qd * sqes + 1;
+    // --iopoll: a polled ring per queue for disks that asked, as deep as the target SQEs of the first
+    tgt->polled_ring_depth = (prep.polled && 0 < SISL_OPTIONS["iopoll"].count()) ? qd * sqes : 0;
 
     // iouring FD 0 is reserved for the ublkc device; prepare is called per queue in init_queue.
     // NOTE: if future disks export non-empty FDs they must be registered here (before ublksrv_queue_init
@@ -454,7 +1479,7 @@ static void deinit_tgt(const struct ublksrv_dev*) { TLOGD("Deinit tgt!") }
 
 static void idle_transition(ublksrv_queue const* q, bool enter) {
     TLOGT("Idle Trans: {}", enter)
-    auto* qs = static_cast< ublkpp_queue_state* >(q->private_data);
+    auto* qs = queue_state(q);
     qs->is_idle = enter;
     // On exit: let any in-flight probe timeout fire naturally; is_idle=false prevents
     // resubmission, and a spurious probe_tick during active I/O is harmless.
@@ -473,6 +1498,7 @@ static int init_queue(const struct ublksrv_queue* q, void**) {
     for (int i = 0; i < q->q_depth; ++i) {
         auto* io = new (ublksrv_io_private_data(q, i)) async_io{};
         io->_pool.reserve(prep.max_sqes_per_io);
+        io->_home = q;
     }
     return 0;
 }
@@ -483,11 +1509,52 @@ static void deinit_queue(const struct ublksrv_queue* q) {
         static_cast< async_io* >(ublksrv_io_private_data(q, i))->~async_io();
 }
 
+std::optional< ring_setup > ring_setup::from_options() {
+    auto setup = ring_setup{.register_fd = 0 < SISL_OPTIONS["ring_fd"].count()};
+    if (auto const mode = SISL_OPTIONS["ring_mode"].as< std::string >(); "defer_taskrun" == mode)
+        setup.mode = ring_mode::DEFER_TASKRUN;
+    else if ("sqpoll" == mode)
+        setup.mode = ring_mode::SQPOLL;
+    else if ("coop_taskrun" != mode)
+        return std::nullopt;
+    return setup;
+}
+
 // Setup ublksrv ctrl device and initiate adding the target to the ublksrv service and handle all device traffic
 ublkpp_tgt::run_result_t ublkpp_tgt::run(boost::uuids::uuid const& vol_id, std::shared_ptr< ublk_disk > device,
-                                         int device_id) {
+                                         int device_id, std::optional< ring_setup > ring) {
+    if (!ring && !(ring = ring_setup::from_options())) {
+        TLOGE("Unknown --ring_mode {}", SISL_OPTIONS["ring_mode"].as< std::string >())
+        return std::unexpected(std::make_error_condition(std::errc::invalid_argument));
+    }
     auto tgt = std::make_shared< ublkpp_tgt_impl >(vol_id, device);
     if (0 <= device_id) tgt->device_recovering = true;
+    tgt->ring = *ring;
+
+    // Shared reactors: each queue is served by the reactor of the CPU placed for it
+    tgt->shared_reactors = (0 < SISL_OPTIONS["shared_reactors"].count());
+    if (tgt->shared_reactors && (ring_mode::COOP_TASKRUN != ring->mode || ring->register_fd))
+        TLOGI("Shared reactors set queue rings up with coop_taskrun and no registered fd: {}", to_string(vol_id))
+
+    // Work stealing: among the threads of one target's queues, which shared reactors do not have
+    tgt->steal_io = (0 < SISL_OPTIONS["steal_io"].count());
+    if (tgt->steal_io && tgt->shared_reactors) {
+        TLOGI("--steal_io does not apply to queues served by shared reactors: {}", to_string(vol_id))
+        tgt->steal_io = false;
+    }
+    tgt->steal_batch = std::max(1U, SISL_OPTIONS["steal_batch"].as< uint32_t >());
+
+    // 0 queues: one per CPU this process may run on, each pinned to its own CPU
+    auto nr_hw_queues = SISL_OPTIONS["nr_hw_queues"].as< uint16_t >();
+    tgt->pin_queues =
+        (0 == nr_hw_queues) || (0 < SISL_OPTIONS["pin_queues"].count()) || tgt->shared_reactors;
+    if (0 == nr_hw_queues) {
+        auto allowed = cpu_set_t{};
+        CPU_ZERO(&allowed);
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        nr_hw_queues = auto_queue_count(allowed);
+        TLOGI("Running {} queues, one per CPU: {}", nr_hw_queues, to_string(vol_id))
+    }
     auto ublk_flags = unsigned(0);
     ublk_flags |= (unsigned)(UBLK_F_USER_RECOVERY | UBLK_F_USER_RECOVERY_REISSUE);
     if (0 < SISL_OPTIONS["feature_zero_copy"].count()) {
@@ -521,7 +1588,7 @@ ublkpp_tgt::run_result_t ublkpp_tgt::run(boost::uuids::uuid const& vol_id, std::
     tgt->dev_data = std::make_unique< ublksrv_dev_data >(ublksrv_dev_data{
         .dev_id = device_id,
         .max_io_buf_bytes = SISL_OPTIONS["max_io_size"].as< uint32_t >(),
-        .nr_hw_queues = SISL_OPTIONS["nr_hw_queues"].as< uint16_t >(),
+        .nr_hw_queues = nr_hw_queues,
         .queue_depth = SISL_OPTIONS["qdepth"].as< uint16_t >(),
         .tgt_type = "ublkpp",
         .tgt_ops = tgt->tgt_type.get(),
@@ -554,6 +1621,56 @@ int ublkpp_tgt::device_id() const {
     return _p->dev_data->dev_id;
 }
 
+std::vector< changed_extent > ublkpp_tgt::cbt_new_epoch() {
+    auto lk = std::scoped_lock< std::mutex >(_p->_cbt_lock);
+    if (!_p->_cbt_storage) {
+        auto const dev = _p->device.load();
+        _p->_cbt_storage = std::make_unique< ChangeTracker >(dev ? dev->capacity() : 0);
+        _p->_cbt.store(_p->_cbt_storage.get(), std::memory_order_release);
+        _p->_cbt_epoch.store(1, std::memory_order_release);
+        TLOGI("Changed-block tracking enabled [capacity:{:#0x}]", _p->_cbt_storage->capacity())
+        return {};
+    }
+    auto extents = _p->_cbt_storage->collect(true);
+    auto const epoch = _p->_cbt_epoch.fetch_add(1, std::memory_order_acq_rel);
+    TLOGD("Closed CBT epoch {} with {} changed extents", epoch, extents.size())
+    return extents;
+}
+
+std::vector< changed_extent > ublkpp_tgt::cbt_changed() const {
+    auto lk = std::scoped_lock< std::mutex >(_p->_cbt_lock);
+    if (!_p->_cbt_storage) return {};
+    return _p->_cbt_storage->collect(false);
+}
+
+uint64_t ublkpp_tgt::cbt_epoch() const { return _p->_cbt_epoch.load(std::memory_order_acquire); }
+
+void ublkpp_tgt::set_qos(qos_limits const& limits) {
+    _p->qos.set(limits);
+    TLOGI("QoS limits [read iops:{}/{} write iops:{}/{} read B/s:{}/{} write B/s:{}/{}]", limits.read_iops.rate,
+          limits.read_iops.burst, limits.write_iops.rate, limits.write_iops.burst, limits.read_bytes.rate,
+          limits.read_bytes.burst, limits.write_bytes.rate, limits.write_bytes.burst)
+}
+
+qos_limits ublkpp_tgt::qos() const { return _p->qos.get(); }
+
+void ublkpp_tgt::set_io_priority(uint16_t ioprio) {
+    auto const was = _p->ioprio.exchange(ioprio, std::memory_order_relaxed);
+    TLOGI("I/O priority [class:{} level:{}]", IOPRIO_PRIO_CLASS(ioprio), IOPRIO_PRIO_DATA(ioprio))
+    if ((IOPRIO_CLASS_IDLE == IOPRIO_PRIO_CLASS(was)) == (IOPRIO_CLASS_IDLE == IOPRIO_PRIO_CLASS(ioprio))) return;
+    // A reactor serves the queues of many targets, so it keeps --sched whatever one of them asks
+    if (_p->shared_reactors) {
+        TLOGI("Shared reactors keep their scheduler policy; only backing I/O takes the idle class")
+        return;
+    }
+    for (auto q_id = 0; auto& t : _p->queue_handlers) {
+        if (t.joinable()) set_queue_sched(t.native_handle(), q_id, ioprio);
+        ++q_id;
+    }
+}
+
+uint16_t ublkpp_tgt::io_priority() const { return _p->ioprio.load(std::memory_order_relaxed); }
+
 void ublkpp_tgt::begin_shutdown() {
     // Relaxed load for the idempotency fast-path: benign optimisation. Correctness is
     // guaranteed by the CAS on _device_reset_done, not by this check.
@@ -574,7 +1691,7 @@ void ublkpp_tgt::begin_shutdown() {
     // device = {} destroys Raid1Disk inline: its destructor calls _resync_task->stop()
     // (joins the resync thread) then writes clean_unmount=1. This call may therefore block
     // until the resync task drains. Do not invoke from a signal handler.
-    if (_p->metrics.all_idle()) {
+    if (_p->metrics.all_idle() && 0 == _p->detached.load(std::memory_order_seq_cst)) {
         bool expected = false;
         if (_p->_device_reset_done.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
             TLOGI("No I/O in-flight at shutdown - flushing backing store immediately")
@@ -598,6 +1715,7 @@ ublkpp_tgt ublkpp_tgt_test_peer::make(disk_handle dev) {
 }
 void ublkpp_tgt_test_peer::try_drain(ublkpp_tgt& tgt) { tgt._p->try_drain(); }
 UblkIOMetrics& ublkpp_tgt_test_peer::metrics(ublkpp_tgt& tgt) { return tgt._p->metrics; }
+ChangeTracker* ublkpp_tgt_test_peer::change_tracker(ublkpp_tgt& tgt) { return tgt._p->_cbt.load(); }
 
 void ublkpp_tgt_impl::destroy() {
     auto const str_id = fmt::format("Device {} [uuid:{}]", device_path.native(), to_string(volume_uuid));
@@ -607,10 +1725,13 @@ void ublkpp_tgt_impl::destroy() {
         ublksrv_ctrl_stop_dev(ctrl_dev);
     }
 
-    // Wait for all queue_handler threads to exit
+    // Wait for all queue_handler threads to exit, and for shared reactors to retire our queues
     TLOGD("Waiting for I/O to stop on {}", str_id)
     for (auto& q : queue_handlers)
         if (q.joinable()) q.join();
+    for (auto n = reactor_queues.load(std::memory_order_acquire); 0 < n;
+         n = reactor_queues.load(std::memory_order_acquire))
+        reactor_queues.wait(n, std::memory_order_acquire);
 
     // De-allocate the ublksrv device and free all unowned memory
     if (ublk_dev) {
@@ -3,10 +3,14 @@
 #include <atomic>
 #include <filesystem>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <boost/uuid/uuid.hpp>
 
+#include "ublkpp/target.hpp"
 #include "metrics/ublk_io_metrics.hpp"
+#include "qos.hpp"
 
 struct ublksrv_ctrl_dev;
 struct ublksrv_dev;
@@ -16,10 +20,25 @@ struct ublksrv_tgt_type;
 namespace ublkpp {
 
 class ublk_disk;
+class ChangeTracker;
+struct queue_rings;
 
 struct ublkpp_tgt_impl {
     bool device_added{false};
     bool device_recovering{false};
+    // Each queue thread runs on one CPU of its queue (see queue_placement.hpp)
+    bool pin_queues{false};
+    // Queues are served by the shared reactor of their CPU, not a thread each (--shared_reactors)
+    bool shared_reactors{false};
+    // Idle queue threads serve I/O their busy siblings offer (--steal_io), at most steal_batch of
+    // their own per pass
+    bool steal_io{false};
+    uint32_t steal_batch{8};
+    ring_setup ring{};
+    // Target SQEs each queue may have in flight on its ring (queue_rings::inflight_max), and
+    // entries of its IOPOLL ring (--iopoll), 0 for none; set in init_tgt
+    unsigned ring_inflight{0};
+    unsigned polled_ring_depth{0};
     boost::uuids::uuid volume_uuid;
     std::filesystem::path device_path;
     // Owned by us. Atomic to allow the probe tick handler (queue thread) and begin_shutdown()
@@ -34,10 +53,22 @@ struct ublkpp_tgt_impl {
     // == Metrics ==
     UblkIOMetrics metrics;
 
+    // QoS limits (set_qos()), enforced by the queue threads
+    qos_throttle qos;
+    // ioprio of every backend SQE (set_io_priority())
+    std::atomic< uint16_t > ioprio{0};
+
     // == ======= ==
     // Owned by us
     std::unique_ptr< ublksrv_dev_data > dev_data;
     std::vector< std::thread > queue_handlers;
+    // Queues a shared reactor serves: destroy() waits for them to be retired as it joins threads
+    std::atomic< int > reactor_queues{0};
+    // Work stealing (--steal_io): each running queue by id, null once it stopped, and the I/Os on
+    // offer among them. steal_lock guards both and every queue's offers.
+    std::mutex steal_lock;
+    std::vector< queue_rings* > stealers;
+    std::atomic< uint64_t > offered{0};
 
     // Shutdown drain: set by begin_shutdown(); gates __handle_io_async so no new I/O reaches
     // the backing device. When the last in-flight op decrements the metrics counter to zero,
@@ -49,11 +80,23 @@ struct ublkpp_tgt_impl {
     std::atomic< bool > _shutting_down{false};
     std::atomic< bool > _device_reset_done{false};
     std::atomic< bool > _drain_complete{false};
+    // Driver I/O outliving its request (detached_io) on any queue (queue_rings::detached). The drain
+    // waits for it too: it runs on the device, and a destructor waiting for it on a queue thread
+    // would hold up the very ring it completes on.
+    std::atomic< uint32_t > detached{0};
+
+    // Changed-block tracking: null until cbt_new_epoch() first allocates it, then never freed
+    // before the target, so queue threads may dereference the loaded pointer without a lock.
+    // _cbt_lock serializes the cbt_* API against itself only.
+    std::atomic< ChangeTracker* > _cbt{nullptr};
+    std::unique_ptr< ChangeTracker > _cbt_storage;
+    std::atomic< uint64_t > _cbt_epoch{0};
+    mutable std::mutex _cbt_lock;
 
     ublkpp_tgt_impl(boost::uuids::uuid const& vol_id, std::shared_ptr< ublk_disk > d);
     ~ublkpp_tgt_impl();
     void destroy();
-    // Assigns device = {} if all counters are zero and the CAS has not fired yet.
+    // Assigns device = {} if all counters and `detached` are zero and the CAS has not fired yet.
     // Called by queue threads after decrementing counters; exposed for testing.
     void try_drain();
 };
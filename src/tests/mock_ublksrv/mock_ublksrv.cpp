@@ -4,6 +4,7 @@ extern "C" {
 #include <unistd.h>
 }
 
+#include <algorithm>
 #include <stdexcept>
 
 #include <ublksrv.h>
@@ -102,15 +103,20 @@ io_result MockUblksrv::submit_io(int tag, uint8_t op, uint64_t start_sector, uin
     int const qid = tag % static_cast< int >(_queues.size());
     _async_tasks[tag].emplace(
         _disk->async_iov(&_queues[qid], &ts.data, &ts.iov, 1, ts.iod.start_sector << SECTOR_SHIFT).start());
-    // Pool size == number of CqeStates registered (one per pending stripe SQE)
-    return io_result{_io_states[tag]._pool.size()};
+    // Pool size == number of CqeStates registered (one per pending stripe SQE). An I/O parked on a
+    // timer of its own (e.g. RAID10 waiting for its regions to be marked dirty) has none there yet,
+    // but is pending all the same.
+    auto const pending = _async_tasks[tag]->done() ? 0 : 1;
+    return io_result{std::max< size_t >(_io_states[tag]._pool.size(), pending)};
 }
 
 void MockUblksrv::process_cqe(io_uring_cqe* cqe, std::vector< Completion >& out) {
     if (!sisl::async::is_managed_user_data(cqe->user_data)) return (void)io_uring_cqe_seen(&_ring, cqe);
+    if (0 < _rings.inflight) --_rings.inflight;
     auto* state = static_cast< cqe_state* >(sisl::async::decode_managed_user_data(cqe->user_data));
-    if (!state || !state->_owner) return (void)io_uring_cqe_seen(&_ring, cqe);
-    int const tag = state->_owner->_tag;
+    if (!state) return (void)io_uring_cqe_seen(&_ring, cqe);
+    // Stand-alone states (backoff timers) are resumed as the target does; no tag is told of it
+    int const tag = state->_owner ? state->_owner->_tag : -1;
     int const res = cqe->res;
 
     // Consume the CQE immediately so peek sees the next one
@@ -120,6 +126,7 @@ void MockUblksrv::process_cqe(io_uring_cqe* cqe, std::vector< Completion >& out)
     state->_result_ready = true;
 
     if (auto h = std::exchange(state->_waiter, {})) h.resume();
+    if (0 > tag) return; // Issued by the disk on its own (e.g. a RAID1 write-behind copy)
     auto& opt = _async_tasks[tag];
     if (opt && opt->done()) out.push_back({tag, opt->result()});
 }
@@ -172,11 +179,35 @@ std::vector< MockUblksrv::Completion > MockUblksrv::poll(int min_completions, st
         do {
             process_cqe(cqe, completions);
         } while (io_uring_peek_cqe(&_ring, &cqe) == 0 && cqe != nullptr);
+        wake_waiters(completions);
     }
 
     return completions;
 }
 
+void MockUblksrv::limit_ring(uint32_t inflight_max) {
+    _rings.inflight_max = inflight_max;
+    for (auto& q : _queues)
+        q.private_data = &_rings;
+}
+
+// As run_queue_loop does: the room the CQEs just reaped freed goes to the oldest waiters
+void MockUblksrv::wake_waiters(std::vector< Completion >& out) {
+    auto* const last = _rings.waiters_tail;
+    _rings.waking = true;
+    for (auto done = false; !done && _rings.waiters && !sq_full(&_queues[0]);) {
+        auto* w = std::exchange(_rings.waiters, _rings.waiters->next);
+        if (!_rings.waiters) _rings.waiters_tail = nullptr;
+        done = (last == w);
+        auto const* owner = w->owner; // w may be gone once on_space() returns
+        w->on_space(w);
+        if (!owner || 0 > owner->_tag) continue;
+        auto& opt = _async_tasks[owner->_tag];
+        if (opt && opt->done()) out.push_back({owner->_tag, opt->result()});
+    }
+    _rings.waking = false;
+}
+
 void* MockUblksrv::io_buf(int tag) { return _io_buf_ptrs[tag]; }
 
 uint64_t MockUblksrv::capacity_sectors() const noexcept { return _disk->capacity() >> SECTOR_SHIFT; }
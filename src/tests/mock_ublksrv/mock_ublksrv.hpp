@@ -39,7 +39,8 @@ public:
     // tag: slot index [0, q_depth), op: UBLK_IO_OP_READ / _WRITE / _FLUSH / _DISCARD
     // start_sector: byte offset >> SECTOR_SHIFT, nr_sectors: byte length >> SECTOR_SHIFT
     // buf: sector-aligned buffer (caller owns lifetime)
-    // Returns the number of CqeStates registered (one per pending SQE).
+    // Returns the number of CqeStates registered (one per pending SQE), at least 1 while the I/O is
+    // pending.
     io_result submit_io(int tag, uint8_t op, uint64_t start_sector, uint32_t nr_sectors, void* buf);
 
     // Drain io_uring CQEs until at least min_completions are collected or timeout expires.
@@ -50,6 +51,11 @@ public:
     // task runs to completion. Call once per awaited stripe for multi-stripe IOs.
     std::vector< Completion > inject_cqe(int tag, int result);
 
+    // Hold the queues to `inflight_max` SQEs in flight on the ring, as the target does
+    // (--ring_sqes_per_io): I/O past it waits for room (sq_space), and poll() wakes it as CQEs
+    // come in.
+    void limit_ring(uint32_t inflight_max);
+
     // Per-tag sector-aligned I/O buffer (max_io_size = DEF_BUF_SIZE bytes).
     void* io_buf(int tag);
 
@@ -58,6 +64,10 @@ public:
     // disk under test has snapshotted the values rather than holding a raw pointer.
     iovec& iov_ref(int tag) noexcept { return _tags[tag].iov; }
 
+    // The async_io the given tag slot is served with. Lets tests set what the target keeps there,
+    // such as the _home queue of an I/O another queue took over.
+    async_io& io_state(int tag) noexcept { return _io_states[tag]; }
+
     int q_depth() const noexcept { return _q_depth; }
     int nr_queues() const noexcept { return static_cast< int >(_queues.size()); }
     ublksrv_queue const* queue(int q_id = 0) const noexcept { return &_queues[q_id]; }
@@ -74,11 +84,13 @@ private:
     };
 
     void process_cqe(io_uring_cqe* cqe, std::vector< Completion >& out);
+    void wake_waiters(std::vector< Completion >& out);
 
     int _q_depth;
     ublksrv_dev _dev{};
     std::vector< ublksrv_queue > _queues;
     io_uring _ring{};
+    queue_rings _rings{}; // Shared by the queues, as the ring is; their private_data after limit_ring()
     std::shared_ptr< ublk_disk > _disk;
     std::vector< TagState > _tags;
 
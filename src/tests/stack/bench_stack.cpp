@@ -0,0 +1,203 @@
+// Per-I/O CPU cost of arrays built with stack::make_stack() against the same arrays composed at
+// runtime with make_*_disk(), over file-backed legs.
+//
+// Each case keeps `qd` I/Os in flight through MockUblksrv (a real io_uring, no ublk device) and
+// reports, per I/O, the user-mode CPU cycles of this thread (from perf_event_open(2); "-" where
+// the kernel does not allow it) and its total CPU time, kernel included. The difference between
+// the two columns of a pair is what the statically known topology saves. Not registered with
+// ctest; run by hand:
+//
+//     bench_stack [--ios=200000] [--qd=32] [--dir=/tmp]
+extern "C" {
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+}
+
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <boost/uuid/string_generator.hpp>
+#include <sisl/logging/logging.h>
+#include <sisl/options/options.h>
+#include <ublksrv.h>
+
+#include "ublkpp/stack.hpp"
+#include "lib/common.hpp"
+#include "mock_ublksrv/mock_ublksrv.hpp"
+
+SISL_OPTION_GROUP(bench_stack,
+                  (ios, "", "ios", "I/Os per case", ::cxxopts::value< uint32_t >()->default_value("200000"),
+                   "<count>"),
+                  (qd, "", "qd", "I/Os kept in flight", ::cxxopts::value< uint32_t >()->default_value("32"), "<depth>"),
+                  (dir, "", "dir", "Directory for the backing files",
+                   ::cxxopts::value< std::string >()->default_value("/tmp"), "<path>"))
+
+#define ENABLED_OPTIONS logging, raid1, bench_stack
+
+SISL_LOGGING_INIT(ublk_drivers, ublk_raid, ublksrv)
+SISL_OPTIONS_ENABLE(ENABLED_OPTIONS)
+
+using namespace ublkpp;
+
+namespace {
+constexpr uint32_t k_legs = 4;
+constexpr uint32_t k_stripe = 128 * Ki;
+constexpr uint64_t k_file_size = 1 * Gi;
+
+// User-mode cycles of the calling thread; nullopt where perf events are not permitted
+class cycle_counter {
+    int _fd{-1};
+
+public:
+    cycle_counter() {
+        auto attr = perf_event_attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        _fd = static_cast< int >(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+    ~cycle_counter() {
+        if (0 <= _fd) close(_fd);
+    }
+    void start() const noexcept {
+        if (0 > _fd) return;
+        ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    std::optional< uint64_t > stop() const noexcept {
+        if (0 > _fd) return std::nullopt;
+        ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+        auto cycles = uint64_t{0};
+        if (sizeof(cycles) != read(_fd, &cycles, sizeof(cycles))) return std::nullopt;
+        return cycles;
+    }
+};
+
+uint64_t thread_cpu_ns() {
+    auto ts = timespec{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast< uint64_t >(ts.tv_sec) * 1000000000UL + static_cast< uint64_t >(ts.tv_nsec);
+}
+
+struct result {
+    std::optional< double > cycles;
+    double cpu_ns;
+};
+
+// `ios` I/Os of `op` and `io_size` at scattered aligned offsets, `qd` at a time
+result run(disk_handle const& disk, uint8_t const op, uint64_t const io_size, uint32_t const ios, uint32_t const qd) {
+    auto mock = MockUblksrv(disk, static_cast< int >(qd));
+    auto bufs = std::unique_ptr< uint8_t, decltype(&free) >(
+        static_cast< uint8_t* >(std::aligned_alloc(4 * Ki, qd * io_size)), &free);
+    auto const slots = disk->capacity() / io_size;
+    auto next = 0U;
+    auto done = 0U;
+    auto const submit = [&](int const tag) {
+        auto const addr = ((next++ * 2654435761ULL) % slots) * io_size;
+        auto const sub = mock.submit_io(tag, op, addr >> SECTOR_SHIFT, static_cast< uint32_t >(io_size >> SECTOR_SHIFT),
+                                        bufs.get() + tag * io_size);
+        RELEASE_ASSERT(sub, "submit failed")
+        // Completed inline: collect it now
+        if (0 == sub.value()) {
+            for (auto const& c : mock.inject_cqe(tag, 0))
+                RELEASE_ASSERT_LE(0, c.result, "I/O failed");
+            return false;
+        }
+        return true;
+    };
+
+    auto const counter = cycle_counter();
+    auto const cpu_start = thread_cpu_ns();
+    counter.start();
+    for (auto tag = 0U; qd > tag && ios > next;) {
+        if (submit(static_cast< int >(tag)))
+            ++tag;
+        else
+            ++done;
+    }
+    while (ios > done) {
+        for (auto const& c : mock.poll(1, std::chrono::seconds(5))) {
+            RELEASE_ASSERT_LE(0, c.result, "I/O failed");
+            ++done;
+            while (ios > next && !submit(c.tag))
+                ++done;
+        }
+    }
+    auto const cycles = counter.stop();
+    auto const cpu_ns = thread_cpu_ns() - cpu_start;
+    return {.cycles = cycles ? std::optional< double >(static_cast< double >(*cycles) / ios) : std::nullopt,
+            .cpu_ns = static_cast< double >(cpu_ns) / ios};
+}
+
+std::string cycles_str(result const& r) { return r.cycles ? fmt::format("{:.0f}", *r.cycles) : "-"; }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SISL_OPTIONS_LOAD(argc, argv, ENABLED_OPTIONS);
+    sisl::logging::SetLogger(std::string(argv[0]));
+    spdlog::set_pattern("[%D %T.%e] [%n] [%^%l%$] [%t] %v");
+
+    auto const ios = SISL_OPTIONS["ios"].as< uint32_t >();
+    auto const qd = SISL_OPTIONS["qd"].as< uint32_t >();
+    auto const dir = std::filesystem::path(SISL_OPTIONS["dir"].as< std::string >());
+
+    auto const uuid = boost::uuids::string_generator()("0f6b3c1e-2a4d-4e8f-9b7c-5d1e3a2f4b60");
+    struct bench_case {
+        std::string name;
+        uint8_t op;
+        uint64_t io_size;
+    };
+    auto const cases = std::vector< bench_case >{
+        {"4K read", UBLK_IO_OP_READ, 4 * Ki},
+        {"128K read", UBLK_IO_OP_READ, 128 * Ki},
+        {"64K write", UBLK_IO_OP_WRITE, 64 * Ki},
+        {"512K write", UBLK_IO_OP_WRITE, 512 * Ki},
+    };
+    fmt::print("{:<22} {:>14} {:>14} {:>14} {:>14}   ({} I/Os per case, qd {})\n", "array, I/O", "dynamic cyc/IO",
+               "stack cyc/IO", "dynamic ns/IO", "stack ns/IO", ios, qd);
+    for (auto const lay : {std::optional< raid10::layout >(), std::optional(raid10::layout::NEAR)}) {
+        // Fresh legs per layout; the dynamic and the stacked array take turns on them
+        auto legs = std::vector< stack::fs >();
+        for (auto i = 0U; k_legs > i; ++i) {
+            auto const path = dir / fmt::format("bench_stack_{}_{}.img", getpid(), i);
+            std::ofstream(path).close();
+            std::filesystem::resize_file(path, k_file_size);
+            legs.push_back({path});
+        }
+        auto const make_dynamic = [&] {
+            auto disks = std::vector< disk_handle >();
+            for (auto const& leg : legs)
+                disks.push_back(make_fs_disk(leg.path));
+            return lay ? make_raid10_disk(uuid, k_stripe, std::move(disks), *lay)
+                       : make_raid0_disk(uuid, k_stripe, std::move(disks));
+        };
+        auto const make_stacked = [&] {
+            if (lay)
+                return stack::make_stack(
+                    stack::raid10< stack::fs >{.uuid = uuid, .stripe_size = k_stripe, .legs = legs, .layout = *lay});
+            return stack::make_stack(stack::raid0< stack::fs >{.uuid = uuid, .stripe_size = k_stripe, .legs = legs});
+        };
+        for (auto const& c : cases) {
+            auto const d = run(make_dynamic(), c.op, c.io_size, ios, qd);
+            auto const s = run(make_stacked(), c.op, c.io_size, ios, qd);
+            fmt::print("{:<22} {:>14} {:>14} {:>14.0f} {:>14.0f}\n",
+                       fmt::format("{} x{}, {}", lay ? "RAID10" : "RAID0", k_legs, c.name), cycles_str(d),
+                       cycles_str(s), d.cpu_ns, s.cpu_ns);
+        }
+        for (auto const& leg : legs)
+            std::filesystem::remove(leg.path);
+    }
+    return 0;
+}
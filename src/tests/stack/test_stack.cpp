@@ -0,0 +1,225 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/uuid/string_generator.hpp>
+#include <sisl/logging/logging.h>
+#include <sisl/options/options.h>
+#include <ublksrv.h>
+
+#include "ublkpp/lib/ublk_disk.hpp"
+#include "ublkpp/stack.hpp"
+#include "lib/common.hpp"
+#include "mock_ublksrv/mock_ublksrv.hpp"
+
+SISL_LOGGING_INIT(ublk_drivers, ublk_raid, ublksrv)
+SISL_OPTIONS_ENABLE(logging, raid1)
+
+using namespace ublkpp;
+using namespace std::chrono_literals;
+
+namespace {
+std::string const test_uuid("5d0b9c3e-4f1a-4b6e-9d2c-7a8e1f3b6c40");
+constexpr uint32_t k_stripe = 64 * Ki;
+constexpr uint64_t k_file_size = 64 * Mi;
+
+// Sparse backing files, removed with the fixture
+struct StackTest : public ::testing::Test {
+    std::vector< std::filesystem::path > files;
+
+    std::vector< stack::fs > make_files(uint32_t n) {
+        auto legs = std::vector< stack::fs >();
+        for (auto i = 0U; n > i; ++i) {
+            auto name = (std::filesystem::temp_directory_path() / "ublkpp_stack_XXXXXX").string();
+            auto const fd = mkstemp(name.data());
+            EXPECT_LE(0, fd);
+            EXPECT_EQ(0, ftruncate(fd, k_file_size));
+            close(fd);
+            files.emplace_back(name);
+            legs.push_back({name});
+        }
+        return legs;
+    }
+    void TearDown() override {
+        for (auto const& f : files)
+            std::filesystem::remove(f);
+    }
+};
+
+struct aligned_buf {
+    std::unique_ptr< uint8_t, decltype(&free) > p;
+    explicit aligned_buf(size_t len) : p(static_cast< uint8_t* >(std::aligned_alloc(4 * Ki, len)), &free) {}
+    uint8_t* data() const noexcept { return p.get(); }
+};
+
+void fill(uint8_t* buf, uint64_t len, uint64_t off) {
+    for (auto i = 0UL; len > i; ++i)
+        buf[i] = static_cast< uint8_t >((off + i) * 31 + ((off + i) >> 12));
+}
+
+// One I/O through the async path, waited for
+int run_io(MockUblksrv& mock, uint8_t op, uint64_t addr, uint64_t len, uint8_t* buf) {
+    auto const sub = mock.submit_io(0, op, addr >> SECTOR_SHIFT, static_cast< uint32_t >(len >> SECTOR_SHIFT), buf);
+    if (!sub) return -EIO;
+    auto const done = (0 == sub.value()) ? mock.inject_cqe(0, 0) : mock.poll(1, 5s);
+    return done.empty() ? -ETIMEDOUT : done[0].result;
+}
+
+// Scattered writes, some crossing stripes or whole rows, then reads of the same ranges
+struct extent {
+    uint64_t addr;
+    uint64_t len;
+};
+std::vector< extent > const k_extents{
+    {0, 4 * Ki}, {k_stripe - 4 * Ki, 8 * Ki}, {3 * k_stripe, 4 * k_stripe}, {9 * Mi + 12 * Ki, 128 * Ki}};
+
+// ring_limit: SQEs the mock's ring may have in flight, 0 for no limit
+void write_extents(disk_handle const& disk, uint32_t ring_limit = 0) {
+    auto mock = MockUblksrv(disk);
+    if (0 < ring_limit) mock.limit_ring(ring_limit);
+    for (auto const& e : k_extents) {
+        auto buf = aligned_buf(e.len);
+        fill(buf.data(), e.len, e.addr);
+        EXPECT_LE(0, run_io(mock, UBLK_IO_OP_WRITE, e.addr, e.len, buf.data())) << e.addr;
+    }
+}
+
+void expect_extents(disk_handle const& disk, uint32_t ring_limit = 0) {
+    auto mock = MockUblksrv(disk);
+    if (0 < ring_limit) mock.limit_ring(ring_limit);
+    for (auto const& e : k_extents) {
+        auto buf = aligned_buf(e.len);
+        auto expected = aligned_buf(e.len);
+        fill(expected.data(), e.len, e.addr);
+        ASSERT_LE(0, run_io(mock, UBLK_IO_OP_READ, e.addr, e.len, buf.data())) << e.addr;
+        EXPECT_EQ(0, memcmp(expected.data(), buf.data(), e.len)) << e.addr;
+    }
+}
+
+std::vector< disk_handle > fs_disks(std::vector< stack::fs > const& legs) {
+    auto disks = std::vector< disk_handle >();
+    for (auto const& leg : legs)
+        disks.push_back(make_fs_disk(leg.path));
+    return disks;
+}
+} // namespace
+
+// Stacked and dynamically composed arrays share their on-disk format: what one writes the other reads
+TEST_F(StackTest, Raid0MatchesDynamic) {
+    auto const legs = make_files(4);
+    auto const uuid = boost::uuids::string_generator()(test_uuid);
+    {
+        auto disk = stack::make_stack(stack::raid0< stack::fs >{.uuid = uuid, .stripe_size = k_stripe, .legs = legs});
+        write_extents(disk);
+        expect_extents(disk);
+    }
+    {
+        auto disk = make_raid0_disk(uuid, k_stripe, fs_disks(legs));
+        expect_extents(disk);
+    }
+}
+
+TEST_F(StackTest, Raid10MatchesDynamic) {
+    for (auto const lay : {raid10::layout::NEAR, raid10::layout::FAR}) {
+        auto const legs = make_files(4);
+        auto const uuid = boost::uuids::string_generator()(test_uuid);
+        {
+            auto disk = make_raid10_disk(uuid, k_stripe, fs_disks(legs), lay);
+            write_extents(disk);
+        }
+        auto disk = stack::make_stack(
+            stack::raid10< stack::fs >{.uuid = uuid, .stripe_size = k_stripe, .legs = legs, .layout = lay});
+        expect_extents(disk);
+        EXPECT_TRUE(raid10::failed_devices(*disk).empty());
+    }
+}
+
+// Layers over other layers compose through ublk_disk; only the one over the leaves is fused
+TEST_F(StackTest, Raid0OverRaid1) {
+    auto const files = make_files(4);
+    auto const spec = stack::raid0< stack::raid1< stack::fs > >{
+        .uuid = boost::uuids::string_generator()(test_uuid),
+        .stripe_size = k_stripe,
+        .legs = {{.uuid = boost::uuids::string_generator()("5d0b9c3e-4f1a-4b6e-9d2c-7a8e1f3b6c41"),
+                  .a = files[0],
+                  .b = files[1]},
+                 {.uuid = boost::uuids::string_generator()("5d0b9c3e-4f1a-4b6e-9d2c-7a8e1f3b6c42"),
+                  .a = files[2],
+                  .b = files[3]}}};
+    auto disk = stack::make_stack(spec);
+    auto const mirror = raid0::get_device(*disk, 0);
+    ASSERT_TRUE(mirror);
+    EXPECT_TRUE(raid1::replicas(*mirror).first);
+    write_extents(disk);
+    expect_extents(disk);
+}
+
+// A ring with room for one SQE at a time: the legs an I/O cannot queue wait for room, fused legs
+// (leg_io) and async_iov() alike, and every I/O still completes
+TEST_F(StackTest, LegsWaitForRingRoom) {
+    auto const legs = make_files(4);
+    auto const uuid = boost::uuids::string_generator()(test_uuid);
+    {
+        auto disk = stack::make_stack(stack::raid0< stack::fs >{.uuid = uuid, .stripe_size = k_stripe, .legs = legs});
+        write_extents(disk, 1);
+        expect_extents(disk, 1);
+    }
+    {
+        auto disk = make_raid0_disk(uuid, k_stripe, fs_disks(legs));
+        expect_extents(disk, 1);
+    }
+}
+
+// A stacked RAID0 over files only grows by more files
+TEST_F(StackTest, ExpandTakesOnlyLeaves) {
+    auto const files = make_files(5);
+    auto const uuid = boost::uuids::string_generator()(test_uuid);
+    auto disk = stack::make_stack(stack::raid0< stack::fs >{
+        .uuid = uuid, .stripe_size = k_stripe, .legs = {files[0], files[1]}});
+    write_extents(disk);
+
+    // Larger than the legs and otherwise compatible, but not a file
+    auto nested = stack::make_stack(stack::raid0< stack::fs >{
+        .uuid = boost::uuids::string_generator()("5d0b9c3e-4f1a-4b6e-9d2c-7a8e1f3b6c43"),
+        .stripe_size = k_stripe,
+        .legs = {files[2], files[3]}});
+    ASSERT_LT(make_fs_disk(files[4].path)->capacity(), nested->capacity());
+    EXPECT_FALSE(raid0::expand(*disk, {nested}));
+    EXPECT_TRUE(raid0::expand(*disk, {make_fs_disk(files[4].path)}));
+    auto const deadline = std::chrono::steady_clock::now() + 30s;
+    while (0 < raid0::reshape_remaining(*disk) && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(0U, raid0::reshape_remaining(*disk));
+    expect_extents(disk);
+}
+
+TEST_F(StackTest, RejectsOtherLegs) {
+    auto const files = make_files(2);
+    auto legs = fs_disks(files);
+    legs[1] = make_missing_disk();
+    EXPECT_THROW(stack::detail::make_raid0_over_fs(boost::uuids::string_generator()(test_uuid), k_stripe,
+                                                   std::move(legs), {}),
+                 std::invalid_argument);
+}
+
+int main(int argc, char* argv[]) {
+    int parsed_argc = argc;
+    ::testing::InitGoogleTest(&parsed_argc, argv);
+    SISL_OPTIONS_LOAD(parsed_argc, argv, logging, raid1);
+    sisl::logging::SetLogger(std::string(argv[0]));
+    spdlog::set_pattern("[%D %T.%e] [%n] [%^%l%$] [%t] %v");
+    parsed_argc = 1;
+    return RUN_ALL_TESTS();
+}
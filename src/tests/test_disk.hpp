@@ -1,5 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+
 #include "ublkpp/lib/cqe_state.hpp"
 #include "ublkpp/lib/ublk_disk.hpp"
 
@@ -21,14 +31,18 @@ struct TestParams {
     bool can_discard{true};
     bool direct_io{true};
     bool is_slot_b{false};
+    bool scatter_gather{false};
 };
 
 namespace ublkpp {
 
 class TestDisk : public ublk_disk {
+    bool const _scatter_gather;
+
 public:
     std::string my_id;
-    explicit TestDisk(TestParams const& test_params) : ublk_disk(), my_id(test_params.id) {
+    explicit TestDisk(TestParams const& test_params) :
+            ublk_disk(), _scatter_gather(test_params.scatter_gather), my_id(test_params.id) {
         auto& our_params = *params();
         our_params.basic.dev_sectors = test_params.capacity >> SECTOR_SHIFT;
         our_params.basic.logical_bs_shift = ilog2(test_params.l_size);
@@ -42,6 +56,7 @@ public:
         _direct_io = test_params.direct_io;
     }
     std::string id() const noexcept override { return my_id; }
+    bool scatter_gather() const noexcept override { return _scatter_gather; }
 
     MOCK_METHOD(prepare_result, prepare, (ublksrv_queue const*, int const), (override));
     MOCK_METHOD(void, probe_tick, (ublksrv_queue const*), (noexcept, override));
@@ -67,3 +82,87 @@ public:
 };
 
 }; // namespace ublkpp
+
+// Keeps the last superblock (the first `sb_size` bytes) written to it, so an array can be assembled
+// again from the same legs or a detached leg handed back; everything else reads as zeroes.
+inline std::shared_ptr< ::testing::NiceMock< ublkpp::TestDisk > >
+make_sb_leg(std::string const& id, uint64_t capacity = ublkpp::Gi, size_t sb_size = 4 * Ki) {
+    auto leg = std::make_shared< ::testing::NiceMock< ublkpp::TestDisk > >(TestParams{.capacity = capacity, .id = id});
+    auto sb_page = std::make_shared< std::vector< uint8_t > >(sb_size);
+    ON_CALL(*leg, sync_iov(::testing::_, ::testing::_, ::testing::_, ::testing::_))
+        .WillByDefault([sb_page](uint8_t op, iovec* iovecs, uint32_t, off_t addr) -> ublkpp::io_result {
+            if (0 == addr && UBLK_IO_OP_WRITE == op) memcpy(sb_page->data(), iovecs->iov_base, sb_page->size());
+            if (UBLK_IO_OP_READ == op && iovecs->iov_base) {
+                memset(iovecs->iov_base, 0, iovecs->iov_len);
+                if (0 == addr) memcpy(iovecs->iov_base, sb_page->data(), sb_page->size());
+            }
+            return static_cast< int >(iovecs->iov_len);
+        });
+    return leg;
+}
+
+// A leg backed by memory, shared by the array tests. Setting *broken makes every I/O fail, and reads
+// reaching past *fail_from fail too (stopping a background pass at a known place); *failed records
+// that one did. Setting *lossy makes writes report success without landing, as if cut off by a
+// crash. *reads counts read calls, and *lock serializes access to *data with background threads.
+struct mem_leg {
+    std::shared_ptr< ::testing::NiceMock< ublkpp::TestDisk > > disk;
+    std::shared_ptr< std::vector< uint8_t > > data;
+    std::shared_ptr< std::atomic< bool > > broken;
+    std::shared_ptr< std::atomic< bool > > lossy;
+    std::shared_ptr< std::atomic< uint64_t > > fail_from;
+    std::shared_ptr< std::atomic< bool > > failed;
+    std::shared_ptr< std::atomic< uint32_t > > reads;
+    std::shared_ptr< std::mutex > lock;
+};
+
+inline mem_leg make_mem_leg(std::string const& id, uint64_t capacity) {
+    auto leg = mem_leg{
+        .disk = std::make_shared< ::testing::NiceMock< ublkpp::TestDisk > >(TestParams{.capacity = capacity, .id = id}),
+        .data = std::make_shared< std::vector< uint8_t > >(capacity),
+        .broken = std::make_shared< std::atomic< bool > >(false),
+        .lossy = std::make_shared< std::atomic< bool > >(false),
+        .fail_from = std::make_shared< std::atomic< uint64_t > >(UINT64_MAX),
+        .failed = std::make_shared< std::atomic< bool > >(false),
+        .reads = std::make_shared< std::atomic< uint32_t > >(0),
+        .lock = std::make_shared< std::mutex >(),
+    };
+    // Captures the fields rather than the leg: the disk holding its own action would never be freed
+    ON_CALL(*leg.disk, sync_iov(::testing::_, ::testing::_, ::testing::_, ::testing::_))
+        .WillByDefault([data = leg.data, broken = leg.broken, lossy = leg.lossy, fail_from = leg.fail_from,
+                        failed = leg.failed, reads = leg.reads,
+                        lock = leg.lock](uint8_t op, iovec* iovecs, uint32_t nr_vecs, off_t addr) -> ublkpp::io_result {
+            auto lk = std::scoped_lock(*lock);
+            if (UBLK_IO_OP_READ == op) ++*reads;
+            auto const len = ublkpp::iovec_len(iovecs, iovecs + nr_vecs);
+            if (*broken || data->size() < addr + len || (UBLK_IO_OP_READ == op && *fail_from < addr + len)) {
+                *failed = true;
+                return std::unexpected(std::make_error_condition(std::errc::io_error));
+            }
+            if (UBLK_IO_OP_WRITE == op && *lossy) return len;
+            for (auto* cur = data->data() + addr; auto const& iov : std::span(iovecs, nr_vecs)) {
+                if (UBLK_IO_OP_READ == op)
+                    memcpy(iov.iov_base, cur, iov.iov_len);
+                else
+                    memcpy(cur, iov.iov_base, iov.iov_len);
+                cur += iov.iov_len;
+            }
+            return len;
+        });
+    return leg;
+}
+
+// `width` legs of `capacity` bytes named DiskA, DiskB, ... from `first`
+inline std::vector< mem_leg > make_mem_legs(uint32_t width, uint64_t capacity, char first = 'A') {
+    auto legs = std::vector< mem_leg >();
+    for (auto i = 0U; width > i; ++i)
+        legs.push_back(make_mem_leg(fmt::format("Disk{}", static_cast< char >(first + i)), capacity));
+    return legs;
+}
+
+inline std::vector< std::shared_ptr< ublkpp::ublk_disk > > handles_of(std::vector< mem_leg > const& legs) {
+    auto res = std::vector< std::shared_ptr< ublkpp::ublk_disk > >();
+    for (auto const& leg : legs)
+        res.push_back(leg.disk);
+    return res;
+}